@@ -0,0 +1,47 @@
+# FindMPP.cmake
+# Find Rockchip MPP (Media Process Platform) library
+#
+# Defines:
+#   MPP_FOUND          - True if found
+#   MPP_INCLUDE_DIRS   - Include directories (containing rockchip/rk_mpi.h)
+#   MPP_LIBRARIES      - Libraries to link
+#
+# Search paths:
+#   /usr/include/rockchip/   (librockchip-mpp-dev)
+#   /usr/local/include/rockchip/
+#   ${MPP_ROOT}
+
+find_path(MPP_INCLUDE_DIR
+    NAMES rockchip/rk_mpi.h
+    PATHS
+        ${MPP_ROOT}/include
+        /usr/include
+        /usr/local/include
+)
+
+find_library(MPP_LIBRARY
+    NAMES rockchip_mpp
+    PATHS
+        ${MPP_ROOT}/lib
+        /usr/lib/aarch64-linux-gnu
+        /usr/lib
+        /usr/local/lib/aarch64-linux-gnu
+        /usr/local/lib
+)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(MPP
+    REQUIRED_VARS MPP_INCLUDE_DIR MPP_LIBRARY
+    FAIL_MESSAGE
+        "MPP (librockchip_mpp) not found. Install with: sudo apt install librockchip-mpp-dev or set MPP_ROOT"
+)
+
+if(MPP_FOUND)
+    set(MPP_INCLUDE_DIRS ${MPP_INCLUDE_DIR})
+    set(MPP_LIBRARIES ${MPP_LIBRARY})
+    message(STATUS "MPP found:")
+    message(STATUS "  Include: ${MPP_INCLUDE_DIRS}")
+    message(STATUS "  Library: ${MPP_LIBRARIES}")
+endif()
+
+mark_as_advanced(MPP_INCLUDE_DIR MPP_LIBRARY)
@@ -7,7 +7,12 @@
  * 提供 HTTP REST 接口用于:
  * - 流的 CRUD 管理 (添加/删除/启停)
  * - 查询流状态和服务器全局状态
- * - 获取图片缓存
+ * - 获取图片缓存 / 报警视频片段
+ * - Prometheus 指标 (分阶段延迟分位数、队列深度、丢弃计数)
+ * - 实时推送: MJPEG 预览流 (来自图片缓存) 与检测结果 Server-Sent Events
+ *   (长连接各占一个工作线程, 线程池额外预留 http_push_clients 个, 不挤占普通请求)
+ * - 集群: 每个节点经 /api/node 上报容量与负载; 协调器 (配置了 cluster_nodes) 额外提供
+ *   /api/cluster* 管理全部流的分配
  *
  * 所有端点:
  *   POST   /api/streams                 添加流 (含自动启动)
@@ -18,14 +23,27 @@
  *   POST   /api/streams/:cam_id/stop    停止流
  *   POST   /api/streams/start_all       启动所有流
  *   POST   /api/streams/stop_all        停止所有流
+ *   POST   /api/models/swap             模型热切换
  *   GET    /api/status                  服务器全局状态
+ *   GET    /metrics                     Prometheus 指标 (text/plain)
  *   GET    /api/cache/image             获取缓存图片 (JPEG)
+ *   GET    /api/cache/clip              导出报警视频片段 (MP4 / MPEG-TS)
+ *   GET    /api/cache/mjpeg             MJPEG 实时预览 (multipart/x-mixed-replace)
+ *   GET    /api/results/stream          检测结果实时推送 (text/event-stream)
+ *   GET    /api/node                    节点容量与负载 (供集群协调器轮询)
+ *   GET    /api/cluster                 集群状态 (仅协调器)
+ *   GET    /api/cluster/streams         集群流配置列表 (仅协调器)
+ *   POST   /api/cluster/streams         添加集群流, 由协调器分配到节点 (仅协调器)
+ *   DELETE /api/cluster/streams/:cam_id 移除集群流 (仅协调器)
+ *   POST   /api/cluster/rebalance       立即执行一轮分配 (仅协调器)
  */
 
 #ifdef HAS_HTTP
 
 #include "infer_server/common/config.h"
 #include "infer_server/stream/stream_manager.h"
+#include "infer_server/common/buffer_pool.h"
+#include "infer_server/processor/rga_scheduler.h"
 
 #include <string>
 #include <memory>
@@ -41,6 +59,8 @@ class Server;
 namespace infer_server {
 
 class ImageCache;
+class ResultBroadcaster;
+class ClusterCoordinator;
 
 #ifdef HAS_RKNN
 class InferenceEngine;
@@ -80,6 +100,15 @@ public:
     /// 服务器是否正在运行
     bool is_running() const { return running_.load(); }
 
+    /// 设置结果广播 (SSE 推送的数据源, 可为 nullptr; 须在 start() 之前调用)
+    void set_result_broadcaster(ResultBroadcaster* broadcaster) { broadcaster_ = broadcaster; }
+
+    /// 设置集群协调器 (启用 /api/cluster* 端点, 可为 nullptr; 须在 start() 之前调用)
+    void set_cluster(ClusterCoordinator* cluster) { cluster_ = cluster; }
+
+    /// 当前推送连接数 (MJPEG + SSE)
+    int push_clients() const { return push_clients_.load(); }
+
 private:
     /// 注册所有路由
     void setup_routes();
@@ -90,8 +119,25 @@ private:
     /// JSON 错误响应
     static std::string json_error(int code, const std::string& message);
 
+    /// 校验流配置, 返回错误信息 (合法返回空串)
+    static std::string validate_stream(const StreamConfig& stream_config);
+
+    /// 缓冲池统计 -> JSON
+    static nlohmann::json pool_stats_json(const BufferPool::Stats& stats);
+
+    /// 滑动窗口速率 -> JSON ({"1s", "10s", "60s"}, 次/秒)
+    static nlohmann::json rates_json(const RateMeter::Rates& rates);
+
+    /// 生成 /metrics 的 Prometheus 文本
+    std::string prometheus_metrics() const;
+
+    /// 占用一个推送连接名额 (超过 http_push_clients 返回 false)
+    bool acquire_push_slot();
+
     StreamManager& stream_mgr_;
     ImageCache* cache_ = nullptr;
+    ResultBroadcaster* broadcaster_ = nullptr;
+    ClusterCoordinator* cluster_ = nullptr;
 #ifdef HAS_RKNN
     InferenceEngine* engine_ = nullptr;
 #endif
@@ -100,6 +146,7 @@ private:
     std::unique_ptr<httplib::Server> server_;
     std::thread server_thread_;
     std::atomic<bool> running_{false};
+    std::atomic<int> push_clients_{0};
     std::chrono::steady_clock::time_point start_time_;
 };
 
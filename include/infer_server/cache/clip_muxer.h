@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * @file clip_muxer.h
+ * @brief 视频片段封装 (无转码 remux)
+ *
+ * 将 PacketRing 提取的压缩包序列直接封装为 MP4 或 MPEG-TS, 只做容器层写入,
+ * 不解码也不重新编码, CPU 开销可忽略。
+ *
+ * - MP4 输出为 fragmented MP4 (empty_moov + frag_keyframe), 可写入非 seekable 的内存缓冲
+ * - 时间戳整体平移, 片段从 0 开始
+ */
+
+#ifdef HAS_FFMPEG
+
+#include "infer_server/cache/packet_ring.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace infer_server {
+
+class ClipMuxer {
+public:
+    /// 支持的容器格式
+    static bool is_supported_format(const std::string& format) {
+        return format == "mp4" || format == "ts";
+    }
+
+    /// 容器格式对应的 HTTP Content-Type
+    static const char* content_type(const std::string& format) {
+        return format == "ts" ? "video/mp2t" : "video/mp4";
+    }
+
+    /**
+     * @brief 封装片段到内存
+     * @param clip    PacketRing::get_clip() 的结果
+     * @param format  "mp4" 或 "ts"
+     * @param out     输出容器数据
+     * @return true 成功 (错误信息通过 LOG_ERROR 输出)
+     */
+    static bool remux(const Clip& clip, const std::string& format, std::vector<uint8_t>& out);
+};
+
+} // namespace infer_server
+
+#endif // HAS_FFMPEG
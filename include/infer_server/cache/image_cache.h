@@ -8,21 +8,32 @@
  * 用于报警层获取报警时刻的图片/视频截图。
  *
  * 特性:
- * - 每个流独立的 deque + mutex (不同流写入互不阻塞)
+ * - 每个流一个按 timestamp_ms 升序的连续数组, 精确/最近查询为二分查找 O(log n)
+ * - 读取无锁阻塞: 写入者 (add_frame / 淘汰 / 延迟编码回写) 以写时复制方式发布新数组,
+ *   读取者原子加载当前快照 (shared_ptr), 不与解码线程竞争同一把锁
+ * - 不同流写入互不阻塞 (每流独立写锁)
  * - 按时间自动淘汰过期帧
- * - 全局内存上限控制
- * - 支持精确时间戳查询和最近帧查询
+ * - 全局内存上限控制: 有序索引记录各流最旧帧, 淘汰时直接取全局最旧帧, 不遍历所有流
+ * - 支持延迟编码: 帧只带 raw_nv12 时, 首次被读取才编码为 JPEG 并替换原图
+ *   (报警层只读取极少数帧, 大部分帧无需编码)
+ * - 支持检测框叠加: 推理结果按 frame_id 回填到尚未编码的帧, 延迟编码时先画框再编码
+ *   (带框图片只编码一次)
  * - 线程安全
  */
 
 #include "infer_server/common/types.h"
-#include <deque>
+#include "infer_server/cache/jpeg_encoder.h"
+#include <vector>
+#include <set>
+#include <utility>
 #include <mutex>
 #include <unordered_map>
 #include <memory>
 #include <string>
 #include <optional>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 
 namespace infer_server {
 
@@ -30,8 +41,11 @@ class ImageCache {
 public:
     /// @param duration_sec    每流保留时长 (秒)
     /// @param max_memory_mb   全局最大缓存内存 (MB, 0=不限制)
-    ImageCache(int duration_sec = 5, int max_memory_mb = 64);
-    ~ImageCache() = default;
+    /// @param jpeg_quality    延迟编码帧的 JPEG 质量 (1-100)
+    /// @param jpeg_backend    延迟编码使用的 JPEG 后端 (AUTO: MPP 可用时硬件编码)
+    ImageCache(int duration_sec = 5, int max_memory_mb = 64, int jpeg_quality = 75,
+               JpegBackend jpeg_backend = JpegBackend::TURBOJPEG);
+    ~ImageCache();
 
     // 禁止拷贝
     ImageCache(const ImageCache&) = delete;
@@ -43,11 +57,18 @@ public:
     /// 删除一个流及其所有缓存帧
     void remove_stream(const std::string& cam_id);
 
-    /// 添加一帧到缓存
+    /// 添加一帧到缓存 (jpeg_data 或 raw_nv12 二选一)
     /// 自动清理该流的过期帧; 如果全局内存超限, 淘汰最旧帧
     void add_frame(CachedFrame frame);
 
+    /// 把推理结果的检测框回填到对应的缓存帧 (按 cam_id + timestamp_ms + frame_id 匹配)
+    /// 只对尚未编码的 raw 帧生效, 之后的延迟编码会把检测框画入 JPEG;
+    /// 同一帧多次回填时检测框累加 (多个模型的结果分开到达)
+    /// @return 找到未编码的帧并回填返回 true; 没有检测框 / 帧不存在 / 已编码返回 false
+    bool attach_overlay(const FrameResult& result);
+
     /// 按精确时间戳获取帧
+    /// 以下查询接口返回的帧总是带 jpeg_data (延迟编码帧在此时编码, 编码失败时为空)
     /// @return 匹配的帧, 找不到返回 nullopt
     std::optional<CachedFrame> get_frame(
         const std::string& cam_id, int64_t timestamp_ms) const;
@@ -61,24 +82,66 @@ public:
     std::optional<CachedFrame> get_latest_frame(
         const std::string& cam_id) const;
 
-    /// 当前缓存的总内存使用 (字节)
+    /// 等待某流出现比 after_timestamp_ms 更新的帧, 返回其中最新一帧 (用于 MJPEG 推送)
+    /// 已有更新的帧时立即返回; 没有读取者等待时 add_frame 不做任何通知
+    /// @return 最新帧, 超时或流不存在返回 nullopt
+    std::optional<CachedFrame> wait_latest_frame(
+        const std::string& cam_id, int64_t after_timestamp_ms,
+        std::chrono::milliseconds timeout) const;
+
+    /// 当前缓存的总内存使用 (字节, JPEG + 未编码的原图)
     size_t total_memory_bytes() const;
 
+    /// 延迟编码次数 (raw_nv12 帧首次被读取时编码)
+    uint64_t lazy_encode_count() const { return lazy_encodes_.load(std::memory_order_relaxed); }
+
+    /// 带检测框编码的帧数
+    uint64_t annotated_count() const { return annotated_.load(std::memory_order_relaxed); }
+
     /// 当前缓存帧总数
     size_t total_frames() const;
 
     /// 某流当前缓存帧数
     size_t stream_frame_count(const std::string& cam_id) const;
 
+    /// 流是否已注册
+    bool has_stream(const std::string& cam_id) const { return get_cache(cam_id) != nullptr; }
+
     /// 已注册的流数量
     size_t stream_count() const;
 
 private:
+    using FramePtr = std::shared_ptr<const CachedFrame>;
+    /// 不可变快照: 按 timestamp_ms 升序 (相同时间戳按写入顺序)
+    using FrameList = std::vector<FramePtr>;
+    using Snapshot = std::shared_ptr<const FrameList>;
+
     /// 单个流的缓存
     struct StreamCache {
-        std::deque<CachedFrame> frames;
-        mutable std::mutex mutex;
-        std::atomic<size_t> memory_bytes{0};  ///< 该流的 JPEG 总大小
+        explicit StreamCache(std::string id);
+
+        const std::string cam_id;
+        std::mutex write_mutex;                 ///< 串行化该流的写入者
+        std::atomic<size_t> memory_bytes{0};    ///< 该流的缓存总大小
+
+        // 以下成员由 write_mutex 保护
+        int64_t indexed_oldest = 0;             ///< 在 oldest_index_ 中登记的最旧时间戳
+        bool indexed = false;
+        bool removed = false;                   ///< 已从 caches_ 删除 (迟到的写入直接丢弃)
+
+        // 新帧通知 (wait_latest_frame): 仅在 waiters > 0 时加锁通知
+        std::atomic<int> waiters{0};
+        std::mutex notify_mutex;
+        std::condition_variable notify_cv;
+
+        /// 当前快照 (读取者无需 write_mutex)
+        Snapshot load() const { return std::atomic_load(&frames_); }
+
+        /// 发布新快照 (调用方持有 write_mutex)
+        void store(Snapshot next) { std::atomic_store(&frames_, std::move(next)); }
+
+    private:
+        Snapshot frames_;
     };
 
     /// 获取或创建流缓存
@@ -87,19 +150,41 @@ private:
     /// 获取流缓存 (不创建)
     std::shared_ptr<StreamCache> get_cache(const std::string& cam_id) const;
 
-    /// 清理单个流的过期帧
-    void evict_expired(StreamCache& cache, int64_t now_ms);
+    /// 发布新快照并更新最旧帧索引 (调用方持有 cache.write_mutex)
+    void publish(StreamCache& cache, std::shared_ptr<FrameList> next);
+
+    /// 更新最旧帧索引 (调用方持有 cache.write_mutex)
+    void update_oldest_index(StreamCache& cache, const FrameList& frames);
 
     /// 全局内存淘汰
     void evict_global_memory();
 
+    /// 延迟编码: frame 为 raw 帧时编码为 JPEG, 并回写缓存中的对应帧 (释放原图)
+    /// 编码在锁之外进行, 不阻塞该流的写入
+    CachedFrame materialize(StreamCache& cache, CachedFrame frame) const;
+
+    /// 第一个 timestamp_ms >= ts 的位置
+    static FrameList::const_iterator lower_bound_ts(const FrameList& frames, int64_t ts);
+
     int duration_sec_;
     size_t max_memory_bytes_;
+    int jpeg_quality_;
+    JpegBackend jpeg_backend_;
+
+    mutable std::mutex encoder_mutex_;              ///< 保护 encoder_ (TurboJPEG handle / MPP 上下文非线程安全)
+    mutable std::unique_ptr<JpegEncoder> encoder_;  ///< 首次延迟编码时创建
+    mutable std::atomic<uint64_t> lazy_encodes_{0};
+    mutable std::atomic<uint64_t> annotated_{0};
 
     mutable std::mutex map_mutex_;  ///< 保护 caches_ map
     std::unordered_map<std::string, std::shared_ptr<StreamCache>> caches_;
 
-    std::atomic<size_t> total_memory_{0};  ///< 全局 JPEG 总大小
+    /// 各流最旧帧索引 (timestamp_ms, cam_id), begin() 即全局最旧帧
+    /// 锁顺序: StreamCache::write_mutex -> oldest_mutex_
+    std::mutex oldest_mutex_;
+    std::set<std::pair<int64_t, std::string>> oldest_index_;
+
+    mutable std::atomic<size_t> total_memory_{0};  ///< 全局缓存总大小
 };
 
 } // namespace infer_server
@@ -2,12 +2,50 @@
 
 /**
  * @file jpeg_encoder.h
- * @brief JPEG 编码工具 (基于 libjpeg-turbo TurboJPEG API)
+ * @brief JPEG 编码工具 (MPP 硬件编码 / TurboJPEG 软件编码)
  *
- * 将 RGB 数据编码为 JPEG 格式, 用于图片缓存。
- * TurboJPEG 在 ARM64 上使用 NEON 指令优化, 编码速度很快。
+ * 将 NV12 / RGB 数据编码为 JPEG 格式, 用于图片缓存。
+ *
+ * 后端:
+ * - MPP (HAS_MPP): Rockchip VEPU 硬件 MJPEG 编码, 直接接受 NV12, 不占用 CPU 核心
+ * - TurboJPEG: 软件编码 (ARM64 上使用 NEON), 始终可用, 作为回退
+ *
+ * 默认只用 TurboJPEG (MPP 路径尚未在硬件上验证); 选择 AUTO / MPP 时 NV12 输入优先走 MPP,
+ * MPP 不可用时使用 TurboJPEG, 硬件编码出错后该编码器改用 TurboJPEG。
+ * RGB 输入总是走 TurboJPEG (MPP JPEG 只接受 YUV)。
  */
 
+#include <string>
+
+namespace infer_server {
+
+/// JPEG 编码后端
+enum class JpegBackend {
+    AUTO = 0,       ///< MPP 可用时用 MPP, 否则 TurboJPEG
+    MPP = 1,        ///< 硬件编码 (初始化失败时仍回退到 TurboJPEG)
+    TURBOJPEG = 2,  ///< 只用软件编码
+};
+
+/// 后端名称 ("auto" / "mpp" / "turbojpeg")
+inline const char* jpeg_backend_name(JpegBackend backend) {
+    switch (backend) {
+        case JpegBackend::MPP: return "mpp";
+        case JpegBackend::TURBOJPEG: return "turbojpeg";
+        default: return "auto";
+    }
+}
+
+/// 解析后端名称 (配置项 cache_jpeg_backend)
+/// @return 名称合法返回 true
+inline bool parse_jpeg_backend(const std::string& name, JpegBackend& backend) {
+    if (name == "auto") { backend = JpegBackend::AUTO; return true; }
+    if (name == "mpp") { backend = JpegBackend::MPP; return true; }
+    if (name == "turbojpeg") { backend = JpegBackend::TURBOJPEG; return true; }
+    return false;
+}
+
+} // namespace infer_server
+
 #ifdef HAS_TURBOJPEG
 
 #include <vector>
@@ -16,16 +54,21 @@
 
 namespace infer_server {
 
+#ifdef HAS_MPP
+class MppJpegEncoder;
+#endif
+
 class JpegEncoder {
 public:
-    JpegEncoder();
+    /// @param backend NV12 编码使用的后端 (AUTO: 优先 MPP)
+    explicit JpegEncoder(JpegBackend backend = JpegBackend::TURBOJPEG);
     ~JpegEncoder();
 
-    // 禁止拷贝 (TurboJPEG handle 不可共享)
+    // 禁止拷贝 (TurboJPEG handle / MPP 上下文不可共享)
     JpegEncoder(const JpegEncoder&) = delete;
     JpegEncoder& operator=(const JpegEncoder&) = delete;
 
-    /// 将 RGB 数据编码为 JPEG
+    /// 将 RGB 数据编码为 JPEG (TurboJPEG)
     /// @param rgb_data   RGB888 数据 (3 bytes per pixel, R-G-B 顺序)
     /// @param width      图片宽度
     /// @param height     图片高度
@@ -34,11 +77,38 @@ public:
     std::vector<uint8_t> encode(
         const uint8_t* rgb_data, int width, int height, int quality = 75);
 
+    /// 将 NV12 数据编码为 JPEG (YUV 直接编码, 无 RGB 色彩转换; MPP 可用时为硬件编码)
+    /// @param nv12_data  NV12 数据 (Y plane + UV interleaved, 大小 = width * height * 3/2)
+    /// @param width      图片宽度 (偶数)
+    /// @param height     图片高度 (偶数)
+    /// @param quality    JPEG 质量 (1-100)
+    /// @return JPEG 数据, 编码失败返回空 vector
+    std::vector<uint8_t> encode_nv12(
+        const uint8_t* nv12_data, int width, int height, int quality = 75);
+
     /// 编码器是否可用
-    bool is_valid() const { return handle_ != nullptr; }
+    bool is_valid() const { return handle_ != nullptr || hardware(); }
+
+    /// NV12 编码当前实际使用的后端 (MPP 或 TURBOJPEG)
+    JpegBackend backend() const { return hardware() ? JpegBackend::MPP : JpegBackend::TURBOJPEG; }
+
+    /// 硬件编码次数
+    uint64_t hw_encodes() const { return hw_encodes_; }
 
 private:
+    /// MPP 编码器是否可用
+    bool hardware() const;
+
+    /// TurboJPEG NV12 编码
+    std::vector<uint8_t> encode_nv12_soft(
+        const uint8_t* nv12_data, int width, int height, int quality);
+
     void* handle_ = nullptr;  // tjhandle (TurboJPEG compressor handle)
+    std::vector<uint8_t> chroma_planes_;  ///< NV12 UV 拆分为 U/V 平面的临时缓冲 (复用)
+#ifdef HAS_MPP
+    std::unique_ptr<MppJpegEncoder> mpp_;
+#endif
+    uint64_t hw_encodes_ = 0;
 };
 
 } // namespace infer_server
@@ -0,0 +1,65 @@
+#pragma once
+
+/**
+ * @file mpp_jpeg_encoder.h
+ * @brief Rockchip MPP 硬件 JPEG 编码 (VEPU, MJPEG)
+ *
+ * 由 JpegEncoder 在 HAS_MPP 时使用, 不直接对外暴露。
+ *
+ * - 输入 NV12 (MPP_FMT_YUV420SP), 拷贝进按 16 对齐步长的 DRM 缓冲后送入编码器
+ *   (缓存缩略图由 RGA 写在普通内存中, 拷贝一帧 640x360 约 0.35 MB)
+ * - 输出写入预分配的 DRM 缓冲 (KEY_OUTPUT_PACKET), 不经过 MPP 内部分配
+ * - 尺寸 / 质量变化时重新配置; 输入输出缓冲按最大尺寸复用
+ * - 非线程安全: 每个 JpegEncoder 持有独立的 MPP 上下文 (硬件由驱动在上下文之间分时复用)
+ */
+
+#ifdef HAS_MPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace infer_server {
+
+class MppJpegEncoder {
+public:
+    MppJpegEncoder();
+    ~MppJpegEncoder();
+
+    MppJpegEncoder(const MppJpegEncoder&) = delete;
+    MppJpegEncoder& operator=(const MppJpegEncoder&) = delete;
+
+    /// 上下文是否创建成功
+    bool is_valid() const { return ctx_ != nullptr; }
+
+    /// 编码 NV12 (宽高为偶数, 质量 1-100)
+    /// @return JPEG 数据, 失败返回空 vector
+    std::vector<uint8_t> encode(const uint8_t* nv12, int width, int height, int quality);
+
+private:
+    /// 按尺寸 / 质量配置编码器 (与当前配置相同时直接返回)
+    bool configure(int width, int height, int quality);
+
+    /// 确保输入 / 输出缓冲至少 size 字节
+    bool ensure_buffers(size_t size);
+
+    void release_buffers();
+
+    void* ctx_ = nullptr;       ///< MppCtx
+    void* mpi_ = nullptr;       ///< MppApi*
+    void* cfg_ = nullptr;       ///< MppEncCfg
+    void* group_ = nullptr;     ///< MppBufferGroup (DRM)
+    void* frame_buf_ = nullptr; ///< MppBuffer: 输入 NV12
+    void* packet_buf_ = nullptr;///< MppBuffer: 输出 JPEG
+    size_t buf_size_ = 0;
+
+    int width_ = 0;
+    int height_ = 0;
+    int hor_stride_ = 0;
+    int ver_stride_ = 0;
+    int quality_ = 0;
+};
+
+} // namespace infer_server
+
+#endif // HAS_MPP
@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * @file overlay.h
+ * @brief 在缓存缩略图 (NV12) 上绘制检测框
+ *
+ * 报警图片的检测框在 JPEG 编码之前直接画在 NV12 缩略图上, 带框的图片只需一次编码
+ * (客户端无需 解码 -> 画框 -> 再编码)。
+ *
+ * 只画矩形边框: 每个框只改写边框上的像素 (逐行 memset, Y 平面全分辨率, UV 平面半分辨率),
+ * 开销远小于一次 RGA 任务提交, 因此不走 RGA。颜色按 class_id 取自固定调色板。
+ *
+ * 纯 CPU, 不依赖任何硬件库。
+ */
+
+#include "infer_server/common/types.h"
+#include <cstdint>
+#include <vector>
+
+namespace infer_server {
+namespace overlay {
+
+/// 根据缩略图宽度选择边框粗细 (像素, 偶数, 640 宽约 2 像素)
+int default_thickness(int width);
+
+/**
+ * @brief 把推理结果的检测框换算到缓存图坐标
+ * @param result   推理结果 (检测框为原图坐标)
+ * @param width    缓存图宽度
+ * @param height   缓存图高度
+ * @return 缓存图坐标的检测框 (已裁剪到图像范围, 丢弃空框)
+ */
+std::vector<OverlayBox> scale_boxes(const FrameResult& result, int width, int height);
+
+/**
+ * @brief 在 NV12 图像上原地绘制矩形边框
+ * @param nv12      NV12 数据 (width * height * 3/2, Y 平面 + UV 交错平面)
+ * @param width     图像宽度 (偶数)
+ * @param height    图像高度 (偶数)
+ * @param boxes     检测框 (缓存图坐标)
+ * @param thickness 边框粗细 (像素, <= 0 时按宽度自动选择)
+ */
+void draw_boxes_nv12(uint8_t* nv12, int width, int height,
+                     const std::vector<OverlayBox>& boxes, int thickness = 0);
+
+} // namespace overlay
+} // namespace infer_server
@@ -0,0 +1,116 @@
+#pragma once
+
+/**
+ * @file packet_ring.h
+ * @brief 每流压缩码流环形缓冲 (报警视频片段)
+ *
+ * 报警层需要事件前后数秒的视频片段。用 ImageCache 保存 5 秒 640px JPEG
+ * 的内存远大于原始 H.264/H.265 码流, 因此在 HwDecoder 解复用之后、送入解码器之前
+ * 把视频包原样保存下来, 需要片段时再无转码地封装为 MP4 / MPEG-TS (ClipMuxer)。
+ *
+ * 特性:
+ * - 按关键帧索引: 总是以完整 GOP 为单位淘汰, 缓冲区首包始终是关键帧
+ * - 按时长 (最新包 - 最旧包) 和内存上限淘汰
+ * - get_clip() 二分查找不晚于起始时间的关键帧, 输出可独立解码的包序列
+ * - timestamp_ms 与 DecodedFrame::timestamp_ms 同一时间基准 (PTS 换算的毫秒)
+ * - 线程安全 (解码线程写入, REST 线程读取)
+ *
+ * 纯数据结构, 不依赖 FFmpeg。
+ */
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+
+namespace infer_server {
+
+/// 一个压缩视频包 (一帧的码流)
+struct ClipPacket {
+    std::shared_ptr<std::vector<uint8_t>> data;
+    int64_t pts = 0;                ///< 流时间基 (ClipCodecInfo::time_base)
+    int64_t dts = 0;                ///< 流时间基
+    int64_t duration = 0;           ///< 流时间基 (0 = 未知)
+    int64_t timestamp_ms = 0;       ///< 显示时间 (毫秒)
+    bool keyframe = false;
+
+    size_t size() const { return data ? data->size() : 0; }
+};
+
+/// 重新封装所需的码流参数 (取自 AVCodecParameters / AVStream)
+struct ClipCodecInfo {
+    int codec_id = 0;               ///< AVCodecID
+    int width = 0;
+    int height = 0;
+    int time_base_num = 1;
+    int time_base_den = 90000;
+    int fps_num = 0;                ///< 平均帧率 (0 = 未知)
+    int fps_den = 1;
+    std::vector<uint8_t> extradata; ///< SPS/PPS (VPS) 等
+};
+
+/// 一个视频片段
+struct Clip {
+    ClipCodecInfo codec;
+    std::vector<ClipPacket> packets;  ///< 解码顺序, 首包为关键帧
+    int64_t start_ms = 0;             ///< 首包时间
+    int64_t end_ms = 0;               ///< 末包时间
+};
+
+class PacketRing {
+public:
+    /// @param duration_sec  保留时长 (秒)
+    /// @param max_bytes     内存上限 (字节, 0=不限制)
+    PacketRing(int duration_sec, size_t max_bytes);
+
+    PacketRing(const PacketRing&) = delete;
+    PacketRing& operator=(const PacketRing&) = delete;
+
+    /// 设置码流参数并清空已有包 (每次打开流时调用, 重连后的时间戳不连续)
+    void reset(ClipCodecInfo codec);
+
+    /// 追加一个包 (解码顺序)。第一个关键帧之前的包无法独立解码, 直接丢弃
+    void push(ClipPacket packet);
+
+    /**
+     * @brief 提取 [start_ms, end_ms] 时间窗口的片段
+     *
+     * 起点向前对齐到不晚于 start_ms 的关键帧 (早于缓冲区则从最旧关键帧开始),
+     * 终点为第一个时间晚于 end_ms 的包之前。
+     * @return 片段, 窗口与缓冲区无交集时返回 nullopt
+     */
+    std::optional<Clip> get_clip(int64_t start_ms, int64_t end_ms) const;
+
+    /// 清空所有包 (保留码流参数)
+    void clear();
+
+    size_t packet_count() const;
+    size_t keyframe_count() const;
+    size_t memory_bytes() const;
+
+    /// 缓冲区覆盖的时长 (最新包 - 最旧包, 毫秒)
+    int64_t duration_ms() const;
+
+private:
+    /// 淘汰最旧的一个 GOP (调用方持有 mutex_)
+    void pop_front_gop();
+
+    /// 关键帧在 packets_ 中的下标 (调用方持有 mutex_)
+    size_t key_index(size_t k) const { return static_cast<size_t>(key_seqs_[k] - base_seq_); }
+
+    int64_t duration_ms_limit_;
+    size_t max_bytes_;
+
+    mutable std::mutex mutex_;
+    ClipCodecInfo codec_;
+    std::deque<ClipPacket> packets_;
+    std::deque<uint64_t> key_seqs_;   ///< 关键帧的序号 (单调递增)
+    uint64_t base_seq_ = 0;           ///< packets_.front() 的序号
+    int64_t newest_ms_ = 0;           ///< 已写入包的最大时间戳
+    size_t bytes_ = 0;
+};
+
+} // namespace infer_server
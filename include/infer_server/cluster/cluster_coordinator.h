@@ -0,0 +1,132 @@
+#pragma once
+
+/**
+ * @file cluster_coordinator.h
+ * @brief 集群协调器: 把摄像头分配到多个 infer_server 节点并汇聚结果
+ *
+ * 配置了 cluster_nodes 的实例作为协调器 (自身也可以列为节点之一):
+ * - 全部流配置保存在 cluster_streams_path, 经 /api/cluster/streams 增删
+ * - 每 cluster_poll_ms 轮询各节点: GET /api/node (容量 / NPU 利用率 / 推理丢帧率),
+ *   GET /api/streams (节点上实际运行的流)
+ * - ShardPlanner 计算目标分配, 经节点现有 REST 流接口执行:
+ *   DELETE /api/streams/:cam_id 移除, POST /api/streams 添加 (请求体为完整 StreamConfig)
+ * - 单次轮询失败 / 超时 (过载节点最容易超时) 不判定下线: 沿用上次观测到的流与负载, 节点冻结
+ *   (不加新流、不迁出); 连续 3 次失败后才视为不可达, 其上的流在其他节点上
+ *   重新添加, 节点恢复后多余的副本被移除
+ * - 可选结果汇聚 (cluster_zmq_endpoint, 需要 HAS_CLUSTER_FORWARD): ResultForwarder 以 XSUB 连接
+ *   各节点的 ZMQ 发布端, 经一个 XPUB 端点转发, 订阅者只需连接协调器
+ *
+ * 节点之间不直接通信; 协调器停止后各节点继续运行当前的流 (各自的 streams_save_path 持久化)。
+ */
+
+#ifdef HAS_HTTP
+
+#include "infer_server/common/config.h"
+#include "infer_server/cluster/shard_planner.h"
+
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace infer_server {
+
+#ifdef HAS_CLUSTER_FORWARD
+class ResultForwarder;
+#endif
+
+class ClusterCoordinator {
+public:
+    /// 一个节点的最近一次轮询结果
+    struct NodeInfo {
+        std::string url;                ///< REST 地址 (分配时的节点键)
+        std::string node_id;            ///< 节点上报的名称
+        bool healthy = false;
+        int streams = 0;                ///< 节点上运行的流数
+        int max_streams = 0;            ///< 节点上报的容量 (0 = 不限)
+        double npu_util = 0.0;          ///< NPU 平均利用率
+        double drop_rate = 0.0;         ///< 推理丢帧率 (帧/秒, 10s 窗口)
+        bool overloaded = false;
+        int poll_failures = 0;          ///< 连续轮询失败次数 (> 0 且 healthy: 沿用上次观测)
+        std::string zmq_endpoint;       ///< 结果汇聚时连接的地址 (空 = 节点未启用 ZMQ)
+        std::string error;              ///< 最近一次轮询 / 操作失败原因
+    };
+
+    explicit ClusterCoordinator(const ServerConfig& config);
+    ~ClusterCoordinator();
+
+    ClusterCoordinator(const ClusterCoordinator&) = delete;
+    ClusterCoordinator& operator=(const ClusterCoordinator&) = delete;
+
+    /// 加载 cluster_streams_path, 启动轮询线程 (及结果汇聚)
+    bool start();
+    void stop();
+
+    // === 集群流配置 ===
+
+    /// 添加流 (cam_id 已存在返回 false); 持久化并立即触发一轮分配
+    bool add_stream(const StreamConfig& stream);
+
+    /// 移除流 (不存在返回 false); 持久化并立即触发一轮分配
+    bool remove_stream(const std::string& cam_id);
+
+    std::vector<StreamConfig> streams() const;
+
+    /// 立即执行一轮轮询与分配 (阻塞); 测试与手动再平衡用
+    void reconcile();
+
+    /// 集群状态: 节点 / 分配 / 未分配的流 / 最近一轮的操作
+    nlohmann::json status() const;
+
+    /// 节点 URL 对应的 ZMQ 地址: 节点 zmq_endpoint 中的通配主机 (* / 0.0.0.0) 替换为 URL 中的主机
+    static std::string zmq_endpoint_for(const std::string& node_url, const std::string& node_zmq);
+
+private:
+    void run();
+
+    /// 轮询一个节点, 返回其上运行的 cam_id
+    std::vector<std::string> poll_node(NodeInfo& node) const;
+
+    /// 在节点上执行一个操作, 失败返回错误信息
+    std::string apply(const ShardAction& action, const StreamConfig* stream) const;
+
+    void save_streams() const;
+
+    /// 节点最近一次成功的轮询结果 (轮询失败未达到下线判定时沿用)
+    struct NodeTrack {
+        int failures = 0;                       ///< 连续轮询失败次数
+        NodeInfo last;                          ///< 最近一次成功的轮询结果 (url 为空 = 从未成功)
+        std::vector<std::string> streams;       ///< 最近一次观测到的流
+    };
+
+    ServerConfig config_;
+
+    mutable std::mutex mutex_;                  ///< 保护 streams_ 与状态
+    std::map<std::string, StreamConfig> streams_;
+    std::vector<NodeInfo> nodes_;
+    ShardPlan last_plan_;
+    std::vector<std::string> last_errors_;      ///< 最近一轮失败的操作
+    uint64_t rounds_ = 0;
+
+    std::mutex reconcile_mutex_;                ///< 串行化 reconcile()
+    ShedState shed_;                            ///< 过载迁出的记忆 (reconcile_mutex_ 保护)
+    std::map<std::string, NodeTrack> tracks_;   ///< url -> 轮询记录 (reconcile_mutex_ 保护)
+    std::condition_variable cv_;
+    bool wake_ = false;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+#ifdef HAS_CLUSTER_FORWARD
+    std::unique_ptr<ResultForwarder> forwarder_;
+#endif
+};
+
+} // namespace infer_server
+
+#endif // HAS_HTTP
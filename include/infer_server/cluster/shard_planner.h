@@ -0,0 +1,90 @@
+#pragma once
+
+/**
+ * @file shard_planner.h
+ * @brief 多节点分片: 摄像头 -> 节点分配与再平衡规划
+ *
+ * 单台 RK3588 约可承载 16~24 路摄像头, 更多路数需要多台节点。ShardPlanner 根据
+ * 各节点上报的容量与负载, 计算每路流应运行在哪个节点, 以及从当前状态到目标状态的操作
+ * (在节点上添加 / 移除流, 由 ClusterCoordinator 经各节点现有 REST 流接口执行)。
+ *
+ * - 分配: 加权 rendezvous (HRW) 哈希, score = -weight / ln(hash(node, cam_id)),
+ *   每路流按得分从高到低选择第一个还有容量的健康节点 (按 cam_id 顺序, 结果确定)。
+ *   节点增减时只有约 1/N 的流需要迁移, 其余流不动
+ * - 容量: max_streams (0 = 不限); 过载节点 (推理丢帧) 的容量临时降为当前路数 - 1,
+ *   每轮迁出一路, 直到不再过载。降低后的容量记在 ShedState 中, 节点连续 cooldown_rounds 轮
+ *   不过载后才放开一路, 迁出的流不会在 "过载 / 恢复" 之间来回迁移
+ * - 操作: 未运行的流直接添加 (不限数量, 故障恢复优先); 在健康节点上运行但不在目标节点的流
+ *   每轮最多迁移 max_moves 路 (避免集中重连); 重复运行 / 已删除的流直接移除
+ * - 疑似故障 (suspect) 的节点: 容量冻结为当前路数, 其上的流原地保留, 直到恢复或被判定下线
+ *
+ * 纯规划逻辑, 不依赖网络。
+ */
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace infer_server {
+
+/// 节点状态 (由协调器轮询节点 /api/node 得到)
+struct NodeLoad {
+    std::string node_id;
+    bool healthy = true;        ///< 节点可达 (不健康节点上的流视为未运行)
+    int max_streams = 0;        ///< 可承载路数 (0 = 不限)
+    double weight = 1.0;        ///< 哈希权重 (容量越大分到的流越多)
+    bool overloaded = false;    ///< 推理丢帧超过阈值
+    bool suspect = false;       ///< 最近轮询失败但尚未判定下线: 保留其上的流, 不分配新流也不迁出
+};
+
+/// 对节点的一个操作
+struct ShardAction {
+    enum class Kind { Add, Remove };
+    Kind kind = Kind::Add;
+    std::string cam_id;
+    std::string node_id;
+};
+
+/// 过载迁出的记忆 (由调用方跨轮保存并传给 plan())
+struct ShedState {
+    struct Entry {
+        int cap = 0;            ///< 迁出后记住的容量上限
+        int calm_rounds = 0;    ///< 连续不过载的轮数
+    };
+    std::map<std::string, Entry> nodes;     ///< node_id -> 记住的上限
+    int cooldown_rounds = 5;                ///< 连续不过载多少轮后放开一路
+};
+
+/// 规划结果
+struct ShardPlan {
+    std::vector<ShardAction> actions;               ///< 先执行所有 Remove, 再执行 Add
+    std::map<std::string, std::string> assignment;  ///< 执行后 cam_id -> node_id
+    std::vector<std::string> unassigned;            ///< 没有节点有剩余容量的流
+    int moves = 0;                                  ///< 本轮迁移的流数 (不含新增)
+    int deferred = 0;                               ///< 超过 max_moves 推迟到下一轮的迁移数
+};
+
+class ShardPlanner {
+public:
+    /// cam_id 在该节点上的 HRW 得分 (越大越优先)
+    static double score(const std::string& node_id, const std::string& cam_id, double weight = 1.0);
+
+    /// 按得分从高到低排列的健康节点下标
+    static std::vector<size_t> rank(const std::string& cam_id, const std::vector<NodeLoad>& nodes);
+
+    /**
+     * @brief 规划一轮分配
+     * @param cams      期望运行的全部 cam_id
+     * @param nodes     节点状态
+     * @param running   观测到的运行情况: cam_id -> 正在运行它的健康节点 (可多个)
+     * @param max_moves 本轮最多迁移的流数 (< 0 = 不限)
+     * @param shed      过载迁出的记忆 (nullptr = 只按本轮是否过载; 非空时按本轮结果更新)
+     */
+    static ShardPlan plan(const std::vector<std::string>& cams,
+                          const std::vector<NodeLoad>& nodes,
+                          const std::map<std::string, std::vector<std::string>>& running,
+                          int max_moves = -1, ShedState* shed = nullptr);
+};
+
+} // namespace infer_server
@@ -3,59 +3,112 @@
 /**
  * @file bounded_queue.h
  * @brief 线程安全有界队列 (满时丢弃最旧元素)
- * 
+ *
  * 设计用于解码器→推理器之间的帧传递:
  * - 队列满时自动丢弃最旧的元素，保证实时性
  * - 支持阻塞 pop (带超时) 和非阻塞 try_pop
  * - 支持 stop() 优雅关闭
  * - 统计丢弃帧数
  * - 支持移动语义 (可用于 unique_ptr 等不可拷贝类型)
+ * - 支持按条件弹出 (pop_if), 供推理批处理收集同一模型的任务
+ *
+ * 两种实现, 构造时按队列选择 (QueueMode):
+ * - MUTEX:     std::deque + mutex + condition_variable (默认)
+ * - LOCK_FREE: 固定容量的 Vyukov MPMC 环形缓冲, 读写索引按 cache line 隔离;
+ *              push/pop 无锁, 仅在队列为空需要阻塞等待时才进入 mutex/condvar (futex),
+ *              push 只在存在等待者时 notify。
+ *              pop_if 把跳过的元素移入受 mutex 保护的暂存区 (最多 capacity 个),
+ *              后续 pop 优先从暂存区取出, 保持 FIFO 顺序。
  */
 
-#include <queue>
+#include <deque>
+#include <algorithm>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
 #include <optional>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
 #include <cstddef>
+#include <cstdint>
 
 namespace infer_server {
 
+/// 队列实现选择
+enum class QueueMode {
+    MUTEX,          ///< 互斥锁 + 条件变量
+    LOCK_FREE       ///< 无锁 MPMC 环形缓冲 (空时回退到条件变量等待)
+};
+
 template<typename T>
 class BoundedQueue {
 public:
     /// 构造有界队列
     /// @param capacity 最大容量 (必须 > 0)
-    explicit BoundedQueue(size_t capacity)
-        : capacity_(capacity > 0 ? capacity : 1) {}
+    /// @param mode     实现方式
+    explicit BoundedQueue(size_t capacity, QueueMode mode = QueueMode::MUTEX)
+        : capacity_(capacity > 0 ? capacity : 1)
+        , mode_(mode)
+    {
+        if (mode_ == QueueMode::LOCK_FREE) {
+            init_ring();
+        }
+    }
+
+    ~BoundedQueue() {
+        if (cells_) {
+            while (ring_try_pop()) {}
+        }
+    }
 
     // 禁止拷贝
     BoundedQueue(const BoundedQueue&) = delete;
     BoundedQueue& operator=(const BoundedQueue&) = delete;
 
-    // 允许移动
+    // 允许移动 (不可与其他线程的访问并发)
     BoundedQueue(BoundedQueue&& other) noexcept {
         std::lock_guard<std::mutex> lock(other.mutex_);
         capacity_ = other.capacity_;
+        mode_ = other.mode_;
         queue_ = std::move(other.queue_);
-        stopped_ = other.stopped_;
-        dropped_count_ = other.dropped_count_;
+        cells_ = std::move(other.cells_);
+        stash_ = std::move(other.stash_);
+        stash_count_.store(other.stash_count_.load());
+        enqueue_pos_.value.store(other.enqueue_pos_.value.load());
+        dequeue_pos_.value.store(other.dequeue_pos_.value.load());
+        stopped_.store(other.stopped_.load());
+        dropped_count_.store(other.dropped_count_.load());
     }
 
     /// 向队列推入元素
     /// 如果队列已满，丢弃最旧的元素 (队首)
     /// @return true 如果成功推入, false 如果队列已停止
     bool push(T item) {
+        std::optional<T> evicted;
+        return push(std::move(item), evicted);
+    }
+
+    /// 推入元素, 满时把被丢弃的最旧元素移交给调用方 (用于按来源统计丢弃 / 在锁外释放)
+    /// @param evicted 被丢弃的元素 (未丢弃时保持为空)
+    /// @return true 如果成功推入, false 如果队列已停止
+    bool push(T item, std::optional<T>& evicted) {
+        if (mode_ == QueueMode::LOCK_FREE) {
+            return lf_push(std::move(item), evicted);
+        }
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            if (stopped_) {
+            if (stopped_.load(std::memory_order_relaxed)) {
                 return false;
             }
             if (queue_.size() >= capacity_) {
-                queue_.pop();
-                dropped_count_++;
+                evicted.emplace(std::move(queue_.front()));
+                queue_.pop_front();
+                dropped_count_.fetch_add(1, std::memory_order_relaxed);
             }
-            queue_.push(std::move(item));
+            queue_.push_back(std::move(item));
+            push_seq_++;
         }
         not_empty_cv_.notify_one();
         return true;
@@ -65,45 +118,94 @@ public:
     /// @param timeout 最大等待时间
     /// @return 弹出的元素, 如果超时或队列已停止则返回 nullopt
     std::optional<T> pop(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) {
+        if (mode_ == QueueMode::LOCK_FREE) {
+            return lf_pop(std::chrono::steady_clock::now() + timeout);
+        }
         std::unique_lock<std::mutex> lock(mutex_);
         if (!not_empty_cv_.wait_for(lock, timeout,
-                [this] { return !queue_.empty() || stopped_; })) {
+                [this] { return !queue_.empty() || stopped_.load(std::memory_order_relaxed); })) {
             return std::nullopt;  // 超时
         }
         if (queue_.empty()) {
             return std::nullopt;  // 被 stop() 唤醒但队列为空
         }
         T item = std::move(queue_.front());
-        queue_.pop();
+        queue_.pop_front();
         return item;
     }
 
     /// 非阻塞尝试弹出
     /// @return 弹出的元素, 如果队列为空则返回 nullopt
     std::optional<T> try_pop() {
+        if (mode_ == QueueMode::LOCK_FREE) {
+            return lf_try_pop();
+        }
         std::lock_guard<std::mutex> lock(mutex_);
         if (queue_.empty()) {
             return std::nullopt;
         }
         T item = std::move(queue_.front());
-        queue_.pop();
+        queue_.pop_front();
         return item;
     }
 
-    /// 当前队列大小
+    /// 按条件弹出: 取出队列中第一个满足 pred 的元素 (不要求在队首)
+    /// 没有匹配元素时阻塞等待, 直到 deadline
+    /// @return 弹出的元素, 超时或队列已停止则返回 nullopt
+    template<typename Pred>
+    std::optional<T> pop_if(Pred pred, std::chrono::steady_clock::time_point deadline) {
+        if (mode_ == QueueMode::LOCK_FREE) {
+            return lf_pop_if(pred, deadline);
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        uint64_t seen_seq = push_seq_;
+        while (true) {
+            auto it = std::find_if(queue_.begin(), queue_.end(), pred);
+            if (it != queue_.end()) {
+                T item = std::move(*it);
+                queue_.erase(it);
+                return item;
+            }
+            if (stopped_.load(std::memory_order_relaxed)) {
+                return std::nullopt;
+            }
+            // 上次扫描后有新元素但均不匹配: 唤醒信号可能是发给本等待者的, 转给其他等待者,
+            // 避免新元素无人消费; 已见过的元素不再转发, 否则多个批处理等待者会互相唤醒空转
+            if (push_seq_ != seen_seq && !queue_.empty()) {
+                not_empty_cv_.notify_one();
+            }
+            seen_seq = push_seq_;
+            if (not_empty_cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                it = std::find_if(queue_.begin(), queue_.end(), pred);
+                if (it == queue_.end()) {
+                    return std::nullopt;
+                }
+                T item = std::move(*it);
+                queue_.erase(it);
+                return item;
+            }
+        }
+    }
+
+    /// 当前队列大小 (无锁模式为近似值)
     size_t size() const {
+        if (mode_ == QueueMode::LOCK_FREE) {
+            return lf_size();
+        }
         std::lock_guard<std::mutex> lock(mutex_);
         return queue_.size();
     }
 
     /// 队列是否为空
     bool empty() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.empty();
+        return size() == 0;
     }
 
     /// 队列是否已满
     bool full() const {
+        if (mode_ == QueueMode::LOCK_FREE) {
+            return lf_size() >= capacity_;
+        }
         std::lock_guard<std::mutex> lock(mutex_);
         return queue_.size() >= capacity_;
     }
@@ -113,16 +215,19 @@ public:
         return capacity_;
     }
 
+    /// 实现方式
+    QueueMode mode() const {
+        return mode_;
+    }
+
     /// 累计丢弃的元素数量
     size_t dropped_count() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return dropped_count_;
+        return dropped_count_.load(std::memory_order_relaxed);
     }
 
     /// 队列是否已停止
     bool is_stopped() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return stopped_;
+        return stopped_.load();
     }
 
     /// 停止队列 (唤醒所有等待的 pop, 拒绝后续 push)
@@ -136,27 +241,273 @@ public:
 
     /// 清空队列内容 (不改变 stopped 状态)
     void clear() {
+        if (mode_ == QueueMode::LOCK_FREE) {
+            while (ring_try_pop()) {}
+            std::lock_guard<std::mutex> lock(mutex_);
+            stash_.clear();
+            stash_count_.store(0, std::memory_order_relaxed);
+            return;
+        }
         std::lock_guard<std::mutex> lock(mutex_);
-        std::queue<T> empty_queue;
+        std::deque<T> empty_queue;
         queue_.swap(empty_queue);
     }
 
     /// 重置队列 (清空内容 + 取消停止状态 + 清零统计)
     void reset() {
+        clear();
         std::lock_guard<std::mutex> lock(mutex_);
-        std::queue<T> empty_queue;
-        queue_.swap(empty_queue);
         stopped_ = false;
         dropped_count_ = 0;
     }
 
 private:
+    // ============================================================
+    // 无锁环形缓冲 (Dmitry Vyukov bounded MPMC queue)
+    //
+    // 每个槽位带序号 seq:
+    //   seq == pos       槽位空闲, 可由 enqueue_pos == pos 的生产者写入
+    //   seq == pos + 1   槽位已写入, 可由 dequeue_pos == pos 的消费者读取
+    // 读取后 seq = pos + capacity, 供下一圈写入。
+    // 使用取模而非掩码, 容量不必是 2 的幂 (保持与 MUTEX 模式相同的丢弃行为)。
+    // ============================================================
+
+    static constexpr size_t kCacheLine = 64;
+    static constexpr int kSpinCount = 64;
+
+    struct alignas(kCacheLine) Cell {
+        std::atomic<size_t> seq;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* ptr() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    /// 独占 cache line 的索引, 避免生产者/消费者伪共享
+    struct alignas(kCacheLine) PaddedIndex {
+        std::atomic<size_t> value{0};
+    };
+
+    void init_ring() {
+        cells_.reset(new Cell[capacity_]);
+        for (size_t i = 0; i < capacity_; i++) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// 写入环形缓冲, 满时返回 false (item 保持不变)
+    bool ring_try_push(T& item) {
+        size_t pos = enqueue_pos_.value.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos % capacity_];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.value.compare_exchange_weak(pos, pos + 1,
+                        std::memory_order_relaxed)) {
+                    new (cell.storage) T(std::move(item));
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // 满
+            } else {
+                pos = enqueue_pos_.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// 从环形缓冲读取, 空时返回 nullopt
+    std::optional<T> ring_try_pop() {
+        size_t pos = dequeue_pos_.value.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos % capacity_];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.value.compare_exchange_weak(pos, pos + 1,
+                        std::memory_order_relaxed)) {
+                    T* p = cell.ptr();
+                    std::optional<T> item(std::move(*p));
+                    p->~T();
+                    cell.seq.store(pos + capacity_, std::memory_order_release);
+                    return item;
+                }
+            } else if (diff < 0) {
+                return std::nullopt;  // 空 (或生产者尚未完成写入)
+            } else {
+                pos = dequeue_pos_.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t ring_size() const {
+        size_t tail = dequeue_pos_.value.load(std::memory_order_seq_cst);
+        size_t head = enqueue_pos_.value.load(std::memory_order_seq_cst);
+        return head > tail ? std::min(head - tail, capacity_) : 0;
+    }
+
+    /// 环形缓冲 + 暂存区的元素数 (近似值)
+    size_t lf_size() const {
+        return ring_size() + stash_count_.load(std::memory_order_relaxed);
+    }
+
+    bool lf_push(T item, std::optional<T>& evicted) {
+        if (stopped_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        // 容量包含暂存区: pop_if 跳过的元素仍在队列中, 否则环形缓冲可再写满, 总量达到 2 倍容量
+        while (lf_size() >= capacity_ || !ring_try_push(item)) {
+            // 满: 丢弃最旧元素后重试 (并发生产者可能各丢弃一个, 只交回最后一个)
+            // 暂存区的元素比环形缓冲中的更旧, 先丢弃暂存区队首
+            std::optional<T> old;
+            if (stash_count_.load(std::memory_order_relaxed) > 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                old = stash_pop_locked();
+            }
+            if (!old) old = ring_try_pop();
+            if (old) {
+                evicted = std::move(old);
+                dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        // 与 lf_wait 中 waiters_ 递增配对, 保证等待者不会错过本次写入
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) > 0) {
+            { std::lock_guard<std::mutex> lock(mutex_); }
+            not_empty_cv_.notify_one();
+        }
+        return true;
+    }
+
+    /// 从暂存区取出 (调用方持有 mutex_)
+    std::optional<T> stash_pop_locked() {
+        if (stash_.empty()) return std::nullopt;
+        T item = std::move(stash_.front());
+        stash_.pop_front();
+        stash_count_.fetch_sub(1, std::memory_order_relaxed);
+        return item;
+    }
+
+    std::optional<T> lf_try_pop() {
+        // pop_if 暂存的元素比环形缓冲中的更旧, 优先取出
+        if (stash_count_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (auto item = stash_pop_locked()) return item;
+        }
+        return ring_try_pop();
+    }
+
+    /**
+     * @brief 等待队列非空 (调用方持有 lock)
+     * @return false 超时
+     */
+    bool lf_wait(std::unique_lock<std::mutex>& lock,
+                 std::chrono::steady_clock::time_point deadline) {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool ready = not_empty_cv_.wait_until(lock, deadline, [this] {
+            return stopped_.load(std::memory_order_relaxed) ||
+                   ring_size() > 0 || !stash_.empty();
+        });
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return ready;
+    }
+
+    std::optional<T> lf_pop(std::chrono::steady_clock::time_point deadline) {
+        while (true) {
+            for (int i = 0; i < kSpinCount; i++) {
+                if (auto item = lf_try_pop()) return item;
+                if (ring_size() == 0) break;   // 真正为空, 不再自旋
+                std::this_thread::yield();     // 生产者写入中
+            }
+            if (stopped_.load(std::memory_order_acquire)) {
+                return std::nullopt;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (auto item = stash_pop_locked()) return item;
+            if (!lf_wait(lock, deadline)) {
+                lock.unlock();
+                return lf_try_pop();
+            }
+            if (auto item = stash_pop_locked()) return item;
+            if (stopped_.load(std::memory_order_relaxed) && ring_size() == 0) {
+                return std::nullopt;
+            }
+        }
+    }
+
+    template<typename Pred>
+    std::optional<T> lf_pop_if(Pred& pred, std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool timed_out = false;
+        while (true) {
+            uint64_t seen_seq = push_seq_;
+            auto it = std::find_if(stash_.begin(), stash_.end(), pred);
+            if (it != stash_.end()) {
+                T item = std::move(*it);
+                stash_.erase(it);
+                stash_count_.fetch_sub(1, std::memory_order_relaxed);
+                return item;
+            }
+
+            // 从环形缓冲依次取出, 不匹配的移入暂存区
+            bool stashed = false;
+            std::optional<T> found;
+            while (stash_.size() < capacity_) {
+                auto item = ring_try_pop();
+                if (!item) break;
+                if (pred(*item)) {
+                    found = std::move(item);
+                    break;
+                }
+                stash_.push_back(std::move(*item));
+                stash_count_.fetch_add(1, std::memory_order_relaxed);
+                stashed = true;
+            }
+            // 暂存区有新元素: 唤醒其他等待者消费 (仅在有新暂存时, 避免等待者互相唤醒空转)
+            if (stashed) {
+                push_seq_++;
+                seen_seq = push_seq_;
+                if (waiters_.load(std::memory_order_relaxed) > 0) {
+                    not_empty_cv_.notify_one();
+                }
+            }
+            if (found) return found;
+
+            if (timed_out || stopped_.load(std::memory_order_relaxed)) {
+                return std::nullopt;
+            }
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            timed_out = !not_empty_cv_.wait_until(lock, deadline, [this, seen_seq] {
+                return stopped_.load(std::memory_order_relaxed) || push_seq_ != seen_seq ||
+                       (ring_size() > 0 && stash_.size() < capacity_);
+            });
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
     size_t capacity_;
-    std::queue<T> queue_;
+    QueueMode mode_ = QueueMode::MUTEX;
+
+    // MUTEX 模式
+    std::deque<T> queue_;
+
+    // LOCK_FREE 模式
+    std::unique_ptr<Cell[]> cells_;
+    PaddedIndex enqueue_pos_;
+    PaddedIndex dequeue_pos_;
+    std::deque<T> stash_;                       ///< pop_if 跳过的元素 (受 mutex_ 保护)
+    std::atomic<size_t> stash_count_{0};
+    std::atomic<int> waiters_{0};
+
+    // 共用: MUTEX 模式的全部状态 / LOCK_FREE 模式的阻塞等待
     mutable std::mutex mutex_;
+    uint64_t push_seq_ = 0;                     ///< MUTEX: 入队计数 / LOCK_FREE: 暂存计数 (受 mutex_ 保护)
     std::condition_variable not_empty_cv_;
-    bool stopped_ = false;
-    size_t dropped_count_ = 0;
+    std::atomic<bool> stopped_{false};
+    std::atomic<size_t> dropped_count_{0};
 };
 
 } // namespace infer_server
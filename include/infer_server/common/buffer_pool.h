@@ -0,0 +1,87 @@
+#pragma once
+
+/**
+ * @file buffer_pool.h
+ * @brief 按尺寸分级的可回收字节缓冲池
+ *
+ * 每帧的 NV12 拷贝、模型 RGB 输入、缓存缩略图都是 1~6MB 的大块内存,
+ * 直接 make_shared<vector> 会走 glibc mmap/munmap, 每帧都有缺页和清零开销。
+ *
+ * BufferPool 返回带自定义 deleter 的 shared_ptr<vector<uint8_t>>:
+ * - 与现有 InferTask::input_data / DecodedFrame::nv12_data 类型完全兼容
+ * - 最后一个持有者 (InferTask / CachedFrame 等) 释放时, 缓冲区回到池中
+ * - 按 64KB 粒度分级, 同一路流分辨率固定, 复用时 resize 不触发重新分配
+ * - 空闲内存超过上限时直接释放, 不再回池
+ *
+ * 线程安全: 内部使用 mutex 保护, 可从任意线程 acquire / 释放。
+ */
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+namespace infer_server {
+
+class BufferPool {
+public:
+    using Buffer = std::shared_ptr<std::vector<uint8_t>>;
+
+    /// 池统计信息
+    struct Stats {
+        uint64_t hits = 0;            ///< 从空闲链表复用的次数
+        uint64_t misses = 0;          ///< 新分配的次数
+        size_t bytes_in_use = 0;      ///< 正在被使用的字节数 (按分级容量计)
+        size_t bytes_idle = 0;        ///< 空闲链表中的字节数
+        size_t idle_buffers = 0;      ///< 空闲缓冲区个数
+
+        /// 池持有的总字节数 (使用中 + 空闲)
+        size_t bytes_resident() const { return bytes_in_use + bytes_idle; }
+    };
+
+    /// 进程级全局缓冲池 (不析构, 避免退出时仍有缓冲区未归还)
+    static BufferPool& global();
+
+    /// @param max_idle_bytes 空闲内存上限, 超出后归还的缓冲区直接释放
+    explicit BufferPool(size_t max_idle_bytes = 64 * 1024 * 1024);
+
+    // 禁止拷贝
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief 获取一个大小为 size 的缓冲区
+     *
+     * 内容未定义 (复用时保留上一次的数据)。
+     * 返回的 Buffer 析构时自动归还, 调用方需保证池的生命周期更长。
+     */
+    Buffer acquire(size_t size);
+
+    /// 设置空闲内存上限 (超出部分立即释放)
+    void set_max_idle_bytes(size_t max_idle_bytes);
+
+    /// 释放所有空闲缓冲区
+    void trim();
+
+    /// 获取统计信息
+    Stats get_stats() const;
+
+    /// 分级容量: 向上取整到 64KB
+    static size_t size_class(size_t size);
+
+private:
+    void release(std::vector<uint8_t>* buf, size_t cls);
+    void trim_locked(size_t target_idle_bytes);
+
+    mutable std::mutex mutex_;
+    size_t max_idle_bytes_;
+
+    /// 分级容量 -> 空闲缓冲区
+    std::unordered_map<size_t, std::vector<std::unique_ptr<std::vector<uint8_t>>>> free_lists_;
+
+    Stats stats_;
+};
+
+} // namespace infer_server
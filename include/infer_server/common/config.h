@@ -17,30 +17,140 @@ namespace infer_server {
 /// 服务器全局配置
 struct ServerConfig {
     int http_port = 8080;                                       ///< REST API 端口
+    int http_threads = 4;                                       ///< REST API 请求处理线程数 (0 = cpp-httplib 默认)
+    int status_refresh_ms = 1000;                               ///< 流状态快照的最长复用时间 (ms, 0 = 每次查询重建)
+    int http_push_clients = 4;                                  ///< MJPEG / SSE 推送连接上限 (各占一个独立线程, 0 = 禁用推送)
     std::string zmq_endpoint = "tcp://0.0.0.0:5555";   ///< ZeroMQ 发布地址 (TCP)
+    std::string zmq_format = "json";                            ///< ZeroMQ 消息格式: "json" / "msgpack"
+    /// ZeroMQ 主题: "none" = 单帧消息; "camera" = [cam_id/][帧]; "task" = [cam_id/task_name][单模型结果]
+    std::string zmq_topic_mode = "none";
+    bool zmq_skip_empty = false;                                ///< 不发布没有检测结果的帧
     int num_infer_workers = 3;                                  ///< 推理线程数 (建议等于 NPU 核心数)
     int num_npu_cores = 2;                                      ///< NPU 核心数 (RK3576=2, RK3588=3)
-    int decode_queue_size = 2;                                  ///< 每路解码输出队列大小
+    int decode_queue_size = 2;                                  ///< 每路解码 -> 预处理 / 预处理 -> 编码队列大小
+    int decode_threads = 0;                                     ///< 共享解码线程池大小 (0 = 每路流一个解码线程)
     int infer_queue_size = 18;                                  ///< 全局推理任务队列大小
+    bool infer_queue_lockfree = false;                          ///< 推理任务队列使用无锁 MPMC 环形缓冲 (仅 fifo 策略)
+    /// 推理任务队列策略: "fifo" = 全局先进先出; "fair" = 按 cam_id 加权公平 (DRR), 满时按优先级挤出
+    std::string infer_queue_policy = "fair";
+    int infer_task_deadline_ms = 1000;                          ///< 任务排队超过该时长即丢弃 (0=不限, 流可单独设置)
     std::string streams_save_path = "/etc/infer-server/streams.json";  ///< 流配置持久化路径
     std::string log_level = "info";                             ///< 日志级别
 
     // === 图片缓存配置 (Phase 2) ===
     int cache_duration_sec = 5;         ///< Ring Buffer 保留时长 (秒)
     int cache_jpeg_quality = 75;        ///< JPEG 压缩质量 (1-100)
+    /// 缓存模式: "jpeg" = 每帧立即编码; "raw" = 保存缩放后的 NV12, 首次读取时编码并缓存结果
+    std::string cache_mode = "jpeg";
+    /// 报警图片画检测框: 推理结果回填到缓存帧, 编码时画入 JPEG (隐含按 "raw" 模式缓存, 编码推迟到首次读取)
+    bool cache_overlay = false;
+    /// JPEG 编码后端: "turbojpeg" = 只用软件编码 (默认); "auto" = MPP 硬件编码可用时使用, 否则 TurboJPEG; "mpp"
+    /// (MPP 编码路径尚未在硬件上验证, 需显式开启)
+    std::string cache_jpeg_backend = "turbojpeg";
     int cache_resize_width = 640;       ///< 缓存图片宽度 (0=保持原始宽度)
     int cache_resize_height = 0;        ///< 缓存图片高度 (0=按宽度等比例计算)
     int cache_max_memory_mb = 64;       ///< 缓存最大总内存 (MB)
 
+    // === 报警片段 (压缩码流缓存) ===
+    int clip_duration_sec = 0;          ///< 每流保留的码流时长 (秒, 0=禁用)
+    int clip_max_memory_mb = 16;        ///< 每流码流缓存内存上限 (MB, 0=不限制)
+
+    // === RGA 调度 ===
+    /// 参与调度的 RGA 核心掩码 (IM_SCHEDULER_CORE 位组合)
+    /// 0 = 单槽位由驱动选核 (所有 RGA 操作串行); RK3588 推荐 7, RK3576 推荐 12
+    int rga_core_mask = 0;
+
+    // === 缓冲池 ===
+    int buffer_pool_max_mb = 64;        ///< 帧/RGB 缓冲池空闲内存上限 (MB, 0=不复用)
+
+    // === 零拷贝 (DMA-BUF) ===
+    /// 解码 -> RGA -> NPU 全程使用 DMA-BUF, 不经过 CPU 拷贝
+    /// 需要 MPP 输出 DRM-PRIME 帧; 不满足条件时自动回退到虚拟地址路径
+    bool zero_copy = false;
+    /// 非零拷贝路径: RGA 直接从 DRM-PRIME 帧等比缩小到最大消费者 (模型输入 / 缓存缩略图) 所需尺寸,
+    /// 只把缩小后的 NV12 传到 CPU 内存 (替代全分辨率 av_hwframe_transfer_data + 拷贝)
+    bool decode_downscale = true;
+
+    // === 推理调度 ===
+    /// "shared"  : 所有 worker 竞争同一个全局队列 (每个 worker 为每个模型创建 context)
+    /// "affinity": 每个模型固定到主 worker, 空闲 worker 窃取已有 context 的模型任务
+    std::string infer_scheduler = "shared";
+    int affinity_replicas = 1;          ///< affinity 模式下每个模型预创建 context 的 worker 数
+    int steal_backlog = 0;              ///< 队列积压达到该值时允许无 context 的 worker 窃取 (0=禁用)
+    /// 每个 worker 的在途任务数: 后处理在独立线程执行, NPU 同时推理下一个任务 (1 = 串行)
+    int infer_pipeline_depth = 2;
+    /// 每个 worker context 预分配并绑定持久输入 / 输出 tensor (rknn_set_io_mem),
+    /// 稳态推理不再调用 rknn_inputs_set / rknn_outputs_get; 创建失败时自动回退
+    bool infer_io_binding = true;
+    /// worker context 共享主 context 的权重内存 (RKNN_FLAG_SHARE_WEIGHT_MEM), 每个模型只驻留一份权重;
+    /// 各 context 的中间 tensor 与输入 / 输出仍独立. 运行时不支持时自动回退
+    bool model_share_weights = false;
+
+    // === 自适应跳帧 (准入控制) ===
+    /// 根据推理队列占用率与各流单帧推理开销动态调整每路流的准入帧率, 在解码前丢帧;
+    /// 各流按 NPU 时间公平分配. false = 仅按 frame_skip 固定跳帧
+    bool adaptive_skip = true;
+    int adaptive_interval_ms = 500;     ///< 重新分配准入帧率的周期 (ms)
+    double adaptive_min_fps = 1.0;      ///< 过载时每路流保底的准入帧率
+
+    // === 结果输出 ===
+    /// 输出线程数: 序列化 / ZMQ 发送 / 统计回调在输出线程执行, 不占用 NPU 线程
+    /// 0 = 在推理线程同步输出; 多线程时按 cam_id 分片, 同一路流的结果保持顺序
+    int output_threads = 1;
+    int output_queue_size = 64;         ///< 每个输出线程的结果队列容量 (满时丢弃最旧)
+
+    // === 后处理 ===
+    /// INT8 输出模型直接在量化域后处理 (want_float=0, 只反量化通过阈值的 anchor)
+    bool int8_postprocess = true;
+    /// 后处理内核: "portable" (默认) / "neon" (AArch64, 不支持时回退) / "reference" (原始标量实现)
+    std::string post_kernel = "portable";
+
+    // === 线程策略 (大小核绑定 / 优先级) ===
+    /// 推理线程绑大核 (按 worker_id 轮转), 后处理线程绑全部大核, 每路流解码/预处理/编码线程与 HTTP 线程绑小核
+    bool thread_affinity = false;
+    std::string cpu_big_cores;          ///< 大核 CPU 列表 (如 "4-7", 空 = 从 sysfs 自动识别)
+    std::string cpu_little_cores;       ///< 小核 CPU 列表 (如 "0-3", 空 = 从 sysfs 自动识别)
+    int infer_rt_priority = 0;          ///< 推理线程 SCHED_FIFO 优先级 (1-99, 0=普通调度; 需要 CAP_SYS_NICE)
+    int infer_nice = 0;                 ///< 推理 / 后处理线程 nice 值 (-20~19, 负值需要 CAP_SYS_NICE)
+    int decode_nice = 0;                ///< 每路流解码 / 预处理 / 编码线程 nice 值
+
+    // 多节点集群 (见 cluster/shard_planner.h)
+    std::string node_id;                ///< 本节点在集群中的名称 (空 = 主机名:http_port)
+    int node_max_streams = 0;           ///< 本节点可承载的流数, 协调器按此分配与加权 (0 = 不限)
+    /// 协调器模式: 各节点 REST 地址 (如 "http://10.0.0.11:8080"), 为空 = 不启用协调器
+    std::vector<std::string> cluster_nodes;
+    std::string cluster_streams_path = "/etc/infer-server/cluster_streams.json";  ///< 协调器管理的全部流配置
+    int cluster_poll_ms = 5000;         ///< 协调器轮询节点 / 再平衡周期
+    int cluster_max_moves = 4;          ///< 每轮最多迁移的流数 (未运行的流不受限)
+    double cluster_drop_rate = 1.0;     ///< 节点推理丢帧率 (帧/秒, 10s 窗口) 超过该值视为过载, 每轮迁出一路
+    std::string cluster_zmq_endpoint;   ///< 协调器汇聚各节点结果的 XPUB 地址 (如 "tcp://0.0.0.0:5556", 空 = 不转发)
+
     NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(
         ServerConfig,
-        http_port, zmq_endpoint, num_infer_workers,
+        http_port, http_threads, status_refresh_ms, http_push_clients, zmq_endpoint, zmq_format, zmq_topic_mode, zmq_skip_empty,
+        num_infer_workers,
         num_npu_cores,
-        decode_queue_size, infer_queue_size,
+        decode_queue_size, decode_threads, infer_queue_size, infer_queue_lockfree,
+        infer_queue_policy, infer_task_deadline_ms,
         streams_save_path, log_level,
-        cache_duration_sec, cache_jpeg_quality,
+        cache_duration_sec, cache_jpeg_quality, cache_mode, cache_overlay, cache_jpeg_backend,
         cache_resize_width, cache_resize_height,
-        cache_max_memory_mb
+        cache_max_memory_mb,
+        clip_duration_sec, clip_max_memory_mb,
+        rga_core_mask,
+        buffer_pool_max_mb,
+        zero_copy,
+        decode_downscale,
+        infer_scheduler, affinity_replicas, steal_backlog, infer_pipeline_depth, infer_io_binding,
+        model_share_weights,
+        adaptive_skip, adaptive_interval_ms, adaptive_min_fps,
+        output_threads, output_queue_size,
+        int8_postprocess, post_kernel,
+        thread_affinity, cpu_big_cores, cpu_little_cores,
+        infer_rt_priority, infer_nice, decode_nice,
+        node_id, node_max_streams,
+        cluster_nodes, cluster_streams_path, cluster_poll_ms, cluster_max_moves,
+        cluster_drop_rate, cluster_zmq_endpoint
     )
 };
 
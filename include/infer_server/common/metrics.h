@@ -0,0 +1,203 @@
+#pragma once
+
+/**
+ * @file metrics.h
+ * @brief 延迟直方图与 Prometheus 文本格式输出
+ *
+ * LatencyHistogram 是 HDR 风格的对数-线性直方图 (单位微秒):
+ * - 每个 2 的幂区间再均分为 8 个子桶, 相对误差 <= 12.5%, 覆盖 1us ~ 12 天
+ * - record() 只做几次 relaxed 原子加法, 不加锁, 可在解码 / 预处理 / NPU / 输出线程直接调用
+ * - snapshot() 拷贝桶计数后计算分位数 (p50 / p99 / p999), 与记录并发时结果为近似快照
+ *
+ * 每路流的 StreamCounters 持有一组分阶段直方图 (StageLatency), 时间戳取 steady_clock
+ * 随 DecodedFrame -> InferTask -> FrameResult 传递; 每个 ModelBinding 另有一组
+ * 只记录排队 / NPU / 后处理的直方图 (按流 x 模型)。
+ *
+ * RateMeter 按秒分桶统计事件数, 给出最近 1 / 10 / 60 秒的指数加权速率, 取代
+ * "总数 / 运行时长" 的全程平均, 重连或长时间运行后仍能反映当前负载。
+ *
+ * PrometheusWriter 生成 /metrics 的文本格式 (text/plain; version=0.0.4)。
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace infer_server {
+
+/// 单调时钟 (steady_clock) 当前时间, 纳秒
+inline int64_t mono_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 3;                      ///< 每个 2 的幂区间 2^kSubBits 个子桶
+    static constexpr int kSubBuckets = 1 << kSubBits;
+    static constexpr int kMaxBits = 40;                     ///< 记录值上限 2^40 us, 超出按上限计
+    static constexpr size_t kBuckets = static_cast<size_t>((kMaxBits - kSubBits + 1) * kSubBuckets);
+
+    /// 直方图快照
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t sum_us = 0;
+        uint64_t max_us = 0;
+        std::vector<uint64_t> buckets;
+
+        /// 分位数 (q = 0~1), 返回所在桶的上界 (不超过最大值), 单位微秒; 空直方图返回 0
+        uint64_t percentile_us(double q) const;
+
+        double mean_us() const { return count ? static_cast<double>(sum_us) / static_cast<double>(count) : 0.0; }
+
+        /// 累加另一份快照 (如多路流汇总)
+        void merge(const Snapshot& other);
+
+        /// 减去同一直方图较早的快照, 得到两次快照之间的分布 (max_us 无法还原, 保留当前值)
+        void subtract(const Snapshot& earlier);
+    };
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /// 记录一次耗时 (微秒)
+    void record_us(uint64_t us);
+
+    /// 记录一次耗时 (纳秒, 负值按 0 计)
+    void record_ns(int64_t ns) { record_us(ns > 0 ? static_cast<uint64_t>(ns) / 1000 : 0); }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    Snapshot snapshot() const;
+
+    /// 值所在的桶下标
+    static size_t bucket_index(uint64_t us);
+
+    /// 桶内的最大值 (微秒)
+    static uint64_t bucket_upper(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_us_{0};
+    std::atomic<uint64_t> max_us_{0};
+};
+
+/// 流水线阶段
+enum class LatencyStage {
+    Decode,         ///< 解复用 + 解码 (含网络等待)
+    Nv12Copy,       ///< 硬件帧拷贝到 CPU 内存 (零拷贝 / 解码器缩放时不记录)
+    Rga,            ///< RGA job 提交到完成 (含等待 RGA 核心)
+    QueueWait,      ///< 推理队列排队
+    Npu,            ///< 输入设置 + rknn_run + 取输出
+    PostProcess,    ///< 后处理 (解码 + NMS)
+    Aggregate,      ///< 多模型 / 分块帧: 第一个模型结果到达到整帧完成
+    Publish,        ///< 整帧完成到输出阶段处理完毕 (输出队列 + 序列化 / ZMQ / 回调)
+    EndToEnd,       ///< 解码完成到输出完毕
+};
+
+constexpr size_t kNumLatencyStages = static_cast<size_t>(LatencyStage::EndToEnd) + 1;
+
+/// 阶段名 (Prometheus 标签值)
+const char* latency_stage_name(LatencyStage stage);
+
+/// 一组分阶段延迟直方图
+class StageLatency {
+public:
+    void record(LatencyStage stage, int64_t ns) { at(stage).record_ns(ns); }
+
+    LatencyHistogram& at(LatencyStage stage) { return stages_[static_cast<size_t>(stage)]; }
+    const LatencyHistogram& at(LatencyStage stage) const { return stages_[static_cast<size_t>(stage)]; }
+
+private:
+    std::array<LatencyHistogram, kNumLatencyStages> stages_;
+};
+
+/**
+ * @brief 滑动窗口速率计 (无锁)
+ *
+ * 最近 64 秒每秒一个槽位, 槽位高 24 位为秒号、低 40 位为计数: mark() 对当前秒的槽位做一次
+ * relaxed 原子加法 (秒号过期时 CAS 换新), 不需要后台线程定时 tick。
+ * rates() 按最近 60 个完整秒的计数做指数加权平均 (时间常数 1 / 10 / 60 秒, 按权重归一化),
+ * 只统计 reset() 之后的完整秒, 刚启动时不会被未覆盖的时段拉低。
+ */
+class RateMeter {
+public:
+    static constexpr int kWindowSec = 60;                   ///< 参与计算的历史秒数
+    static constexpr size_t kSlots = 64;
+
+    /// 事件速率 (次/秒)
+    struct Rates {
+        double last_1s = 0.0;
+        double last_10s = 0.0;
+        double last_60s = 0.0;
+
+        Rates& operator+=(const Rates& o) {
+            last_1s += o.last_1s;
+            last_10s += o.last_10s;
+            last_60s += o.last_60s;
+            return *this;
+        }
+    };
+
+    explicit RateMeter(int64_t now_ns = mono_now_ns()) : start_ns_(now_ns) {}
+    RateMeter(const RateMeter&) = delete;
+    RateMeter& operator=(const RateMeter&) = delete;
+
+    /// 记录 n 次事件
+    void mark(uint64_t n = 1, int64_t now_ns = mono_now_ns());
+
+    /// 最近 1 / 10 / 60 秒的速率
+    Rates rates(int64_t now_ns = mono_now_ns()) const;
+
+    /// 从 now_ns 起重新统计 (之前的计数不再参与计算)
+    void reset(int64_t now_ns = mono_now_ns()) { start_ns_.store(now_ns, std::memory_order_relaxed); }
+
+private:
+    static constexpr int kCountBits = 40;
+    static constexpr uint64_t kCountMask = (uint64_t{1} << kCountBits) - 1;
+    static constexpr uint64_t kEpochMask = (uint64_t{1} << (64 - kCountBits)) - 1;
+
+    std::array<std::atomic<uint64_t>, kSlots> slots_{};
+    std::atomic<int64_t> start_ns_;
+};
+
+/**
+ * @brief Prometheus 文本格式生成器
+ *
+ * 同名指标的样本须连续写入 (每个指标的 # HELP / # TYPE 只在首次写入时输出)。
+ */
+class PrometheusWriter {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    /// 写入 gauge / counter 样本 (type = "gauge" / "counter")
+    void sample(const std::string& name, const char* type, const char* help,
+                const Labels& labels, double value);
+
+    /**
+     * @brief 写入 summary: p50 / p99 / p999 (秒) 以及 _sum (秒) / _count
+     */
+    void summary(const std::string& name, const char* help, const Labels& labels,
+                 const LatencyHistogram::Snapshot& snap);
+
+    const std::string& str() const { return out_; }
+
+    /// 标签值转义 (反斜杠, 双引号, 换行)
+    static std::string escape(const std::string& value);
+
+private:
+    void declare(const std::string& name, const char* type, const char* help);
+    void line(const std::string& name, const Labels& labels, double value,
+              const char* extra_key = nullptr, const char* extra_value = nullptr);
+
+    std::string out_;
+    std::string last_declared_;
+};
+
+} // namespace infer_server
@@ -0,0 +1,108 @@
+#pragma once
+
+/**
+ * @file thread_policy.h
+ * @brief 流水线线程的命名、CPU 亲和性与调度优先级策略
+ *
+ * RK3588 (4xA76 + 4xA55) / RK3576 (4xA72 + 4xA53) 为大小核结构。线程不绑核时,
+ * 调度器会把后处理迁到小核、把解码线程放到大核, 推理延迟抖动明显。
+ *
+ * ThreadPolicy 由各线程在入口处调用 apply() 对自身生效:
+ * - 线程名: 始终设置 (pthread_setname_np, 最长 15 字符), 便于 perf / htop 区分
+ * - 亲和性 (thread_affinity = true):
+ *     Infer       -> 单个大核, 按 worker_id 轮转 (与 NpuCoreMask::from_worker_id 的 NPU 核心分配同序)
+ *     PostProcess -> 全部大核
+ *     Decode / Preprocess / Encode / Http -> 全部小核
+ *     Output      -> 不绑定
+ * - 优先级: Infer 可选 SCHED_FIFO (infer_rt_priority, 需要 CAP_SYS_NICE);
+ *   其余按 nice 值 (infer_nice 作用于推理与后处理线程, decode_nice 作用于每路流的三级线程)
+ *
+ * 大小核列表可在配置中显式给出 ("4-7"), 为空时从 sysfs 的 cpu_capacity
+ * (回退 cpufreq/cpuinfo_max_freq) 自动识别; 单一簇 (没有大小核之分) 时不绑核。
+ *
+ * 所有设置失败都只告警, 不影响线程运行。
+ */
+
+#include "infer_server/common/config.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace infer_server {
+
+/// 线程角色
+enum class ThreadRole {
+    Decode = 0,     ///< 每路流解码线程
+    Preprocess,     ///< 每路流预处理 (RGA) 线程
+    Encode,         ///< 每路流缓存 JPEG 编码线程
+    Infer,          ///< InferWorker NPU 提交线程
+    PostProcess,    ///< InferWorker 后处理线程
+    Output,         ///< ResultDispatcher 输出线程
+    Http,           ///< REST API 线程 (及其请求处理线程池)
+};
+
+/// 角色名称 ("decode" / "infer" / ...)
+const char* thread_role_name(ThreadRole role);
+
+class ThreadPolicy {
+public:
+    struct Options {
+        bool affinity = false;          ///< 是否绑核
+        std::vector<int> big_cores;     ///< 大核 CPU 编号 (升序)
+        std::vector<int> little_cores;  ///< 小核 CPU 编号 (升序)
+        int infer_rt_priority = 0;      ///< Infer 线程 SCHED_FIFO 优先级 (1-99, 0 = 不使用实时调度)
+        int infer_nice = 0;             ///< Infer / PostProcess 线程 nice 值
+        int decode_nice = 0;            ///< Decode / Preprocess / Encode 线程 nice 值
+    };
+
+    /// 大小核划分
+    struct Topology {
+        std::vector<int> big;
+        std::vector<int> little;    ///< 单一簇时为空
+    };
+
+    /// 进程级全局策略 (不析构)
+    static ThreadPolicy& instance();
+
+    /// 由 ServerConfig 生成策略 (解析 / 自动识别大小核, 无法区分时关闭绑核并告警)
+    static Options from_config(const ServerConfig& config);
+
+    /// 设置策略 (应在启动流水线线程之前调用; 已运行的线程不受影响)
+    void configure(const Options& options);
+
+    Options options() const;
+
+    /// 该角色线程应绑定的 CPU (空 = 不绑定)
+    /// @param index 同角色线程的序号 (Infer 为 worker_id)
+    std::vector<int> cpus_for(ThreadRole role, int index = 0) const;
+
+    /**
+     * @brief 对当前线程生效: 线程名 + 亲和性 + 调度优先级
+     * @param role  线程角色
+     * @param name  线程名 (超过 15 字符时截断)
+     * @param index 同角色线程的序号 (Infer 为 worker_id)
+     */
+    void apply(ThreadRole role, const std::string& name, int index = 0) const;
+
+    /// 设置当前线程名 (截断到 15 字符)
+    static bool set_current_name(const std::string& name);
+
+    /// 解析 CPU 列表 ("0-3,6"), 格式错误返回空
+    static std::vector<int> parse_cpu_list(const std::string& list);
+
+    /// 格式化 CPU 列表 ({0,1,2,3,6} -> "0-3,6")
+    static std::string format_cpu_list(const std::vector<int>& cpus);
+
+    /// 从 sysfs 识别大小核 (按 cpu_capacity, 回退 cpuinfo_max_freq; 最大值为大核)
+    static Topology detect_topology(const std::string& sysfs_root = "/sys/devices/system/cpu");
+
+    /// 策略摘要 (用于启动日志)
+    std::string describe() const;
+
+private:
+    mutable std::mutex mutex_;
+    Options options_;
+};
+
+} // namespace infer_server
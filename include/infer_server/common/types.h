@@ -10,17 +10,107 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <atomic>
+#include <mutex>
 #include <cstdint>
 #include <chrono>
 #include <nlohmann/json.hpp>
 
+#include "infer_server/common/metrics.h"
+
 namespace infer_server {
 
+class StreamTrackers;   // 跟踪阶段 (inference/object_tracker.h)
+class FrameResultCollector;   // 多模型结果聚合 (inference/frame_result_collector.h)
+
 // ============================================================
 // 配置类型 (来自用户请求, JSON 可序列化)
 // ============================================================
 
+/// 像素矩形 (RGA 源裁剪区域等, 宽或高为 0 表示整幅图像)
+struct CropRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool empty() const { return width <= 0 || height <= 0; }
+};
+
+/**
+ * @brief 感兴趣区域 (ROI)
+ *
+ * 归一化坐标, 相对于原始帧宽高 (0~1), 与码流分辨率无关。
+ * 预处理时由 RGA 从源帧裁剪该区域再缩放到模型输入。
+ */
+struct RoiConfig {
+    float x = 0.0f;         ///< 左上角 x (0~1)
+    float y = 0.0f;         ///< 左上角 y (0~1)
+    float width = 1.0f;     ///< 宽度 (0~1)
+    float height = 1.0f;    ///< 高度 (0~1)
+
+    /// 是否为合法区域 (宽高 > 0 且不超出画面)
+    bool valid() const {
+        return width > 0.0f && height > 0.0f && x >= 0.0f && y >= 0.0f &&
+               x + width <= 1.0f + 1e-4f && y + height <= 1.0f + 1e-4f;
+    }
+
+    /// 换算到 frame_w x frame_h 的像素矩形 (RGA 要求起点和宽高均为偶数, 至少 2x2)
+    CropRect to_pixels(int frame_w, int frame_h) const {
+        CropRect r;
+        if (frame_w < 2 || frame_h < 2) return r;
+        int x1 = std::clamp(static_cast<int>(x * frame_w), 0, frame_w - 2) & ~1;
+        int y1 = std::clamp(static_cast<int>(y * frame_h), 0, frame_h - 2) & ~1;
+        int x2 = std::clamp(static_cast<int>(std::lround((x + width) * frame_w)), x1 + 2, frame_w);
+        int y2 = std::clamp(static_cast<int>(std::lround((y + height) * frame_h)), y1 + 2, frame_h);
+        r.x = x1;
+        r.y = y1;
+        r.width = (x2 - x1) & ~1;
+        r.height = (y2 - y1) & ~1;
+        return r;
+    }
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(RoiConfig, x, y, width, height)
+};
+
+/**
+ * @brief 将 ROI 列表按网格切块
+ *
+ * 每个 ROI 切成 cols x rows 块, 相邻块重叠 overlap (相对于块尺寸),
+ * 保证跨块边界的目标至少在一个块中完整可见。rois 为空时对整帧切块。
+ * 返回顺序: ROI 顺序, 块内按行优先。
+ */
+inline std::vector<RoiConfig> tile_regions(const std::vector<RoiConfig>& rois,
+                                           int cols, int rows, float overlap) {
+    cols = std::max(cols, 1);
+    rows = std::max(rows, 1);
+    overlap = std::clamp(overlap, 0.0f, 0.5f);
+
+    std::vector<RoiConfig> regions;
+    const std::vector<RoiConfig> full_frame(1);
+    const auto& sources = rois.empty() ? full_frame : rois;
+    regions.reserve(sources.size() * static_cast<size_t>(cols * rows));
+    for (const auto& roi : sources) {
+        // 块尺寸满足: cols 块扣除 cols-1 段重叠后恰好覆盖 ROI
+        float tile_w = roi.width / (static_cast<float>(cols) - static_cast<float>(cols - 1) * overlap);
+        float tile_h = roi.height / (static_cast<float>(rows) - static_cast<float>(rows - 1) * overlap);
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                RoiConfig tile;
+                tile.x = roi.x + static_cast<float>(c) * tile_w * (1.0f - overlap);
+                tile.y = roi.y + static_cast<float>(r) * tile_h * (1.0f - overlap);
+                tile.width = tile_w;
+                tile.height = tile_h;
+                regions.push_back(tile);
+            }
+        }
+    }
+    return regions;
+}
+
 /// 单个模型的配置
 struct ModelConfig {
     std::string model_path;             ///< RKNN 模型文件路径
@@ -31,26 +121,93 @@ struct ModelConfig {
     float conf_threshold = 0.25f;       ///< 置信度阈值
     float nms_threshold  = 0.45f;       ///< NMS 阈值
     std::string labels_file;            ///< 类别标签文件路径 (可选, 每行一个类别名)
+    std::string resize_mode = "letterbox";  ///< 预处理缩放: "letterbox" (等比+填充) / "stretch" (拉伸)
+
+    // ROI 裁剪与分块推理: 每个 ROI 按 tile_cols x tile_rows 切块, 每块一次推理, 跨块 NMS 合并
+    std::vector<RoiConfig> rois;        ///< 模型的 ROI (为空时使用 StreamConfig::rois, 仍为空则为整帧)
+    int tile_cols = 1;                  ///< 每个 ROI 的水平分块数
+    int tile_rows = 1;                  ///< 每个 ROI 的垂直分块数
+    float tile_overlap = 0.2f;          ///< 相邻分块的重叠比例 (相对于分块尺寸, 0~0.5)
+
+    // 级联: 第二级模型只在第一级模型选定类别的检测框裁剪上推理, 不跑整帧
+    std::string cascade_from;           ///< 第一级模型的 task_name (为空 = 整帧推理)
+    std::vector<std::string> cascade_classes;  ///< 触发第二级推理的类别名或类别 ID (为空 = 所有类别)
+    float cascade_expand = 0.1f;        ///< 裁剪框向四周扩展的比例 (相对于检测框宽高)
+    int cascade_max_crops = 8;          ///< 单帧最多裁剪数 (按第一级置信度取前 N 个)
+
+    // 目标跟踪: 检测框带稳定的 track_id; infer_interval > 1 时中间帧由跟踪器外推
+    bool track = false;                 ///< 是否开启跟踪
+    int infer_interval = 1;             ///< 每 N 个处理帧推理一次 (需要 track = true; 级联第二级模型忽略)
+    float track_high_threshold = 0.5f;  ///< 高分检测阈值: 第一轮关联并可新建轨迹
+    float track_iou_threshold = 0.3f;   ///< 关联所需的最小 IoU
+    int track_max_age_ms = 1000;        ///< 轨迹未匹配超过该时长即删除 (也是外推的最长时长)
+
+    // 动态批处理 (需要 batch 维度 > 1 编译的 RKNN 模型)
+    int max_batch = 1;                  ///< 单次 rknn_run 最多合并的任务数 (1=不批处理)
+    int batch_wait_ms = 2;              ///< 凑批等待窗口 (毫秒)
 
     NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(
         ModelConfig,
         model_path, task_name, model_type,
         input_width, input_height,
         conf_threshold, nms_threshold,
-        labels_file
+        labels_file, resize_mode,
+        rois, tile_cols, tile_rows, tile_overlap,
+        cascade_from, cascade_classes, cascade_expand, cascade_max_crops,
+        track, infer_interval, track_high_threshold, track_iou_threshold, track_max_age_ms,
+        max_batch, batch_wait_ms
     )
 };
 
+/// 解码模式: 解复用之后哪些包送入解码器
+enum class DecodeMode {
+    All = 0,        ///< 全部解码 (跳帧只省去 NV12 拷贝)
+    NonRef,         ///< 丢弃非参考帧 (H.264 nal_ref_idc = 0 / H.265 sub-layer non-reference)
+    Keyframe        ///< 只解码关键帧 (IDR / IRAP), 其余包不进入解码器
+};
+
+/// 解码模式字符串解析 (未知取值按 All 处理)
+inline DecodeMode decode_mode_from_string(const std::string& s) {
+    if (s == "nonref") return DecodeMode::NonRef;
+    if (s == "keyframe") return DecodeMode::Keyframe;
+    return DecodeMode::All;
+}
+
+/// 解码模式枚举转字符串
+inline std::string decode_mode_to_string(DecodeMode m) {
+    switch (m) {
+        case DecodeMode::NonRef:   return "nonref";
+        case DecodeMode::Keyframe: return "keyframe";
+        default:                   return "all";
+    }
+}
+
 /// 单个 RTSP 流的配置
 struct StreamConfig {
     std::string cam_id;                 ///< 摄像头唯一标识
     std::string rtsp_url;               ///< RTSP 地址
-    int frame_skip = 5;                 ///< 每 N 帧推理一次
+    int frame_skip = 5;                 ///< 每 N 帧推理一次 (target_fps = 0 时决定请求帧率)
+    double target_fps = 0.0;            ///< 目标推理帧率 (0 = 源帧率 / frame_skip); 过载时自适应下调
+    /// 推理队列优先级: "critical" (报警关键, 如闸机) / "normal" / "best_effort"
+    std::string priority = "normal";
+    int deadline_ms = 0;                ///< 推理任务排队超过该时长即丢弃 (0 = 使用 infer_task_deadline_ms)
+    /// 解码模式: "all" / "nonref" / "keyframe" (只解码 I 帧, frame_skip 按关键帧计数)
+    std::string decode_mode = "all";
+    std::vector<RoiConfig> rois;        ///< 该流所有模型默认的 ROI (为空 = 整帧; 模型可单独覆盖)
+    /// 场景变化门控: 亮度缩略图任一块平均差 (0~255) 超过该值才推理 (0 = 关闭, 每帧推理)
+    double motion_threshold = 0.0;
+    int motion_min_blocks = 1;          ///< 判定为变化所需的最少变化块数 (共 8 x 9 块)
+    int motion_max_skip_ms = 10000;     ///< 静止时最长跳过推理的时长, 超过后强制推理一帧 (0 = 不限)
+    /// 跳过推理的帧: "republish" (转发上次推理结果, 标记 repeated) / "suppress" (不输出)
+    std::string motion_skip_action = "republish";
+    /// rtsp_url 为本地文件 (虚拟摄像头) 时的回放帧率: 0 = 文件帧率, < 0 = 不限速; 文件结束后从头循环
+    double file_fps = 0.0;
     std::vector<ModelConfig> models;    ///< 使用的模型列表
 
     NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(
         StreamConfig,
-        cam_id, rtsp_url, frame_skip, models
+        cam_id, rtsp_url, frame_skip, target_fps, priority, deadline_ms, decode_mode, rois,
+        motion_threshold, motion_min_blocks, motion_max_skip_ms, motion_skip_action, file_fps, models
     )
 };
 
@@ -68,16 +225,85 @@ struct BBox {
     NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(BBox, x1, y1, x2, y2)
 };
 
+/**
+ * @brief 预处理几何变换 (原图坐标 <-> 模型输入坐标)
+ *
+ * 原图 (或其中从 (src_x, src_y) 开始的 src_w x src_h 裁剪区域)
+ * 被缩放到模型输入中的矩形 (x, y, w, h), 矩形外为填充区域:
+ * - letterbox: 等比缩放后居中, 短边两侧填充灰色 (114)
+ * - stretch:   拉伸到整个模型输入, 无填充
+ * 矩形按 RGA 要求对齐为偶数, 因此两个方向的缩放比例可能略有差异;
+ * 后处理按矩形逐轴反算, 与预处理写入的像素位置完全一致。
+ */
+struct LetterboxTransform {
+    int src_x = 0;      ///< 裁剪区域在原图中的左上角 x (整帧时为 0)
+    int src_y = 0;      ///< 裁剪区域在原图中的左上角 y
+    int src_w = 0;      ///< 原图 (裁剪区域) 宽度
+    int src_h = 0;      ///< 原图 (裁剪区域) 高度
+    int model_w = 0;    ///< 模型输入宽度
+    int model_h = 0;    ///< 模型输入高度
+    int x = 0;          ///< 图像区域在模型输入中的左上角 x
+    int y = 0;          ///< 图像区域在模型输入中的左上角 y
+    int w = 0;          ///< 图像区域宽度
+    int h = 0;          ///< 图像区域高度
+
+    bool valid() const { return src_w > 0 && src_h > 0 && w > 0 && h > 0; }
+
+    /// 模型输入中是否存在填充区域
+    bool has_padding() const { return w < model_w || h < model_h; }
+
+    /// 等比缩放 + 居中填充
+    static LetterboxTransform letterbox(int src_w, int src_h, int model_w, int model_h) {
+        LetterboxTransform t = stretch(src_w, src_h, model_w, model_h);
+        if (!t.valid()) return t;
+        double scale = std::min(static_cast<double>(model_w) / src_w,
+                                static_cast<double>(model_h) / src_h);
+        t.w = std::clamp(static_cast<int>(std::lround(src_w * scale)) & ~1, 2, model_w);
+        t.h = std::clamp(static_cast<int>(std::lround(src_h * scale)) & ~1, 2, model_h);
+        t.x = ((model_w - t.w) / 2) & ~1;
+        t.y = ((model_h - t.h) / 2) & ~1;
+        return t;
+    }
+
+    /// 拉伸到整个模型输入
+    static LetterboxTransform stretch(int src_w, int src_h, int model_w, int model_h) {
+        LetterboxTransform t;
+        if (src_w <= 0 || src_h <= 0 || model_w <= 0 || model_h <= 0) return t;
+        t.src_w = src_w;
+        t.src_h = src_h;
+        t.model_w = model_w;
+        t.model_h = model_h;
+        t.w = model_w;
+        t.h = model_h;
+        return t;
+    }
+
+    /// 模型输入坐标 -> 原图坐标 (裁剪到 src 区域范围)
+    void unmap(BBox& box) const {
+        float sx = static_cast<float>(src_w) / static_cast<float>(w);
+        float sy = static_cast<float>(src_h) / static_cast<float>(h);
+        float ox = static_cast<float>(src_x);
+        float oy = static_cast<float>(src_y);
+        float max_x = static_cast<float>(src_w);
+        float max_y = static_cast<float>(src_h);
+        box.x1 = std::clamp((box.x1 - static_cast<float>(x)) * sx, 0.0f, max_x) + ox;
+        box.y1 = std::clamp((box.y1 - static_cast<float>(y)) * sy, 0.0f, max_y) + oy;
+        box.x2 = std::clamp((box.x2 - static_cast<float>(x)) * sx, 0.0f, max_x) + ox;
+        box.y2 = std::clamp((box.y2 - static_cast<float>(y)) * sy, 0.0f, max_y) + oy;
+    }
+};
+
 /// 单个检测目标
 struct Detection {
     int class_id = -1;              ///< 类别 ID
     std::string class_name;         ///< 类别名称 (来自 labels_file)
     float confidence = 0.0f;        ///< 置信度
     BBox bbox;                      ///< 检测框
+    int track_id = -1;              ///< 跟踪 ID (同一目标跨帧不变; -1 = 未跟踪)
 
     NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(
         Detection,
-        class_id, class_name, confidence, bbox
+        class_id, class_name, confidence, bbox, track_id
     )
 };
 
@@ -87,13 +313,42 @@ struct ModelResult {
     std::string model_path;             ///< 模型路径
     double inference_time_ms = 0.0;     ///< 推理耗时 (毫秒)
     std::vector<Detection> detections;  ///< 检测结果列表
+    bool predicted = false;             ///< 本帧模型未推理 (infer_interval), 检测框由跟踪器外推
+    /// 本帧实际占用的 NPU + 后处理时间 (批内均摊, 不含排队等待; 不序列化, 供准入控制估计开销)
+    double compute_ms = 0.0;
 
     NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(
         ModelResult,
-        task_name, model_path, inference_time_ms, detections
+        task_name, model_path, inference_time_ms, detections, predicted
     )
 };
 
+/**
+ * @brief 流级运行时计数器
+ *
+ * 由 StreamManager 为每路流创建, 经 ModelBinding -> FrameResult 随结果传递,
+ * 输出线程更新计数时直接通过句柄原子累加, 不需要按 cam_id 查表加锁。
+ */
+struct StreamCounters {
+    std::atomic<uint64_t> inferred_frames{0};   ///< 完成推理的帧数
+    std::atomic<double> frame_cost_ms{0.0};     ///< 单帧 NPU + 后处理耗时滑动平均 (所有模型之和, 供准入控制估计 NPU 开销)
+    std::atomic<uint64_t> infer_dropped{0};     ///< 推理队列满时被挤出的任务数
+    std::atomic<uint64_t> infer_expired{0};     ///< 排队超过 deadline 被丢弃的任务数
+
+    /// 分阶段延迟直方图 (解码 -> 输出, 各阶段线程直接记录)
+    StageLatency latency;
+
+    // 滑动窗口速率 (各线程直接 mark, 重启流时 reset)
+    RateMeter decode_rate;                      ///< 解码输出帧
+    RateMeter infer_rate;                       ///< 完成推理的帧
+    RateMeter drop_rate;                        ///< 预处理队列丢弃的帧 + 推理队列挤出 / 超时的任务
+
+    /// 保留最近一次推理结果 (motion_skip_action = "republish" 时开启)
+    std::atomic<bool> keep_last_result{false};
+    std::mutex last_result_mutex;
+    std::vector<ModelResult> last_results;      ///< 最近一次推理结果 (last_result_mutex 保护)
+};
+
 /// 单帧的完整推理结果 (所有模型聚合后)
 struct FrameResult {
     std::string cam_id;             ///< 摄像头 ID
@@ -104,11 +359,28 @@ struct FrameResult {
     int original_width = 0;        ///< 原始帧宽度
     int original_height = 0;       ///< 原始帧高度
     std::vector<ModelResult> results;  ///< 各模型推理结果
+    bool repeated = false;          ///< 场景静止跳过推理, results 沿用上一次推理结果
+
+    /// 所属流的计数器句柄 (不序列化; 流已删除时仍有效)
+    std::shared_ptr<StreamCounters> counters;
+
+    /// 所属流的跟踪阶段 (不序列化; 没有模型开启跟踪时为空)
+    std::shared_ptr<const StreamTrackers> trackers;
+
+    // 延迟追踪 (不序列化; steady_clock 纳秒, 0 = 未记录)
+    int64_t decoded_ns = 0;         ///< 解码完成
+    int64_t completed_ns = 0;       ///< 所有模型完成 (进入输出阶段)
+
+    /// 本帧经过了推理: 不是运动门控转发的结果, 且至少一个模型不是跟踪器外推的
+    bool inferred() const {
+        return !repeated && std::any_of(results.begin(), results.end(),
+                                        [](const ModelResult& r) { return !r.predicted; });
+    }
 
     NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(
         FrameResult,
         cam_id, rtsp_url, frame_id, timestamp_ms, pts,
-        original_width, original_height, results
+        original_width, original_height, results, repeated
     )
 };
 
@@ -143,24 +415,80 @@ struct StreamStatus {
     std::string rtsp_url;
     std::string status = "stopped";
     int frame_skip = 0;
+    double target_fps = 0.0;
+    std::string priority = "normal";
+    int deadline_ms = 0;
+    std::string decode_mode = "all";
+    std::vector<RoiConfig> rois;
+    double motion_threshold = 0.0;
+    int motion_min_blocks = 1;
+    int motion_max_skip_ms = 10000;
+    std::string motion_skip_action = "republish";
     std::vector<ModelConfig> models;
 
     // 运行时统计
-    uint64_t decoded_frames = 0;
+    uint64_t decoded_frames = 0;        ///< 解码器输出的帧数 (keyframe 模式只含关键帧)
+    uint64_t demux_discarded = 0;       ///< 按 decode_mode 在解复用层丢弃、未送入解码器的包数
     uint64_t inferred_frames = 0;
-    uint64_t dropped_frames = 0;
-    double decode_fps = 0.0;
-    double infer_fps = 0.0;
+    uint64_t dropped_frames = 0;        ///< 预处理队列 + 推理队列丢弃之和
+    uint64_t infer_dropped = 0;         ///< 推理队列满时被挤出的任务数
+    uint64_t infer_expired = 0;         ///< 排队超过 deadline 被丢弃的任务数
+    double decode_fps = 0.0;            ///< 解码帧率 (最近 10 秒指数加权, 下同)
+    double decode_fps_1s = 0.0;         ///< 解码帧率 (最近 1 秒)
+    double decode_fps_60s = 0.0;        ///< 解码帧率 (最近 60 秒)
+    double infer_fps = 0.0;             ///< 推理帧率
+    double infer_fps_1s = 0.0;
+    double infer_fps_60s = 0.0;
+    double drop_fps = 0.0;              ///< 丢弃速率 (dropped_frames 的增长速度)
+    double drop_fps_1s = 0.0;
+    double drop_fps_60s = 0.0;
     uint32_t reconnect_count = 0;
     std::string last_error;
     double uptime_seconds = 0.0;
 
+    // 流水线统计 (各阶段单帧耗时的滑动平均, 毫秒)
+    double decode_ms = 0.0;             ///< 解复用 + 解码 (含网络等待)
+    double preprocess_ms = 0.0;         ///< RGA 预处理 + 推理提交
+    double encode_ms = 0.0;             ///< JPEG 编码 + 写入缓存
+    uint32_t preprocess_queue = 0;      ///< 待预处理帧数
+    uint32_t encode_queue = 0;          ///< 待编码帧数
+    uint64_t encode_dropped = 0;        ///< 编码跟不上而丢弃的缓存帧数
+
+    // 自适应跳帧 (adaptive_skip = true 时有效)
+    double admitted_fps = 0.0;          ///< 当前分配到的准入帧率
+    int effective_skip = 0;             ///< 等效跳帧间隔 (源帧率 / 准入帧率)
+    uint64_t admission_skipped = 0;     ///< 准入控制在解码前跳过的帧数
+    double frame_cost_ms = 0.0;         ///< 单帧 NPU + 后处理耗时滑动平均 (所有模型之和)
+
+    // 目标跟踪 (模型 infer_interval > 1 时有效)
+    uint64_t predicted_results = 0;     ///< 由跟踪器外推、未推理的模型结果数
+
+    // 场景变化门控 (motion_threshold > 0 时有效)
+    uint64_t motion_skipped = 0;        ///< 场景静止而跳过推理的帧数
+    double motion_score = 0.0;          ///< 最近一帧变化最大块的平均亮度差
+
+    // 模型预热
+    bool models_ready = false;          ///< 流引用的模型均已结束加载 (之前不提交推理)
+
+    // 报警片段码流缓存 (clip_duration_sec > 0 时有效)
+    uint64_t clip_bytes = 0;            ///< 缓存的压缩码流字节数
+    int64_t clip_duration_ms = 0;       ///< 缓存覆盖的时长
+
     NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(
         StreamStatus,
-        cam_id, rtsp_url, status, frame_skip, models,
-        decoded_frames, inferred_frames, dropped_frames,
-        decode_fps, infer_fps, reconnect_count,
-        last_error, uptime_seconds
+        cam_id, rtsp_url, status, frame_skip, target_fps, priority, deadline_ms, decode_mode, rois,
+        motion_threshold, motion_min_blocks, motion_max_skip_ms, motion_skip_action, models,
+        decoded_frames, demux_discarded, inferred_frames, dropped_frames, infer_dropped, infer_expired,
+        decode_fps, decode_fps_1s, decode_fps_60s, infer_fps, infer_fps_1s, infer_fps_60s,
+        drop_fps, drop_fps_1s, drop_fps_60s, reconnect_count,
+        last_error, uptime_seconds,
+        decode_ms, preprocess_ms, encode_ms,
+        preprocess_queue, encode_queue, encode_dropped,
+        admitted_fps, effective_skip, admission_skipped, frame_cost_ms,
+        predicted_results,
+        motion_skipped, motion_score,
+        models_ready,
+        clip_bytes, clip_duration_ms
     )
 };
 
@@ -168,6 +496,26 @@ struct StreamStatus {
 // 内部类型 (不需要 JSON 序列化)
 // ============================================================
 
+/// DMA-BUF 缓冲区描述 (零拷贝模式)
+///
+/// 用于两类缓冲区:
+/// - MPP 解码输出的 DRM-PRIME 帧 (NV12, 只有 fd, 无 CPU 映射)
+/// - NPU 输入 tensor (rknn_create_mem 分配, fd + 虚拟地址)
+///
+/// holder 持有底层分配对象 (AVFrame 引用 / rknn_tensor_mem 等),
+/// 最后一个引用释放时归还给解码器缓冲池或 NPU 驱动。
+struct DmaBuffer {
+    int fd = -1;                    ///< DMA-BUF 文件描述符
+    void* virt_addr = nullptr;      ///< CPU 虚拟地址 (可为 nullptr)
+    size_t size = 0;                ///< 缓冲区字节数
+    int width = 0;                  ///< 图像宽度 (像素)
+    int height = 0;                 ///< 图像高度 (像素)
+    int wstride = 0;                ///< 行步长 (像素)
+    int hstride = 0;                ///< 高度步长 (行, NV12 的 UV 平面起始行)
+    uint64_t id = 0;                ///< 非 0 时在进程内唯一标识底层内存 (池化复用时不变, 可缓存 fd 导入)
+    std::shared_ptr<void> holder;   ///< 底层对象的所有权
+};
+
 /// 解码后的帧 (NV12 格式, 从 AVFrame 拷贝出的连续内存)
 struct DecodedFrame {
     std::string cam_id;
@@ -177,10 +525,28 @@ struct DecodedFrame {
     int64_t timestamp_ms = 0;     ///< 系统时间戳 (毫秒, epoch)
     int width = 0;                ///< 帧宽度
     int height = 0;               ///< 帧高度
+    int source_width = 0;         ///< 解码器缩放输出时的原始码流宽度 (0 = 与 width 相同)
+    int source_height = 0;        ///< 解码器缩放输出时的原始码流高度 (0 = 与 height 相同)
 
     /// NV12 数据 (Y plane + UV interleaved, 连续存储)
     /// 布局: [Y: width*height bytes] [UV: width*(height/2) bytes]
     std::shared_ptr<std::vector<uint8_t>> nv12_data;
+
+    /// 零拷贝模式: 解码器输出的 DRM-PRIME 帧 (此时 nv12_data 为空)
+    std::shared_ptr<DmaBuffer> dma_buf;
+
+    // 延迟追踪 (steady_clock 纳秒)
+    int64_t decoded_ns = 0;       ///< 解码完成 (解码线程取到帧时)
+    int64_t copy_ns = 0;          ///< 硬件帧拷贝到 CPU 内存的耗时 (0 = 未拷贝)
+};
+
+/// 缓存图上的检测框 (缓存图像素坐标, 闭区间; 见 cache/overlay.h)
+struct OverlayBox {
+    int x1 = 0;
+    int y1 = 0;
+    int x2 = 0;
+    int y2 = 0;
+    int class_id = -1;  ///< 决定边框颜色
 };
 
 /// 图片缓存帧 (JPEG 压缩后)
@@ -192,40 +558,130 @@ struct CachedFrame {
     int height = 0;
     std::shared_ptr<std::vector<uint8_t>> jpeg_data;
 
+    /// 延迟编码模式 (cache_mode = "raw"): 缩放后的 NV12 原图, 首次读取时编码为 JPEG
+    /// 布局同 DecodedFrame::nv12_data (width * height * 3/2)
+    std::shared_ptr<std::vector<uint8_t>> raw_nv12;
+
+    /// 检测框叠加 (cache_overlay): 由推理结果回填到尚未编码的 raw 帧, 编码时画入 JPEG
+    /// 已编码的帧: 非空表示 jpeg_data 带检测框
+    std::shared_ptr<const std::vector<OverlayBox>> overlay;
+
     /// JPEG 数据大小 (字节)
     size_t jpeg_size() const {
         return jpeg_data ? jpeg_data->size() : 0;
     }
+
+    /// 缓存占用 (JPEG + 未编码的原图)
+    size_t memory_size() const {
+        return jpeg_size() + (raw_nv12 ? raw_nv12->size() : 0);
+    }
+};
+
+/// 类别标签表 (按标签文件共享, 构造后不可变)
+using LabelTable = std::vector<std::string>;
+
+/// 推理任务优先级 (数值越小越优先)
+enum class TaskPriority {
+    Critical = 0,       ///< 报警关键流: 队列满时最后被挤出, 调度权重最高
+    Normal = 1,
+    BestEffort = 2      ///< 尽力而为: 队列满时最先被挤出
+};
+
+constexpr int kNumTaskPriorities = 3;
+
+/// 优先级字符串解析 (未知取值按 Normal 处理)
+inline TaskPriority task_priority_from_string(const std::string& s) {
+    if (s == "critical") return TaskPriority::Critical;
+    if (s == "best_effort") return TaskPriority::BestEffort;
+    return TaskPriority::Normal;
+}
+
+/// 优先级枚举转字符串
+inline std::string task_priority_to_string(TaskPriority p) {
+    switch (p) {
+        case TaskPriority::Critical:   return "critical";
+        case TaskPriority::BestEffort: return "best_effort";
+        default:                       return "normal";
+    }
+}
+
+/**
+ * @brief 流 + 模型的不可变描述
+ *
+ * 添加流时为每个模型构造一次, 该流所有帧的 InferTask 以指针共享,
+ * 避免每帧每模型拷贝字符串和标签表。
+ */
+struct ModelBinding {
+    std::string cam_id;
+    std::string rtsp_url;
+    std::string model_path;
+    std::string task_name;
+    std::string model_type;
+    float conf_threshold = 0.25f;
+    float nms_threshold = 0.45f;
+    int max_batch = 1;              ///< 动态批处理上限 (来自 ModelConfig)
+    int batch_wait_ms = 0;          ///< 凑批等待窗口 (来自 ModelConfig)
+    int input_width = 0;            ///< 模型输入宽度
+    int input_height = 0;           ///< 模型输入高度
+    TaskPriority priority = TaskPriority::Normal;  ///< 推理队列优先级 (来自 StreamConfig)
+    int deadline_ms = 0;            ///< 排队超时丢弃阈值 (0 = 不限)
+    std::shared_ptr<const LabelTable> labels;  ///< 标签表 (无标签文件时为空)
+    std::shared_ptr<StreamCounters> counters;  ///< 所属流的计数器 (可为空)
+    std::shared_ptr<const StreamTrackers> trackers;  ///< 所属流的跟踪阶段 (可为空)
+    std::shared_ptr<StageLatency> latency;     ///< 流 x 模型的排队 / NPU / 后处理延迟 (可为空)
+
+    /// 标签表引用 (无标签时返回空表)
+    const LabelTable& label_table() const {
+        static const LabelTable kEmpty;
+        return labels ? *labels : kEmpty;
+    }
 };
 
 /// 推理任务 (有界队列中的元素)
 struct InferTask {
     // 帧标识信息
-    std::string cam_id;
-    std::string rtsp_url;           ///< RTSP 地址 (Phase 2 新增)
     uint64_t frame_id = 0;
     int64_t pts = 0;
     int64_t timestamp_ms = 0;
     int original_width = 0;
     int original_height = 0;
 
-    // 模型信息
-    std::string model_path;
-    std::string task_name;
-    std::string model_type;
-    float conf_threshold = 0.25f;
-    float nms_threshold = 0.45f;
-    std::vector<std::string> labels;
+    /// 模型信息 (流内所有帧共享)
+    std::shared_ptr<const ModelBinding> binding;
 
     // 输入数据 (RGA resize 后的 RGB 数据)
     std::shared_ptr<std::vector<uint8_t>> input_data;
-    int input_width = 0;
-    int input_height = 0;
+
+    /// 零拷贝模式: RGA 直接写入的 NPU 输入 tensor (此时 input_data 为空)
+    std::shared_ptr<DmaBuffer> input_dma;
+
+    /// 预处理几何变换 (后处理据此把检测框映射回原图; 无效时按 letterbox 假设计算)
+    LetterboxTransform transform;
+
+    /// 同一帧同一模型的分块数 (ROI / tiling; > 1 时聚合器等齐所有分块后跨块 NMS)
+    int tile_count = 1;
+
+    /// 本任务在分块中的下标 (0 <= tile_index < tile_count)
+    int tile_index = 0;
+
+    /// 结果在聚合器中的槽位 (模型在 StreamConfig::models 中的下标)
+    int result_slot = 0;
+
+    /// 进入推理队列的时间 (由队列在 push 时记录, 用于 deadline 判定)
+    std::chrono::steady_clock::time_point enqueue_time{};
+
+    /// 帧解码完成时间 (steady_clock 纳秒, 随结果传递用于端到端延迟)
+    int64_t decoded_ns = 0;
 
     /// 结果聚合器 (同一帧的多模型任务共享)
-    /// 实际类型: std::shared_ptr<FrameResultCollector>
     /// 单模型场景可为 nullptr, InferWorker 会直接组装 FrameResult
-    std::shared_ptr<void> aggregator;
+    std::shared_ptr<FrameResultCollector> aggregator;
+
+    /// 模型路径 (调度器按模型分组; binding 为空时返回空串)
+    const std::string& model_path() const {
+        static const std::string kEmpty;
+        return binding ? binding->model_path : kEmpty;
+    }
 };
 
 // ============================================================
@@ -7,6 +7,33 @@
  * 封装 FFmpeg 的 h264_rkmpp 硬件解码器，从 RTSP 流读取并解码视频帧。
  * 输出 NV12 格式的 DecodedFrame（连续内存，无 stride padding）。
  *
+ * 零拷贝模式 (Config::zero_copy): 硬件解码输出 DRM-PRIME 帧时,
+ * 不做 av_hwframe_transfer_data 和 NV12 拷贝, 而是保留 AVFrame 引用,
+ * 通过 DecodedFrame::dma_buf 暴露 DMA-BUF fd 供 RGA 直接读取。
+ *
+ * 码流缓存 (set_packet_ring): 每个视频包在送入解码器之前原样写入 PacketRing,
+ * 跳帧路径同样写入, 供报警片段无转码导出。
+ *
+ * 输出缩放 (set_output_size): 非零拷贝路径下, DRM-PRIME 帧由 RGA 直接缩放到 CPU 内存,
+ * 只传输缩放后的 NV12, 不再做全分辨率 av_hwframe_transfer_data + extract_nv12;
+ * DecodedFrame::source_width/height 保留原始分辨率。需要 HAS_RGA, 否则忽略。
+ *
+ * 解码模式 (Config::decode_mode): 在解复用之后按包过滤, 被丢弃的包不进入 MPP:
+ * - NonRef:   丢弃非参考帧 (NonRefPacketFilter), 其余帧正常解码
+ * - Keyframe: 只送入关键帧包, 每个关键帧送入后立即 drain + flush 取出, 不等待后续包;
+ *             skip_frame() 只读到下一个关键帧包, 完全不解码
+ * 这两种模式下 decode_frame() / skip_frame() 每次对应一个 "输出帧",
+ * 输出帧率由包时间戳估计 (get_output_fps)。
+ *
+ * 本地文件源 (rtsp_url 为文件路径或 file: URL, 用于虚拟摄像头 / 压测):
+ * 按 Config::file_fps 限速读包 (默认文件帧率, 模拟实时摄像头), 读到文件末尾后
+ * 回到开头循环, 时间戳接续上一轮保持单调, 解码器状态不复位。
+ *
+ * 单包推进 (poll): 每次只读取并处理一个包, 供解码线程池按步调度
+ * (DecodeScheduler); decode_frame() / skip_frame() 是对 poll() 的循环。
+ * 网络读取通过 interrupt_callback 设置截止时间 (read_timeout_sec),
+ * set_abort_flag() 给出的停止标志置位后阻塞中的读取立即返回。
+ *
  * 使用方式:
  *   HwDecoder decoder;
  *   HwDecoder::Config cfg;
@@ -21,8 +48,11 @@
 #ifdef HAS_FFMPEG
 
 #include "infer_server/common/types.h"
+#include "infer_server/decoder/nal_parser.h"
+#include <atomic>
 #include <string>
 #include <optional>
+#include <memory>
 #include <cstdint>
 
 // Forward declarations for FFmpeg types (avoid including heavy headers here)
@@ -33,6 +63,8 @@ struct AVPacket;
 
 namespace infer_server {
 
+class PacketRing;
+
 class HwDecoder {
 public:
     /// 解码器配置
@@ -41,8 +73,22 @@ public:
         int connect_timeout_sec = 5;    ///< RTSP 连接超时 (秒)
         int read_timeout_sec = 5;       ///< 读取超时 (秒)
         bool tcp_transport = true;      ///< 使用 TCP 传输 (更可靠)
+        bool zero_copy = false;         ///< 输出 DRM-PRIME DMA-BUF 帧 (不拷贝到 CPU)
+        DecodeMode decode_mode = DecodeMode::All;   ///< 解复用层丢帧策略
+        double file_fps = 0.0;          ///< 本地文件源的回放帧率 (0 = 文件帧率, < 0 = 不限速); RTSP 源忽略
     };
 
+    /// poll() 的结果
+    enum class PollStatus {
+        Pending,    ///< 已处理一个包, 尚无输出帧 (非视频包 / 被丢弃 / 解码器需要更多数据)
+        Frame,      ///< 输出一帧 (want_frame = true)
+        Skipped,    ///< 输出帧已丢弃 (want_frame = false)
+        Error,      ///< 流结束或出错 (需要重新打开)
+    };
+
+    /// URL 是否为本地文件 (无 "scheme://" 前缀, 或 file: 协议)
+    static bool is_file_source(const std::string& url);
+
     HwDecoder() = default;
     ~HwDecoder();
 
@@ -65,9 +111,26 @@ public:
     /// @return true 成功解码（数据已丢弃），false 流结束或出错
     bool skip_frame();
 
+    /**
+     * @brief 读取并处理一个包 (不循环, 供按步调度)
+     * @param want_frame true: 得到输出帧时写入 frame; false: 按 skip_frame() 的方式丢弃
+     * @param frame      输出帧 (仅 PollStatus::Frame 时有效)
+     */
+    PollStatus poll(bool want_frame, std::optional<DecodedFrame>& frame);
+
     /// 关闭解码器并释放所有资源
     void close();
 
+    /// 设置输出尺寸 (0 = 原始分辨率), 可在 open() 之后根据 get_width/height 决定
+    /// NV12 要求偶数宽高, 奇数向上取整
+    void set_output_size(int width, int height);
+
+    /// 设置码流缓存 (可为 nullptr)。open() 时以当前流参数重置缓存
+    void set_packet_ring(std::shared_ptr<PacketRing> ring) { packet_ring_ = std::move(ring); }
+
+    /// 设置停止标志 (可为 nullptr): 置位后阻塞中的 open / 读取立即返回失败
+    void set_abort_flag(const std::atomic<bool>* flag) { abort_flag_ = flag; }
+
     /// 流是否已打开
     bool is_open() const { return is_open_; }
 
@@ -80,16 +143,74 @@ public:
     /// 视频帧率
     double get_fps() const { return fps_; }
 
+    /// 输出帧率: All 模式为源帧率; NonRef / Keyframe 模式为实测值 (尚未测出时为 0)
+    double get_output_fps() const;
+
+    /// 在解复用层丢弃、未送入解码器的包数 (本次 open 以来)
+    uint64_t discarded_packets() const { return discarded_packets_; }
+
     /// 解码器名称 (如 "h264_rkmpp")
     const std::string& get_codec_name() const { return codec_name_; }
 
     /// 是否使用硬件解码器
     bool is_hardware() const { return is_hw_decoder_; }
 
+    /// 当前打开的是本地文件源
+    bool is_file() const { return file_source_; }
+
+    /// 本地文件源下一个视频包的读取时刻 (steady_clock 纳秒, 不限速时为 0)
+    int64_t next_read_ns() const { return packet_interval_ns_ > 0 ? next_packet_ns_ : 0; }
+
+    /// 最近读到的视频包时间戳 (毫秒)
+    int64_t last_packet_ms() const { return last_packet_ms_; }
+
+    /// 最近一次读取是否等待了网络数据 (av_read_frame 耗时超过 1 ms)
+    bool last_read_blocked() const { return last_read_ns_ > 1000000; }
+
 private:
     /// 从 AVFrame 提取 NV12 数据到连续内存
     std::shared_ptr<std::vector<uint8_t>> extract_nv12(AVFrame* frame);
 
+    /// 将 DRM-PRIME 帧包装为 DmaBuffer (持有 AVFrame 引用, 不拷贝数据)
+    /// @return 非 NV12 布局或描述符无效时返回 nullptr
+    std::shared_ptr<DmaBuffer> wrap_drm_frame(AVFrame* frame);
+
+    /// RGA 将 DRM-PRIME 帧缩放为 output_width_ x output_height_ 的 NV12 (CPU 内存)
+    /// @return 失败时返回 nullptr (调用方回退到全分辨率传输)
+    std::shared_ptr<std::vector<uint8_t>> scale_drm_frame(AVFrame* frame);
+
+    /// 将当前视频包拷贝到码流缓存
+    void capture_packet(const AVPacket* packet);
+
+    /// 按 decode_mode 判断当前视频包是否丢弃 (不送入解码器)
+    bool discard_packet(const AVPacket* packet);
+
+    /// 记录一个输出帧的时间戳, 更新输出帧间隔估计
+    void note_output(const AVPacket* packet);
+
+    /// 读取下一个包 (av_read_frame); 本地文件源在此限速, 并在文件末尾回到开头循环
+    int read_packet();
+
+    /// 解码器输出帧 -> DecodedFrame (零拷贝 / RGA 缩放 / 传输 + NV12 提取)
+    /// @return 传输失败或像素格式不符时返回 nullopt (该帧丢弃)
+    std::optional<DecodedFrame> take_frame();
+
+    /// FFmpeg interrupt_callback: 停止标志置位或超过读取截止时间时中断阻塞 I/O
+    static int interrupt_callback(void* opaque);
+
+    /// 停止标志已置位
+    bool abort_requested() const {
+        return abort_flag_ && abort_flag_->load(std::memory_order_relaxed);
+    }
+
+    /// Keyframe 模式: 已送入关键帧但解码器未输出时, drain 取出该帧并复位解码器
+    int drain_and_flush();
+
+    /// PTS (流时间基) -> 毫秒时间戳, 无 PTS 时使用系统时钟
+    int64_t pts_to_ms(int64_t pts) const;
+
+    Config config_;
+
     AVFormatContext* fmt_ctx_ = nullptr;
     AVCodecContext* codec_ctx_ = nullptr;
     AVFrame* frame_ = nullptr;
@@ -103,6 +224,29 @@ private:
     std::string codec_name_;
     bool is_open_ = false;
     bool is_hw_decoder_ = false;
+
+    std::shared_ptr<PacketRing> packet_ring_;
+
+    int output_width_ = 0;      ///< 0 = 原始分辨率
+    int output_height_ = 0;
+
+    std::unique_ptr<NonRefPacketFilter> nonref_filter_;    ///< 仅 NonRef 模式
+    uint64_t discarded_packets_ = 0;
+    int64_t last_output_ms_ = -1;
+    double output_interval_ms_ = 0.0;   ///< 输出帧间隔滑动平均 (0 = 未知)
+
+    // 本地文件源
+    bool file_source_ = false;
+    int64_t loop_offset_ = 0;           ///< 当前一轮叠加到包时间戳上的偏移 (流时间基)
+    int64_t loop_end_pts_ = 0;          ///< 已读包 (叠加偏移后) 的最大结束时间戳
+    int64_t packet_interval_ns_ = 0;    ///< 读包间隔 (0 = 不限速)
+    int64_t next_packet_ns_ = 0;        ///< 下一个视频包的读取时刻 (steady_clock 纳秒)
+
+    // 按步调度 / 中断
+    const std::atomic<bool>* abort_flag_ = nullptr;
+    int64_t io_deadline_ns_ = 0;        ///< 阻塞 I/O 截止时刻 (steady_clock 纳秒, 0 = 不限)
+    int64_t last_read_ns_ = 0;          ///< 最近一次 av_read_frame 耗时
+    int64_t last_packet_ms_ = 0;
 };
 
 } // namespace infer_server
@@ -0,0 +1,67 @@
+#pragma once
+
+/**
+ * @file nal_parser.h
+ * @brief H.264 / H.265 NAL 单元解析 (解复用层丢帧)
+ *
+ * 跳帧路径 (HwDecoder::skip_frame) 仍然把每个包送进 MPP 解码, 只省去 NV12 拷贝。
+ * 低帧率分析场景下可以在解复用之后、送入解码器之前直接丢弃不影响后续解码的包:
+ *
+ * - H.264: 所有 VCL NAL 的 nal_ref_idc == 0 (非参考帧, 通常是 B 帧)
+ * - H.265: 所有 VCL NAL 为 sub-layer non-reference 类型 (TRAIL_N / RASL_N 等),
+ *          且位于目前见到的最高时域层 (更高层可能参考低层的 _N 帧)
+ *
+ * 支持 Annex B 起始码 (RTSP) 和 4 字节长度前缀 (AVCC / HVCC, MP4 文件) 两种封装。
+ *
+ * 纯字节解析, 不依赖 FFmpeg。
+ */
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace infer_server {
+
+/// 码流编码格式
+enum class NalCodec {
+    H264,
+    H265
+};
+
+/// 一个 NAL 单元 (指向原始包内存, 不含起始码 / 长度前缀)
+struct NalUnit {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+/**
+ * @brief 拆分压缩包中的 NAL 单元
+ *
+ * 以 00 00 01 / 00 00 00 01 开头时按 Annex B 解析, 否则按 4 字节大端长度前缀解析;
+ * 长度前缀越界时停止解析。
+ * @return NAL 单元数
+ */
+size_t split_nal_units(const uint8_t* data, size_t size, std::vector<NalUnit>& out);
+
+/**
+ * @brief 非参考帧过滤器 (每路流一个, 跨包记录 H.265 最高时域层)
+ */
+class NonRefPacketFilter {
+public:
+    explicit NonRefPacketFilter(NalCodec codec) : codec_(codec) {}
+
+    /// 包是否可以不送入解码器 (不含 VCL NAL 的包, 如单独的 SPS/PPS/SEI, 返回 false)
+    bool droppable(const uint8_t* data, size_t size);
+
+    /// 重新打开流时清空状态
+    void reset() { max_temporal_id_ = 0; }
+
+    NalCodec codec() const { return codec_; }
+
+private:
+    NalCodec codec_;
+    int max_temporal_id_ = 0;       ///< H.265 目前见到的最高 TemporalId
+    std::vector<NalUnit> nals_;     ///< 复用的拆分缓冲
+};
+
+} // namespace infer_server
@@ -0,0 +1,131 @@
+#pragma once
+
+/**
+ * @file affinity_scheduler.h
+ * @brief 模型亲和 + 工作窃取的推理任务调度器
+ *
+ * 共享队列模式下, 每个 InferWorker 都会从同一个队列取到任意模型的任务,
+ * 于是每个 worker 都为每个模型创建 rknn_context, NPU 内存随 worker 数倍增。
+ *
+ * AffinityScheduler 为每个 worker 维护独立的 InferTaskQueue:
+ * - 每个模型固定分配一个 "主 worker" (按已分配模型数最少的 worker 选择)
+ * - submit() 将任务推入模型主 worker 的队列
+ * - worker 自己的队列为空时尝试窃取:
+ *     a. 目标任务的模型在本 worker 已有 context (can_steal 回调判定, 热窃取)
+ *     b. 或者对方队列积压达到 steal_backlog (冷窃取, 由 worker 惰性创建 context;
+ *        steal_backlog = 0 时禁用)
+ * - 无任务可取的 worker 在调度器条件变量上睡眠, submit 时唤醒重新检查 (不轮询)
+ *
+ * 纯调度逻辑, 不依赖 RKNN。
+ */
+
+#include "infer_server/common/bounded_queue.h"
+#include "infer_server/common/types.h"
+#include "infer_server/inference/infer_task_queue.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <functional>
+
+namespace infer_server {
+
+class AffinityScheduler {
+public:
+    /// 判断 worker 是否可以直接处理该模型 (已有 context)
+    using CanStealFn = std::function<bool(const std::string& model_path)>;
+
+    /**
+     * @param num_workers    worker 数量
+     * @param queue_capacity 每个 worker 队列容量
+     * @param steal_backlog  积压达到该值时即使没有 context 也允许窃取 (0 = 仅热窃取)
+     * @param queue_mode     worker 队列实现 (互斥锁 / 无锁环形缓冲, 仅 FIFO 策略)
+     * @param policy         worker 队列调度策略 (FIFO / 按流公平)
+     */
+    AffinityScheduler(size_t num_workers, size_t queue_capacity, size_t steal_backlog = 0,
+                      QueueMode queue_mode = QueueMode::MUTEX,
+                      InferTaskQueue::Policy policy = InferTaskQueue::Policy::FIFO);
+
+    AffinityScheduler(const AffinityScheduler&) = delete;
+    AffinityScheduler& operator=(const AffinityScheduler&) = delete;
+
+    /// 为模型分配主 worker (已分配则直接返回)
+    int assign_model(const std::string& model_path);
+
+    /// 模型的主 worker, 未分配返回 -1
+    int home_worker(const std::string& model_path) const;
+
+    /// 取消模型的主 worker 分配 (模型卸载后调用, 该 worker 的负载计数随之减少)
+    void release_model(const std::string& model_path);
+
+    /// 提交任务到模型主 worker 的队列 (未分配的模型自动分配)
+    bool submit(InferTask task);
+
+    /**
+     * @brief worker 取任务
+     *
+     * 优先取自己的队列; 为空时按 can_steal / 积压条件从其他队列窃取。
+     * 都没有时睡眠到下一次 submit 或超时。
+     * @return 任务, 超时或已停止返回 nullopt
+     */
+    std::optional<InferTask> pop(int worker_id, std::chrono::milliseconds timeout,
+                                 const CanStealFn& can_steal);
+
+    /// worker 自己的队列 (批处理凑批时使用)
+    InferTaskQueue& queue(int worker_id) { return *queues_[worker_id]; }
+
+    /// 停止所有队列
+    void stop();
+
+    /// 清空所有队列
+    void clear();
+
+    /// 所有队列任务总数
+    size_t size() const;
+
+    /// 所有队列容量之和
+    size_t capacity() const;
+
+    /// 所有队列丢弃总数
+    size_t dropped_count() const;
+
+    /// 所有队列超时丢弃总数
+    size_t expired_count() const;
+
+    /// 所有队列挤出 + 超时丢弃的滑动窗口速率之和
+    RateMeter::Rates drop_rate() const;
+
+    /// 窃取成功次数
+    uint64_t steal_count() const { return steal_count_.load(std::memory_order_relaxed); }
+
+    size_t worker_count() const { return queues_.size(); }
+
+private:
+    std::optional<InferTask> try_steal(int worker_id, const CanStealFn& can_steal);
+
+    /// 唤醒空闲 worker 重新检查自己的队列与窃取条件
+    void notify_idle();
+
+    std::vector<std::unique_ptr<InferTaskQueue>> queues_;
+    size_t steal_backlog_;
+
+    mutable std::mutex assign_mutex_;
+    std::unordered_map<std::string, int> model_home_;
+    std::vector<int> models_per_worker_;
+
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    uint64_t submit_seq_ = 0;               ///< submit 计数 (idle_mutex_ 保护, 有空闲 worker 时才递增)
+    std::atomic<int> idle_waiters_{0};
+
+    std::atomic<bool> stopped_{false};
+    std::atomic<uint64_t> steal_count_{0};
+};
+
+} // namespace infer_server
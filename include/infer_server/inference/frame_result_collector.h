@@ -2,35 +2,51 @@
 
 /**
  * @file frame_result_collector.h
- * @brief 多模型推理结果聚合器 (header-only)
+ * @brief 多模型推理结果聚合器 (header-only, 无锁)
  *
  * 当一帧需要多个模型推理时 (如同时检测手机和吸烟),
  * 解码线程为该帧创建一个 FrameResultCollector,
  * 所有相关的 InferTask 共享同一个 Collector 指针。
  *
- * 多个 InferWorker 线程可并发调用 add_result(),
- * 当最后一个模型完成时, add_result() 返回完整的 FrameResult。
+ * 每个模型对应一个预分配的结果槽位 (槽位号 = 模型在 StreamConfig::models 中的下标),
+ * 输出顺序与配置顺序一致, 与各模型完成的先后无关。
+ * 多个 InferWorker 线程可并发调用 add_result(): 各自只写自己的槽位,
+ * 再对原子计数做一次 acq_rel 递减; 把计数减到 0 的线程 (唯一) 把完整的 FrameResult
+ * 移出返回, 全程不加锁、不拷贝检测结果。
+ *
+ * ROI / 分块推理时同一模型对应多个 InferTask (tile_count > 1),
+ * 提交前用 expect_tiles() 声明分块数, 各分块经 add_tile() 写入各自的分块槽位,
+ * 最后一块到达后跨块 NMS 合并为一个 ModelResult。
+ *
+ * 级联模型: 第二级模型不在整帧上推理, 由 set_stage_hook() 注册的回调在第一级
+ * 模型结果到达时按检测框裁剪并提交第二级任务 (同样汇入本聚合器);
+ * 没有可裁剪目标的第二级模型由回调直接返回空结果, 与第一级结果一起计入完成数。
  *
  * 用法:
  *   // 解码线程
  *   auto collector = std::make_shared<FrameResultCollector>(num_models, base_result);
- *   for (auto& model : models) {
+ *   for (size_t i = 0; i < models.size(); i++) {
  *       InferTask task;
+ *       task.binding = models[i].binding;
  *       task.aggregator = collector;
+ *       task.result_slot = static_cast<int>(i);
  *       queue.push(std::move(task));
  *   }
  *
  *   // InferWorker 线程
- *   auto* collector = static_cast<FrameResultCollector*>(task.aggregator.get());
- *   auto complete = collector->add_result(model_result);
+ *   auto complete = task.aggregator->add_result(task.result_slot, std::move(model_result));
  *   if (complete) {
  *       zmq_publisher.publish(*complete);
  *   }
  */
 
 #include "infer_server/common/types.h"
-#include <mutex>
+#include "infer_server/inference/post_processor.h"
+#include <algorithm>
 #include <atomic>
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -38,37 +54,110 @@ namespace infer_server {
 
 class FrameResultCollector {
 public:
+    /// 写入指定槽位的模型结果 (级联回调的返回值)
+    struct SlotResult {
+        int slot = 0;
+        ModelResult result;
+    };
+
+    /**
+     * @brief 模型结果回调 (级联模型)
+     *
+     * 每个模型的完整结果 (分块已合并) 计入之前调用, 在调用 add_result / add_tile 的线程执行。
+     * @return 需要立即计入的其他槽位结果 (如没有可裁剪目标、因此不再推理的第二级模型的空结果)
+     */
+    using StageHook = std::function<std::vector<SlotResult>(const ModelResult&)>;
+
     /**
      * @brief 构造聚合器
-     * @param total_models 需要等待的模型总数
+     * @param total_models 需要等待的模型总数 (槽位数)
      * @param base_result  基础帧信息 (cam_id, frame_id, timestamp 等)
      */
     FrameResultCollector(int total_models, FrameResult base_result)
         : total_models_(total_models)
         , result_(std::move(base_result))
+        , tiles_(std::make_unique<TileSlot[]>(static_cast<size_t>(std::max(total_models, 0))))
+        , remaining_(total_models)
     {
-        result_.results.reserve(total_models);
+        result_.results.resize(static_cast<size_t>(std::max(total_models, 0)));
     }
 
     // 禁止拷贝
     FrameResultCollector(const FrameResultCollector&) = delete;
     FrameResultCollector& operator=(const FrameResultCollector&) = delete;
 
+    /// 注册模型结果回调 (须在提交本帧任何 InferTask 之前调用)
+    void set_stage_hook(StageHook hook) { stage_hook_ = std::move(hook); }
+
     /**
-     * @brief 添加一个模型的推理结果 (线程安全)
+     * @brief 声明槽位的分块数 (须在提交该槽位的任何分块任务之前调用)
      *
+     * 每个槽位只能声明一次; 各分块经 add_tile() 按 tile_index 写入。
+     */
+    void expect_tiles(int slot, int tile_count) {
+        auto& tile = tiles_[static_cast<size_t>(slot)];
+        tile.parts.resize(static_cast<size_t>(tile_count));
+        tile.remaining.store(tile_count, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 写入一个模型的推理结果 (线程安全, 每个槽位只写一次)
+     *
+     * @param slot         模型槽位 (0 <= slot < total_models)
      * @param model_result 单个模型的推理结果
-     * @return 当所有模型都完成时，返回完整的 FrameResult；否则返回 nullopt
+     * @return 当所有模型都完成时, 返回完整的 FrameResult (只返回给一个调用方); 否则返回 nullopt
      */
-    std::optional<FrameResult> add_result(ModelResult model_result) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        result_.results.push_back(std::move(model_result));
-        int completed = completed_.fetch_add(1, std::memory_order_relaxed) + 1;
+    std::optional<FrameResult> add_result(int slot, ModelResult model_result) {
+        note_arrival();
+        std::vector<SlotResult> extra;
+        if (stage_hook_) extra = stage_hook_(model_result);
 
-        if (completed == total_models_) {
-            return result_;
+        result_.results[static_cast<size_t>(slot)] = std::move(model_result);
+        for (auto& sr : extra) {
+            result_.results[static_cast<size_t>(sr.slot)] = std::move(sr.result);
         }
-        return std::nullopt;
+        return count_completed(static_cast<int>(extra.size()) + 1);
+    }
+
+    /**
+     * @brief 写入一个模型的单个分块结果 (线程安全)
+     *
+     * 槽位的分块 (数量由 expect_tiles() 声明) 全部到达后, 按分块顺序合并检测框并做跨块 NMS
+     * (按类别, IoU 阈值 nms_threshold), 推理耗时取各块之和, 然后按一个模型计入完成数。
+     *
+     * @param slot           模型槽位
+     * @param tile_index     分块下标 (0 <= tile_index < 声明的分块数)
+     * @param tile_result    单个分块的推理结果 (检测框已映射到原图坐标)
+     * @param nms_threshold  跨块 NMS 的 IoU 阈值
+     * @return 同 add_result()
+     */
+    std::optional<FrameResult> add_tile(int slot, int tile_index, ModelResult tile_result,
+                                        float nms_threshold) {
+        note_arrival();
+        auto& tile = tiles_[static_cast<size_t>(slot)];
+        tile.parts[static_cast<size_t>(tile_index)] = std::move(tile_result);
+        if (tile.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return std::nullopt;
+        }
+
+        // 最后一块已到达, 其余线程不会再访问该槽位的分块
+        ModelResult merged;
+        size_t total_dets = 0;
+        for (const auto& part : tile.parts) total_dets += part.detections.size();
+        merged.detections.reserve(total_dets);
+        for (auto& part : tile.parts) {
+            if (merged.task_name.empty()) merged.task_name = std::move(part.task_name);
+            if (merged.model_path.empty()) merged.model_path = std::move(part.model_path);
+            merged.inference_time_ms += part.inference_time_ms;
+            merged.compute_ms += part.compute_ms;
+            merged.detections.insert(merged.detections.end(),
+                                     std::make_move_iterator(part.detections.begin()),
+                                     std::make_move_iterator(part.detections.end()));
+        }
+        std::vector<ModelResult>().swap(tile.parts);
+
+        PostProcessor::nms(merged.detections, nms_threshold);
+        return add_result(slot, std::move(merged));
     }
 
     /// 模型总数
@@ -76,19 +165,47 @@ public:
 
     /// 已完成的模型数
     int completed_count() const {
-        return completed_.load(std::memory_order_relaxed);
+        return total_models_ - std::max(remaining_.load(std::memory_order_acquire), 0);
     }
 
     /// 是否已全部完成
     bool is_complete() const {
-        return completed_.load(std::memory_order_relaxed) >= total_models_;
+        return remaining_.load(std::memory_order_acquire) <= 0;
     }
 
 private:
+    /// 计入 n 个已写入槽位的模型结果; 计数归零的调用方取走结果
+    std::optional<FrameResult> count_completed(int n) {
+        // release: 本线程写入的槽位对完成者可见; acquire: 完成者看到其他线程写入的槽位
+        if (remaining_.fetch_sub(n, std::memory_order_acq_rel) == n) {
+            if (result_.counters) {
+                result_.counters->latency.record(
+                    LatencyStage::Aggregate, mono_now_ns() - first_arrival_ns_.load(std::memory_order_relaxed));
+            }
+            return std::move(result_);
+        }
+        return std::nullopt;
+    }
+
+    /// 记录第一个结果 (分块) 到达的时间, 整帧完成时计入 Aggregate 阶段
+    void note_arrival() {
+        if (first_arrival_ns_.load(std::memory_order_relaxed) != 0) return;
+        int64_t expected = 0;
+        first_arrival_ns_.compare_exchange_strong(expected, mono_now_ns(), std::memory_order_relaxed);
+    }
+
+    /// 一个槽位的分块结果
+    struct TileSlot {
+        std::vector<ModelResult> parts;     ///< 按 tile_index 存放
+        std::atomic<int> remaining{0};      ///< 尚未到达的分块数
+    };
+
     int total_models_;
-    FrameResult result_;
-    std::atomic<int> completed_{0};
-    std::mutex mutex_;
+    StageHook stage_hook_;
+    FrameResult result_;                    ///< results 预分配 total_models 个槽位
+    std::unique_ptr<TileSlot[]> tiles_;     ///< 每个槽位的分块状态
+    std::atomic<int> remaining_;            ///< 尚未完成的模型数
+    std::atomic<int64_t> first_arrival_ns_{0};  ///< 第一个结果到达的时间 (steady_clock 纳秒)
 };
 
 } // namespace infer_server
@@ -0,0 +1,158 @@
+#pragma once
+
+/**
+ * @file infer_task_queue.h
+ * @brief 推理任务队列 (FIFO / 按流加权公平)
+ *
+ * 单一 FIFO + 丢弃最旧时, 几路 25fps / frame_skip=1 的高帧率流会把低帧率流的任务挤出队列,
+ * 全局 dropped_count() 也看不出是谁在丢帧。InferTaskQueue 提供两种策略:
+ *
+ * - FIFO: 直接使用 BoundedQueue (可选无锁实现), 行为与之前相同
+ * - FAIR: 按 cam_id 分流的 Deficit Round Robin:
+ *     * 每路流一个子队列, 轮转调度, 每轮可取 quantum 个任务
+ *       (quantum 由优先级决定: critical = 4, normal = 2, best_effort = 1)
+ *     * 队列满时从 "最低优先级中积压最多" 的流挤出最旧任务;
+ *       新任务本身最该被丢弃时 (比所有排队任务优先级都低) 直接丢弃新任务
+ *     * 高帧率流只会挤掉自己的旧任务, 不会饿死低帧率流
+ *
+ * 两种策略共用:
+ * - deadline: 任务排队超过 ModelBinding::deadline_ms 时在出队时丢弃 (不再占用 NPU)
+ * - 按流统计: 挤出 / 超时的任务计入所属流的 StreamCounters (infer_dropped / infer_expired)
+ *
+ * 纯调度逻辑, 不依赖 RKNN。
+ */
+
+#include "infer_server/common/bounded_queue.h"
+#include "infer_server/common/types.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <functional>
+
+namespace infer_server {
+
+class InferTaskQueue {
+public:
+    /// 调度策略
+    enum class Policy {
+        FIFO,       ///< 全局先进先出 (满时丢弃最旧)
+        FAIR        ///< 按 cam_id 加权公平 (DRR) + 优先级挤出
+    };
+
+    using Pred = std::function<bool(const InferTask&)>;
+
+    /**
+     * @param capacity 最大任务数 (必须 > 0)
+     * @param mode     FIFO 策略下 BoundedQueue 的实现 (FAIR 策略固定使用互斥锁)
+     * @param policy   调度策略
+     */
+    explicit InferTaskQueue(size_t capacity, QueueMode mode = QueueMode::MUTEX,
+                            Policy policy = Policy::FIFO);
+
+    InferTaskQueue(const InferTaskQueue&) = delete;
+    InferTaskQueue& operator=(const InferTaskQueue&) = delete;
+
+    /// 推入任务 (记录 enqueue_time); 满时按策略丢弃一个任务
+    /// @return false 队列已停止
+    bool push(InferTask task);
+
+    /// 阻塞弹出, 带超时 (跳过并丢弃已超时的任务)
+    std::optional<InferTask> pop(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+
+    /// 非阻塞弹出
+    std::optional<InferTask> try_pop();
+
+    /// 按条件弹出第一个满足 pred 的任务, 没有时等待到 deadline
+    std::optional<InferTask> pop_if(const Pred& pred, std::chrono::steady_clock::time_point deadline);
+
+    /// 当前任务数 (FIFO 无锁模式为近似值)
+    size_t size() const;
+
+    bool empty() const { return size() == 0; }
+
+    size_t capacity() const { return capacity_; }
+
+    QueueMode mode() const { return fifo_.mode(); }
+
+    Policy policy() const { return policy_; }
+
+    /// 队列满时丢弃的任务数
+    size_t dropped_count() const;
+
+    /// 排队超过 deadline 被丢弃的任务数
+    size_t expired_count() const { return expired_.load(std::memory_order_relaxed); }
+
+    /// 挤出 + 超时丢弃的滑动窗口速率 (次/秒)
+    RateMeter::Rates drop_rate() const { return drop_rate_.rates(); }
+
+    /// 当前排队的流数量 (仅 FAIR 策略)
+    size_t flow_count() const;
+
+    bool is_stopped() const { return stopped_.load(); }
+
+    /// 停止队列 (唤醒所有等待的 pop, 拒绝后续 push)
+    void stop();
+
+    /// 清空队列内容 (不改变 stopped 状态)
+    void clear();
+
+    /// 重置队列 (清空内容 + 取消停止状态 + 清零统计)
+    void reset();
+
+    /// 优先级对应的 DRR quantum
+    static int quantum(TaskPriority priority);
+
+    /// 解析策略字符串 ("fifo" / "fair"), 未知取值返回 false
+    static bool parse_policy(const std::string& name, Policy& out);
+
+private:
+    /// 每路流的子队列
+    struct Flow {
+        std::string key;
+        TaskPriority priority = TaskPriority::Normal;
+        std::deque<InferTask> tasks;
+        int deficit = 0;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    static bool is_expired(const InferTask& task, Clock::time_point now);
+    void count_dropped(const InferTask& task);
+    void count_expired(const InferTask& task);
+
+    // FAIR 策略实现 (调用方持有 mutex_, 被丢弃的任务移入 garbage, 在锁外释放)
+    void purge_expired_locked(Flow& flow, Clock::time_point now, std::vector<InferTask>& garbage);
+    void evict_locked(InferTask& incoming, bool& drop_incoming, std::vector<InferTask>& garbage);
+    std::optional<InferTask> fair_take_locked(const Pred* pred, std::vector<InferTask>& garbage);
+    void erase_flow_locked(size_t round_index);
+
+    std::optional<InferTask> fair_pop(const Pred* pred, Clock::time_point deadline);
+    std::optional<InferTask> fifo_pop(const Pred* pred, Clock::time_point deadline);
+
+    size_t capacity_;
+    Policy policy_;
+
+    // FIFO
+    BoundedQueue<InferTask> fifo_;
+
+    // FAIR (mutex_ 保护)
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_cv_;
+    std::unordered_map<std::string, Flow> flows_;   ///< 只保存非空的流
+    std::deque<Flow*> round_;                       ///< DRR 轮转顺序 (队首为当前服务的流)
+    size_t fair_size_ = 0;
+
+    std::atomic<bool> stopped_{false};
+    std::atomic<size_t> dropped_{0};                ///< FAIR 策略的丢弃计数 (FIFO 使用 fifo_ 的计数)
+    std::atomic<size_t> expired_{0};
+    RateMeter drop_rate_;                           ///< 挤出 + 超时 (两种策略共用)
+};
+
+} // namespace infer_server
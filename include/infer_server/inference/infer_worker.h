@@ -5,12 +5,32 @@
  * @brief NPU 推理工作线程
  *
  * 每个 InferWorker 运行在独立线程中, 绑定一个 NPU 核心:
- * 1. 从全局 BoundedQueue<InferTask> 竞争消费任务
+ * 1. 从全局 InferTaskQueue 竞争消费任务
+ *    (affinity 调度模式: 消费自己的队列, 空闲时经 AffinityScheduler 窃取)
  * 2. 使用 ModelManager 惰性创建 rknn_context
  * 3. 执行推理: rknn_inputs_set -> rknn_run -> rknn_outputs_get
+ *    (零拷贝模式: rknn_create_mem_from_fd + rknn_set_io_mem 绑定 RGA 输出)
  * 4. 调用 PostProcessor 进行 YOLO 后处理
+ *    (INT8 输出模型: want_float=0 取原始量化输出, PostProcessor::process_int8 在量化域过滤)
  * 5. 通过 FrameResultCollector 聚合多模型结果
  * 6. 当帧的所有模型完成时, 调用 on_complete 回调
+ *
+ * 动态批处理 (ModelConfig::max_batch > 1 且模型以 batch > 1 编译):
+ * 在 batch_wait_ms 窗口内从队列收集同一模型的任务, 拼接为一次 rknn_run,
+ * 再按样本拆分输出分发给各自的 FrameResultCollector。
+ *
+ * 流水线 (pipeline_depth > 1):
+ * rknn_outputs_get 以 is_prealloc 方式写入 worker 自己的输出缓冲 (每个在途任务一组),
+ * 后处理与结果聚合交给本 worker 的后处理线程, NPU 线程立即开始下一个任务的推理。
+ * 在途任务数达到 pipeline_depth 时 NPU 线程等待后处理线程 (不丢弃任务)。
+ * pipeline_depth <= 1 时在 NPU 线程串行后处理 (旧行为)。
+ *
+ * 持久 I/O 绑定 (io_binding = true):
+ * 每个模型 context 首次推理时创建一次输入 tensor 与 pipeline_depth 组输出 tensor
+ * (rknn_create_mem), 之后只在切换时调用 rknn_set_io_mem。拷贝模式把输入写入绑定的
+ * tensor, 零拷贝模式按 DmaBuffer::id 缓存 fd 导入; rknn_run 直接写出到绑定的输出,
+ * 稳态推理路径不再有 rknn_inputs_set / rknn_outputs_get 和内存分配。
+ * 创建失败的模型自动回退到 rknn_inputs_set + rknn_outputs_get(is_prealloc)。
  */
 
 #ifdef HAS_RKNN
@@ -18,13 +38,20 @@
 #include "infer_server/inference/model_manager.h"
 #include "infer_server/inference/post_processor.h"
 #include "infer_server/inference/frame_result_collector.h"
+#include "infer_server/inference/affinity_scheduler.h"
 #include "infer_server/common/types.h"
-#include "infer_server/common/bounded_queue.h"
+#include "infer_server/inference/infer_task_queue.h"
+#include "infer_server/common/buffer_pool.h"
 #include <string>
 #include <unordered_map>
 #include <functional>
+#include <memory>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
 #include <vector>
 
 namespace infer_server {
@@ -40,13 +67,23 @@ public:
      * @param worker_id   工作线程 ID (0, 1, 2, ...)
      * @param core_mask   NPU 核心掩码 (NpuCoreMask::CORE_0 等)
      * @param model_mgr   模型管理器引用 (共享)
-     * @param task_queue   全局推理任务队列引用 (共享)
+     * @param task_queue   推理任务队列引用 (共享模式为全局队列, affinity 模式为本 worker 队列)
      * @param on_complete  帧结果完成回调
+     * @param zero_copy    是否通过 rknn_set_io_mem 直接绑定输入 DMA-BUF
+     * @param scheduler    affinity 调度器 (nullptr = 共享队列模式)
+     * @param int8_postprocess  INT8 输出模型跳过 RKNN 反量化, 在量化域后处理
+     * @param pipeline_depth    每个 worker 的在途任务数 (<= 1 = 在 NPU 线程串行后处理)
+     * @param io_binding        为每个模型 context 预分配并绑定持久输入 / 输出 tensor
      */
     InferWorker(int worker_id, int core_mask,
                 ModelManager& model_mgr,
-                BoundedQueue<InferTask>& task_queue,
-                OnCompleteCallback on_complete);
+                InferTaskQueue& task_queue,
+                OnCompleteCallback on_complete,
+                bool zero_copy = false,
+                AffinityScheduler* scheduler = nullptr,
+                bool int8_postprocess = false,
+                int pipeline_depth = 1,
+                bool io_binding = false);
 
     ~InferWorker();
 
@@ -57,7 +94,7 @@ public:
     /// 启动工作线程
     void start();
 
-    /// 停止工作线程 (等待当前任务完成)
+    /// 停止工作线程 (等待当前任务及后处理队列中的任务完成)
     void stop();
 
     /// 是否正在运行
@@ -66,41 +103,252 @@ public:
     /// Worker ID
     int worker_id() const { return worker_id_; }
 
+    /// NPU 核心掩码
+    int core_mask() const { return core_mask_; }
+
     /// 已处理的任务计数
     uint64_t processed_count() const { return processed_count_.load(std::memory_order_relaxed); }
 
-    /// 预创建模型的 rknn_context (在流启动前调用，避免与 RGA 并发导致硬件冲突)
+    /// 处理任务的滑动窗口速率 (次/秒; 每个 worker 单独计数, 引擎汇总)
+    RateMeter::Rates processed_rate() const { return processed_rate_.rates(); }
+
+    /// 已执行的批次数 (仅批处理路径)
+    uint64_t batch_count() const { return batch_count_.load(std::memory_order_relaxed); }
+
+    /// 批处理路径处理的任务数
+    uint64_t batched_task_count() const { return batched_tasks_.load(std::memory_order_relaxed); }
+
+    /// 批处理路径的总槽位数 (每批的容量之和), 填充率 = batched_task_count / batch_slot_count
+    uint64_t batch_slot_count() const { return batch_slots_.load(std::memory_order_relaxed); }
+
+    /// 流水线深度 (1 = 串行)
+    int pipeline_depth() const { return pipeline_depth_; }
+
+    /// NPU 累计忙碌时间 (微秒): 输入设置 -> rknn_run -> rknn_outputs_get
+    uint64_t npu_busy_us() const { return npu_busy_ns_.load(std::memory_order_relaxed) / 1000; }
+
+    /// 自启动以来的 NPU 利用率 (忙碌时间 / 运行时间, 0~1)
+    double npu_utilization() const;
+
+    /// 预创建模型的 rknn_context (模型加载阶段调用, 避免在推理线程上惰性创建)
+    /// 可从多个加载线程并发调用; rknn_init 期间 RGA job 暂停 (RgaScheduler::begin_npu_init())
     bool pre_create_context(const std::string& model_path);
 
+    /// 已持有 context 的模型数
+    size_t context_count() const { return context_count_.load(std::memory_order_relaxed); }
+
+    /// 是否已持有模型的 context (窃取判定 / 卸载等待)
+    bool has_context(const std::string& model_path) const;
+
+    /**
+     * @brief 请求释放模型的 I/O 绑定与 context (模型热切换后卸载旧模型时调用)
+     *
+     * 只登记请求, 由 NPU 线程在任务间隙执行: 该模型的后处理槽位全部归还后
+     * 销毁 I/O 绑定并调用 ModelManager::release_worker_context; 仍有在途任务时顺延到下一轮。
+     * 调用方通过 has_context() 等待完成, 且须保证之后不再提交该模型的任务。
+     */
+    void release_model(const std::string& model_path);
+
 private:
+    using Clock = std::chrono::steady_clock;
+
+    struct IoBinding;
+
+    /**
+     * @brief 一次 rknn_run 的输出, 等待后处理 (单任务或一个批)
+     *
+     * 每个模型 context 预分配 pipeline_depth 个槽位, 稳态下循环复用 (容器容量保留)。
+     */
+    struct PostJob {
+        IoBinding* owner = nullptr;
+        std::vector<InferTask> tasks;
+        std::vector<rknn_tensor_mem*> out_mems;     ///< 本槽位绑定的输出 tensor (io 绑定可用时)
+        std::vector<BufferPool::Buffer> buffers;    ///< 回退路径: rknn_outputs_get 的预分配缓冲
+        std::vector<rknn_output> rknn_outputs;      ///< 回退路径: rknn_outputs_get 参数
+        std::vector<void*> outputs;                 ///< 各输出 tensor 的数据起始地址
+        std::vector<std::vector<Detection>> detections;   ///< 每个任务的后处理结果
+        const std::vector<TensorAttr>* attrs = nullptr;   ///< 单样本 tensor 属性 (ModelInfo 缓存)
+        int batch_dim = 1;
+        Clock::time_point t_start;
+        Clock::time_point t_infer_done;
+    };
+
+    /// 一个模型 context 的 I/O 绑定与后处理槽位 (NPU 线程创建, stop() 后释放)
+    struct IoBinding {
+        rknn_context ctx = 0;
+        const ModelInfo* info = nullptr;
+        bool int8 = false;                          ///< 输出走 INT8 后处理 (want_float = 0)
+        bool bound = false;                         ///< 持久 tensor 可用, 走 rknn_set_io_mem 路径
+        rknn_tensor_mem* input = nullptr;           ///< 持久输入 tensor
+        rknn_tensor_mem* bound_input = nullptr;     ///< 当前绑定到 context 的输入
+        PostJob* bound_outputs = nullptr;           ///< 当前绑定到 context 的输出所属槽位
+        std::vector<std::unique_ptr<PostJob>> slots;
+        std::vector<PostJob*> free_slots;           ///< 以 post_mutex_ 保护
+        struct Import {
+            rknn_tensor_mem* mem = nullptr;
+            uint64_t last_use = 0;                  ///< 最近一次命中的序号 (LRU 淘汰)
+        };
+        std::unordered_map<uint64_t, Import> imports;   ///< 零拷贝: DmaBuffer::id -> 导入的 tensor
+        uint64_t import_seq = 0;
+    };
+
+    /// 零拷贝导入缓存上限, 超出时淘汰最久未用的导入
+    static constexpr size_t kMaxImports = 32;
+
     /// 主循环
     void run();
 
+    /// 后处理线程主循环 (pipeline_depth > 1)
+    void post_loop();
+
     /// 处理单个推理任务
     void process_task(InferTask& task);
 
+    /// 批量处理同一模型的多个任务 (一次 rknn_run), 任务被移入后处理 job
+    void process_batch(std::vector<InferTask>& tasks);
+
+    /// 获取模型的 I/O 绑定 (首次调用时创建 context 侧的持久 tensor 与后处理槽位)
+    IoBinding* get_io_binding(const InferTask& task);
+
+    /// 创建持久输入 / 输出 tensor, 失败时销毁已创建部分并返回 false
+    bool create_io_tensors(IoBinding& io);
+
+    /// 释放 I/O 绑定持有的全部 tensor
+    void destroy_io_binding(IoBinding& io);
+
+    /// 取一个空闲槽位 (在途任务数受 pipeline_depth 限制, 正常情况下总能取到)
+    /// 当前输出已绑定到 context 的槽位空闲时优先取它, 避免重新 rknn_set_io_mem
+    PostJob* acquire_slot(IoBinding& io);
+
+    /// 归还槽位 (清空任务与回退缓冲, 保留容量)
+    void release_slot(PostJob* job);
+
+    /**
+     * @brief 设置输入: 绑定路径写入 / 导入持久 tensor, 回退路径走原有接口
+     * @param sample 批处理时的样本下标 (绑定路径按样本偏移写入)
+     * @return false 失败; temp_mem 返回需在推理后销毁的临时导入 tensor
+     */
+    bool bind_input(IoBinding& io, const InferTask& task, rknn_tensor_mem*& temp_mem);
+
+    /// 绑定路径: 把一个样本拷贝到持久输入 tensor (处理行步长)
+    bool write_input_sample(IoBinding& io, const InferTask& task, size_t sample);
+
+    /// 绑定路径: 把 mem 绑定为 context 的输入 (与当前绑定相同时跳过)
+    bool set_input_mem(IoBinding& io, rknn_tensor_mem* mem);
+
+    /// 绑定路径: 把 job 的输出 tensor 绑定到 context (与当前绑定相同时跳过)
+    bool set_output_mems(IoBinding& io, PostJob& job);
+
+    /**
+     * @brief 推理完成后取出输出到 job.outputs
+     *
+     * 绑定路径: 同步输出 tensor 的 CPU cache; 回退路径: rknn_outputs_get(is_prealloc)
+     * 写入 job.buffers。两种方式取出后 context 都可立即开始下一次 rknn_run。
+     */
+    bool fetch_outputs(IoBinding& io, PostJob& job);
+
+    /// 交给后处理: 串行模式直接执行, 流水线模式入队 (在途任务达到上限时等待)
+    void submit_post(PostJob* job);
+
+    /// 后处理一个 job 并分发结果
+    void run_post_job(PostJob& job);
+
+    /// 累加 NPU 忙碌时间
+    void add_npu_busy(Clock::time_point t_start, Clock::time_point t_end);
+
+    /// 构造 ModelResult, 聚合并在帧完成时回调
+    void finish_task(InferTask& task, std::vector<Detection> detections, double total_ms, double compute_ms);
+
+    /// 模型输出是否走 INT8 后处理 (决定 rknn_output::want_float)
+    bool use_int8_output(const InferTask& task, const std::vector<TensorAttr>& attrs) const;
+
+    /**
+     * @brief 对一个样本的输出做后处理
+     * @param outputs  各输出 tensor 的数据起始地址 (int8 = true 时为原始 INT8 数据)
+     * @param attrs    单样本的 tensor 属性
+     * @param sample   batch 内样本下标 (输出按 attrs[i].n_elems 偏移)
+     */
+    std::vector<Detection> post_process(const InferTask& task,
+                                        const std::vector<void*>& outputs,
+                                        const std::vector<TensorAttr>& attrs,
+                                        size_t sample, bool int8) const;
+
+    /// 任务可用的批大小: min(max_batch, 模型 batch 维度)
+    int batch_capacity(const InferTask& task) const;
+
+    /// 设置输入 (回退路径, 拷贝模式: rknn_inputs_set)
+    bool set_input_copy(rknn_context ctx, const InferTask& task);
+
+    /// 设置输入 (回退路径, 零拷贝模式: rknn_set_io_mem), 返回绑定的 tensor mem
+    /// 调用方在 rknn_outputs_get 之后通过 rknn_destroy_mem 释放
+    rknn_tensor_mem* set_input_zero_copy(rknn_context ctx, const ModelInfo& info,
+                                         const InferTask& task);
+
+    /// 零拷贝导入: 按 DmaBuffer::id 复用已导入的 tensor (id = 0 时返回 nullptr)
+    rknn_tensor_mem* import_input(IoBinding& io, const DmaBuffer& dma);
+
     /// 获取或创建模型的 rknn_context (惰性创建)
     rknn_context get_or_create_context(const std::string& model_path);
 
-    /// 释放所有持有的 context
+    /// 登记锁外创建的 context; 已有同一模型的 context 时释放 ctx, 返回登记的那一份
+    rknn_context adopt_context(const std::string& model_path, rknn_context ctx);
+
+    /// 释放所有 I/O 绑定与持有的 context
     void release_all_contexts();
 
+    /// NPU 线程: 执行 release_model() 登记的释放请求 (有在途任务的模型留待下一轮)
+    void process_releases();
+
+    /// NPU 线程: 释放单个模型, 后处理槽位未全部归还时返回 false
+    bool try_release_model(const std::string& model_path);
+
     /// 加载标签文件
     static std::vector<std::string> load_labels(const std::string& labels_file);
 
     int worker_id_;
     int core_mask_;
     ModelManager& model_mgr_;
-    BoundedQueue<InferTask>& task_queue_;
+    InferTaskQueue& task_queue_;
     OnCompleteCallback on_complete_;
+    bool zero_copy_;
+    AffinityScheduler* scheduler_;
+    bool int8_postprocess_;
+    int pipeline_depth_;
+    bool io_binding_;
 
     std::thread thread_;
     std::atomic<bool> running_{false};
     std::atomic<bool> stop_requested_{false};
     std::atomic<uint64_t> processed_count_{0};
+    RateMeter processed_rate_;
+    std::atomic<uint64_t> batch_count_{0};
+    std::atomic<uint64_t> batched_tasks_{0};
+    std::atomic<uint64_t> batch_slots_{0};
+    std::atomic<size_t> context_count_{0};
+    std::atomic<uint64_t> npu_busy_ns_{0};
+    std::atomic<int64_t> started_at_ns_{0};     ///< start() 时刻 (steady_clock)
+
+    /// 后处理队列 (NPU 线程 -> 后处理线程)
+    /// post_inflight_ = 排队 + 正在处理的 job 数, 上限 pipeline_depth_ - 1 (另一个在 NPU 上)
+    std::thread post_thread_;
+    std::deque<PostJob*> post_jobs_;
+    size_t post_inflight_ = 0;
+    bool post_stop_ = false;
+    std::mutex post_mutex_;
+    std::condition_variable post_cv_;
 
     /// 每个模型路径对应一个 rknn_context (惰性创建)
+    /// pre_create_context 在控制线程调用, 其余在 worker 线程, 以 contexts_mutex_ 保护
     std::unordered_map<std::string, rknn_context> contexts_;
+    mutable std::mutex contexts_mutex_;
+
+    /// 每个模型 context 的 I/O 绑定 (只在 NPU 线程访问, stop() 中线程退出后释放)
+    std::unordered_map<std::string, std::unique_ptr<IoBinding>> io_bindings_;
+
+    /// 待释放的模型 (release_model() 登记, NPU 线程处理)
+    std::vector<std::string> pending_releases_;
+    std::atomic<bool> release_pending_{false};
+    std::mutex release_mutex_;
 };
 
 } // namespace infer_server
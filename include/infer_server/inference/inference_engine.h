@@ -6,12 +6,15 @@
  *
  * InferenceEngine 是 Phase 3 的核心编排组件:
  * - 拥有 ModelManager (模型生命周期)
- * - 拥有 BoundedQueue<InferTask> (全局推理任务队列)
+ * - 拥有 InferTaskQueue (全局推理任务队列, FIFO 或按流公平, infer_scheduler = "shared")
+ *   或 AffinityScheduler (每 worker 队列 + 模型亲和 + 窃取, infer_scheduler = "affinity")
  * - 拥有 N 个 InferWorker (NPU 推理线程)
+ * - 拥有 ResultDispatcher (输出线程: 序列化 / ZMQ 发布 / 结果回调, 不占用 NPU 线程)
  * - 拥有 ZmqPublisher (结果发布)
  *
  * 对外暴露简单接口:
- * - load_models(): 预加载模型
+ * - load_models() / load_models_async(): 并行预加载模型 (阻塞 / 后台)
+ * - unload_model(): 运行时卸载模型 (模型热切换)
  * - submit(): 提交推理任务
  * - shutdown(): 优雅关闭
  *
@@ -22,9 +25,11 @@
 
 #include "infer_server/common/config.h"
 #include "infer_server/common/types.h"
-#include "infer_server/common/bounded_queue.h"
+#include "infer_server/inference/infer_task_queue.h"
 #include "infer_server/inference/model_manager.h"
 #include "infer_server/inference/infer_worker.h"
+#include "infer_server/inference/affinity_scheduler.h"
+#include "infer_server/output/result_dispatcher.h"
 
 #ifdef HAS_ZMQ
 #include "infer_server/output/zmq_publisher.h"
@@ -35,6 +40,10 @@
 #include <string>
 #include <functional>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
 
 namespace infer_server {
 
@@ -43,6 +52,23 @@ public:
     /// 外部结果回调 (除了 ZMQ 发布外的额外回调)
     using ResultCallback = std::function<void(const FrameResult&)>;
 
+    /// 单个 worker 的统计信息
+    struct WorkerStats {
+        int worker_id = 0;
+        int core_mask = 0;
+        uint64_t processed = 0;         ///< 已处理任务数
+        uint64_t npu_busy_us = 0;       ///< NPU 累计忙碌时间 (微秒)
+        double npu_utilization = 0.0;   ///< 自启动以来的 NPU 利用率 (0~1)
+    };
+
+    /// 模型加载统计
+    struct ModelLoadStats {
+        size_t loading = 0;             ///< 加载或预创建 context 中的模型数
+        size_t ready = 0;               ///< 已就绪的模型数
+        size_t failed = 0;              ///< 加载失败的模型数
+        double warmup_ms = 0.0;         ///< 最近一批模型从开始加载到就绪的耗时
+    };
+
     /**
      * @brief 构造推理引擎
      * @param config 服务器配置
@@ -62,27 +88,63 @@ public:
     bool init();
 
     /**
-     * @brief 预加载模型列表
+     * @brief 预加载模型列表 (阻塞至全部结束)
      *
-     * 通常在添加流时调用, 确保流引用的所有模型已加载。
-     * 已加载的模型不会重复加载。
+     * 各模型的文件映射 + rknn_init 并行执行, 随后所有 (模型, worker) 的 context 并行预创建,
+     * 并行度为 CPU 核数。已加载 / 正在由其他调用加载的模型不会重复加载 (等待其结束)。
      *
      * @param models 模型配置列表
      * @return true 所有模型加载成功
      */
     bool load_models(const std::vector<ModelConfig>& models);
 
+    /**
+     * @brief 在后台线程预加载模型列表 (不阻塞)
+     *
+     * 添加流时调用: 流立即开始解码, 模型就绪前不提交推理 (见 models_ready())。
+     * 所有调用共用一个加载线程, 排队期间的请求合并为一批加载。
+     * rknn_init 期间 RGA job 暂停 (RgaScheduler::begin_npu_init()), 已运行的流预处理会短暂等待。
+     * affinity 主 worker 在调用线程按配置顺序分配, 与加载完成顺序无关。
+     */
+    void load_models_async(const std::vector<ModelConfig>& models);
+
+    /// 列表中的模型是否都已结束加载 (成功或失败; 失败模型的任务由 worker 照常丢弃)
+    bool models_ready(const std::vector<ModelConfig>& models) const;
+
+    /// 模型加载统计
+    ModelLoadStats model_load_stats() const;
+
+    /**
+     * @brief 卸载模型 (热切换后释放旧模型)
+     *
+     * 请求所有 worker 释放该模型的 I/O 绑定与 context (在任务间隙执行),
+     * 全部释放后销毁主 context 并取消 affinity 主 worker 分配。
+     * 调用方须保证已没有排队 / 在途的该模型任务, 且之后不再提交。
+     *
+     * @param timeout_ms 等待 worker 释放的最长时间
+     * @return false 超时 (worker 稍后仍会释放各自的 context, 主 context 保留到关闭)
+     */
+    bool unload_model(const std::string& model_path, int timeout_ms = 5000);
+
     /**
      * @brief 提交推理任务
      *
-     * 将 InferTask 推入全局有界队列。
+     * 将 InferTask 推入全局有界队列 (affinity 模式为模型主 worker 的队列)。
      * 如果队列已满, 最旧的任务会被丢弃。
      *
      * @param task 推理任务
-     * @return true 提交成功 (false 仅在引擎未初始化或已停止时)
+     * @return true 提交成功 (false: 引擎未初始化/已停止, 或 task.binding 为空)
      */
     bool submit(InferTask task);
 
+    /**
+     * @brief 直接输出一帧结果 (不经过 NPU)
+     *
+     * 用于运动门控转发的上一次结果、全部由跟踪器外推的帧等,
+     * 与推理结果走同一跟踪阶段和输出阶段 (ZMQ / 结果回调)。
+     */
+    void publish(FrameResult result) { on_result_complete(std::move(result)); }
+
     /**
      * @brief 优雅关闭引擎
      *
@@ -94,6 +156,7 @@ public:
      * @brief 设置额外的结果回调
      *
      * 除了 ZMQ 发布外, 还可以设置额外回调 (如统计、日志等)。
+     * output_threads > 0 时回调在输出线程执行, 不应长时间阻塞。
      */
     void set_result_callback(ResultCallback cb) { result_callback_ = std::move(cb); }
 
@@ -102,11 +165,44 @@ public:
     /// 引擎是否已初始化
     bool is_initialized() const { return initialized_.load(); }
 
-    /// 任务队列当前大小
-    size_t queue_size() const { return task_queue_.size(); }
+    /// 任务队列当前大小 (affinity 模式为所有 worker 队列之和)
+    size_t queue_size() const {
+        return scheduler_ ? scheduler_->size() : task_queue_.size();
+    }
+
+    /// 任务队列容量 (affinity 模式为所有 worker 队列之和)
+    size_t queue_capacity() const {
+        return scheduler_ ? scheduler_->capacity() : task_queue_.capacity();
+    }
 
     /// 任务队列丢弃计数
-    size_t queue_dropped() const { return task_queue_.dropped_count(); }
+    size_t queue_dropped() const {
+        return scheduler_ ? scheduler_->dropped_count() : task_queue_.dropped_count();
+    }
+
+    /// 排队超过 deadline 被丢弃的任务数
+    size_t queue_expired() const {
+        return scheduler_ ? scheduler_->expired_count() : task_queue_.expired_count();
+    }
+
+    /// 任务队列挤出 + 超时丢弃的滑动窗口速率 (次/秒)
+    RateMeter::Rates queue_drop_rate() const {
+        return scheduler_ ? scheduler_->drop_rate() : task_queue_.drop_rate();
+    }
+
+    /// 任务队列调度策略 ("fifo" / "fair")
+    const char* queue_policy() const {
+        return task_queue_.policy() == InferTaskQueue::Policy::FAIR ? "fair" : "fifo";
+    }
+
+    /// 调度模式 ("shared" / "affinity")
+    const std::string& scheduler_mode() const { return config_.infer_scheduler; }
+
+    /// 工作窃取次数 (仅 affinity 模式)
+    uint64_t steal_count() const { return scheduler_ ? scheduler_->steal_count() : 0; }
+
+    /// 所有 worker 持有的 context 总数
+    size_t total_contexts() const;
 
     /// 模型管理器 (只读访问)
     const ModelManager& model_manager() const { return model_mgr_; }
@@ -120,19 +216,63 @@ public:
     /// 总处理任务计数
     uint64_t total_processed() const;
 
+    /// 所有 worker 处理任务的滑动窗口速率之和 (次/秒)
+    RateMeter::Rates processed_rate() const;
+
+    /// 动态批处理执行的批次数
+    uint64_t total_batches() const;
+
+    /// 动态批处理填充率 (实际任务数 / 批容量, 无批处理时为 0)
+    double batch_fill_ratio() const;
+
+    /// 各 worker (NPU 核心) 的统计信息
+    std::vector<WorkerStats> worker_stats() const;
+
+    /// 输出阶段统计
+    ResultDispatcher::Stats output_stats() const { return dispatcher_.get_stats(); }
+
 #ifdef HAS_ZMQ
     /// ZMQ 已发布消息计数
     uint64_t zmq_published_count() const { return zmq_pub_.published_count(); }
+
+    /// ZMQ 因没有检测结果而跳过的消息计数
+    uint64_t zmq_skipped_count() const { return zmq_pub_.skipped_count(); }
 #endif
 
 private:
-    /// 结果完成回调 (被 InferWorker 调用)
+    /// 结果完成回调 (被 InferWorker 调用, 只负责入队)
     void on_result_complete(FrameResult result);
 
+    /// 输出一帧结果 (在输出线程执行)
+    void output_result(const FrameResult& result);
+
+    /// 模型加载状态
+    enum class ModelState { Loading, Ready, Failed };
+
+    /// 登记尚未加载 (或上次失败) 的模型并分配主 worker, 返回由本次调用负责加载的模型路径
+    std::vector<std::string> claim_models(const std::vector<ModelConfig>& models);
+
+    /// 并行加载 claim_models() 登记的模型并预创建 worker context
+    bool load_claimed(const std::vector<std::string>& model_paths);
+
+    /// 需要预创建 context 的 worker (affinity 模式为主 worker 及其副本)
+    std::vector<InferWorker*> context_targets(const std::string& model_path);
+
+    /// 列表中没有正在加载的模型 (调用方持有 load_mutex_)
+    bool models_settled_locked(const std::vector<ModelConfig>& models) const;
+
+    /// 后台加载线程: 取出 load_queue_ 中累积的模型, 按批加载
+    void loader_loop();
+
+    /// 停止后台加载线程 (已排队的模型先加载完)
+    void join_loaders();
+
     ServerConfig config_;
     ModelManager model_mgr_;
-    BoundedQueue<InferTask> task_queue_;
+    InferTaskQueue task_queue_;
+    std::unique_ptr<AffinityScheduler> scheduler_;
     std::vector<std::unique_ptr<InferWorker>> workers_;
+    ResultDispatcher dispatcher_;
 
 #ifdef HAS_ZMQ
     ZmqPublisher zmq_pub_;
@@ -140,6 +280,15 @@ private:
 
     ResultCallback result_callback_;
     std::atomic<bool> initialized_{false};
+
+    // 模型加载状态 (load_mutex_ 保护)
+    mutable std::mutex load_mutex_;
+    std::condition_variable load_cv_;
+    std::unordered_map<std::string, ModelState> model_states_;  ///< model_path -> 状态
+    std::vector<std::string> load_queue_;                       ///< load_models_async 已认领、待加载的模型
+    std::thread loader_;                                        ///< 后台加载线程 (首次 load_models_async 时启动)
+    bool loader_stop_ = false;
+    double warmup_ms_ = 0.0;
 };
 
 } // namespace infer_server
@@ -5,22 +5,32 @@
  * @brief RKNN 模型管理器
  *
  * 负责:
- * - 模型文件加载 (rknn_init)
+ * - 模型文件加载 (只读 mmap + rknn_init, 文件在模型生命周期内保持映射)
  * - 输入/输出 tensor 属性查询
- * - 为 InferWorker 创建独立的 rknn_context (rknn_dup_context)
+ * - 为 InferWorker 创建独立的 rknn_context (可共享主 context 的权重内存)
  * - NPU 核心绑定 (rknn_set_core_mask)
+ * - 零拷贝模式下分配 NPU 输入 tensor 内存 (rknn_create_mem)
+ * - 预热完成后释放不再需要的主 context / 文件映射 (trim)
+ * - 每个模型的 NPU 内存统计
  * - 模型卸载和资源释放
  *
  * 线程安全: 内部使用 mutex 保护, 可从多线程调用。
+ * 文件映射、rknn_init 与属性查询都在锁外进行, 不同模型 / 不同 worker 的加载可并行。
  */
 
 #ifdef HAS_RKNN
 
 #include "infer_server/inference/post_processor.h"
+#include "infer_server/common/types.h"
+#include "infer_server/common/buffer_pool.h"
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <utility>
 #include <cstdint>
 
 // RKNN API
@@ -66,8 +76,45 @@ struct ModelInfo {
     /// 输出 tensor 属性列表
     std::vector<rknn_tensor_attr> output_attrs;
 
-    /// 转换为 PostProcessor 使用的 TensorAttr 格式
-    std::vector<TensorAttr> get_output_tensor_attrs() const;
+    /// 输入 batch 维度 (dims[0], 非批处理模型为 1)
+    int batch = 1;
+
+    /// PostProcessor 格式的输出属性 (加载时转换一次, 推理路径不再重建)
+    std::vector<TensorAttr> output_tensor_attrs;
+
+    /// 单样本输出属性: batch 维度视为 1, n_elems 按 batch 均分 (批处理按样本拆分输出用)
+    std::vector<TensorAttr> sample_output_attrs;
+
+    /// PostProcessor 使用的 TensorAttr 格式 (缓存)
+    const std::vector<TensorAttr>& get_output_tensor_attrs() const { return output_tensor_attrs; }
+
+    /// 由 input_attrs / output_attrs 计算 batch 与两组 TensorAttr 缓存
+    void build_tensor_attrs();
+};
+
+/**
+ * @brief 单个模型的 NPU 内存占用 (RKNN_QUERY_MEM_SIZE, 运行时不支持时为 0)
+ */
+struct ModelMemory {
+    std::string model_path;
+    uint64_t weight_bytes = 0;      ///< 一份权重的大小
+    uint64_t internal_bytes = 0;    ///< 每个 context 的中间 tensor (激活) 内存
+    int worker_contexts = 0;        ///< worker context 数
+    int shared_contexts = 0;        ///< 其中与主 context 共享权重的个数
+    bool master_resident = false;   ///< 主 context 是否仍驻留
+    bool file_mapped = false;       ///< 模型文件是否仍映射
+
+    /// 驻留的权重份数 (主 context + 独立权重的 worker context)
+    int weight_copies() const {
+        return (master_resident ? 1 : 0) + worker_contexts - shared_contexts;
+    }
+
+    /// 估算总占用: 权重份数 x 权重 + context 数 x 中间内存
+    uint64_t total_bytes() const {
+        int contexts = worker_contexts + (master_resident ? 1 : 0);
+        return weight_bytes * static_cast<uint64_t>(std::max(weight_copies(), 0)) +
+               internal_bytes * static_cast<uint64_t>(contexts);
+    }
 };
 
 /**
@@ -82,11 +129,20 @@ public:
     ModelManager(const ModelManager&) = delete;
     ModelManager& operator=(const ModelManager&) = delete;
 
+    /**
+     * @brief 设置 worker context 是否共享主 context 的权重内存 (在加载任何模型之前调用)
+     *
+     * 开启后 worker context 以 RKNN_FLAG_SHARE_WEIGHT_MEM 初始化, 每个模型只驻留一份权重;
+     * 各 context 仍独立 rknn_init, 中间 tensor 与输入 / 输出互相隔离。
+     * 运行时不支持时自动回退为独立权重。
+     */
+    void set_share_weights(bool share) { share_weights_ = share; }
+
     /**
      * @brief 加载模型文件
      *
-     * 读取 .rknn 模型文件, 调用 rknn_init, 查询输入输出属性。
-     * 如果模型已加载, 直接返回 true。
+     * 映射 .rknn 模型文件, 调用 rknn_init, 查询输入输出属性 (均在锁外)。
+     * 如果模型已加载, 直接返回 true; 同一模型被并发加载时保留先完成的一份。
      *
      * @param model_path 模型文件路径
      * @return true 加载成功
@@ -96,7 +152,7 @@ public:
     /**
      * @brief 为 worker 线程创建独立的 rknn_context
      *
-     * 使用 rknn_dup_context 从主 context 创建轻量级副本,
+     * 从映射的模型文件独立 rknn_init (锁外执行, 可并行),
      * 并通过 rknn_set_core_mask 绑定到指定 NPU 核心。
      *
      * @param model_path 已加载的模型路径
@@ -111,6 +167,35 @@ public:
      */
     void release_worker_context(rknn_context ctx);
 
+    /**
+     * @brief 预热完成后释放不再需要的资源
+     *
+     * - 解除模型文件映射 (之后惰性创建 context 时重新映射)
+     * - keep_master = false 时销毁主 context (模型信息已缓存; 零拷贝输入 tensor 池
+     *   与共享权重都依赖主 context, 此时调用方应传 true)
+     */
+    void trim(const std::string& model_path, bool keep_master);
+
+    /// 各模型的 NPU 内存占用
+    std::vector<ModelMemory> memory_stats() const;
+
+    /**
+     * @brief 分配模型输入 tensor 的 DMA 内存 (零拷贝模式)
+     *
+     * 使用主 context 调用 rknn_create_mem, 按 input_attrs[0] 的
+     * size_with_stride 分配, 供 RGA 直接写入 RGB888 (NHWC)。
+     * 每个模型维护空闲 tensor 链表, DmaBuffer 析构时归还复用,
+     * 必须在 unload_model / unload_all 之前释放。
+     * 返回的 DmaBuffer::id 随 tensor 复用保持不变, worker 据此缓存 fd 导入结果。
+     *
+     * @param model_path 已加载的模型路径
+     * @return DmaBuffer, 失败返回 nullptr
+     */
+    std::shared_ptr<DmaBuffer> create_input_buffer(const std::string& model_path);
+
+    /// 输入 tensor 池统计 (所有模型汇总)
+    BufferPool::Stats input_pool_stats() const;
+
     /**
      * @brief 获取模型信息 (线程安全)
      * @param model_path 模型路径
@@ -139,14 +224,60 @@ public:
     size_t loaded_count() const;
 
 private:
+    /// 只读映射的模型文件 (mmap 失败时回退为堆内存副本); 由 LoadedModel 与进行中的 rknn_init 共享
+    struct ModelFile {
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        bool mapped = false;
+        std::vector<uint8_t> heap;      ///< 回退副本
+
+        ~ModelFile();
+
+        /// 打开并映射模型文件, 失败返回 nullptr
+        static std::shared_ptr<ModelFile> open(const std::string& path);
+    };
+
+    /// 单个模型的输入 tensor 空闲链表
+    /// 池创建后接管主 context; DmaBuffer 的 deleter 持有池的强引用, 模型卸载后
+    /// 最后一个在途 tensor 归还时才销毁 tensor 与 context
+    /// (rknn_destroy 不会释放 rknn_create_mem 分配的内存, 必须先逐个 rknn_destroy_mem)
+    struct InputPool {
+        struct IdleMem {
+            rknn_tensor_mem* mem;
+            uint64_t id;
+        };
+
+        rknn_context ctx = 0;           ///< 主 context (池拥有, 析构时销毁)
+        std::mutex mutex;
+        std::vector<IdleMem> idle;
+        BufferPool::Stats stats;
+
+        ~InputPool();
+    };
+
+    static constexpr size_t kMaxIdleInputs = 16;
+
     struct LoadedModel {
-        rknn_context master_ctx = 0;   ///< 主 context (查询模型信息用)
+        rknn_context master_ctx = 0;   ///< 主 context (查询模型信息 / 输入 tensor 池 / 共享权重来源; trim 后可为 0)
         ModelInfo info;
-        std::vector<uint8_t> model_data; ///< 模型二进制数据 (worker 独立 rknn_init 用)
+        std::shared_ptr<ModelFile> model_file; ///< 模型文件映射 (worker 独立 rknn_init 用; trim 后为空)
+        std::shared_ptr<InputPool> input_pool; ///< 零拷贝输入 tensor 池
+        ModelMemory memory;                    ///< 内存统计 (mutex_ 保护)
     };
 
+    /// 释放主 context: 已建输入池时交由池在在途 tensor 全部归还后销毁 (mutex_ 下调用)
+    static void release_master(LoadedModel& loaded);
+
     mutable std::mutex mutex_;
     std::unordered_map<std::string, LoadedModel> models_;
+
+    /// worker context -> (模型路径, 是否共享权重), 释放时更新内存统计
+    std::unordered_map<rknn_context, std::pair<std::string, bool>> worker_contexts_;
+
+    bool share_weights_ = false;
+
+    /// DmaBuffer::id 分配 (所有模型共享, 不重复使用)
+    std::atomic<uint64_t> next_input_id_{1};
 };
 
 } // namespace infer_server
@@ -0,0 +1,117 @@
+#pragma once
+
+/**
+ * @file object_tracker.h
+ * @brief 轻量多目标跟踪 (IoU 关联 + 常速度外推, ByteTrack 风格)
+ *
+ * 推理结果经 FrameResultCollector 聚合后进入跟踪阶段 (StreamTrackers::apply),
+ * 每个开启跟踪的模型 (ModelConfig::track) 有独立的 ObjectTracker:
+ *
+ * - 每条轨迹保存框中心 / 宽高及其速度 (α-β 滤波, 即常速度 Kalman 的稳态增益形式)
+ * - 两轮贪心 IoU 关联 (只在同类别之间): 高分检测先与所有轨迹的外推框匹配,
+ *   低分检测再与剩余轨迹匹配 (遮挡时置信度下降的目标不会断轨);
+ *   未匹配的高分检测新建轨迹, 未匹配的低分检测原样输出 (track_id = -1)
+ * - 超过 max_age_ms 未匹配的轨迹删除
+ * - infer_interval > 1 时, 模型不推理的帧由 predict() 把轨迹外推到当前时间戳,
+ *   下游照常得到带 track_id 的检测框
+ *
+ * 纯 CPU 逻辑, 不依赖硬件; 内部加锁, 可被多个推理 / 预处理线程调用。
+ */
+
+#include "infer_server/common/types.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include <limits>
+
+namespace infer_server {
+
+class ObjectTracker {
+public:
+    /// 跟踪参数
+    struct Options {
+        float high_threshold = 0.5f;    ///< 高分检测阈值: 第一轮关联并可新建轨迹
+        float iou_threshold = 0.3f;     ///< 关联所需的最小 IoU (检测框 vs 轨迹外推框)
+        int max_age_ms = 1000;          ///< 轨迹未匹配超过该时长即删除 (也是外推的最长时长)
+    };
+
+    explicit ObjectTracker(const Options& options);
+
+    /**
+     * @brief 用一帧的检测结果更新轨迹
+     * @return 同一组检测 (顺序不变), 已关联或新建轨迹的检测带 track_id
+     *
+     * 时间戳早于上一次更新 (多 worker 乱序完成) 时只按当前轨迹分配 ID, 不修改轨迹状态。
+     */
+    std::vector<Detection> update(std::vector<Detection> detections, int64_t timestamp_ms);
+
+    /**
+     * @brief 把所有存活轨迹外推到 timestamp_ms (不修改轨迹状态)
+     * @param frame_w / frame_h 原始帧尺寸, 外推框裁剪到帧内 (<= 0 不裁剪)
+     * @return 外推的检测框, 置信度沿用最近一次匹配的检测
+     */
+    std::vector<Detection> predict(int64_t timestamp_ms, int frame_w = 0, int frame_h = 0) const;
+
+    /// 当前轨迹数
+    size_t track_count() const;
+
+    /// 两个框的 IoU
+    static float iou(const BBox& a, const BBox& b);
+
+private:
+    struct Track {
+        int id = 0;
+        int class_id = -1;
+        std::string class_name;
+        float confidence = 0.0f;
+        float cx = 0.0f, cy = 0.0f, w = 0.0f, h = 0.0f;     ///< 最近一次更新时的框
+        float vx = 0.0f, vy = 0.0f, vw = 0.0f, vh = 0.0f;   ///< 每毫秒变化量
+        int64_t last_ms = 0;                                ///< 最近一次匹配的时间戳
+        int hits = 0;                                       ///< 累计匹配次数
+
+        /// 外推到 timestamp_ms 的框
+        BBox box_at(int64_t timestamp_ms) const;
+    };
+
+    /// 贪心关联: 按 IoU 降序匹配同类别的 (检测, 轨迹) 对, 写入 det_track (检测下标 -> 轨迹下标)
+    void associate(const std::vector<Detection>& detections, const std::vector<size_t>& candidates,
+                   const std::vector<BBox>& predicted, std::vector<int>& det_track,
+                   std::vector<bool>& track_used) const;
+
+    /// 用匹配的检测更新轨迹状态
+    static void correct(Track& track, const Detection& det, int64_t timestamp_ms);
+
+    Options options_;
+    mutable std::mutex mutex_;
+    std::vector<Track> tracks_;
+    int next_id_ = 1;
+    int64_t last_update_ms_ = std::numeric_limits<int64_t>::min();
+};
+
+/**
+ * @brief 一路流的跟踪阶段 (task_name -> 跟踪器)
+ *
+ * 添加流时构造, 之后只读; 经 ModelBinding / FrameResult 共享, 流删除后仍可安全使用。
+ */
+class StreamTrackers {
+public:
+    /// 为模型添加跟踪器 (仅在构造阶段调用)
+    void add(const std::string& task_name, const ObjectTracker::Options& options);
+
+    /// 查找模型的跟踪器 (未开启跟踪返回 nullptr)
+    ObjectTracker* find(const std::string& task_name) const;
+
+    /// 跟踪阶段: 为一帧中各开启跟踪的模型分配 track_id (外推结果与转发结果跳过)
+    void apply(FrameResult& result) const;
+
+    bool empty() const { return trackers_.empty(); }
+
+private:
+    std::unordered_map<std::string, std::unique_ptr<ObjectTracker>> trackers_;
+};
+
+} // namespace infer_server
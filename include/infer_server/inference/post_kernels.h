@@ -0,0 +1,137 @@
+#pragma once
+
+/**
+ * @file post_kernels.h
+ * @brief YOLO 后处理计算内核 (标量便携实现 + NEON 实现, 运行时分发)
+ *
+ * PostProcessor 的热点:
+ *   - 每个 anchor 对 80 类做 argmax (YOLOv8 连续布局 / YOLOv11 通道优先布局)
+ *   - 每个 anchor 的 sigmoid (std::exp)
+ *   - DFL softmax (每个 box 边 16 个 exp)
+ *
+ * 内核集合:
+ *   - argmax:        连续数组 argmax (相同值取最小下标, 与参考实现一致)
+ *   - column_argmax: 通道优先布局按 anchor 分块 argmax (顺序访问内存, NEON 一次 4 个 anchor)
+ *   - dfl16:         reg_max = 16 的 DFL 解码, 无堆分配, 多项式 exp
+ *   - suppress:      NMS 内层循环, 一个保留框对一段候选框 (SoA) 计算 IoU 并标记抑制
+ *
+ * fast_exp 使用 Cephes expf 多项式 (相对误差约 1e-7), 标量与 NEON 版本公式相同。
+ * 纯 CPU 计算, 不依赖任何硬件库。
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+
+namespace infer_server {
+
+/// 后处理内核实现
+enum class PostProcessKernel {
+    REFERENCE = 0,  ///< 原始标量实现 (std::exp, 逐 anchor sigmoid), 作为正确性基准
+    PORTABLE  = 1,  ///< 阈值预过滤 + 分块 argmax + 多项式 exp, 标量代码
+    NEON      = 2,  ///< 同 PORTABLE, 内核使用 NEON intrinsics
+};
+
+/// 内核名称 ("reference" / "portable" / "neon")
+const char* post_kernel_name(PostProcessKernel kernel);
+
+namespace post_kernels {
+
+/// NMS 用的紧凑框数组 (SoA, 同一类别内按置信度降序)
+struct BoxSoA {
+    const float* x1;
+    const float* y1;
+    const float* x2;
+    const float* y2;
+    const float* area;
+};
+
+/// 一组内核函数
+struct KernelTable {
+    /// 连续数组 argmax, 返回最大值, *index 为最大值下标 (n >= 1)
+    float (*argmax)(const float* data, int n, int* index);
+
+    /**
+     * 通道优先布局的逐列 argmax: 元素 (c, j) 位于 data[c * stride + j]
+     * 对 j in [0, count) 更新 best[j] / index[j] (严格大于才更新, 初值由调用方设置)
+     */
+    void (*column_argmax)(const float* data, int rows, int stride, int count,
+                          float* best, int* index);
+
+    /// DFL 解码 (reg_max = 16): softmax 加权求和
+    float (*dfl16)(const float* data);
+
+    /// INT8 连续数组 argmax (语义同 argmax)
+    int8_t (*argmax_i8)(const int8_t* data, int n, int* index);
+
+    /// INT8 通道优先布局逐列 argmax (语义同 column_argmax)
+    void (*column_argmax_i8)(const int8_t* data, int rows, int stride, int count,
+                             int8_t* best, int* index);
+
+    /**
+     * NMS 抑制: 对 j in [begin, end), IoU(boxes[keep], boxes[j]) > threshold 时置 suppressed[j] = 1
+     * 以 inter > threshold * union 比较, 不做除法 (threshold >= 0)
+     */
+    void (*suppress)(const BoxSoA& boxes, int keep, int begin, int end,
+                     float threshold, uint8_t* suppressed);
+};
+
+/// 运行时是否支持 NEON
+bool neon_available();
+
+/// 指定实现的内核表 (NEON 不可用时返回便携实现)
+const KernelTable& table(PostProcessKernel kernel);
+
+/// Cephes expf 多项式近似
+inline float fast_exp(float x) {
+    x = std::min(std::max(x, -87.3f), 88.0f);
+    float fx = std::floor(x * 1.44269504088896341f + 0.5f);
+    x -= fx * 0.693359375f;
+    x -= fx * -2.12194440e-4f;
+    float z = x * x;
+    float y = 1.9875691500e-4f;
+    y = y * x + 1.3981999507e-3f;
+    y = y * x + 8.3334519073e-3f;
+    y = y * x + 4.1665795894e-2f;
+    y = y * x + 1.6666665459e-1f;
+    y = y * x + 5.0000001201e-1f;
+    y = y * z + x + 1.0f;
+
+    // 2^fx: 直接构造 IEEE754 指数位
+    int32_t bits = (static_cast<int32_t>(fx) + 127) << 23;
+    float pow2;
+    std::memcpy(&pow2, &bits, sizeof(pow2));
+    return y * pow2;
+}
+
+inline float fast_sigmoid(float x) {
+    return 1.0f / (1.0f + fast_exp(-x));
+}
+
+/**
+ * @brief sigmoid 阈值对应的 logit, 用于在 sigmoid 之前过滤
+ *
+ * sigmoid(x) >= t  <=>  x >= log(t / (1 - t))。
+ * t 不在 (0, 1) 内时返回 -FLT_MAX (不预过滤)。
+ * 调用方仍需对通过的值做精确比较, 预过滤只减去一个很小的余量。
+ */
+float sigmoid_threshold_logit(float t);
+
+/**
+ * @brief 浮点阈值换算到 INT8 量化域
+ *
+ * 反量化 x = (q - zp) * scale (scale > 0) 单调递增, 返回的 qt 满足:
+ * q < qt 时必有 x < value (可直接用整数比较拒绝)。
+ * 换算留有余量, 通过的值仍需反量化后精确比较。
+ * @return [-128, 128]; -128 = 全部通过, 128 = 全部拒绝
+ */
+int quantize_threshold(float value, int32_t zp, float scale);
+
+/// INT8 反量化单个值
+inline float dequantize(int8_t q, int32_t zp, float scale) {
+    return (static_cast<float>(q) - static_cast<float>(zp)) * scale;
+}
+
+} // namespace post_kernels
+} // namespace infer_server
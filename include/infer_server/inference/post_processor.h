@@ -15,9 +15,15 @@
  *     - box output:  [1, grid_h, grid_w, 64]  (DFL box regression, 4 * reg_max=16)
  *     - score output: [1, grid_h, grid_w, num_classes]
  *     - 或合并格式: [1, grid_h, grid_w, 64 + num_classes]
+ *
+ * 计算内核 (post_kernels.h):
+ *   默认使用 PORTABLE: sigmoid 之前按 logit 阈值预过滤, 分块类别 argmax, 多项式 exp,
+ *   无堆分配 DFL。NEON 内核算法相同, 需通过 set_kernel() (配置 post_kernel) 显式启用。
+ *   REFERENCE 保留原始标量实现作为基准 (测试比对 / 排查精度问题)。
  */
 
 #include "infer_server/common/types.h"
+#include "infer_server/inference/post_kernels.h"
 #include <vector>
 #include <string>
 #include <cstdint>
@@ -113,6 +119,11 @@ public:
 
     /**
      * @brief 通用 NMS (Non-Maximum Suppression)
+     *
+     * 快速内核: 按置信度排序一次后按类别分桶, 在紧凑的 SoA 框数组上逐桶抑制
+     * (无重叠提前退出, NEON 一次比较 4 个框), 最后按下标移动保留的 Detection。
+     * 结果按置信度降序, 与 REFERENCE 一致。
+     *
      * @param detections 检测结果 (会被修改, 保留 NMS 后的结果)
      * @param threshold  IoU 阈值
      */
@@ -142,6 +153,70 @@ public:
         float conf_thresh, float nms_thresh,
         const std::vector<std::string>& labels);
 
+    /**
+     * @brief INT8 输出直接后处理 (不对整个输出 tensor 反量化)
+     *
+     * 置信度阈值先换算到量化域 (sigmoid 输出的模型先取 logit), 用整数比较拒绝 anchor,
+     * 只对通过的 anchor 反量化。结果与「dequantize_int8 后调用 process()」一致。
+     * REFERENCE 内核下退化为整体反量化 + 参考实现。
+     *
+     * @param outputs 各输出头的 INT8 数据指针, 量化参数取自 attrs[i].zp / scale
+     */
+    static std::vector<Detection> process_int8(
+        const std::string& model_type,
+        const std::vector<const int8_t*>& outputs,
+        const std::vector<TensorAttr>& attrs,
+        int model_w, int model_h,
+        int orig_w, int orig_h,
+        float conf_thresh, float nms_thresh,
+        const std::vector<std::string>& labels);
+
+    /**
+     * @brief 按预处理的实际几何变换后处理
+     *
+     * 检测框先在模型输入坐标中解码, 再经 transform.unmap() 映射回原图,
+     * 与 RGA 预处理 (letterbox / stretch) 写入的像素位置一致;
+     * 模型输入尺寸取自 transform.model_w / model_h。
+     */
+    static std::vector<Detection> process(
+        const std::string& model_type,
+        const std::vector<float*>& outputs,
+        const std::vector<TensorAttr>& attrs,
+        const LetterboxTransform& transform,
+        float conf_thresh, float nms_thresh,
+        const std::vector<std::string>& labels);
+
+    /// INT8 输出 + 预处理几何变换 (见上)
+    static std::vector<Detection> process_int8(
+        const std::string& model_type,
+        const std::vector<const int8_t*>& outputs,
+        const std::vector<TensorAttr>& attrs,
+        const LetterboxTransform& transform,
+        float conf_thresh, float nms_thresh,
+        const std::vector<std::string>& labels);
+
+    /// 将模型输入坐标中的检测框映射回原图坐标
+    static void unmap_coords(std::vector<Detection>& dets, const LetterboxTransform& transform);
+
+    /// 是否可走 INT8 后处理: 模型类型支持且所有输出头均为 INT8 (scale > 0)
+    static bool supports_int8(const std::string& model_type,
+                              const std::vector<TensorAttr>& attrs);
+
+    /// 当前平台可用的最快内核
+    static PostProcessKernel best_kernel();
+
+    /// 未调用 set_kernel() 时使用的内核 (PORTABLE)
+    static PostProcessKernel default_kernel();
+
+    /// 按名称 ("reference" / "portable" / "neon") 解析内核, 未知名称返回 false
+    static bool parse_kernel(const std::string& name, PostProcessKernel& kernel);
+
+    /// 选择内核 (全局生效); 请求 NEON 但当前 CPU 不支持时回退到 best_kernel()
+    static void set_kernel(PostProcessKernel kernel);
+
+    /// 当前使用的内核 (未设置时为 default_kernel())
+    static PostProcessKernel kernel();
+
 private:
     /// YOLOv5 默认 anchor 定义 (COCO)
     static constexpr float YOLOV5_ANCHORS[3][6] = {
@@ -153,6 +228,55 @@ private:
     static constexpr int YOLOV5_NUM_ANCHORS = 3;
     static constexpr int STRIDES[3] = {8, 16, 32};
 
+    /// 快速路径 (PORTABLE / NEON), 输出与参考实现一致 (浮点误差内)
+    static std::vector<Detection> yolov5_fast(
+        const std::vector<float*>& outputs, const std::vector<TensorAttr>& attrs,
+        int model_w, int model_h, int orig_w, int orig_h,
+        float conf_thresh, float nms_thresh, const std::vector<std::string>& labels,
+        const post_kernels::KernelTable& kt);
+
+    static std::vector<Detection> yolov8_fast(
+        const std::vector<float*>& outputs, const std::vector<TensorAttr>& attrs,
+        int model_w, int model_h, int orig_w, int orig_h,
+        float conf_thresh, float nms_thresh, const std::vector<std::string>& labels,
+        const post_kernels::KernelTable& kt);
+
+    static std::vector<Detection> yolov11_fast(
+        const std::vector<float*>& outputs, const std::vector<TensorAttr>& attrs,
+        int model_w, int model_h, int orig_w, int orig_h,
+        float conf_thresh, float nms_thresh, const std::vector<std::string>& labels,
+        const post_kernels::KernelTable& kt);
+
+    /// INT8 快速路径
+    static std::vector<Detection> yolov5_int8(
+        const std::vector<const int8_t*>& outputs, const std::vector<TensorAttr>& attrs,
+        int model_w, int model_h, int orig_w, int orig_h,
+        float conf_thresh, float nms_thresh, const std::vector<std::string>& labels,
+        const post_kernels::KernelTable& kt);
+
+    static std::vector<Detection> yolov8_int8(
+        const std::vector<const int8_t*>& outputs, const std::vector<TensorAttr>& attrs,
+        int model_w, int model_h, int orig_w, int orig_h,
+        float conf_thresh, float nms_thresh, const std::vector<std::string>& labels,
+        const post_kernels::KernelTable& kt);
+
+    static std::vector<Detection> yolov11_int8(
+        const std::vector<const int8_t*>& outputs, const std::vector<TensorAttr>& attrs,
+        int model_w, int model_h, int orig_w, int orig_h,
+        float conf_thresh, float nms_thresh, const std::vector<std::string>& labels,
+        const post_kernels::KernelTable& kt);
+
+    /// 原始 O(n^2) NMS (REFERENCE)
+    static void nms_reference(std::vector<Detection>& detections, float threshold);
+
+    /// 分桶 SoA NMS
+    static void nms_fast(std::vector<Detection>& detections, float threshold,
+                         const post_kernels::KernelTable& kt);
+
+    /// NMS 之后填充 class_name (只为保留的框分配字符串)
+    static void attach_labels(std::vector<Detection>& detections,
+                              const std::vector<std::string>& labels);
+
     /// DFL (Distribution Focal Loss) softmax 解码
     static float dfl_decode(const float* data, int reg_max);
 
@@ -163,7 +287,8 @@ private:
     static float iou(const BBox& a, const BBox& b);
 
     /// 将检测框从模型坐标映射到原始图像坐标
-    /// 假设使用 letterbox (等比例缩放+填充) 预处理
+    /// 假设使用 letterbox (等比例缩放+居中填充, 不做偶数对齐) 预处理;
+    /// 已知实际预处理变换时使用 unmap_coords()
     static void scale_coords(std::vector<Detection>& dets,
                              int model_w, int model_h,
                              int orig_w, int orig_h);
@@ -0,0 +1,90 @@
+#pragma once
+
+/**
+ * @file result_broadcaster.h
+ * @brief 推理结果的进程内广播 (HTTP 推送: Server-Sent Events)
+ *
+ * 轻量 Web 客户端不需要 ZMQ 即可实时接收检测结果:
+ * RestServer 的 SSE 连接各持有一个 Subscription, 输出线程对每帧调用 publish()。
+ *
+ * - 没有订阅者时 publish() 只做一次原子读取
+ * - 每帧只编码一次 JSON (与 REST / ZMQ JSON 格式相同), 所有匹配的订阅者共享同一份文本
+ * - 每个订阅者拥有独立的有界队列, 慢客户端满时丢弃最旧结果, 不阻塞输出线程
+ * - 订阅者析构即退订 (下一次 publish / subscribe 时清理)
+ *
+ * 纯 CPU, 不依赖任何硬件库。
+ */
+
+#include "infer_server/common/types.h"
+#include "infer_server/common/bounded_queue.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace infer_server {
+
+class ResultBroadcaster {
+public:
+    /// 一帧结果的 JSON 文本 (订阅者之间共享)
+    using Payload = std::shared_ptr<const std::string>;
+
+    /// 一个订阅 (由 subscribe() 创建, 析构即退订)
+    class Subscription {
+    public:
+        Subscription(std::string cam_id, size_t queue_size);
+
+        /// 等待下一条结果; 超时返回 nullopt
+        std::optional<Payload> next(std::chrono::milliseconds timeout) { return queue_.pop(timeout); }
+
+        /// 订阅的摄像头 (空 = 所有摄像头)
+        const std::string& cam_id() const { return cam_id_; }
+
+        /// 队列满而丢弃的结果数
+        size_t dropped() const { return queue_.dropped_count(); }
+
+    private:
+        friend class ResultBroadcaster;
+
+        std::string cam_id_;
+        BoundedQueue<Payload> queue_;
+    };
+
+    ResultBroadcaster() = default;
+
+    // 禁止拷贝
+    ResultBroadcaster(const ResultBroadcaster&) = delete;
+    ResultBroadcaster& operator=(const ResultBroadcaster&) = delete;
+
+    /**
+     * @brief 订阅结果
+     * @param cam_id     只接收该摄像头的结果 (空 = 所有摄像头)
+     * @param queue_size 订阅者队列容量 (满时丢弃最旧结果)
+     */
+    std::shared_ptr<Subscription> subscribe(const std::string& cam_id, size_t queue_size = 32);
+
+    /// 广播一帧结果 (线程安全, 不阻塞; 在输出线程调用)
+    void publish(const FrameResult& result);
+
+    /// 当前订阅者数 (含已析构、尚未清理的订阅)
+    size_t subscriber_count() const { return count_.load(std::memory_order_relaxed); }
+
+    /// 已广播的帧数 (至少有一个订阅者匹配)
+    uint64_t published_count() const { return published_.load(std::memory_order_relaxed); }
+
+private:
+    /// 清理已析构的订阅 (调用方持有 mutex_)
+    void prune_locked();
+
+    mutable std::mutex mutex_;
+    std::vector<std::weak_ptr<Subscription>> subscribers_;
+    std::atomic<size_t> count_{0};
+    std::atomic<uint64_t> published_{0};
+};
+
+} // namespace infer_server
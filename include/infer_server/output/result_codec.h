@@ -0,0 +1,103 @@
+#pragma once
+
+/**
+ * @file result_codec.h
+ * @brief FrameResult 序列化格式 (JSON / MessagePack) 与 ZMQ 主题
+ *
+ * JSON: 与 REST API 相同的对象格式, 经 nlohmann::json DOM 生成, 兼容旧下游。
+ *
+ * MessagePack (schema v1): 直接从结构体写入字节缓冲, 不构造 DOM,
+ * 使用定长数组 (按位置取字段, 无字段名), 任意 MessagePack 库都可解码:
+ *
+ *   FrameResult = [version=1, cam_id, rtsp_url, frame_id, timestamp_ms, pts,
+ *                  original_width, original_height, [ModelResult...]]
+ *   ModelResult = [task_name, model_path, inference_time_ms (float64), [Detection...]]
+ *   Detection   = [class_id, class_name, confidence, x1, y1, x2, y2]   (浮点为 float32)
+ *
+ * 兼容规则: 只在数组末尾追加字段, 不改变已有字段的位置和含义;
+ * 解码时忽略多出的尾部字段。需要不兼容修改时递增 version。
+ *
+ * 格式识别: JSON 以 '{' 开头, MessagePack 以 fixarray 头 (0x90~0x9f) 开头。
+ *
+ * 主题 (TopicMode != NONE 时为两帧 multipart 消息 [topic][payload]):
+ *   CAMERA: topic = "cam_id/",           payload = 整帧结果
+ *   TASK:   topic = "cam_id/task_name",  payload = 只含该模型结果的 FrameResult
+ * 订阅 "cam_id/" 即可在 socket 层过滤出单个摄像头 (两种模式通用)。
+ */
+
+#include "infer_server/common/types.h"
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+
+namespace infer_server {
+
+/// 结果输出格式
+enum class OutputFormat {
+    JSON    = 0,    ///< JSON 文本 (默认, 兼容旧下游)
+    MSGPACK = 1,    ///< MessagePack 定长数组 (schema v1)
+};
+
+/// 格式名称 ("json" / "msgpack")
+const char* output_format_name(OutputFormat format);
+
+/**
+ * @brief 解析格式名称
+ * @return 未知名称返回 false, out 不变
+ */
+bool parse_output_format(const std::string& name, OutputFormat& out);
+
+/// ZMQ 主题模式
+enum class TopicMode {
+    NONE   = 0,     ///< 单帧消息, 无主题 (默认, 兼容旧下游)
+    CAMERA = 1,     ///< 每帧一条 [cam_id/][整帧结果]
+    TASK   = 2,     ///< 每个模型结果一条 [cam_id/task_name][该模型结果]
+};
+
+/// 主题模式名称 ("none" / "camera" / "task")
+const char* topic_mode_name(TopicMode mode);
+
+/**
+ * @brief 解析主题模式名称
+ * @return 未知名称返回 false, out 不变
+ */
+bool parse_topic_mode(const std::string& name, TopicMode& out);
+
+namespace result_codec {
+
+/// MessagePack schema 版本
+constexpr int kMsgpackSchemaVersion = 1;
+
+/**
+ * @brief 编码为 MessagePack
+ *
+ * 覆盖 out 的内容; out 的容量被保留, 复用同一个缓冲时稳态下不分配内存。
+ */
+void encode_msgpack(const FrameResult& result, std::vector<uint8_t>& out);
+
+/**
+ * @brief 构造主题: "cam_id/" 或 "cam_id/task_name"
+ *
+ * 摄像头 ID 后总是带 '/', 避免前缀订阅 "cam1" 误匹配 "cam10"。
+ */
+std::string make_topic(const std::string& cam_id, const std::string& task_name = "");
+
+/// 编码为 JSON 字符串
+std::string encode_json(const FrameResult& result);
+
+/// 按首字节识别格式 (无法识别时返回 nullopt)
+std::optional<OutputFormat> detect_format(const void* data, size_t size);
+
+/**
+ * @brief 解码 MessagePack (schema v1)
+ * @return 数据截断、类型不符或版本不支持时返回 nullopt
+ */
+std::optional<FrameResult> decode_msgpack(const void* data, size_t size);
+
+/// 解码任一格式 (按首字节识别)
+std::optional<FrameResult> decode(const void* data, size_t size);
+
+} // namespace result_codec
+} // namespace infer_server
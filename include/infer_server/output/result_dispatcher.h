@@ -0,0 +1,94 @@
+#pragma once
+
+/**
+ * @file result_dispatcher.h
+ * @brief 推理结果输出阶段 (独立队列 + 输出线程)
+ *
+ * InferWorker 完成一帧后只需 post() 入队, 序列化、ZMQ 发送、统计回调等
+ * CPU / I/O 工作都在输出线程执行, NPU 线程不再被下游阻塞。
+ *
+ * - 每个输出线程拥有独立的有界队列 (满时丢弃最旧结果)
+ * - 按 cam_id 哈希分片: 同一路流的结果始终由同一线程按顺序输出
+ * - num_threads = 0 时 post() 在调用线程同步执行各 sink (旧行为)
+ * - stop() 先处理完队列中剩余的结果再返回
+ *
+ * 纯调度逻辑, 不依赖任何硬件库。
+ */
+
+#include "infer_server/common/types.h"
+#include "infer_server/common/bounded_queue.h"
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace infer_server {
+
+class ResultDispatcher {
+public:
+    /// 结果输出目标 (ZMQ、统计回调等), 在输出线程调用
+    using Sink = std::function<void(const FrameResult&)>;
+
+    /// 统计信息
+    struct Stats {
+        uint64_t posted = 0;        ///< 入队的结果数
+        uint64_t dispatched = 0;    ///< 已交给所有 sink 的结果数
+        uint64_t dropped = 0;       ///< 队列满时被丢弃的结果数
+        size_t queued = 0;          ///< 当前排队的结果数
+    };
+
+    /**
+     * @param num_threads 输出线程数 (0 = 在 post() 调用线程同步输出)
+     * @param queue_size  每个输出线程的队列容量
+     */
+    ResultDispatcher(int num_threads, size_t queue_size);
+
+    ~ResultDispatcher();
+
+    // 禁止拷贝
+    ResultDispatcher(const ResultDispatcher&) = delete;
+    ResultDispatcher& operator=(const ResultDispatcher&) = delete;
+
+    /// 添加输出目标 (必须在 start() 之前调用, 按添加顺序执行)
+    void add_sink(Sink sink);
+
+    /// 启动输出线程 (重复调用无效果)
+    void start();
+
+    /**
+     * @brief 提交一帧结果 (线程安全, 不阻塞)
+     * @return false: 未启动或已停止
+     */
+    bool post(FrameResult result);
+
+    /// 停止: 处理完剩余结果后退出输出线程
+    void stop();
+
+    /// 获取统计信息
+    Stats get_stats() const;
+
+    /// 输出线程数
+    int num_threads() const { return num_threads_; }
+
+    /// 是否正在运行
+    bool is_running() const { return running_.load(); }
+
+private:
+    void run(size_t shard);
+    void dispatch(const FrameResult& result);
+    size_t shard_of(const std::string& cam_id) const;
+
+    int num_threads_;
+    std::vector<Sink> sinks_;
+    std::vector<std::unique_ptr<BoundedQueue<FrameResult>>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> posted_{0};
+    std::atomic<uint64_t> dispatched_{0};
+};
+
+} // namespace infer_server
@@ -0,0 +1,67 @@
+#pragma once
+
+/**
+ * @file result_forwarder.h
+ * @brief ZeroMQ XSUB/XPUB 结果汇聚转发
+ *
+ * 集群模式下每个节点各自以 PUB 发布推理结果。ResultForwarder 在协调器上以 XSUB
+ * 连接所有节点的发布端, 把消息 (含 multipart 主题帧) 原样经 XPUB 转发:
+ * 订阅者只连接一个端点即可收到所有摄像头的结果, 流在节点间迁移时无需重连。
+ * 订阅 (ZMQ_SUBSCRIBE 前缀) 经 XPUB -> XSUB 反向传到各节点, 主题过滤仍在节点 PUB 端完成。
+ *
+ * 不使用 zmq_proxy(): 节点列表会变化, 而 socket 只能在其所属线程上 connect / disconnect;
+ * 转发线程自己 poll 两个 socket, 并在每轮 poll 之间应用新的上游列表。
+ */
+
+#ifdef HAS_CLUSTER_FORWARD
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace infer_server {
+
+class ResultForwarder {
+public:
+    /// @param bind_endpoint XPUB 绑定地址 (如 "tcp://0.0.0.0:5556")
+    explicit ResultForwarder(std::string bind_endpoint);
+    ~ResultForwarder();
+
+    ResultForwarder(const ResultForwarder&) = delete;
+    ResultForwarder& operator=(const ResultForwarder&) = delete;
+
+    /// 启动转发线程 (绑定失败返回 false)
+    bool start();
+    void stop();
+
+    /// 设置上游 (各节点 PUB 地址); 在转发线程下一轮 poll 时 connect / disconnect
+    void set_upstreams(const std::vector<std::string>& endpoints);
+
+    /// 已转发的消息数 (multipart 消息计一次)
+    uint64_t forwarded() const { return forwarded_.load(std::memory_order_relaxed); }
+
+    const std::string& endpoint() const { return bind_endpoint_; }
+
+private:
+    void run();
+
+    std::string bind_endpoint_;
+
+    std::mutex mutex_;
+    std::set<std::string> upstreams_;   ///< 期望的上游 (mutex_ 保护)
+    bool upstreams_changed_ = false;
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> bound_{false};
+    std::atomic<bool> bind_done_{false};
+    std::atomic<uint64_t> forwarded_{0};
+    std::thread thread_;
+};
+
+} // namespace infer_server
+
+#endif // HAS_CLUSTER_FORWARD
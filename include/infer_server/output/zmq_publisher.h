@@ -4,17 +4,23 @@
  * @file zmq_publisher.h
  * @brief ZeroMQ 推理结果发布器
  *
- * 使用 PUB socket 将 FrameResult 以 JSON 格式发布。
+ * 使用 PUB socket 将 FrameResult 发布。
  * 下游程序 (行为分析/报警) 通过 SUB socket 订阅。
  *
  * 默认 endpoint: tcp://0.0.0.0:5555
  * 通信模式: PUB/SUB
- * 消息格式: JSON 字符串 (UTF-8)
+ * 消息格式: JSON 字符串 (UTF-8) 或 MessagePack (schema 见 result_codec.h)
+ * 主题: 可选 multipart [cam_id/task_name][payload], 订阅者用 ZMQ_SUBSCRIBE 前缀过滤,
+ *       不订阅的摄像头在发送端即被丢弃 (TCP 下由 PUB 端过滤), 不占网络和解码开销
+ *
+ * 发送为零拷贝: 序列化结果直接交给 zmq_msg_init_data, 由 ZMQ 发送完成后
+ * 通过 free 回调释放。MessagePack 缓冲在回调中回收复用, 稳态下不分配内存。
  */
 
 #ifdef HAS_ZMQ
 
 #include "infer_server/common/types.h"
+#include "infer_server/output/result_codec.h"
 #include <string>
 #include <mutex>
 #include <atomic>
@@ -30,11 +36,27 @@ namespace infer_server {
 
 class ZmqPublisher {
 public:
+    /// 发布选项
+    struct Options {
+        OutputFormat format = OutputFormat::JSON;   ///< 消息格式
+        TopicMode topic_mode = TopicMode::NONE;     ///< 主题模式
+        bool skip_empty = false;                    ///< 不发布没有检测结果的帧 (TASK 模式下按模型)
+    };
+
     /**
      * @brief 构造 ZMQ 发布器
      * @param endpoint ZMQ endpoint (如 "tcp://0.0.0.0:5555")
+     * @param format   消息格式
      */
-    explicit ZmqPublisher(const std::string& endpoint = "tcp://0.0.0.0:5555");
+    explicit ZmqPublisher(const std::string& endpoint = "tcp://0.0.0.0:5555",
+                          OutputFormat format = OutputFormat::JSON);
+
+    /**
+     * @brief 构造 ZMQ 发布器
+     * @param endpoint ZMQ endpoint
+     * @param options  格式 / 主题 / 空结果过滤
+     */
+    ZmqPublisher(const std::string& endpoint, const Options& options);
 
     ~ZmqPublisher();
 
@@ -51,7 +73,8 @@ public:
     /**
      * @brief 发布推理结果 (线程安全)
      *
-     * 将 FrameResult 序列化为 JSON, 然后通过 ZMQ PUB socket 发送。
+     * 将 FrameResult 按配置的格式序列化 (在锁外), 然后通过 ZMQ PUB socket 发送。
+     * TASK 主题模式下每个模型结果单独发送一条消息。
      * 如果没有订阅者, 消息会被静默丢弃 (PUB/SUB 语义)。
      *
      * @param result 完整的帧推理结果
@@ -73,18 +96,42 @@ public:
      */
     uint64_t published_count() const { return published_count_.load(); }
 
+    /**
+     * @brief 因没有检测结果而跳过的消息计数 (skip_empty)
+     */
+    uint64_t skipped_count() const { return skipped_count_.load(); }
+
     /**
      * @brief 获取 endpoint
      */
     const std::string& endpoint() const { return endpoint_; }
 
+    /**
+     * @brief 获取消息格式
+     */
+    OutputFormat format() const { return options_.format; }
+
+    /**
+     * @brief 获取发布选项
+     */
+    const Options& options() const { return options_; }
+
 private:
+    /// 序列化并发送一条消息 (topic 为空时发送单帧消息)
+    void send_message(const std::string& topic, const FrameResult& result);
+
+    /// MessagePack 发送缓冲回收器 (由 ZMQ free 回调归还, 可能晚于发布器析构)
+    struct BufferRecycler;
+
     std::string endpoint_;
+    Options options_;
+    std::shared_ptr<BufferRecycler> recycler_;
     std::unique_ptr<zmq::context_t> zmq_ctx_;
     std::unique_ptr<zmq::socket_t> pub_socket_;
     std::mutex mutex_;
     std::atomic<bool> initialized_{false};
     std::atomic<uint64_t> published_count_{0};
+    std::atomic<uint64_t> skipped_count_{0};
 };
 
 } // namespace infer_server
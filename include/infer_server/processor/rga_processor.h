@@ -7,13 +7,20 @@
  * 使用 Rockchip RGA 硬件加速进行:
  * - NV12 → RGB 色彩空间转换 + 缩放
  * - NV12 → NV12 缩放
+ * - letterbox: 等比缩放到目标图像中的子矩形 (improcess + 目标 rect), 其余区域填充
+ * - ROI 裁剪: 只读取源帧中的子矩形 (improcess + 源 rect), 与 letterbox 可组合
  *
- * 所有操作使用虚拟地址模式 (wrapbuffer_virtualaddr)。
- * 输入输出均为 CPU 可访问的内存。
+ * 默认使用虚拟地址模式 (wrapbuffer_virtualaddr), 输入输出均为 CPU 可访问的内存。
+ * 零拷贝模式下, DmaBuffer 重载通过 importbuffer_fd + wrapbuffer_handle
+ * 直接读写 DMA-BUF (MPP 解码帧 / NPU 输入 tensor), 不经过 CPU。
+ *
+ * 所有操作经 RgaScheduler 分配到 RGA 核心提交, 同一帧的多个输出
+ * 可通过 RgaFrameBatch 合并为一个 RGA job。
  */
 
 #ifdef HAS_RGA
 
+#include "infer_server/common/types.h"
 #include <cstdint>
 #include <cstddef>
 #include <vector>
@@ -21,6 +28,75 @@
 
 namespace infer_server {
 
+/**
+ * @brief 单帧 RGA 批处理
+ *
+ * 同一源帧的多个 resize + 色彩转换输出 (各模型输入、缓存缩略图)
+ * 合并为一个 RGA job, 在 RgaScheduler 分配的核心上一次提交。
+ *
+ * 用法:
+ *   RgaFrameBatch batch(*frame->dma_buf);
+ *   auto rgb = batch.add_rgb(640, 640);
+ *   bool ok = batch.add_rgb(*tensor);
+ *   if (batch.submit()) { ... rgb / tensor 已写入 ... }
+ *
+ * 输出缓冲区在 submit() 成功返回后才有效。非线程安全, 每个线程独立构造。
+ */
+class RgaFrameBatch {
+public:
+    /// NV12 源 (CPU 内存, 大小 = src_w * src_h * 3/2)
+    RgaFrameBatch(const uint8_t* nv12_data, int src_w, int src_h);
+
+    /// NV12 源 (DMA-BUF, 使用 width/height/wstride/hstride)
+    explicit RgaFrameBatch(const DmaBuffer& src);
+
+    ~RgaFrameBatch();
+
+    RgaFrameBatch(const RgaFrameBatch&) = delete;
+    RgaFrameBatch& operator=(const RgaFrameBatch&) = delete;
+
+    /// 源是否有效 (参数合法且导入成功)
+    bool valid() const;
+
+    /// 已添加的输出数量
+    size_t size() const;
+
+    /// 追加 RGB 输出到 CPU 内存 (宽高对齐为偶数)
+    /// @return 输出缓冲区 (大小 = dst_w * dst_h * 3), 失败返回 nullptr
+    std::shared_ptr<std::vector<uint8_t>> add_rgb(int dst_w, int dst_h);
+
+    /// 追加 NV12 输出到 CPU 内存 (宽高对齐为偶数, 用于延迟编码的图片缓存)
+    /// @return 输出缓冲区 (大小 = dst_w * dst_h * 3/2), 失败返回 nullptr
+    std::shared_ptr<std::vector<uint8_t>> add_nv12(int dst_w, int dst_h);
+
+    /// 追加 RGB888 输出到 DMA-BUF (如 NPU 输入 tensor)
+    /// @return false 导入失败, 调用方可改用 CPU 内存输出
+    bool add_rgb(DmaBuffer& dst);
+
+    /// 追加按 transform 缩放的 RGB 输出到 CPU 内存 (大小 = model_w * model_h * 3)
+    /// letterbox 时图像写入子矩形 (x, y, w, h), 填充区域由 CPU 写为 114;
+    /// crop 非空时只读取源帧中的该矩形 (源像素坐标, 起点和宽高须为偶数)。
+    /// 无填充且不裁剪时等价于 add_rgb(w, h)
+    /// @return 输出缓冲区, 失败返回 nullptr
+    std::shared_ptr<std::vector<uint8_t>> add_rgb(const LetterboxTransform& transform,
+                                                  const CropRect& crop = {});
+
+    /// 追加按 transform 缩放的 RGB888 输出到 DMA-BUF (crop 含义同上)
+    /// @return false 导入失败, 或有填充区域但 dst 没有 CPU 虚拟地址 (调用方可改用 CPU 内存输出)
+    bool add_rgb(DmaBuffer& dst, const LetterboxTransform& transform, const CropRect& crop = {});
+
+    /// 提交所有输出 (阻塞直到完成), 提交后清空输出列表
+    /// @return true 全部成功
+    bool submit();
+
+private:
+    /// crop 是否为空, 或为源帧内起点和宽高均为偶数的矩形
+    bool crop_fits(const CropRect& crop) const;
+
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
 class RgaProcessor {
 public:
     RgaProcessor() = default;
@@ -37,6 +113,25 @@ public:
         const uint8_t* nv12_data, int src_w, int src_h,
         int dst_w, int dst_h);
 
+    /// NV12 (DMA-BUF) → RGB, 输出到 CPU 内存 (图片缓存用)
+    /// @param src    NV12 DMA-BUF (使用 width/height/wstride/hstride)
+    /// @param dst_w  目标宽度
+    /// @param dst_h  目标高度
+    /// @return RGB 数据 (大小 = dst_w * dst_h * 3), 失败返回 nullptr
+    static std::shared_ptr<std::vector<uint8_t>> nv12_to_rgb_resize(
+        const DmaBuffer& src, int dst_w, int dst_h);
+
+    /// NV12 (DMA-BUF) → RGB (DMA-BUF), 全程零拷贝
+    /// @param src  NV12 DMA-BUF
+    /// @param dst  RGB888 目标 (如 NPU 输入 tensor, 使用 width/height/wstride)
+    /// @return true 成功
+    static bool nv12_to_rgb_resize(const DmaBuffer& src, DmaBuffer& dst);
+
+    /// NV12 (CPU 内存) → RGB (DMA-BUF), 软件解码时写入 NPU 输入 tensor
+    /// @return true 成功
+    static bool nv12_to_rgb_resize(const uint8_t* nv12_data, int src_w, int src_h,
+                                   DmaBuffer& dst);
+
     /// NV12 → NV12 (仅缩放)
     /// @param nv12_data  NV12 数据 (Y + UV 连续)
     /// @param src_w      源宽度
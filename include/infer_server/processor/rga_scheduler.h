@@ -0,0 +1,164 @@
+#pragma once
+
+/**
+ * @file rga_scheduler.h
+ * @brief RGA 多核心调度器
+ *
+ * RK3588 有 RGA3_CORE0 / RGA3_CORE1 / RGA2_CORE0 三个核心, RK3576 有两个 RGA2 核心。
+ * 原先所有 RGA 调用经过进程级全局锁串行化, 多路流时成为主要竞争点。
+ *
+ * RgaScheduler 为每个配置的核心维护一个提交槽位:
+ * - acquire() 优先选择空闲核心, 全忙时排队到等待者最少的核心
+ * - 返回的 Lease 持有该核心的提交权 (RAII), 同一核心上的 job 仍然串行
+ * - 不同核心的 job 可并行提交
+ *
+ * core_mask = 0 时只有一个 "驱动自动调度" 槽位, 行为等价于原全局锁。
+ *
+ * NPU 初始化 (rknn_init) 与 RGA job 并发时驱动可能出现硬件冲突:
+ * begin_npu_init() 等待进行中的 RGA job 结束并暂停新的 acquire(), 直到返回的 NpuInit 析构。
+ * 多个初始化之间可以并行; 等待中的初始化优先于新的 RGA job, 避免被持续的 RGA 负载饿死。
+ *
+ * 纯调度逻辑, 不依赖 librga (核心掩码值与 IM_SCHEDULER_CORE 一致)。
+ */
+
+#include "infer_server/common/metrics.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+namespace infer_server {
+
+/// RGA 核心掩码定义 (与 im2d_type.h 中 IM_SCHEDULER_CORE 一致)
+struct RgaCoreMask {
+    static constexpr int AUTO       = 0;        ///< IM_SCHEDULER_DEFAULT (驱动自动选择)
+    static constexpr int RGA3_CORE0 = 1 << 0;   ///< IM_SCHEDULER_RGA3_CORE0
+    static constexpr int RGA3_CORE1 = 1 << 1;   ///< IM_SCHEDULER_RGA3_CORE1
+    static constexpr int RGA2_CORE0 = 1 << 2;   ///< IM_SCHEDULER_RGA2_CORE0
+    static constexpr int RGA2_CORE1 = 1 << 3;   ///< IM_SCHEDULER_RGA2_CORE1
+
+    static constexpr int RK3588 = RGA3_CORE0 | RGA3_CORE1 | RGA2_CORE0;
+    static constexpr int RK3576 = RGA2_CORE0 | RGA2_CORE1;
+};
+
+class RgaScheduler {
+public:
+    /// 单个核心的统计
+    struct CoreStats {
+        int core = 0;               ///< 核心掩码 (RgaCoreMask)
+        uint64_t jobs = 0;          ///< 已提交 job 数
+        uint64_t contended = 0;     ///< 提交时需要排队的次数
+        int waiting = 0;            ///< 当前排队线程数
+        uint64_t wait_us = 0;       ///< 累计等待核心的时间 (微秒)
+    };
+
+private:
+    struct Slot {
+        int core = 0;
+        std::mutex mutex;
+        std::atomic<int> waiting{0};
+        std::atomic<uint64_t> jobs{0};
+        std::atomic<uint64_t> contended{0};
+        std::atomic<uint64_t> wait_ns{0};
+    };
+
+public:
+    /**
+     * @brief 核心提交权 (RAII)
+     *
+     * 析构时释放核心。持有期间调用方在该核心上提交 RGA job。
+     */
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept : sched_(other.sched_), slot_(other.slot_) { other.slot_ = nullptr; }
+        Lease& operator=(Lease&&) = delete;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() {
+            if (slot_) {
+                slot_->mutex.unlock();
+                sched_->leave_rga();
+            }
+        }
+
+        /// 分配到的核心掩码 (RgaCoreMask::AUTO 表示由驱动选择)
+        int core() const { return slot_->core; }
+
+    private:
+        friend class RgaScheduler;
+        Lease(RgaScheduler* sched, Slot* slot) : sched_(sched), slot_(slot) {}
+        RgaScheduler* sched_;
+        Slot* slot_;
+    };
+
+    /// NPU 初始化期 (RAII): 持有期间不会有 RGA job 在提交
+    class NpuInit {
+    public:
+        NpuInit(NpuInit&& other) noexcept : sched_(other.sched_) { other.sched_ = nullptr; }
+        NpuInit& operator=(NpuInit&&) = delete;
+        NpuInit(const NpuInit&) = delete;
+        NpuInit& operator=(const NpuInit&) = delete;
+        ~NpuInit() {
+            if (sched_) sched_->end_npu_init();
+        }
+
+    private:
+        friend class RgaScheduler;
+        explicit NpuInit(RgaScheduler* sched) : sched_(sched) {}
+        RgaScheduler* sched_;
+    };
+
+    /// 进程级调度器 (不析构, 解码线程可能晚于静态析构退出)
+    static RgaScheduler& instance();
+
+    /// @param core_mask 参与调度的核心 (RgaCoreMask 位组合, 0=单槽位自动调度)
+    explicit RgaScheduler(int core_mask = RgaCoreMask::AUTO);
+
+    RgaScheduler(const RgaScheduler&) = delete;
+    RgaScheduler& operator=(const RgaScheduler&) = delete;
+
+    /**
+     * @brief 设置参与调度的核心
+     *
+     * 必须在任何 acquire() 之前调用 (启动阶段), 之后调用会被忽略。
+     * @return true 设置生效
+     */
+    bool configure(int core_mask);
+
+    /// 获取一个核心的提交权 (可能阻塞; NPU 初始化期间等待其结束)
+    Lease acquire();
+
+    /// 进入 NPU 初始化期: 等待进行中的 RGA job 结束 (可能阻塞), 之后的 acquire() 等待返回值析构
+    NpuInit begin_npu_init();
+
+    /// 槽位数量
+    size_t core_count() const { return slots_.size(); }
+
+    /// 各核心统计
+    std::vector<CoreStats> get_stats() const;
+
+    /// 每次 acquire() 等待核心的时间分布 (空闲核心直接取得时记 0)
+    const LatencyHistogram& wait_histogram() const { return wait_hist_; }
+
+private:
+    void build_slots(int core_mask);
+    void leave_rga();
+    void end_npu_init();
+
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::atomic<uint32_t> next_{0};
+    std::atomic<bool> started_{false};
+    LatencyHistogram wait_hist_;
+
+    // RGA job 与 NPU 初始化互斥 (两类各自内部可并行)
+    std::mutex gate_mutex_;
+    std::condition_variable gate_cv_;
+    int rga_active_ = 0;            ///< 已进入 acquire() 且尚未释放的 RGA job 数
+    int npu_inits_ = 0;             ///< 进行中的 NPU 初始化数
+    int npu_waiting_ = 0;           ///< 等待 RGA job 结束的 NPU 初始化数
+};
+
+} // namespace infer_server
@@ -0,0 +1,149 @@
+#pragma once
+
+/**
+ * @file admission_controller.h
+ * @brief 负载感知的帧准入控制 (自适应跳帧)
+ *
+ * 固定 frame_skip 不感知 NPU 负载: 过载时帧在推理队列中按 "丢弃最旧" 被丢掉,
+ * 而此前的 RGA 预处理和内存拷贝已经白做。AdmissionController 在解码前决定每帧是否处理,
+ * 不处理的帧走 skip_frame() 轻量路径:
+ *
+ * - 每路流有目标帧率 (StreamConfig::target_fps; 0 = 源帧率 / frame_skip)
+ * - 每路流的单帧推理开销 (StreamCounters::frame_cost_ms, 所有模型耗时之和) 估计其 NPU 占用
+ * - 周期性 update(): 根据推理队列占用率 / 丢弃增量调整全局预算系数 scale (AIMD),
+ *   预算 = worker 数 x 1000 ms/s x scale, 按 NPU 时间做 max-min 公平分配 (water-filling):
+ *   需求小于均分额度的流全部满足, 剩余预算在其他流之间均分, 单路繁忙的流不会挤占其他流
+ * - 每路流按 准入帧率 / 源帧率 做分数累加 (admit), 等效于小数跳帧间隔, 被准入的帧均匀分布
+ *
+ * 纯调度逻辑, 不依赖硬件; 负载通过 LoadProbe 回调获取。
+ */
+
+#include "infer_server/common/types.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+namespace infer_server {
+
+class AdmissionController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// 控制参数
+    struct Options {
+        int update_interval_ms = 500;   ///< 重新分配预算的周期
+        double min_fps = 1.0;           ///< 每路流的最低准入帧率 (过载时也保证不被饿死)
+        double queue_high = 0.75;       ///< 推理队列占用率高水位: 预算乘性收紧
+        double queue_low = 0.25;        ///< 推理队列占用率低水位: 预算加性放宽
+        double default_source_fps = 25.0;  ///< 解码器未报告帧率时假定的源帧率
+    };
+
+    /// 推理引擎负载采样
+    struct LoadSample {
+        size_t queue_depth = 0;         ///< 推理队列当前任务数
+        size_t queue_capacity = 0;      ///< 推理队列容量 (0 = 无队列信号)
+        uint64_t dropped = 0;           ///< 推理队列累计丢弃数
+        size_t workers = 0;             ///< 推理 worker 数 (NPU 时间预算的并行度)
+    };
+
+    using LoadProbe = std::function<LoadSample()>;
+
+    /**
+     * @brief 每路流的准入状态
+     *
+     * admit() / set_source_fps() 仅由该流的解码线程调用;
+     * 分配结果 (allowed_fps) 由 update() 写入, 原子读取, 不加锁。
+     */
+    class Stream {
+    public:
+        Stream(std::string cam_id, int frame_skip, double target_fps,
+               std::shared_ptr<StreamCounters> counters);
+
+        /// 当前帧是否处理 (每个源帧调用一次)
+        bool admit();
+
+        /// 解码器打开后报告源帧率 (<= 0 或明显异常表示未知)
+        void set_source_fps(double fps);
+
+        /// 设置目标帧率 (0 = 源帧率 / frame_skip), 准入帧率立即重置为新的请求帧率
+        void set_target_fps(double fps);
+
+        /// 请求帧率: target_fps 或 源帧率 / frame_skip, 不超过源帧率
+        double demand_fps() const;
+
+        /// 当前分配到的准入帧率
+        double allowed_fps() const { return allowed_fps_.load(std::memory_order_relaxed); }
+
+        /// 等效跳帧间隔 (源帧率 / 准入帧率, 仅用于状态展示)
+        int effective_skip() const;
+
+        double target_fps() const { return target_fps_.load(std::memory_order_relaxed); }
+        const std::string& cam_id() const { return cam_id_; }
+
+        /// 准入控制拒绝的帧数
+        uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+    private:
+        friend class AdmissionController;
+
+        double source_fps() const;
+
+        std::string cam_id_;
+        int frame_skip_;
+        std::shared_ptr<StreamCounters> counters_;
+
+        std::atomic<double> target_fps_;
+        std::atomic<double> source_fps_{0.0};
+        std::atomic<double> allowed_fps_{0.0};
+        std::atomic<uint64_t> rejected_{0};
+        double default_source_fps_ = 25.0;
+
+        // 准入累加器 (仅解码线程访问), 初值保证第一帧被处理
+        double credit_ = 1.0;
+    };
+
+    explicit AdmissionController(Options options, LoadProbe probe = nullptr);
+
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+
+    /// 注册流, 返回解码线程使用的句柄 (初始准入帧率 = 请求帧率)
+    std::shared_ptr<Stream> add_stream(const std::string& cam_id, int frame_skip, double target_fps,
+                                       std::shared_ptr<StreamCounters> counters);
+
+    /// 注销流 (句柄仍可安全使用, 只是不再参与分配)
+    void remove_stream(const std::shared_ptr<Stream>& stream);
+
+    /**
+     * @brief 距上次分配超过 update_interval_ms 时重新分配
+     *
+     * 由解码线程随帧调用; 其他线程正在分配时直接返回, 不阻塞解码。
+     */
+    void maybe_update(Clock::time_point now);
+
+    /// 按负载采样立即重新分配
+    void update(const LoadSample& load);
+
+    /// 当前全局预算系数
+    double scale() const { return scale_.load(std::memory_order_relaxed); }
+
+    size_t stream_count() const;
+
+private:
+    Options options_;
+    LoadProbe probe_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<Stream>> streams_;
+    Clock::time_point last_update_{};
+    uint64_t last_dropped_ = 0;
+
+    std::atomic<double> scale_{1.0};
+};
+
+} // namespace infer_server
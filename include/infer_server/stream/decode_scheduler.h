@@ -0,0 +1,148 @@
+#pragma once
+
+/**
+ * @file decode_scheduler.h
+ * @brief 解码任务调度器: 多路流复用少量解码线程
+ *
+ * 每路流一个解码线程时, 64 路以上低帧率摄像头的线程数、栈内存与上下文切换都不可忽视。
+ * DecodeScheduler 用固定数量的线程轮流执行各路流的 "单步" (打开流 / 读一个包并解码),
+ * 单步返回下一次运行时刻, 重连退避与本地文件限速都变成定时器, 不再占用线程睡眠。
+ *
+ * - 定时器: 按运行时刻排序的有序集合, 线程等待最早到期的任务
+ * - 同一任务不会被两个线程同时执行 (运行期间不在定时器集合中)
+ * - wake(): 立即调度 (停止流时不必等退避结束)
+ * - 挂起: 单步返回 kParked 的任务不进入定时器, 直到 wake() (如等待池外线程打开 RTSP)
+ * - wait(): 等待任务结束 (单步返回 nullopt 后从调度器移除)
+ *
+ * RTSP 解复用 (av_read_frame) 不支持非阻塞读取, 单步仍可能阻塞在网络上。
+ * ArrivalPredictor 按视频包时间戳预测下一个包的到达时刻, 在包到达后才去读,
+ * 使单步基本不阻塞, 池线程不被空等的流占用。
+ *
+ * 纯调度逻辑, 不依赖 FFmpeg。
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace infer_server {
+
+class DecodeScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// 单步: 返回下一次运行时刻, nullopt 表示任务结束
+    using StepFn = std::function<std::optional<Clock::time_point>()>;
+
+    /// 单步返回此时刻: 挂起, 直到 wake()
+    static constexpr Clock::time_point kParked = Clock::time_point::max();
+
+    /// 调度统计
+    struct Stats {
+        int threads = 0;            ///< 池线程数
+        size_t tasks = 0;           ///< 注册的任务数
+        int busy = 0;               ///< 正在执行单步的线程数
+        uint64_t steps = 0;         ///< 累计单步数
+        double lag_ms = 0.0;        ///< 到期到实际开始执行的延迟 (滑动平均, ms)
+    };
+
+    /// @param num_threads 池线程数 (>= 1)
+    explicit DecodeScheduler(int num_threads);
+    ~DecodeScheduler();
+
+    DecodeScheduler(const DecodeScheduler&) = delete;
+    DecodeScheduler& operator=(const DecodeScheduler&) = delete;
+
+    /**
+     * @brief 注册任务
+     * @param name  任务名 (日志用, 如 cam_id)
+     * @param step  单步函数, 在池线程上调用
+     * @param parked true: 注册后挂起, 由 wake() 开始运行 (调用方先保存任务 ID, 单步中才能安全使用)
+     * @return 任务 ID (> 0)
+     */
+    uint64_t add(std::string name, StepFn step, bool parked = false);
+
+    /// 立即调度任务 (正在执行时, 本次单步结束后立即再次执行)
+    void wake(uint64_t id);
+
+    /// 等待任务结束 (不能在该任务自身的单步中调用)
+    void wait(uint64_t id);
+
+    /// 停止所有线程 (未结束的任务被丢弃, 调用方应先让任务自行结束)
+    void stop();
+
+    Stats stats() const;
+
+    int num_threads() const { return static_cast<int>(threads_.size()); }
+
+private:
+    struct Task {
+        std::string name;
+        StepFn step;
+        Clock::time_point due;
+        bool running = false;
+        bool woken = false;     ///< 运行期间收到 wake()
+    };
+
+    void run(int index);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;        ///< 定时器变化 / 停止
+    std::condition_variable done_cv_;   ///< 任务结束
+    std::map<uint64_t, Task> tasks_;
+    std::set<std::pair<Clock::time_point, uint64_t>> timers_;
+    uint64_t next_id_ = 1;
+    bool stopping_ = false;
+
+    int busy_ = 0;
+    uint64_t steps_ = 0;
+    double lag_ms_ = 0.0;
+
+    std::vector<std::thread> threads_;
+};
+
+/**
+ * @brief 视频包到达时刻预测
+ *
+ * 摄像头按固定帧间隔发送视频包。读取时记录 "接收时刻 - 包时间戳" 的偏移:
+ * 读取阻塞过 (包刚到达) 时偏移即为真实值; 之后每个包的期望到达时刻 = 时间戳 + 偏移。
+ * - 读到的包已落后期望时刻半个帧间隔以上: 有积压, 立即再读
+ * - 否则: 下一次在下一个包的期望到达时刻 (+ guard) 再读
+ */
+class ArrivalPredictor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// @param guard 在期望到达时刻之后多等的时间 (吸收网络抖动)
+    explicit ArrivalPredictor(std::chrono::microseconds guard = std::chrono::microseconds(2000))
+        : guard_(guard) {}
+
+    /**
+     * @brief 读完一个视频包后计算下次读取时刻
+     * @param now     读取完成时刻
+     * @param pts_ms  包时间戳 (毫秒)
+     * @param blocked 本次读取是否等待了网络数据
+     * @param fps     视频帧率 (<= 0 时立即再读)
+     */
+    Clock::time_point next_read(Clock::time_point now, int64_t pts_ms, bool blocked, double fps);
+
+    /// 流重新打开后时间戳不连续, 清除偏移
+    void reset() { has_offset_ = false; }
+
+private:
+    std::chrono::microseconds guard_;
+    bool has_offset_ = false;
+    int64_t offset_us_ = 0;     ///< 接收时刻 (steady_clock 微秒) - 包时间戳 (微秒)
+};
+
+} // namespace infer_server
@@ -0,0 +1,73 @@
+#pragma once
+
+/**
+ * @file model_retirement.h
+ * @brief 热切换后旧模型的延迟卸载
+ *
+ * swap_model() 在流切换到新模型后, 旧模型要等所有旧 ModelBinding 释放 (没有排队 / 在途任务)
+ * 才能卸载。切换超时或旧任务迟迟未排空时, 旧模型登记在这里, 之后由预处理线程 / 删除流时重试:
+ *
+ * - retire(): 登记旧模型及其旧绑定
+ * - claim():  绑定全部释放且不再被任何流引用的模型转为 "卸载中" 并返回, 由调用方在锁外卸载;
+ *             仍被流引用 (重新投入使用) 的模型不再登记
+ * - finish(): 卸载结束, 唤醒 wait_unloaded() 的等待者
+ *
+ * 卸载在 StreamManager::mutex_ 之外进行, 引用卸载中模型的 add_stream / swap_model 先等待其结束,
+ * 再重新加载。纯逻辑, 不依赖硬件; 内部加锁, 各方法可并发调用。
+ */
+
+#include "infer_server/common/types.h"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace infer_server {
+
+class ModelRetirement {
+public:
+    /// 模型是否仍被某个流引用 (claim() 的调用方保证判断期间流配置不变)
+    using InUse = std::function<bool(const std::string& model_path)>;
+
+    /// 登记待卸载的旧模型 (同一模型多次登记时合并绑定)
+    void retire(const std::string& model_path, std::vector<std::weak_ptr<const ModelBinding>> bindings);
+
+    /**
+     * @brief 取出可以卸载的模型并标记为卸载中
+     * @return 绑定已全部释放、且 in_use 为 false 的模型 (调用方卸载后须对每个调用 finish())
+     */
+    std::vector<std::string> claim(const InUse& in_use);
+
+    /// 取消登记 (模型重新投入使用, 如再次切换回该模型)
+    void cancel(const std::string& model_path);
+
+    /// 直接标记为卸载中 (不等待绑定释放); 已在卸载中时返回 false
+    bool begin_unload(const std::string& model_path);
+
+    /// 卸载结束
+    void finish(const std::string& model_path);
+
+    /// 列表中的模型是否有正在卸载的
+    bool unloading(const std::vector<std::string>& model_paths) const;
+
+    /// 等待列表中的模型都结束卸载
+    void wait_unloaded(const std::vector<std::string>& model_paths) const;
+
+    /// 已登记、尚未卸载的模型数
+    size_t retired_count() const;
+
+private:
+    bool unloading_locked(const std::vector<std::string>& model_paths) const;
+
+    mutable std::mutex mutex_;
+    mutable std::condition_variable cv_;
+    std::unordered_map<std::string, std::vector<std::weak_ptr<const ModelBinding>>> retired_;
+    std::unordered_set<std::string> unloading_;
+};
+
+} // namespace infer_server
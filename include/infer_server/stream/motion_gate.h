@@ -0,0 +1,79 @@
+#pragma once
+
+/**
+ * @file motion_gate.h
+ * @brief 场景变化门控 (静止画面跳过推理)
+ *
+ * 室内摄像头大部分时间画面静止, 每帧仍要经过 RGA + NPU + 后处理。
+ * MotionGate 在预处理前用亮度缩略图判断场景是否变化:
+ *
+ * - 从 NV12 的 Y 平面采样 kThumbWidth x kThumbHeight 的缩略图 (每点 2x2 均值, 抑制噪声)
+ * - 与最近一次推理帧的缩略图逐块 (kBlockWidth x kBlockHeight) 计算平均绝对差 (SAD / 像素数),
+ *   块宽 16 字节正好是一个 NEON 向量
+ * - 超过 threshold 的块数 >= min_blocks 视为变化, 推理并更新参考帧;
+ *   否则跳过推理, 但连续跳过超过 max_skip_ms 时强制推理一帧 (缓慢变化也会累积到参考帧差异中)
+ *
+ * 纯 CPU 逻辑, 不依赖硬件; 每路流一个实例, 仅由该流的预处理线程调用。
+ */
+
+#include <cstdint>
+#include <vector>
+
+namespace infer_server {
+
+class MotionGate {
+public:
+    static constexpr int kThumbWidth = 128;     ///< 缩略图宽度 (像素)
+    static constexpr int kThumbHeight = 72;     ///< 缩略图高度 (像素)
+    static constexpr int kBlockWidth = 16;      ///< 比较块宽度
+    static constexpr int kBlockHeight = 8;      ///< 比较块高度
+    static constexpr int kBlockCols = kThumbWidth / kBlockWidth;
+    static constexpr int kBlockRows = kThumbHeight / kBlockHeight;
+
+    /// 门控参数
+    struct Options {
+        double threshold = 8.0;     ///< 块平均亮度差阈值 (0~255)
+        int min_blocks = 1;         ///< 判定为变化所需的最少变化块数
+        int max_skip_ms = 10000;    ///< 最长连续跳过时长, 超过后强制推理一帧 (0 = 不限)
+    };
+
+    explicit MotionGate(const Options& options);
+
+    /**
+     * @brief 从 Y 平面采样缩略图
+     * @param y      Y 平面起始地址
+     * @param stride 行步长 (字节)
+     * @param thumb  输出, kThumbWidth * kThumbHeight 字节
+     */
+    static void downsample(const uint8_t* y, int width, int height, int stride, uint8_t* thumb);
+
+    /**
+     * @brief 判断当前帧是否需要推理
+     *
+     * 首帧、场景变化或超过 max_skip_ms 时返回 true 并把缩略图设为新的参考帧。
+     * @param thumb        kThumbWidth x kThumbHeight 的亮度缩略图 (可由 downsample 或 RGA 缩放得到)
+     * @param timestamp_ms 帧时间戳 (毫秒)
+     */
+    bool check(const uint8_t* thumb, int64_t timestamp_ms);
+
+    /// 清空参考帧 (流重启后下一帧必定推理)
+    void reset();
+
+    /// 上一次 check 中变化最大的块的平均亮度差
+    double last_score() const { return last_score_; }
+
+    /// 上一次 check 中超过阈值的块数
+    int last_changed_blocks() const { return last_changed_; }
+
+    /// 单块 SAD (kBlockWidth x kBlockHeight, 两幅图行步长相同)
+    static uint32_t block_sad(const uint8_t* a, const uint8_t* b, int stride);
+
+private:
+    Options options_;
+    std::vector<uint8_t> reference_;    ///< 最近一次推理帧的缩略图 (空 = 无参考帧)
+    int64_t reference_ms_ = 0;          ///< 参考帧时间戳
+    double last_score_ = 0.0;
+    int last_changed_ = 0;
+};
+
+} // namespace infer_server
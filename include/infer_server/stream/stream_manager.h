@@ -6,18 +6,34 @@
  *
  * StreamManager 是 Phase 4 的核心编排组件:
  * - 管理所有 RTSP 流的添加/删除/启停
- * - 每个流拥有独立的解码线程
- * - 解码线程内部完成: RTSP解码 -> 跳帧 -> RGA缩放 -> 推理提交 + 图片缓存
+ * - 每个流拥有三级流水线, 阶段间由 BoundedQueue (decode_queue_size, 满时丢弃最旧) 连接:
+ *     解码线程:   RTSP 解复用 -> 准入控制 (自适应跳帧) -> 解码
+ *     预处理线程: RGA 缩放 -> 推理提交
+ *     编码线程:   JPEG 编码 -> 图片缓存
+ *   下游变慢只会丢帧, 不会阻塞 RTSP 读取
+ * - 解码可由共享线程池 (decode_threads > 0, DecodeScheduler) 按包单步推进,
+ *   替代每路流一个解码线程; 打开 / 重连在专用打开线程上依次进行, 预处理与编码线程仍按流独立
+ * - 可选的压缩码流环形缓冲 (PacketRing), 用于导出报警视频片段
  * - 自动重连 (指数退避)
- * - 运行时统计 (原子计数器)
+ * - 运行时统计 (原子计数器), 查询接口读取按周期重建的不可变状态快照
+ * - 模型热切换 (加载新模型, 帧边界替换, 旧模型排空后卸载)
  * - 配置持久化 (重启恢复)
  */
 
 #include "infer_server/common/config.h"
 #include "infer_server/common/types.h"
+#include "infer_server/common/bounded_queue.h"
+#include "infer_server/cache/packet_ring.h"
+#include "infer_server/inference/frame_result_collector.h"
+#include "infer_server/stream/admission_controller.h"
+#include "infer_server/stream/decode_scheduler.h"
+#include "infer_server/stream/model_retirement.h"
+#include "infer_server/stream/motion_gate.h"
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <condition_variable>
 #include <unordered_map>
 #include <memory>
 #include <mutex>
@@ -26,6 +42,7 @@
 #include <chrono>
 #include <optional>
 #include <functional>
+#include <utility>
 
 namespace infer_server {
 
@@ -36,6 +53,8 @@ class ImageCache;
 class InferenceEngine;
 #endif
 
+class StreamTrackers;
+
 class JpegEncoder;
 
 /**
@@ -94,10 +113,31 @@ public:
 
     // === 查询 ===
 
-    /// 获取所有流的运行状态
+    /// 全部流的运行状态快照 (构造后不可变, 可在任意线程持有)
+    struct StatusSnapshot {
+        std::vector<StreamStatus> streams;
+        std::chrono::steady_clock::time_point built_at;
+        uint64_t generation = 0;        ///< 构造时的流配置版本 (增删 / 启停 / 配置变更时递增)
+
+        /// 按 cam_id 查找 (未找到返回 nullptr)
+        const StreamStatus* find(const std::string& cam_id) const;
+    };
+
+    /**
+     * @brief 获取状态快照
+     *
+     * 快照超过 max_age_ms 时由一个读取者重建 (持 mutex_ 一次, 为所有流构造 StreamStatus),
+     * 同时到达的其他读取者不等待, 直接返回旧快照; 轮询再频繁也不会让 mutex_ 的占用超过每周期一次。
+     * 流的增删 / 启停 / 配置变更使快照立即失效, 之后的读取等待重建, 保证读到已完成的写操作。
+     *
+     * @param max_age_ms 允许的快照年龄 (ms); < 0 取 ServerConfig::status_refresh_ms, 0 = 总是重建
+     */
+    std::shared_ptr<const StatusSnapshot> status_snapshot(int max_age_ms = -1) const;
+
+    /// 获取所有流的运行状态 (取自 status_snapshot(), 计数最多滞后 status_refresh_ms)
     std::vector<StreamStatus> get_all_status() const;
 
-    /// 获取单个流的运行状态
+    /// 获取单个流的运行状态 (同上)
     std::optional<StreamStatus> get_status(const std::string& cam_id) const;
 
     /// 获取所有流的配置
@@ -109,6 +149,67 @@ public:
     /// 当前流数量
     size_t stream_count() const;
 
+    /**
+     * @brief 设置流的目标推理帧率并持久化
+     * @param target_fps 目标帧率 (0 = 源帧率 / frame_skip)
+     * @return false 流不存在
+     */
+    bool set_target_fps(const std::string& cam_id, double target_fps);
+
+    /// 准入控制的全局预算系数 (adaptive_skip 关闭时返回 0)
+    double admission_scale() const;
+
+    /// 解码线程池统计 (decode_threads = 0, 每路流独立解码线程时返回 nullopt)
+    std::optional<DecodeScheduler::Stats> decode_pool_stats() const;
+
+    /// 延迟直方图快照: 流级 (所有阶段) 或流 x 模型 (排队 / NPU / 后处理)
+    struct LatencyReport {
+        std::string cam_id;
+        std::string task_name;              ///< 为空 = 流级
+        std::string model_path;
+        std::vector<std::pair<LatencyStage, LatencyHistogram::Snapshot>> stages;  ///< 只含有样本的阶段
+    };
+
+    /// 所有流的延迟直方图快照 (流级在前, 随后是该流各模型)
+    std::vector<LatencyReport> latency_reports() const;
+
+    // === 模型热切换 ===
+
+    /// swap_model() 的结果
+    struct ModelSwapResult {
+        bool ok = false;
+        std::string error;
+        std::vector<std::string> swapped;   ///< 已切换到新模型的流
+        std::vector<std::string> pending;   ///< 超时前尚未切换的流 (预处理线程在下一帧 / 重启后切换)
+        bool old_unloaded = false;          ///< 旧模型的任务已排空且不再被引用, 已卸载 (否则稍后自动卸载)
+        double load_ms = 0.0;               ///< 新模型加载 + worker context 预创建耗时
+        double drain_ms = 0.0;              ///< 切换后等待旧模型任务排空的耗时
+    };
+
+    /**
+     * @brief 模型热切换: 加载新模型后把流引用的旧模型替换为新模型, 旧模型排空后卸载
+     *
+     * 1. 加载 new_path 并在 worker 上预创建 context (流继续用旧模型推理)
+     * 2. 为每个目标流构造新的 ModelBinding / 级联计划, 由预处理线程在帧边界一次性替换
+     *    (新模型除路径外沿用旧模型的配置, 输入尺寸必须与配置一致)
+     * 3. 等待旧模型的排队 / 在途任务全部完成 (旧 ModelBinding 不再被引用),
+     *    没有流再引用旧模型时经 InferenceEngine::unload_model() 释放各 worker 的 context
+     *    (在 mutex_ 之外卸载; 超时未切换 / 未排空时由预处理线程在旧绑定全部释放后卸载)
+     *
+     * 阻塞调用 (REST 线程); new_path 必须与 old_path 不同 (同一路径的覆盖重载不支持)。
+     *
+     * @param cam_ids    只切换这些流 (为空 = 所有引用 old_path 的流)
+     * @param timeout_ms 等待切换与排空的最长时间 (各自计时)
+     */
+    ModelSwapResult swap_model(const std::string& old_path, const std::string& new_path,
+                               const std::vector<std::string>& cam_ids = {}, int timeout_ms = 5000);
+
+    /**
+     * @brief 从码流缓存提取报警片段
+     * @return 片段 (解码顺序的压缩包), 流不存在 / 未启用码流缓存 / 窗口内无数据返回 nullopt
+     */
+    std::optional<Clip> get_clip(const std::string& cam_id, int64_t start_ms, int64_t end_ms) const;
+
     // === 持久化 ===
 
     /// 保存所有流配置到磁盘
@@ -122,31 +223,147 @@ public:
     /// 优雅关闭 (停止所有流)
     void shutdown();
 
-    /// 当推理结果完成时的回调 (用于递增 inferred_frames 统计)
+    /// 当推理结果完成时的回调 (用于递增 inferred_frames 统计; 通过结果携带的计数器句柄, 不加锁)
     void on_infer_result(const FrameResult& result);
 
 private:
+    /// 共享同一预处理结果的模型组
+    /// 所有模型输入均为 RGB888 NHWC, 因此仅按 (input_width, input_height, resize_mode, 区域) 分组
+    struct PreprocessGroup {
+        int input_width = 0;
+        int input_height = 0;
+        bool letterbox = true;              ///< false = 拉伸 (resize_mode = "stretch")
+        std::vector<RoiConfig> regions;     ///< ROI / 分块区域, 每个区域一次 RGA 输出 (为空 = 整帧)
+        std::vector<size_t> model_indices;  ///< 在 StreamConfig::models 中的下标
+    };
+
+    /// 级联第二级模型 (只在第一级模型选定类别的检测框裁剪上推理)
+    struct CascadeStage {
+        std::shared_ptr<const ModelBinding> binding;
+        int slot = 0;                       ///< 在 StreamConfig::models 中的下标 (聚合器槽位)
+        bool letterbox = true;              ///< false = 拉伸 (resize_mode = "stretch")
+        std::vector<std::string> classes;   ///< 触发类别名或类别 ID (为空 = 所有类别)
+        float expand = 0.1f;                ///< 裁剪框扩展比例
+        int max_crops = 8;                  ///< 单帧最多裁剪数
+    };
+
+    /// 第一级模型 task_name -> 依赖它的第二级模型 (添加流时构造, 该流所有帧共享)
+    using CascadePlan = std::unordered_map<std::string, std::vector<CascadeStage>>;
+
+    /// 为第二级裁剪保留的解码帧 (所有第一级模型结果处理完后释放)
+    struct CascadeFrame {
+        std::shared_ptr<std::vector<uint8_t>> nv12_data;
+        std::shared_ptr<DmaBuffer> dma_buf;
+        int width = 0;                      ///< 解码输出尺寸 (RGA 源)
+        int height = 0;
+        int orig_w = 0;                     ///< 原始分辨率 (检测框坐标空间)
+        int orig_h = 0;
+        uint64_t frame_id = 0;
+        int64_t pts = 0;
+        int64_t timestamp_ms = 0;
+        std::atomic<int> parents_pending{0};  ///< 尚未处理的第一级模型数
+
+        /// 一个第一级结果处理完毕; 全部处理完后不再需要解码帧, 尽早归还给解码器 / 缓冲池
+        void release_parent() {
+            if (parents_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                nv12_data.reset();
+                dma_buf.reset();
+            }
+        }
+    };
+
+    /// 级联裁剪任务 (推理线程 -> 级联线程)
+    struct CascadeJob {
+        std::shared_ptr<const CascadePlan> plan;
+        std::shared_ptr<CascadeFrame> frame;
+        ModelResult parent;                             ///< 第一级模型结果
+        std::shared_ptr<FrameResultCollector> collector;
+    };
+
+    /// 待编码的缓存帧 (预处理线程 -> 编码线程)
+    struct EncodeJob {
+        uint64_t frame_id = 0;
+        int64_t timestamp_ms = 0;
+        int width = 0;
+        int height = 0;
+        std::shared_ptr<std::vector<uint8_t>> nv12;  ///< NV12 缩略图 (偶数宽高)
+    };
+
+    /// 解码状态机 (打开 / 逐包解码 / 重连退避), 在 .cpp 中定义
+    struct DecodeSession;
+
     /// 流上下文 (每个流的内部状态)
     struct StreamContext {
+        /// @param queue_size 流水线各级队列容量 (在 .cpp 中定义, JpegEncoder 为不完整类型)
+        explicit StreamContext(size_t queue_size);
+        ~StreamContext();
+
         StreamConfig config;
         std::atomic<int> state{static_cast<int>(StreamState::Stopped)};
-        std::thread decode_thread;
+        std::thread decode_thread;                      ///< 独立解码线程 (decode_threads = 0)
+        std::unique_ptr<DecodeSession> decode_session;  ///< 解码状态, 由解码线程或解码线程池单步推进
+        std::atomic<uint64_t> decode_task{0};           ///< 解码线程池任务 ID (0 = 独立解码线程)
         std::atomic<bool> running{false};
         std::atomic<bool> stop_requested{false};
 
         // 原子统计计数器
         std::atomic<uint64_t> decoded_frames{0};
-        std::atomic<uint64_t> inferred_frames{0};
+        std::atomic<uint64_t> demux_discarded{0};   ///< 按 decode_mode 在解复用层丢弃的包数
+        std::shared_ptr<StreamCounters> counters = std::make_shared<StreamCounters>();  ///< 推理结果计数 (经 ModelBinding 共享)
         std::atomic<uint32_t> reconnect_count{0};
         std::string last_error;
         mutable std::mutex error_mutex;
         std::chrono::steady_clock::time_point start_time;
 
-        // 每个流拥有独立的 JPEG 编码器
+        // 流水线队列 (解码 -> 预处理 -> 编码)
+        BoundedQueue<DecodedFrame> frame_queue;
+        BoundedQueue<EncodeJob> encode_queue;
+        std::shared_ptr<BoundedQueue<CascadeJob>> cascade_queue;  ///< 级联裁剪 (经 stage hook 共享, 流移除后推入失败)
+
+        // 各阶段单帧耗时滑动平均 (ms), 仅由对应阶段线程写入
+        std::atomic<double> decode_ms{0.0};
+        std::atomic<double> preprocess_ms{0.0};
+        std::atomic<double> encode_ms{0.0};
+
+        // 每个流拥有独立的 JPEG 编码器 (各自的 TurboJPEG handle / MPP 上下文)
         std::unique_ptr<JpegEncoder> jpeg_encoder;
 
-        // 标签缓存: model_path -> labels
-        std::unordered_map<std::string, std::vector<std::string>> labels_cache;
+        // 压缩码流缓存 (clip_duration_sec > 0 时创建, 解码线程写入)
+        std::shared_ptr<PacketRing> packet_ring;
+
+        // 模型绑定: 与 config.models 一一对应, 该流所有 InferTask 共享
+        std::vector<std::shared_ptr<const ModelBinding>> bindings;
+
+        // 预处理分组: 输入尺寸相同的模型共享一次 RGA 转换 (不含级联第二级模型)
+        std::vector<PreprocessGroup> preprocess_groups;
+
+        // 级联计划 (没有级联模型时为空)
+        std::shared_ptr<const CascadePlan> cascade_plan;
+
+        // 跟踪阶段 (没有模型开启跟踪时为空; 经 ModelBinding 随结果共享)
+        std::shared_ptr<const StreamTrackers> trackers;
+        uint64_t processed_frames = 0;              ///< 进入推理的帧数 (infer_interval 计数, 仅预处理线程访问)
+        std::atomic<uint64_t> predicted_results{0}; ///< 由跟踪器外推、未推理的模型结果数
+
+        // 准入控制句柄 (adaptive_skip 关闭时为空, 使用固定 frame_skip)
+        std::shared_ptr<AdmissionController::Stream> admission;
+
+        // 场景变化门控 (motion_threshold = 0 时为空; 仅预处理线程访问)
+        std::unique_ptr<MotionGate> motion_gate;
+        std::atomic<uint64_t> motion_skipped{0};    ///< 场景静止而跳过推理的帧数
+        std::atomic<double> motion_score{0.0};      ///< 最近一帧的变化分数
+
+        // 流引用的模型已结束加载 (预处理线程首次确认后置位; 之前的帧不提交推理)
+        std::atomic<bool> models_ready{false};
+
+        /// 模型热切换: swap_model() 构造, 预处理线程在帧边界持 mutex_ 应用 (流未运行时直接应用)
+        struct ModelSwap {
+            std::vector<std::string> model_paths;   ///< 与 config.models 一一对应
+            std::vector<std::shared_ptr<const ModelBinding>> bindings;
+            std::shared_ptr<const CascadePlan> cascade_plan;
+        };
+        std::unique_ptr<ModelSwap> pending_swap;    ///< mutex_ 保护
+        std::atomic<bool> swap_pending{false};
 
         void set_error(const std::string& err) {
             std::lock_guard<std::mutex> lock(error_mutex);
@@ -158,26 +375,187 @@ private:
         }
     };
 
-    /// 解码线程主函数
+    /// 独立解码线程主函数: 循环执行 decode_step(), 按返回的时刻等待
     void decode_thread_func(StreamContext* ctx);
 
+    /**
+     * @brief 解码单步 (独立解码线程与解码线程池共用)
+     *
+     * 首步启动预处理与编码线程; 之后每步打开流或读取并处理一个包,
+     * 停止时关闭解码器并回收预处理与编码线程。
+     * @return 下一步的运行时刻 (重连退避 / 文件限速 / 预测的下一个包到达时刻), nullopt = 流已停止
+     */
+    std::optional<std::chrono::steady_clock::time_point> decode_step(StreamContext* ctx);
+
+    /// 打开解码器 (Open 阶段); 成功进入 Run 阶段
+    /// @return 下一步的运行时刻 (成功: 立即; 失败: 重连退避)
+    std::chrono::steady_clock::time_point open_decoder(StreamContext* ctx);
+
+    /// 打开线程: 线程池模式下依次执行各流的 open_decoder(), 完成后唤醒其解码任务
+    void opener_loop();
+
+    /// 启动解码 (独立线程或提交到解码线程池; 调用者需持有 mutex_)
+    void launch_decode(StreamContext& ctx);
+
+    /// 等待解码结束 (join 解码线程或等待线程池任务结束)
+    void join_decode(StreamContext& ctx);
+
+    /// 预处理线程: 从 frame_queue 取帧, RGA 预处理并提交推理
+    void preprocess_thread_func(StreamContext* ctx);
+
+    /// 编码线程: 从 encode_queue 取 NV12 缩略图, JPEG 编码 (MPP / TurboJPEG) 后写入缓存
+    void encode_thread_func(StreamContext* ctx);
+
+    /// 级联线程: 从 cascade_queue 取第一级结果, RGA 裁剪并提交第二级任务
+    void cascade_thread_func(StreamContext* ctx);
+
+    /// 处理单帧: RGA + 推理提交 + 投递编码任务
+    void preprocess_frame(StreamContext* ctx, const DecodedFrame& frame);
+
+    /// 场景变化门控: 采样亮度缩略图并与参考帧比较, 返回 false 表示场景静止可跳过推理
+    static bool motion_check(StreamContext* ctx, const DecodedFrame& frame);
+
+    /// 更新阶段耗时滑动平均
+    static void update_stage_ms(std::atomic<double>& avg, std::chrono::steady_clock::time_point start);
+
     /// 构造 StreamStatus 快照
     StreamStatus build_status(const StreamContext& ctx) const;
 
+    /**
+     * @brief 解码输出尺寸: 等比缩小到最大消费者所需的分辨率
+     *
+     * 每个模型输入两个方向都不放大 (scale >= max(model_w / src_w, model_h / src_h)),
+     * ROI / 分块模型按区域尺寸计算 (区域越小需要的分辨率越高),
+     * 缓存缩略图同理; cache_resize_width = 0 (缓存原图宽度) 时不缩放。
+     * @return {0, 0} 表示保持原始分辨率 (缩小不足 3/4 时也不缩放)
+     */
+    static std::pair<int, int> decode_output_size(const ServerConfig& config,
+                                                  const StreamConfig& stream,
+                                                  bool cache_enabled, int src_w, int src_h);
+
+    /// 模型的推理区域: ROI (模型配置优先, 否则取流配置) 按 tile_cols x tile_rows 切块;
+    /// 无 ROI 且不分块时返回空 (整帧)
+    static std::vector<RoiConfig> model_regions(const StreamConfig& stream, const ModelConfig& mc);
+
+    /// 按输入尺寸、缩放方式与推理区域对模型分组 (保持首次出现的顺序; 跳过级联第二级模型)
+    static std::vector<PreprocessGroup> build_preprocess_groups(const StreamConfig& stream);
+
+    /// 每个模型的级联第一级模型下标 (-1 = 整帧推理; cascade_from 无效时同样按整帧处理)
+    static std::vector<int> cascade_parents(const StreamConfig& stream);
+
+    /// 构造级联计划 (没有级联模型时返回空)
+    static std::shared_ptr<const CascadePlan> build_cascade_plan(
+        const StreamConfig& stream, const std::vector<std::shared_ptr<const ModelBinding>>& bindings);
+
+#ifdef HAS_RKNN
+    /// 检测框能否触发第二级模型 (类别匹配且尺寸有效)
+    static bool cascade_candidate(const CascadeStage& stage, const Detection& det);
+
+    /// 第一级结果中是否有触发该第二级模型的检测框
+    static bool cascade_triggered(const CascadeStage& stage, const ModelResult& parent);
+
+    /// 第二级模型槽位的空结果 (没有可裁剪目标 / 裁剪失败)
+    static FrameResultCollector::SlotResult cascade_empty_result(const CascadeStage& stage);
+
+    /**
+     * @brief 第一级模型结果到达时的 stage hook (在推理线程执行, 不做 RGA)
+     *
+     * 没有候选检测框的第二级模型立即返回空结果; 其余投递到级联线程裁剪。
+     * 队列已停止时同样返回空结果; 队列满时被挤出的最旧任务以空结果完成。
+     * @return 立即计入的第二级模型槽位空结果
+     */
+    static std::vector<FrameResultCollector::SlotResult> defer_cascade(
+        const std::shared_ptr<const CascadePlan>& plan, const std::shared_ptr<CascadeFrame>& frame,
+        const ModelResult& parent, const std::shared_ptr<FrameResultCollector>& collector,
+        BoundedQueue<CascadeJob>& queue, InferenceEngine* engine);
+
+    /**
+     * @brief 裁剪检测框并提交第二级任务 (在级联线程执行)
+     *
+     * 所有第二级模型的裁剪合并为一个 RGA job; 每个裁剪一个 InferTask,
+     * 以分块方式 (tile_count = 裁剪数) 汇入同一 collector 的第二级模型槽位, 检测框映射回整帧坐标。
+     * 裁剪失败的槽位以空结果计入, 整帧因此完成时经 engine->publish() 输出。
+     */
+    static void run_cascade(CascadeJob& job, InferenceEngine* engine);
+
+    /// 放弃级联任务 (队列满 / 流停止): 待裁剪的第二级模型槽位以空结果计入
+    static void abandon_cascade(CascadeJob& job, InferenceEngine* engine);
+#endif
+
     /// 加载标签文件
     static std::vector<std::string> load_labels_file(const std::string& path);
 
+    /// 按路径共享的标签表: 仍有流引用时复用, 否则重新加载 (调用者需持有 mutex_)
+    std::shared_ptr<const LabelTable> intern_labels(const std::string& path);
+
+    /// 为流的每个模型构造 ModelBinding (调用者需持有 mutex_)
+    std::vector<std::shared_ptr<const ModelBinding>> build_bindings(
+        const StreamConfig& config, const std::shared_ptr<StreamCounters>& counters,
+        const std::shared_ptr<const StreamTrackers>& trackers);
+
+    /// 为开启跟踪的模型构造跟踪器 (没有模型开启跟踪时返回空)
+    static std::shared_ptr<const StreamTrackers> build_trackers(const StreamConfig& stream);
+
     /// 停止流内部实现 (调用者需持有 mutex_)
     void stop_stream_internal(StreamContext& ctx);
 
+    /// 应用待切换的模型: 替换模型路径、ModelBinding 与级联计划 (调用者需持有 mutex_)
+    void apply_model_swap(StreamContext& ctx);
+
+    /// 模型是否被某个流引用 (待切换的流按切换后的模型计算; 调用者需持有 mutex_)
+    bool model_in_use_locked(const std::string& model_path) const;
+
+    /**
+     * @brief 卸载已排空且不再被引用的旧模型 (持 mutex_ 选出, 在锁外卸载)
+     * @param try_only   拿不到 mutex_ 时直接返回 (预处理线程不能阻塞加锁)
+     * @param timeout_ms 每个模型等待 worker 释放 context 的最长时间
+     * @return 已卸载的模型
+     */
+    std::vector<std::string> unload_retired(bool try_only = false, int timeout_ms = 5000);
+
+    /// 在锁外卸载已由 retirement_ 标记为卸载中的模型, 返回成功卸载的模型
+    std::vector<std::string> unload_claimed(const std::vector<std::string>& model_paths, int timeout_ms);
+
+    /// 使状态快照失效 (在改变流集合 / 配置 / 启停状态之后调用)
+    void invalidate_status() { status_generation_.fetch_add(1, std::memory_order_release); }
+
     ServerConfig config_;
 #ifdef HAS_RKNN
     InferenceEngine* engine_ = nullptr;
 #endif
     ImageCache* cache_ = nullptr;
 
+    /// 自适应跳帧控制器 (adaptive_skip = false 时为空)
+    std::unique_ptr<AdmissionController> admission_;
+
+    /// 共享解码线程池 (decode_threads = 0 时为空)
+    std::unique_ptr<DecodeScheduler> decode_pool_;
+
+    /// 打开 / 重连 RTSP 的专用线程 (仅线程池模式): 打开最长阻塞 connect_timeout + read_timeout,
+    /// 不占用池线程, 离线摄像头的重连不会拖慢其他流的解码
+    std::thread opener_;
+    std::mutex open_mutex_;
+    std::condition_variable open_cv_;
+    std::deque<StreamContext*> open_queue_;     ///< 等待打开的流 (open_mutex_ 保护)
+    bool opener_stop_ = false;
+
     mutable std::mutex mutex_;
     std::unordered_map<std::string, std::unique_ptr<StreamContext>> streams_;
+
+    /// 串行化 swap_model() (同一流不会同时有两次切换)
+    std::mutex swap_mutex_;
+
+    /// 热切换后待卸载 / 正在卸载的旧模型
+    ModelRetirement retirement_;
+
+    /// 标签文件路径 -> 标签表 (弱引用, 最后一个流删除后释放; mutex_ 保护)
+    std::unordered_map<std::string, std::weak_ptr<const LabelTable>> label_tables_;
+
+    /// 状态快照: 读取者以 std::atomic_load 获取, 重建者以 std::atomic_store 发布
+    mutable std::shared_ptr<const StatusSnapshot> status_snapshot_;
+    /// 串行化快照重建 (先于 mutex_ 加锁)
+    mutable std::mutex status_mutex_;
+    std::atomic<uint64_t> status_generation_{0};
 };
 
 } // namespace infer_server
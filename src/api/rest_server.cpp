@@ -7,6 +7,9 @@
 
 #include "infer_server/api/rest_server.h"
 #include "infer_server/common/logger.h"
+#include "infer_server/common/thread_policy.h"
+#include "infer_server/output/result_broadcaster.h"
+#include "infer_server/cluster/cluster_coordinator.h"
 
 #ifdef HAS_TURBOJPEG
 #include "infer_server/cache/image_cache.h"
@@ -16,8 +19,14 @@
 #include "infer_server/inference/inference_engine.h"
 #endif
 
+#ifdef HAS_FFMPEG
+#include "infer_server/cache/clip_muxer.h"
+#endif
+
 #include <httplib.h>
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <unistd.h>
 
 namespace infer_server {
 
@@ -60,7 +69,19 @@ bool RestServer::start() {
     setup_routes();
     start_time_ = std::chrono::steady_clock::now();
 
+    // 请求在线程池中处理, 监听线程只负责 accept
+    // 推送长连接 (MJPEG / SSE) 在连接期间一直占用工作线程, 为其额外预留 http_push_clients 个
+    size_t push_threads = static_cast<size_t>(std::max(config_.http_push_clients, 0));
+    if (config_.http_threads > 0 || push_threads > 0) {
+        size_t threads = (config_.http_threads > 0 ? static_cast<size_t>(config_.http_threads)
+                                                   : static_cast<size_t>(CPPHTTPLIB_THREAD_POOL_COUNT))
+                         + push_threads;
+        server_->new_task_queue = [threads] { return new httplib::ThreadPool(threads); };
+    }
+
     server_thread_ = std::thread([this]() {
+        // 请求处理线程池在 listen() 内由本线程创建, 继承这里设置的亲和性与 nice 值
+        ThreadPolicy::instance().apply(ThreadRole::Http, "http");
         LOG_INFO("REST API server starting on 0.0.0.0:{}", config_.http_port);
         running_ = true;
         bool ok = server_->listen("0.0.0.0", config_.http_port);
@@ -96,6 +117,15 @@ void RestServer::stop() {
     running_ = false;
 }
 
+bool RestServer::acquire_push_slot() {
+    int limit = std::max(config_.http_push_clients, 0);
+    if (push_clients_.fetch_add(1) >= limit) {
+        push_clients_.fetch_sub(1);
+        return false;
+    }
+    return true;
+}
+
 // ============================================================
 // JSON 工具
 // ============================================================
@@ -118,6 +148,185 @@ std::string RestServer::json_error(int code, const std::string& message) {
     return j.dump();
 }
 
+nlohmann::json RestServer::pool_stats_json(const BufferPool::Stats& stats) {
+    json j;
+    j["hits"] = stats.hits;
+    j["misses"] = stats.misses;
+    j["bytes_resident"] = stats.bytes_resident();
+    j["bytes_in_use"] = stats.bytes_in_use;
+    j["idle_buffers"] = stats.idle_buffers;
+    return j;
+}
+
+nlohmann::json RestServer::rates_json(const RateMeter::Rates& rates) {
+    auto round2 = [](double v) { return std::round(v * 100.0) / 100.0; };
+    json j;
+    j["1s"] = round2(rates.last_1s);
+    j["10s"] = round2(rates.last_10s);
+    j["60s"] = round2(rates.last_60s);
+    return j;
+}
+
+std::string RestServer::validate_stream(const StreamConfig& stream_config) {
+    if (stream_config.cam_id.empty()) {
+        return "cam_id is required";
+    }
+    if (stream_config.rtsp_url.empty()) {
+        return "rtsp_url is required";
+    }
+    if (task_priority_to_string(task_priority_from_string(stream_config.priority)) !=
+        stream_config.priority) {
+        return "priority must be critical / normal / best_effort";
+    }
+    if (decode_mode_to_string(decode_mode_from_string(stream_config.decode_mode)) !=
+        stream_config.decode_mode) {
+        return "decode_mode must be all / nonref / keyframe";
+    }
+    auto rois_valid = [](const std::vector<RoiConfig>& rois) {
+        return std::all_of(rois.begin(), rois.end(),
+                           [](const RoiConfig& roi) { return roi.valid(); });
+    };
+    if (!rois_valid(stream_config.rois)) {
+        return "rois must be normalized rectangles inside the frame";
+    }
+    if (stream_config.motion_threshold < 0.0 || stream_config.motion_threshold > 255.0 ||
+        stream_config.motion_min_blocks < 1 ||
+        stream_config.motion_min_blocks > MotionGate::kBlockCols * MotionGate::kBlockRows ||
+        stream_config.motion_max_skip_ms < 0) {
+        return "motion_threshold must be 0-255, motion_min_blocks 1-72, "
+               "motion_max_skip_ms >= 0";
+    }
+    if (stream_config.motion_skip_action != "republish" &&
+        stream_config.motion_skip_action != "suppress") {
+        return "motion_skip_action must be republish / suppress";
+    }
+    for (const auto& mc : stream_config.models) {
+        if (mc.resize_mode != "letterbox" && mc.resize_mode != "stretch") {
+            return "resize_mode must be letterbox / stretch";
+        }
+        if (!rois_valid(mc.rois)) {
+            return "rois must be normalized rectangles inside the frame";
+        }
+        if (!mc.cascade_from.empty()) {
+            auto parent = std::find_if(
+                stream_config.models.begin(), stream_config.models.end(),
+                [&mc](const ModelConfig& m) { return m.task_name == mc.cascade_from; });
+            if (parent == stream_config.models.end() || &*parent == &mc ||
+                !parent->cascade_from.empty() || mc.cascade_max_crops < 1 ||
+                mc.cascade_expand < 0.0f || mc.cascade_expand > 1.0f) {
+                return "cascade_from must name a full-frame model of this "
+                       "stream, cascade_max_crops >= 1, cascade_expand 0 ~ 1";
+            }
+        }
+        if (mc.tile_cols < 1 || mc.tile_rows < 1 || mc.tile_cols * mc.tile_rows > 16 ||
+            mc.tile_overlap < 0.0f || mc.tile_overlap > 0.5f) {
+            return "tile_cols / tile_rows must be >= 1 (at most 16 tiles), "
+                   "tile_overlap must be 0 ~ 0.5";
+        }
+        if (mc.infer_interval < 1 || (mc.infer_interval > 1 && !mc.track) ||
+            mc.track_high_threshold <= 0.0f || mc.track_high_threshold > 1.0f ||
+            mc.track_iou_threshold <= 0.0f || mc.track_iou_threshold > 1.0f ||
+            mc.track_max_age_ms < 0) {
+            return "infer_interval must be >= 1 (> 1 requires track), "
+                   "track thresholds 0 ~ 1, track_max_age_ms >= 0";
+        }
+    }
+
+    return {};
+}
+
+std::string RestServer::prometheus_metrics() const {
+    using Labels = PrometheusWriter::Labels;
+    PrometheusWriter w;
+
+    // 分阶段延迟: 同名指标连续输出, 先流级再流 x 模型
+    auto reports = stream_mgr_.latency_reports();
+    for (const auto& r : reports) {
+        if (!r.task_name.empty()) continue;
+        for (const auto& [stage, snap] : r.stages) {
+            w.summary("infer_server_stage_latency_seconds", "Per-stream pipeline stage latency",
+                      Labels{{"cam_id", r.cam_id}, {"stage", latency_stage_name(stage)}}, snap);
+        }
+    }
+    for (const auto& r : reports) {
+        if (r.task_name.empty()) continue;
+        for (const auto& [stage, snap] : r.stages) {
+            w.summary("infer_server_model_latency_seconds", "Per-stream per-model inference latency",
+                      Labels{{"cam_id", r.cam_id}, {"task", r.task_name}, {"model", r.model_path},
+                             {"stage", latency_stage_name(stage)}}, snap);
+        }
+    }
+
+    // 流计数器
+    auto snapshot = stream_mgr_.status_snapshot();
+    auto per_stream = [&](const char* name, const char* help, auto field) {
+        for (const auto& st : snapshot->streams) {
+            w.sample(name, "counter", help, Labels{{"cam_id", st.cam_id}}, static_cast<double>(field(st)));
+        }
+    };
+    per_stream("infer_server_stream_decoded_frames_total", "Frames output by the decoder",
+               [](const StreamStatus& st) { return st.decoded_frames; });
+    per_stream("infer_server_stream_inferred_frames_total", "Frames with all models inferred",
+               [](const StreamStatus& st) { return st.inferred_frames; });
+    per_stream("infer_server_stream_dropped_frames_total", "Frames dropped by the preprocess and infer queues",
+               [](const StreamStatus& st) { return st.dropped_frames; });
+    per_stream("infer_server_stream_infer_dropped_total", "Infer tasks evicted from a full queue",
+               [](const StreamStatus& st) { return st.infer_dropped; });
+    per_stream("infer_server_stream_infer_expired_total", "Infer tasks dropped after their deadline",
+               [](const StreamStatus& st) { return st.infer_expired; });
+    per_stream("infer_server_stream_admission_skipped_total", "Frames skipped by admission control",
+               [](const StreamStatus& st) { return st.admission_skipped; });
+    per_stream("infer_server_stream_motion_skipped_total", "Frames skipped on static scenes",
+               [](const StreamStatus& st) { return st.motion_skipped; });
+
+#ifdef HAS_RKNN
+    if (engine_) {
+        w.sample("infer_server_infer_queue_depth", "gauge", "Queued infer tasks", {},
+                 static_cast<double>(engine_->queue_size()));
+        w.sample("infer_server_infer_queue_capacity", "gauge", "Infer queue capacity", {},
+                 static_cast<double>(engine_->queue_capacity()));
+        w.sample("infer_server_infer_queue_dropped_total", "counter", "Infer tasks evicted from a full queue", {},
+                 static_cast<double>(engine_->queue_dropped()));
+        w.sample("infer_server_infer_queue_expired_total", "counter", "Infer tasks dropped after their deadline", {},
+                 static_cast<double>(engine_->queue_expired()));
+        w.sample("infer_server_infer_processed_total", "counter", "Infer tasks processed by all workers", {},
+                 static_cast<double>(engine_->total_processed()));
+        auto workers = engine_->worker_stats();
+        for (const auto& ws : workers) {
+            w.sample("infer_server_npu_utilization", "gauge", "NPU busy ratio since start",
+                     Labels{{"worker", std::to_string(ws.worker_id)}}, ws.npu_utilization);
+        }
+        auto out = engine_->output_stats();
+        w.sample("infer_server_output_queue_depth", "gauge", "Results waiting for the output stage", {},
+                 static_cast<double>(out.queued));
+        w.sample("infer_server_output_dropped_total", "counter", "Results dropped by a full output queue", {},
+                 static_cast<double>(out.dropped));
+    }
+#endif
+
+    w.sample("infer_server_http_push_clients", "gauge", "Open MJPEG / SSE push connections", {},
+             static_cast<double>(push_clients_.load()));
+
+    // RGA 核心等待
+    const auto& rga = RgaScheduler::instance();
+    w.summary("infer_server_rga_wait_seconds", "Time waiting for an RGA core per job", {},
+              rga.wait_histogram().snapshot());
+    auto cores = rga.get_stats();
+    for (const auto& cs : cores) {
+        w.sample("infer_server_rga_jobs_total", "counter", "RGA jobs submitted",
+                 Labels{{"core", std::to_string(cs.core)}}, static_cast<double>(cs.jobs));
+    }
+    for (const auto& cs : cores) {
+        w.sample("infer_server_rga_contended_total", "counter", "RGA jobs that had to wait for a core",
+                 Labels{{"core", std::to_string(cs.core)}}, static_cast<double>(cs.contended));
+    }
+    for (const auto& cs : cores) {
+        w.sample("infer_server_rga_wait_seconds_total", "counter", "Total time waiting for an RGA core",
+                 Labels{{"core", std::to_string(cs.core)}}, static_cast<double>(cs.wait_us) * 1e-6);
+    }
+    return w.str();
+}
+
 // ============================================================
 // 路由注册
 // ============================================================
@@ -132,14 +341,10 @@ void RestServer::setup_routes() {
             auto j = json::parse(req.body);
             auto stream_config = j.get<StreamConfig>();
 
-            if (stream_config.cam_id.empty()) {
+            std::string invalid = validate_stream(stream_config);
+            if (!invalid.empty()) {
                 res.status = 400;
-                res.set_content(json_error(400, "cam_id is required"), "application/json");
-                return;
-            }
-            if (stream_config.rtsp_url.empty()) {
-                res.status = 400;
-                res.set_content(json_error(400, "rtsp_url is required"), "application/json");
+                res.set_content(json_error(400, invalid), "application/json");
                 return;
             }
 
@@ -191,9 +396,9 @@ void RestServer::setup_routes() {
     // ----------------------------------------------------------
     server_->Get("/api/streams", [this](const httplib::Request&, httplib::Response& res) {
         res.set_header("Content-Type", "application/json");
-        auto statuses = stream_mgr_.get_all_status();
+        auto snapshot = stream_mgr_.status_snapshot();
         json data = json::array();
-        for (const auto& s : statuses) {
+        for (const auto& s : snapshot->streams) {
             data.push_back(s);
         }
         res.set_content(json_ok("success", data), "application/json");
@@ -225,8 +430,8 @@ void RestServer::setup_routes() {
         res.set_header("Content-Type", "application/json");
         std::string cam_id = req.matches[1];
 
-        auto status = stream_mgr_.get_status(cam_id);
-        if (status) {
+        auto snapshot = stream_mgr_.status_snapshot();
+        if (const StreamStatus* status = snapshot->find(cam_id)) {
             json data = *status;
             res.set_content(json_ok("success", data), "application/json");
         } else {
@@ -273,6 +478,91 @@ void RestServer::setup_routes() {
         }
     });
 
+    // ----------------------------------------------------------
+    // POST /api/streams/:cam_id/fps -- 设置目标推理帧率
+    // Body: {"target_fps": 5} (0 = 恢复按 frame_skip 跳帧)
+    // ----------------------------------------------------------
+    server_->Post(R"(/api/streams/([^/]+)/fps)", [this](const httplib::Request& req, httplib::Response& res) {
+        res.set_header("Content-Type", "application/json");
+        std::string cam_id = req.matches[1];
+        try {
+            auto j = json::parse(req.body);
+            if (!j.contains("target_fps") || !j["target_fps"].is_number()) {
+                res.status = 400;
+                res.set_content(json_error(400, "target_fps (number) is required"), "application/json");
+                return;
+            }
+            double target_fps = j["target_fps"].get<double>();
+            if (target_fps < 0.0) {
+                res.status = 400;
+                res.set_content(json_error(400, "target_fps must be >= 0"), "application/json");
+                return;
+            }
+
+            if (stream_mgr_.set_target_fps(cam_id, target_fps)) {
+                json data;
+                data["cam_id"] = cam_id;
+                data["target_fps"] = target_fps;
+                res.set_content(json_ok("Stream " + cam_id + " target fps updated", data),
+                                "application/json");
+            } else {
+                res.status = 404;
+                res.set_content(json_error(404, "Stream " + cam_id + " not found"),
+                                "application/json");
+            }
+        } catch (const json::exception& e) {
+            res.status = 400;
+            res.set_content(json_error(400, std::string("Invalid JSON: ") + e.what()),
+                            "application/json");
+        }
+    });
+
+    // ----------------------------------------------------------
+    // POST /api/models/swap -- 模型热切换
+    // Body: {"model_path": "old.rknn", "new_model_path": "new.rknn",
+    //        "cam_ids": ["cam01"] (可选, 默认所有引用旧模型的流), "timeout_ms": 5000 (可选)}
+    // ----------------------------------------------------------
+    server_->Post("/api/models/swap", [this](const httplib::Request& req, httplib::Response& res) {
+        res.set_header("Content-Type", "application/json");
+        try {
+            auto j = json::parse(req.body);
+            if (!j.contains("model_path") || !j["model_path"].is_string() ||
+                !j.contains("new_model_path") || !j["new_model_path"].is_string()) {
+                res.status = 400;
+                res.set_content(json_error(400, "model_path and new_model_path (string) are required"),
+                                "application/json");
+                return;
+            }
+            std::string old_path = j["model_path"].get<std::string>();
+            std::string new_path = j["new_model_path"].get<std::string>();
+            std::vector<std::string> cam_ids = j.value("cam_ids", std::vector<std::string>{});
+            int timeout_ms = j.value("timeout_ms", 5000);
+
+            auto result = stream_mgr_.swap_model(old_path, new_path, cam_ids, timeout_ms);
+            if (!result.ok) {
+                res.status = 400;
+                res.set_content(json_error(400, result.error), "application/json");
+                return;
+            }
+
+            json data;
+            data["model_path"] = old_path;
+            data["new_model_path"] = new_path;
+            data["swapped"] = result.swapped;
+            data["pending"] = result.pending;
+            data["old_unloaded"] = result.old_unloaded;
+            data["load_ms"] = std::round(result.load_ms * 10.0) / 10.0;
+            data["drain_ms"] = std::round(result.drain_ms * 10.0) / 10.0;
+            res.set_content(json_ok("Model swapped on " + std::to_string(result.swapped.size()) +
+                                    " stream(s)", data),
+                            "application/json");
+        } catch (const json::exception& e) {
+            res.status = 400;
+            res.set_content(json_error(400, std::string("Invalid JSON: ") + e.what()),
+                            "application/json");
+        }
+    });
+
     // ----------------------------------------------------------
     // GET /api/status -- 服务器全局状态
     // ----------------------------------------------------------
@@ -282,25 +572,86 @@ void RestServer::setup_routes() {
         auto now = std::chrono::steady_clock::now();
         double uptime = std::chrono::duration<double>(now - start_time_).count();
 
-        auto all_status = stream_mgr_.get_all_status();
+        auto snapshot = stream_mgr_.status_snapshot();
         int running_count = 0;
-        for (const auto& s : all_status) {
+        for (const auto& s : snapshot->streams) {
             if (s.status == "running") running_count++;
         }
 
         json data;
         data["version"] = "0.1.0";
         data["uptime_seconds"] = uptime;
-        data["streams_total"] = static_cast<int>(all_status.size());
+        data["streams_total"] = static_cast<int>(snapshot->streams.size());
         data["streams_running"] = running_count;
+        data["admission_scale"] = std::round(stream_mgr_.admission_scale() * 1000.0) / 1000.0;
+        data["push_clients"] = push_clients_.load();
+        if (auto pool = stream_mgr_.decode_pool_stats()) {
+            data["decode_pool"] = {
+                {"threads", pool->threads},
+                {"tasks", pool->tasks},
+                {"busy", pool->busy},
+                {"steps", pool->steps},
+                {"lag_ms", std::round(pool->lag_ms * 100.0) / 100.0}
+            };
+        }
 
 #ifdef HAS_RKNN
         if (engine_) {
             data["infer_queue_size"] = engine_->queue_size();
             data["infer_queue_dropped"] = engine_->queue_dropped();
+            data["infer_queue_expired"] = engine_->queue_expired();
+            data["infer_queue_policy"] = engine_->queue_policy();
             data["infer_total_processed"] = engine_->total_processed();
+            data["infer_rate"] = rates_json(engine_->processed_rate());
+            data["infer_drop_rate"] = rates_json(engine_->queue_drop_rate());
+            data["infer_batches"] = engine_->total_batches();
+            data["infer_batch_fill_ratio"] = std::round(engine_->batch_fill_ratio() * 1000.0) / 1000.0;
+            data["infer_scheduler"] = engine_->scheduler_mode();
+            data["infer_steals"] = engine_->steal_count();
+            data["infer_contexts"] = engine_->total_contexts();
+            auto loads = engine_->model_load_stats();
+            data["models_ready"] = loads.loading == 0;
+            data["models_loading"] = loads.loading;
+            data["models_loaded"] = loads.ready;
+            data["models_failed"] = loads.failed;
+            data["model_warmup_ms"] = std::round(loads.warmup_ms);
+
+            json model_memory = json::array();
+            uint64_t model_total = 0;
+            for (const auto& mm : engine_->model_manager().memory_stats()) {
+                model_total += mm.total_bytes();
+                model_memory.push_back({
+                    {"model_path", mm.model_path},
+                    {"weight_bytes", mm.weight_bytes},
+                    {"internal_bytes", mm.internal_bytes},
+                    {"contexts", mm.worker_contexts},
+                    {"shared_contexts", mm.shared_contexts},
+                    {"weight_copies", mm.weight_copies()},
+                    {"master_resident", mm.master_resident},
+                    {"total_bytes", mm.total_bytes()}
+                });
+            }
+            data["model_memory"] = std::move(model_memory);
+            data["model_memory_bytes"] = model_total;
+            data["tensor_pool"] = pool_stats_json(engine_->model_manager().input_pool_stats());
+
+            json workers = json::array();
+            for (const auto& ws : engine_->worker_stats()) {
+                workers.push_back({
+                    {"worker", ws.worker_id},
+                    {"core_mask", ws.core_mask},
+                    {"processed", ws.processed},
+                    {"npu_busy_ms", ws.npu_busy_us / 1000},
+                    {"npu_util", std::round(ws.npu_utilization * 1000.0) / 1000.0}
+                });
+            }
+            data["infer_workers"] = std::move(workers);
+            auto out = engine_->output_stats();
+            data["output_queue_size"] = out.queued;
+            data["output_dropped"] = out.dropped;
 #ifdef HAS_ZMQ
             data["zmq_published"] = engine_->zmq_published_count();
+            data["zmq_skipped"] = engine_->zmq_skipped_count();
 #endif
         }
 #endif
@@ -310,12 +661,150 @@ void RestServer::setup_routes() {
             double mem_mb = static_cast<double>(cache_->total_memory_bytes()) / (1024.0 * 1024.0);
             data["cache_memory_mb"] = std::round(mem_mb * 100.0) / 100.0;
             data["cache_total_frames"] = cache_->total_frames();
+            data["cache_annotated_frames"] = cache_->annotated_count();
         }
 #endif
 
+        data["buffer_pool"] = pool_stats_json(BufferPool::global().get_stats());
+
+        json rga_cores = json::array();
+        for (const auto& cs : RgaScheduler::instance().get_stats()) {
+            rga_cores.push_back({
+                {"core", cs.core},
+                {"jobs", cs.jobs},
+                {"contended", cs.contended},
+                {"waiting", cs.waiting},
+                {"wait_us", cs.wait_us}
+            });
+        }
+        data["rga_cores"] = std::move(rga_cores);
+
         res.set_content(json_ok("success", data), "application/json");
     });
 
+    // ----------------------------------------------------------
+    // GET /api/node -- 节点容量与负载 (集群协调器轮询)
+    // ----------------------------------------------------------
+    server_->Get("/api/node", [this](const httplib::Request&, httplib::Response& res) {
+        res.set_header("Content-Type", "application/json");
+
+        std::string node_id = config_.node_id;
+        if (node_id.empty()) {
+            char host[256] = {};
+            gethostname(host, sizeof(host) - 1);
+            node_id = std::string(host) + ":" + std::to_string(config_.http_port);
+        }
+
+        json data;
+        data["node_id"] = node_id;
+        data["streams"] = static_cast<int>(stream_mgr_.status_snapshot()->streams.size());
+        data["max_streams"] = config_.node_max_streams;
+        double decode_lag_ms = 0.0;
+        if (auto pool = stream_mgr_.decode_pool_stats()) decode_lag_ms = pool->lag_ms;
+        data["decode_lag_ms"] = std::round(decode_lag_ms * 100.0) / 100.0;
+
+        double npu_util = 0.0;
+        double drop_rate = 0.0;
+#ifdef HAS_RKNN
+        if (engine_) {
+            auto workers = engine_->worker_stats();
+            for (const auto& ws : workers) npu_util += ws.npu_utilization;
+            if (!workers.empty()) npu_util /= static_cast<double>(workers.size());
+            drop_rate = engine_->queue_drop_rate().last_10s;
+        }
+#endif
+        data["npu_util"] = std::round(npu_util * 1000.0) / 1000.0;
+        data["infer_drop_rate"] = std::round(drop_rate * 100.0) / 100.0;
+#ifdef HAS_ZMQ
+        data["zmq_endpoint"] = config_.zmq_endpoint;
+#else
+        data["zmq_endpoint"] = "";
+#endif
+        res.set_content(json_ok("success", data), "application/json");
+    });
+
+    // 集群端点只在协调器上注册
+    if (cluster_) {
+        // ------------------------------------------------------
+        // GET /api/cluster -- 集群状态 (节点 / 分配 / 最近一轮操作)
+        // ------------------------------------------------------
+        server_->Get("/api/cluster", [this](const httplib::Request&, httplib::Response& res) {
+            res.set_content(json_ok("success", cluster_->status()), "application/json");
+        });
+
+        // ------------------------------------------------------
+        // GET /api/cluster/streams -- 集群流配置列表
+        // ------------------------------------------------------
+        server_->Get("/api/cluster/streams", [this](const httplib::Request&, httplib::Response& res) {
+            json data = json::array();
+            for (const auto& s : cluster_->streams()) {
+                data.push_back(s);
+            }
+            res.set_content(json_ok("success", data), "application/json");
+        });
+
+        // ------------------------------------------------------
+        // POST /api/cluster/streams -- 添加集群流 (请求体同 POST /api/streams)
+        // ------------------------------------------------------
+        server_->Post("/api/cluster/streams", [this](const httplib::Request& req, httplib::Response& res) {
+            try {
+                auto stream_config = json::parse(req.body).get<StreamConfig>();
+                std::string invalid = validate_stream(stream_config);
+                if (!invalid.empty()) {
+                    res.status = 400;
+                    res.set_content(json_error(400, invalid), "application/json");
+                    return;
+                }
+                if (!cluster_->add_stream(stream_config)) {
+                    res.status = 409;
+                    res.set_content(json_error(409, "Stream " + stream_config.cam_id + " already exists"),
+                                    "application/json");
+                    return;
+                }
+                json data;
+                data["cam_id"] = stream_config.cam_id;
+                res.set_content(json_ok("Stream " + stream_config.cam_id + " added to cluster", data),
+                                "application/json");
+            } catch (const json::exception& e) {
+                res.status = 400;
+                res.set_content(json_error(400, std::string("Invalid JSON: ") + e.what()),
+                                "application/json");
+            }
+        });
+
+        // ------------------------------------------------------
+        // POST /api/cluster/rebalance -- 立即执行一轮轮询与分配
+        // ------------------------------------------------------
+        server_->Post("/api/cluster/rebalance", [this](const httplib::Request&, httplib::Response& res) {
+            cluster_->reconcile();
+            res.set_content(json_ok("Cluster reconciled", cluster_->status()), "application/json");
+        });
+
+        // ------------------------------------------------------
+        // DELETE /api/cluster/streams/:cam_id -- 移除集群流
+        // ------------------------------------------------------
+        server_->Delete(R"(/api/cluster/streams/([^/]+))",
+                        [this](const httplib::Request& req, httplib::Response& res) {
+            std::string cam_id = req.matches[1];
+            if (cluster_->remove_stream(cam_id)) {
+                json data;
+                data["cam_id"] = cam_id;
+                res.set_content(json_ok("Stream " + cam_id + " removed from cluster", data),
+                                "application/json");
+            } else {
+                res.status = 404;
+                res.set_content(json_error(404, "Stream " + cam_id + " not found"), "application/json");
+            }
+        });
+    }
+
+    // ----------------------------------------------------------
+    // GET /metrics -- Prometheus 指标
+    // ----------------------------------------------------------
+    server_->Get("/metrics", [this](const httplib::Request&, httplib::Response& res) {
+        res.set_content(prometheus_metrics(), "text/plain; version=0.0.4");
+    });
+
     // ----------------------------------------------------------
     // GET /api/cache/image -- 获取缓存图片
     // 参数: stream_id (必须), ts (可选, 毫秒时间戳), latest (可选, "true")
@@ -369,6 +858,8 @@ void RestServer::setup_routes() {
             res.set_header("X-Timestamp-Ms", std::to_string(frame->timestamp_ms));
             res.set_header("X-Width", std::to_string(frame->width));
             res.set_header("X-Height", std::to_string(frame->height));
+            bool annotated = frame->overlay && !frame->overlay->empty();
+            res.set_header("X-Annotated", annotated ? "true" : "false");
             res.set_content(
                 std::string(reinterpret_cast<const char*>(frame->jpeg_data->data()),
                             frame->jpeg_data->size()),
@@ -388,6 +879,231 @@ void RestServer::setup_routes() {
 #endif
     });
 
+    // ----------------------------------------------------------
+    // GET /api/cache/clip -- 导出报警视频片段 (码流 remux, 不转码)
+    // 参数: stream_id (必须), ts (毫秒时间戳) + before_ms / after_ms (默认 5000),
+    //       或 start_ms + end_ms; format (可选, "mp4" / "ts", 默认 mp4)
+    // ----------------------------------------------------------
+    server_->Get("/api/cache/clip", [this](const httplib::Request& req, httplib::Response& res) {
+#ifdef HAS_FFMPEG
+        auto fail = [&res](int code, const std::string& msg) {
+            res.status = code;
+            res.set_header("Content-Type", "application/json");
+            res.set_content(json_error(code, msg), "application/json");
+        };
+
+        if (config_.clip_duration_sec <= 0) {
+            fail(503, "Clip cache disabled (clip_duration_sec = 0)");
+            return;
+        }
+
+        std::string stream_id = req.has_param("stream_id") ? req.get_param_value("stream_id") : "";
+        if (stream_id.empty()) {
+            fail(400, "stream_id parameter is required");
+            return;
+        }
+
+        std::string format = req.has_param("format") ? req.get_param_value("format") : "mp4";
+        if (!ClipMuxer::is_supported_format(format)) {
+            fail(400, "Invalid format (expected mp4 or ts)");
+            return;
+        }
+
+        int64_t start_ms = 0, end_ms = 0;
+        try {
+            if (req.has_param("start_ms") && req.has_param("end_ms")) {
+                start_ms = std::stoll(req.get_param_value("start_ms"));
+                end_ms = std::stoll(req.get_param_value("end_ms"));
+            } else if (req.has_param("ts")) {
+                int64_t ts = std::stoll(req.get_param_value("ts"));
+                int64_t before = req.has_param("before_ms") ? std::stoll(req.get_param_value("before_ms")) : 5000;
+                int64_t after = req.has_param("after_ms") ? std::stoll(req.get_param_value("after_ms")) : 5000;
+                start_ms = ts - std::max<int64_t>(before, 0);
+                end_ms = ts + std::max<int64_t>(after, 0);
+            } else {
+                fail(400, "ts or start_ms/end_ms parameter is required");
+                return;
+            }
+        } catch (...) {
+            fail(400, "Invalid time parameter");
+            return;
+        }
+        if (end_ms < start_ms) {
+            fail(400, "end_ms must not be earlier than start_ms");
+            return;
+        }
+
+        auto clip = stream_mgr_.get_clip(stream_id, start_ms, end_ms);
+        if (!clip) {
+            fail(404, "No clip data found for stream " + stream_id);
+            return;
+        }
+
+        std::vector<uint8_t> data;
+        if (!ClipMuxer::remux(*clip, format, data)) {
+            fail(500, "Failed to remux clip");
+            return;
+        }
+
+        res.set_header("X-Clip-Start-Ms", std::to_string(clip->start_ms));
+        res.set_header("X-Clip-End-Ms", std::to_string(clip->end_ms));
+        res.set_header("X-Clip-Packets", std::to_string(clip->packets.size()));
+        res.set_content(std::string(reinterpret_cast<const char*>(data.data()), data.size()),
+                        ClipMuxer::content_type(format));
+#else
+        (void)req;
+        res.status = 503;
+        res.set_header("Content-Type", "application/json");
+        res.set_content(json_error(503, "Clip export not compiled (FFmpeg unavailable)"),
+                        "application/json");
+#endif
+    });
+
+    // ----------------------------------------------------------
+    // GET /api/cache/mjpeg -- MJPEG 实时预览 (multipart/x-mixed-replace)
+    // 参数: stream_id (必须), max_fps (可选, 0 = 与缓存写入同频)
+    // 每个新缓存帧推送一次; JPEG 直接从缓存的共享缓冲写出, 不拷贝
+    // ----------------------------------------------------------
+    server_->Get("/api/cache/mjpeg", [this](const httplib::Request& req, httplib::Response& res) {
+#ifdef HAS_TURBOJPEG
+        auto fail = [&res](int code, const std::string& msg) {
+            res.status = code;
+            res.set_header("Content-Type", "application/json");
+            res.set_content(json_error(code, msg), "application/json");
+        };
+
+        if (!cache_) {
+            fail(503, "Image cache not available");
+            return;
+        }
+        std::string stream_id = req.has_param("stream_id") ? req.get_param_value("stream_id") : "";
+        if (stream_id.empty()) {
+            fail(400, "stream_id parameter is required");
+            return;
+        }
+        double max_fps = 0.0;
+        try {
+            if (req.has_param("max_fps")) max_fps = std::stod(req.get_param_value("max_fps"));
+        } catch (...) {
+            fail(400, "Invalid max_fps parameter");
+            return;
+        }
+        if (!cache_->has_stream(stream_id)) {
+            fail(404, "No cached images for stream " + stream_id);
+            return;
+        }
+        if (!acquire_push_slot()) {
+            fail(503, "Too many push clients (http_push_clients = " +
+                      std::to_string(config_.http_push_clients) + ")");
+            return;
+        }
+
+        auto interval = max_fps > 0.0
+            ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                  std::chrono::duration<double>(1.0 / max_fps))
+            : std::chrono::steady_clock::duration::zero();
+        int64_t last_ts = -1;
+        auto next_due = std::chrono::steady_clock::now();
+
+        res.set_header("Cache-Control", "no-cache");
+        res.set_chunked_content_provider(
+            "multipart/x-mixed-replace; boundary=frame",
+            [this, stream_id, interval, last_ts, next_due](size_t, httplib::DataSink& sink) mutable {
+                // 每次调用最多推送一帧; 返回后 httplib 检查连接与服务器状态再继续调用
+                if (!cache_->has_stream(stream_id)) {
+                    sink.done();
+                    return true;
+                }
+                auto frame = cache_->wait_latest_frame(stream_id, last_ts, std::chrono::milliseconds(1000));
+                if (!frame) return true;
+                last_ts = frame->timestamp_ms;
+                if (!frame->jpeg_data || frame->jpeg_data->empty()) return true;
+
+                std::string header = "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: " +
+                    std::to_string(frame->jpeg_data->size()) +
+                    "\r\nX-Frame-Id: " + std::to_string(frame->frame_id) +
+                    "\r\nX-Timestamp-Ms: " + std::to_string(frame->timestamp_ms) + "\r\n\r\n";
+                if (!sink.write(header.data(), header.size()) ||
+                    !sink.write(reinterpret_cast<const char*>(frame->jpeg_data->data()),
+                                frame->jpeg_data->size()) ||
+                    !sink.write("\r\n", 2)) {
+                    return false;
+                }
+
+                if (interval.count() > 0) {
+                    next_due = std::max(next_due + interval, std::chrono::steady_clock::now() - interval);
+                    std::this_thread::sleep_until(next_due);
+                }
+                return true;
+            },
+            [this](bool) { push_clients_.fetch_sub(1); });
+#else
+        (void)req;
+        res.status = 503;
+        res.set_header("Content-Type", "application/json");
+        res.set_content(json_error(503, "Image cache not compiled (TurboJPEG unavailable)"),
+                        "application/json");
+#endif
+    });
+
+    // ----------------------------------------------------------
+    // GET /api/results/stream -- 检测结果实时推送 (Server-Sent Events)
+    // 参数: stream_id (可选, 不指定则推送所有流)
+    // 每帧一个 "result" 事件, data 为与 ZMQ JSON 相同的 FrameResult;
+    // 客户端来不及接收时丢弃最旧结果; 空闲 15 秒发送一次注释行保活
+    // ----------------------------------------------------------
+    server_->Get("/api/results/stream", [this](const httplib::Request& req, httplib::Response& res) {
+        auto fail = [&res](int code, const std::string& msg) {
+            res.status = code;
+            res.set_header("Content-Type", "application/json");
+            res.set_content(json_error(code, msg), "application/json");
+        };
+
+        if (!broadcaster_) {
+            fail(503, "Result streaming not available");
+            return;
+        }
+        std::string stream_id = req.has_param("stream_id") ? req.get_param_value("stream_id") : "";
+        if (!stream_id.empty() && !stream_mgr_.status_snapshot()->find(stream_id)) {
+            fail(404, "Stream not found: " + stream_id);
+            return;
+        }
+        if (!acquire_push_slot()) {
+            fail(503, "Too many push clients (http_push_clients = " +
+                      std::to_string(config_.http_push_clients) + ")");
+            return;
+        }
+
+        auto sub = broadcaster_->subscribe(stream_id, 64);
+        auto last_write = std::chrono::steady_clock::now();
+        bool opened = false;
+
+        res.set_header("Cache-Control", "no-cache");
+        res.set_header("X-Accel-Buffering", "no");
+        res.set_chunked_content_provider(
+            "text/event-stream",
+            [sub, last_write, opened](size_t, httplib::DataSink& sink) mutable {
+                std::string out;
+                if (!opened) {
+                    out = "retry: 3000\n\n";
+                    opened = true;
+                }
+                auto payload = sub->next(std::chrono::milliseconds(1000));
+                auto now = std::chrono::steady_clock::now();
+                if (payload) {
+                    out += "event: result\ndata: ";
+                    out += **payload;
+                    out += "\n\n";
+                } else if (now - last_write >= std::chrono::seconds(15)) {
+                    out += ": keepalive\n\n";
+                }
+                if (out.empty()) return true;
+                last_write = now;
+                return sink.write(out.data(), out.size());
+            },
+            [this](bool) { push_clients_.fetch_sub(1); });
+    });
+
     LOG_DEBUG("All REST API routes registered");
 }
 
@@ -0,0 +1,179 @@
+#ifdef HAS_FFMPEG
+
+#include "infer_server/cache/clip_muxer.h"
+#include "infer_server/common/logger.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libavutil/mem.h>
+}
+
+#include <algorithm>
+#include <cstring>
+
+namespace infer_server {
+
+namespace {
+
+constexpr int kAvioBufferSize = 64 * 1024;
+
+/// AVIOContext 写回调: 追加到 std::vector
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+int write_to_vector(void* opaque, const uint8_t* buf, int size) {
+#else
+int write_to_vector(void* opaque, uint8_t* buf, int size) {
+#endif
+    auto* out = static_cast<std::vector<uint8_t>*>(opaque);
+    out->insert(out->end(), buf, buf + size);
+    return size;
+}
+
+std::string av_error_string(int err) {
+    char errbuf[256];
+    av_strerror(err, errbuf, sizeof(errbuf));
+    return errbuf;
+}
+
+} // namespace
+
+bool ClipMuxer::remux(const Clip& clip, const std::string& format, std::vector<uint8_t>& out) {
+    out.clear();
+    if (clip.packets.empty()) {
+        LOG_ERROR("ClipMuxer: empty clip");
+        return false;
+    }
+    if (!is_supported_format(format)) {
+        LOG_ERROR("ClipMuxer: unsupported format '{}'", format);
+        return false;
+    }
+
+    AVFormatContext* oc = nullptr;
+    int ret = avformat_alloc_output_context2(
+        &oc, nullptr, format == "ts" ? "mpegts" : "mp4", nullptr);
+    if (ret < 0 || !oc) {
+        LOG_ERROR("ClipMuxer: failed to allocate output context: {}", av_error_string(ret));
+        return false;
+    }
+
+    AVIOContext* avio = nullptr;
+    bool ok = false;
+
+    do {
+        // ========================
+        // 视频流参数
+        // ========================
+        AVStream* st = avformat_new_stream(oc, nullptr);
+        if (!st) {
+            LOG_ERROR("ClipMuxer: failed to create stream");
+            break;
+        }
+
+        const ClipCodecInfo& codec = clip.codec;
+        st->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+        st->codecpar->codec_id = static_cast<AVCodecID>(codec.codec_id);
+        st->codecpar->codec_tag = 0;
+        st->codecpar->width = codec.width;
+        st->codecpar->height = codec.height;
+        if (!codec.extradata.empty()) {
+            st->codecpar->extradata = static_cast<uint8_t*>(
+                av_mallocz(codec.extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+            if (!st->codecpar->extradata) break;
+            std::memcpy(st->codecpar->extradata, codec.extradata.data(), codec.extradata.size());
+            st->codecpar->extradata_size = static_cast<int>(codec.extradata.size());
+        }
+
+        AVRational in_tb{codec.time_base_num, codec.time_base_den};
+        st->time_base = in_tb;
+        if (codec.fps_num > 0 && codec.fps_den > 0) {
+            st->avg_frame_rate = AVRational{codec.fps_num, codec.fps_den};
+        }
+
+        // ========================
+        // 内存 IO
+        // ========================
+        auto* avio_buf = static_cast<uint8_t*>(av_malloc(kAvioBufferSize));
+        if (!avio_buf) break;
+        avio = avio_alloc_context(avio_buf, kAvioBufferSize, 1, &out,
+                                  nullptr, write_to_vector, nullptr);
+        if (!avio) {
+            av_free(avio_buf);
+            break;
+        }
+        oc->pb = avio;
+        oc->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+        AVDictionary* opts = nullptr;
+        if (format == "mp4") {
+            av_dict_set(&opts, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+        }
+        ret = avformat_write_header(oc, &opts);
+        av_dict_free(&opts);
+        if (ret < 0) {
+            LOG_ERROR("ClipMuxer: write header failed: {}", av_error_string(ret));
+            break;
+        }
+
+        // ========================
+        // 写入包 (时间戳平移到 0)
+        // ========================
+        int64_t base = clip.packets.front().dts;
+        for (const auto& p : clip.packets) {
+            base = std::min(base, std::min(p.dts, p.pts));
+        }
+
+        AVPacket* pkt = av_packet_alloc();
+        if (!pkt) break;
+
+        bool write_ok = true;
+        for (const auto& p : clip.packets) {
+            if (!p.data || p.data->empty()) continue;
+            // 非引用计数包, av_interleaved_write_frame 内部会拷贝数据
+            pkt->data = p.data->data();
+            pkt->size = static_cast<int>(p.data->size());
+            pkt->stream_index = st->index;
+            pkt->pts = p.pts - base;
+            pkt->dts = p.dts - base;
+            pkt->duration = p.duration;
+            pkt->flags = p.keyframe ? AV_PKT_FLAG_KEY : 0;
+            pkt->pos = -1;
+            av_packet_rescale_ts(pkt, in_tb, st->time_base);
+
+            ret = av_interleaved_write_frame(oc, pkt);
+            if (ret < 0) {
+                LOG_ERROR("ClipMuxer: write packet failed: {}", av_error_string(ret));
+                write_ok = false;
+                break;
+            }
+        }
+        av_packet_free(&pkt);
+        if (!write_ok) break;
+
+        ret = av_write_trailer(oc);
+        if (ret < 0) {
+            LOG_ERROR("ClipMuxer: write trailer failed: {}", av_error_string(ret));
+            break;
+        }
+        avio_flush(avio);
+        ok = true;
+    } while (false);
+
+    if (avio) {
+        av_freep(&avio->buffer);
+        avio_context_free(&avio);
+    }
+    avformat_free_context(oc);
+
+    if (ok) {
+        LOG_DEBUG("ClipMuxer: {} packets ({} ms) -> {} bytes {}",
+                  clip.packets.size(), clip.end_ms - clip.start_ms, out.size(), format);
+    } else {
+        out.clear();
+    }
+    return ok;
+}
+
+} // namespace infer_server
+
+#endif // HAS_FFMPEG
@@ -1,57 +1,109 @@
 #include "infer_server/cache/image_cache.h"
+#include "infer_server/cache/jpeg_encoder.h"
+#include "infer_server/cache/overlay.h"
 #include "infer_server/common/logger.h"
 
 #include <algorithm>
 #include <cmath>
 #include <chrono>
+#include <iterator>
 
 namespace infer_server {
 
-ImageCache::ImageCache(int duration_sec, int max_memory_mb)
+ImageCache::StreamCache::StreamCache(std::string id)
+    : cam_id(std::move(id))
+    , frames_(std::make_shared<const FrameList>())
+{
+}
+
+ImageCache::ImageCache(int duration_sec, int max_memory_mb, int jpeg_quality, JpegBackend jpeg_backend)
     : duration_sec_(duration_sec)
     , max_memory_bytes_(static_cast<size_t>(max_memory_mb) * 1024 * 1024)
+    , jpeg_quality_(jpeg_quality)
+    , jpeg_backend_(jpeg_backend)
 {
-    LOG_INFO("ImageCache created: duration={}s, max_memory={}MB",
-             duration_sec_, max_memory_mb);
+    LOG_INFO("ImageCache created: duration={}s, max_memory={}MB, jpeg_backend={}",
+             duration_sec_, max_memory_mb, jpeg_backend_name(jpeg_backend_));
 }
 
+ImageCache::~ImageCache() = default;
+
 void ImageCache::add_stream(const std::string& cam_id) {
     std::lock_guard<std::mutex> lock(map_mutex_);
     if (caches_.find(cam_id) == caches_.end()) {
-        caches_[cam_id] = std::make_shared<StreamCache>();
+        caches_[cam_id] = std::make_shared<StreamCache>(cam_id);
         LOG_DEBUG("ImageCache: added stream {}", cam_id);
     }
 }
 
 void ImageCache::remove_stream(const std::string& cam_id) {
-    std::lock_guard<std::mutex> lock(map_mutex_);
-    auto it = caches_.find(cam_id);
-    if (it != caches_.end()) {
-        // 减去该流的内存
-        total_memory_ -= it->second->memory_bytes.load();
+    std::shared_ptr<StreamCache> cache;
+    {
+        std::lock_guard<std::mutex> lock(map_mutex_);
+        auto it = caches_.find(cam_id);
+        if (it == caches_.end()) return;
+        cache = std::move(it->second);
         caches_.erase(it);
-        LOG_DEBUG("ImageCache: removed stream {}", cam_id);
     }
+
+    // 标记删除: 持有旧指针的写入者不会再计入内存或登记索引
+    std::lock_guard<std::mutex> lock(cache->write_mutex);
+    cache->removed = true;
+    total_memory_ -= cache->memory_bytes.exchange(0);
+    cache->store(std::make_shared<const FrameList>());
+    if (cache->indexed) {
+        std::lock_guard<std::mutex> index_lock(oldest_mutex_);
+        oldest_index_.erase({cache->indexed_oldest, cache->cam_id});
+        cache->indexed = false;
+    }
+    LOG_DEBUG("ImageCache: removed stream {}", cam_id);
 }
 
 void ImageCache::add_frame(CachedFrame frame) {
     auto cache = get_or_create_cache(frame.cam_id);
     if (!cache) return;
 
-    size_t frame_size = frame.jpeg_size();
+    size_t frame_size = frame.memory_size();
+    int64_t ts = frame.timestamp_ms;
+    auto frame_ptr = std::make_shared<const CachedFrame>(std::move(frame));
 
     {
-        std::lock_guard<std::mutex> lock(cache->mutex);
+        std::lock_guard<std::mutex> lock(cache->write_mutex);
+        if (cache->removed) return;
+
+        auto current = cache->load();
+
+        // 过期帧: 时间早于 (新帧时间 - duration) 的前缀
+        int64_t threshold = ts - static_cast<int64_t>(duration_sec_) * 1000;
+        auto first = lower_bound_ts(*current, threshold);
+        size_t expired_size = 0;
+        for (auto it = current->begin(); it != first; ++it) {
+            expired_size += (*it)->memory_size();
+        }
+
+        // 按时间戳插入 (通常追加在末尾), 保持有序
+        auto pos = std::upper_bound(first, current->end(), ts,
+            [](int64_t t, const FramePtr& f) { return t < f->timestamp_ms; });
 
-        // 清理该流的过期帧
-        evict_expired(*cache, frame.timestamp_ms);
+        auto next = std::make_shared<FrameList>();
+        next->reserve(static_cast<size_t>(std::distance(first, current->end())) + 1);
+        next->insert(next->end(), first, pos);
+        next->push_back(std::move(frame_ptr));
+        next->insert(next->end(), pos, current->end());
 
-        // 添加新帧
-        cache->frames.push_back(std::move(frame));
         cache->memory_bytes += frame_size;
+        cache->memory_bytes -= expired_size;
+        total_memory_ += frame_size;
+        total_memory_ -= expired_size;
+
+        publish(*cache, std::move(next));
     }
 
-    total_memory_ += frame_size;
+    // 唤醒等待新帧的读取者 (快照已发布, 等待者在 notify_mutex 下复查快照, 不会错过)
+    if (cache->waiters.load() > 0) {
+        std::lock_guard<std::mutex> lock(cache->notify_mutex);
+        cache->notify_cv.notify_all();
+    }
 
     // 全局内存检查
     if (max_memory_bytes_ > 0 && total_memory_.load() > max_memory_bytes_) {
@@ -59,19 +111,54 @@ void ImageCache::add_frame(CachedFrame frame) {
     }
 }
 
+bool ImageCache::attach_overlay(const FrameResult& result) {
+    auto cache = get_cache(result.cam_id);
+    if (!cache) return false;
+
+    // 没有检测框: 不必复制帧列表, 帧保持无框
+    bool any_boxes = std::any_of(result.results.begin(), result.results.end(),
+                                 [](const ModelResult& mr) { return !mr.detections.empty(); });
+    if (!any_boxes) return false;
+
+    std::lock_guard<std::mutex> lock(cache->write_mutex);
+    if (cache->removed) return false;
+
+    auto current = cache->load();
+    for (auto it = lower_bound_ts(*current, result.timestamp_ms);
+         it != current->end() && (*it)->timestamp_ms == result.timestamp_ms; ++it) {
+        if ((*it)->frame_id != result.frame_id) continue;
+        // 已编码 (或编码失败) 的帧无法再画框
+        if (!(*it)->raw_nv12 || (*it)->jpeg_data) return false;
+
+        auto boxes = overlay::scale_boxes(result, (*it)->width, (*it)->height);
+        if (boxes.empty()) return false;
+        auto merged = std::make_shared<std::vector<OverlayBox>>();
+        if ((*it)->overlay) *merged = *(*it)->overlay;
+        merged->insert(merged->end(), boxes.begin(), boxes.end());
+
+        auto updated = std::make_shared<CachedFrame>(**it);
+        updated->overlay = std::move(merged);
+
+        auto next = std::make_shared<FrameList>(*current);
+        (*next)[static_cast<size_t>(std::distance(current->begin(), it))] = std::move(updated);
+        cache->store(std::move(next));  // 最旧帧不变, 无需更新索引
+        return true;
+    }
+    return false;
+}
+
 std::optional<CachedFrame> ImageCache::get_frame(
     const std::string& cam_id, int64_t timestamp_ms) const
 {
     auto cache = get_cache(cam_id);
     if (!cache) return std::nullopt;
 
-    std::lock_guard<std::mutex> lock(cache->mutex);
-    for (const auto& f : cache->frames) {
-        if (f.timestamp_ms == timestamp_ms) {
-            return f;  // 返回拷贝 (shared_ptr 引用计数+1)
-        }
+    auto frames = cache->load();
+    auto it = lower_bound_ts(*frames, timestamp_ms);
+    if (it == frames->end() || (*it)->timestamp_ms != timestamp_ms) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    return materialize(*cache, **it);  // 拷贝 (shared_ptr 引用计数+1)
 }
 
 std::optional<CachedFrame> ImageCache::get_nearest_frame(
@@ -80,23 +167,21 @@ std::optional<CachedFrame> ImageCache::get_nearest_frame(
     auto cache = get_cache(cam_id);
     if (!cache) return std::nullopt;
 
-    std::lock_guard<std::mutex> lock(cache->mutex);
-    if (cache->frames.empty()) return std::nullopt;
-
-    // 二分查找最接近的帧 (frames 按 timestamp_ms 有序)
-    const CachedFrame* best = nullptr;
-    int64_t best_diff = INT64_MAX;
-
-    for (const auto& f : cache->frames) {
-        int64_t diff = std::abs(f.timestamp_ms - timestamp_ms);
-        if (diff < best_diff) {
-            best_diff = diff;
-            best = &f;
+    auto frames = cache->load();
+    if (frames->empty()) return std::nullopt;
+
+    // 二分查找: 比较插入点与其前一帧
+    auto it = lower_bound_ts(*frames, timestamp_ms);
+    if (it == frames->end()) {
+        --it;
+    } else if (it != frames->begin()) {
+        auto prev = std::prev(it);
+        if (std::abs((*prev)->timestamp_ms - timestamp_ms) <=
+            std::abs((*it)->timestamp_ms - timestamp_ms)) {
+            it = prev;
         }
     }
-
-    if (best) return *best;
-    return std::nullopt;
+    return materialize(*cache, **it);
 }
 
 std::optional<CachedFrame> ImageCache::get_latest_frame(
@@ -105,10 +190,37 @@ std::optional<CachedFrame> ImageCache::get_latest_frame(
     auto cache = get_cache(cam_id);
     if (!cache) return std::nullopt;
 
-    std::lock_guard<std::mutex> lock(cache->mutex);
-    if (cache->frames.empty()) return std::nullopt;
+    auto frames = cache->load();
+    if (frames->empty()) return std::nullopt;
+
+    return materialize(*cache, *frames->back());
+}
+
+std::optional<CachedFrame> ImageCache::wait_latest_frame(
+    const std::string& cam_id, int64_t after_timestamp_ms,
+    std::chrono::milliseconds timeout) const
+{
+    auto cache = get_cache(cam_id);
+    if (!cache) return std::nullopt;
 
-    return cache->frames.back();
+    auto newer = [&]() -> FramePtr {
+        auto frames = cache->load();
+        if (frames->empty() || frames->back()->timestamp_ms <= after_timestamp_ms) return nullptr;
+        return frames->back();
+    };
+
+    FramePtr latest = newer();
+    if (!latest) {
+        // 先登记再复查: 与 add_frame 的 "发布快照 -> 检查 waiters" 顺序配对
+        cache->waiters.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock(cache->notify_mutex);
+            cache->notify_cv.wait_for(lock, timeout, [&] { return (latest = newer()) != nullptr; });
+        }
+        cache->waiters.fetch_sub(1);
+        if (!latest) return std::nullopt;
+    }
+    return materialize(*cache, *latest);
 }
 
 size_t ImageCache::total_memory_bytes() const {
@@ -119,8 +231,7 @@ size_t ImageCache::total_frames() const {
     std::lock_guard<std::mutex> lock(map_mutex_);
     size_t count = 0;
     for (const auto& [cam_id, cache] : caches_) {
-        std::lock_guard<std::mutex> cache_lock(cache->mutex);
-        count += cache->frames.size();
+        count += cache->load()->size();
     }
     return count;
 }
@@ -128,8 +239,7 @@ size_t ImageCache::total_frames() const {
 size_t ImageCache::stream_frame_count(const std::string& cam_id) const {
     auto cache = get_cache(cam_id);
     if (!cache) return 0;
-    std::lock_guard<std::mutex> lock(cache->mutex);
-    return cache->frames.size();
+    return cache->load()->size();
 }
 
 size_t ImageCache::stream_count() const {
@@ -141,6 +251,88 @@ size_t ImageCache::stream_count() const {
 // Private
 // ============================================================
 
+CachedFrame ImageCache::materialize(StreamCache& cache, CachedFrame frame) const {
+    if (frame.jpeg_data || !frame.raw_nv12) {
+        frame.raw_nv12.reset();
+        return frame;
+    }
+
+    // 检测框画在原图副本上 (原图可能正被其他读取者编码), 编码仍只有一次
+    const uint8_t* nv12 = frame.raw_nv12->data();
+    std::vector<uint8_t> annotated;
+    if (frame.overlay && !frame.overlay->empty()) {
+        annotated.assign(frame.raw_nv12->begin(), frame.raw_nv12->end());
+        overlay::draw_boxes_nv12(annotated.data(), frame.width, frame.height, *frame.overlay);
+        nv12 = annotated.data();
+    }
+
+    std::vector<uint8_t> jpeg;
+    {
+        std::lock_guard<std::mutex> lock(encoder_mutex_);
+        if (!encoder_) encoder_ = std::make_unique<JpegEncoder>(jpeg_backend_);
+        jpeg = encoder_->encode_nv12(nv12, frame.width, frame.height, jpeg_quality_);
+    }
+    if (jpeg.empty()) {
+        LOG_WARN("ImageCache: lazy encode failed for {} frame {}", frame.cam_id, frame.frame_id);
+        frame.raw_nv12.reset();
+        frame.overlay.reset();
+        return frame;
+    }
+    lazy_encodes_.fetch_add(1, std::memory_order_relaxed);
+    if (!annotated.empty()) annotated_.fetch_add(1, std::memory_order_relaxed);
+
+    auto jpeg_data = std::make_shared<std::vector<uint8_t>>(std::move(jpeg));
+
+    // 回写: 帧可能已被淘汰, 或被并发读取者先一步编码 (此时沿用已有结果)
+    {
+        std::lock_guard<std::mutex> lock(cache.write_mutex);
+        auto current = cache.load();
+        if (!cache.removed) {
+            for (auto it = lower_bound_ts(*current, frame.timestamp_ms);
+                 it != current->end() && (*it)->timestamp_ms == frame.timestamp_ms; ++it) {
+                if ((*it)->frame_id != frame.frame_id) continue;
+                if ((*it)->jpeg_data) {
+                    jpeg_data = (*it)->jpeg_data;
+                    frame.overlay = (*it)->overlay;
+                } else if ((*it)->raw_nv12) {
+                    auto encoded = std::make_shared<CachedFrame>(**it);
+                    encoded->jpeg_data = jpeg_data;
+                    encoded->raw_nv12.reset();
+                    // 编码期间回填的检测框未画入 JPEG: 记录实际画入的检测框
+                    encoded->overlay = frame.overlay;
+
+                    // 一次性调整, 避免并发读取 total_memory_ 时看到中间值
+                    size_t old_size = (*it)->memory_size();
+                    size_t new_size = encoded->memory_size();
+                    if (old_size >= new_size) {
+                        cache.memory_bytes -= old_size - new_size;
+                        total_memory_ -= old_size - new_size;
+                    } else {
+                        cache.memory_bytes += new_size - old_size;
+                        total_memory_ += new_size - old_size;
+                    }
+
+                    auto next = std::make_shared<FrameList>(*current);
+                    (*next)[static_cast<size_t>(std::distance(current->begin(), it))] = std::move(encoded);
+                    cache.store(std::move(next));  // 最旧帧不变, 无需更新索引
+                }
+                break;
+            }
+        }
+    }
+
+    frame.jpeg_data = std::move(jpeg_data);
+    frame.raw_nv12.reset();
+    return frame;
+}
+
+ImageCache::FrameList::const_iterator ImageCache::lower_bound_ts(
+    const FrameList& frames, int64_t ts)
+{
+    return std::lower_bound(frames.begin(), frames.end(), ts,
+        [](const FramePtr& f, int64_t t) { return f->timestamp_ms < t; });
+}
+
 std::shared_ptr<ImageCache::StreamCache> ImageCache::get_or_create_cache(
     const std::string& cam_id)
 {
@@ -149,7 +341,7 @@ std::shared_ptr<ImageCache::StreamCache> ImageCache::get_or_create_cache(
     if (it != caches_.end()) {
         return it->second;
     }
-    auto cache = std::make_shared<StreamCache>();
+    auto cache = std::make_shared<StreamCache>(cam_id);
     caches_[cam_id] = cache;
     return cache;
 }
@@ -165,51 +357,66 @@ std::shared_ptr<ImageCache::StreamCache> ImageCache::get_cache(
     return nullptr;
 }
 
-void ImageCache::evict_expired(StreamCache& cache, int64_t now_ms) {
-    // 调用方已持有 cache.mutex
-    int64_t threshold = now_ms - static_cast<int64_t>(duration_sec_) * 1000;
+void ImageCache::publish(StreamCache& cache, std::shared_ptr<FrameList> next) {
+    // 调用方已持有 cache.write_mutex
+    update_oldest_index(cache, *next);
+    cache.store(std::move(next));
+}
+
+void ImageCache::update_oldest_index(StreamCache& cache, const FrameList& frames) {
+    // 调用方已持有 cache.write_mutex
+    bool want = !frames.empty() && !cache.removed;
+    int64_t oldest = want ? frames.front()->timestamp_ms : 0;
+    if (cache.indexed == want && (!want || cache.indexed_oldest == oldest)) return;
 
-    while (!cache.frames.empty() && cache.frames.front().timestamp_ms < threshold) {
-        size_t frame_size = cache.frames.front().jpeg_size();
-        cache.frames.pop_front();
-        cache.memory_bytes -= frame_size;
-        total_memory_ -= frame_size;
+    std::lock_guard<std::mutex> lock(oldest_mutex_);
+    if (cache.indexed) {
+        oldest_index_.erase({cache.indexed_oldest, cache.cam_id});
     }
+    if (want) {
+        oldest_index_.insert({oldest, cache.cam_id});
+    }
+    cache.indexed = want;
+    cache.indexed_oldest = oldest;
 }
 
 void ImageCache::evict_global_memory() {
-    // 从所有流中淘汰最旧的帧, 直到内存低于上限
-    std::lock_guard<std::mutex> map_lock(map_mutex_);
-
+    // 反复淘汰全局最旧帧, 直到内存低于上限
     int evict_count = 0;
     while (total_memory_.load() > max_memory_bytes_) {
-        // 找到最旧帧所在的流
-        std::string oldest_cam;
-        int64_t oldest_ts = INT64_MAX;
-
-        for (const auto& [cam_id, cache] : caches_) {
-            std::lock_guard<std::mutex> cache_lock(cache->mutex);
-            if (!cache->frames.empty()) {
-                int64_t ts = cache->frames.front().timestamp_ms;
-                if (ts < oldest_ts) {
-                    oldest_ts = ts;
-                    oldest_cam = cam_id;
-                }
-            }
+        std::pair<int64_t, std::string> oldest;
+        {
+            std::lock_guard<std::mutex> lock(oldest_mutex_);
+            if (oldest_index_.empty()) break;  // 所有流都为空
+            oldest = *oldest_index_.begin();
+        }
+
+        auto cache = get_cache(oldest.second);
+        if (!cache) {
+            // 流已删除, 清理残留索引
+            std::lock_guard<std::mutex> lock(oldest_mutex_);
+            oldest_index_.erase(oldest);
+            continue;
         }
 
-        if (oldest_cam.empty()) break;  // 所有流都为空
-
-        // 淘汰该帧
-        auto& cache = caches_[oldest_cam];
-        std::lock_guard<std::mutex> cache_lock(cache->mutex);
-        if (!cache->frames.empty()) {
-            size_t frame_size = cache->frames.front().jpeg_size();
-            cache->frames.pop_front();
-            cache->memory_bytes -= frame_size;
-            total_memory_ -= frame_size;
-            evict_count++;
+        std::lock_guard<std::mutex> cache_lock(cache->write_mutex);
+        if (!cache->indexed || cache->indexed_oldest != oldest.first) {
+            // 索引已被该流的写入者更新; 持有写锁时 indexed_oldest 是权威值,
+            // 与之不符的同名条目只可能是残留 (如同名流删除后重建)
+            std::lock_guard<std::mutex> lock(oldest_mutex_);
+            oldest_index_.erase(oldest);
+            continue;
         }
+
+        auto current = cache->load();
+        if (current->empty()) continue;
+
+        size_t frame_size = current->front()->memory_size();
+        auto next = std::make_shared<FrameList>(current->begin() + 1, current->end());
+        cache->memory_bytes -= frame_size;
+        total_memory_ -= frame_size;
+        publish(*cache, std::move(next));
+        evict_count++;
     }
 
     if (evict_count > 0) {
@@ -3,15 +3,35 @@
 #include "infer_server/cache/jpeg_encoder.h"
 #include "infer_server/common/logger.h"
 
+#ifdef HAS_MPP
+#include "infer_server/cache/mpp_jpeg_encoder.h"
+#endif
+
 #include <turbojpeg.h>
+#include <algorithm>
 
 namespace infer_server {
 
-JpegEncoder::JpegEncoder() {
+JpegEncoder::JpegEncoder(JpegBackend backend) {
     handle_ = tjInitCompress();
     if (!handle_) {
         LOG_ERROR("Failed to initialize TurboJPEG compressor");
     }
+
+#ifdef HAS_MPP
+    if (backend != JpegBackend::TURBOJPEG) {
+        auto mpp = std::make_unique<MppJpegEncoder>();
+        if (mpp->is_valid()) {
+            mpp_ = std::move(mpp);
+        } else {
+            LOG_WARN("MPP JPEG encoder unavailable, using TurboJPEG");
+        }
+    }
+#else
+    if (backend == JpegBackend::MPP) {
+        LOG_WARN("MPP not compiled in (HAS_MPP), using TurboJPEG");
+    }
+#endif
 }
 
 JpegEncoder::~JpegEncoder() {
@@ -69,6 +89,88 @@ std::vector<uint8_t> JpegEncoder::encode(
     return result;
 }
 
+bool JpegEncoder::hardware() const {
+#ifdef HAS_MPP
+    return mpp_ != nullptr;
+#else
+    return false;
+#endif
+}
+
+std::vector<uint8_t> JpegEncoder::encode_nv12(
+    const uint8_t* nv12_data, int width, int height, int quality)
+{
+#ifdef HAS_MPP
+    if (mpp_ && nv12_data && width > 0 && height > 0 && !(width & 1) && !(height & 1)) {
+        auto jpeg = mpp_->encode(nv12_data, width, height, std::max(1, std::min(100, quality)));
+        if (!jpeg.empty()) {
+            hw_encodes_++;
+            LOG_TRACE("JPEG encoded (MPP): {}x{} q={} -> {} bytes", width, height, quality, jpeg.size());
+            return jpeg;
+        }
+        // 硬件上下文出错后不再重试, 之后全部走 TurboJPEG
+        LOG_WARN("JpegEncoder: MPP encode failed ({}x{}), switching to TurboJPEG", width, height);
+        mpp_.reset();
+    }
+#endif
+    return encode_nv12_soft(nv12_data, width, height, quality);
+}
+
+std::vector<uint8_t> JpegEncoder::encode_nv12_soft(
+    const uint8_t* nv12_data, int width, int height, int quality)
+{
+    if (!handle_) {
+        LOG_ERROR("JpegEncoder: compressor not initialized");
+        return {};
+    }
+
+    if (!nv12_data || width <= 0 || height <= 0 || (width & 1) || (height & 1)) {
+        LOG_ERROR("JpegEncoder: invalid NV12 input ({}x{})", width, height);
+        return {};
+    }
+
+    quality = std::max(1, std::min(100, quality));
+
+    // TurboJPEG 只接受平面 YUV: 把交织的 UV 拆成 U / V 两个平面
+    size_t y_size = static_cast<size_t>(width) * height;
+    size_t c_size = y_size / 4;
+    chroma_planes_.resize(c_size * 2);
+    const uint8_t* uv = nv12_data + y_size;
+    uint8_t* u_plane = chroma_planes_.data();
+    uint8_t* v_plane = u_plane + c_size;
+    for (size_t i = 0; i < c_size; i++) {
+        u_plane[i] = uv[2 * i];
+        v_plane[i] = uv[2 * i + 1];
+    }
+
+    const unsigned char* planes[3] = {nv12_data, u_plane, v_plane};
+    int strides[3] = {width, width / 2, width / 2};
+
+    unsigned char* jpeg_buf = nullptr;
+    unsigned long jpeg_size = 0;
+
+    int ret = tjCompressFromYUVPlanes(
+        static_cast<tjhandle>(handle_),
+        planes, width, strides, height,
+        TJSAMP_420,
+        &jpeg_buf, &jpeg_size,
+        quality,
+        TJFLAG_FASTDCT);
+
+    if (ret != 0) {
+        LOG_ERROR("JpegEncoder: tjCompressFromYUVPlanes failed: {}",
+                  tjGetErrorStr2(static_cast<tjhandle>(handle_)));
+        if (jpeg_buf) tjFree(jpeg_buf);
+        return {};
+    }
+
+    std::vector<uint8_t> result(jpeg_buf, jpeg_buf + jpeg_size);
+    tjFree(jpeg_buf);
+
+    LOG_TRACE("JPEG encoded (NV12): {}x{} q={} -> {} bytes", width, height, quality, result.size());
+    return result;
+}
+
 } // namespace infer_server
 
 #endif // HAS_TURBOJPEG
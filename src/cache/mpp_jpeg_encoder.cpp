@@ -0,0 +1,209 @@
+/**
+ * @file mpp_jpeg_encoder.cpp
+ * @brief Rockchip MPP 硬件 JPEG 编码实现
+ */
+
+#ifdef HAS_MPP
+
+#include "infer_server/cache/mpp_jpeg_encoder.h"
+#include "infer_server/common/logger.h"
+
+#include <rockchip/rk_mpi.h>
+#include <rockchip/rk_venc_cfg.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace infer_server {
+
+namespace {
+
+constexpr int align16(int v) { return (v + 15) & ~15; }
+
+} // namespace
+
+MppJpegEncoder::MppJpegEncoder() {
+    MppCtx ctx = nullptr;
+    MppApi* mpi = nullptr;
+    if (mpp_create(&ctx, &mpi) != MPP_OK) {
+        LOG_ERROR("MppJpegEncoder: mpp_create failed");
+        return;
+    }
+    if (mpp_init(ctx, MPP_CTX_ENC, MPP_VIDEO_CodingMJPEG) != MPP_OK) {
+        LOG_ERROR("MppJpegEncoder: mpp_init (MJPEG encoder) failed");
+        mpp_destroy(ctx);
+        return;
+    }
+
+    MppEncCfg cfg = nullptr;
+    if (mpp_enc_cfg_init(&cfg) != MPP_OK || mpi->control(ctx, MPP_ENC_GET_CFG, cfg) != MPP_OK) {
+        LOG_ERROR("MppJpegEncoder: failed to get encoder config");
+        if (cfg) mpp_enc_cfg_deinit(cfg);
+        mpp_destroy(ctx);
+        return;
+    }
+
+    MppBufferGroup group = nullptr;
+    if (mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_DRM) != MPP_OK) {
+        LOG_ERROR("MppJpegEncoder: failed to create DRM buffer group");
+        mpp_enc_cfg_deinit(cfg);
+        mpp_destroy(ctx);
+        return;
+    }
+
+    ctx_ = ctx;
+    mpi_ = mpi;
+    cfg_ = cfg;
+    group_ = group;
+    LOG_DEBUG("MppJpegEncoder: hardware JPEG encoder ready");
+}
+
+MppJpegEncoder::~MppJpegEncoder() {
+    release_buffers();
+    if (group_) {
+        mpp_buffer_group_put(static_cast<MppBufferGroup>(group_));
+        group_ = nullptr;
+    }
+    if (cfg_) {
+        mpp_enc_cfg_deinit(static_cast<MppEncCfg>(cfg_));
+        cfg_ = nullptr;
+    }
+    if (ctx_) {
+        mpp_destroy(static_cast<MppCtx>(ctx_));
+        ctx_ = nullptr;
+    }
+}
+
+void MppJpegEncoder::release_buffers() {
+    if (frame_buf_) {
+        mpp_buffer_put(static_cast<MppBuffer>(frame_buf_));
+        frame_buf_ = nullptr;
+    }
+    if (packet_buf_) {
+        mpp_buffer_put(static_cast<MppBuffer>(packet_buf_));
+        packet_buf_ = nullptr;
+    }
+    buf_size_ = 0;
+}
+
+bool MppJpegEncoder::ensure_buffers(size_t size) {
+    if (buf_size_ >= size) return true;
+    release_buffers();
+
+    auto group = static_cast<MppBufferGroup>(group_);
+    MppBuffer frame_buf = nullptr;
+    MppBuffer packet_buf = nullptr;
+    if (mpp_buffer_get(group, &frame_buf, size) != MPP_OK) {
+        LOG_ERROR("MppJpegEncoder: failed to allocate {} byte input buffer", size);
+        return false;
+    }
+    // JPEG 输出不会超过未压缩的 YUV420 帧
+    if (mpp_buffer_get(group, &packet_buf, size) != MPP_OK) {
+        LOG_ERROR("MppJpegEncoder: failed to allocate {} byte output buffer", size);
+        mpp_buffer_put(frame_buf);
+        return false;
+    }
+    frame_buf_ = frame_buf;
+    packet_buf_ = packet_buf;
+    buf_size_ = size;
+    return true;
+}
+
+bool MppJpegEncoder::configure(int width, int height, int quality) {
+    if (width == width_ && height == height_ && quality == quality_) return true;
+
+    auto cfg = static_cast<MppEncCfg>(cfg_);
+    int hor_stride = align16(width);
+    int ver_stride = align16(height);
+
+    mpp_enc_cfg_set_s32(cfg, "prep:width", width);
+    mpp_enc_cfg_set_s32(cfg, "prep:height", height);
+    mpp_enc_cfg_set_s32(cfg, "prep:hor_stride", hor_stride);
+    mpp_enc_cfg_set_s32(cfg, "prep:ver_stride", ver_stride);
+    mpp_enc_cfg_set_s32(cfg, "prep:format", MPP_FMT_YUV420SP);
+    mpp_enc_cfg_set_s32(cfg, "rc:mode", MPP_ENC_RC_MODE_FIXQP);
+    // q_factor 1-99 与 TurboJPEG quality 含义一致
+    int qf = std::clamp(quality, 1, 99);
+    mpp_enc_cfg_set_s32(cfg, "jpeg:q_factor", qf);
+    mpp_enc_cfg_set_s32(cfg, "jpeg:qf_max", qf);
+    mpp_enc_cfg_set_s32(cfg, "jpeg:qf_min", qf);
+
+    auto mpi = static_cast<MppApi*>(mpi_);
+    if (mpi->control(static_cast<MppCtx>(ctx_), MPP_ENC_SET_CFG, cfg) != MPP_OK) {
+        LOG_ERROR("MppJpegEncoder: MPP_ENC_SET_CFG failed ({}x{} q={})", width, height, quality);
+        width_ = height_ = quality_ = 0;
+        return false;
+    }
+
+    width_ = width;
+    height_ = height;
+    hor_stride_ = hor_stride;
+    ver_stride_ = ver_stride;
+    quality_ = quality;
+    return true;
+}
+
+std::vector<uint8_t> MppJpegEncoder::encode(const uint8_t* nv12, int width, int height, int quality) {
+    if (!ctx_ || !nv12 || width <= 0 || height <= 0) return {};
+    if (!configure(width, height, quality)) return {};
+
+    size_t frame_size = static_cast<size_t>(hor_stride_) * ver_stride_ * 3 / 2;
+    if (!ensure_buffers(frame_size)) return {};
+
+    // 拷贝到对齐步长的 DRM 缓冲 (Y 平面 + UV 平面, 行尾与平面尾的填充不影响编码)
+    auto* dst = static_cast<uint8_t*>(mpp_buffer_get_ptr(static_cast<MppBuffer>(frame_buf_)));
+    const uint8_t* src_uv = nv12 + static_cast<size_t>(width) * height;
+    uint8_t* dst_uv = dst + static_cast<size_t>(hor_stride_) * ver_stride_;
+    for (int y = 0; y < height; y++) {
+        std::memcpy(dst + static_cast<size_t>(y) * hor_stride_, nv12 + static_cast<size_t>(y) * width,
+                    static_cast<size_t>(width));
+    }
+    for (int y = 0; y < height / 2; y++) {
+        std::memcpy(dst_uv + static_cast<size_t>(y) * hor_stride_, src_uv + static_cast<size_t>(y) * width,
+                    static_cast<size_t>(width));
+    }
+
+    MppFrame frame = nullptr;
+    if (mpp_frame_init(&frame) != MPP_OK) return {};
+    mpp_frame_set_width(frame, static_cast<RK_U32>(width));
+    mpp_frame_set_height(frame, static_cast<RK_U32>(height));
+    mpp_frame_set_hor_stride(frame, static_cast<RK_U32>(hor_stride_));
+    mpp_frame_set_ver_stride(frame, static_cast<RK_U32>(ver_stride_));
+    mpp_frame_set_fmt(frame, MPP_FMT_YUV420SP);
+    mpp_frame_set_buffer(frame, static_cast<MppBuffer>(frame_buf_));
+    mpp_frame_set_eos(frame, 0);
+
+    MppPacket packet = nullptr;
+    if (mpp_packet_init_with_buffer(&packet, static_cast<MppBuffer>(packet_buf_)) != MPP_OK) {
+        mpp_frame_deinit(&frame);
+        return {};
+    }
+    mpp_packet_set_length(packet, 0);
+    mpp_meta_set_packet(mpp_frame_get_meta(frame), KEY_OUTPUT_PACKET, packet);
+
+    auto mpi = static_cast<MppApi*>(mpi_);
+    auto ctx = static_cast<MppCtx>(ctx_);
+    std::vector<uint8_t> jpeg;
+    if (mpi->encode_put_frame(ctx, frame) != MPP_OK) {
+        LOG_ERROR("MppJpegEncoder: encode_put_frame failed");
+    } else {
+        MppPacket out = nullptr;
+        if (mpi->encode_get_packet(ctx, &out) != MPP_OK || !out) {
+            LOG_ERROR("MppJpegEncoder: encode_get_packet failed");
+        } else {
+            auto* data = static_cast<const uint8_t*>(mpp_packet_get_pos(out));
+            size_t len = mpp_packet_get_length(out);
+            if (data && len > 0) jpeg.assign(data, data + len);
+            // 输出使用了 KEY_OUTPUT_PACKET 指定的 packet, 与 out 为同一对象
+            if (out != packet) mpp_packet_deinit(&out);
+        }
+    }
+
+    mpp_packet_deinit(&packet);
+    mpp_frame_deinit(&frame);
+    return jpeg;
+}
+
+} // namespace infer_server
+
+#endif // HAS_MPP
@@ -0,0 +1,108 @@
+/**
+ * @file overlay.cpp
+ * @brief NV12 检测框绘制实现
+ */
+
+#include "infer_server/cache/overlay.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace infer_server {
+namespace overlay {
+
+namespace {
+
+struct YuvColor {
+    uint8_t y, u, v;
+};
+
+/// BT.601 limited range: 红 / 绿 / 蓝 / 黄 / 青 / 品红
+constexpr YuvColor kPalette[] = {
+    {81, 90, 240}, {145, 54, 34}, {41, 240, 110},
+    {210, 16, 146}, {170, 166, 16}, {106, 202, 222},
+};
+constexpr int kPaletteSize = static_cast<int>(sizeof(kPalette) / sizeof(kPalette[0]));
+
+/// 绘制矩形边框 (闭区间坐标): 上下两条横条与左右两条竖条, fill 负责填充一个实心矩形
+template <typename Fill>
+void outline(int x1, int y1, int x2, int y2, int t, Fill fill) {
+    fill(x1, y1, x2, std::min(y1 + t - 1, y2));
+    fill(x1, std::max(y2 - t + 1, y1), x2, y2);
+    fill(x1, y1, std::min(x1 + t - 1, x2), y2);
+    fill(std::max(x2 - t + 1, x1), y1, x2, y2);
+}
+
+} // namespace
+
+int default_thickness(int width) {
+    return std::max(2, (width / 320) & ~1);
+}
+
+std::vector<OverlayBox> scale_boxes(const FrameResult& result, int width, int height) {
+    std::vector<OverlayBox> boxes;
+    if (result.original_width <= 0 || result.original_height <= 0 || width <= 0 || height <= 0) {
+        return boxes;
+    }
+    float sx = static_cast<float>(width) / static_cast<float>(result.original_width);
+    float sy = static_cast<float>(height) / static_cast<float>(result.original_height);
+    auto clamp = [](float v, int hi) {
+        return std::clamp(static_cast<int>(std::lround(v)), 0, hi);
+    };
+
+    for (const auto& mr : result.results) {
+        for (const auto& det : mr.detections) {
+            OverlayBox b;
+            b.x1 = clamp(det.bbox.x1 * sx, width - 1);
+            b.y1 = clamp(det.bbox.y1 * sy, height - 1);
+            b.x2 = clamp(det.bbox.x2 * sx, width - 1);
+            b.y2 = clamp(det.bbox.y2 * sy, height - 1);
+            b.class_id = det.class_id;
+            if (b.x2 > b.x1 && b.y2 > b.y1) boxes.push_back(b);
+        }
+    }
+    return boxes;
+}
+
+void draw_boxes_nv12(uint8_t* nv12, int width, int height,
+                     const std::vector<OverlayBox>& boxes, int thickness) {
+    if (!nv12 || width <= 0 || height <= 0 || boxes.empty()) return;
+    if (thickness <= 0) thickness = default_thickness(width);
+    const int chroma_thickness = std::max(1, thickness / 2);
+
+    uint8_t* y_plane = nv12;
+    uint8_t* uv_plane = nv12 + static_cast<size_t>(width) * height;
+    const int cw = width / 2;
+    const int ch = height / 2;
+
+    for (const auto& b : boxes) {
+        int x1 = std::clamp(std::min(b.x1, b.x2), 0, width - 1);
+        int x2 = std::clamp(std::max(b.x1, b.x2), 0, width - 1);
+        int y1 = std::clamp(std::min(b.y1, b.y2), 0, height - 1);
+        int y2 = std::clamp(std::max(b.y1, b.y2), 0, height - 1);
+        const auto& c = kPalette[((b.class_id % kPaletteSize) + kPaletteSize) % kPaletteSize];
+
+        outline(x1, y1, x2, y2, thickness, [&](int fx1, int fy1, int fx2, int fy2) {
+            for (int y = fy1; y <= fy2; y++) {
+                std::memset(y_plane + static_cast<size_t>(y) * width + fx1, c.y,
+                            static_cast<size_t>(fx2 - fx1 + 1));
+            }
+        });
+
+        if (cw <= 0 || ch <= 0) continue;
+        outline(std::min(x1 / 2, cw - 1), std::min(y1 / 2, ch - 1),
+                std::min(x2 / 2, cw - 1), std::min(y2 / 2, ch - 1), chroma_thickness,
+                [&](int fx1, int fy1, int fx2, int fy2) {
+            for (int y = fy1; y <= fy2; y++) {
+                uint8_t* row = uv_plane + static_cast<size_t>(y) * width;
+                for (int x = fx1; x <= fx2; x++) {
+                    row[2 * x] = c.u;
+                    row[2 * x + 1] = c.v;
+                }
+            }
+        });
+    }
+}
+
+} // namespace overlay
+} // namespace infer_server
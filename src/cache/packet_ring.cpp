@@ -0,0 +1,143 @@
+/**
+ * @file packet_ring.cpp
+ * @brief 每流压缩码流环形缓冲实现
+ */
+
+#include "infer_server/cache/packet_ring.h"
+
+#include <algorithm>
+
+namespace infer_server {
+
+PacketRing::PacketRing(int duration_sec, size_t max_bytes)
+    : duration_ms_limit_(static_cast<int64_t>(std::max(duration_sec, 1)) * 1000)
+    , max_bytes_(max_bytes)
+{
+}
+
+void PacketRing::reset(ClipCodecInfo codec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    codec_ = std::move(codec);
+    packets_.clear();
+    key_seqs_.clear();
+    base_seq_ = 0;
+    newest_ms_ = 0;
+    bytes_ = 0;
+}
+
+void PacketRing::push(ClipPacket packet) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 缓冲区必须从关键帧开始
+    if (packets_.empty() && !packet.keyframe) {
+        return;
+    }
+
+    if (packet.keyframe) {
+        key_seqs_.push_back(base_seq_ + packets_.size());
+    }
+    newest_ms_ = packets_.empty() ? packet.timestamp_ms
+                                  : std::max(newest_ms_, packet.timestamp_ms);
+    bytes_ += packet.size();
+    packets_.push_back(std::move(packet));
+
+    // 按时长淘汰: 去掉最旧 GOP 后仍覆盖 duration 时才淘汰
+    while (key_seqs_.size() > 1 &&
+           newest_ms_ - packets_[key_index(1)].timestamp_ms >= duration_ms_limit_) {
+        pop_front_gop();
+    }
+
+    // 按内存淘汰
+    while (max_bytes_ > 0 && bytes_ > max_bytes_ && key_seqs_.size() > 1) {
+        pop_front_gop();
+    }
+
+    // 单个 GOP 已超出上限: 整体丢弃, 等待下一个关键帧
+    if (max_bytes_ > 0 && bytes_ > max_bytes_) {
+        base_seq_ += packets_.size();
+        packets_.clear();
+        key_seqs_.clear();
+        bytes_ = 0;
+    }
+}
+
+std::optional<Clip> PacketRing::get_clip(int64_t start_ms, int64_t end_ms) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (packets_.empty() || end_ms < start_ms) return std::nullopt;
+    if (end_ms < packets_.front().timestamp_ms || start_ms > newest_ms_) return std::nullopt;
+
+    // 二分查找最后一个时间不晚于 start_ms 的关键帧 (关键帧时间单调递增)
+    size_t lo = 0, hi = key_seqs_.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (packets_[key_index(mid)].timestamp_ms <= start_ms) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    size_t k = lo > 0 ? lo - 1 : 0;
+
+    Clip clip;
+    clip.codec = codec_;
+    clip.start_ms = packets_[key_index(k)].timestamp_ms;
+    clip.end_ms = clip.start_ms;
+
+    for (size_t i = key_index(k); i < packets_.size(); i++) {
+        const auto& pkt = packets_[i];
+        if (pkt.timestamp_ms > end_ms) break;
+        clip.end_ms = std::max(clip.end_ms, pkt.timestamp_ms);
+        clip.packets.push_back(pkt);  // 拷贝 (shared_ptr 引用计数+1)
+    }
+
+    if (clip.packets.empty()) return std::nullopt;
+    return clip;
+}
+
+void PacketRing::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    base_seq_ += packets_.size();
+    packets_.clear();
+    key_seqs_.clear();
+    newest_ms_ = 0;
+    bytes_ = 0;
+}
+
+size_t PacketRing::packet_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return packets_.size();
+}
+
+size_t PacketRing::keyframe_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return key_seqs_.size();
+}
+
+size_t PacketRing::memory_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+int64_t PacketRing::duration_ms() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (packets_.empty()) return 0;
+    return newest_ms_ - packets_.front().timestamp_ms;
+}
+
+// ============================================================
+// Private
+// ============================================================
+
+void PacketRing::pop_front_gop() {
+    // 调用方已持有 mutex_, 且 key_seqs_.size() > 1
+    size_t count = key_index(1);
+    for (size_t i = 0; i < count; i++) {
+        bytes_ -= packets_.front().size();
+        packets_.pop_front();
+    }
+    base_seq_ += count;
+    key_seqs_.pop_front();
+}
+
+} // namespace infer_server
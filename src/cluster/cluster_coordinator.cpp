@@ -0,0 +1,397 @@
+/**
+ * @file cluster_coordinator.cpp
+ * @brief 集群协调器实现
+ */
+
+#ifdef HAS_HTTP
+
+#include "infer_server/cluster/cluster_coordinator.h"
+#include "infer_server/common/logger.h"
+#include "infer_server/common/thread_policy.h"
+
+#ifdef HAS_CLUSTER_FORWARD
+#include "infer_server/output/result_forwarder.h"
+#endif
+
+#include <httplib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace infer_server {
+
+using json = nlohmann::json;
+
+namespace {
+
+/// 节点请求超时: 轮询在协调线程上串行进行, 不可达节点不能拖住整轮
+constexpr int kConnectTimeoutSec = 2;
+constexpr int kReadTimeoutSec = 5;
+
+/// 连续轮询失败多少次后判定节点下线 (之前沿用上次观测, 避免一次超时就在其他节点重复添加它的流)
+constexpr int kDownAfterFailures = 3;
+
+/// 去掉 "scheme://" 与路径, 返回 "host:port" 中的主机部分
+std::string host_of(const std::string& url) {
+    std::string rest = url;
+    auto scheme = rest.find("://");
+    if (scheme != std::string::npos) rest = rest.substr(scheme + 3);
+    auto slash = rest.find('/');
+    if (slash != std::string::npos) rest = rest.substr(0, slash);
+    auto colon = rest.rfind(':');
+    if (colon != std::string::npos) rest = rest.substr(0, colon);
+    return rest;
+}
+
+std::string http_error(const httplib::Result& res) {
+    if (!res) return "unreachable (" + httplib::to_string(res.error()) + ")";
+    return "HTTP " + std::to_string(res->status);
+}
+
+} // namespace
+
+ClusterCoordinator::ClusterCoordinator(const ServerConfig& config)
+    : config_(config) {}
+
+ClusterCoordinator::~ClusterCoordinator() {
+    stop();
+}
+
+// ============================================================
+// 生命周期
+// ============================================================
+
+bool ClusterCoordinator::start() {
+    if (running_.load()) return true;
+
+    try {
+        auto streams = ConfigManager::load_streams(config_.cluster_streams_path);
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& s : streams) streams_[s.cam_id] = std::move(s);
+    } catch (const std::exception& e) {
+        LOG_INFO("No cluster streams loaded ({}), starting empty", e.what());
+    }
+
+#ifdef HAS_CLUSTER_FORWARD
+    if (!config_.cluster_zmq_endpoint.empty()) {
+        forwarder_ = std::make_unique<ResultForwarder>(config_.cluster_zmq_endpoint);
+        if (!forwarder_->start()) {
+            LOG_WARN("Cluster result forwarding disabled");
+            forwarder_.reset();
+        }
+    }
+#else
+    if (!config_.cluster_zmq_endpoint.empty()) {
+        LOG_WARN("cluster_zmq_endpoint ignored: built without ENABLE_CLUSTER_FORWARD");
+    }
+#endif
+
+    running_ = true;
+    thread_ = std::thread(&ClusterCoordinator::run, this);
+    LOG_INFO("Cluster coordinator started: {} node(s), {} stream(s), poll every {}ms",
+             config_.cluster_nodes.size(), streams().size(), config_.cluster_poll_ms);
+    return true;
+}
+
+void ClusterCoordinator::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.exchange(false) && !thread_.joinable()) return;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+#ifdef HAS_CLUSTER_FORWARD
+    if (forwarder_) forwarder_->stop();
+#endif
+    LOG_INFO("Cluster coordinator stopped");
+}
+
+void ClusterCoordinator::run() {
+    ThreadPolicy::instance().apply(ThreadRole::Http, "cluster");
+    auto interval = std::chrono::milliseconds(std::max(config_.cluster_poll_ms, 100));
+
+    while (running_.load()) {
+        reconcile();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, interval, [this] { return wake_ || !running_.load(); });
+        wake_ = false;
+    }
+}
+
+// ============================================================
+// 集群流配置
+// ============================================================
+
+bool ClusterCoordinator::add_stream(const StreamConfig& stream) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (streams_.count(stream.cam_id)) return false;
+        streams_[stream.cam_id] = stream;
+        save_streams();
+        wake_ = true;
+    }
+    cv_.notify_all();
+    LOG_INFO("Cluster stream [{}] added", stream.cam_id);
+    return true;
+}
+
+bool ClusterCoordinator::remove_stream(const std::string& cam_id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (streams_.erase(cam_id) == 0) return false;
+        save_streams();
+        wake_ = true;
+    }
+    cv_.notify_all();
+    LOG_INFO("Cluster stream [{}] removed", cam_id);
+    return true;
+}
+
+std::vector<StreamConfig> ClusterCoordinator::streams() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<StreamConfig> out;
+    out.reserve(streams_.size());
+    for (const auto& [cam_id, s] : streams_) out.push_back(s);
+    return out;
+}
+
+// 调用方持有 mutex_
+void ClusterCoordinator::save_streams() const {
+    try {
+        std::vector<StreamConfig> configs;
+        configs.reserve(streams_.size());
+        for (const auto& [cam_id, s] : streams_) configs.push_back(s);
+        ConfigManager::save_streams(config_.cluster_streams_path, configs);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to save cluster streams: {}", e.what());
+    }
+}
+
+// ============================================================
+// 轮询与分配
+// ============================================================
+
+std::vector<std::string> ClusterCoordinator::poll_node(NodeInfo& node) const {
+    httplib::Client cli(node.url);
+    cli.set_connection_timeout(kConnectTimeoutSec);
+    cli.set_read_timeout(kReadTimeoutSec);
+
+    auto res = cli.Get("/api/node");
+    if (!res || res->status != 200) {
+        node.error = "GET /api/node: " + http_error(res);
+        return {};
+    }
+    auto streams_res = cli.Get("/api/streams");
+    if (!streams_res || streams_res->status != 200) {
+        node.error = "GET /api/streams: " + http_error(streams_res);
+        return {};
+    }
+
+    std::vector<std::string> cam_ids;
+    try {
+        const auto data = json::parse(res->body).at("data");
+        node.node_id = data.value("node_id", node.url);
+        node.max_streams = data.value("max_streams", 0);
+        node.npu_util = data.value("npu_util", 0.0);
+        node.drop_rate = data.value("infer_drop_rate", 0.0);
+        std::string zmq = data.value("zmq_endpoint", std::string());
+        node.zmq_endpoint = zmq.empty() ? std::string() : zmq_endpoint_for(node.url, zmq);
+
+        for (const auto& s : json::parse(streams_res->body).at("data")) {
+            cam_ids.push_back(s.at("cam_id").get<std::string>());
+        }
+    } catch (const json::exception& e) {
+        node.error = std::string("invalid response: ") + e.what();
+        return {};
+    }
+
+    node.healthy = true;
+    node.streams = static_cast<int>(cam_ids.size());
+    node.overloaded = node.drop_rate > config_.cluster_drop_rate;
+    return cam_ids;
+}
+
+std::string ClusterCoordinator::apply(const ShardAction& action, const StreamConfig* stream) const {
+    httplib::Client cli(action.node_id);
+    cli.set_connection_timeout(kConnectTimeoutSec);
+    cli.set_read_timeout(kReadTimeoutSec);
+
+    if (action.kind == ShardAction::Kind::Remove) {
+        auto res = cli.Delete("/api/streams/" + action.cam_id);
+        // 404: 节点上已不存在, 目标已达成
+        if (res && (res->status == 200 || res->status == 404)) return {};
+        return "remove [" + action.cam_id + "] from " + action.node_id + ": " + http_error(res);
+    }
+
+    if (!stream) return "add [" + action.cam_id + "]: no stream config";
+    json body = *stream;
+    auto res = cli.Post("/api/streams", body.dump(), "application/json");
+    // 409: 上一轮的添加已生效但响应丢失
+    if (res && (res->status == 200 || res->status == 409)) return {};
+    std::string err = "add [" + action.cam_id + "] to " + action.node_id + ": " + http_error(res);
+    if (res && !res->body.empty()) {
+        try {
+            err += " " + json::parse(res->body).value("message", std::string());
+        } catch (const json::exception&) {}
+    }
+    return err;
+}
+
+void ClusterCoordinator::reconcile() {
+    std::lock_guard<std::mutex> round_lock(reconcile_mutex_);
+
+    std::vector<NodeInfo> nodes;
+    std::map<std::string, std::vector<std::string>> running;
+    for (const auto& url : config_.cluster_nodes) {
+        NodeInfo node;
+        node.url = url;
+        auto cam_ids = poll_node(node);
+        auto& track = tracks_[url];
+        if (node.healthy) {
+            track.failures = 0;
+            track.last = node;
+            track.streams = cam_ids;
+        } else if (++track.failures < kDownAfterFailures && !track.last.url.empty()) {
+            // 偶发失败 / 超时: 沿用上次观测, 节点上的流仍算作运行中
+            LOG_WARN("Cluster node {} poll failed ({}/{}), keeping last state: {}",
+                     url, track.failures, kDownAfterFailures, node.error);
+            std::string error = std::move(node.error);
+            node = track.last;
+            node.error = std::move(error);
+            cam_ids = track.streams;
+        } else {
+            LOG_WARN("Cluster node {} unavailable: {}", url, node.error);
+            cam_ids.clear();
+        }
+        node.poll_failures = track.failures;
+        for (const auto& cam_id : cam_ids) running[cam_id].push_back(url);
+        nodes.push_back(std::move(node));
+    }
+
+    std::map<std::string, StreamConfig> streams;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        streams = streams_;
+    }
+    std::vector<std::string> cams;
+    cams.reserve(streams.size());
+    for (const auto& [cam_id, s] : streams) cams.push_back(cam_id);
+
+    // 节点以 URL 为键: 上报的 node_id 只用于展示, 重名不会影响分配
+    std::vector<NodeLoad> loads;
+    loads.reserve(nodes.size());
+    for (const auto& node : nodes) {
+        NodeLoad load;
+        load.node_id = node.url;
+        load.healthy = node.healthy;
+        load.max_streams = node.max_streams;
+        load.weight = node.max_streams > 0 ? static_cast<double>(node.max_streams) : 1.0;
+        load.overloaded = node.overloaded;
+        load.suspect = node.healthy && node.poll_failures > 0;
+        loads.push_back(load);
+    }
+
+    auto plan = ShardPlanner::plan(cams, loads, running, config_.cluster_max_moves, &shed_);
+
+    std::vector<std::string> errors;
+    for (const auto& action : plan.actions) {
+        const StreamConfig* stream = nullptr;
+        if (action.kind == ShardAction::Kind::Add) {
+            auto it = streams.find(action.cam_id);
+            if (it != streams.end()) stream = &it->second;
+        }
+        std::string err = apply(action, stream);
+        if (err.empty()) {
+            LOG_INFO("Cluster: {} [{}] {} {}",
+                     action.kind == ShardAction::Kind::Add ? "added" : "removed", action.cam_id,
+                     action.kind == ShardAction::Kind::Add ? "to" : "from", action.node_id);
+            continue;
+        }
+        LOG_WARN("Cluster: {}", err);
+        for (auto& node : nodes) {
+            if (node.url == action.node_id) node.error = err;
+        }
+        // 失败的添加下一轮会重新规划
+        if (action.kind == ShardAction::Kind::Add) plan.assignment.erase(action.cam_id);
+        errors.push_back(std::move(err));
+    }
+    if (!plan.unassigned.empty()) {
+        LOG_WARN("Cluster: {} stream(s) unassigned, no node has capacity", plan.unassigned.size());
+    }
+
+#ifdef HAS_CLUSTER_FORWARD
+    if (forwarder_) {
+        std::vector<std::string> upstreams;
+        for (const auto& node : nodes) {
+            if (node.healthy && !node.zmq_endpoint.empty()) upstreams.push_back(node.zmq_endpoint);
+        }
+        forwarder_->set_upstreams(upstreams);
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    nodes_ = std::move(nodes);
+    last_plan_ = std::move(plan);
+    last_errors_ = std::move(errors);
+    rounds_++;
+}
+
+// ============================================================
+// 状态
+// ============================================================
+
+nlohmann::json ClusterCoordinator::status() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    json nodes = json::array();
+    for (const auto& n : nodes_) {
+        nodes.push_back({
+            {"url", n.url},
+            {"node_id", n.node_id},
+            {"healthy", n.healthy},
+            {"streams", n.streams},
+            {"max_streams", n.max_streams},
+            {"npu_util", std::round(n.npu_util * 1000.0) / 1000.0},
+            {"infer_drop_rate", std::round(n.drop_rate * 100.0) / 100.0},
+            {"overloaded", n.overloaded},
+            {"poll_failures", n.poll_failures},
+            {"zmq_endpoint", n.zmq_endpoint},
+            {"error", n.error}
+        });
+    }
+
+    json data;
+    data["nodes"] = std::move(nodes);
+    data["streams_total"] = static_cast<int>(streams_.size());
+    data["assignment"] = last_plan_.assignment;
+    data["unassigned"] = last_plan_.unassigned;
+    data["moves"] = last_plan_.moves;
+    data["deferred"] = last_plan_.deferred;
+    data["errors"] = last_errors_;
+    data["rounds"] = rounds_;
+#ifdef HAS_CLUSTER_FORWARD
+    if (forwarder_) {
+        data["zmq_endpoint"] = forwarder_->endpoint();
+        data["zmq_forwarded"] = forwarder_->forwarded();
+    }
+#endif
+    return data;
+}
+
+std::string ClusterCoordinator::zmq_endpoint_for(const std::string& node_url, const std::string& node_zmq) {
+    auto scheme = node_zmq.find("://");
+    if (scheme == std::string::npos) return node_zmq;
+    std::string prefix = node_zmq.substr(0, scheme + 3);
+    std::string rest = node_zmq.substr(scheme + 3);
+    auto colon = rest.rfind(':');
+    if (colon == std::string::npos) return node_zmq;
+    std::string host = rest.substr(0, colon);
+    if (host != "*" && host != "0.0.0.0" && !host.empty()) return node_zmq;
+    return prefix + host_of(node_url) + rest.substr(colon);
+}
+
+} // namespace infer_server
+
+#endif // HAS_HTTP
@@ -0,0 +1,231 @@
+/**
+ * @file shard_planner.cpp
+ * @brief 多节点分片规划实现 (加权 rendezvous 哈希 + 容量约束)
+ */
+
+#include "infer_server/cluster/shard_planner.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iterator>
+#include <set>
+
+namespace infer_server {
+
+namespace {
+
+uint64_t fnv1a(const std::string& s, uint64_t h = 1469598103934665603ULL) {
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/// splitmix64 终结混合: FNV 对相近的字符串 (cam01 / cam02) 低位差异小, 混合后再取均匀分布
+uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+double ShardPlanner::score(const std::string& node_id, const std::string& cam_id, double weight) {
+    uint64_t h = mix64(fnv1a(cam_id, fnv1a(node_id) ^ 0xFFULL));
+    // 取高 53 位映射到 (0, 1)
+    double u = (static_cast<double>(h >> 11) + 0.5) / 9007199254740992.0;
+    return -std::max(weight, 1e-9) / std::log(u);
+}
+
+std::vector<size_t> ShardPlanner::rank(const std::string& cam_id, const std::vector<NodeLoad>& nodes) {
+    std::vector<std::pair<double, size_t>> scored;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!nodes[i].healthy) continue;
+        scored.emplace_back(score(nodes[i].node_id, cam_id, nodes[i].weight), i);
+    }
+    std::sort(scored.begin(), scored.end(), [&](const auto& a, const auto& b) {
+        if (a.first != b.first) return a.first > b.first;
+        return nodes[a.second].node_id < nodes[b.second].node_id;
+    });
+    std::vector<size_t> order;
+    order.reserve(scored.size());
+    for (const auto& [s, i] : scored) order.push_back(i);
+    return order;
+}
+
+ShardPlan ShardPlanner::plan(const std::vector<std::string>& cams,
+                             const std::vector<NodeLoad>& nodes,
+                             const std::map<std::string, std::vector<std::string>>& running,
+                             int max_moves, ShedState* shed) {
+    ShardPlan plan;
+    std::set<std::string> desired(cams.begin(), cams.end());
+
+    std::map<std::string, size_t> index;
+    for (size_t i = 0; i < nodes.size(); i++) index[nodes[i].node_id] = i;
+    auto locate = [&](const std::string& node_id) -> int {
+        auto it = index.find(node_id);
+        if (it == index.end() || !nodes[it->second].healthy) return -1;
+        return static_cast<int>(it->second);
+    };
+
+    // 各节点当前运行的期望流数 (过载节点据此降低容量)
+    std::vector<int> observed(nodes.size(), 0);
+    for (const auto& [cam, where] : running) {
+        if (!desired.count(cam)) continue;
+        std::set<int> seen;
+        for (const auto& node_id : where) {
+            int i = locate(node_id);
+            if (i >= 0 && seen.insert(i).second) observed[static_cast<size_t>(i)]++;
+        }
+    }
+
+    std::vector<int> caps(nodes.size(), 0);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!nodes[i].healthy) continue;
+        caps[i] = nodes[i].max_streams > 0 ? nodes[i].max_streams : INT_MAX;
+        // 疑似故障: 负载信息已过时, 既不分配新流也不按过载迁出
+        if (nodes[i].suspect) {
+            caps[i] = observed[i];
+            continue;
+        }
+        if (nodes[i].overloaded) caps[i] = std::min(caps[i], std::max(0, observed[i] - 1));
+        if (!shed) continue;
+
+        // 记住迁出后的上限: 过载时取更低者; 之后每连续 cooldown_rounds 轮不过载放开一路
+        auto it = shed->nodes.find(nodes[i].node_id);
+        if (nodes[i].overloaded) {
+            auto& entry = shed->nodes[nodes[i].node_id];
+            entry.cap = it == shed->nodes.end() ? caps[i] : std::min(entry.cap, caps[i]);
+            entry.calm_rounds = 0;
+        } else if (it != shed->nodes.end()) {
+            auto& entry = it->second;
+            if (++entry.calm_rounds >= std::max(1, shed->cooldown_rounds)) {
+                entry.cap++;
+                entry.calm_rounds = 0;
+            }
+            caps[i] = std::min(caps[i], entry.cap);
+        }
+    }
+
+    // 目标分配: 按 cam_id 顺序, 每路取得分最高且有容量的节点
+    std::map<std::string, int> target;
+    std::map<std::string, std::vector<size_t>> ranks;
+    std::vector<int> fill(nodes.size(), 0);
+    for (const auto& cam : desired) {
+        auto& order = ranks[cam];
+        order = rank(cam, nodes);
+        target[cam] = -1;
+        for (size_t i : order) {
+            if (fill[i] < caps[i]) {
+                fill[i]++;
+                target[cam] = static_cast<int>(i);
+                break;
+            }
+        }
+    }
+
+    // 上限不再起作用 (目标分配已低于上限) 或节点已移出集群: 忘记
+    if (shed) {
+        for (auto it = shed->nodes.begin(); it != shed->nodes.end();) {
+            auto found = index.find(it->first);
+            bool drop = found == index.end();
+            if (!drop) {
+                size_t i = found->second;
+                drop = nodes[i].healthy && !nodes[i].suspect && !nodes[i].overloaded &&
+                       fill[i] < it->second.cap;
+            }
+            it = drop ? shed->nodes.erase(it) : std::next(it);
+        }
+    }
+
+    std::vector<ShardAction> removes;
+    std::vector<ShardAction> adds;
+    auto remove = [&](const std::string& cam, size_t i) {
+        removes.push_back({ShardAction::Kind::Remove, cam, nodes[i].node_id});
+    };
+    auto add = [&](const std::string& cam, size_t i) {
+        adds.push_back({ShardAction::Kind::Add, cam, nodes[i].node_id});
+    };
+
+    // 当前位置: 优先认定目标节点上的副本, 其余副本与已删除的流移除
+    std::map<std::string, int> current;
+    std::vector<int> counts(nodes.size(), 0);
+    for (const auto& [cam, where] : running) {
+        std::vector<int> located;
+        for (const auto& node_id : where) {
+            int i = locate(node_id);
+            if (i >= 0 && std::find(located.begin(), located.end(), i) == located.end()) {
+                located.push_back(i);
+            }
+        }
+        if (!desired.count(cam)) {
+            for (int i : located) remove(cam, static_cast<size_t>(i));
+            continue;
+        }
+        if (located.empty()) continue;
+        int keep = located.front();
+        if (std::find(located.begin(), located.end(), target[cam]) != located.end()) keep = target[cam];
+        for (int i : located) {
+            if (i != keep) remove(cam, static_cast<size_t>(i));
+        }
+        current[cam] = keep;
+        counts[static_cast<size_t>(keep)]++;
+    }
+
+    // 未运行的流: 立即添加 (目标节点已满时取下一个有容量的节点)
+    for (const auto& cam : desired) {
+        if (current.count(cam)) continue;
+        int chosen = -1;
+        int t = target[cam];
+        if (t >= 0 && counts[static_cast<size_t>(t)] < caps[static_cast<size_t>(t)]) {
+            chosen = t;
+        } else {
+            for (size_t i : ranks[cam]) {
+                if (counts[i] < caps[i]) {
+                    chosen = static_cast<int>(i);
+                    break;
+                }
+            }
+        }
+        if (chosen < 0) {
+            plan.unassigned.push_back(cam);
+            continue;
+        }
+        add(cam, static_cast<size_t>(chosen));
+        counts[static_cast<size_t>(chosen)]++;
+        current[cam] = chosen;
+    }
+
+    // 再平衡: 不在目标节点上的流, 每轮最多迁移 max_moves 路
+    for (const auto& cam : desired) {
+        auto it = current.find(cam);
+        if (it == current.end()) continue;
+        int from = it->second;
+        int to = target[cam];
+        if (to < 0 || to == from) continue;
+        if (nodes[static_cast<size_t>(from)].suspect) continue;    // 移除请求多半也会超时
+        if ((max_moves >= 0 && plan.moves >= max_moves) ||
+            counts[static_cast<size_t>(to)] >= caps[static_cast<size_t>(to)]) {
+            plan.deferred++;
+            continue;
+        }
+        remove(cam, static_cast<size_t>(from));
+        add(cam, static_cast<size_t>(to));
+        counts[static_cast<size_t>(from)]--;
+        counts[static_cast<size_t>(to)]++;
+        it->second = to;
+        plan.moves++;
+    }
+
+    plan.actions = std::move(removes);
+    plan.actions.insert(plan.actions.end(), adds.begin(), adds.end());
+    for (const auto& [cam, i] : current) {
+        plan.assignment[cam] = nodes[static_cast<size_t>(i)].node_id;
+    }
+    return plan;
+}
+
+} // namespace infer_server
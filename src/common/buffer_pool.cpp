@@ -0,0 +1,102 @@
+/**
+ * @file buffer_pool.cpp
+ * @brief 可回收字节缓冲池实现
+ */
+
+#include "infer_server/common/buffer_pool.h"
+#include <iterator>
+
+namespace infer_server {
+
+namespace {
+constexpr size_t kClassGranularity = 64 * 1024;
+} // namespace
+
+BufferPool& BufferPool::global() {
+    // 有意泄漏: 解码线程 / 推理任务可能晚于静态析构释放缓冲区
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+}
+
+BufferPool::BufferPool(size_t max_idle_bytes)
+    : max_idle_bytes_(max_idle_bytes) {}
+
+size_t BufferPool::size_class(size_t size) {
+    if (size == 0) return kClassGranularity;
+    return (size + kClassGranularity - 1) / kClassGranularity * kClassGranularity;
+}
+
+BufferPool::Buffer BufferPool::acquire(size_t size) {
+    size_t cls = size_class(size);
+    std::unique_ptr<std::vector<uint8_t>> buf;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = free_lists_.find(cls);
+        if (it != free_lists_.end() && !it->second.empty()) {
+            buf = std::move(it->second.back());
+            it->second.pop_back();
+            stats_.hits++;
+            stats_.bytes_idle -= cls;
+            stats_.idle_buffers--;
+        } else {
+            stats_.misses++;
+        }
+        stats_.bytes_in_use += cls;
+    }
+
+    if (!buf) {
+        buf = std::make_unique<std::vector<uint8_t>>();
+        buf->reserve(cls);
+    }
+    // 容量已满足, 不会重新分配; 同尺寸复用时为空操作
+    buf->resize(size);
+
+    return Buffer(buf.release(), [this, cls](std::vector<uint8_t>* p) {
+        release(p, cls);
+    });
+}
+
+void BufferPool::release(std::vector<uint8_t>* buf, size_t cls) {
+    std::unique_ptr<std::vector<uint8_t>> owned(buf);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.bytes_in_use -= cls;
+    if (stats_.bytes_idle + cls > max_idle_bytes_) {
+        return;  // 超出空闲上限, 直接释放
+    }
+    free_lists_[cls].push_back(std::move(owned));
+    stats_.bytes_idle += cls;
+    stats_.idle_buffers++;
+}
+
+void BufferPool::set_max_idle_bytes(size_t max_idle_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_idle_bytes_ = max_idle_bytes;
+    trim_locked(max_idle_bytes_);
+}
+
+void BufferPool::trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    trim_locked(0);
+}
+
+void BufferPool::trim_locked(size_t target_idle_bytes) {
+    for (auto it = free_lists_.begin();
+         it != free_lists_.end() && stats_.bytes_idle > target_idle_bytes;) {
+        auto& list = it->second;
+        while (!list.empty() && stats_.bytes_idle > target_idle_bytes) {
+            list.pop_back();
+            stats_.bytes_idle -= it->first;
+            stats_.idle_buffers--;
+        }
+        it = list.empty() ? free_lists_.erase(it) : std::next(it);
+    }
+}
+
+BufferPool::Stats BufferPool::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace infer_server
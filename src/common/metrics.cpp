@@ -0,0 +1,221 @@
+/**
+ * @file metrics.cpp
+ * @brief 延迟直方图与 Prometheus 文本格式输出实现
+ */
+
+#include "infer_server/common/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace infer_server {
+
+// ============================================================
+// LatencyHistogram
+// ============================================================
+
+size_t LatencyHistogram::bucket_index(uint64_t us) {
+    constexpr uint64_t kMax = (uint64_t{1} << kMaxBits) - 1;
+    us = std::min(us, kMax);
+    if (us < static_cast<uint64_t>(kSubBuckets)) return static_cast<size_t>(us);
+
+    // 最高位 e (>= kSubBits), 其后 kSubBits 位为子桶号
+    int e = 63 - __builtin_clzll(us);
+    uint64_t sub = (us >> (e - kSubBits)) & (kSubBuckets - 1);
+    return static_cast<size_t>((e - kSubBits + 1) * kSubBuckets) + static_cast<size_t>(sub);
+}
+
+uint64_t LatencyHistogram::bucket_upper(size_t index) {
+    if (index < static_cast<size_t>(kSubBuckets)) return index;
+    int e = static_cast<int>(index / kSubBuckets) + kSubBits - 1;
+    uint64_t sub = index % kSubBuckets;
+    uint64_t width = uint64_t{1} << (e - kSubBits);
+    return (static_cast<uint64_t>(kSubBuckets) + sub) * width + width - 1;
+}
+
+void LatencyHistogram::record_us(uint64_t us) {
+    buckets_[bucket_index(us)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_us_.fetch_add(us, std::memory_order_relaxed);
+
+    uint64_t prev = max_us_.load(std::memory_order_relaxed);
+    while (us > prev && !max_us_.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot snap;
+    snap.buckets.resize(kBuckets);
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        snap.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += snap.buckets[i];
+    }
+    // 与 record 并发时 count_ 可能与桶计数略有出入, 以桶为准保证分位数自洽
+    snap.count = total;
+    snap.sum_us = sum_us_.load(std::memory_order_relaxed);
+    snap.max_us = max_us_.load(std::memory_order_relaxed);
+    return snap;
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile_us(double q) const {
+    if (count == 0) return 0;
+    q = std::clamp(q, 0.0, 1.0);
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank) return std::min(bucket_upper(i), max_us);
+    }
+    return max_us;
+}
+
+void LatencyHistogram::Snapshot::merge(const Snapshot& other) {
+    if (buckets.size() < other.buckets.size()) buckets.resize(other.buckets.size());
+    for (size_t i = 0; i < other.buckets.size(); i++) buckets[i] += other.buckets[i];
+    count += other.count;
+    sum_us += other.sum_us;
+    max_us = std::max(max_us, other.max_us);
+}
+
+void LatencyHistogram::Snapshot::subtract(const Snapshot& earlier) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        uint64_t prev = i < earlier.buckets.size() ? earlier.buckets[i] : 0;
+        buckets[i] = buckets[i] > prev ? buckets[i] - prev : 0;
+        total += buckets[i];
+    }
+    count = total;
+    sum_us = sum_us > earlier.sum_us ? sum_us - earlier.sum_us : 0;
+}
+
+const char* latency_stage_name(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::Decode:      return "decode";
+        case LatencyStage::Nv12Copy:    return "nv12_copy";
+        case LatencyStage::Rga:         return "rga";
+        case LatencyStage::QueueWait:   return "queue_wait";
+        case LatencyStage::Npu:         return "npu";
+        case LatencyStage::PostProcess: return "post_process";
+        case LatencyStage::Aggregate:   return "aggregate";
+        case LatencyStage::Publish:     return "publish";
+        case LatencyStage::EndToEnd:    return "end_to_end";
+    }
+    return "unknown";
+}
+
+// ============================================================
+// RateMeter
+// ============================================================
+
+void RateMeter::mark(uint64_t n, int64_t now_ns) {
+    int64_t sec = now_ns / 1000000000;
+    uint64_t tag = static_cast<uint64_t>(sec) & kEpochMask;
+    auto& slot = slots_[static_cast<size_t>(sec) % kSlots];
+
+    uint64_t v = slot.load(std::memory_order_relaxed);
+    while ((v >> kCountBits) != tag) {
+        // 槽位仍是 64 秒前的计数: 换成当前秒 (失败时 v 为最新值, 可能已被其他线程换新)
+        if (slot.compare_exchange_weak(v, (tag << kCountBits) | (n & kCountMask),
+                                       std::memory_order_relaxed)) {
+            return;
+        }
+    }
+    slot.fetch_add(n, std::memory_order_relaxed);
+}
+
+RateMeter::Rates RateMeter::rates(int64_t now_ns) const {
+    int64_t sec = now_ns / 1000000000;
+    int64_t start_sec = start_ns_.load(std::memory_order_relaxed) / 1000000000;
+
+    constexpr double kTau[3] = {1.0, 10.0, 60.0};
+    double num[3] = {0.0, 0.0, 0.0};
+    double den[3] = {0.0, 0.0, 0.0};
+    for (int k = 0; k < kWindowSec; k++) {
+        // 只取 reset 之后的完整秒 (当前秒与 reset 所在秒都不完整)
+        int64_t s = sec - 1 - k;
+        if (s <= start_sec) break;
+        uint64_t v = slots_[static_cast<size_t>(s) % kSlots].load(std::memory_order_relaxed);
+        uint64_t count = (v >> kCountBits) == (static_cast<uint64_t>(s) & kEpochMask) ? (v & kCountMask) : 0;
+        for (int w = 0; w < 3; w++) {
+            double weight = std::exp(-static_cast<double>(k) / kTau[w]);
+            num[w] += weight * static_cast<double>(count);
+            den[w] += weight;
+        }
+    }
+
+    Rates r;
+    if (den[0] > 0.0) {
+        r.last_1s = num[0] / den[0];
+        r.last_10s = num[1] / den[1];
+        r.last_60s = num[2] / den[2];
+    }
+    return r;
+}
+
+// ============================================================
+// PrometheusWriter
+// ============================================================
+
+std::string PrometheusWriter::escape(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '"':  out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            default:   out += c; break;
+        }
+    }
+    return out;
+}
+
+void PrometheusWriter::declare(const std::string& name, const char* type, const char* help) {
+    if (name == last_declared_) return;
+    last_declared_ = name;
+    out_ += "# HELP " + name + " " + help + "\n";
+    out_ += "# TYPE " + name + " " + type + "\n";
+}
+
+void PrometheusWriter::line(const std::string& name, const Labels& labels, double value,
+                            const char* extra_key, const char* extra_value) {
+    out_ += name;
+    if (!labels.empty() || extra_key) {
+        out_ += '{';
+        bool first = true;
+        for (const auto& [key, val] : labels) {
+            if (!first) out_ += ',';
+            first = false;
+            out_ += key + "=\"" + escape(val) + "\"";
+        }
+        if (extra_key) {
+            if (!first) out_ += ',';
+            out_ += std::string(extra_key) + "=\"" + extra_value + "\"";
+        }
+        out_ += '}';
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), " %.9g\n", value);
+    out_ += buf;
+}
+
+void PrometheusWriter::sample(const std::string& name, const char* type, const char* help,
+                              const Labels& labels, double value) {
+    declare(name, type, help);
+    line(name, labels, value);
+}
+
+void PrometheusWriter::summary(const std::string& name, const char* help, const Labels& labels,
+                               const LatencyHistogram::Snapshot& snap) {
+    declare(name, "summary", help);
+    constexpr double kUsToSec = 1e-6;
+    line(name, labels, static_cast<double>(snap.percentile_us(0.5)) * kUsToSec, "quantile", "0.5");
+    line(name, labels, static_cast<double>(snap.percentile_us(0.99)) * kUsToSec, "quantile", "0.99");
+    line(name, labels, static_cast<double>(snap.percentile_us(0.999)) * kUsToSec, "quantile", "0.999");
+    line(name + "_sum", labels, static_cast<double>(snap.sum_us) * kUsToSec);
+    line(name + "_count", labels, static_cast<double>(snap.count));
+}
+
+} // namespace infer_server
@@ -0,0 +1,276 @@
+/**
+ * @file thread_policy.cpp
+ * @brief 线程命名 / 亲和性 / 调度优先级策略实现 (Linux)
+ */
+
+#include "infer_server/common/thread_policy.h"
+#include "infer_server/common/logger.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace infer_server {
+
+namespace {
+
+/// pthread_setname_np 上限 (不含结尾 '\0')
+constexpr size_t kMaxThreadName = 15;
+
+/// 读取 sysfs 中的单个整数, 不存在返回 -1
+long read_sysfs_long(const std::filesystem::path& path) {
+    std::ifstream in(path);
+    long value = -1;
+    if (!(in >> value)) return -1;
+    return value;
+}
+
+/// 同类告警只打印一次 (例如非特权进程每个线程都设置 SCHED_FIFO 失败)
+void warn_once(std::atomic<bool>& flag, const std::string& message) {
+    if (!flag.exchange(true)) LOG_WARN("{}", message);
+}
+
+bool all_digits(const std::string& s) {
+    return !s.empty() && std::all_of(s.begin(), s.end(),
+                                     [](unsigned char c) { return std::isdigit(c) != 0; });
+}
+
+std::atomic<bool> g_affinity_warned{false};
+std::atomic<bool> g_fifo_warned{false};
+std::atomic<bool> g_nice_warned{false};
+
+} // namespace
+
+const char* thread_role_name(ThreadRole role) {
+    switch (role) {
+        case ThreadRole::Decode: return "decode";
+        case ThreadRole::Preprocess: return "preprocess";
+        case ThreadRole::Encode: return "encode";
+        case ThreadRole::Infer: return "infer";
+        case ThreadRole::PostProcess: return "postprocess";
+        case ThreadRole::Output: return "output";
+        case ThreadRole::Http: return "http";
+    }
+    return "unknown";
+}
+
+ThreadPolicy& ThreadPolicy::instance() {
+    static ThreadPolicy* policy = new ThreadPolicy();
+    return *policy;
+}
+
+ThreadPolicy::Options ThreadPolicy::from_config(const ServerConfig& config) {
+    Options options;
+    options.infer_rt_priority = std::clamp(config.infer_rt_priority, 0, 99);
+    options.infer_nice = std::clamp(config.infer_nice, -20, 19);
+    options.decode_nice = std::clamp(config.decode_nice, -20, 19);
+    if (!config.thread_affinity) return options;
+
+    options.big_cores = parse_cpu_list(config.cpu_big_cores);
+    options.little_cores = parse_cpu_list(config.cpu_little_cores);
+    if (!config.cpu_big_cores.empty() && options.big_cores.empty()) {
+        LOG_WARN("Invalid cpu_big_cores '{}', detecting from sysfs", config.cpu_big_cores);
+    }
+    if (!config.cpu_little_cores.empty() && options.little_cores.empty()) {
+        LOG_WARN("Invalid cpu_little_cores '{}', detecting from sysfs", config.cpu_little_cores);
+    }
+
+    if (options.big_cores.empty() || options.little_cores.empty()) {
+        auto topo = detect_topology();
+        if (options.big_cores.empty()) options.big_cores = topo.big;
+        if (options.little_cores.empty()) options.little_cores = topo.little;
+    }
+
+    if (options.big_cores.empty() || options.little_cores.empty()) {
+        LOG_WARN("thread_affinity: no big.LITTLE split found (big='{}', little='{}'), "
+                 "threads are not pinned", format_cpu_list(options.big_cores),
+                 format_cpu_list(options.little_cores));
+        options.big_cores.clear();
+        options.little_cores.clear();
+        return options;
+    }
+    options.affinity = true;
+    return options;
+}
+
+void ThreadPolicy::configure(const Options& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+}
+
+ThreadPolicy::Options ThreadPolicy::options() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+std::vector<int> ThreadPolicy::cpus_for(ThreadRole role, int index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!options_.affinity) return {};
+
+    const auto& big = options_.big_cores;
+    const auto& little = options_.little_cores;
+    switch (role) {
+        case ThreadRole::Infer:
+            if (big.empty()) return {};
+            return {big[static_cast<size_t>(std::max(index, 0)) % big.size()]};
+        case ThreadRole::PostProcess:
+            return big;
+        case ThreadRole::Decode:
+        case ThreadRole::Preprocess:
+        case ThreadRole::Encode:
+        case ThreadRole::Http:
+            return little;
+        case ThreadRole::Output:
+            return {};
+    }
+    return {};
+}
+
+void ThreadPolicy::apply(ThreadRole role, const std::string& name, int index) const {
+    set_current_name(name);
+
+    auto cpus = cpus_for(role, index);
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+        }
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (ret != 0) {
+            warn_once(g_affinity_warned, "ThreadPolicy: failed to pin " + name + " to CPUs " +
+                      format_cpu_list(cpus) + ": " + std::strerror(ret));
+        }
+    }
+
+    Options options = this->options();
+    bool infer_side = role == ThreadRole::Infer || role == ThreadRole::PostProcess;
+    bool stream_side = role == ThreadRole::Decode || role == ThreadRole::Preprocess ||
+                       role == ThreadRole::Encode;
+
+    if (role == ThreadRole::Infer && options.infer_rt_priority > 0) {
+        sched_param param{};
+        param.sched_priority = options.infer_rt_priority;
+        int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (ret == 0) return;
+        warn_once(g_fifo_warned, "ThreadPolicy: SCHED_FIFO priority " +
+                  std::to_string(options.infer_rt_priority) + " not applied (" +
+                  std::strerror(ret) + "), needs CAP_SYS_NICE; falling back to nice");
+    }
+
+    int nice = infer_side ? options.infer_nice : (stream_side ? options.decode_nice : 0);
+    if (nice != 0) {
+        // Linux 上 nice 值按线程 (tid) 生效
+        auto tid = static_cast<id_t>(syscall(SYS_gettid));
+        if (setpriority(PRIO_PROCESS, tid, nice) != 0) {
+            warn_once(g_nice_warned, "ThreadPolicy: failed to set nice " + std::to_string(nice) +
+                      " for " + name + ": " + std::strerror(errno));
+        }
+    }
+}
+
+bool ThreadPolicy::set_current_name(const std::string& name) {
+    std::string truncated = name.substr(0, kMaxThreadName);
+    return pthread_setname_np(pthread_self(), truncated.c_str()) == 0;
+}
+
+std::vector<int> ThreadPolicy::parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t comma = list.find(',', pos);
+        std::string item = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        pos = comma == std::string::npos ? list.size() : comma + 1;
+
+        item.erase(std::remove_if(item.begin(), item.end(),
+                                  [](unsigned char c) { return std::isspace(c) != 0; }),
+                   item.end());
+        if (item.empty()) return {};
+
+        size_t dash = item.find('-');
+        std::string lo_str = item.substr(0, dash);
+        std::string hi_str = dash == std::string::npos ? lo_str : item.substr(dash + 1);
+        if (!all_digits(lo_str) || !all_digits(hi_str) || lo_str.size() > 4 || hi_str.size() > 4) {
+            return {};
+        }
+        int lo = std::stoi(lo_str);
+        int hi = std::stoi(hi_str);
+        if (lo > hi || hi >= CPU_SETSIZE) return {};
+        for (int cpu = lo; cpu <= hi; cpu++) cpus.push_back(cpu);
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::string ThreadPolicy::format_cpu_list(const std::vector<int>& cpus) {
+    std::string out;
+    size_t i = 0;
+    while (i < cpus.size()) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+        if (!out.empty()) out += ',';
+        out += std::to_string(cpus[i]);
+        if (j > i) out += '-' + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return out;
+}
+
+ThreadPolicy::Topology ThreadPolicy::detect_topology(const std::string& sysfs_root) {
+    namespace fs = std::filesystem;
+    std::vector<std::pair<int, long>> capacity;  // (cpu, capacity / max_freq)
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(sysfs_root, ec)) {
+        std::string dir = entry.path().filename().string();
+        if (dir.compare(0, 3, "cpu") != 0 || !all_digits(dir.substr(std::min<size_t>(3, dir.size())))) {
+            continue;
+        }
+        int cpu = std::stoi(dir.substr(3));
+        long value = read_sysfs_long(entry.path() / "cpu_capacity");
+        if (value <= 0) value = read_sysfs_long(entry.path() / "cpufreq" / "cpuinfo_max_freq");
+        if (value > 0) capacity.emplace_back(cpu, value);
+    }
+
+    Topology topo;
+    if (capacity.empty()) return topo;
+
+    long max_value = 0;
+    for (const auto& [cpu, value] : capacity) max_value = std::max(max_value, value);
+    for (const auto& [cpu, value] : capacity) {
+        (value == max_value ? topo.big : topo.little).push_back(cpu);
+    }
+    std::sort(topo.big.begin(), topo.big.end());
+    std::sort(topo.little.begin(), topo.little.end());
+    return topo;
+}
+
+std::string ThreadPolicy::describe() const {
+    Options options = this->options();
+    std::string out;
+    if (options.affinity) {
+        out = "big=" + format_cpu_list(options.big_cores) +
+              " little=" + format_cpu_list(options.little_cores);
+    } else {
+        out = "no pinning";
+    }
+    if (options.infer_rt_priority > 0) {
+        out += ", infer SCHED_FIFO " + std::to_string(options.infer_rt_priority);
+    }
+    if (options.infer_nice != 0) out += ", infer nice " + std::to_string(options.infer_nice);
+    if (options.decode_nice != 0) out += ", decode nice " + std::to_string(options.decode_nice);
+    return out;
+}
+
+} // namespace infer_server
@@ -2,6 +2,12 @@
 
 #include "infer_server/decoder/hw_decoder.h"
 #include "infer_server/common/logger.h"
+#include "infer_server/common/buffer_pool.h"
+#include "infer_server/cache/packet_ring.h"
+
+#ifdef HAS_RGA
+#include "infer_server/processor/rga_processor.h"
+#endif
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -10,10 +16,13 @@ extern "C" {
 #include <libavutil/imgutils.h>
 #include <libavutil/time.h>
 #include <libavutil/opt.h>
+#include <libavutil/hwcontext_drm.h>
 }
 
+#include <algorithm>
 #include <cstring>
 #include <chrono>
+#include <thread>
 
 namespace infer_server {
 
@@ -27,19 +36,23 @@ bool HwDecoder::open(const Config& config) {
         close();
     }
 
-    LOG_INFO("Opening RTSP stream: {}", config.rtsp_url);
+    file_source_ = is_file_source(config.rtsp_url);
+    LOG_INFO("Opening {}: {}", file_source_ ? "local file" : "RTSP stream", config.rtsp_url);
+    config_ = config;
 
     // ========================
     // 设置 RTSP 选项
     // ========================
     AVDictionary* opts = nullptr;
-    if (config.tcp_transport) {
-        av_dict_set(&opts, "rtsp_transport", "tcp", 0);
+    if (!file_source_) {
+        if (config.tcp_transport) {
+            av_dict_set(&opts, "rtsp_transport", "tcp", 0);
+        }
+        // 连接超时 (微秒)
+        std::string timeout_us = std::to_string(
+            static_cast<int64_t>(config.connect_timeout_sec) * 1000000);
+        av_dict_set(&opts, "stimeout", timeout_us.c_str(), 0);
     }
-    // 连接超时 (微秒)
-    std::string timeout_us = std::to_string(
-        static_cast<int64_t>(config.connect_timeout_sec) * 1000000);
-    av_dict_set(&opts, "stimeout", timeout_us.c_str(), 0);
     // 最大分析时长
     av_dict_set(&opts, "analyzeduration", "2000000", 0);
     av_dict_set(&opts, "probesize", "2000000", 0);
@@ -47,6 +60,18 @@ bool HwDecoder::open(const Config& config) {
     // ========================
     // 打开输入流
     // ========================
+    // 中断回调: 停止请求可打断连接 / 读取; 截止时间兜底 stimeout 不覆盖的阻塞
+    // (avformat_open_input 失败时会释放 fmt_ctx_ 并置空)
+    fmt_ctx_ = avformat_alloc_context();
+    if (!fmt_ctx_) {
+        av_dict_free(&opts);
+        LOG_ERROR("Failed to allocate format context");
+        return false;
+    }
+    fmt_ctx_->interrupt_callback.callback = &HwDecoder::interrupt_callback;
+    fmt_ctx_->interrupt_callback.opaque = this;
+    io_deadline_ns_ = mono_now_ns() + static_cast<int64_t>(config.connect_timeout_sec) * 1000000000LL;
+
     int ret = avformat_open_input(&fmt_ctx_, config.rtsp_url.c_str(),
                                   nullptr, &opts);
     av_dict_free(&opts);
@@ -61,7 +86,9 @@ bool HwDecoder::open(const Config& config) {
     // ========================
     // 获取流信息
     // ========================
+    io_deadline_ns_ = mono_now_ns() + static_cast<int64_t>(config.read_timeout_sec) * 1000000000LL;
     ret = avformat_find_stream_info(fmt_ctx_, nullptr);
+    io_deadline_ns_ = 0;
     if (ret < 0) {
         LOG_ERROR("Failed to find stream info");
         close();
@@ -137,6 +164,26 @@ bool HwDecoder::open(const Config& config) {
         codec_ctx_->thread_count = 2;
     }
 
+    // 解码模式: 解复用层过滤为主; skip_frame 对软件解码器额外生效
+    discarded_packets_ = 0;
+    last_output_ms_ = -1;
+    output_interval_ms_ = 0.0;
+    nonref_filter_.reset();
+    if (config.decode_mode == DecodeMode::NonRef) {
+        if (stream->codecpar->codec_id == AV_CODEC_ID_H264) {
+            nonref_filter_ = std::make_unique<NonRefPacketFilter>(NalCodec::H264);
+        } else if (stream->codecpar->codec_id == AV_CODEC_ID_HEVC) {
+            nonref_filter_ = std::make_unique<NonRefPacketFilter>(NalCodec::H265);
+        } else {
+            LOG_WARN("decode_mode=nonref not supported for codec_id {}, decoding all frames",
+                     stream->codecpar->codec_id);
+        }
+        codec_ctx_->skip_frame = AVDISCARD_NONREF;
+    } else if (config.decode_mode == DecodeMode::Keyframe) {
+        codec_ctx_->skip_frame = AVDISCARD_NONKEY;
+        codec_ctx_->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    }
+
     ret = avcodec_open2(codec_ctx_, codec, nullptr);
     if (ret < 0) {
         char errbuf[256];
@@ -162,6 +209,16 @@ bool HwDecoder::open(const Config& config) {
         LOG_WARN("Could not determine FPS, defaulting to {:.1f}", fps_);
     }
 
+    // 本地文件: 按回放帧率读包, 对外报告回放帧率 (准入控制 / 跳帧按它换算)
+    loop_offset_ = 0;
+    loop_end_pts_ = 0;
+    next_packet_ns_ = 0;
+    packet_interval_ns_ = 0;
+    if (file_source_ && config.file_fps >= 0.0) {
+        if (config.file_fps > 0.0) fps_ = config.file_fps;
+        packet_interval_ns_ = static_cast<int64_t>(1e9 / fps_);
+    }
+
     // ========================
     // 分配帧和数据包
     // ========================
@@ -175,161 +232,351 @@ bool HwDecoder::open(const Config& config) {
         return false;
     }
 
+    // 码流缓存: 新会话的时间戳与之前不连续, 清空旧包
+    if (packet_ring_) {
+        ClipCodecInfo info;
+        info.codec_id = static_cast<int>(stream->codecpar->codec_id);
+        info.width = stream->codecpar->width;
+        info.height = stream->codecpar->height;
+        info.time_base_num = stream->time_base.num;
+        info.time_base_den = stream->time_base.den;
+        if (stream->avg_frame_rate.num > 0 && stream->avg_frame_rate.den > 0) {
+            info.fps_num = stream->avg_frame_rate.num;
+            info.fps_den = stream->avg_frame_rate.den;
+        }
+        if (stream->codecpar->extradata && stream->codecpar->extradata_size > 0) {
+            info.extradata.assign(stream->codecpar->extradata,
+                                  stream->codecpar->extradata + stream->codecpar->extradata_size);
+        }
+        packet_ring_->reset(std::move(info));
+    }
+
     is_open_ = true;
-    LOG_INFO("Decoder opened successfully: {}x{} @ {:.1f}fps, codec={}, hw={}",
-             width_, height_, fps_, codec_name_, is_hw_decoder_);
+    LOG_INFO("Decoder opened successfully: {}x{} @ {:.1f}fps, codec={}, hw={}, mode={}",
+             width_, height_, fps_, codec_name_, is_hw_decoder_,
+             decode_mode_to_string(config.decode_mode));
 
     return true;
 }
 
 std::optional<DecodedFrame> HwDecoder::decode_frame() {
-    if (!is_open_) {
-        return std::nullopt;
+    std::optional<DecodedFrame> frame;
+    while (true) {
+        auto status = poll(true, frame);
+        if (status == PollStatus::Frame) return frame;
+        if (status == PollStatus::Error) return std::nullopt;
     }
+}
 
+bool HwDecoder::skip_frame() {
+    std::optional<DecodedFrame> unused;
     while (true) {
-        // 读取一个数据包
-        int ret = av_read_frame(fmt_ctx_, packet_);
-        if (ret < 0) {
-            if (ret == AVERROR_EOF) {
-                LOG_INFO("Stream EOF");
-            } else {
-                char errbuf[256];
-                av_strerror(ret, errbuf, sizeof(errbuf));
-                LOG_ERROR("Error reading frame: {}", errbuf);
-            }
-            return std::nullopt;
-        }
+        auto status = poll(false, unused);
+        if (status == PollStatus::Skipped) return true;
+        if (status == PollStatus::Error) return false;
+    }
+}
 
-        // 跳过非视频包
-        if (packet_->stream_index != video_stream_idx_) {
-            av_packet_unref(packet_);
-            continue;
+HwDecoder::PollStatus HwDecoder::poll(bool want_frame, std::optional<DecodedFrame>& frame) {
+    if (!is_open_) {
+        return PollStatus::Error;
+    }
+
+    // 读取一个数据包
+    int ret = read_packet();
+    if (ret < 0) {
+        if (ret == AVERROR_EOF) {
+            LOG_INFO("Stream EOF");
+        } else if (ret == AVERROR_EXIT && abort_requested()) {
+            LOG_DEBUG("Read interrupted by stop request");
+        } else {
+            char errbuf[256];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            LOG_ERROR("Error reading frame: {}", errbuf);
         }
+        return PollStatus::Error;
+    }
 
-        // 送入解码器
-        ret = avcodec_send_packet(codec_ctx_, packet_);
+    // 跳过非视频包
+    if (packet_->stream_index != video_stream_idx_) {
         av_packet_unref(packet_);
-        if (ret < 0) {
-            if (ret != AVERROR(EAGAIN)) {
-                LOG_WARN("Error sending packet to decoder, skipping");
-            }
-            continue;
-        }
+        return PollStatus::Pending;
+    }
+    last_packet_ms_ = pts_to_ms(packet_->pts != AV_NOPTS_VALUE ? packet_->pts : packet_->dts);
 
-        // 尝试获取解码后的帧
-        ret = avcodec_receive_frame(codec_ctx_, frame_);
-        if (ret == AVERROR(EAGAIN)) {
-            continue;  // 需要更多数据包
-        }
-        if (ret < 0) {
-            LOG_ERROR("Error receiving frame from decoder");
-            return std::nullopt;
-        }
+    if (packet_ring_) capture_packet(packet_);
+
+    // 按解码模式在解复用层丢弃 (码流缓存仍保留完整 GOP)
+    if (discard_packet(packet_)) {
+        av_packet_unref(packet_);
+        return PollStatus::Pending;
+    }
+    note_output(packet_);
 
-        // ========================
-        // 获取 NV12 数据
-        // ========================
-        AVFrame* src_frame = frame_;
-        bool transferred = false;
-
-        // 如果是硬件帧 (DRM_PRIME 或有 hw_frames_ctx)，需要转换到 CPU 内存
-        if (frame_->hw_frames_ctx != nullptr) {
-            ret = av_hwframe_transfer_data(sw_frame_, frame_, 0);
-            if (ret < 0) {
-                char errbuf[256];
-                av_strerror(ret, errbuf, sizeof(errbuf));
-                LOG_WARN("Failed to transfer HW frame: {}, skipping", errbuf);
-                av_frame_unref(frame_);
-                continue;
-            }
-            sw_frame_->pts = frame_->pts;
-            src_frame = sw_frame_;
-            transferred = true;
+    // Keyframe 模式: 关键帧之间互不参考, 跳过的关键帧无需解码
+    if (!want_frame && config_.decode_mode == DecodeMode::Keyframe) {
+        av_packet_unref(packet_);
+        return PollStatus::Skipped;
+    }
+
+    // 送入解码器
+    ret = avcodec_send_packet(codec_ctx_, packet_);
+    av_packet_unref(packet_);
+    if (ret < 0) {
+        if (ret != AVERROR(EAGAIN)) {
+            LOG_WARN("Error sending packet to decoder, skipping");
         }
+        return PollStatus::Pending;
+    }
+
+    // 尝试获取解码后的帧
+    ret = avcodec_receive_frame(codec_ctx_, frame_);
+    if (ret == AVERROR(EAGAIN) && want_frame && config_.decode_mode == DecodeMode::Keyframe) {
+        ret = drain_and_flush();    // 不等下一个关键帧把这一帧 "推" 出来
+    }
+    if (ret == AVERROR(EAGAIN)) {
+        return PollStatus::Pending;  // 需要更多数据包
+    }
+    if (ret < 0) {
+        if (want_frame) LOG_ERROR("Error receiving frame from decoder");
+        return PollStatus::Error;
+    }
+
+    if (!want_frame) {
+        // 跳帧: 直接丢弃帧数据（不做 HW transfer 和 NV12 extract）
+        av_frame_unref(frame_);
+        return PollStatus::Skipped;
+    }
+
+    frame = take_frame();
+    return frame ? PollStatus::Frame : PollStatus::Pending;
+}
 
-        // 验证像素格式
-        if (src_frame->format != AV_PIX_FMT_NV12) {
-            LOG_WARN("Unexpected pixel format: {} (expected NV12={}), skipping",
-                     src_frame->format, AV_PIX_FMT_NV12);
+std::optional<DecodedFrame> HwDecoder::take_frame() {
+    int ret = 0;
+    // ========================
+    // 零拷贝: 直接引用 DRM-PRIME 帧
+    // ========================
+    if (config_.zero_copy && frame_->format == AV_PIX_FMT_DRM_PRIME) {
+        auto dma = wrap_drm_frame(frame_);
+        if (dma) {
+            DecodedFrame decoded;
+            decoded.width = frame_->width;
+            decoded.height = frame_->height;
+            decoded.dma_buf = std::move(dma);
+            decoded.pts = frame_->pts != AV_NOPTS_VALUE
+                ? frame_->pts : frame_->best_effort_timestamp;
+            decoded.timestamp_ms = pts_to_ms(decoded.pts);
             av_frame_unref(frame_);
-            if (transferred) av_frame_unref(sw_frame_);
-            continue;
+            return decoded;
         }
+        // 描述符不可用, 回退到拷贝路径
+    }
 
-        // ========================
-        // 提取 NV12 数据到连续内存
-        // ========================
-        auto nv12_data = extract_nv12(src_frame);
-
-        // 构建 DecodedFrame
-        DecodedFrame decoded;
-        decoded.width = src_frame->width;
-        decoded.height = src_frame->height;
-        decoded.nv12_data = std::move(nv12_data);
-
-        // PTS 和时间戳
-        int64_t pts = frame_->pts;
-        if (pts == AV_NOPTS_VALUE) {
-            pts = frame_->best_effort_timestamp;
+    // ========================
+    // 输出缩放: RGA 读 DRM-PRIME 帧, 只传输缩放后的 NV12
+    // ========================
+    if (output_width_ > 0 && frame_->format == AV_PIX_FMT_DRM_PRIME) {
+        int64_t t_scale = mono_now_ns();
+        auto scaled = scale_drm_frame(frame_);
+        if (scaled) {
+            DecodedFrame decoded;
+            decoded.copy_ns = mono_now_ns() - t_scale;
+            decoded.width = output_width_;
+            decoded.height = output_height_;
+            decoded.source_width = frame_->width;
+            decoded.source_height = frame_->height;
+            decoded.nv12_data = std::move(scaled);
+            decoded.pts = frame_->pts != AV_NOPTS_VALUE
+                ? frame_->pts : frame_->best_effort_timestamp;
+            decoded.timestamp_ms = pts_to_ms(decoded.pts);
+            av_frame_unref(frame_);
+            return decoded;
         }
-        decoded.pts = pts;
+        // RGA 不可用, 回退到全分辨率传输
+    }
 
-        // 转换 PTS 到毫秒时间戳
-        if (pts != AV_NOPTS_VALUE && video_stream_idx_ >= 0) {
-            AVRational tb = fmt_ctx_->streams[video_stream_idx_]->time_base;
-            decoded.timestamp_ms = av_rescale_q(pts, tb, {1, 1000});
-        } else {
-            // 使用系统时钟作为后备
-            decoded.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::system_clock::now().time_since_epoch()).count();
+    // ========================
+    // 获取 NV12 数据
+    // ========================
+    AVFrame* src_frame = frame_;
+    bool transferred = false;
+    int64_t t_copy = mono_now_ns();
+
+    // 如果是硬件帧 (DRM_PRIME 或有 hw_frames_ctx)，需要转换到 CPU 内存
+    if (frame_->hw_frames_ctx != nullptr) {
+        ret = av_hwframe_transfer_data(sw_frame_, frame_, 0);
+        if (ret < 0) {
+            char errbuf[256];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            LOG_WARN("Failed to transfer HW frame: {}, skipping", errbuf);
+            av_frame_unref(frame_);
+            return std::nullopt;
         }
+        sw_frame_->pts = frame_->pts;
+        src_frame = sw_frame_;
+        transferred = true;
+    }
 
-        // 清理 AVFrame
+    // 验证像素格式
+    if (src_frame->format != AV_PIX_FMT_NV12) {
+        LOG_WARN("Unexpected pixel format: {} (expected NV12={}), skipping",
+                 src_frame->format, AV_PIX_FMT_NV12);
         av_frame_unref(frame_);
         if (transferred) av_frame_unref(sw_frame_);
+        return std::nullopt;
+    }
 
-        return decoded;
+    // ========================
+    // 提取 NV12 数据到连续内存
+    // ========================
+    auto nv12_data = extract_nv12(src_frame);
+
+    // 构建 DecodedFrame
+    DecodedFrame decoded;
+    decoded.width = src_frame->width;
+    decoded.height = src_frame->height;
+    decoded.nv12_data = std::move(nv12_data);
+    decoded.copy_ns = mono_now_ns() - t_copy;
+
+    // PTS 和时间戳
+    int64_t pts = frame_->pts;
+    if (pts == AV_NOPTS_VALUE) {
+        pts = frame_->best_effort_timestamp;
     }
+    decoded.pts = pts;
+
+    // 转换 PTS 到毫秒时间戳
+    decoded.timestamp_ms = pts_to_ms(pts);
+
+    // 清理 AVFrame
+    av_frame_unref(frame_);
+    if (transferred) av_frame_unref(sw_frame_);
+
+    return decoded;
 }
 
-bool HwDecoder::skip_frame() {
-    if (!is_open_) {
-        return false;
-    }
+bool HwDecoder::is_file_source(const std::string& url) {
+    return url.find("://") == std::string::npos || url.compare(0, 5, "file:") == 0;
+}
 
-    while (true) {
-        int ret = av_read_frame(fmt_ctx_, packet_);
+int HwDecoder::interrupt_callback(void* opaque) {
+    auto* self = static_cast<HwDecoder*>(opaque);
+    if (self->abort_requested()) return 1;
+    return self->io_deadline_ns_ > 0 && mono_now_ns() > self->io_deadline_ns_ ? 1 : 0;
+}
+
+int HwDecoder::read_packet() {
+    int64_t t_read = mono_now_ns();
+    if (!file_source_ && config_.read_timeout_sec > 0) {
+        io_deadline_ns_ = t_read + static_cast<int64_t>(config_.read_timeout_sec) * 1000000000LL;
+    }
+    int ret = av_read_frame(fmt_ctx_, packet_);
+    last_read_ns_ = mono_now_ns() - t_read;
+    io_deadline_ns_ = 0;
+    if (!file_source_) return ret;
+
+    if (ret == AVERROR_EOF) {
+        // 回到开头循环, 之后的包时间戳接在上一轮末尾
+        AVStream* stream = fmt_ctx_->streams[video_stream_idx_];
+        int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+        ret = av_seek_frame(fmt_ctx_, video_stream_idx_, start, AVSEEK_FLAG_BACKWARD);
         if (ret < 0) {
-            return false;
+            LOG_ERROR("Failed to rewind local file: {}", config_.rtsp_url);
+            return ret;
         }
+        loop_offset_ = loop_end_pts_ - start;
+        ret = av_read_frame(fmt_ctx_, packet_);
+    }
+    if (ret < 0 || packet_->stream_index != video_stream_idx_) return ret;
 
-        if (packet_->stream_index != video_stream_idx_) {
-            av_packet_unref(packet_);
-            continue;
-        }
+    if (packet_->pts != AV_NOPTS_VALUE) packet_->pts += loop_offset_;
+    if (packet_->dts != AV_NOPTS_VALUE) packet_->dts += loop_offset_;
+    int64_t ts = packet_->pts != AV_NOPTS_VALUE ? packet_->pts : packet_->dts;
+    if (ts != AV_NOPTS_VALUE) {
+        loop_end_pts_ = std::max(loop_end_pts_, ts + std::max<int64_t>(packet_->duration, 1));
+    }
 
-        ret = avcodec_send_packet(codec_ctx_, packet_);
-        av_packet_unref(packet_);
-        if (ret < 0) {
-            if (ret != AVERROR(EAGAIN)) {
-                LOG_WARN("Error sending packet to decoder, skipping");
-            }
-            continue;
+    // 限速: 落后超过一个间隔时不追赶 (下游阻塞后不突发)
+    if (packet_interval_ns_ > 0) {
+        int64_t now = mono_now_ns();
+        if (next_packet_ns_ == 0 || now - next_packet_ns_ > packet_interval_ns_) {
+            next_packet_ns_ = now;
+        } else if (next_packet_ns_ > now) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(next_packet_ns_ - now));
         }
+        next_packet_ns_ += packet_interval_ns_;
+    }
+    return ret;
+}
 
-        ret = avcodec_receive_frame(codec_ctx_, frame_);
-        if (ret == AVERROR(EAGAIN)) {
-            continue;
-        }
-        if (ret < 0) {
-            return false;
-        }
+bool HwDecoder::discard_packet(const AVPacket* packet) {
+    bool discard = false;
+    if (config_.decode_mode == DecodeMode::Keyframe) {
+        discard = (packet->flags & AV_PKT_FLAG_KEY) == 0;
+    } else if (nonref_filter_ && packet->data && packet->size > 0) {
+        discard = nonref_filter_->droppable(packet->data, static_cast<size_t>(packet->size));
+    }
+    if (discard) discarded_packets_++;
+    return discard;
+}
 
-        // 成功解码，直接丢弃帧数据（不做 HW transfer 和 NV12 extract）
-        av_frame_unref(frame_);
-        return true;
+void HwDecoder::note_output(const AVPacket* packet) {
+    if (config_.decode_mode == DecodeMode::All) return;
+
+    int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+    int64_t now_ms = pts_to_ms(pts);
+    if (last_output_ms_ >= 0 && now_ms > last_output_ms_) {
+        double interval = static_cast<double>(now_ms - last_output_ms_);
+        output_interval_ms_ = output_interval_ms_ > 0.0
+            ? output_interval_ms_ * 0.8 + interval * 0.2 : interval;
+    }
+    last_output_ms_ = now_ms;
+}
+
+double HwDecoder::get_output_fps() const {
+    if (config_.decode_mode == DecodeMode::All) return fps_;
+    return output_interval_ms_ > 0.0 ? 1000.0 / output_interval_ms_ : 0.0;
+}
+
+int HwDecoder::drain_and_flush() {
+    int ret = avcodec_send_packet(codec_ctx_, nullptr);
+    if (ret < 0 && ret != AVERROR_EOF) {
+        avcodec_flush_buffers(codec_ctx_);
+        return AVERROR(EAGAIN);
+    }
+    ret = avcodec_receive_frame(codec_ctx_, frame_);
+    // 复位后解码器重新接受数据包, 取出的帧 (若有) 不受影响
+    avcodec_flush_buffers(codec_ctx_);
+    return ret == AVERROR_EOF ? AVERROR(EAGAIN) : ret;
+}
+
+void HwDecoder::capture_packet(const AVPacket* packet) {
+    if (!packet->data || packet->size <= 0) return;
+
+    ClipPacket cp;
+    cp.data = std::make_shared<std::vector<uint8_t>>(packet->data, packet->data + packet->size);
+    cp.dts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    cp.pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : cp.dts;
+    cp.duration = packet->duration;
+    cp.keyframe = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+    cp.timestamp_ms = pts_to_ms(cp.pts);
+    if (cp.dts == AV_NOPTS_VALUE) {
+        // 无时间戳的流: 由毫秒时间戳反推, 保证 remux 后时间轴单调
+        AVRational tb = fmt_ctx_->streams[video_stream_idx_]->time_base;
+        cp.pts = cp.dts = av_rescale_q(cp.timestamp_ms, {1, 1000}, tb);
+    }
+    packet_ring_->push(std::move(cp));
+}
+
+int64_t HwDecoder::pts_to_ms(int64_t pts) const {
+    if (pts != AV_NOPTS_VALUE && video_stream_idx_ >= 0) {
+        AVRational tb = fmt_ctx_->streams[video_stream_idx_]->time_base;
+        return av_rescale_q(pts, tb, {1, 1000});
     }
+    // 使用系统时钟作为后备
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
 std::shared_ptr<std::vector<uint8_t>> HwDecoder::extract_nv12(AVFrame* frame) {
@@ -338,7 +585,7 @@ std::shared_ptr<std::vector<uint8_t>> HwDecoder::extract_nv12(AVFrame* frame) {
     int y_size = w * h;
     int uv_size = w * (h / 2);
 
-    auto buffer = std::make_shared<std::vector<uint8_t>>(y_size + uv_size);
+    auto buffer = BufferPool::global().acquire(static_cast<size_t>(y_size + uv_size));
 
     // 拷贝 Y 平面 (处理 stride/linesize)
     if (frame->linesize[0] == w) {
@@ -367,6 +614,70 @@ std::shared_ptr<std::vector<uint8_t>> HwDecoder::extract_nv12(AVFrame* frame) {
     return buffer;
 }
 
+void HwDecoder::set_output_size(int width, int height) {
+    if (width <= 0 || height <= 0 || (width >= width_ && height >= height_)) {
+        output_width_ = output_height_ = 0;
+        return;
+    }
+    output_width_ = (width + 1) & ~1;
+    output_height_ = (height + 1) & ~1;
+}
+
+std::shared_ptr<std::vector<uint8_t>> HwDecoder::scale_drm_frame(AVFrame* frame) {
+#ifdef HAS_RGA
+    auto dma = wrap_drm_frame(frame);
+    if (!dma) return nullptr;
+
+    RgaFrameBatch batch(*dma);
+    if (!batch.valid()) return nullptr;
+    auto nv12 = batch.add_nv12(output_width_, output_height_);
+    if (!nv12 || !batch.submit()) {
+        LOG_DEBUG("RGA scale {}x{} -> {}x{} failed", frame->width, frame->height,
+                  output_width_, output_height_);
+        return nullptr;
+    }
+    return nv12;
+#else
+    (void)frame;
+    return nullptr;
+#endif
+}
+
+std::shared_ptr<DmaBuffer> HwDecoder::wrap_drm_frame(AVFrame* frame) {
+    const auto* desc = reinterpret_cast<const AVDRMFrameDescriptor*>(frame->data[0]);
+    if (!desc || desc->nb_objects < 1 || desc->nb_layers < 1) {
+        return nullptr;
+    }
+
+    // rkmpp 输出的 NV12 为单个 object, Y/UV 两个 plane
+    const AVDRMLayerDescriptor& layer = desc->layers[0];
+    if (layer.nb_planes < 1 || layer.planes[0].pitch <= 0) {
+        return nullptr;
+    }
+
+    int pitch = static_cast<int>(layer.planes[0].pitch);
+    int hstride = frame->height;
+    if (layer.nb_planes > 1 && layer.planes[1].object_index == layer.planes[0].object_index) {
+        hstride = static_cast<int>(layer.planes[1].offset / layer.planes[0].pitch);
+    }
+
+    // 克隆引用 (不拷贝数据), 最后一个 DmaBuffer 释放时归还 MPP 缓冲池
+    AVFrame* ref = av_frame_clone(frame);
+    if (!ref) {
+        return nullptr;
+    }
+
+    auto dma = std::make_shared<DmaBuffer>();
+    dma->fd = desc->objects[0].fd;
+    dma->size = desc->objects[0].size;
+    dma->width = frame->width;
+    dma->height = frame->height;
+    dma->wstride = pitch;
+    dma->hstride = hstride;
+    dma->holder = std::shared_ptr<AVFrame>(ref, [](AVFrame* f) { av_frame_free(&f); });
+    return dma;
+}
+
 void HwDecoder::close() {
     if (packet_) {
         av_packet_free(&packet_);
@@ -390,6 +701,8 @@ void HwDecoder::close() {
     }
 
     video_stream_idx_ = -1;
+    output_width_ = 0;
+    output_height_ = 0;
     width_ = 0;
     height_ = 0;
     fps_ = 0.0;
@@ -0,0 +1,97 @@
+/**
+ * @file nal_parser.cpp
+ * @brief H.264 / H.265 NAL 单元解析实现
+ */
+
+#include "infer_server/decoder/nal_parser.h"
+
+#include <algorithm>
+
+namespace infer_server {
+
+namespace {
+
+/// 从 pos 开始查找下一个 00 00 01, 返回其位置 (找不到返回 size)
+size_t find_start_code(const uint8_t* data, size_t size, size_t pos) {
+    while (pos + 3 <= size) {
+        if (data[pos + 2] > 1) {
+            pos += 3;
+        } else if (data[pos] == 0 && data[pos + 1] == 0 && data[pos + 2] == 1) {
+            return pos;
+        } else {
+            pos++;
+        }
+    }
+    return size;
+}
+
+bool is_annexb(const uint8_t* data, size_t size) {
+    if (size >= 3 && data[0] == 0 && data[1] == 0 && data[2] == 1) return true;
+    return size >= 4 && data[0] == 0 && data[1] == 0 && data[2] == 0 && data[3] == 1;
+}
+
+} // namespace
+
+size_t split_nal_units(const uint8_t* data, size_t size, std::vector<NalUnit>& out) {
+    out.clear();
+    if (!data || size == 0) return 0;
+
+    if (is_annexb(data, size)) {
+        size_t sc = find_start_code(data, size, 0);
+        while (sc < size) {
+            size_t begin = sc + 3;
+            size_t next = find_start_code(data, size, begin);
+            // 去掉下一个 4 字节起始码的前导 0 (以及 trailing_zero_8bits)
+            size_t end = next;
+            while (end > begin && data[end - 1] == 0) end--;
+            if (end > begin) out.push_back({data + begin, end - begin});
+            sc = next;
+        }
+        return out.size();
+    }
+
+    size_t pos = 0;
+    while (pos + 4 <= size) {
+        size_t len = (static_cast<size_t>(data[pos]) << 24) | (static_cast<size_t>(data[pos + 1]) << 16) |
+                     (static_cast<size_t>(data[pos + 2]) << 8) | data[pos + 3];
+        pos += 4;
+        if (len == 0 || len > size - pos) break;
+        out.push_back({data + pos, len});
+        pos += len;
+    }
+    return out.size();
+}
+
+bool NonRefPacketFilter::droppable(const uint8_t* data, size_t size) {
+    split_nal_units(data, size, nals_);
+
+    bool has_vcl = false;
+    if (codec_ == NalCodec::H264) {
+        for (const auto& nal : nals_) {
+            int type = nal.data[0] & 0x1F;
+            if (type < 1 || type > 5) continue;    // 非 VCL (SPS / PPS / SEI / AUD ...)
+            has_vcl = true;
+            if ((nal.data[0] >> 5) & 0x03) return false;   // nal_ref_idc != 0
+        }
+        return has_vcl;
+    }
+
+    // H.265: 2 字节 NAL 头, type = bits[1..6], TemporalId = nuh_temporal_id_plus1 - 1
+    bool all_nonref = true;
+    int tid = 0;
+    for (const auto& nal : nals_) {
+        if (nal.size < 2) continue;
+        int type = (nal.data[0] >> 1) & 0x3F;
+        if (type > 31) continue;                    // 非 VCL
+        has_vcl = true;
+        tid = std::max(tid, (nal.data[1] & 0x07) - 1);
+        // sub-layer non-reference: 0..14 中的偶数 (TRAIL_N, TSA_N, STSA_N, RADL_N, RASL_N, RSV_VCL_N*)
+        if (type > 14 || (type & 1)) all_nonref = false;
+    }
+    if (!has_vcl) return false;
+
+    max_temporal_id_ = std::max(max_temporal_id_, tid);
+    return all_nonref && tid >= max_temporal_id_;
+}
+
+} // namespace infer_server
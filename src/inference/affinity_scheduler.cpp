@@ -0,0 +1,171 @@
+/**
+ * @file affinity_scheduler.cpp
+ * @brief 模型亲和 + 工作窃取调度器实现
+ */
+
+#include "infer_server/inference/affinity_scheduler.h"
+
+#include <algorithm>
+
+namespace infer_server {
+
+AffinityScheduler::AffinityScheduler(size_t num_workers, size_t queue_capacity,
+                                     size_t steal_backlog, QueueMode queue_mode,
+                                     InferTaskQueue::Policy policy)
+    : steal_backlog_(steal_backlog)
+{
+    if (num_workers == 0) num_workers = 1;
+    if (queue_capacity == 0) queue_capacity = 1;
+
+    queues_.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; i++) {
+        queues_.push_back(std::make_unique<InferTaskQueue>(queue_capacity, queue_mode, policy));
+    }
+    models_per_worker_.assign(num_workers, 0);
+}
+
+int AffinityScheduler::assign_model(const std::string& model_path) {
+    std::lock_guard<std::mutex> lock(assign_mutex_);
+
+    auto it = model_home_.find(model_path);
+    if (it != model_home_.end()) return it->second;
+
+    // 选择已分配模型最少的 worker (相同时取 ID 最小)
+    auto min_it = std::min_element(models_per_worker_.begin(), models_per_worker_.end());
+    int home = static_cast<int>(std::distance(models_per_worker_.begin(), min_it));
+    models_per_worker_[home]++;
+    model_home_[model_path] = home;
+    return home;
+}
+
+int AffinityScheduler::home_worker(const std::string& model_path) const {
+    std::lock_guard<std::mutex> lock(assign_mutex_);
+    auto it = model_home_.find(model_path);
+    return it != model_home_.end() ? it->second : -1;
+}
+
+void AffinityScheduler::release_model(const std::string& model_path) {
+    std::lock_guard<std::mutex> lock(assign_mutex_);
+    auto it = model_home_.find(model_path);
+    if (it == model_home_.end()) return;
+    models_per_worker_[it->second]--;
+    model_home_.erase(it);
+}
+
+bool AffinityScheduler::submit(InferTask task) {
+    int home = assign_model(task.model_path());
+    if (!queues_[home]->push(std::move(task))) return false;
+    notify_idle();
+    return true;
+}
+
+void AffinityScheduler::notify_idle() {
+    // 与 pop 中 idle_waiters_ 递增配对: 要么这里看到等待者, 要么等待者看到刚推入的任务
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (idle_waiters_.load(std::memory_order_relaxed) == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        submit_seq_++;
+    }
+    idle_cv_.notify_all();
+}
+
+std::optional<InferTask> AffinityScheduler::pop(int worker_id, std::chrono::milliseconds timeout,
+                                                const CanStealFn& can_steal) {
+    auto& own = *queues_[worker_id];
+
+    if (queues_.size() == 1) {
+        return own.pop(timeout);
+    }
+
+    // 空闲时在调度器条件变量上等待 submit 通知 (新任务可能进入自己的队列, 也可能可窃取),
+    // 不轮询其他队列
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_waiters_.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::optional<InferTask> task;
+    while (!stopped_.load(std::memory_order_relaxed)) {
+        // 先记录序号再检查队列: 检查期间的 submit 会改变序号, 不会错过
+        uint64_t seen = submit_seq_;
+        lock.unlock();
+        task = own.try_pop();
+        if (!task) task = try_steal(worker_id, can_steal);
+        lock.lock();
+        if (task) break;
+
+        if (!idle_cv_.wait_until(lock, deadline, [&] {
+                return submit_seq_ != seen || stopped_.load(std::memory_order_relaxed);
+            })) {
+            break;
+        }
+    }
+    idle_waiters_.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+}
+
+std::optional<InferTask> AffinityScheduler::try_steal(int worker_id, const CanStealFn& can_steal) {
+    size_t n = queues_.size();
+    auto now = std::chrono::steady_clock::now();
+
+    for (size_t i = 1; i < n; i++) {
+        auto& victim = *queues_[(worker_id + i) % n];
+        if (victim.empty()) continue;
+
+        bool backlogged = steal_backlog_ > 0 && victim.size() >= steal_backlog_;
+        auto task = victim.pop_if([&](const InferTask& t) {
+            return backlogged || (can_steal && can_steal(t.model_path()));
+        }, now);
+
+        if (task) {
+            steal_count_.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    return std::nullopt;
+}
+
+void AffinityScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        stopped_ = true;
+    }
+    idle_cv_.notify_all();
+    for (auto& q : queues_) q->stop();
+}
+
+void AffinityScheduler::clear() {
+    for (auto& q : queues_) q->clear();
+}
+
+size_t AffinityScheduler::size() const {
+    size_t total = 0;
+    for (const auto& q : queues_) total += q->size();
+    return total;
+}
+
+size_t AffinityScheduler::capacity() const {
+    size_t total = 0;
+    for (const auto& q : queues_) total += q->capacity();
+    return total;
+}
+
+size_t AffinityScheduler::dropped_count() const {
+    size_t total = 0;
+    for (const auto& q : queues_) total += q->dropped_count();
+    return total;
+}
+
+size_t AffinityScheduler::expired_count() const {
+    size_t total = 0;
+    for (const auto& q : queues_) total += q->expired_count();
+    return total;
+}
+
+RateMeter::Rates AffinityScheduler::drop_rate() const {
+    RateMeter::Rates total;
+    for (const auto& q : queues_) total += q->drop_rate();
+    return total;
+}
+
+} // namespace infer_server
@@ -0,0 +1,353 @@
+/**
+ * @file infer_task_queue.cpp
+ * @brief 推理任务队列实现
+ */
+
+#include "infer_server/inference/infer_task_queue.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace infer_server {
+
+InferTaskQueue::InferTaskQueue(size_t capacity, QueueMode mode, Policy policy)
+    : capacity_(capacity > 0 ? capacity : 1)
+    , policy_(policy)
+    , fifo_(policy == Policy::FIFO ? capacity_ : 1,
+            policy == Policy::FIFO ? mode : QueueMode::MUTEX)
+{
+}
+
+int InferTaskQueue::quantum(TaskPriority priority) {
+    switch (priority) {
+        case TaskPriority::Critical:   return 4;
+        case TaskPriority::BestEffort: return 1;
+        default:                       return 2;
+    }
+}
+
+bool InferTaskQueue::parse_policy(const std::string& name, Policy& out) {
+    if (name == "fifo") { out = Policy::FIFO; return true; }
+    if (name == "fair") { out = Policy::FAIR; return true; }
+    return false;
+}
+
+// ============================================================
+// 统计
+// ============================================================
+
+bool InferTaskQueue::is_expired(const InferTask& task, Clock::time_point now) {
+    int deadline_ms = task.binding ? task.binding->deadline_ms : 0;
+    return deadline_ms > 0 && now - task.enqueue_time > std::chrono::milliseconds(deadline_ms);
+}
+
+void InferTaskQueue::count_dropped(const InferTask& task) {
+    drop_rate_.mark();
+    if (task.binding && task.binding->counters) {
+        task.binding->counters->infer_dropped.fetch_add(1, std::memory_order_relaxed);
+        task.binding->counters->drop_rate.mark();
+    }
+}
+
+void InferTaskQueue::count_expired(const InferTask& task) {
+    drop_rate_.mark();
+    expired_.fetch_add(1, std::memory_order_relaxed);
+    if (task.binding && task.binding->counters) {
+        task.binding->counters->infer_expired.fetch_add(1, std::memory_order_relaxed);
+        task.binding->counters->drop_rate.mark();
+    }
+}
+
+size_t InferTaskQueue::dropped_count() const {
+    return policy_ == Policy::FIFO ? fifo_.dropped_count() : dropped_.load(std::memory_order_relaxed);
+}
+
+size_t InferTaskQueue::size() const {
+    if (policy_ == Policy::FIFO) return fifo_.size();
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fair_size_;
+}
+
+size_t InferTaskQueue::flow_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return flows_.size();
+}
+
+// ============================================================
+// push
+// ============================================================
+
+bool InferTaskQueue::push(InferTask task) {
+    task.enqueue_time = Clock::now();
+
+    if (policy_ == Policy::FIFO) {
+        std::optional<InferTask> evicted;
+        if (!fifo_.push(std::move(task), evicted)) return false;
+        if (evicted) count_dropped(*evicted);
+        return true;
+    }
+
+    std::vector<InferTask> garbage;     // 在锁外释放 (可能持有 DMA-BUF / 聚合器)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_.load(std::memory_order_relaxed)) return false;
+
+        if (fair_size_ >= capacity_) {
+            bool drop_incoming = false;
+            evict_locked(task, drop_incoming, garbage);
+            if (drop_incoming) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                count_dropped(task);
+                return true;
+            }
+        }
+
+        const std::string& key = task.binding ? task.binding->cam_id : std::string();
+        auto [it, inserted] = flows_.try_emplace(key);
+        Flow& flow = it->second;
+        if (inserted) {
+            flow.key = key;
+            round_.push_back(&flow);
+        }
+        if (task.binding) flow.priority = task.binding->priority;
+        flow.tasks.push_back(std::move(task));
+        fair_size_++;
+    }
+    not_empty_cv_.notify_one();
+    return true;
+}
+
+void InferTaskQueue::evict_locked(InferTask& incoming, bool& drop_incoming,
+                                  std::vector<InferTask>& garbage)
+{
+    auto now = Clock::now();
+
+    // 先清理已超时的任务, 可能无需挤出
+    for (size_t i = 0; i < round_.size();) {
+        purge_expired_locked(*round_[i], now, garbage);
+        if (round_[i]->tasks.empty()) {
+            erase_flow_locked(i);
+        } else {
+            i++;
+        }
+    }
+    if (fair_size_ < capacity_) return;
+
+    // 挤出顺序: 优先级最低 -> 积压最多 (新任务计入其所属流)
+    const std::string& in_key = incoming.binding ? incoming.binding->cam_id : std::string();
+    TaskPriority in_prio = incoming.binding ? incoming.binding->priority : TaskPriority::Normal;
+
+    Flow* in_flow = nullptr;
+    Flow* victim = nullptr;
+    for (Flow* f : round_) {
+        if (f->key == in_key) {
+            in_flow = f;
+            continue;
+        }
+        if (!victim ||
+            std::make_tuple(static_cast<int>(f->priority), f->tasks.size()) >
+            std::make_tuple(static_cast<int>(victim->priority), victim->tasks.size())) {
+            victim = f;
+        }
+    }
+
+    size_t in_backlog = (in_flow ? in_flow->tasks.size() : 0) + 1;
+    bool evict_own = !victim ||
+        std::make_tuple(static_cast<int>(in_prio), in_backlog) >=
+        std::make_tuple(static_cast<int>(victim->priority), victim->tasks.size());
+
+    if (evict_own) {
+        if (!in_flow) {
+            // 新任务比所有排队任务都不重要, 且该流没有旧任务可挤出
+            drop_incoming = true;
+            return;
+        }
+        victim = in_flow;
+    }
+
+    InferTask old = std::move(victim->tasks.front());
+    victim->tasks.pop_front();
+    fair_size_--;
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    count_dropped(old);
+    garbage.push_back(std::move(old));
+
+    if (victim->tasks.empty()) {
+        auto it = std::find(round_.begin(), round_.end(), victim);
+        erase_flow_locked(static_cast<size_t>(std::distance(round_.begin(), it)));
+    }
+}
+
+// ============================================================
+// pop
+// ============================================================
+
+std::optional<InferTask> InferTaskQueue::pop(std::chrono::milliseconds timeout) {
+    auto deadline = Clock::now() + timeout;
+    return policy_ == Policy::FIFO ? fifo_pop(nullptr, deadline) : fair_pop(nullptr, deadline);
+}
+
+std::optional<InferTask> InferTaskQueue::try_pop() {
+    if (policy_ == Policy::FIFO) {
+        auto now = Clock::now();
+        while (auto task = fifo_.try_pop()) {
+            if (!is_expired(*task, now)) return task;
+            count_expired(*task);
+        }
+        return std::nullopt;
+    }
+
+    std::vector<InferTask> garbage;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fair_take_locked(nullptr, garbage);
+}
+
+std::optional<InferTask> InferTaskQueue::pop_if(const Pred& pred, Clock::time_point deadline) {
+    return policy_ == Policy::FIFO ? fifo_pop(&pred, deadline) : fair_pop(&pred, deadline);
+}
+
+std::optional<InferTask> InferTaskQueue::fifo_pop(const Pred* pred, Clock::time_point deadline) {
+    while (true) {
+        std::optional<InferTask> task;
+        if (pred) {
+            task = fifo_.pop_if(*pred, deadline);
+        } else {
+            auto now = Clock::now();
+            auto wait = deadline > now
+                ? std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now)
+                : std::chrono::milliseconds(0);
+            task = fifo_.pop(wait);
+        }
+        if (!task) return std::nullopt;
+        if (!is_expired(*task, Clock::now())) return task;
+        count_expired(*task);
+    }
+}
+
+std::optional<InferTask> InferTaskQueue::fair_pop(const Pred* pred, Clock::time_point deadline) {
+    std::vector<InferTask> garbage;     // 析构于锁释放之后
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (auto task = fair_take_locked(pred, garbage)) return task;
+        if (stopped_.load(std::memory_order_relaxed)) return std::nullopt;
+
+        // 队列中有不匹配的任务: 把唤醒信号传给其他等待者, 避免新任务无人消费
+        if (pred && fair_size_ > 0) {
+            not_empty_cv_.notify_one();
+        }
+        if (not_empty_cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+            return fair_take_locked(pred, garbage);
+        }
+    }
+}
+
+void InferTaskQueue::purge_expired_locked(Flow& flow, Clock::time_point now,
+                                          std::vector<InferTask>& garbage)
+{
+    // 同一路流的 deadline 相同, 超时任务总在队首
+    while (!flow.tasks.empty() && is_expired(flow.tasks.front(), now)) {
+        count_expired(flow.tasks.front());
+        garbage.push_back(std::move(flow.tasks.front()));
+        flow.tasks.pop_front();
+        fair_size_--;
+    }
+}
+
+void InferTaskQueue::erase_flow_locked(size_t round_index) {
+    Flow* flow = round_[round_index];
+    round_.erase(round_.begin() + static_cast<std::ptrdiff_t>(round_index));
+    auto it = flows_.find(flow->key);
+    if (it != flows_.end()) flows_.erase(it);
+}
+
+std::optional<InferTask> InferTaskQueue::fair_take_locked(const Pred* pred,
+                                                          std::vector<InferTask>& garbage)
+{
+    auto now = Clock::now();
+
+    if (!pred) {
+        // DRR: 队首流用完本轮 quantum 后移到队尾
+        while (!round_.empty()) {
+            Flow* flow = round_.front();
+            purge_expired_locked(*flow, now, garbage);
+            if (flow->tasks.empty()) {
+                erase_flow_locked(0);
+                continue;
+            }
+
+            while (flow->deficit < 1) flow->deficit += quantum(flow->priority);
+
+            InferTask task = std::move(flow->tasks.front());
+            flow->tasks.pop_front();
+            fair_size_--;
+            flow->deficit--;
+
+            if (flow->tasks.empty()) {
+                erase_flow_locked(0);
+            } else if (flow->deficit < 1) {
+                round_.pop_front();
+                round_.push_back(flow);
+            }
+            return task;
+        }
+        return std::nullopt;
+    }
+
+    // 按条件取 (凑批 / 窃取): 按轮转顺序找第一个匹配的任务, 计入该流的 deficit
+    for (size_t i = 0; i < round_.size();) {
+        Flow* flow = round_[i];
+        purge_expired_locked(*flow, now, garbage);
+        auto it = std::find_if(flow->tasks.begin(), flow->tasks.end(), *pred);
+        if (it == flow->tasks.end()) {
+            if (flow->tasks.empty()) {
+                erase_flow_locked(i);
+            } else {
+                i++;
+            }
+            continue;
+        }
+
+        InferTask task = std::move(*it);
+        flow->tasks.erase(it);
+        fair_size_--;
+        flow->deficit--;    // 可为负, 下一轮补足后才会再被调度
+        if (flow->tasks.empty()) erase_flow_locked(i);
+        return task;
+    }
+    return std::nullopt;
+}
+
+// ============================================================
+// 生命周期
+// ============================================================
+
+void InferTaskQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    fifo_.stop();
+    not_empty_cv_.notify_all();
+}
+
+void InferTaskQueue::clear() {
+    fifo_.clear();
+    std::unordered_map<std::string, Flow> flows;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flows.swap(flows_);
+        round_.clear();
+        fair_size_ = 0;
+    }
+}
+
+void InferTaskQueue::reset() {
+    clear();
+    fifo_.reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = false;
+    dropped_ = 0;
+    expired_ = 0;
+}
+
+} // namespace infer_server
@@ -7,6 +7,9 @@
 
 #include "infer_server/inference/infer_worker.h"
 #include "infer_server/common/logger.h"
+#include "infer_server/common/buffer_pool.h"
+#include "infer_server/common/thread_policy.h"
+#include <algorithm>
 #include <fstream>
 #include <cstring>
 #include <chrono>
@@ -19,13 +22,23 @@ namespace infer_server {
 
 InferWorker::InferWorker(int worker_id, int core_mask,
                          ModelManager& model_mgr,
-                         BoundedQueue<InferTask>& task_queue,
-                         OnCompleteCallback on_complete)
+                         InferTaskQueue& task_queue,
+                         OnCompleteCallback on_complete,
+                         bool zero_copy,
+                         AffinityScheduler* scheduler,
+                         bool int8_postprocess,
+                         int pipeline_depth,
+                         bool io_binding)
     : worker_id_(worker_id)
     , core_mask_(core_mask)
     , model_mgr_(model_mgr)
     , task_queue_(task_queue)
     , on_complete_(std::move(on_complete))
+    , zero_copy_(zero_copy)
+    , scheduler_(scheduler)
+    , int8_postprocess_(int8_postprocess)
+    , pipeline_depth_(std::max(pipeline_depth, 1))
+    , io_binding_(io_binding)
 {
 }
 
@@ -42,9 +55,21 @@ void InferWorker::start() {
 
     stop_requested_ = false;
     running_ = true;
+    npu_busy_ns_ = 0;
+    started_at_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+
+    if (pipeline_depth_ > 1) {
+        {
+            std::lock_guard<std::mutex> lock(post_mutex_);
+            post_stop_ = false;
+        }
+        post_thread_ = std::thread(&InferWorker::post_loop, this);
+    }
     thread_ = std::thread(&InferWorker::run, this);
 
-    LOG_INFO("InferWorker[{}] started (core_mask={})", worker_id_, core_mask_);
+    LOG_INFO("InferWorker[{}] started (core_mask={}, pipeline_depth={})",
+             worker_id_, core_mask_, pipeline_depth_);
 }
 
 void InferWorker::stop() {
@@ -54,10 +79,36 @@ void InferWorker::stop() {
     if (thread_.joinable()) {
         thread_.join();
     }
+
+    // NPU 线程已退出, 后处理线程处理完队列中的 job 后退出
+    if (post_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(post_mutex_);
+            post_stop_ = true;
+        }
+        post_cv_.notify_all();
+        post_thread_.join();
+    }
     running_ = false;
 
     release_all_contexts();
-    LOG_INFO("InferWorker[{}] stopped (processed {} tasks)", worker_id_, processed_count_.load());
+    LOG_INFO("InferWorker[{}] stopped (processed {} tasks, npu util {:.1f}%)",
+             worker_id_, processed_count_.load(), npu_utilization() * 100.0);
+}
+
+double InferWorker::npu_utilization() const {
+    int64_t started = started_at_ns_.load(std::memory_order_relaxed);
+    if (started == 0) return 0.0;
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+    if (now <= started) return 0.0;
+    double busy = static_cast<double>(npu_busy_ns_.load(std::memory_order_relaxed));
+    return std::min(1.0, busy / static_cast<double>(now - started));
+}
+
+void InferWorker::add_npu_busy(Clock::time_point t_start, Clock::time_point t_end) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t_end - t_start).count();
+    if (ns > 0) npu_busy_ns_.fetch_add(static_cast<uint64_t>(ns), std::memory_order_relaxed);
 }
 
 // ============================================================
@@ -65,15 +116,55 @@ void InferWorker::stop() {
 // ============================================================
 
 void InferWorker::run() {
+    ThreadPolicy::instance().apply(ThreadRole::Infer, "infer-" + std::to_string(worker_id_), worker_id_);
     LOG_DEBUG("InferWorker[{}] thread started", worker_id_);
 
     while (!stop_requested_.load(std::memory_order_relaxed)) {
+        if (release_pending_.load(std::memory_order_acquire)) {
+            process_releases();
+        }
+
         // 阻塞等待任务, 500ms 超时后检查 stop 信号
-        auto task_opt = task_queue_.pop(std::chrono::milliseconds(500));
+        // affinity 模式: 自己的队列为空时窃取本 worker 已有 context 的模型任务
+        auto task_opt = scheduler_
+            ? scheduler_->pop(worker_id_, std::chrono::milliseconds(500),
+                              [this](const std::string& model_path) {
+                                  return has_context(model_path);
+                              })
+            : task_queue_.pop(std::chrono::milliseconds(500));
         if (!task_opt) continue;
 
-        process_task(*task_opt);
-        processed_count_.fetch_add(1, std::memory_order_relaxed);
+        int capacity = batch_capacity(*task_opt);
+        if (capacity <= 1) {
+            process_task(*task_opt);
+            processed_count_.fetch_add(1, std::memory_order_relaxed);
+            processed_rate_.mark();
+            continue;
+        }
+
+        // 动态批处理: 在等待窗口内收集同一模型的任务
+        std::vector<InferTask> batch;
+        batch.reserve(static_cast<size_t>(capacity));
+        batch.push_back(std::move(*task_opt));
+
+        const std::string model_path = batch.front().model_path();
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(std::max(0, batch.front().binding->batch_wait_ms));
+        while (static_cast<int>(batch.size()) < capacity) {
+            auto next = task_queue_.pop_if(
+                [&model_path](const InferTask& t) { return t.model_path() == model_path; },
+                deadline);
+            if (!next) break;
+            batch.push_back(std::move(*next));
+        }
+
+        size_t batch_size = batch.size();   // process_batch 会移走任务
+        process_batch(batch);
+        processed_count_.fetch_add(batch_size, std::memory_order_relaxed);
+        processed_rate_.mark(batch_size);
+        batch_count_.fetch_add(1, std::memory_order_relaxed);
+        batched_tasks_.fetch_add(batch_size, std::memory_order_relaxed);
+        batch_slots_.fetch_add(static_cast<uint64_t>(capacity), std::memory_order_relaxed);
     }
 
     LOG_DEBUG("InferWorker[{}] thread exiting", worker_id_);
@@ -83,125 +174,252 @@ void InferWorker::run() {
 // 处理单个任务
 // ============================================================
 
-void InferWorker::process_task(InferTask& task) {
-    auto t_start = std::chrono::steady_clock::now();
+namespace {
 
-    // 1. 获取 rknn_context
-    rknn_context ctx = get_or_create_context(task.model_path);
-    if (ctx == 0) {
-        LOG_ERROR("InferWorker[{}]: cannot get context for model: {}",
-                  worker_id_, task.model_path);
-        return;
-    }
+/// 输出 tensor 的字节数 (INT8 取原始量化数据, 否则由 RKNN 转为 float)
+size_t output_bytes(const rknn_tensor_attr& attr, bool int8) {
+    return int8 ? std::max<size_t>(attr.size, attr.n_elems)
+                : static_cast<size_t>(attr.n_elems) * sizeof(float);
+}
 
-    // 2. 获取模型信息
-    const ModelInfo* model_info = model_mgr_.get_model_info(task.model_path);
-    if (!model_info) {
-        LOG_ERROR("InferWorker[{}]: model info not found: {}", worker_id_, task.model_path);
-        return;
+/// NHWC UINT8 输入 tensor 的单样本布局 (dims = [N, H, W, C])
+struct InputLayout {
+    size_t row_bytes = 0;       ///< 有效行字节数 (W * C)
+    size_t stride_bytes = 0;    ///< 行步长字节数 (w_stride * C)
+    size_t rows = 0;            ///< H
+
+    size_t packed_bytes() const { return row_bytes * rows; }
+    size_t sample_bytes() const { return stride_bytes * rows; }
+};
+
+InputLayout input_layout(const rknn_tensor_attr& attr) {
+    InputLayout layout;
+    if (attr.n_dims < 4) {
+        layout.row_bytes = layout.stride_bytes = attr.n_elems;
+        layout.rows = 1;
+        return layout;
     }
+    size_t w = attr.dims[2];
+    size_t c = attr.dims[3];
+    size_t w_stride = attr.w_stride > w ? attr.w_stride : w;
+    layout.row_bytes = w * c;
+    layout.stride_bytes = w_stride * c;
+    layout.rows = attr.dims[1];
+    return layout;
+}
 
-    // 3. 设置输入
-    rknn_input inputs[1];
-    std::memset(inputs, 0, sizeof(inputs));
-    inputs[0].index = 0;
-    inputs[0].type = RKNN_TENSOR_UINT8;
-    inputs[0].fmt = RKNN_TENSOR_NHWC;
-    inputs[0].size = task.input_data ? task.input_data->size() : 0;
-    inputs[0].buf = task.input_data ? task.input_data->data() : nullptr;
-    inputs[0].pass_through = 0;
+} // namespace
 
-    if (inputs[0].size == 0 || inputs[0].buf == nullptr) {
-        LOG_ERROR("InferWorker[{}]: empty input data for task [{}] frame {}",
-                  worker_id_, task.cam_id, task.frame_id);
-        return;
+void InferWorker::process_task(InferTask& task) {
+    auto t_start = Clock::now();
+
+    // 1. 获取 context 与 I/O 绑定 (首次使用模型时创建)
+    IoBinding* io = get_io_binding(task);
+    if (!io) return;
+    PostJob* job = acquire_slot(*io);
+    if (!job) return;
+    job->t_start = t_start;
+    job->batch_dim = 1;
+    job->attrs = &io->info->get_output_tensor_attrs();
+
+    // 2. 设置输入
+    rknn_tensor_mem* temp_mem = nullptr;
+    bool ok = bind_input(*io, task, temp_mem);
+
+    // 3. 推理 (绑定路径: 输出直接写入本槽位的 tensor)
+    if (ok && io->bound) ok = set_output_mems(*io, *job);
+    if (ok) {
+        int ret = rknn_run(io->ctx, nullptr);
+        if (ret != RKNN_SUCC) {
+            LOG_ERROR("InferWorker[{}]: rknn_run failed: ret={}", worker_id_, ret);
+            ok = false;
+        }
     }
 
-    int ret = rknn_inputs_set(ctx, 1, inputs);
-    if (ret != RKNN_SUCC) {
-        LOG_ERROR("InferWorker[{}]: rknn_inputs_set failed: ret={}", worker_id_, ret);
+    // 4. 取出输出
+    ok = ok && fetch_outputs(*io, *job);
+    if (temp_mem) {
+        // 输入 DMA-BUF 本身由 task.input_dma 持有, 这里只释放 context 侧的引用
+        if (io->bound_input == temp_mem) io->bound_input = nullptr;
+        rknn_destroy_mem(io->ctx, temp_mem);
+    }
+    job->t_infer_done = Clock::now();
+    add_npu_busy(t_start, job->t_infer_done);
+    if (!ok) {
+        release_slot(job);
         return;
     }
 
-    // 4. 推理
-    ret = rknn_run(ctx, nullptr);
-    if (ret != RKNN_SUCC) {
-        LOG_ERROR("InferWorker[{}]: rknn_run failed: ret={}", worker_id_, ret);
-        return;
+    // 5. 后处理 (纯 CPU, 不再访问 context; 流水线模式在后处理线程执行)
+    job->tasks.push_back(std::move(task));
+    submit_post(job);
+}
+
+bool InferWorker::fetch_outputs(IoBinding& io, PostJob& job) {
+    if (io.bound) {
+        // job.outputs 在创建槽位时已指向 out_mems, 只需让 CPU 看到 NPU 写入的数据
+        for (auto* mem : job.out_mems) {
+            rknn_mem_sync(io.ctx, mem, RKNN_MEMORY_SYNC_FROM_DEVICE);
+        }
+        return true;
     }
 
-    // 5. 获取输出 (float 格式)
-    uint32_t n_output = model_info->io_num.n_output;
-    std::vector<rknn_output> rknn_outputs(n_output);
+    uint32_t n_output = io.info->io_num.n_output;
+    job.buffers.resize(n_output);
     for (uint32_t i = 0; i < n_output; i++) {
-        std::memset(&rknn_outputs[i], 0, sizeof(rknn_output));
-        rknn_outputs[i].want_float = 1;
+        size_t bytes = output_bytes(io.info->output_attrs[i], io.int8);
+        job.buffers[i] = BufferPool::global().acquire(bytes);
+        job.outputs[i] = job.buffers[i]->data();
+
+        std::memset(&job.rknn_outputs[i], 0, sizeof(rknn_output));
+        job.rknn_outputs[i].index = i;
+        job.rknn_outputs[i].want_float = io.int8 ? 0 : 1;
+        job.rknn_outputs[i].is_prealloc = 1;
+        job.rknn_outputs[i].buf = job.buffers[i]->data();
+        job.rknn_outputs[i].size = static_cast<uint32_t>(bytes);
     }
 
-    ret = rknn_outputs_get(ctx, n_output, rknn_outputs.data(), nullptr);
+    int ret = rknn_outputs_get(io.ctx, n_output, job.rknn_outputs.data(), nullptr);
     if (ret != RKNN_SUCC) {
         LOG_ERROR("InferWorker[{}]: rknn_outputs_get failed: ret={}", worker_id_, ret);
+        return false;
+    }
+    // 预分配模式下数据已在 job.buffers 中, release 只归还 context 侧的状态
+    rknn_outputs_release(io.ctx, n_output, job.rknn_outputs.data());
+    return true;
+}
+
+// ============================================================
+// 后处理流水线
+// ============================================================
+
+void InferWorker::submit_post(PostJob* job) {
+    if (pipeline_depth_ <= 1) {
+        run_post_job(*job);
+        release_slot(job);
         return;
     }
 
-    auto t_infer_done = std::chrono::steady_clock::now();
+    {
+        // 在途 job 达到上限时等待: NPU 线程比后处理快时形成背压, 不丢弃已推理的结果
+        std::unique_lock<std::mutex> lock(post_mutex_);
+        post_cv_.wait(lock, [this] {
+            return post_inflight_ < static_cast<size_t>(pipeline_depth_ - 1);
+        });
+        post_jobs_.push_back(job);
+        post_inflight_++;
+    }
+    post_cv_.notify_all();
+}
 
-    // 6. 后处理 (纯 CPU，不需要 RKNN 锁)
-    std::vector<float*> output_ptrs(n_output);
-    for (uint32_t i = 0; i < n_output; i++) {
-        output_ptrs[i] = static_cast<float*>(rknn_outputs[i].buf);
+void InferWorker::post_loop() {
+    ThreadPolicy::instance().apply(ThreadRole::PostProcess, "post-" + std::to_string(worker_id_), worker_id_);
+    LOG_DEBUG("InferWorker[{}] post-process thread started", worker_id_);
+
+    while (true) {
+        PostJob* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(post_mutex_);
+            post_cv_.wait(lock, [this] { return post_stop_ || !post_jobs_.empty(); });
+            if (post_jobs_.empty()) break;   // post_stop_ 且队列已空
+            job = post_jobs_.front();
+            post_jobs_.pop_front();
+        }
+
+        run_post_job(*job);
+        release_slot(job);
+
+        {
+            std::lock_guard<std::mutex> lock(post_mutex_);
+            post_inflight_--;
+        }
+        post_cv_.notify_all();
     }
 
-    auto tensor_attrs = model_info->get_output_tensor_attrs();
+    LOG_DEBUG("InferWorker[{}] post-process thread exiting", worker_id_);
+}
 
-    auto detections = PostProcessor::process(
-        task.model_type,
-        output_ptrs,
-        tensor_attrs,
-        task.input_width, task.input_height,
-        task.original_width, task.original_height,
-        task.conf_threshold, task.nms_threshold,
-        task.labels
-    );
+void InferWorker::run_post_job(PostJob& job) {
+    auto t_post_begin = Clock::now();
+    bool int8 = job.owner->int8;
+    job.detections.resize(job.tasks.size());
+    for (size_t b = 0; b < job.tasks.size(); b++) {
+        job.detections[b] = post_process(job.tasks[b], job.outputs, *job.attrs, b, int8);
+    }
 
-    rknn_outputs_release(ctx, n_output, rknn_outputs.data());
+    auto t_post_done = Clock::now();
+    auto to_ns = [](Clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    };
+    int64_t npu_ns = to_ns(job.t_infer_done - job.t_start);
+    int64_t post_ns = to_ns(t_post_done - job.t_infer_done);
+    double total_ms = std::chrono::duration<double, std::milli>(t_post_done - job.t_start).count();
+    // 单帧开销: NPU 与实际后处理时间按批内任务均摊 (不含后处理线程排队)
+    double compute_ms = static_cast<double>(npu_ns + to_ns(t_post_done - t_post_begin)) / 1e6 /
+                        static_cast<double>(job.tasks.size());
 
-    auto t_post_done = std::chrono::steady_clock::now();
+    if (job.batch_dim <= 1) {
+        LOG_DEBUG("InferWorker[{}]: [{}] frame {} model={} -> {} dets "
+                  "(infer={:.1f}ms post={:.1f}ms total={:.1f}ms)",
+                  worker_id_, job.tasks.front().binding->cam_id, job.tasks.front().frame_id,
+                  job.tasks.front().binding->task_name, job.detections.front().size(),
+                  npu_ns / 1e6, post_ns / 1e6, total_ms);
+    } else {
+        LOG_DEBUG("InferWorker[{}]: batch {}/{} model={} (infer={:.1f}ms post={:.1f}ms total={:.1f}ms)",
+                  worker_id_, job.tasks.size(), job.batch_dim, job.tasks.front().binding->task_name,
+                  npu_ns / 1e6, post_ns / 1e6, total_ms);
+    }
 
-    double infer_ms = std::chrono::duration<double, std::milli>(t_infer_done - t_start).count();
-    double post_ms = std::chrono::duration<double, std::milli>(t_post_done - t_infer_done).count();
-    double total_ms = std::chrono::duration<double, std::milli>(t_post_done - t_start).count();
+    // 延迟直方图: 流级 + 流 x 模型 (批内任务共享 NPU / 后处理耗时)
+    for (const auto& task : job.tasks) {
+        int64_t wait_ns = task.enqueue_time != Clock::time_point{} ? to_ns(job.t_start - task.enqueue_time) : 0;
+        StageLatency* targets[] = {task.binding->counters ? &task.binding->counters->latency : nullptr,
+                                   task.binding->latency.get()};
+        for (StageLatency* latency : targets) {
+            if (!latency) continue;
+            latency->record(LatencyStage::QueueWait, wait_ns);
+            latency->record(LatencyStage::Npu, npu_ns);
+            latency->record(LatencyStage::PostProcess, post_ns);
+        }
+    }
 
-    LOG_DEBUG("InferWorker[{}]: [{}] frame {} model={} -> {} dets "
-              "(infer={:.1f}ms post={:.1f}ms total={:.1f}ms)",
-              worker_id_, task.cam_id, task.frame_id,
-              task.task_name, detections.size(),
-              infer_ms, post_ms, total_ms);
+    // 构造 ModelResult 并聚合
+    for (size_t b = 0; b < job.tasks.size(); b++) {
+        finish_task(job.tasks[b], std::move(job.detections[b]), total_ms, compute_ms);
+    }
+}
 
-    // 7. 构造 ModelResult
+void InferWorker::finish_task(InferTask& task, std::vector<Detection> detections, double total_ms,
+                              double compute_ms) {
     ModelResult model_result;
-    model_result.task_name = task.task_name;
-    model_result.model_path = task.model_path;
+    model_result.task_name = task.binding->task_name;
+    model_result.model_path = task.model_path();
     model_result.inference_time_ms = total_ms;
+    model_result.compute_ms = compute_ms;
     model_result.detections = std::move(detections);
 
-    // 8. 聚合结果
+    // 聚合结果
     if (task.aggregator) {
-        auto* collector = static_cast<FrameResultCollector*>(task.aggregator.get());
-        auto complete_result = collector->add_result(std::move(model_result));
+        auto complete_result = task.tile_count > 1
+            ? task.aggregator->add_tile(task.result_slot, task.tile_index, std::move(model_result),
+                                        task.binding->nms_threshold)
+            : task.aggregator->add_result(task.result_slot, std::move(model_result));
         if (complete_result && on_complete_) {
             on_complete_(std::move(*complete_result));
         }
     } else {
         // 单模型场景, 无 aggregator, 直接组装 FrameResult
         FrameResult result;
-        result.cam_id = task.cam_id;
-        result.rtsp_url = task.rtsp_url;
+        result.cam_id = task.binding->cam_id;
+        result.rtsp_url = task.binding->rtsp_url;
         result.frame_id = task.frame_id;
         result.timestamp_ms = task.timestamp_ms;
         result.pts = task.pts;
         result.original_width = task.original_width;
         result.original_height = task.original_height;
+        result.counters = task.binding->counters;
+        result.trackers = task.binding->trackers;
+        result.decoded_ns = task.decoded_ns;
         result.results.push_back(std::move(model_result));
 
         if (on_complete_) {
@@ -210,27 +428,568 @@ void InferWorker::process_task(InferTask& task) {
     }
 }
 
+// ============================================================
+// 后处理
+// ============================================================
+
+bool InferWorker::use_int8_output(const InferTask& task,
+                                  const std::vector<TensorAttr>& attrs) const {
+    return int8_postprocess_ && PostProcessor::supports_int8(task.binding->model_type, attrs);
+}
+
+std::vector<Detection> InferWorker::post_process(const InferTask& task,
+                                                 const std::vector<void*>& outputs,
+                                                 const std::vector<TensorAttr>& attrs,
+                                                 size_t sample, bool int8) const {
+    // 预处理给出了实际的几何变换时按变换反算坐标, 否则按 letterbox 假设计算
+    const LetterboxTransform& transform = task.transform;
+    bool exact = transform.valid() &&
+                 transform.model_w == task.binding->input_width &&
+                 transform.model_h == task.binding->input_height;
+
+    // 指针数组按线程复用 (串行模式在 NPU 线程, 流水线模式在后处理线程)
+    if (int8) {
+        thread_local std::vector<const int8_t*> ptrs;
+        ptrs.resize(outputs.size());
+        for (size_t i = 0; i < outputs.size(); i++) {
+            ptrs[i] = static_cast<const int8_t*>(outputs[i]) + sample * attrs[i].n_elems;
+        }
+        if (exact) {
+            return PostProcessor::process_int8(
+                task.binding->model_type, ptrs, attrs, transform,
+                task.binding->conf_threshold, task.binding->nms_threshold,
+                task.binding->label_table());
+        }
+        return PostProcessor::process_int8(
+            task.binding->model_type, ptrs, attrs,
+            task.binding->input_width, task.binding->input_height,
+            task.original_width, task.original_height,
+            task.binding->conf_threshold, task.binding->nms_threshold,
+            task.binding->label_table());
+    }
+
+    thread_local std::vector<float*> ptrs;
+    ptrs.resize(outputs.size());
+    for (size_t i = 0; i < outputs.size(); i++) {
+        ptrs[i] = static_cast<float*>(outputs[i]) + sample * attrs[i].n_elems;
+    }
+    if (exact) {
+        return PostProcessor::process(
+            task.binding->model_type, ptrs, attrs, transform,
+            task.binding->conf_threshold, task.binding->nms_threshold,
+            task.binding->label_table());
+    }
+    return PostProcessor::process(
+        task.binding->model_type, ptrs, attrs,
+        task.binding->input_width, task.binding->input_height,
+        task.original_width, task.original_height,
+        task.binding->conf_threshold, task.binding->nms_threshold,
+        task.binding->label_table());
+}
+
+// ============================================================
+// 动态批处理
+// ============================================================
+
+int InferWorker::batch_capacity(const InferTask& task) const {
+    if (task.binding->max_batch <= 1) return 1;
+
+    const ModelInfo* info = model_mgr_.get_model_info(task.model_path());
+    if (!info || info->input_attrs.empty() || info->input_attrs[0].n_dims < 4) return 1;
+
+    // 批处理模型的 batch 维度在 dims[0] (NHWC / NCHW 均是)
+    return std::max(1, std::min(task.binding->max_batch, info->batch));
+}
+
+void InferWorker::process_batch(std::vector<InferTask>& tasks) {
+    auto t_start = Clock::now();
+
+    IoBinding* io = get_io_binding(tasks.front());
+    if (!io) return;
+    const ModelInfo& info = *io->info;
+    PostJob* job = acquire_slot(*io);
+    if (!job) return;
+
+    // 按样本拆分输出: 每个输出 tensor 的 dims[0] 是 batch, 单样本属性已在 ModelInfo 中缓存
+    int batch_dim = info.batch;
+    job->t_start = t_start;
+    job->batch_dim = batch_dim;
+    job->attrs = &info.sample_output_attrs;
+
+    // 1. 拼接输入: [B, H, W, 3], 不足 B 的槽位填 0
+    bool ok = true;
+    if (io->bound) {
+        // 绑定路径: 逐样本直接写入持久输入 tensor; 输入无效的任务与单任务路径一样丢弃,
+        // 其余任务前移补位, 保证样本下标与任务一一对应
+        size_t n = 0;
+        for (size_t i = 0; i < tasks.size(); i++) {
+            if (!write_input_sample(*io, tasks[i], n)) continue;
+            if (n != i) tasks[n] = std::move(tasks[i]);
+            n++;
+        }
+        tasks.resize(n);
+        if (tasks.empty()) {
+            release_slot(job);
+            return;
+        }
+        size_t sample_bytes = input_layout(info.input_attrs[0]).sample_bytes();
+        if (tasks.size() < static_cast<size_t>(batch_dim)) {
+            std::memset(static_cast<uint8_t*>(io->input->virt_addr) + tasks.size() * sample_bytes, 0,
+                        (batch_dim - tasks.size()) * sample_bytes);
+        }
+        rknn_mem_sync(io->ctx, io->input, RKNN_MEMORY_SYNC_TO_DEVICE);
+        ok = set_input_mem(*io, io->input) && set_output_mems(*io, *job);
+    } else {
+        const rknn_tensor_attr& in_attr = info.input_attrs[0];
+        size_t total_bytes = in_attr.n_elems;   // UINT8 输入, 1 byte/elem
+        size_t sample_bytes = total_bytes / static_cast<size_t>(batch_dim);
+        InputLayout layout = input_layout(in_attr);
+
+        auto input = BufferPool::global().acquire(total_bytes);
+        for (size_t i = 0; i < tasks.size(); i++) {
+            const auto& task = tasks[i];
+            uint8_t* slot = input->data() + i * sample_bytes;
+
+            const uint8_t* src = nullptr;
+            size_t src_size = 0;
+            if (task.input_data && !task.input_data->empty()) {
+                src = task.input_data->data();
+                src_size = task.input_data->size();
+            } else if (task.input_dma && task.input_dma->virt_addr) {
+                src = static_cast<const uint8_t*>(task.input_dma->virt_addr);
+                src_size = task.input_dma->size;
+            }
+
+            if (!src || src_size < sample_bytes) {
+                LOG_WARN("InferWorker[{}]: bad input for batched task [{}] frame {} ({} < {} bytes)",
+                         worker_id_, task.binding->cam_id, task.frame_id, src_size, sample_bytes);
+                std::memset(slot, 0, sample_bytes);
+                continue;
+            }
+            // rknn_inputs_set 要求紧凑排列: 源数据按 tensor 行步长排列 (池化 tensor) 时逐行拷贝
+            if (layout.stride_bytes != layout.row_bytes && layout.packed_bytes() == sample_bytes &&
+                src_size >= layout.sample_bytes()) {
+                for (size_t r = 0; r < layout.rows; r++) {
+                    std::memcpy(slot + r * layout.row_bytes, src + r * layout.stride_bytes, layout.row_bytes);
+                }
+                continue;
+            }
+            std::memcpy(slot, src, sample_bytes);
+        }
+        if (tasks.size() < static_cast<size_t>(batch_dim)) {
+            std::memset(input->data() + tasks.size() * sample_bytes, 0,
+                        (batch_dim - tasks.size()) * sample_bytes);
+        }
+
+        rknn_input inputs[1];
+        std::memset(inputs, 0, sizeof(inputs));
+        inputs[0].index = 0;
+        inputs[0].type = RKNN_TENSOR_UINT8;
+        inputs[0].fmt = RKNN_TENSOR_NHWC;
+        inputs[0].size = static_cast<uint32_t>(total_bytes);
+        inputs[0].buf = input->data();
+
+        int ret = rknn_inputs_set(io->ctx, 1, inputs);
+        if (ret != RKNN_SUCC) {
+            LOG_ERROR("InferWorker[{}]: rknn_inputs_set (batch={}) failed: ret={}",
+                      worker_id_, tasks.size(), ret);
+            ok = false;
+        }
+    }
+
+    // 2. 推理
+    if (ok) {
+        int ret = rknn_run(io->ctx, nullptr);
+        if (ret != RKNN_SUCC) {
+            LOG_ERROR("InferWorker[{}]: rknn_run (batch={}) failed: ret={}", worker_id_, tasks.size(), ret);
+            ok = false;
+        }
+    }
+
+    ok = ok && fetch_outputs(*io, *job);
+    job->t_infer_done = Clock::now();
+    add_npu_busy(t_start, job->t_infer_done);
+    if (!ok) {
+        release_slot(job);
+        return;
+    }
+
+    // 3. 逐样本后处理并分发结果到各自的 Collector
+    for (auto& task : tasks) {
+        job->tasks.push_back(std::move(task));
+    }
+    submit_post(job);
+}
+
+// ============================================================
+// 输入设置
+// ============================================================
+
+bool InferWorker::bind_input(IoBinding& io, const InferTask& task, rknn_tensor_mem*& temp_mem) {
+    temp_mem = nullptr;
+    if (!io.bound) {
+        if (zero_copy_) {
+            temp_mem = set_input_zero_copy(io.ctx, *io.info, task);
+            return temp_mem != nullptr;
+        }
+        return set_input_copy(io.ctx, task);
+    }
+
+    if (task.input_dma && task.input_dma->fd >= 0) {
+        // RGA 已写入 DMA-BUF: 池化 tensor 复用导入结果, 其他 DMA-BUF 临时导入
+        rknn_tensor_mem* mem = nullptr;
+        if (task.input_dma->id != 0) {
+            mem = import_input(io, *task.input_dma);
+        } else {
+            mem = temp_mem = rknn_create_mem_from_fd(
+                io.ctx, task.input_dma->fd, task.input_dma->virt_addr,
+                static_cast<uint32_t>(task.input_dma->size), 0);
+        }
+        if (!mem) {
+            LOG_ERROR("InferWorker[{}]: failed to import input DMA-BUF for task [{}] frame {}",
+                      worker_id_, task.binding->cam_id, task.frame_id);
+            return false;
+        }
+        return set_input_mem(io, mem);
+    }
+
+    if (!write_input_sample(io, task, 0)) return false;
+    rknn_mem_sync(io.ctx, io.input, RKNN_MEMORY_SYNC_TO_DEVICE);
+    return set_input_mem(io, io.input);
+}
+
+bool InferWorker::write_input_sample(IoBinding& io, const InferTask& task, size_t sample) {
+    InputLayout layout = input_layout(io.info->input_attrs[0]);
+    uint8_t* dst = static_cast<uint8_t*>(io.input->virt_addr) + sample * layout.sample_bytes();
+
+    const uint8_t* src = nullptr;
+    size_t src_size = 0;
+    if (task.input_data && !task.input_data->empty()) {
+        src = task.input_data->data();
+        src_size = task.input_data->size();
+    } else if (task.input_dma && task.input_dma->virt_addr) {
+        src = static_cast<const uint8_t*>(task.input_dma->virt_addr);
+        src_size = task.input_dma->size;
+    }
+
+    if (!src || src_size < layout.packed_bytes()) {
+        LOG_WARN("InferWorker[{}]: bad input for task [{}] frame {} ({} < {} bytes)",
+                 worker_id_, task.binding->cam_id, task.frame_id, src_size, layout.packed_bytes());
+        std::memset(dst, 0, layout.sample_bytes());
+        return false;
+    }
+
+    // 源数据已按 tensor 行步长排列 (池化 tensor) 或步长与行宽一致时整块拷贝
+    if (layout.stride_bytes == layout.row_bytes || src_size >= layout.sample_bytes()) {
+        std::memcpy(dst, src, layout.sample_bytes());
+        return true;
+    }
+    for (size_t r = 0; r < layout.rows; r++) {
+        std::memcpy(dst + r * layout.stride_bytes, src + r * layout.row_bytes, layout.row_bytes);
+    }
+    return true;
+}
+
+bool InferWorker::set_input_mem(IoBinding& io, rknn_tensor_mem* mem) {
+    if (io.bound_input == mem) return true;
+
+    rknn_tensor_attr attr = io.info->input_attrs[0];
+    attr.type = RKNN_TENSOR_UINT8;
+    attr.fmt = RKNN_TENSOR_NHWC;
+
+    int ret = rknn_set_io_mem(io.ctx, mem, &attr);
+    if (ret != RKNN_SUCC) {
+        LOG_ERROR("InferWorker[{}]: rknn_set_io_mem (input) failed: ret={}", worker_id_, ret);
+        io.bound_input = nullptr;
+        return false;
+    }
+    io.bound_input = mem;
+    return true;
+}
+
+bool InferWorker::set_output_mems(IoBinding& io, PostJob& job) {
+    if (io.bound_outputs == &job) return true;
+
+    for (size_t i = 0; i < job.out_mems.size(); i++) {
+        rknn_tensor_attr attr = io.info->output_attrs[i];
+        if (!io.int8) attr.type = RKNN_TENSOR_FLOAT32;
+
+        int ret = rknn_set_io_mem(io.ctx, job.out_mems[i], &attr);
+        if (ret != RKNN_SUCC) {
+            LOG_ERROR("InferWorker[{}]: rknn_set_io_mem (output {}) failed: ret={}", worker_id_, i, ret);
+            io.bound_outputs = nullptr;
+            return false;
+        }
+    }
+    io.bound_outputs = &job;
+    return true;
+}
+
+rknn_tensor_mem* InferWorker::import_input(IoBinding& io, const DmaBuffer& dma) {
+    auto it = io.imports.find(dma.id);
+    if (it != io.imports.end()) {
+        it->second.last_use = ++io.import_seq;
+        return it->second.mem;
+    }
+
+    if (io.imports.size() >= kMaxImports) {
+        // 淘汰最久未用的导入: 池中 tensor 释放重建后旧 id 不再出现, 逐步被淘汰;
+        // 仍在轮转的 tensor 不受影响 (整体清空会让多路流共用时反复重新导入)
+        auto lru = io.imports.begin();
+        for (auto i = io.imports.begin(); i != io.imports.end(); ++i) {
+            if (i->second.last_use < lru->second.last_use) lru = i;
+        }
+        if (io.bound_input == lru->second.mem) io.bound_input = nullptr;
+        rknn_destroy_mem(io.ctx, lru->second.mem);
+        io.imports.erase(lru);
+    }
+
+    rknn_tensor_mem* mem = rknn_create_mem_from_fd(io.ctx, dma.fd, dma.virt_addr,
+                                                   static_cast<uint32_t>(dma.size), 0);
+    if (!mem) return nullptr;
+    io.imports.emplace(dma.id, IoBinding::Import{mem, ++io.import_seq});
+    return mem;
+}
+
+bool InferWorker::set_input_copy(rknn_context ctx, const InferTask& task) {
+    rknn_input inputs[1];
+    std::memset(inputs, 0, sizeof(inputs));
+    inputs[0].index = 0;
+    inputs[0].type = RKNN_TENSOR_UINT8;
+    inputs[0].fmt = RKNN_TENSOR_NHWC;
+    inputs[0].size = task.input_data ? task.input_data->size() : 0;
+    inputs[0].buf = task.input_data ? task.input_data->data() : nullptr;
+    inputs[0].pass_through = 0;
+
+    if (inputs[0].size == 0 || inputs[0].buf == nullptr) {
+        LOG_ERROR("InferWorker[{}]: empty input data for task [{}] frame {}",
+                  worker_id_, task.binding->cam_id, task.frame_id);
+        return false;
+    }
+
+    int ret = rknn_inputs_set(ctx, 1, inputs);
+    if (ret != RKNN_SUCC) {
+        LOG_ERROR("InferWorker[{}]: rknn_inputs_set failed: ret={}", worker_id_, ret);
+        return false;
+    }
+    return true;
+}
+
+rknn_tensor_mem* InferWorker::set_input_zero_copy(rknn_context ctx, const ModelInfo& info,
+                                                  const InferTask& task) {
+    if (info.input_attrs.empty()) {
+        LOG_ERROR("InferWorker[{}]: model has no input attrs: {}", worker_id_, task.model_path());
+        return nullptr;
+    }
+
+    rknn_tensor_mem* mem = nullptr;
+    if (task.input_dma && task.input_dma->fd >= 0) {
+        // RGA 已写入 DMA-BUF, 导入当前 context 直接绑定
+        mem = rknn_create_mem_from_fd(ctx, task.input_dma->fd, task.input_dma->virt_addr,
+                                      static_cast<uint32_t>(task.input_dma->size), 0);
+    } else if (task.input_data && !task.input_data->empty()) {
+        // 回退: 输入在 CPU 内存中 (如 RGA 写 tensor 失败), 拷贝到临时 tensor mem
+        mem = rknn_create_mem(ctx, static_cast<uint32_t>(task.input_data->size()));
+        if (mem) {
+            std::memcpy(mem->virt_addr, task.input_data->data(), task.input_data->size());
+        }
+    } else {
+        LOG_ERROR("InferWorker[{}]: empty input data for task [{}] frame {}",
+                  worker_id_, task.binding->cam_id, task.frame_id);
+        return nullptr;
+    }
+
+    if (!mem) {
+        LOG_ERROR("InferWorker[{}]: failed to create input tensor mem for task [{}] frame {}",
+                  worker_id_, task.binding->cam_id, task.frame_id);
+        return nullptr;
+    }
+
+    rknn_tensor_attr attr = info.input_attrs[0];
+    attr.type = RKNN_TENSOR_UINT8;
+    attr.fmt = RKNN_TENSOR_NHWC;
+
+    int ret = rknn_set_io_mem(ctx, mem, &attr);
+    if (ret != RKNN_SUCC) {
+        LOG_ERROR("InferWorker[{}]: rknn_set_io_mem failed: ret={}", worker_id_, ret);
+        rknn_destroy_mem(ctx, mem);
+        return nullptr;
+    }
+    return mem;
+}
+
+// ============================================================
+// I/O 绑定
+// ============================================================
+
+InferWorker::IoBinding* InferWorker::get_io_binding(const InferTask& task) {
+    const std::string& model_path = task.model_path();
+    auto it = io_bindings_.find(model_path);
+    if (it != io_bindings_.end()) return it->second.get();
+
+    rknn_context ctx = get_or_create_context(model_path);
+    if (ctx == 0) {
+        LOG_ERROR("InferWorker[{}]: cannot get context for model: {}", worker_id_, model_path);
+        return nullptr;
+    }
+    const ModelInfo* info = model_mgr_.get_model_info(model_path);
+    if (!info || info->input_attrs.empty()) {
+        LOG_ERROR("InferWorker[{}]: model info not found: {}", worker_id_, model_path);
+        return nullptr;
+    }
+
+    auto io = std::make_unique<IoBinding>();
+    io->ctx = ctx;
+    io->info = info;
+    io->int8 = use_int8_output(task, info->sample_output_attrs);
+
+    uint32_t n_output = info->io_num.n_output;
+    io->slots.reserve(static_cast<size_t>(pipeline_depth_));
+    for (int i = 0; i < pipeline_depth_; i++) {
+        auto slot = std::make_unique<PostJob>();
+        slot->owner = io.get();
+        slot->tasks.reserve(static_cast<size_t>(info->batch));
+        slot->detections.reserve(static_cast<size_t>(info->batch));
+        slot->outputs.resize(n_output, nullptr);
+        slot->rknn_outputs.resize(n_output);
+        io->slots.push_back(std::move(slot));
+    }
+    io->bound = io_binding_ && create_io_tensors(*io);
+    {
+        std::lock_guard<std::mutex> lock(post_mutex_);
+        for (auto& slot : io->slots) io->free_slots.push_back(slot.get());
+    }
+
+    LOG_INFO("InferWorker[{}]: {} -> {} I/O, {} slot(s), {} output",
+             worker_id_, model_path, io->bound ? "bound" : "runtime-copy",
+             io->slots.size(), io->int8 ? "int8" : "float");
+
+    IoBinding* raw = io.get();
+    io_bindings_.emplace(model_path, std::move(io));
+    return raw;
+}
+
+bool InferWorker::create_io_tensors(IoBinding& io) {
+    const rknn_tensor_attr& in_attr = io.info->input_attrs[0];
+    uint32_t in_size = in_attr.size_with_stride > 0 ? in_attr.size_with_stride : in_attr.n_elems;
+    io.input = rknn_create_mem(io.ctx, in_size);
+    bool ok = io.input != nullptr;
+
+    for (size_t s = 0; ok && s < io.slots.size(); s++) {
+        PostJob& slot = *io.slots[s];
+        for (const auto& attr : io.info->output_attrs) {
+            rknn_tensor_mem* mem = rknn_create_mem(io.ctx, static_cast<uint32_t>(output_bytes(attr, io.int8)));
+            if (!mem) {
+                ok = false;
+                break;
+            }
+            slot.out_mems.push_back(mem);
+        }
+    }
+
+    if (!ok) {
+        LOG_WARN("InferWorker[{}]: rknn_create_mem failed for {}, falling back to rknn_inputs_set / "
+                 "rknn_outputs_get", worker_id_, io.info->model_path);
+        destroy_io_binding(io);
+        return false;
+    }
+
+    for (auto& slot : io.slots) {
+        for (size_t i = 0; i < slot->out_mems.size(); i++) {
+            slot->outputs[i] = slot->out_mems[i]->virt_addr;
+        }
+    }
+    return true;
+}
+
+void InferWorker::destroy_io_binding(IoBinding& io) {
+    for (auto& [id, entry] : io.imports) {
+        rknn_destroy_mem(io.ctx, entry.mem);
+    }
+    io.imports.clear();
+    if (io.input) {
+        rknn_destroy_mem(io.ctx, io.input);
+        io.input = nullptr;
+    }
+    for (auto& slot : io.slots) {
+        for (auto* mem : slot->out_mems) {
+            rknn_destroy_mem(io.ctx, mem);
+        }
+        slot->out_mems.clear();
+        std::fill(slot->outputs.begin(), slot->outputs.end(), nullptr);
+    }
+    io.bound_input = nullptr;
+    io.bound_outputs = nullptr;
+    io.bound = false;
+}
+
+InferWorker::PostJob* InferWorker::acquire_slot(IoBinding& io) {
+    std::lock_guard<std::mutex> lock(post_mutex_);
+    if (io.free_slots.empty()) {
+        // 在途任务数 <= pipeline_depth - 1, 每个模型有 pipeline_depth 个槽位, 不应发生
+        LOG_ERROR("InferWorker[{}]: no free post-process slot for {}", worker_id_, io.info->model_path);
+        return nullptr;
+    }
+    // 优先复用输出仍绑定在 context 上的槽位 (上一个任务的后处理已完成时), 省去重新绑定;
+    // 流水线满载时该槽位仍在后处理, 只能换用其他槽位并重新绑定输出
+    // (RKNN 每个 context 只有一组输出绑定, 多槽位轮转无法只绑定一次)
+    auto pick = std::find(io.free_slots.begin(), io.free_slots.end(), io.bound_outputs);
+    if (pick == io.free_slots.end()) pick = io.free_slots.end() - 1;
+    PostJob* job = *pick;
+    io.free_slots.erase(pick);
+    return job;
+}
+
+void InferWorker::release_slot(PostJob* job) {
+    // 释放任务持有的输入缓冲与回退路径的输出缓冲 (容器容量保留)
+    job->tasks.clear();
+    job->detections.clear();
+    job->buffers.clear();
+
+    std::lock_guard<std::mutex> lock(post_mutex_);
+    job->owner->free_slots.push_back(job);
+}
+
 // ============================================================
 // Context 管理
 // ============================================================
 
 bool InferWorker::pre_create_context(const std::string& model_path) {
-    if (contexts_.count(model_path)) return true;
+    if (has_context(model_path)) return true;
 
+    // rknn_init 不持 contexts_mutex_: 同一 worker 的多个模型可并行预创建
     LOG_INFO("InferWorker[{}]: pre-creating context for model: {}", worker_id_, model_path);
     rknn_context ctx = model_mgr_.create_worker_context(model_path, core_mask_);
     if (ctx == 0) {
         LOG_ERROR("InferWorker[{}]: failed to pre-create context for: {}", worker_id_, model_path);
         return false;
     }
-    contexts_[model_path] = ctx;
-    return true;
+    return adopt_context(model_path, ctx) != 0;
+}
+
+rknn_context InferWorker::adopt_context(const std::string& model_path, rknn_context ctx) {
+    std::lock_guard<std::mutex> lock(contexts_mutex_);
+    auto [it, inserted] = contexts_.emplace(model_path, ctx);
+    if (!inserted) {
+        // 并发创建了同一模型的 context: 保留已登记的一份
+        model_mgr_.release_worker_context(ctx);
+    }
+    context_count_.store(contexts_.size(), std::memory_order_relaxed);
+    return it->second;
+}
+
+bool InferWorker::has_context(const std::string& model_path) const {
+    std::lock_guard<std::mutex> lock(contexts_mutex_);
+    return contexts_.count(model_path) > 0;
 }
 
 rknn_context InferWorker::get_or_create_context(const std::string& model_path) {
-    auto it = contexts_.find(model_path);
-    if (it != contexts_.end()) {
-        return it->second;
+    {
+        std::lock_guard<std::mutex> lock(contexts_mutex_);
+        auto it = contexts_.find(model_path);
+        if (it != contexts_.end()) {
+            return it->second;
+        }
     }
 
     // 惰性创建
@@ -239,17 +998,77 @@ rknn_context InferWorker::get_or_create_context(const std::string& model_path) {
     if (ctx == 0) {
         return 0;
     }
-
-    contexts_[model_path] = ctx;
-    return ctx;
+    return adopt_context(model_path, ctx);
 }
 
 void InferWorker::release_all_contexts() {
+    // I/O 绑定的 tensor 属于各自的 context, 必须先于 context 销毁
+    for (auto& [path, io] : io_bindings_) {
+        destroy_io_binding(*io);
+    }
+    io_bindings_.clear();
+
+    std::lock_guard<std::mutex> lock(contexts_mutex_);
     for (auto& [path, ctx] : contexts_) {
         LOG_DEBUG("InferWorker[{}]: releasing context for model: {}", worker_id_, path);
         model_mgr_.release_worker_context(ctx);
     }
     contexts_.clear();
+    context_count_.store(0, std::memory_order_relaxed);
+}
+
+void InferWorker::release_model(const std::string& model_path) {
+    std::lock_guard<std::mutex> lock(release_mutex_);
+    if (std::find(pending_releases_.begin(), pending_releases_.end(), model_path) == pending_releases_.end()) {
+        pending_releases_.push_back(model_path);
+    }
+    release_pending_.store(true, std::memory_order_release);
+}
+
+void InferWorker::process_releases() {
+    std::vector<std::string> paths;
+    {
+        std::lock_guard<std::mutex> lock(release_mutex_);
+        paths.swap(pending_releases_);
+    }
+
+    std::vector<std::string> deferred;
+    for (auto& path : paths) {
+        if (!try_release_model(path)) deferred.push_back(std::move(path));
+    }
+
+    std::lock_guard<std::mutex> lock(release_mutex_);
+    for (auto& path : deferred) {
+        if (std::find(pending_releases_.begin(), pending_releases_.end(), path) == pending_releases_.end()) {
+            pending_releases_.push_back(std::move(path));
+        }
+    }
+    release_pending_.store(!pending_releases_.empty(), std::memory_order_release);
+}
+
+bool InferWorker::try_release_model(const std::string& model_path) {
+    auto it = io_bindings_.find(model_path);
+    if (it != io_bindings_.end()) {
+        IoBinding& io = *it->second;
+        {
+            // 后处理线程仍持有该模型的槽位 (输出 tensor 属于该 context)
+            std::lock_guard<std::mutex> lock(post_mutex_);
+            if (io.free_slots.size() < io.slots.size()) return false;
+        }
+        destroy_io_binding(io);
+        io_bindings_.erase(it);
+    }
+
+    // 持锁释放: has_context() 返回 false 时 context 已销毁, 调用方随后可卸载主 context
+    std::lock_guard<std::mutex> lock(contexts_mutex_);
+    auto ctx_it = contexts_.find(model_path);
+    if (ctx_it != contexts_.end()) {
+        LOG_INFO("InferWorker[{}]: releasing context for model: {}", worker_id_, model_path);
+        model_mgr_.release_worker_context(ctx_it->second);
+        contexts_.erase(ctx_it);
+        context_count_.store(contexts_.size(), std::memory_order_relaxed);
+    }
+    return true;
 }
 
 // ============================================================
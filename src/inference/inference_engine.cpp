@@ -7,20 +7,55 @@
 
 #include "infer_server/inference/inference_engine.h"
 #include "infer_server/common/logger.h"
+#include "infer_server/inference/object_tracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
 
 namespace infer_server {
 
+#ifdef HAS_ZMQ
+/// 解析 zmq_* 配置, 未知值回退到默认
+static ZmqPublisher::Options zmq_options(const ServerConfig& config) {
+    ZmqPublisher::Options options;
+    if (!parse_output_format(config.zmq_format, options.format)) {
+        LOG_WARN("Unknown zmq_format '{}', falling back to json", config.zmq_format);
+    }
+    if (!parse_topic_mode(config.zmq_topic_mode, options.topic_mode)) {
+        LOG_WARN("Unknown zmq_topic_mode '{}', falling back to none", config.zmq_topic_mode);
+    }
+    options.skip_empty = config.zmq_skip_empty;
+    return options;
+}
+#endif
+
+/// 解析 infer_queue_policy, 未知值回退到 fifo
+static InferTaskQueue::Policy task_queue_policy(const ServerConfig& config) {
+    InferTaskQueue::Policy policy = InferTaskQueue::Policy::FIFO;
+    if (!InferTaskQueue::parse_policy(config.infer_queue_policy, policy)) {
+        LOG_WARN("Unknown infer_queue_policy '{}', falling back to fifo", config.infer_queue_policy);
+    }
+    return policy;
+}
+
 InferenceEngine::InferenceEngine(const ServerConfig& config)
     : config_(config)
-    , task_queue_(static_cast<size_t>(config.infer_queue_size))
+    , task_queue_(static_cast<size_t>(config.infer_queue_size),
+                  config.infer_queue_lockfree ? QueueMode::LOCK_FREE : QueueMode::MUTEX,
+                  task_queue_policy(config))
+    , dispatcher_(config.output_threads, static_cast<size_t>(std::max(config.output_queue_size, 1)))
 #ifdef HAS_ZMQ
-    , zmq_pub_(config.zmq_endpoint)
+    , zmq_pub_(config.zmq_endpoint, zmq_options(config))
 #endif
 {
+    model_mgr_.set_share_weights(config.model_share_weights);
+    dispatcher_.add_sink([this](const FrameResult& result) { output_result(result); });
 }
 
 InferenceEngine::~InferenceEngine() {
     shutdown();
+    join_loaders();
 }
 
 bool InferenceEngine::init() {
@@ -31,11 +66,20 @@ bool InferenceEngine::init() {
 
     LOG_INFO("Initializing InferenceEngine...");
     LOG_INFO("  Workers:    {}", config_.num_infer_workers);
-    LOG_INFO("  Queue size: {}", config_.infer_queue_size);
+    LOG_INFO("  Queue size: {} ({}, {})", config_.infer_queue_size, queue_policy(),
+             task_queue_.mode() == QueueMode::LOCK_FREE ? "lock-free" : "mutex");
+    LOG_INFO("  Zero-copy:  {}", config_.zero_copy ? "on" : "off");
+    LOG_INFO("  Scheduler:  {}", config_.infer_scheduler);
+    LOG_INFO("  Pipeline:   depth {}, io binding {}", std::max(config_.infer_pipeline_depth, 1),
+             config_.infer_io_binding ? "on" : "off");
+    LOG_INFO("  INT8 post:  {}", config_.int8_postprocess ? "on" : "off");
+    LOG_INFO("  Weights:    {}", config_.model_share_weights ? "shared across contexts" : "per context");
 
 #ifdef HAS_ZMQ
     // 初始化 ZMQ
-    LOG_INFO("  ZMQ endpoint: {}", config_.zmq_endpoint);
+    LOG_INFO("  ZMQ endpoint: {} ({}, topics={})", config_.zmq_endpoint,
+             output_format_name(zmq_pub_.format()),
+             topic_mode_name(zmq_pub_.options().topic_mode));
     if (!zmq_pub_.init()) {
         LOG_ERROR("Failed to initialize ZMQ publisher");
         return false;
@@ -44,19 +88,44 @@ bool InferenceEngine::init() {
     LOG_WARN("ZMQ not available, results will only be passed via callback");
 #endif
 
+    // 启动输出阶段 (worker 创建前, 保证第一帧结果就有消费者)
+    LOG_INFO("  Output:     {} thread(s), queue {}", dispatcher_.num_threads(), config_.output_queue_size);
+    dispatcher_.start();
+
     // 创建工作线程
     int num_workers = config_.num_infer_workers;
     int num_npu_cores = config_.num_npu_cores;
     LOG_INFO("  NPU cores: {}", num_npu_cores);
     workers_.reserve(num_workers);
 
+    if (config_.infer_scheduler == "affinity" && num_workers > 0) {
+        // 每个 worker 队列分摊全局队列容量, 总缓冲上限不变
+        size_t per_worker = std::max<size_t>(
+            1, static_cast<size_t>(config_.infer_queue_size) / static_cast<size_t>(num_workers));
+        scheduler_ = std::make_unique<AffinityScheduler>(
+            static_cast<size_t>(num_workers), per_worker,
+            static_cast<size_t>(std::max(0, config_.steal_backlog)),
+            task_queue_.mode(), task_queue_.policy());
+        LOG_INFO("  Affinity:   {} per-worker queues x {}, replicas={}, steal_backlog={}",
+                 num_workers, per_worker, config_.affinity_replicas, config_.steal_backlog);
+    } else if (config_.infer_scheduler != "shared") {
+        LOG_WARN("Unknown infer_scheduler '{}', falling back to shared queue",
+                 config_.infer_scheduler);
+    }
+
     for (int i = 0; i < num_workers; i++) {
         int core_mask = NpuCoreMask::from_worker_id(i, num_npu_cores);
         auto worker = std::make_unique<InferWorker>(
-            i, core_mask, model_mgr_, task_queue_,
+            i, core_mask, model_mgr_,
+            scheduler_ ? scheduler_->queue(i) : task_queue_,
             [this](FrameResult result) {
                 on_result_complete(std::move(result));
-            }
+            },
+            config_.zero_copy,
+            scheduler_.get(),
+            config_.int8_postprocess,
+            config_.infer_pipeline_depth,
+            config_.infer_io_binding
         );
         workers_.push_back(std::move(worker));
     }
@@ -71,33 +140,242 @@ bool InferenceEngine::init() {
     return true;
 }
 
-bool InferenceEngine::load_models(const std::vector<ModelConfig>& models) {
-    bool all_ok = true;
+namespace {
+
+/// 在最多 CPU 核数个线程上并行执行 fn(0) .. fn(n - 1)
+template <typename Fn>
+void parallel_for(size_t n, Fn&& fn) {
+    size_t threads = std::min<size_t>(n, std::max(1u, std::thread::hardware_concurrency()));
+    if (threads <= 1) {
+        for (size_t i = 0; i < n; i++) fn(i);
+        return;
+    }
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (size_t t = 0; t < threads; t++) {
+        pool.emplace_back([&]() {
+            for (size_t i = next.fetch_add(1); i < n; i = next.fetch_add(1)) fn(i);
+        });
+    }
+    for (auto& th : pool) th.join();
+}
+
+} // namespace
+
+std::vector<std::string> InferenceEngine::claim_models(const std::vector<ModelConfig>& models) {
+    std::vector<std::string> paths;
+    std::lock_guard<std::mutex> lock(load_mutex_);
     for (const auto& mc : models) {
-        if (!model_mgr_.is_loaded(mc.model_path)) {
-            LOG_INFO("Pre-loading model: {} (task={})", mc.model_path, mc.task_name);
-            if (!model_mgr_.load_model(mc.model_path)) {
-                LOG_ERROR("Failed to load model: {}", mc.model_path);
-                all_ok = false;
-                continue;
-            }
-            // 预创建所有 worker context，避免惰性创建时与 RGA 硬件并发冲突
-            for (auto& worker : workers_) {
-                if (!worker->pre_create_context(mc.model_path)) {
-                    LOG_ERROR("Failed to pre-create context for worker {}", worker->worker_id());
-                    all_ok = false;
-                }
-            }
+        auto it = model_states_.find(mc.model_path);
+        if (it != model_states_.end() && it->second != ModelState::Failed) continue;
+        model_states_[mc.model_path] = ModelState::Loading;
+        paths.push_back(mc.model_path);
+        LOG_INFO("Pre-loading model: {} (task={})", mc.model_path, mc.task_name);
+
+        // affinity 主 worker 按配置顺序分配, 不受并行加载完成顺序影响
+        if (scheduler_ && !workers_.empty()) {
+            int home = scheduler_->assign_model(mc.model_path);
+            int replicas = std::clamp(config_.affinity_replicas, 1, static_cast<int>(workers_.size()));
+            LOG_INFO("Model {} -> home worker {} ({} replica(s))", mc.model_path, home, replicas);
+        }
+    }
+    return paths;
+}
+
+std::vector<InferWorker*> InferenceEngine::context_targets(const std::string& model_path) {
+    // affinity 模式只在主 worker 及其后 (affinity_replicas - 1) 个 worker 上创建
+    std::vector<InferWorker*> targets;
+    if (scheduler_ && !workers_.empty()) {
+        int n = static_cast<int>(workers_.size());
+        int home = scheduler_->assign_model(model_path);
+        int replicas = std::clamp(config_.affinity_replicas, 1, n);
+        for (int r = 0; r < replicas; r++) {
+            targets.push_back(workers_[(home + r) % n].get());
+        }
+    } else {
+        for (auto& worker : workers_) targets.push_back(worker.get());
+    }
+    return targets;
+}
+
+bool InferenceEngine::load_claimed(const std::vector<std::string>& model_paths) {
+    if (model_paths.empty()) return true;
+    auto start = std::chrono::steady_clock::now();
+
+    // 第一阶段: 各模型并行映射文件 + rknn_init
+    std::vector<char> loaded(model_paths.size(), 0);
+    parallel_for(model_paths.size(), [&](size_t i) {
+        loaded[i] = model_mgr_.load_model(model_paths[i]);
+        if (!loaded[i]) LOG_ERROR("Failed to load model: {}", model_paths[i]);
+    });
+
+    // 第二阶段: 所有 (模型, worker) 的 context 并行预创建,
+    // 避免惰性创建时与 RGA 硬件并发冲突
+    std::vector<std::pair<size_t, InferWorker*>> jobs;
+    for (size_t i = 0; i < model_paths.size(); i++) {
+        if (!loaded[i]) continue;
+        for (auto* worker : context_targets(model_paths[i])) jobs.emplace_back(i, worker);
+    }
+    std::atomic<bool> contexts_ok{true};
+    parallel_for(jobs.size(), [&](size_t j) {
+        auto [i, worker] = jobs[j];
+        if (!worker->pre_create_context(model_paths[i])) {
+            LOG_ERROR("Failed to pre-create context for worker {}", worker->worker_id());
+            contexts_ok = false;
+        }
+    });
+
+    // context 已就绪: 释放文件映射; 零拷贝输入 tensor 池与共享权重依赖主 context, 其余情况一并释放
+    bool keep_master = config_.zero_copy || config_.model_share_weights;
+    for (size_t i = 0; i < model_paths.size(); i++) {
+        if (loaded[i]) model_mgr_.trim(model_paths[i], keep_master);
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    size_t ok_count = static_cast<size_t>(std::count(loaded.begin(), loaded.end(), 1));
+    {
+        std::lock_guard<std::mutex> lock(load_mutex_);
+        for (size_t i = 0; i < model_paths.size(); i++) {
+            model_states_[model_paths[i]] = loaded[i] ? ModelState::Ready : ModelState::Failed;
         }
+        warmup_ms_ = ms;
+    }
+    load_cv_.notify_all();
+
+    LOG_INFO("{} model(s) ready in {:.0f} ms ({} context(s), {} failed)",
+             ok_count, ms, jobs.size(), model_paths.size() - ok_count);
+    return ok_count == model_paths.size() && contexts_ok.load();
+}
+
+bool InferenceEngine::models_settled_locked(const std::vector<ModelConfig>& models) const {
+    return std::none_of(models.begin(), models.end(), [this](const ModelConfig& mc) {
+        auto it = model_states_.find(mc.model_path);
+        return it != model_states_.end() && it->second == ModelState::Loading;
+    });
+}
+
+bool InferenceEngine::load_models(const std::vector<ModelConfig>& models) {
+    bool all_ok = load_claimed(claim_models(models));
+
+    // 由其他调用 (如后台加载) 负责的模型: 等待其结束
+    std::unique_lock<std::mutex> lock(load_mutex_);
+    load_cv_.wait(lock, [&]() { return models_settled_locked(models); });
+    for (const auto& mc : models) {
+        auto it = model_states_.find(mc.model_path);
+        if (it != model_states_.end() && it->second == ModelState::Failed) all_ok = false;
     }
     return all_ok;
 }
 
+void InferenceEngine::load_models_async(const std::vector<ModelConfig>& models) {
+    auto paths = claim_models(models);
+    if (paths.empty()) return;
+
+    std::lock_guard<std::mutex> lock(load_mutex_);
+    if (loader_stop_) {
+        // 引擎已关闭: 不再加载, 等待者按失败处理
+        for (const auto& path : paths) model_states_[path] = ModelState::Failed;
+        load_cv_.notify_all();
+        return;
+    }
+    load_queue_.insert(load_queue_.end(), std::make_move_iterator(paths.begin()),
+                       std::make_move_iterator(paths.end()));
+    if (!loader_.joinable()) {
+        loader_ = std::thread(&InferenceEngine::loader_loop, this);
+    }
+    load_cv_.notify_all();
+}
+
+void InferenceEngine::loader_loop() {
+    std::unique_lock<std::mutex> lock(load_mutex_);
+    while (true) {
+        load_cv_.wait(lock, [this]() { return !load_queue_.empty() || loader_stop_; });
+        if (load_queue_.empty()) break;
+
+        // 排队期间累积的多次请求合并为一批, 共享并行加载
+        std::vector<std::string> paths;
+        paths.swap(load_queue_);
+        lock.unlock();
+        load_claimed(paths);
+        lock.lock();
+    }
+}
+
+bool InferenceEngine::models_ready(const std::vector<ModelConfig>& models) const {
+    std::lock_guard<std::mutex> lock(load_mutex_);
+    return models_settled_locked(models);
+}
+
+InferenceEngine::ModelLoadStats InferenceEngine::model_load_stats() const {
+    std::lock_guard<std::mutex> lock(load_mutex_);
+    ModelLoadStats stats;
+    for (const auto& [path, state] : model_states_) {
+        (void)path;
+        switch (state) {
+            case ModelState::Loading: stats.loading++; break;
+            case ModelState::Ready:   stats.ready++; break;
+            case ModelState::Failed:  stats.failed++; break;
+        }
+    }
+    stats.warmup_ms = warmup_ms_;
+    return stats;
+}
+
+bool InferenceEngine::unload_model(const std::string& model_path, int timeout_ms) {
+    {
+        // 正在加载的模型等待其结束, 之后再次添加引用它的流会重新加载
+        std::unique_lock<std::mutex> lock(load_mutex_);
+        load_cv_.wait(lock, [&]() {
+            auto it = model_states_.find(model_path);
+            return it == model_states_.end() || it->second != ModelState::Loading;
+        });
+        model_states_.erase(model_path);
+    }
+
+    for (auto& worker : workers_) {
+        worker->release_model(model_path);
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeout_ms, 0));
+    auto holds_context = [&]() {
+        return std::any_of(workers_.begin(), workers_.end(), [&](const std::unique_ptr<InferWorker>& w) {
+            return w->has_context(model_path);
+        });
+    };
+    while (holds_context()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            LOG_WARN("Timed out waiting for workers to release model: {}", model_path);
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    model_mgr_.unload_model(model_path);
+    if (scheduler_) scheduler_->release_model(model_path);
+    return true;
+}
+
+void InferenceEngine::join_loaders() {
+    {
+        std::lock_guard<std::mutex> lock(load_mutex_);
+        loader_stop_ = true;
+    }
+    load_cv_.notify_all();
+    if (loader_.joinable()) loader_.join();
+}
+
 bool InferenceEngine::submit(InferTask task) {
     if (!initialized_.load()) {
         LOG_WARN("InferenceEngine not initialized, dropping task");
         return false;
     }
+    if (!task.binding) {
+        LOG_WARN("InferenceEngine: task without model binding, dropping (frame {})", task.frame_id);
+        return false;
+    }
+    if (scheduler_) {
+        return scheduler_->submit(std::move(task));
+    }
     return task_queue_.push(std::move(task));
 }
 
@@ -106,8 +384,12 @@ void InferenceEngine::shutdown() {
 
     LOG_INFO("InferenceEngine shutting down...");
 
+    // 后台模型加载会访问 worker, 必须先于 worker 销毁结束
+    join_loaders();
+
     // 停止任务队列 (唤醒等待中的 worker)
     task_queue_.stop();
+    if (scheduler_) scheduler_->stop();
 
     // 停止所有工作线程
     for (auto& worker : workers_) {
@@ -115,12 +397,23 @@ void InferenceEngine::shutdown() {
     }
     workers_.clear();
 
+    // worker 已全部退出, 输出剩余结果后再关闭 ZMQ
+    dispatcher_.stop();
+
 #ifdef HAS_ZMQ
     zmq_pub_.shutdown();
 #endif
 
+    // 丢弃残留任务: 零拷贝 tensor 内存依赖主 context, 必须先于模型卸载释放
+    task_queue_.clear();
+    if (scheduler_) scheduler_->clear();
+
     // 卸载所有模型
     model_mgr_.unload_all();
+    {
+        std::lock_guard<std::mutex> lock(load_mutex_);
+        model_states_.clear();
+    }
 
     initialized_ = false;
     LOG_INFO("InferenceEngine shutdown complete");
@@ -134,7 +427,65 @@ uint64_t InferenceEngine::total_processed() const {
     return total;
 }
 
+RateMeter::Rates InferenceEngine::processed_rate() const {
+    RateMeter::Rates total;
+    for (const auto& w : workers_) {
+        total += w->processed_rate();
+    }
+    return total;
+}
+
+size_t InferenceEngine::total_contexts() const {
+    size_t total = 0;
+    for (const auto& w : workers_) {
+        total += w->context_count();
+    }
+    return total;
+}
+
+uint64_t InferenceEngine::total_batches() const {
+    uint64_t total = 0;
+    for (const auto& w : workers_) {
+        total += w->batch_count();
+    }
+    return total;
+}
+
+std::vector<InferenceEngine::WorkerStats> InferenceEngine::worker_stats() const {
+    std::vector<WorkerStats> stats;
+    stats.reserve(workers_.size());
+    for (const auto& w : workers_) {
+        WorkerStats s;
+        s.worker_id = w->worker_id();
+        s.core_mask = w->core_mask();
+        s.processed = w->processed_count();
+        s.npu_busy_us = w->npu_busy_us();
+        s.npu_utilization = w->npu_utilization();
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+double InferenceEngine::batch_fill_ratio() const {
+    uint64_t tasks = 0, slots = 0;
+    for (const auto& w : workers_) {
+        tasks += w->batched_task_count();
+        slots += w->batch_slot_count();
+    }
+    return slots > 0 ? static_cast<double>(tasks) / static_cast<double>(slots) : 0.0;
+}
+
 void InferenceEngine::on_result_complete(FrameResult result) {
+    if (result.completed_ns == 0) result.completed_ns = mono_now_ns();
+
+    // 跟踪阶段: 聚合后的整帧结果按模型分配 track_id (跟踪器内部加锁, 可在任意 worker 线程执行)
+    if (result.trackers) {
+        result.trackers->apply(result);
+    }
+    dispatcher_.post(std::move(result));
+}
+
+void InferenceEngine::output_result(const FrameResult& result) {
     // 1. ZMQ 发布
 #ifdef HAS_ZMQ
     zmq_pub_.publish(result);
@@ -144,6 +495,15 @@ void InferenceEngine::on_result_complete(FrameResult result) {
     if (result_callback_) {
         result_callback_(result);
     }
+
+    // 3. 延迟统计: 输出阶段与端到端 (只统计推理帧; 转发 / 外推的帧没有 NPU 阶段, 会拉低分位数)
+    if (result.counters && result.inferred()) {
+        int64_t now = mono_now_ns();
+        result.counters->latency.record(LatencyStage::Publish, now - result.completed_ns);
+        if (result.decoded_ns > 0) {
+            result.counters->latency.record(LatencyStage::EndToEnd, now - result.decoded_ns);
+        }
+    }
 }
 
 } // namespace infer_server
@@ -7,16 +7,28 @@
 
 #include "infer_server/inference/model_manager.h"
 #include "infer_server/common/logger.h"
-#include <fstream>
+#include "infer_server/processor/rga_scheduler.h"
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace infer_server {
 
 // ============================================================
 // ModelInfo
 // ============================================================
 
-std::vector<TensorAttr> ModelInfo::get_output_tensor_attrs() const {
+void ModelInfo::build_tensor_attrs() {
+    batch = 1;
+    if (!input_attrs.empty() && input_attrs[0].n_dims >= 4) {
+        batch = std::max(1, static_cast<int>(input_attrs[0].dims[0]));
+    }
+
     std::vector<TensorAttr> attrs;
     attrs.reserve(output_attrs.size());
 
@@ -39,7 +51,14 @@ std::vector<TensorAttr> ModelInfo::get_output_tensor_attrs() const {
         attrs.push_back(attr);
     }
 
-    return attrs;
+    sample_output_attrs = attrs;
+    if (batch > 1) {
+        for (auto& attr : sample_output_attrs) {
+            if (!attr.dims.empty()) attr.dims[0] = 1;
+            attr.n_elems /= batch;
+        }
+    }
+    output_tensor_attrs = std::move(attrs);
 }
 
 // ============================================================
@@ -50,43 +69,81 @@ ModelManager::~ModelManager() {
     unload_all();
 }
 
-bool ModelManager::load_model(const std::string& model_path) {
-    std::lock_guard<std::mutex> lock(mutex_);
+ModelManager::ModelFile::~ModelFile() {
+    if (mapped && data) {
+        munmap(data, size);
+    }
+}
 
-    // 已加载
-    if (models_.count(model_path)) {
-        LOG_DEBUG("Model already loaded: {}", model_path);
-        return true;
+std::shared_ptr<ModelManager::ModelFile> ModelManager::ModelFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open model file: {}", path);
+        return nullptr;
     }
 
-    // 读取模型文件
-    std::ifstream file(model_path, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        LOG_ERROR("Failed to open model file: {}", model_path);
-        return false;
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        LOG_ERROR("Model file is empty: {}", path);
+        ::close(fd);
+        return nullptr;
     }
 
-    auto file_size = file.tellg();
-    if (file_size <= 0) {
-        LOG_ERROR("Model file is empty: {}", model_path);
-        return false;
+    auto file = std::make_shared<ModelFile>();
+    file->size = static_cast<size_t>(st.st_size);
+
+    // 只读映射: 页面与页缓存共享, rknn_init 只读取模型数据
+    void* addr = mmap(nullptr, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+        madvise(addr, file->size, MADV_WILLNEED);
+        file->data = static_cast<uint8_t*>(addr);
+        file->mapped = true;
+    } else {
+        LOG_WARN("mmap failed for {} ({}), reading into memory", path, std::strerror(errno));
+        file->heap.resize(file->size);
+        size_t done = 0;
+        while (done < file->size) {
+            ssize_t n = ::read(fd, file->heap.data() + done, file->size - done);
+            if (n <= 0) {
+                LOG_ERROR("Failed to read model file: {}", path);
+                ::close(fd);
+                return nullptr;
+            }
+            done += static_cast<size_t>(n);
+        }
+        file->data = file->heap.data();
+    }
+    ::close(fd);
+    return file;
+}
+
+bool ModelManager::load_model(const std::string& model_path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 已加载
+        if (models_.count(model_path)) {
+            LOG_DEBUG("Model already loaded: {}", model_path);
+            return true;
+        }
     }
 
-    file.seekg(0, std::ios::beg);
-    std::vector<uint8_t> model_data(static_cast<size_t>(file_size));
-    if (!file.read(reinterpret_cast<char*>(model_data.data()), file_size)) {
-        LOG_ERROR("Failed to read model file: {}", model_path);
+    // 映射模型文件 (不持锁: 其他模型的加载 / 查询不受影响)
+    auto model_file = ModelFile::open(model_path);
+    if (!model_file) {
         return false;
     }
-    file.close();
 
-    LOG_INFO("Loading RKNN model: {} ({:.2f} MB)", model_path,
-             static_cast<double>(file_size) / (1024.0 * 1024.0));
+    LOG_INFO("Loading RKNN model: {} ({:.2f} MB{})", model_path,
+             static_cast<double>(model_file->size) / (1024.0 * 1024.0),
+             model_file->mapped ? ", mmap" : "");
 
-    // rknn_init
+    // rknn_init (与 RGA job 互斥, 避免 NPU 初始化与 RGA 并发导致硬件冲突)
     rknn_context ctx = 0;
-    int ret = rknn_init(&ctx, model_data.data(), static_cast<uint32_t>(model_data.size()),
-                        0, nullptr);
+    int ret;
+    {
+        auto npu_init = RgaScheduler::instance().begin_npu_init();
+        ret = rknn_init(&ctx, model_file->data, static_cast<uint32_t>(model_file->size), 0, nullptr);
+    }
     if (ret != RKNN_SUCC) {
         LOG_ERROR("rknn_init failed for {}: ret={}", model_path, ret);
         return false;
@@ -140,37 +197,93 @@ bool ModelManager::load_model(const std::string& model_path) {
                  output_attrs[i].zp, output_attrs[i].scale);
     }
 
+    // 内存占用 (旧版运行时不支持该查询, 统计为 0)
+    rknn_mem_size mem_size;
+    std::memset(&mem_size, 0, sizeof(mem_size));
+    if (rknn_query(ctx, RKNN_QUERY_MEM_SIZE, &mem_size, sizeof(mem_size)) == RKNN_SUCC) {
+        LOG_INFO("  Memory: weight={:.2f} MB, internal={:.2f} MB",
+                 mem_size.total_weight_size / (1024.0 * 1024.0),
+                 mem_size.total_internal_size / (1024.0 * 1024.0));
+    }
+
     // 存储
     LoadedModel loaded;
     loaded.master_ctx = ctx;
-    loaded.model_data = std::move(model_data);
+    loaded.memory.model_path = model_path;
+    loaded.memory.weight_bytes = mem_size.total_weight_size;
+    loaded.memory.internal_bytes = mem_size.total_internal_size;
+    loaded.memory.master_resident = true;
+    loaded.memory.file_mapped = model_file->mapped;
+    loaded.model_file = std::move(model_file);
     loaded.info.model_path = model_path;
     loaded.info.io_num = io_num;
     loaded.info.input_attrs = std::move(input_attrs);
     loaded.info.output_attrs = std::move(output_attrs);
+    loaded.info.build_tensor_attrs();
 
-    models_[model_path] = std::move(loaded);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (models_.count(model_path)) {
+            // 并发加载同一模型: 保留先完成的一份
+            rknn_destroy(ctx);
+            return true;
+        }
+        models_[model_path] = std::move(loaded);
+    }
     LOG_INFO("Model loaded successfully: {}", model_path);
 
     return true;
 }
 
 rknn_context ModelManager::create_worker_context(const std::string& model_path, int core_mask) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<ModelFile> model_file;
+    rknn_context weight_source = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = models_.find(model_path);
+        if (it == models_.end()) {
+            LOG_ERROR("Cannot create worker context: model not loaded: {}", model_path);
+            return 0;
+        }
+        model_file = it->second.model_file;
+        if (share_weights_) weight_source = it->second.master_ctx;
+    }
 
-    auto it = models_.find(model_path);
-    if (it == models_.end()) {
-        LOG_ERROR("Cannot create worker context: model not loaded: {}", model_path);
-        return 0;
+    // trim 之后的惰性创建 (如冷窃取): 重新映射模型文件
+    if (!model_file) {
+        model_file = ModelFile::open(model_path);
+        if (!model_file) return 0;
     }
 
     // 使用 rknn_init 为每个 worker 创建完全独立的上下文。
     // rknn_dup_context 的"轻量级副本"在多线程并发推理时会共享内部状态，
     // 导致 rknn_inputs_set / rknn_run 并发执行时出现堆内存损坏。
+    // 共享权重时同样独立 rknn_init, 只有只读的权重内存来自主 context,
+    // 中间 tensor 与输入 / 输出各自分配, 并发推理互不干扰。
+    // 在锁外执行 (持有文件映射的引用), 多个 worker / 模型的 context 可并行创建;
+    // 创建期间暂停 RGA job (惰性创建同样如此)。
     rknn_context ctx = 0;
-    int ret = rknn_init(&ctx, it->second.model_data.data(),
-                        static_cast<uint32_t>(it->second.model_data.size()),
-                        0, nullptr);
+    int ret = -1;
+    bool shared = false;
+    {
+        auto npu_init = RgaScheduler::instance().begin_npu_init();
+        if (weight_source != 0) {
+            rknn_init_extend extend;
+            std::memset(&extend, 0, sizeof(extend));
+            extend.ctx = weight_source;
+            ret = rknn_init(&ctx, model_file->data, static_cast<uint32_t>(model_file->size),
+                            RKNN_FLAG_SHARE_WEIGHT_MEM, &extend);
+            shared = ret == RKNN_SUCC;
+            if (!shared) {
+                LOG_WARN("rknn_init with shared weights failed for {}: ret={}, using private weights",
+                         model_path, ret);
+            }
+        }
+        if (!shared) {
+            ret = rknn_init(&ctx, model_file->data, static_cast<uint32_t>(model_file->size),
+                            0, nullptr);
+        }
+    }
     if (ret != RKNN_SUCC) {
         LOG_ERROR("rknn_init for worker context failed: {}: ret={}", model_path, ret);
         return 0;
@@ -185,13 +298,179 @@ rknn_context ModelManager::create_worker_context(const std::string& model_path,
         }
     }
 
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = models_.find(model_path);
+        if (it != models_.end()) {
+            it->second.memory.worker_contexts++;
+            if (shared) it->second.memory.shared_contexts++;
+        }
+        worker_contexts_[ctx] = {model_path, shared};
+    }
     return ctx;
 }
 
 void ModelManager::release_worker_context(rknn_context ctx) {
-    if (ctx != 0) {
-        rknn_destroy(ctx);
+    if (ctx == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto wc = worker_contexts_.find(ctx);
+        if (wc != worker_contexts_.end()) {
+            auto it = models_.find(wc->second.first);
+            if (it != models_.end()) {
+                it->second.memory.worker_contexts--;
+                if (wc->second.second) it->second.memory.shared_contexts--;
+            }
+            worker_contexts_.erase(wc);
+        }
     }
+    rknn_destroy(ctx);
+}
+
+void ModelManager::trim(const std::string& model_path, bool keep_master) {
+    std::shared_ptr<ModelFile> model_file;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = models_.find(model_path);
+    if (it == models_.end()) return;
+    auto& loaded = it->second;
+
+    // 文件映射在锁外释放 (进行中的 rknn_init 仍持有引用)
+    model_file = std::move(loaded.model_file);
+    loaded.memory.file_mapped = false;
+
+    if (!keep_master && loaded.master_ctx != 0 && loaded.memory.shared_contexts == 0 && !loaded.input_pool) {
+        rknn_destroy(loaded.master_ctx);
+        loaded.master_ctx = 0;
+        loaded.memory.master_resident = false;
+        LOG_INFO("Released master context of {} ({} worker context(s) remain)",
+                 model_path, loaded.memory.worker_contexts);
+    }
+}
+
+std::vector<ModelMemory> ModelManager::memory_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ModelMemory> stats;
+    stats.reserve(models_.size());
+    for (const auto& [path, loaded] : models_) {
+        (void)path;
+        stats.push_back(loaded.memory);
+    }
+    std::sort(stats.begin(), stats.end(), [](const ModelMemory& a, const ModelMemory& b) {
+        return a.model_path < b.model_path;
+    });
+    return stats;
+}
+
+ModelManager::InputPool::~InputPool() {
+    for (auto& entry : idle) {
+        rknn_destroy_mem(ctx, entry.mem);
+    }
+    if (ctx != 0) rknn_destroy(ctx);
+}
+
+std::shared_ptr<DmaBuffer> ModelManager::create_input_buffer(const std::string& model_path) {
+    std::shared_ptr<InputPool> pool;
+    int width = 0, height = 0, wstride = 0;
+    uint32_t size = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = models_.find(model_path);
+        if (it == models_.end() || it->second.info.input_attrs.empty()) {
+            LOG_ERROR("Cannot create input buffer: model not loaded: {}", model_path);
+            return nullptr;
+        }
+        if (it->second.master_ctx == 0) {
+            LOG_ERROR("Cannot create input buffer: master context released: {}", model_path);
+            return nullptr;
+        }
+
+        const rknn_tensor_attr& attr = it->second.info.input_attrs[0];
+
+        // NHWC: dims = [1, H, W, C]
+        height = static_cast<int>(attr.dims[1]);
+        width = static_cast<int>(attr.dims[2]);
+        wstride = attr.w_stride > 0 ? static_cast<int>(attr.w_stride) : width;
+        size = attr.size_with_stride > 0
+            ? attr.size_with_stride
+            : static_cast<uint32_t>(wstride) * height * 3;
+
+        if (!it->second.input_pool) {
+            it->second.input_pool = std::make_shared<InputPool>();
+            it->second.input_pool->ctx = it->second.master_ctx;
+        }
+        pool = it->second.input_pool;
+    }
+
+    rknn_tensor_mem* mem = nullptr;
+    uint64_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (!pool->idle.empty()) {
+            mem = pool->idle.back().mem;
+            id = pool->idle.back().id;
+            pool->idle.pop_back();
+            pool->stats.hits++;
+            pool->stats.bytes_idle -= mem->size;
+            pool->stats.idle_buffers--;
+        }
+    }
+
+    if (!mem) {
+        mem = rknn_create_mem(pool->ctx, size);
+        if (!mem) {
+            LOG_ERROR("rknn_create_mem({}) failed for {}", size, model_path);
+            return nullptr;
+        }
+        id = next_input_id_.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stats.misses++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stats.bytes_in_use += mem->size;
+    }
+
+    auto buf = std::make_shared<DmaBuffer>();
+    buf->fd = mem->fd;
+    buf->virt_addr = mem->virt_addr;
+    buf->size = mem->size;
+    buf->width = width;
+    buf->height = height;
+    buf->wstride = wstride;
+    buf->hstride = height;
+    buf->id = id;
+
+    // 强引用: 模型卸载后池 (及主 context) 保留到最后一个 tensor 归还, 由池析构统一销毁
+    buf->holder = std::shared_ptr<rknn_tensor_mem>(mem, [p = pool, id](rknn_tensor_mem* m) {
+        std::lock_guard<std::mutex> lock(p->mutex);
+        p->stats.bytes_in_use -= m->size;
+        if (p->idle.size() >= kMaxIdleInputs) {
+            rknn_destroy_mem(p->ctx, m);
+            return;
+        }
+        p->idle.push_back({m, id});
+        p->stats.bytes_idle += m->size;
+        p->stats.idle_buffers++;
+    });
+    return buf;
+}
+
+BufferPool::Stats ModelManager::input_pool_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    BufferPool::Stats total;
+    for (const auto& [path, loaded] : models_) {
+        if (!loaded.input_pool) continue;
+        std::lock_guard<std::mutex> pool_lock(loaded.input_pool->mutex);
+        const auto& st = loaded.input_pool->stats;
+        total.hits += st.hits;
+        total.misses += st.misses;
+        total.bytes_in_use += st.bytes_in_use;
+        total.bytes_idle += st.bytes_idle;
+        total.idle_buffers += st.idle_buffers;
+    }
+    return total;
 }
 
 const ModelInfo* ModelManager::get_model_info(const std::string& model_path) const {
@@ -206,13 +485,23 @@ bool ModelManager::is_loaded(const std::string& model_path) const {
     return models_.count(model_path) > 0;
 }
 
+void ModelManager::release_master(LoadedModel& loaded) {
+    if (loaded.input_pool) {
+        // 主 context 归池所有: 仍有在途 tensor 时, 池在其全部归还后销毁 tensor 与 context
+        loaded.input_pool.reset();
+    } else if (loaded.master_ctx != 0) {
+        rknn_destroy(loaded.master_ctx);
+    }
+    loaded.master_ctx = 0;
+}
+
 void ModelManager::unload_model(const std::string& model_path) {
     std::lock_guard<std::mutex> lock(mutex_);
     auto it = models_.find(model_path);
     if (it == models_.end()) return;
 
     LOG_INFO("Unloading model: {}", model_path);
-    rknn_destroy(it->second.master_ctx);
+    release_master(it->second);
     models_.erase(it);
 }
 
@@ -220,7 +509,7 @@ void ModelManager::unload_all() {
     std::lock_guard<std::mutex> lock(mutex_);
     for (auto& [path, loaded] : models_) {
         LOG_INFO("Unloading model: {}", path);
-        rknn_destroy(loaded.master_ctx);
+        release_master(loaded);
     }
     models_.clear();
 }
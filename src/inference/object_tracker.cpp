@@ -0,0 +1,235 @@
+/**
+ * @file object_tracker.cpp
+ * @brief 轻量多目标跟踪实现
+ */
+
+#include "infer_server/inference/object_tracker.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace infer_server {
+
+namespace {
+
+// α-β 滤波增益: 位置以检测为主 (检测框本身较准), 速度缓慢修正以抑制抖动
+constexpr float kPositionGain = 0.85f;
+constexpr float kVelocityGain = 0.3f;
+
+} // namespace
+
+// ============================================================
+// ObjectTracker
+// ============================================================
+
+ObjectTracker::ObjectTracker(const Options& options)
+    : options_(options)
+{
+    options_.max_age_ms = std::max(options_.max_age_ms, 0);
+}
+
+float ObjectTracker::iou(const BBox& a, const BBox& b) {
+    float ix = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+    float iy = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+    if (ix <= 0.0f || iy <= 0.0f) return 0.0f;
+    float inter = ix * iy;
+    float uni = (a.x2 - a.x1) * (a.y2 - a.y1) + (b.x2 - b.x1) * (b.y2 - b.y1) - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+BBox ObjectTracker::Track::box_at(int64_t timestamp_ms) const {
+    float dt = static_cast<float>(timestamp_ms - last_ms);
+    float pcx = cx + vx * dt;
+    float pcy = cy + vy * dt;
+    float pw = std::max(w + vw * dt, 1.0f);
+    float ph = std::max(h + vh * dt, 1.0f);
+    BBox box;
+    box.x1 = pcx - pw * 0.5f;
+    box.y1 = pcy - ph * 0.5f;
+    box.x2 = pcx + pw * 0.5f;
+    box.y2 = pcy + ph * 0.5f;
+    return box;
+}
+
+void ObjectTracker::associate(const std::vector<Detection>& detections,
+                              const std::vector<size_t>& candidates,
+                              const std::vector<BBox>& predicted,
+                              std::vector<int>& det_track,
+                              std::vector<bool>& track_used) const {
+    // (IoU, 检测下标, 轨迹下标); 目标数通常只有几个到几十个, 贪心即可
+    std::vector<std::tuple<float, size_t, size_t>> pairs;
+    for (size_t d : candidates) {
+        for (size_t t = 0; t < predicted.size(); t++) {
+            if (track_used[t] || tracks_[t].class_id != detections[d].class_id) continue;
+            float overlap = iou(detections[d].bbox, predicted[t]);
+            if (overlap >= options_.iou_threshold) {
+                pairs.emplace_back(overlap, d, t);
+            }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) {
+        return std::get<0>(a) > std::get<0>(b);
+    });
+    for (const auto& [overlap, d, t] : pairs) {
+        (void)overlap;
+        if (det_track[d] >= 0 || track_used[t]) continue;
+        det_track[d] = static_cast<int>(t);
+        track_used[t] = true;
+    }
+}
+
+void ObjectTracker::correct(Track& track, const Detection& det, int64_t timestamp_ms) {
+    float mcx = (det.bbox.x1 + det.bbox.x2) * 0.5f;
+    float mcy = (det.bbox.y1 + det.bbox.y2) * 0.5f;
+    float mw = det.bbox.x2 - det.bbox.x1;
+    float mh = det.bbox.y2 - det.bbox.y1;
+    float dt = static_cast<float>(timestamp_ms - track.last_ms);
+
+    if (dt > 0.0f && track.hits == 1) {
+        // 第二次观测: 直接用两次位置差初始化速度
+        track.vx = (mcx - track.cx) / dt;
+        track.vy = (mcy - track.cy) / dt;
+        track.vw = (mw - track.w) / dt;
+        track.vh = (mh - track.h) / dt;
+        track.cx = mcx; track.cy = mcy; track.w = mw; track.h = mh;
+    } else if (dt > 0.0f) {
+        float pcx = track.cx + track.vx * dt;
+        float pcy = track.cy + track.vy * dt;
+        float pw = track.w + track.vw * dt;
+        float ph = track.h + track.vh * dt;
+        float rx = mcx - pcx, ry = mcy - pcy, rw = mw - pw, rh = mh - ph;
+        track.cx = pcx + kPositionGain * rx;
+        track.cy = pcy + kPositionGain * ry;
+        track.w = pw + kPositionGain * rw;
+        track.h = ph + kPositionGain * rh;
+        track.vx += kVelocityGain * rx / dt;
+        track.vy += kVelocityGain * ry / dt;
+        track.vw += kVelocityGain * rw / dt;
+        track.vh += kVelocityGain * rh / dt;
+    } else {
+        track.cx = mcx; track.cy = mcy; track.w = mw; track.h = mh;
+    }
+
+    track.confidence = det.confidence;
+    track.class_name = det.class_name;
+    track.last_ms = timestamp_ms;
+    track.hits++;
+}
+
+std::vector<Detection> ObjectTracker::update(std::vector<Detection> detections, int64_t timestamp_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<BBox> predicted;
+    predicted.reserve(tracks_.size());
+    for (const auto& track : tracks_) {
+        predicted.push_back(track.box_at(timestamp_ms));
+    }
+
+    std::vector<size_t> high, low;
+    for (size_t i = 0; i < detections.size(); i++) {
+        (detections[i].confidence >= options_.high_threshold ? high : low).push_back(i);
+    }
+
+    // 第一轮: 高分检测; 第二轮: 低分检测只与剩余轨迹关联
+    std::vector<int> det_track(detections.size(), -1);
+    std::vector<bool> track_used(tracks_.size(), false);
+    associate(detections, high, predicted, det_track, track_used);
+    associate(detections, low, predicted, det_track, track_used);
+
+    // 乱序到达的旧帧: 只分配 ID, 不用旧观测回退轨迹状态
+    bool stale = timestamp_ms < last_update_ms_;
+
+    for (size_t i = 0; i < detections.size(); i++) {
+        auto& det = detections[i];
+        if (det_track[i] >= 0) {
+            auto& track = tracks_[static_cast<size_t>(det_track[i])];
+            if (!stale) correct(track, det, timestamp_ms);
+            det.track_id = track.id;
+        } else if (!stale && det.confidence >= options_.high_threshold) {
+            Track track;
+            track.id = next_id_++;
+            track.class_id = det.class_id;
+            track.class_name = det.class_name;
+            track.confidence = det.confidence;
+            track.cx = (det.bbox.x1 + det.bbox.x2) * 0.5f;
+            track.cy = (det.bbox.y1 + det.bbox.y2) * 0.5f;
+            track.w = det.bbox.x2 - det.bbox.x1;
+            track.h = det.bbox.y2 - det.bbox.y1;
+            track.last_ms = timestamp_ms;
+            track.hits = 1;
+            det.track_id = track.id;
+            tracks_.push_back(std::move(track));
+        }
+    }
+
+    if (!stale) {
+        last_update_ms_ = timestamp_ms;
+        int64_t max_age = options_.max_age_ms;
+        tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(), [&](const Track& t) {
+            return timestamp_ms - t.last_ms > max_age;
+        }), tracks_.end());
+    }
+    return detections;
+}
+
+std::vector<Detection> ObjectTracker::predict(int64_t timestamp_ms, int frame_w, int frame_h) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<Detection> out;
+    out.reserve(tracks_.size());
+    for (const auto& track : tracks_) {
+        if (timestamp_ms - track.last_ms > options_.max_age_ms) continue;
+
+        Detection det;
+        det.class_id = track.class_id;
+        det.class_name = track.class_name;
+        det.confidence = track.confidence;
+        det.track_id = track.id;
+        det.bbox = track.box_at(timestamp_ms);
+        if (frame_w > 0 && frame_h > 0) {
+            det.bbox.x1 = std::clamp(det.bbox.x1, 0.0f, static_cast<float>(frame_w));
+            det.bbox.x2 = std::clamp(det.bbox.x2, 0.0f, static_cast<float>(frame_w));
+            det.bbox.y1 = std::clamp(det.bbox.y1, 0.0f, static_cast<float>(frame_h));
+            det.bbox.y2 = std::clamp(det.bbox.y2, 0.0f, static_cast<float>(frame_h));
+            // 已移出画面
+            if (det.bbox.x2 <= det.bbox.x1 || det.bbox.y2 <= det.bbox.y1) continue;
+        }
+        out.push_back(std::move(det));
+    }
+    // 与推理结果一致: 按置信度降序
+    std::stable_sort(out.begin(), out.end(), [](const Detection& a, const Detection& b) {
+        return a.confidence > b.confidence;
+    });
+    return out;
+}
+
+size_t ObjectTracker::track_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tracks_.size();
+}
+
+// ============================================================
+// StreamTrackers
+// ============================================================
+
+void StreamTrackers::add(const std::string& task_name, const ObjectTracker::Options& options) {
+    trackers_[task_name] = std::make_unique<ObjectTracker>(options);
+}
+
+ObjectTracker* StreamTrackers::find(const std::string& task_name) const {
+    auto it = trackers_.find(task_name);
+    return it != trackers_.end() ? it->second.get() : nullptr;
+}
+
+void StreamTrackers::apply(FrameResult& result) const {
+    // 运动门控转发的结果已带 track_id
+    if (result.repeated) return;
+    for (auto& mr : result.results) {
+        if (mr.predicted) continue;
+        auto* tracker = find(mr.task_name);
+        if (!tracker) continue;
+        mr.detections = tracker->update(std::move(mr.detections), result.timestamp_ms);
+    }
+}
+
+} // namespace infer_server
@@ -0,0 +1,459 @@
+/**
+ * @file post_kernels.cpp
+ * @brief YOLO 后处理计算内核实现
+ */
+
+#include "infer_server/inference/post_kernels.h"
+
+#include <cfloat>
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define INFER_SERVER_POST_NEON 1
+#endif
+
+#if defined(INFER_SERVER_POST_NEON) && !defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace infer_server {
+
+const char* post_kernel_name(PostProcessKernel kernel) {
+    switch (kernel) {
+        case PostProcessKernel::REFERENCE: return "reference";
+        case PostProcessKernel::PORTABLE:  return "portable";
+        case PostProcessKernel::NEON:      return "neon";
+    }
+    return "unknown";
+}
+
+namespace post_kernels {
+
+namespace {
+
+constexpr int kDflBins = 16;
+
+// ============================================================
+// 便携实现
+// ============================================================
+
+float argmax_portable(const float* data, int n, int* index) {
+    // 更新极少发生 (最大值很快稳定), 分支预测几乎总是命中, 顺序扫描即可
+    float best = data[0];
+    int best_idx = 0;
+    for (int i = 1; i < n; i++) {
+        if (data[i] > best) {
+            best = data[i];
+            best_idx = i;
+        }
+    }
+    *index = best_idx;
+    return best;
+}
+
+void column_argmax_portable(const float* data, int rows, int stride, int count,
+                            float* best, int* index) {
+    // 与 NEON 版本相同的寄存器分块: 一次 4 列, 逐行向下扫描, 最大值/下标保存在局部变量
+    int j = 0;
+    for (; j + 4 <= count; j += 4) {
+        float b0 = best[j], b1 = best[j + 1], b2 = best[j + 2], b3 = best[j + 3];
+        int i0 = index[j], i1 = index[j + 1], i2 = index[j + 2], i3 = index[j + 3];
+        const float* col = data + j;
+        for (int c = 0; c < rows; c++, col += stride) {
+            if (col[0] > b0) { b0 = col[0]; i0 = c; }
+            if (col[1] > b1) { b1 = col[1]; i1 = c; }
+            if (col[2] > b2) { b2 = col[2]; i2 = c; }
+            if (col[3] > b3) { b3 = col[3]; i3 = c; }
+        }
+        best[j] = b0; best[j + 1] = b1; best[j + 2] = b2; best[j + 3] = b3;
+        index[j] = i0; index[j + 1] = i1; index[j + 2] = i2; index[j + 3] = i3;
+    }
+    for (; j < count; j++) {
+        const float* col = data + j;
+        for (int c = 0; c < rows; c++, col += stride) {
+            if (*col > best[j]) { best[j] = *col; index[j] = c; }
+        }
+    }
+}
+
+float dfl16_portable(const float* data) {
+    float max_val = data[0];
+    for (int i = 1; i < kDflBins; i++) {
+        max_val = std::max(max_val, data[i]);
+    }
+
+    float sum = 0.0f;
+    float weighted = 0.0f;
+    for (int i = 0; i < kDflBins; i++) {
+        float e = fast_exp(data[i] - max_val);
+        sum += e;
+        weighted += e * static_cast<float>(i);
+    }
+    return weighted / sum;
+}
+
+int8_t argmax_i8_portable(const int8_t* data, int n, int* index) {
+    int8_t best = data[0];
+    int best_idx = 0;
+    for (int i = 1; i < n; i++) {
+        if (data[i] > best) {
+            best = data[i];
+            best_idx = i;
+        }
+    }
+    *index = best_idx;
+    return best;
+}
+
+void column_argmax_i8_portable(const int8_t* data, int rows, int stride, int count,
+                               int8_t* best, int* index) {
+    int j = 0;
+    for (; j + 4 <= count; j += 4) {
+        int8_t b0 = best[j], b1 = best[j + 1], b2 = best[j + 2], b3 = best[j + 3];
+        int i0 = index[j], i1 = index[j + 1], i2 = index[j + 2], i3 = index[j + 3];
+        const int8_t* col = data + j;
+        for (int c = 0; c < rows; c++, col += stride) {
+            if (col[0] > b0) { b0 = col[0]; i0 = c; }
+            if (col[1] > b1) { b1 = col[1]; i1 = c; }
+            if (col[2] > b2) { b2 = col[2]; i2 = c; }
+            if (col[3] > b3) { b3 = col[3]; i3 = c; }
+        }
+        best[j] = b0; best[j + 1] = b1; best[j + 2] = b2; best[j + 3] = b3;
+        index[j] = i0; index[j + 1] = i1; index[j + 2] = i2; index[j + 3] = i3;
+    }
+    for (; j < count; j++) {
+        const int8_t* col = data + j;
+        for (int c = 0; c < rows; c++, col += stride) {
+            if (*col > best[j]) { best[j] = *col; index[j] = c; }
+        }
+    }
+}
+
+void suppress_portable(const BoxSoA& b, int keep, int begin, int end,
+                       float threshold, uint8_t* suppressed) {
+    const float kx1 = b.x1[keep], ky1 = b.y1[keep];
+    const float kx2 = b.x2[keep], ky2 = b.y2[keep];
+    const float karea = b.area[keep];
+    for (int j = begin; j < end; j++) {
+        if (suppressed[j]) continue;
+        // 提前退出: 无水平 / 垂直重叠
+        float iw = std::min(kx2, b.x2[j]) - std::max(kx1, b.x1[j]);
+        if (iw <= 0.0f) continue;
+        float ih = std::min(ky2, b.y2[j]) - std::max(ky1, b.y1[j]);
+        if (ih <= 0.0f) continue;
+        float inter = iw * ih;
+        float uni = karea + b.area[j] - inter;
+        if (uni > 0.0f && inter > threshold * uni) suppressed[j] = 1;
+    }
+}
+
+// ============================================================
+// NEON 实现
+// ============================================================
+
+#ifdef INFER_SERVER_POST_NEON
+
+inline float hmax_f32(float32x4_t v) {
+#if defined(__aarch64__)
+    return vmaxvq_f32(v);
+#else
+    float32x2_t m = vpmax_f32(vget_low_f32(v), vget_high_f32(v));
+    m = vpmax_f32(m, m);
+    return vget_lane_f32(m, 0);
+#endif
+}
+
+inline float hsum_f32(float32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    s = vpadd_f32(s, s);
+    return vget_lane_f32(s, 0);
+#endif
+}
+
+/// 4 路 fast_exp, 与标量版本公式一致
+inline float32x4_t exp_f32x4(float32x4_t x) {
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    x = vminq_f32(x, vdupq_n_f32(88.0f));
+    x = vmaxq_f32(x, vdupq_n_f32(-87.3f));
+
+    // fx = floor(x * log2(e) + 0.5)
+    float32x4_t fx = vmlaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(1.44269504088896341f));
+    float32x4_t t = vcvtq_f32_s32(vcvtq_s32_f32(fx));
+    uint32x4_t gt = vandq_u32(vcgtq_f32(t, fx), vreinterpretq_u32_f32(one));
+    fx = vsubq_f32(t, vreinterpretq_f32_u32(gt));
+
+    x = vmlsq_f32(x, fx, vdupq_n_f32(0.693359375f));
+    x = vmlsq_f32(x, fx, vdupq_n_f32(-2.12194440e-4f));
+
+    float32x4_t z = vmulq_f32(x, x);
+    float32x4_t y = vdupq_n_f32(1.9875691500e-4f);
+    y = vmlaq_f32(vdupq_n_f32(1.3981999507e-3f), y, x);
+    y = vmlaq_f32(vdupq_n_f32(8.3334519073e-3f), y, x);
+    y = vmlaq_f32(vdupq_n_f32(4.1665795894e-2f), y, x);
+    y = vmlaq_f32(vdupq_n_f32(1.6666665459e-1f), y, x);
+    y = vmlaq_f32(vdupq_n_f32(5.0000001201e-1f), y, x);
+    y = vmlaq_f32(x, y, z);
+    y = vaddq_f32(y, one);
+
+    int32x4_t e = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(fx), vdupq_n_s32(127)), 23);
+    return vmulq_f32(y, vreinterpretq_f32_s32(e));
+}
+
+float argmax_neon(const float* data, int n, int* index) {
+    if (n < 8) return argmax_portable(data, n, index);
+
+    // 每条 lane 维护各自的最大值与下标 (严格大于, lane 内保留首次出现)
+    float32x4_t best = vld1q_f32(data);
+    int32x4_t best_idx = {0, 1, 2, 3};
+    int32x4_t idx = best_idx;
+    const int32x4_t step = vdupq_n_s32(4);
+
+    int i = 4;
+    for (; i + 4 <= n; i += 4) {
+        idx = vaddq_s32(idx, step);
+        float32x4_t v = vld1q_f32(data + i);
+        uint32x4_t gt = vcgtq_f32(v, best);
+        best = vbslq_f32(gt, v, best);
+        best_idx = vbslq_s32(gt, idx, best_idx);
+    }
+
+    // lane 归约: 最大值相同时取最小下标, 与顺序扫描结果一致
+    float max_val = hmax_f32(best);
+    float lanes[4];
+    int32_t lane_idx[4];
+    vst1q_f32(lanes, best);
+    vst1q_s32(lane_idx, best_idx);
+    int best_i = n;
+    for (int l = 0; l < 4; l++) {
+        if (lanes[l] == max_val && lane_idx[l] < best_i) best_i = lane_idx[l];
+    }
+
+    for (; i < n; i++) {
+        if (data[i] > max_val) {
+            max_val = data[i];
+            best_i = i;
+        }
+    }
+    *index = best_i;
+    return max_val;
+}
+
+void column_argmax_neon(const float* data, int rows, int stride, int count,
+                        float* best, int* index) {
+    int j = 0;
+    for (; j + 4 <= count; j += 4) {
+        float32x4_t b = vld1q_f32(best + j);
+        int32x4_t bi = vld1q_s32(index + j);
+        for (int c = 0; c < rows; c++) {
+            float32x4_t v = vld1q_f32(data + static_cast<size_t>(c) * stride + j);
+            uint32x4_t gt = vcgtq_f32(v, b);
+            b = vbslq_f32(gt, v, b);
+            bi = vbslq_s32(gt, vdupq_n_s32(c), bi);
+        }
+        vst1q_f32(best + j, b);
+        vst1q_s32(index + j, bi);
+    }
+    if (j < count) {
+        column_argmax_portable(data + j, rows, stride, count - j, best + j, index + j);
+    }
+}
+
+float dfl16_neon(const float* data) {
+    float32x4_t v0 = vld1q_f32(data);
+    float32x4_t v1 = vld1q_f32(data + 4);
+    float32x4_t v2 = vld1q_f32(data + 8);
+    float32x4_t v3 = vld1q_f32(data + 12);
+
+    float32x4_t m = vmaxq_f32(vmaxq_f32(v0, v1), vmaxq_f32(v2, v3));
+    float32x4_t max_val = vdupq_n_f32(hmax_f32(m));
+
+    float32x4_t e0 = exp_f32x4(vsubq_f32(v0, max_val));
+    float32x4_t e1 = exp_f32x4(vsubq_f32(v1, max_val));
+    float32x4_t e2 = exp_f32x4(vsubq_f32(v2, max_val));
+    float32x4_t e3 = exp_f32x4(vsubq_f32(v3, max_val));
+
+    const float32x4_t w0 = {0.0f, 1.0f, 2.0f, 3.0f};
+    const float32x4_t w1 = {4.0f, 5.0f, 6.0f, 7.0f};
+    const float32x4_t w2 = {8.0f, 9.0f, 10.0f, 11.0f};
+    const float32x4_t w3 = {12.0f, 13.0f, 14.0f, 15.0f};
+
+    float32x4_t sum = vaddq_f32(vaddq_f32(e0, e1), vaddq_f32(e2, e3));
+    float32x4_t weighted = vmulq_f32(e0, w0);
+    weighted = vmlaq_f32(weighted, e1, w1);
+    weighted = vmlaq_f32(weighted, e2, w2);
+    weighted = vmlaq_f32(weighted, e3, w3);
+
+    return hsum_f32(weighted) / hsum_f32(sum);
+}
+
+inline int8_t hmax_s8(int8x16_t v) {
+#if defined(__aarch64__)
+    return vmaxvq_s8(v);
+#else
+    int8x8_t m = vpmax_s8(vget_low_s8(v), vget_high_s8(v));
+    m = vpmax_s8(m, m);
+    m = vpmax_s8(m, m);
+    m = vpmax_s8(m, m);
+    return vget_lane_s8(m, 0);
+#endif
+}
+
+int8_t argmax_i8_neon(const int8_t* data, int n, int* index) {
+    // 下标以 uint8 lane 保存, 超过 256 个元素时退回便携实现
+    if (n < 32 || n > 256) return argmax_i8_portable(data, n, index);
+
+    static const uint8_t kLaneIdx[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    int8x16_t best = vld1q_s8(data);
+    uint8x16_t best_idx = vld1q_u8(kLaneIdx);
+    uint8x16_t idx = best_idx;
+    const uint8x16_t step = vdupq_n_u8(16);
+
+    int i = 16;
+    for (; i + 16 <= n; i += 16) {
+        idx = vaddq_u8(idx, step);
+        int8x16_t v = vld1q_s8(data + i);
+        uint8x16_t gt = vcgtq_s8(v, best);
+        best = vbslq_s8(gt, v, best);
+        best_idx = vbslq_u8(gt, idx, best_idx);
+    }
+
+    int8_t max_val = hmax_s8(best);
+    int8_t lanes[16];
+    uint8_t lane_idx[16];
+    vst1q_s8(lanes, best);
+    vst1q_u8(lane_idx, best_idx);
+    int best_i = n;
+    for (int l = 0; l < 16; l++) {
+        if (lanes[l] == max_val && lane_idx[l] < best_i) best_i = lane_idx[l];
+    }
+
+    for (; i < n; i++) {
+        if (data[i] > max_val) {
+            max_val = data[i];
+            best_i = i;
+        }
+    }
+    *index = best_i;
+    return max_val;
+}
+
+void column_argmax_i8_neon(const int8_t* data, int rows, int stride, int count,
+                           int8_t* best, int* index) {
+    // 行号以 uint8 lane 保存 (255 表示沿用调用方初值)
+    if (rows > 255) {
+        column_argmax_i8_portable(data, rows, stride, count, best, index);
+        return;
+    }
+
+    int j = 0;
+    for (; j + 16 <= count; j += 16) {
+        int8x16_t b = vld1q_s8(best + j);
+        uint8x16_t bi = vdupq_n_u8(255);
+        for (int c = 0; c < rows; c++) {
+            int8x16_t v = vld1q_s8(data + static_cast<size_t>(c) * stride + j);
+            uint8x16_t gt = vcgtq_s8(v, b);
+            b = vbslq_s8(gt, v, b);
+            bi = vbslq_u8(gt, vdupq_n_u8(static_cast<uint8_t>(c)), bi);
+        }
+        uint8_t rows_idx[16];
+        vst1q_s8(best + j, b);
+        vst1q_u8(rows_idx, bi);
+        for (int l = 0; l < 16; l++) {
+            if (rows_idx[l] != 255) index[j + l] = rows_idx[l];
+        }
+    }
+    if (j < count) {
+        column_argmax_i8_portable(data + j, rows, stride, count - j, best + j, index + j);
+    }
+}
+
+void suppress_neon(const BoxSoA& b, int keep, int begin, int end,
+                   float threshold, uint8_t* suppressed) {
+    const float32x4_t kx1 = vdupq_n_f32(b.x1[keep]);
+    const float32x4_t ky1 = vdupq_n_f32(b.y1[keep]);
+    const float32x4_t kx2 = vdupq_n_f32(b.x2[keep]);
+    const float32x4_t ky2 = vdupq_n_f32(b.y2[keep]);
+    const float32x4_t karea = vdupq_n_f32(b.area[keep]);
+    const float32x4_t thresh = vdupq_n_f32(threshold);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+
+    int j = begin;
+    for (; j + 4 <= end; j += 4) {
+        float32x4_t iw = vsubq_f32(vminq_f32(kx2, vld1q_f32(b.x2 + j)),
+                                   vmaxq_f32(kx1, vld1q_f32(b.x1 + j)));
+        float32x4_t ih = vsubq_f32(vminq_f32(ky2, vld1q_f32(b.y2 + j)),
+                                   vmaxq_f32(ky1, vld1q_f32(b.y1 + j)));
+        float32x4_t inter = vmulq_f32(vmaxq_f32(iw, zero), vmaxq_f32(ih, zero));
+        float32x4_t uni = vsubq_f32(vaddq_f32(karea, vld1q_f32(b.area + j)), inter);
+        uint32x4_t hit = vandq_u32(vcgtq_f32(uni, zero),
+                                   vcgtq_f32(inter, vmulq_f32(thresh, uni)));
+        // 为 0 时 (常见情况) 整组跳过写回
+#if defined(__aarch64__)
+        if (vmaxvq_u32(hit) == 0) continue;
+#else
+        uint32x2_t h2 = vorr_u32(vget_low_u32(hit), vget_high_u32(hit));
+        if ((vget_lane_u32(h2, 0) | vget_lane_u32(h2, 1)) == 0) continue;
+#endif
+        uint32_t lanes[4];
+        vst1q_u32(lanes, hit);
+        for (int l = 0; l < 4; l++) {
+            if (lanes[l]) suppressed[j + l] = 1;
+        }
+    }
+    if (j < end) {
+        suppress_portable(b, keep, j, end, threshold, suppressed);
+    }
+}
+
+const KernelTable kNeonTable = {argmax_neon, column_argmax_neon, dfl16_neon,
+                                argmax_i8_neon, column_argmax_i8_neon, suppress_neon};
+
+#endif // INFER_SERVER_POST_NEON
+
+const KernelTable kPortableTable = {argmax_portable, column_argmax_portable, dfl16_portable,
+                                    argmax_i8_portable, column_argmax_i8_portable,
+                                    suppress_portable};
+
+} // namespace
+
+bool neon_available() {
+#if defined(INFER_SERVER_POST_NEON) && defined(__aarch64__)
+    return true;  // AArch64 必备 AdvSIMD
+#elif defined(INFER_SERVER_POST_NEON) && defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+    return false;
+#endif
+}
+
+const KernelTable& table(PostProcessKernel kernel) {
+#ifdef INFER_SERVER_POST_NEON
+    if (kernel == PostProcessKernel::NEON && neon_available()) {
+        return kNeonTable;
+    }
+#else
+    (void)kernel;
+#endif
+    return kPortableTable;
+}
+
+float sigmoid_threshold_logit(float t) {
+    if (!(t > 0.0f && t < 1.0f)) return -FLT_MAX;
+    return std::log(t / (1.0f - t));
+}
+
+int quantize_threshold(float value, int32_t zp, float scale) {
+    if (!(scale > 0.0f)) return -128;
+    // q >= value / scale + zp 才可能通过; 减去余量抵消浮点舍入
+    double q = std::ceil(static_cast<double>(value) / scale + zp - 1e-3);
+    if (q <= -128.0) return -128;
+    if (q >= 128.0) return 128;
+    return static_cast<int>(q);
+}
+
+} // namespace post_kernels
+} // namespace infer_server
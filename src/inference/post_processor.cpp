@@ -12,9 +12,57 @@
 #include <cmath>
 #include <numeric>
 #include <cassert>
+#include <atomic>
 
 namespace infer_server {
 
+namespace {
+/// 当前内核 (-1 = 未设置, 使用 default_kernel())
+std::atomic<int> g_post_kernel{-1};
+
+/// logit 预过滤余量: 预过滤只用于跳过明显低于阈值的 anchor, 边界附近交给精确比较
+constexpr float kLogitMargin = 1e-3f;
+} // namespace
+
+// ============================================================
+// 内核选择
+// ============================================================
+
+PostProcessKernel PostProcessor::best_kernel() {
+    return post_kernels::neon_available() ? PostProcessKernel::NEON
+                                          : PostProcessKernel::PORTABLE;
+}
+
+PostProcessKernel PostProcessor::default_kernel() {
+    // NEON 内核只能在 AArch64 设备上编译验证, 默认使用已与 REFERENCE 比对过的便携实现,
+    // 由配置 post_kernel = "neon" 显式启用
+    return PostProcessKernel::PORTABLE;
+}
+
+bool PostProcessor::parse_kernel(const std::string& name, PostProcessKernel& kernel) {
+    for (auto k : {PostProcessKernel::REFERENCE, PostProcessKernel::PORTABLE, PostProcessKernel::NEON}) {
+        if (name == post_kernel_name(k)) {
+            kernel = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PostProcessor::set_kernel(PostProcessKernel kernel) {
+    if (kernel == PostProcessKernel::NEON && !post_kernels::neon_available()) {
+        LOG_WARN("PostProcessor: NEON not available, falling back to {}",
+                 post_kernel_name(best_kernel()));
+        kernel = best_kernel();
+    }
+    g_post_kernel.store(static_cast<int>(kernel), std::memory_order_relaxed);
+}
+
+PostProcessKernel PostProcessor::kernel() {
+    int k = g_post_kernel.load(std::memory_order_relaxed);
+    return k < 0 ? default_kernel() : static_cast<PostProcessKernel>(k);
+}
+
 // ============================================================
 // 工具函数
 // ============================================================
@@ -96,6 +144,16 @@ void PostProcessor::scale_coords(std::vector<Detection>& dets,
 // ============================================================
 
 void PostProcessor::nms(std::vector<Detection>& detections, float threshold) {
+    PostProcessKernel k = kernel();
+    // 负阈值下参考实现会抑制不相交的框, 该语义只保留在参考实现中
+    if (k == PostProcessKernel::REFERENCE || threshold < 0.0f) {
+        nms_reference(detections, threshold);
+    } else {
+        nms_fast(detections, threshold, post_kernels::table(k));
+    }
+}
+
+void PostProcessor::nms_reference(std::vector<Detection>& detections, float threshold) {
     if (detections.empty()) return;
 
     // 按置信度降序排序
@@ -126,6 +184,81 @@ void PostProcessor::nms(std::vector<Detection>& detections, float threshold) {
     detections = std::move(result);
 }
 
+void PostProcessor::nms_fast(std::vector<Detection>& detections, float threshold,
+                             const post_kernels::KernelTable& kt) {
+    const size_t n = detections.size();
+    if (n == 0) return;
+
+    // 每线程复用的工作区, 避免每帧分配
+    struct Scratch {
+        std::vector<uint32_t> order;      ///< 按置信度降序的下标
+        std::vector<uint32_t> bucketed;   ///< 按 (类别, 置信度降序) 的下标
+        std::vector<float> x1, y1, x2, y2, area;
+        std::vector<uint8_t> suppressed;  ///< bucketed 顺序
+        std::vector<uint8_t> removed;     ///< detections 下标顺序
+    };
+    thread_local Scratch s;
+
+    s.order.resize(n);
+    std::iota(s.order.begin(), s.order.end(), 0u);
+    std::stable_sort(s.order.begin(), s.order.end(), [&](uint32_t a, uint32_t b) {
+        return detections[a].confidence > detections[b].confidence;
+    });
+
+    // 按类别分桶: 稳定排序保持桶内置信度顺序, 同类检查移出 O(n^2) 内层循环
+    s.bucketed = s.order;
+    std::stable_sort(s.bucketed.begin(), s.bucketed.end(), [&](uint32_t a, uint32_t b) {
+        return detections[a].class_id < detections[b].class_id;
+    });
+
+    s.x1.resize(n); s.y1.resize(n); s.x2.resize(n); s.y2.resize(n); s.area.resize(n);
+    for (size_t k = 0; k < n; k++) {
+        const auto& box = detections[s.bucketed[k]].bbox;
+        s.x1[k] = box.x1; s.y1[k] = box.y1; s.x2[k] = box.x2; s.y2[k] = box.y2;
+        s.area[k] = (box.x2 - box.x1) * (box.y2 - box.y1);
+    }
+    s.suppressed.assign(n, 0);
+
+    const post_kernels::BoxSoA soa = {s.x1.data(), s.y1.data(), s.x2.data(), s.y2.data(),
+                                      s.area.data()};
+    size_t begin = 0;
+    while (begin < n) {
+        int cls = detections[s.bucketed[begin]].class_id;
+        size_t end = begin + 1;
+        while (end < n && detections[s.bucketed[end]].class_id == cls) end++;
+
+        for (size_t i = begin; i + 1 < end; i++) {
+            if (s.suppressed[i]) continue;
+            kt.suppress(soa, static_cast<int>(i), static_cast<int>(i + 1), static_cast<int>(end),
+                        threshold, s.suppressed.data());
+        }
+        begin = end;
+    }
+
+    s.removed.assign(n, 0);
+    for (size_t k = 0; k < n; k++) {
+        s.removed[s.bucketed[k]] = s.suppressed[k];
+    }
+
+    // 按置信度顺序移动保留的框 (不拷贝 class_name)
+    std::vector<Detection> result;
+    result.reserve(n);
+    for (uint32_t idx : s.order) {
+        if (!s.removed[idx]) result.push_back(std::move(detections[idx]));
+    }
+    detections = std::move(result);
+}
+
+void PostProcessor::attach_labels(std::vector<Detection>& detections,
+                                  const std::vector<std::string>& labels) {
+    if (labels.empty()) return;
+    for (auto& det : detections) {
+        if (det.class_id >= 0 && det.class_id < static_cast<int>(labels.size())) {
+            det.class_name = labels[det.class_id];
+        }
+    }
+}
+
 // ============================================================
 // YOLOv5 后处理 (anchor-based)
 // ============================================================
@@ -143,6 +276,12 @@ std::vector<Detection> PostProcessor::yolov5(
         return {};
     }
 
+    PostProcessKernel k = kernel();
+    if (k != PostProcessKernel::REFERENCE) {
+        return yolov5_fast(outputs, attrs, model_w, model_h, orig_w, orig_h,
+                      conf_thresh, nms_thresh, labels, post_kernels::table(k));
+    }
+
     std::vector<Detection> all_detections;
 
     for (int head = 0; head < 3; head++) {
@@ -241,6 +380,12 @@ std::vector<Detection> PostProcessor::yolov8(
         return {};
     }
 
+    PostProcessKernel k = kernel();
+    if (k != PostProcessKernel::REFERENCE) {
+        return yolov8_fast(outputs, attrs, model_w, model_h, orig_w, orig_h,
+                      conf_thresh, nms_thresh, labels, post_kernels::table(k));
+    }
+
     // YOLOv8/v11 RKNN 输出格式:
     // 每个 head shape: [1, grid_h, grid_w, 64 + num_classes]
     // 前 64 个通道: DFL box regression (4 * reg_max, reg_max=16)
@@ -354,6 +499,12 @@ std::vector<Detection> PostProcessor::yolov11(
         return {};
     }
 
+    PostProcessKernel k = kernel();
+    if (k != PostProcessKernel::REFERENCE) {
+        return yolov11_fast(outputs, attrs, model_w, model_h, orig_w, orig_h,
+                      conf_thresh, nms_thresh, labels, post_kernels::table(k));
+    }
+
     const float* data = outputs[0];
     const auto&  attr = attrs[0];
 
@@ -429,6 +580,533 @@ std::vector<Detection> PostProcessor::yolov11(
     return all_detections;
 }
 
+// ============================================================
+// 快速路径 (PORTABLE / NEON)
+//
+// 与参考实现逐 anchor 等价:
+//   - sigmoid 单调, 先用 logit 阈值跳过绝大多数 anchor, 不计算 exp
+//   - argmax 语义相同 (严格大于, 相同值取最小下标)
+//   - 只有通过阈值的 anchor 才计算 sigmoid / DFL
+// ============================================================
+
+std::vector<Detection> PostProcessor::yolov5_fast(
+    const std::vector<float*>& outputs, const std::vector<TensorAttr>& attrs,
+    int model_w, int model_h, int orig_w, int orig_h,
+    float conf_thresh, float nms_thresh, const std::vector<std::string>& labels,
+    const post_kernels::KernelTable& kt)
+{
+    using post_kernels::fast_sigmoid;
+
+    // obj_conf * cls_conf >= t 要求 obj_conf >= t (cls_conf <= 1)
+    const float logit_thresh = post_kernels::sigmoid_threshold_logit(conf_thresh) - kLogitMargin;
+
+    std::vector<Detection> all_detections;
+
+    for (int head = 0; head < 3; head++) {
+        const float* data = outputs[head];
+        const auto& attr = attrs[head];
+
+        if (attr.dims.size() < 4) {
+            LOG_ERROR("YOLOv5 head {} expects 4D tensor, got {}D", head, attr.dims.size());
+            continue;
+        }
+
+        int grid_h = attr.dims[1];
+        int grid_w = attr.dims[2];
+        int channel = attr.dims[3];
+        int num_classes = channel / YOLOV5_NUM_ANCHORS - 5;
+
+        if (num_classes <= 0) {
+            LOG_ERROR("YOLOv5 head {}: invalid channel count {}, cannot determine num_classes",
+                      head, channel);
+            continue;
+        }
+
+        int stride = STRIDES[head];
+        int entry_size = 5 + num_classes;
+        int num_entries = grid_h * grid_w * YOLOV5_NUM_ANCHORS;
+
+        for (int n = 0; n < num_entries; n++) {
+            const float* entry = data + static_cast<size_t>(n) * entry_size;
+            if (entry[4] < logit_thresh) continue;
+
+            float obj_conf = fast_sigmoid(entry[4]);
+            if (obj_conf < conf_thresh) continue;
+
+            int best_class = 0;
+            float best_score = kt.argmax(entry + 5, num_classes, &best_class);
+            float final_conf = obj_conf * fast_sigmoid(best_score);
+            if (final_conf < conf_thresh) continue;
+
+            int a = n % YOLOV5_NUM_ANCHORS;
+            int x = (n / YOLOV5_NUM_ANCHORS) % grid_w;
+            int y = n / (YOLOV5_NUM_ANCHORS * grid_w);
+
+            float sw = fast_sigmoid(entry[2]) * 2.0f;
+            float sh = fast_sigmoid(entry[3]) * 2.0f;
+            float cx = (fast_sigmoid(entry[0]) * 2.0f - 0.5f + static_cast<float>(x)) * stride;
+            float cy = (fast_sigmoid(entry[1]) * 2.0f - 0.5f + static_cast<float>(y)) * stride;
+            float bw = sw * sw * YOLOV5_ANCHORS[head][a * 2];
+            float bh = sh * sh * YOLOV5_ANCHORS[head][a * 2 + 1];
+
+            Detection det;
+            det.class_id = best_class;
+            det.confidence = final_conf;
+            det.bbox.x1 = cx - bw / 2.0f;
+            det.bbox.y1 = cy - bh / 2.0f;
+            det.bbox.x2 = cx + bw / 2.0f;
+            det.bbox.y2 = cy + bh / 2.0f;
+
+            all_detections.push_back(std::move(det));
+        }
+    }
+
+    nms(all_detections, nms_thresh);
+    attach_labels(all_detections, labels);
+    scale_coords(all_detections, model_w, model_h, orig_w, orig_h);
+    return all_detections;
+}
+
+std::vector<Detection> PostProcessor::yolov8_fast(
+    const std::vector<float*>& outputs, const std::vector<TensorAttr>& attrs,
+    int model_w, int model_h, int orig_w, int orig_h,
+    float conf_thresh, float nms_thresh, const std::vector<std::string>& labels,
+    const post_kernels::KernelTable& kt)
+{
+    static constexpr int REG_MAX = 16;
+    static constexpr int BOX_CHANNELS = 4 * REG_MAX;
+
+    const float logit_thresh = post_kernels::sigmoid_threshold_logit(conf_thresh) - kLogitMargin;
+
+    std::vector<Detection> all_detections;
+
+    for (int head = 0; head < 3; head++) {
+        const float* data = outputs[head];
+        const auto& attr = attrs[head];
+
+        if (attr.dims.size() < 4) {
+            LOG_ERROR("YOLOv8 head {} expects 4D tensor, got {}D", head, attr.dims.size());
+            continue;
+        }
+
+        int grid_h = attr.dims[1];
+        int grid_w = attr.dims[2];
+        int channel = attr.dims[3];
+        int num_classes = channel - BOX_CHANNELS;
+
+        if (num_classes <= 0) {
+            LOG_ERROR("YOLOv8 head {}: channel={}, expected > {}", head, channel, BOX_CHANNELS);
+            continue;
+        }
+
+        int stride = STRIDES[head];
+
+        for (int y = 0; y < grid_h; y++) {
+            for (int x = 0; x < grid_w; x++) {
+                const float* entry = data + static_cast<size_t>(y * grid_w + x) * channel;
+
+                int best_class = 0;
+                float best_raw = kt.argmax(entry + BOX_CHANNELS, num_classes, &best_class);
+                if (best_raw < logit_thresh) continue;
+
+                float best_score = post_kernels::fast_sigmoid(best_raw);
+                if (best_score < conf_thresh) continue;
+
+                float left   = kt.dfl16(entry + 0 * REG_MAX) * stride;
+                float top    = kt.dfl16(entry + 1 * REG_MAX) * stride;
+                float right  = kt.dfl16(entry + 2 * REG_MAX) * stride;
+                float bottom = kt.dfl16(entry + 3 * REG_MAX) * stride;
+
+                float cx = (static_cast<float>(x) + 0.5f) * stride;
+                float cy = (static_cast<float>(y) + 0.5f) * stride;
+
+                Detection det;
+                det.class_id = best_class;
+                det.confidence = best_score;
+                det.bbox.x1 = cx - left;
+                det.bbox.y1 = cy - top;
+                det.bbox.x2 = cx + right;
+                det.bbox.y2 = cy + bottom;
+
+                all_detections.push_back(std::move(det));
+            }
+        }
+    }
+
+    nms(all_detections, nms_thresh);
+    attach_labels(all_detections, labels);
+    scale_coords(all_detections, model_w, model_h, orig_w, orig_h);
+    return all_detections;
+}
+
+std::vector<Detection> PostProcessor::yolov11_fast(
+    const std::vector<float*>& outputs, const std::vector<TensorAttr>& attrs,
+    int model_w, int model_h, int orig_w, int orig_h,
+    float conf_thresh, float nms_thresh, const std::vector<std::string>& labels,
+    const post_kernels::KernelTable& kt)
+{
+    // 通道优先布局 [1, 4 + num_classes, num_anchors]: 逐 anchor 扫描类别是跨步访问,
+    // 改为按 anchor 分块、逐通道顺序扫描, 每块的最大值/类别保存在栈上
+    static constexpr int BLOCK = 256;
+
+    const float* data = outputs[0];
+    const auto&  attr = attrs[0];
+
+    const int num_channels = attr.dims[1];
+    const int num_anchors  = attr.dims[2];
+    const int num_classes  = num_channels - 4;
+
+    std::vector<Detection> all_detections;
+    all_detections.reserve(200);
+
+    float best_score[BLOCK];
+    int   best_class[BLOCK];
+
+    for (int base = 0; base < num_anchors; base += BLOCK) {
+        int count = std::min(BLOCK, num_anchors - base);
+        std::fill(best_score, best_score + count, -1.0f);
+        std::fill(best_class, best_class + count, -1);
+
+        kt.column_argmax(data + static_cast<size_t>(4) * num_anchors + base,
+                         num_classes, num_anchors, count, best_score, best_class);
+
+        for (int j = 0; j < count; j++) {
+            // score 已经是概率值, 无需 sigmoid (与参考实现一致)
+            if (best_score[j] < conf_thresh) continue;
+
+            int i = base + j;
+            float cx = data[0 * num_anchors + i];
+            float cy = data[1 * num_anchors + i];
+            float w  = data[2 * num_anchors + i];
+            float h  = data[3 * num_anchors + i];
+
+            Detection det;
+            det.class_id   = best_class[j];
+            det.confidence = best_score[j];
+            det.bbox.x1    = cx - w * 0.5f;
+            det.bbox.y1    = cy - h * 0.5f;
+            det.bbox.x2    = cx + w * 0.5f;
+            det.bbox.y2    = cy + h * 0.5f;
+
+            all_detections.push_back(std::move(det));
+        }
+    }
+
+    LOG_DEBUG("YOLOv11: {} candidates before NMS", all_detections.size());
+    nms(all_detections, nms_thresh);
+    LOG_DEBUG("YOLOv11: {} detections after NMS", all_detections.size());
+    attach_labels(all_detections, labels);
+    scale_coords(all_detections, model_w, model_h, orig_w, orig_h);
+    return all_detections;
+}
+
+// ============================================================
+// INT8 路径
+//
+// 量化域过滤: dequant(q) = (q - zp) * scale 单调递增, 阈值换算为整数 qt,
+// q < qt 的 anchor 直接跳过; argmax 也在整数上进行。只有通过的 anchor 反量化,
+// 反量化公式与 dequantize_int8 相同, 因此结果与反量化后走浮点路径一致。
+// ============================================================
+
+bool PostProcessor::supports_int8(const std::string& model_type,
+                                  const std::vector<TensorAttr>& attrs) {
+    if (model_type != "yolov5" && model_type != "yolov8" && model_type != "yolov11") {
+        return false;
+    }
+    if (attrs.empty()) return false;
+    for (const auto& attr : attrs) {
+        if (!attr.is_int8 || !(attr.scale > 0.0f)) return false;
+    }
+    return true;
+}
+
+std::vector<Detection> PostProcessor::yolov5_int8(
+    const std::vector<const int8_t*>& outputs, const std::vector<TensorAttr>& attrs,
+    int model_w, int model_h, int orig_w, int orig_h,
+    float conf_thresh, float nms_thresh, const std::vector<std::string>& labels,
+    const post_kernels::KernelTable& kt)
+{
+    using post_kernels::fast_sigmoid;
+    using post_kernels::dequantize;
+
+    const float logit_thresh = post_kernels::sigmoid_threshold_logit(conf_thresh) - kLogitMargin;
+
+    std::vector<Detection> all_detections;
+
+    for (int head = 0; head < 3; head++) {
+        const int8_t* data = outputs[head];
+        const auto& attr = attrs[head];
+
+        if (attr.dims.size() < 4) {
+            LOG_ERROR("YOLOv5 head {} expects 4D tensor, got {}D", head, attr.dims.size());
+            continue;
+        }
+
+        int grid_h = attr.dims[1];
+        int grid_w = attr.dims[2];
+        int channel = attr.dims[3];
+        int num_classes = channel / YOLOV5_NUM_ANCHORS - 5;
+
+        if (num_classes <= 0) {
+            LOG_ERROR("YOLOv5 head {}: invalid channel count {}, cannot determine num_classes",
+                      head, channel);
+            continue;
+        }
+
+        const int32_t zp = attr.zp;
+        const float scale = attr.scale;
+        int q_thresh = post_kernels::quantize_threshold(logit_thresh, zp, scale);
+        if (q_thresh > 127) continue;
+
+        int stride = STRIDES[head];
+        int entry_size = 5 + num_classes;
+        int num_entries = grid_h * grid_w * YOLOV5_NUM_ANCHORS;
+
+        for (int n = 0; n < num_entries; n++) {
+            const int8_t* entry = data + static_cast<size_t>(n) * entry_size;
+            if (entry[4] < q_thresh) continue;
+
+            float obj_conf = fast_sigmoid(dequantize(entry[4], zp, scale));
+            if (obj_conf < conf_thresh) continue;
+
+            int best_class = 0;
+            int8_t best_q = kt.argmax_i8(entry + 5, num_classes, &best_class);
+            float final_conf = obj_conf * fast_sigmoid(dequantize(best_q, zp, scale));
+            if (final_conf < conf_thresh) continue;
+
+            int a = n % YOLOV5_NUM_ANCHORS;
+            int x = (n / YOLOV5_NUM_ANCHORS) % grid_w;
+            int y = n / (YOLOV5_NUM_ANCHORS * grid_w);
+
+            float sw = fast_sigmoid(dequantize(entry[2], zp, scale)) * 2.0f;
+            float sh = fast_sigmoid(dequantize(entry[3], zp, scale)) * 2.0f;
+            float cx = (fast_sigmoid(dequantize(entry[0], zp, scale)) * 2.0f - 0.5f +
+                        static_cast<float>(x)) * stride;
+            float cy = (fast_sigmoid(dequantize(entry[1], zp, scale)) * 2.0f - 0.5f +
+                        static_cast<float>(y)) * stride;
+            float bw = sw * sw * YOLOV5_ANCHORS[head][a * 2];
+            float bh = sh * sh * YOLOV5_ANCHORS[head][a * 2 + 1];
+
+            Detection det;
+            det.class_id = best_class;
+            det.confidence = final_conf;
+            det.bbox.x1 = cx - bw / 2.0f;
+            det.bbox.y1 = cy - bh / 2.0f;
+            det.bbox.x2 = cx + bw / 2.0f;
+            det.bbox.y2 = cy + bh / 2.0f;
+
+            all_detections.push_back(std::move(det));
+        }
+    }
+
+    nms(all_detections, nms_thresh);
+    attach_labels(all_detections, labels);
+    scale_coords(all_detections, model_w, model_h, orig_w, orig_h);
+    return all_detections;
+}
+
+std::vector<Detection> PostProcessor::yolov8_int8(
+    const std::vector<const int8_t*>& outputs, const std::vector<TensorAttr>& attrs,
+    int model_w, int model_h, int orig_w, int orig_h,
+    float conf_thresh, float nms_thresh, const std::vector<std::string>& labels,
+    const post_kernels::KernelTable& kt)
+{
+    static constexpr int REG_MAX = 16;
+    static constexpr int BOX_CHANNELS = 4 * REG_MAX;
+
+    const float logit_thresh = post_kernels::sigmoid_threshold_logit(conf_thresh) - kLogitMargin;
+
+    std::vector<Detection> all_detections;
+
+    for (int head = 0; head < 3; head++) {
+        const int8_t* data = outputs[head];
+        const auto& attr = attrs[head];
+
+        if (attr.dims.size() < 4) {
+            LOG_ERROR("YOLOv8 head {} expects 4D tensor, got {}D", head, attr.dims.size());
+            continue;
+        }
+
+        int grid_h = attr.dims[1];
+        int grid_w = attr.dims[2];
+        int channel = attr.dims[3];
+        int num_classes = channel - BOX_CHANNELS;
+
+        if (num_classes <= 0) {
+            LOG_ERROR("YOLOv8 head {}: channel={}, expected > {}", head, channel, BOX_CHANNELS);
+            continue;
+        }
+
+        const int32_t zp = attr.zp;
+        const float scale = attr.scale;
+        int q_thresh = post_kernels::quantize_threshold(logit_thresh, zp, scale);
+        if (q_thresh > 127) continue;
+
+        int stride = STRIDES[head];
+        float box[BOX_CHANNELS];
+
+        for (int y = 0; y < grid_h; y++) {
+            for (int x = 0; x < grid_w; x++) {
+                const int8_t* entry = data + static_cast<size_t>(y * grid_w + x) * channel;
+
+                int best_class = 0;
+                int8_t best_q = kt.argmax_i8(entry + BOX_CHANNELS, num_classes, &best_class);
+                if (best_q < q_thresh) continue;
+
+                float best_score = post_kernels::fast_sigmoid(
+                    post_kernels::dequantize(best_q, zp, scale));
+                if (best_score < conf_thresh) continue;
+
+                dequantize_int8(entry, box, BOX_CHANNELS, zp, scale);
+                float left   = kt.dfl16(box + 0 * REG_MAX) * stride;
+                float top    = kt.dfl16(box + 1 * REG_MAX) * stride;
+                float right  = kt.dfl16(box + 2 * REG_MAX) * stride;
+                float bottom = kt.dfl16(box + 3 * REG_MAX) * stride;
+
+                float cx = (static_cast<float>(x) + 0.5f) * stride;
+                float cy = (static_cast<float>(y) + 0.5f) * stride;
+
+                Detection det;
+                det.class_id = best_class;
+                det.confidence = best_score;
+                det.bbox.x1 = cx - left;
+                det.bbox.y1 = cy - top;
+                det.bbox.x2 = cx + right;
+                det.bbox.y2 = cy + bottom;
+
+                all_detections.push_back(std::move(det));
+            }
+        }
+    }
+
+    nms(all_detections, nms_thresh);
+    attach_labels(all_detections, labels);
+    scale_coords(all_detections, model_w, model_h, orig_w, orig_h);
+    return all_detections;
+}
+
+std::vector<Detection> PostProcessor::yolov11_int8(
+    const std::vector<const int8_t*>& outputs, const std::vector<TensorAttr>& attrs,
+    int model_w, int model_h, int orig_w, int orig_h,
+    float conf_thresh, float nms_thresh, const std::vector<std::string>& labels,
+    const post_kernels::KernelTable& kt)
+{
+    using post_kernels::dequantize;
+    static constexpr int BLOCK = 256;
+
+    const int8_t* data = outputs[0];
+    const auto&  attr = attrs[0];
+
+    const int num_channels = attr.dims[1];
+    const int num_anchors  = attr.dims[2];
+    const int num_classes  = num_channels - 4;
+    const int32_t zp = attr.zp;
+    const float scale = attr.scale;
+
+    // score 已经是概率值, 阈值直接量化
+    int q_thresh = post_kernels::quantize_threshold(conf_thresh, zp, scale);
+
+    std::vector<Detection> all_detections;
+    all_detections.reserve(200);
+
+    int8_t best_q[BLOCK];
+    int    best_class[BLOCK];
+
+    for (int base = 0; base < num_anchors && q_thresh <= 127; base += BLOCK) {
+        int count = std::min(BLOCK, num_anchors - base);
+        std::fill(best_q, best_q + count, static_cast<int8_t>(-128));
+        std::fill(best_class, best_class + count, -1);
+
+        kt.column_argmax_i8(data + static_cast<size_t>(4) * num_anchors + base,
+                            num_classes, num_anchors, count, best_q, best_class);
+
+        for (int j = 0; j < count; j++) {
+            // 全部为 -128 时保持初值; 参考实现此时取第一个类别 (浮点初值 -1 小于任何概率)
+            if (best_class[j] < 0 && num_classes > 0) best_class[j] = 0;
+            if (best_q[j] < q_thresh) continue;
+
+            float score = dequantize(best_q[j], zp, scale);
+            if (score < conf_thresh) continue;
+
+            int i = base + j;
+            float cx = dequantize(data[0 * num_anchors + i], zp, scale);
+            float cy = dequantize(data[1 * num_anchors + i], zp, scale);
+            float w  = dequantize(data[2 * num_anchors + i], zp, scale);
+            float h  = dequantize(data[3 * num_anchors + i], zp, scale);
+
+            Detection det;
+            det.class_id   = best_class[j];
+            det.confidence = score;
+            det.bbox.x1    = cx - w * 0.5f;
+            det.bbox.y1    = cy - h * 0.5f;
+            det.bbox.x2    = cx + w * 0.5f;
+            det.bbox.y2    = cy + h * 0.5f;
+
+            all_detections.push_back(std::move(det));
+        }
+    }
+
+    LOG_DEBUG("YOLOv11: {} candidates before NMS", all_detections.size());
+    nms(all_detections, nms_thresh);
+    LOG_DEBUG("YOLOv11: {} detections after NMS", all_detections.size());
+    attach_labels(all_detections, labels);
+    scale_coords(all_detections, model_w, model_h, orig_w, orig_h);
+    return all_detections;
+}
+
+std::vector<Detection> PostProcessor::process_int8(
+    const std::string& model_type,
+    const std::vector<const int8_t*>& outputs,
+    const std::vector<TensorAttr>& attrs,
+    int model_w, int model_h,
+    int orig_w, int orig_h,
+    float conf_thresh, float nms_thresh,
+    const std::vector<std::string>& labels)
+{
+    if (outputs.size() != attrs.size() || outputs.empty()) {
+        LOG_ERROR("process_int8: {} outputs but {} attrs", outputs.size(), attrs.size());
+        return {};
+    }
+
+    PostProcessKernel k = kernel();
+    if (k == PostProcessKernel::REFERENCE) {
+        // 参考路径: 整体反量化后走浮点实现
+        std::vector<std::vector<float>> dequantized(outputs.size());
+        std::vector<float*> float_ptrs(outputs.size());
+        for (size_t i = 0; i < outputs.size(); i++) {
+            dequantized[i].resize(attrs[i].n_elems);
+            dequantize_int8(outputs[i], dequantized[i].data(), attrs[i].n_elems,
+                            attrs[i].zp, attrs[i].scale);
+            float_ptrs[i] = dequantized[i].data();
+        }
+        return process(model_type, float_ptrs, attrs, model_w, model_h, orig_w, orig_h,
+                       conf_thresh, nms_thresh, labels);
+    }
+
+    const auto& kt = post_kernels::table(k);
+    if (model_type == "yolov5") {
+        if (outputs.size() != 3) {
+            LOG_ERROR("YOLOv5 expects 3 output heads, got {}", outputs.size());
+            return {};
+        }
+        return yolov5_int8(outputs, attrs, model_w, model_h, orig_w, orig_h,
+                           conf_thresh, nms_thresh, labels, kt);
+    } else if (model_type == "yolov8") {
+        if (outputs.size() != 3) {
+            LOG_ERROR("YOLOv8 expects 3 output heads, got {}", outputs.size());
+            return {};
+        }
+        return yolov8_int8(outputs, attrs, model_w, model_h, orig_w, orig_h,
+                           conf_thresh, nms_thresh, labels, kt);
+    } else if (model_type == "yolov11") {
+        return yolov11_int8(outputs, attrs, model_w, model_h, orig_w, orig_h,
+                            conf_thresh, nms_thresh, labels, kt);
+    } else {
+        LOG_ERROR("Unknown model type: '{}', supported: yolov5, yolov8, yolov11", model_type);
+        return {};
+    }
+}
+
 // ============================================================
 // 统一分发
 // ============================================================
@@ -458,4 +1136,45 @@ std::vector<Detection> PostProcessor::process(
     }
 }
 
+// ============================================================
+// 按预处理几何变换反算坐标
+// ============================================================
+
+void PostProcessor::unmap_coords(std::vector<Detection>& dets, const LetterboxTransform& transform) {
+    for (auto& det : dets) {
+        transform.unmap(det.bbox);
+    }
+}
+
+std::vector<Detection> PostProcessor::process(
+    const std::string& model_type,
+    const std::vector<float*>& outputs,
+    const std::vector<TensorAttr>& attrs,
+    const LetterboxTransform& transform,
+    float conf_thresh, float nms_thresh,
+    const std::vector<std::string>& labels)
+{
+    // 原图尺寸 = 模型尺寸时 scale_coords 为恒等映射 (只裁剪到模型输入范围)
+    int mw = transform.model_w, mh = transform.model_h;
+    auto dets = process(model_type, outputs, attrs, mw, mh, mw, mh,
+                        conf_thresh, nms_thresh, labels);
+    unmap_coords(dets, transform);
+    return dets;
+}
+
+std::vector<Detection> PostProcessor::process_int8(
+    const std::string& model_type,
+    const std::vector<const int8_t*>& outputs,
+    const std::vector<TensorAttr>& attrs,
+    const LetterboxTransform& transform,
+    float conf_thresh, float nms_thresh,
+    const std::vector<std::string>& labels)
+{
+    int mw = transform.model_w, mh = transform.model_h;
+    auto dets = process_int8(model_type, outputs, attrs, mw, mh, mw, mh,
+                             conf_thresh, nms_thresh, labels);
+    unmap_coords(dets, transform);
+    return dets;
+}
+
 } // namespace infer_server
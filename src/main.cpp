@@ -10,9 +10,9 @@
  * 5. 创建 StreamManager(config, engine, cache)
  * 6. 加载持久化流配置 -> StreamManager.load_and_start()
  * 7. 创建 RestServer(stream_mgr, cache, engine, config)
- * 8. RestServer.start()
+ * 8. RestServer.start(), 配置了 cluster_nodes 时启动 ClusterCoordinator
  * 9. 主循环 (等待信号)
- * 10. RestServer.stop()
+ * 10. RestServer.stop(), ClusterCoordinator.stop()
  * 11. StreamManager.shutdown()
  * 12. InferenceEngine.shutdown()
  * 13. 日志关闭
@@ -20,7 +20,12 @@
 
 #include "infer_server/common/logger.h"
 #include "infer_server/common/config.h"
+#include "infer_server/common/buffer_pool.h"
+#include "infer_server/common/thread_policy.h"
+#include "infer_server/processor/rga_scheduler.h"
+#include "infer_server/inference/post_processor.h"
 #include "infer_server/stream/stream_manager.h"
+#include "infer_server/output/result_broadcaster.h"
 
 #ifdef HAS_RKNN
 #include "infer_server/inference/inference_engine.h"
@@ -32,8 +37,10 @@
 
 #ifdef HAS_HTTP
 #include "infer_server/api/rest_server.h"
+#include "infer_server/cluster/cluster_coordinator.h"
 #endif
 
+#include <algorithm>
 #include <csignal>
 #include <atomic>
 #include <iostream>
@@ -88,14 +95,46 @@ int main(int argc, char* argv[]) {
     LOG_INFO("Config:");
     LOG_INFO("  HTTP port:        {}", config.http_port);
     LOG_INFO("  ZMQ endpoint:     {}", config.zmq_endpoint);
+    LOG_INFO("  ZMQ format:       {} (topics={}, skip_empty={})",
+             config.zmq_format, config.zmq_topic_mode, config.zmq_skip_empty);
     LOG_INFO("  Infer workers:    {}", config.num_infer_workers);
     LOG_INFO("  NPU cores:        {}", config.num_npu_cores);
     LOG_INFO("  Decode queue:     {}", config.decode_queue_size);
+    if (config.decode_threads > 0) {
+        LOG_INFO("  Decode threads:   {} (shared pool)", config.decode_threads);
+    } else {
+        LOG_INFO("  Decode threads:   one per stream");
+    }
     LOG_INFO("  Infer queue:      {}", config.infer_queue_size);
     LOG_INFO("  Streams save:     {}", config.streams_save_path);
+    if (!config.cluster_nodes.empty()) {
+        LOG_INFO("  Cluster:          {} node(s), streams={}, poll={}ms, max_moves={}",
+                 config.cluster_nodes.size(), config.cluster_streams_path,
+                 config.cluster_poll_ms, config.cluster_max_moves);
+    }
     LOG_INFO("  Cache duration:   {}s", config.cache_duration_sec);
     LOG_INFO("  Cache JPEG quality: {}", config.cache_jpeg_quality);
+    LOG_INFO("  Cache mode:       {}{}", config.cache_mode, config.cache_overlay ? " (+overlay)" : "");
+    LOG_INFO("  Cache JPEG backend: {}", config.cache_jpeg_backend);
     LOG_INFO("  Cache max memory: {}MB", config.cache_max_memory_mb);
+    LOG_INFO("  Buffer pool max:  {}MB", config.buffer_pool_max_mb);
+    LOG_INFO("  RGA core mask:    {}", config.rga_core_mask);
+    infer_server::PostProcessKernel post_kernel;
+    if (infer_server::PostProcessor::parse_kernel(config.post_kernel, post_kernel)) {
+        infer_server::PostProcessor::set_kernel(post_kernel);
+    } else {
+        LOG_WARN("Unknown post_kernel '{}', using {}", config.post_kernel,
+                 infer_server::post_kernel_name(infer_server::PostProcessor::default_kernel()));
+    }
+    LOG_INFO("  Postproc kernel:  {}",
+             infer_server::post_kernel_name(infer_server::PostProcessor::kernel()));
+
+    infer_server::BufferPool::global().set_max_idle_bytes(
+        static_cast<size_t>(std::max(config.buffer_pool_max_mb, 0)) * 1024 * 1024);
+    infer_server::RgaScheduler::instance().configure(config.rga_core_mask);
+    // 须在创建推理 / 解码 / 输出 / HTTP 线程之前设置, 各线程在入口处按角色生效
+    infer_server::ThreadPolicy::instance().configure(infer_server::ThreadPolicy::from_config(config));
+    LOG_INFO("  Thread policy:    {}", infer_server::ThreadPolicy::instance().describe());
 
     // ========================
     // 注册信号处理
@@ -107,10 +146,15 @@ int main(int argc, char* argv[]) {
     // 3. 创建 ImageCache
     // ========================
 #ifdef HAS_TURBOJPEG
+    infer_server::JpegBackend jpeg_backend = infer_server::JpegBackend::TURBOJPEG;
+    if (!infer_server::parse_jpeg_backend(config.cache_jpeg_backend, jpeg_backend)) {
+        LOG_WARN("Unknown cache_jpeg_backend '{}', falling back to turbojpeg", config.cache_jpeg_backend);
+    }
     auto image_cache = std::make_unique<infer_server::ImageCache>(
-        config.cache_duration_sec, config.cache_max_memory_mb);
-    LOG_INFO("ImageCache created (duration={}s, max_memory={}MB)",
-             config.cache_duration_sec, config.cache_max_memory_mb);
+        config.cache_duration_sec, config.cache_max_memory_mb, config.cache_jpeg_quality,
+        jpeg_backend);
+    LOG_INFO("ImageCache created (duration={}s, max_memory={}MB, mode={})",
+             config.cache_duration_sec, config.cache_max_memory_mb, config.cache_mode);
     infer_server::ImageCache* cache_ptr = image_cache.get();
 #else
     LOG_WARN("TurboJPEG not available, image cache disabled");
@@ -143,11 +187,15 @@ int main(int argc, char* argv[]) {
         cache_ptr);
     LOG_INFO("StreamManager created");
 
-    // 注册推理结果回调 (用于统计 inferred_frames)
+    // 结果广播 (HTTP SSE 推送; 没有订阅者时 publish 直接返回)
+    infer_server::ResultBroadcaster result_broadcaster;
+
+    // 注册推理结果回调 (用于统计 inferred_frames 与 HTTP 推送)
 #ifdef HAS_RKNN
     inference_engine->set_result_callback(
-        [&stream_manager](const infer_server::FrameResult& result) {
+        [&stream_manager, &result_broadcaster](const infer_server::FrameResult& result) {
             stream_manager->on_infer_result(result);
+            result_broadcaster.publish(result);
         });
 #endif
 
@@ -179,11 +227,22 @@ int main(int argc, char* argv[]) {
         engine_ptr,
 #endif
         config);
+    rest_server->set_result_broadcaster(&result_broadcaster);
+
+    // 集群协调器: 本实例同时作为协调器 (也可以把自己列为节点之一)
+    std::unique_ptr<infer_server::ClusterCoordinator> cluster;
+    if (!config.cluster_nodes.empty()) {
+        cluster = std::make_unique<infer_server::ClusterCoordinator>(config);
+        rest_server->set_cluster(cluster.get());
+    }
 
     if (!rest_server->start()) {
         LOG_ERROR("Failed to start REST API server");
         // 不返回, 流管理仍可运行 (只是没有 HTTP 接口)
     }
+    if (cluster) {
+        cluster->start();
+    }
 #else
     LOG_WARN("HTTP not available, REST API disabled");
 #endif
@@ -206,6 +265,9 @@ int main(int argc, char* argv[]) {
     if (rest_server) {
         rest_server->stop();
     }
+    if (cluster) {
+        cluster->stop();
+    }
 #endif
 
     if (stream_manager) {
@@ -0,0 +1,61 @@
+/**
+ * @file result_broadcaster.cpp
+ * @brief 推理结果进程内广播实现
+ */
+
+#include "infer_server/output/result_broadcaster.h"
+#include "infer_server/output/result_codec.h"
+#include <algorithm>
+
+namespace infer_server {
+
+ResultBroadcaster::Subscription::Subscription(std::string cam_id, size_t queue_size)
+    : cam_id_(std::move(cam_id))
+    , queue_(std::max<size_t>(queue_size, 1))
+{
+}
+
+std::shared_ptr<ResultBroadcaster::Subscription> ResultBroadcaster::subscribe(
+    const std::string& cam_id, size_t queue_size)
+{
+    auto sub = std::make_shared<Subscription>(cam_id, queue_size);
+    std::lock_guard<std::mutex> lock(mutex_);
+    prune_locked();
+    subscribers_.push_back(sub);
+    count_.store(subscribers_.size(), std::memory_order_relaxed);
+    return sub;
+}
+
+void ResultBroadcaster::publish(const FrameResult& result) {
+    if (count_.load(std::memory_order_relaxed) == 0) return;
+
+    std::vector<std::shared_ptr<Subscription>> targets;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        prune_locked();
+        count_.store(subscribers_.size(), std::memory_order_relaxed);
+        for (const auto& weak : subscribers_) {
+            auto sub = weak.lock();
+            if (sub && (sub->cam_id_.empty() || sub->cam_id_ == result.cam_id)) {
+                targets.push_back(std::move(sub));
+            }
+        }
+    }
+    if (targets.empty()) return;
+
+    // 锁外编码与入队: 订阅者的增删不等待序列化
+    auto payload = std::make_shared<const std::string>(result_codec::encode_json(result));
+    for (auto& sub : targets) {
+        sub->queue_.push(payload);
+    }
+    published_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ResultBroadcaster::prune_locked() {
+    subscribers_.erase(
+        std::remove_if(subscribers_.begin(), subscribers_.end(),
+                       [](const std::weak_ptr<Subscription>& w) { return w.expired(); }),
+        subscribers_.end());
+}
+
+} // namespace infer_server
@@ -0,0 +1,568 @@
+/**
+ * @file result_codec.cpp
+ * @brief FrameResult 序列化格式实现
+ */
+
+#include "infer_server/output/result_codec.h"
+#include <nlohmann/json.hpp>
+#include <cstring>
+#include <limits>
+
+namespace infer_server {
+
+const char* output_format_name(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::JSON:    return "json";
+        case OutputFormat::MSGPACK: return "msgpack";
+    }
+    return "unknown";
+}
+
+bool parse_output_format(const std::string& name, OutputFormat& out) {
+    if (name == "json") {
+        out = OutputFormat::JSON;
+        return true;
+    }
+    if (name == "msgpack") {
+        out = OutputFormat::MSGPACK;
+        return true;
+    }
+    return false;
+}
+
+const char* topic_mode_name(TopicMode mode) {
+    switch (mode) {
+        case TopicMode::NONE:   return "none";
+        case TopicMode::CAMERA: return "camera";
+        case TopicMode::TASK:   return "task";
+    }
+    return "unknown";
+}
+
+bool parse_topic_mode(const std::string& name, TopicMode& out) {
+    if (name == "none") {
+        out = TopicMode::NONE;
+    } else if (name == "camera") {
+        out = TopicMode::CAMERA;
+    } else if (name == "task") {
+        out = TopicMode::TASK;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+namespace result_codec {
+
+namespace {
+
+// ============================================================
+// MessagePack 写入 (大端序)
+// ============================================================
+
+class Writer {
+public:
+    explicit Writer(std::vector<uint8_t>& out) : out_(out) {}
+
+    void array(size_t n) {
+        if (n < 16) {
+            put(static_cast<uint8_t>(0x90 | n));
+        } else if (n <= 0xffff) {
+            put(0xdc);
+            be(static_cast<uint16_t>(n));
+        } else {
+            put(0xdd);
+            be(static_cast<uint32_t>(n));
+        }
+    }
+
+    void uint(uint64_t v) {
+        if (v < 128) {
+            put(static_cast<uint8_t>(v));
+        } else if (v <= 0xff) {
+            put(0xcc);
+            put(static_cast<uint8_t>(v));
+        } else if (v <= 0xffff) {
+            put(0xcd);
+            be(static_cast<uint16_t>(v));
+        } else if (v <= 0xffffffffu) {
+            put(0xce);
+            be(static_cast<uint32_t>(v));
+        } else {
+            put(0xcf);
+            be(v);
+        }
+    }
+
+    void sint(int64_t v) {
+        if (v >= 0) {
+            uint(static_cast<uint64_t>(v));
+        } else if (v >= -32) {
+            put(static_cast<uint8_t>(static_cast<int8_t>(v)));
+        } else if (v >= std::numeric_limits<int8_t>::min()) {
+            put(0xd0);
+            put(static_cast<uint8_t>(static_cast<int8_t>(v)));
+        } else if (v >= std::numeric_limits<int16_t>::min()) {
+            put(0xd1);
+            be(static_cast<uint16_t>(static_cast<int16_t>(v)));
+        } else if (v >= std::numeric_limits<int32_t>::min()) {
+            put(0xd2);
+            be(static_cast<uint32_t>(static_cast<int32_t>(v)));
+        } else {
+            put(0xd3);
+            be(static_cast<uint64_t>(v));
+        }
+    }
+
+    void boolean(bool v) { put(v ? 0xc3 : 0xc2); }
+
+    void f32(float v) {
+        uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        put(0xca);
+        be(bits);
+    }
+
+    void f64(double v) {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        put(0xcb);
+        be(bits);
+    }
+
+    void str(const std::string& s) {
+        size_t n = s.size();
+        if (n < 32) {
+            put(static_cast<uint8_t>(0xa0 | n));
+        } else if (n <= 0xff) {
+            put(0xd9);
+            put(static_cast<uint8_t>(n));
+        } else if (n <= 0xffff) {
+            put(0xda);
+            be(static_cast<uint16_t>(n));
+        } else {
+            put(0xdb);
+            be(static_cast<uint32_t>(n));
+        }
+        out_.insert(out_.end(), s.begin(), s.end());
+    }
+
+private:
+    void put(uint8_t b) { out_.push_back(b); }
+
+    void be(uint16_t v) {
+        put(static_cast<uint8_t>(v >> 8));
+        put(static_cast<uint8_t>(v));
+    }
+    void be(uint32_t v) {
+        be(static_cast<uint16_t>(v >> 16));
+        be(static_cast<uint16_t>(v));
+    }
+    void be(uint64_t v) {
+        be(static_cast<uint32_t>(v >> 32));
+        be(static_cast<uint32_t>(v));
+    }
+
+    std::vector<uint8_t>& out_;
+};
+
+// ============================================================
+// MessagePack 读取 (只支持 schema 用到的类型, 其余类型可跳过)
+// ============================================================
+
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : p_(data), end_(data + size) {}
+
+    bool at_end() const { return p_ == end_; }
+
+    bool array(size_t& n) {
+        uint8_t tag;
+        if (!get(tag)) return false;
+        if ((tag & 0xf0) == 0x90) {
+            n = tag & 0x0f;
+            return true;
+        }
+        if (tag == 0xdc) return len<uint16_t>(n);
+        if (tag == 0xdd) return len<uint32_t>(n);
+        return false;
+    }
+
+    bool u64(uint64_t& v) {
+        int64_t s;
+        bool is_unsigned;
+        if (!integer(s, v, is_unsigned)) return false;
+        if (is_unsigned) return true;
+        if (s < 0) return false;
+        v = static_cast<uint64_t>(s);
+        return true;
+    }
+
+    bool i64(int64_t& v) {
+        uint64_t u;
+        bool is_unsigned;
+        if (!integer(v, u, is_unsigned)) return false;
+        if (!is_unsigned) return true;
+        if (u > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) return false;
+        v = static_cast<int64_t>(u);
+        return true;
+    }
+
+    bool i32(int& v) {
+        int64_t s;
+        if (!i64(s)) return false;
+        if (s < std::numeric_limits<int>::min() || s > std::numeric_limits<int>::max()) return false;
+        v = static_cast<int>(s);
+        return true;
+    }
+
+    /// 浮点 (也接受整数, 便于其他编码器写出的 0 / 1 等值)
+    bool f64(double& v) {
+        if (p_ == end_) return false;
+        uint8_t tag = *p_;
+        if (tag == 0xca) {
+            ++p_;
+            uint32_t bits;
+            float f;
+            if (!be(bits)) return false;
+            std::memcpy(&f, &bits, sizeof(f));
+            v = f;
+            return true;
+        }
+        if (tag == 0xcb) {
+            ++p_;
+            uint64_t bits;
+            if (!be(bits)) return false;
+            std::memcpy(&v, &bits, sizeof(v));
+            return true;
+        }
+        int64_t s;
+        uint64_t u;
+        bool is_unsigned;
+        if (!integer(s, u, is_unsigned)) return false;
+        v = is_unsigned ? static_cast<double>(u) : static_cast<double>(s);
+        return true;
+    }
+
+    bool f32(float& v) {
+        double d;
+        if (!f64(d)) return false;
+        v = static_cast<float>(d);
+        return true;
+    }
+
+    bool str(std::string& s) {
+        uint8_t tag;
+        if (!get(tag)) return false;
+        size_t n;
+        if ((tag & 0xe0) == 0xa0) {
+            n = tag & 0x1f;
+        } else if (tag == 0xd9) {
+            if (!len<uint8_t>(n)) return false;
+        } else if (tag == 0xda) {
+            if (!len<uint16_t>(n)) return false;
+        } else if (tag == 0xdb) {
+            if (!len<uint32_t>(n)) return false;
+        } else {
+            return false;
+        }
+        if (static_cast<size_t>(end_ - p_) < n) return false;
+        s.assign(reinterpret_cast<const char*>(p_), n);
+        p_ += n;
+        return true;
+    }
+
+    /// 布尔值; 类型不符时不消耗输入并返回 false (调用方可改为 skip)
+    bool boolean(bool& v) {
+        if (p_ == end_ || (*p_ != 0xc2 && *p_ != 0xc3)) return false;
+        v = *p_++ == 0xc3;
+        return true;
+    }
+
+    /// 可选整数字段; 类型不符时不消耗输入并返回 false
+    bool optional_i32(int& v) {
+        if (p_ == end_) return false;
+        uint8_t tag = *p_;
+        bool is_int = tag <= 0x7f || tag >= 0xe0 || (tag >= 0xcc && tag <= 0xcf) || (tag >= 0xd0 && tag <= 0xd3);
+        return is_int && i32(v);
+    }
+
+    /// 跳过任意一个值 (用于忽略新版本追加的尾部字段)
+    bool skip(int depth = 0) {
+        if (depth > kMaxDepth) return false;
+        uint8_t tag;
+        if (!get(tag)) return false;
+
+        if (tag <= 0x7f || tag >= 0xe0) return true;                     // fixint
+        if ((tag & 0xe0) == 0xa0) return advance(tag & 0x1f);             // fixstr
+        if ((tag & 0xf0) == 0x90) return skip_items(tag & 0x0f, depth);   // fixarray
+        if ((tag & 0xf0) == 0x80) return skip_items(2 * (tag & 0x0f), depth);  // fixmap
+
+        size_t n;
+        switch (tag) {
+            case 0xc0: case 0xc2: case 0xc3: return true;                 // nil / bool
+            case 0xcc: case 0xd0: return advance(1);
+            case 0xcd: case 0xd1: return advance(2);
+            case 0xce: case 0xd2: case 0xca: return advance(4);
+            case 0xcf: case 0xd3: case 0xcb: return advance(8);
+            case 0xc4: case 0xd9: return len<uint8_t>(n) && advance(n);   // bin8 / str8
+            case 0xc5: case 0xda: return len<uint16_t>(n) && advance(n);
+            case 0xc6: case 0xdb: return len<uint32_t>(n) && advance(n);
+            case 0xd4: return advance(2);                                 // fixext 1..16
+            case 0xd5: return advance(3);
+            case 0xd6: return advance(5);
+            case 0xd7: return advance(9);
+            case 0xd8: return advance(17);
+            case 0xc7: return len<uint8_t>(n) && advance(n + 1);          // ext8/16/32
+            case 0xc8: return len<uint16_t>(n) && advance(n + 1);
+            case 0xc9: return len<uint32_t>(n) && advance(n + 1);
+            case 0xdc: return len<uint16_t>(n) && skip_items(n, depth);
+            case 0xdd: return len<uint32_t>(n) && skip_items(n, depth);
+            case 0xde: return len<uint16_t>(n) && skip_items(2 * n, depth);
+            case 0xdf: return len<uint32_t>(n) && skip_items(2 * n, depth);
+            default:   return false;                                      // 0xc1 保留
+        }
+    }
+
+    /// 跳过数组剩余元素
+    bool skip_items(size_t n, int depth = 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (!skip(depth + 1)) return false;
+        }
+        return true;
+    }
+
+    /// 剩余字节数 (用于在分配前校验数组长度)
+    size_t remaining() const { return static_cast<size_t>(end_ - p_); }
+
+private:
+    static constexpr int kMaxDepth = 32;
+
+    bool get(uint8_t& b) {
+        if (p_ == end_) return false;
+        b = *p_++;
+        return true;
+    }
+
+    bool advance(size_t n) {
+        if (static_cast<size_t>(end_ - p_) < n) return false;
+        p_ += n;
+        return true;
+    }
+
+    template <typename T>
+    bool be(T& v) {
+        if (static_cast<size_t>(end_ - p_) < sizeof(T)) return false;
+        v = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            v = static_cast<T>((v << 8) | *p_++);
+        }
+        return true;
+    }
+
+    template <typename T>
+    bool len(size_t& n) {
+        T v;
+        if (!be(v)) return false;
+        n = static_cast<size_t>(v);
+        return true;
+    }
+
+    bool integer(int64_t& s, uint64_t& u, bool& is_unsigned) {
+        uint8_t tag;
+        if (!get(tag)) return false;
+        is_unsigned = false;
+
+        if (tag <= 0x7f) {
+            u = tag;
+            is_unsigned = true;
+            return true;
+        }
+        if (tag >= 0xe0) {
+            s = static_cast<int8_t>(tag);
+            return true;
+        }
+
+        switch (tag) {
+            case 0xcc: { uint8_t v;  if (!be(v)) return false; u = v; is_unsigned = true; return true; }
+            case 0xcd: { uint16_t v; if (!be(v)) return false; u = v; is_unsigned = true; return true; }
+            case 0xce: { uint32_t v; if (!be(v)) return false; u = v; is_unsigned = true; return true; }
+            case 0xcf: { if (!be(u)) return false; is_unsigned = true; return true; }
+            case 0xd0: { uint8_t v;  if (!be(v)) return false; s = static_cast<int8_t>(v);  return true; }
+            case 0xd1: { uint16_t v; if (!be(v)) return false; s = static_cast<int16_t>(v); return true; }
+            case 0xd2: { uint32_t v; if (!be(v)) return false; s = static_cast<int32_t>(v); return true; }
+            case 0xd3: { uint64_t v; if (!be(v)) return false; s = static_cast<int64_t>(v); return true; }
+            default:   return false;
+        }
+    }
+
+    const uint8_t* p_;
+    const uint8_t* end_;
+};
+
+// 各结构体的字段数 (schema v1)
+constexpr size_t kFrameFields = 9;
+// 可选尾部字段 (仅为非默认值时写出, 未使用时与旧版本逐字节一致):
+//   FrameResult [9] repeated, ModelResult [4] predicted, Detection [7] track_id
+constexpr size_t kFrameRepeatedField = 9;
+constexpr size_t kModelPredictedField = 4;
+constexpr size_t kDetectionTrackField = 7;
+constexpr size_t kModelFields = 4;
+constexpr size_t kDetectionFields = 7;
+
+bool read_detection(Reader& r, Detection& d) {
+    size_t n;
+    if (!r.array(n) || n < kDetectionFields) return false;
+    if (!r.i32(d.class_id) || !r.str(d.class_name) || !r.f32(d.confidence) ||
+        !r.f32(d.bbox.x1) || !r.f32(d.bbox.y1) || !r.f32(d.bbox.x2) || !r.f32(d.bbox.y2)) {
+        return false;
+    }
+    size_t extra = n - kDetectionFields;
+    if (extra > 0 && r.optional_i32(d.track_id)) {
+        extra--;
+    }
+    return r.skip_items(extra);
+}
+
+bool read_model(Reader& r, ModelResult& m) {
+    size_t n;
+    if (!r.array(n) || n < kModelFields) return false;
+    if (!r.str(m.task_name) || !r.str(m.model_path) || !r.f64(m.inference_time_ms)) {
+        return false;
+    }
+
+    size_t count;
+    // 每个元素至少 1 字节, 防止伪造的长度触发大块分配
+    if (!r.array(count) || count > r.remaining()) return false;
+    m.detections.resize(count);
+    for (auto& d : m.detections) {
+        if (!read_detection(r, d)) return false;
+    }
+    size_t extra = n - kModelFields;
+    if (extra > 0 && r.boolean(m.predicted)) {
+        extra--;
+    }
+    return r.skip_items(extra);
+}
+
+} // namespace
+
+void encode_msgpack(const FrameResult& result, std::vector<uint8_t>& out) {
+    out.clear();
+    Writer w(out);
+
+    w.array(result.repeated ? kFrameRepeatedField + 1 : kFrameFields);
+    w.uint(kMsgpackSchemaVersion);
+    w.str(result.cam_id);
+    w.str(result.rtsp_url);
+    w.uint(result.frame_id);
+    w.sint(result.timestamp_ms);
+    w.sint(result.pts);
+    w.sint(result.original_width);
+    w.sint(result.original_height);
+
+    w.array(result.results.size());
+    for (const auto& m : result.results) {
+        w.array(m.predicted ? kModelPredictedField + 1 : kModelFields);
+        w.str(m.task_name);
+        w.str(m.model_path);
+        w.f64(m.inference_time_ms);
+        w.array(m.detections.size());
+        for (const auto& d : m.detections) {
+            bool tracked = d.track_id >= 0;
+            w.array(tracked ? kDetectionTrackField + 1 : kDetectionFields);
+            w.sint(d.class_id);
+            w.str(d.class_name);
+            w.f32(d.confidence);
+            w.f32(d.bbox.x1);
+            w.f32(d.bbox.y1);
+            w.f32(d.bbox.x2);
+            w.f32(d.bbox.y2);
+            if (tracked) {
+                w.sint(d.track_id);
+            }
+        }
+        if (m.predicted) {
+            w.boolean(true);
+        }
+    }
+    if (result.repeated) {
+        w.boolean(true);
+    }
+}
+
+std::string make_topic(const std::string& cam_id, const std::string& task_name) {
+    std::string topic;
+    topic.reserve(cam_id.size() + 1 + task_name.size());
+    topic += cam_id;
+    topic += '/';
+    topic += task_name;
+    return topic;
+}
+
+std::string encode_json(const FrameResult& result) {
+    nlohmann::json j = result;
+    return j.dump();
+}
+
+std::optional<OutputFormat> detect_format(const void* data, size_t size) {
+    if (!data || size == 0) return std::nullopt;
+    uint8_t first = *static_cast<const uint8_t*>(data);
+    if (first == '{') return OutputFormat::JSON;
+    if ((first & 0xf0) == 0x90 || first == 0xdc || first == 0xdd) return OutputFormat::MSGPACK;
+    return std::nullopt;
+}
+
+std::optional<FrameResult> decode_msgpack(const void* data, size_t size) {
+    if (!data) return std::nullopt;
+    Reader r(static_cast<const uint8_t*>(data), size);
+
+    size_t n;
+    uint64_t version;
+    if (!r.array(n) || n < kFrameFields) return std::nullopt;
+    if (!r.u64(version) || version != static_cast<uint64_t>(kMsgpackSchemaVersion)) {
+        return std::nullopt;
+    }
+
+    FrameResult result;
+    if (!r.str(result.cam_id) || !r.str(result.rtsp_url) ||
+        !r.u64(result.frame_id) || !r.i64(result.timestamp_ms) || !r.i64(result.pts) ||
+        !r.i32(result.original_width) || !r.i32(result.original_height)) {
+        return std::nullopt;
+    }
+
+    size_t count;
+    if (!r.array(count) || count > r.remaining()) return std::nullopt;
+    result.results.resize(count);
+    for (auto& m : result.results) {
+        if (!read_model(r, m)) return std::nullopt;
+    }
+
+    size_t extra = n - kFrameFields;
+    if (extra > 0 && r.boolean(result.repeated)) {
+        extra--;
+    }
+    if (!r.skip_items(extra) || !r.at_end()) return std::nullopt;
+    return result;
+}
+
+std::optional<FrameResult> decode(const void* data, size_t size) {
+    auto format = detect_format(data, size);
+    if (!format) return std::nullopt;
+
+    if (*format == OutputFormat::MSGPACK) {
+        return decode_msgpack(data, size);
+    }
+
+    const char* text = static_cast<const char*>(data);
+    auto j = nlohmann::json::parse(text, text + size, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) return std::nullopt;
+    try {
+        return j.get<FrameResult>();
+    } catch (const nlohmann::json::exception&) {
+        return std::nullopt;
+    }
+}
+
+} // namespace result_codec
+} // namespace infer_server
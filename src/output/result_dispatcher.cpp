@@ -0,0 +1,116 @@
+/**
+ * @file result_dispatcher.cpp
+ * @brief 推理结果输出阶段实现
+ */
+
+#include "infer_server/output/result_dispatcher.h"
+#include "infer_server/common/logger.h"
+#include "infer_server/common/thread_policy.h"
+#include <algorithm>
+#include <functional>
+#include <string>
+
+namespace infer_server {
+
+ResultDispatcher::ResultDispatcher(int num_threads, size_t queue_size)
+    : num_threads_(std::max(num_threads, 0))
+{
+    queues_.reserve(static_cast<size_t>(num_threads_));
+    for (int i = 0; i < num_threads_; i++) {
+        queues_.push_back(std::make_unique<BoundedQueue<FrameResult>>(std::max<size_t>(queue_size, 1)));
+    }
+}
+
+ResultDispatcher::~ResultDispatcher() {
+    stop();
+}
+
+void ResultDispatcher::add_sink(Sink sink) {
+    if (running_.load()) {
+        LOG_WARN("ResultDispatcher: add_sink() after start() ignored");
+        return;
+    }
+    sinks_.push_back(std::move(sink));
+}
+
+void ResultDispatcher::start() {
+    if (running_.exchange(true)) return;
+
+    for (auto& q : queues_) q->reset();
+    threads_.reserve(queues_.size());
+    for (size_t i = 0; i < queues_.size(); i++) {
+        threads_.emplace_back(&ResultDispatcher::run, this, i);
+    }
+    LOG_INFO("ResultDispatcher started: {} thread(s), {} sink(s)", num_threads_, sinks_.size());
+}
+
+bool ResultDispatcher::post(FrameResult result) {
+    if (!running_.load(std::memory_order_relaxed)) return false;
+    posted_.fetch_add(1, std::memory_order_relaxed);
+
+    if (queues_.empty()) {
+        dispatch(result);
+        return true;
+    }
+    return queues_[shard_of(result.cam_id)]->push(std::move(result));
+}
+
+void ResultDispatcher::stop() {
+    if (!running_.exchange(false)) return;
+
+    // 停止队列: 输出线程处理完剩余结果后退出
+    for (auto& q : queues_) q->stop();
+    for (auto& t : threads_) {
+        if (t.joinable()) t.join();
+    }
+    threads_.clear();
+
+    LOG_INFO("ResultDispatcher stopped (dispatched {} results)", dispatched_.load());
+}
+
+ResultDispatcher::Stats ResultDispatcher::get_stats() const {
+    Stats s;
+    s.posted = posted_.load(std::memory_order_relaxed);
+    s.dispatched = dispatched_.load(std::memory_order_relaxed);
+    for (const auto& q : queues_) {
+        s.dropped += q->dropped_count();
+        s.queued += q->size();
+    }
+    return s;
+}
+
+// ============================================================
+// Private
+// ============================================================
+
+void ResultDispatcher::run(size_t shard) {
+    ThreadPolicy::instance().apply(ThreadRole::Output, "output-" + std::to_string(shard),
+                                   static_cast<int>(shard));
+    auto& queue = *queues_[shard];
+    while (true) {
+        auto result = queue.pop(std::chrono::milliseconds(100));
+        if (!result) {
+            if (queue.is_stopped() && queue.empty()) break;
+            continue;
+        }
+        dispatch(*result);
+    }
+}
+
+void ResultDispatcher::dispatch(const FrameResult& result) {
+    for (const auto& sink : sinks_) {
+        try {
+            sink(result);
+        } catch (const std::exception& e) {
+            LOG_ERROR("ResultDispatcher: sink error for [{}] frame {}: {}",
+                      result.cam_id, result.frame_id, e.what());
+        }
+    }
+    dispatched_.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t ResultDispatcher::shard_of(const std::string& cam_id) const {
+    return std::hash<std::string>{}(cam_id) % queues_.size();
+}
+
+} // namespace infer_server
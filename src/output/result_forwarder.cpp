@@ -0,0 +1,162 @@
+/**
+ * @file result_forwarder.cpp
+ * @brief ZeroMQ XSUB/XPUB 结果汇聚转发实现
+ */
+
+#ifdef HAS_CLUSTER_FORWARD
+
+#include "infer_server/output/result_forwarder.h"
+#include "infer_server/common/logger.h"
+#include "infer_server/common/thread_policy.h"
+
+#include <zmq.hpp>
+
+#include <cerrno>
+#include <chrono>
+
+namespace infer_server {
+
+namespace {
+
+/// 每次 poll 唤醒后单方向最多转发的消息数 (两个方向交替, 订阅消息不被结果流饿死)
+constexpr int kBurst = 256;
+
+/// 转发一条完整消息 (所有 multipart 帧), 没有待读消息返回 false
+bool forward_message(zmq::socket_t& from, zmq::socket_t& to) {
+    while (true) {
+        zmq::message_t msg;
+        if (!from.recv(msg, zmq::recv_flags::dontwait)) return false;
+        bool more = msg.more();
+        // XPUB 没有订阅者或达到高水位时直接丢弃, 不阻塞
+        (void)to.send(msg, more ? zmq::send_flags::sndmore : zmq::send_flags::dontwait);
+        if (!more) return true;
+    }
+}
+
+} // namespace
+
+ResultForwarder::ResultForwarder(std::string bind_endpoint)
+    : bind_endpoint_(std::move(bind_endpoint)) {}
+
+ResultForwarder::~ResultForwarder() {
+    stop();
+}
+
+bool ResultForwarder::start() {
+    if (running_.exchange(true)) return bound_.load();
+    bind_done_ = false;
+    thread_ = std::thread(&ResultForwarder::run, this);
+    while (!bind_done_.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    if (!bound_.load()) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void ResultForwarder::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+}
+
+void ResultForwarder::set_upstreams(const std::vector<std::string>& endpoints) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::set<std::string> next(endpoints.begin(), endpoints.end());
+    next.erase(std::string());
+    if (next != upstreams_) {
+        upstreams_ = std::move(next);
+        upstreams_changed_ = true;
+    }
+}
+
+void ResultForwarder::run() {
+    ThreadPolicy::instance().apply(ThreadRole::Output, "zmq-forward");
+
+    try {
+        // socket 只在本线程使用
+        zmq::context_t ctx(1);
+        zmq::socket_t xsub(ctx, zmq::socket_type::xsub);
+        zmq::socket_t xpub(ctx, zmq::socket_type::xpub);
+        xsub.set(zmq::sockopt::linger, 0);
+        xpub.set(zmq::sockopt::linger, 0);
+        xpub.set(zmq::sockopt::sndhwm, 1000);
+        try {
+            xpub.bind(bind_endpoint_);
+        } catch (const zmq::error_t& e) {
+            LOG_ERROR("ResultForwarder: bind {} failed: {}", bind_endpoint_, e.what());
+            bind_done_ = true;
+            return;
+        }
+        bound_ = true;
+        bind_done_ = true;
+        LOG_INFO("ResultForwarder: publishing cluster results on {}", bind_endpoint_);
+
+        std::set<std::string> connected;
+        zmq::pollitem_t items[] = {
+            {xsub.handle(), 0, ZMQ_POLLIN, 0},
+            {xpub.handle(), 0, ZMQ_POLLIN, 0},
+        };
+
+        while (running_.load()) {
+            std::set<std::string> wanted;
+            bool changed = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (upstreams_changed_) {
+                    wanted = upstreams_;
+                    upstreams_changed_ = false;
+                    changed = true;
+                }
+            }
+            if (changed) {
+                for (const auto& ep : connected) {
+                    if (wanted.count(ep)) continue;
+                    try {
+                        xsub.disconnect(ep);
+                    } catch (const zmq::error_t&) {}
+                    LOG_INFO("ResultForwarder: disconnected {}", ep);
+                }
+                std::set<std::string> now_connected;
+                for (const auto& ep : wanted) {
+                    if (connected.count(ep)) {
+                        now_connected.insert(ep);
+                        continue;
+                    }
+                    try {
+                        xsub.connect(ep);   // 异步连接, 节点暂不可达时由 ZMQ 自动重连
+                        now_connected.insert(ep);
+                        LOG_INFO("ResultForwarder: connected {}", ep);
+                    } catch (const zmq::error_t& e) {
+                        LOG_WARN("ResultForwarder: connect {} failed: {}", ep, e.what());
+                    }
+                }
+                connected = std::move(now_connected);
+            }
+
+            try {
+                zmq::poll(items, 2, std::chrono::milliseconds(200));
+            } catch (const zmq::error_t& e) {
+                if (e.num() == EINTR) continue;     // 信号 (Ctrl+C) 打断, 由 running_ 决定是否退出
+                throw;
+            }
+            if (items[0].revents & ZMQ_POLLIN) {
+                for (int i = 0; i < kBurst && forward_message(xsub, xpub); i++) {
+                    forwarded_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            if (items[1].revents & ZMQ_POLLIN) {
+                // 订阅 / 取消订阅: 反向传给所有节点
+                for (int i = 0; i < kBurst && forward_message(xpub, xsub); i++) {}
+            }
+        }
+    } catch (const zmq::error_t& e) {
+        LOG_ERROR("ResultForwarder stopped: {}", e.what());
+        bind_done_ = true;
+    }
+}
+
+} // namespace infer_server
+
+#endif // HAS_CLUSTER_FORWARD
@@ -8,12 +8,75 @@
 #include "infer_server/output/zmq_publisher.h"
 #include "infer_server/common/logger.h"
 #include <zmq.hpp>
-#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <vector>
 
 namespace infer_server {
 
-ZmqPublisher::ZmqPublisher(const std::string& endpoint)
+// ============================================================
+// 发送缓冲回收
+// ============================================================
+
+struct ZmqPublisher::BufferRecycler : std::enable_shared_from_this<BufferRecycler> {
+    /// 一个发送中的消息缓冲; 发送期间持有回收器, 保证回调时回收器仍然存在
+    struct Slot {
+        std::vector<uint8_t> data;
+        std::shared_ptr<BufferRecycler> owner;
+    };
+
+    static constexpr size_t kMaxIdle = 128;                 ///< 不小于 sndhwm
+    static constexpr size_t kMaxIdleCapacity = 256 * 1024;  ///< 超大的缓冲不回收
+
+    ~BufferRecycler() {
+        for (auto* s : idle) delete s;
+    }
+
+    Slot* acquire() {
+        Slot* s = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!idle.empty()) {
+                s = idle.back();
+                idle.pop_back();
+            }
+        }
+        if (!s) s = new Slot();
+        s->owner = shared_from_this();
+        return s;
+    }
+
+    /// ZMQ free 回调 (可能在 ZMQ IO 线程调用)
+    static void release(void* /*data*/, void* hint) {
+        auto* s = static_cast<Slot*>(hint);
+        auto owner = std::move(s->owner);
+        if (s->data.capacity() <= kMaxIdleCapacity) {
+            std::lock_guard<std::mutex> lock(owner->mutex);
+            if (owner->idle.size() < kMaxIdle) {
+                owner->idle.push_back(s);
+                return;
+            }
+        }
+        delete s;
+    }
+
+    std::mutex mutex;
+    std::vector<Slot*> idle;
+};
+
+/// JSON 消息的 free 回调
+static void free_json_message(void* /*data*/, void* hint) {
+    delete static_cast<std::string*>(hint);
+}
+
+ZmqPublisher::ZmqPublisher(const std::string& endpoint, OutputFormat format)
+    : ZmqPublisher(endpoint, Options{format, TopicMode::NONE, false})
+{
+}
+
+ZmqPublisher::ZmqPublisher(const std::string& endpoint, const Options& options)
     : endpoint_(endpoint)
+    , options_(options)
+    , recycler_(std::make_shared<BufferRecycler>())
 {
 }
 
@@ -49,7 +112,9 @@ bool ZmqPublisher::init() {
         pub_socket_->bind(endpoint_);
 
         initialized_ = true;
-        LOG_INFO("ZmqPublisher initialized: {}", endpoint_);
+        LOG_INFO("ZmqPublisher initialized: {} (format={}, topics={}, skip_empty={})",
+                 endpoint_, output_format_name(options_.format),
+                 topic_mode_name(options_.topic_mode), options_.skip_empty);
         return true;
 
     } catch (const zmq::error_t& e) {
@@ -63,20 +128,82 @@ bool ZmqPublisher::init() {
 void ZmqPublisher::publish(const FrameResult& result) {
     if (!initialized_.load()) return;
 
+    if (options_.topic_mode == TopicMode::TASK) {
+        // 每个模型结果一条消息, 帧头字段相同
+        FrameResult part;
+        part.cam_id = result.cam_id;
+        part.rtsp_url = result.rtsp_url;
+        part.frame_id = result.frame_id;
+        part.timestamp_ms = result.timestamp_ms;
+        part.pts = result.pts;
+        part.original_width = result.original_width;
+        part.original_height = result.original_height;
+
+        for (const auto& mr : result.results) {
+            if (options_.skip_empty && mr.detections.empty()) {
+                skipped_count_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            part.results.assign(1, mr);
+            send_message(result_codec::make_topic(result.cam_id, mr.task_name), part);
+        }
+        return;
+    }
+
+    if (options_.skip_empty) {
+        bool empty = std::all_of(result.results.begin(), result.results.end(),
+            [](const ModelResult& mr) { return mr.detections.empty(); });
+        if (empty) {
+            skipped_count_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    send_message(options_.topic_mode == TopicMode::CAMERA
+                     ? result_codec::make_topic(result.cam_id) : std::string(),
+                 result);
+}
+
+void ZmqPublisher::send_message(const std::string& topic, const FrameResult& result) {
     try {
-        // JSON 序列化
-        nlohmann::json j = result;
-        std::string msg = j.dump();
+        // 序列化 (锁外), 缓冲所有权交给 message_t, 发送完成后由 free 回调释放
+        zmq::message_t zmq_msg;
+        if (options_.format == OutputFormat::MSGPACK) {
+            auto* slot = recycler_->acquire();
+            try {
+                result_codec::encode_msgpack(result, slot->data);
+                zmq_msg.rebuild(slot->data.data(), slot->data.size(),
+                                &BufferRecycler::release, slot);
+            } catch (...) {
+                BufferRecycler::release(nullptr, slot);
+                throw;
+            }
+        } else {
+            auto* text = new std::string(result_codec::encode_json(result));
+            try {
+                zmq_msg.rebuild(text->data(), text->size(), &free_json_message, text);
+            } catch (...) {
+                delete text;
+                throw;
+            }
+        }
 
-        // 发送
+        // 发送 (multipart 两帧在同一把锁内, 不会与其他线程的消息交错)
         std::lock_guard<std::mutex> lock(mutex_);
-        zmq::message_t zmq_msg(msg.data(), msg.size());
+        if (!topic.empty()) {
+            auto topic_result = pub_socket_->send(zmq::buffer(topic),
+                                                  zmq::send_flags::sndmore | zmq::send_flags::dontwait);
+            if (!topic_result.has_value()) {
+                LOG_WARN("ZMQ topic send returned no value (would block?)");
+                return;
+            }
+        }
         auto send_result = pub_socket_->send(zmq_msg, zmq::send_flags::dontwait);
 
         if (send_result.has_value()) {
             published_count_.fetch_add(1, std::memory_order_relaxed);
-            LOG_TRACE("ZMQ published: [{}] frame {} ({} bytes)",
-                      result.cam_id, result.frame_id, msg.size());
+            LOG_TRACE("ZMQ published: [{}] {} frame {} ({} bytes)",
+                      result.cam_id, topic, result.frame_id, *send_result);
         } else {
             LOG_WARN("ZMQ send returned no value (would block?)");
         }
@@ -2,6 +2,8 @@
 
 #include "infer_server/processor/rga_processor.h"
 #include "infer_server/common/logger.h"
+#include "infer_server/processor/rga_scheduler.h"
+#include "infer_server/common/buffer_pool.h"
 
 // RGA headers
 // 尝试使用 im2d API (现代接口), 回退到 rga.h
@@ -33,73 +35,488 @@
     }
 #endif
 
+#include <array>
 #include <cstring>
+#include <utility>
 #include <mutex>
+#include <unordered_map>
+#include <sys/ioctl.h>
+#include <linux/dma-buf.h>
 
-// RGA 全局互斥锁 - 修复线程安全问题
-// 根据调试分析（valgrind + gdb + tsan），RGA 库在多线程环境下存在内存损坏问题
-// 所有 RGA 操作必须通过这个锁进行串行化
-static std::mutex g_rga_mutex;
+// 注: 原先所有 RGA 操作通过进程级全局锁串行化 (曾在多线程下观察到内存损坏)。
+// 现在由 RgaScheduler 按核心串行化: 同一核心上的 job 仍然互斥,
+// 不同核心并行。rga_core_mask=0 时只有一个槽位, 等价于原全局锁。
 
 namespace infer_server {
 
-std::shared_ptr<std::vector<uint8_t>> RgaProcessor::nv12_to_rgb_resize(
-    const uint8_t* nv12_data, int src_w, int src_h,
-    int dst_w, int dst_h)
-{
-    if (!nv12_data || src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0) {
-        LOG_ERROR("RGA: invalid parameters src={}x{} dst={}x{}", src_w, src_h, dst_w, dst_h);
-        return nullptr;
+#if defined(RGA_USE_IM2D_HPP) || defined(RGA_USE_IM2D_C)
+namespace {
+
+/// importbuffer_fd 返回的 RGA handle (RAII, 析构时 releasebuffer_handle)
+class RgaHandle {
+public:
+    RgaHandle(int fd, size_t size)
+        : handle_(fd >= 0 ? importbuffer_fd(fd, static_cast<int>(size)) : 0) {}
+    ~RgaHandle() {
+        if (handle_) releasebuffer_handle(handle_);
     }
+    RgaHandle(const RgaHandle&) = delete;
+    RgaHandle& operator=(const RgaHandle&) = delete;
 
-    // RGA 要求宽高为偶数
-    dst_w = (dst_w + 1) & ~1;
-    dst_h = (dst_h + 1) & ~1;
+    bool valid() const { return handle_ != 0; }
+    rga_buffer_handle_t get() const { return handle_; }
 
-    // 分配输出缓冲区 (RGB888: 3 bytes per pixel)
-    size_t dst_size = static_cast<size_t>(dst_w) * dst_h * 3;
-    auto rgb_buf = std::make_shared<std::vector<uint8_t>>(dst_size);
+private:
+    rga_buffer_handle_t handle_;
+};
+
+int stride_or(int stride, int fallback) {
+    return stride > 0 ? stride : fallback;
+}
+
+/// resize + 色彩转换
+/// srect 宽高为 0 时读取整个 src, 否则只读取 src 中的该矩形 (ROI 裁剪);
+/// drect 宽高为 0 时写满整个 dst, 否则只写入 dst 中的该矩形 (letterbox)
+struct RgaOp {
+    rga_buffer_t src;
+    rga_buffer_t dst;
+    im_rect srect;
+    im_rect drect;
+};
+
+RgaOp make_op(const rga_buffer_t& src, const rga_buffer_t& dst,
+              im_rect drect = {}, im_rect srect = {}) {
+    return RgaOp{src, dst, srect, drect};
+}
+
+bool is_plain_resize(const RgaOp& op) {
+    return op.srect.width <= 0 && op.drect.width <= 0;
+}
+
+im_rect src_rect(const RgaOp& op) {
+    return op.srect.width > 0 ? op.srect : im_rect{0, 0, op.src.width, op.src.height};
+}
+
+im_rect dst_rect(const RgaOp& op) {
+    return op.drect.width > 0 ? op.drect : im_rect{0, 0, op.dst.width, op.dst.height};
+}
+
+#if defined(RGA_USE_IM2D_HPP)
+IM_STATUS run_op(im_job_handle_t job, const RgaOp& op) {
+    if (is_plain_resize(op)) return imresizeTask(job, op.src, op.dst);
+    return improcessTask(job, op.src, op.dst, rga_buffer_t{}, src_rect(op), dst_rect(op),
+                         im_rect{}, nullptr, 0);
+}
+#endif
+
+IM_STATUS run_op(const RgaOp& op) {
+    if (is_plain_resize(op)) return imresize(op.src, op.dst);
+    rga_buffer_t pat = {};
+    im_rect prect = {};
+    return improcess(op.src, op.dst, pat, src_rect(op), dst_rect(op), prect, IM_SYNC);
+}
+
+/// letterbox 填充值 (与 YOLO 训练时的灰色填充一致)
+constexpr uint8_t kPadValue = 114;
+
+/// 用 CPU 填充 RGB888 图像中 rect 以外的区域 (RGA3 核心不支持 color fill)
+/// @param stride 行步长 (像素)
+void fill_padding(uint8_t* rgb, int width, int height, int stride, const LetterboxTransform& t) {
+    size_t row_bytes = static_cast<size_t>(stride) * 3;
+    for (int row = 0; row < height; row++) {
+        uint8_t* line = rgb + row * row_bytes;
+        if (row < t.y || row >= t.y + t.h) {
+            std::memset(line, kPadValue, static_cast<size_t>(width) * 3);
+            continue;
+        }
+        if (t.x > 0) std::memset(line, kPadValue, static_cast<size_t>(t.x) * 3);
+        int right = t.x + t.w;
+        if (right < width) {
+            std::memset(line + static_cast<size_t>(right) * 3, kPadValue,
+                        static_cast<size_t>(width - right) * 3);
+        }
+    }
+}
+
+/// CPU 访问 DMA-BUF 的开始 / 结束 (结束时把 CPU cache 中的写入刷到内存, RGA / NPU 才能看到)
+void dma_buf_cpu_write(int fd, bool begin) {
+    struct dma_buf_sync sync = {};
+    sync.flags = (begin ? DMA_BUF_SYNC_START : DMA_BUF_SYNC_END) | DMA_BUF_SYNC_WRITE;
+    if (ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync) != 0) {
+        LOG_WARN("DMA_BUF_IOCTL_SYNC failed (fd={})", fd);
+    }
+}
+
+/**
+ * @brief 池化 DMA-BUF 已填充的 letterbox 边框
+ *
+ * RGA 只写入内容区域, 池化 tensor 循环复用时边框保持不变: 同一缓冲 (DmaBuffer::id) 与
+ * 同一几何变换只需 CPU 填充并同步一次。整帧写入 (无 letterbox 的 add_rgb) 后失效。
+ */
+class PaddingCache {
+public:
+    static PaddingCache& instance() {
+        static PaddingCache cache;
+        return cache;
+    }
+
+    bool filled(uint64_t id, const LetterboxTransform& t, int stride) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(id);
+        return it != entries_.end() && it->second == key(t, stride);
+    }
+
+    void mark(uint64_t id, const LetterboxTransform& t, int stride) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // id 不复用: 池中 tensor 释放后旧条目不会再命中, 超过上限时整体清空 (下一帧重新填充)
+        if (entries_.size() >= kMaxEntries) entries_.clear();
+        entries_[id] = key(t, stride);
+    }
+
+    void invalidate(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.erase(id);
+    }
+
+private:
+    static constexpr size_t kMaxEntries = 256;
+
+    using Key = std::array<int, 7>;
+    static Key key(const LetterboxTransform& t, int stride) {
+        return {t.model_w, t.model_h, t.x, t.y, t.w, t.h, stride};
+    }
+
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, Key> entries_;
+};
+
+/// 在调度器分配的核心上提交一组操作
+/// im2d.hpp: 多个操作合并为一个 job (imbeginJob / imresizeTask / improcessTask / imendJob)
+/// im2d.h:   逐个 imresize / improcess
+bool submit_ops(const std::vector<RgaOp>& ops) {
+    if (ops.empty()) return true;
+
+    auto lease = RgaScheduler::instance().acquire();
+    if (lease.core() != RgaCoreMask::AUTO) {
+        imconfig(IM_CONFIG_SCHEDULER_CORE, static_cast<uint64_t>(lease.core()));
+    }
+
+    IM_STATUS status = IM_STATUS_SUCCESS;
+
+#if defined(RGA_USE_IM2D_HPP)
+    if (ops.size() == 1) {
+        status = run_op(ops[0]);
+    } else {
+        im_job_handle_t job = imbeginJob();
+        if (job == 0) {
+            LOG_ERROR("RGA imbeginJob failed (core={})", lease.core());
+            return false;
+        }
+        for (const auto& op : ops) {
+            status = run_op(job, op);
+            if (status != IM_STATUS_SUCCESS) {
+                imcancelJob(job);
+                break;
+            }
+        }
+        if (status == IM_STATUS_SUCCESS) {
+            status = imendJob(job);
+        }
+    }
+#else
+    for (const auto& op : ops) {
+        status = run_op(op);
+        if (status != IM_STATUS_SUCCESS) break;
+    }
+#endif
+
+    if (status != IM_STATUS_SUCCESS) {
+        LOG_ERROR("RGA job ({} op(s), core={}) failed: {} (status={})",
+                  ops.size(), lease.core(), imStrError(status), static_cast<int>(status));
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+#endif
 
+// ============================================================
+// RgaFrameBatch
+// ============================================================
+
+struct RgaFrameBatch::Impl {
+    bool valid = false;
+    int src_w = 0;
+    int src_h = 0;
 #if defined(RGA_USE_IM2D_HPP) || defined(RGA_USE_IM2D_C)
-    // ========================
-    // 使用 im2d API
-    // ========================
-    // 使用 RGA 全局锁保护所有 RGA 操作，防止多线程并发导致的内存损坏
-    std::lock_guard<std::mutex> rga_lock(g_rga_mutex);
+    rga_buffer_t src = {};
+    std::vector<RgaOp> ops;
+    std::unique_ptr<RgaHandle> src_handle;            ///< DMA 源的导入 handle
+    std::vector<std::unique_ptr<RgaHandle>> handles;  ///< 目标 handle, submit 前保持导入
+#endif
+};
+
+RgaFrameBatch::RgaFrameBatch(const uint8_t* nv12_data, int src_w, int src_h)
+    : impl_(std::make_unique<Impl>())
+{
+    if (!nv12_data || src_w <= 0 || src_h <= 0) {
+        LOG_ERROR("RGA: invalid source {}x{}", src_w, src_h);
+        return;
+    }
+    impl_->src_w = src_w;
+    impl_->src_h = src_h;
 
+#if defined(RGA_USE_IM2D_HPP) || defined(RGA_USE_IM2D_C)
     // wrapbuffer_virtualaddr 参数说明：
     //   vir_addr: 虚拟地址
     //   width, height: 图像的逻辑宽高
     //   format: 像素格式
     //   wstride: 每行步长（像素），通常等于 width
     //   hstride: 图像的虚拟高度（像素），对于 NV12 就是 height
-
-    rga_buffer_t src_buf = wrapbuffer_virtualaddr(
+    impl_->src = wrapbuffer_virtualaddr(
         const_cast<uint8_t*>(nv12_data), src_w, src_h,
         RK_FORMAT_YCbCr_420_SP, src_w, src_h);
+    impl_->valid = true;
+#else
+    LOG_ERROR("RGA im2d API not available. Need im2d.h or im2d.hpp");
+#endif
+}
+
+RgaFrameBatch::RgaFrameBatch(const DmaBuffer& src)
+    : impl_(std::make_unique<Impl>())
+{
+    if (src.fd < 0 || src.width <= 0 || src.height <= 0) {
+        LOG_ERROR("RGA: invalid DMA source fd={} {}x{}", src.fd, src.width, src.height);
+        return;
+    }
+    impl_->src_w = src.width;
+    impl_->src_h = src.height;
+
+#if defined(RGA_USE_IM2D_HPP) || defined(RGA_USE_IM2D_C)
+    auto handle = std::make_unique<RgaHandle>(src.fd, src.size);
+    if (!handle->valid()) {
+        LOG_ERROR("RGA importbuffer_fd failed (fd={}, size={})", src.fd, src.size);
+        return;
+    }
+    impl_->src = wrapbuffer_handle(
+        handle->get(), src.width, src.height, RK_FORMAT_YCbCr_420_SP,
+        stride_or(src.wstride, src.width), stride_or(src.hstride, src.height));
+    impl_->src_handle = std::move(handle);
+    impl_->valid = true;
+#else
+    LOG_ERROR("RGA im2d API not available");
+#endif
+}
+
+RgaFrameBatch::~RgaFrameBatch() = default;
+
+bool RgaFrameBatch::valid() const {
+    return impl_->valid;
+}
+
+size_t RgaFrameBatch::size() const {
+#if defined(RGA_USE_IM2D_HPP) || defined(RGA_USE_IM2D_C)
+    return impl_->ops.size();
+#else
+    return 0;
+#endif
+}
+
+std::shared_ptr<std::vector<uint8_t>> RgaFrameBatch::add_rgb(int dst_w, int dst_h) {
+    if (!impl_->valid || dst_w <= 0 || dst_h <= 0) {
+        return nullptr;
+    }
+
+    // RGA 要求宽高为偶数
+    dst_w = (dst_w + 1) & ~1;
+    dst_h = (dst_h + 1) & ~1;
 
+    // 分配输出缓冲区 (RGB888: 3 bytes per pixel, 从全局缓冲池复用)
+    size_t dst_size = static_cast<size_t>(dst_w) * dst_h * 3;
+    auto rgb_buf = BufferPool::global().acquire(dst_size);
+
+#if defined(RGA_USE_IM2D_HPP) || defined(RGA_USE_IM2D_C)
     rga_buffer_t dst_buf = wrapbuffer_virtualaddr(
         rgb_buf->data(), dst_w, dst_h,
         RK_FORMAT_RGB_888, dst_w, dst_h);
+    impl_->ops.push_back(make_op(impl_->src, dst_buf));
+    return rgb_buf;
+#else
+    return nullptr;
+#endif
+}
 
-    // 执行缩放 + 色彩转换
-    // imresize 可以同时处理格式转换和缩放
-    IM_STATUS status = imresize(src_buf, dst_buf);
-    if (status != IM_STATUS_SUCCESS) {
-        LOG_ERROR("RGA imresize (NV12->RGB) failed: {} (status={})",
-                  imStrError(status), static_cast<int>(status));
+std::shared_ptr<std::vector<uint8_t>> RgaFrameBatch::add_nv12(int dst_w, int dst_h) {
+    if (!impl_->valid || dst_w <= 0 || dst_h <= 0) {
         return nullptr;
     }
 
-    LOG_TRACE("RGA NV12({}x{}) -> RGB({}x{}) success", src_w, src_h, dst_w, dst_h);
-    return rgb_buf;
+    dst_w = (dst_w + 1) & ~1;
+    dst_h = (dst_h + 1) & ~1;
 
+    // NV12 输出: Y + UV = w * h * 3/2
+    size_t dst_size = static_cast<size_t>(dst_w) * dst_h * 3 / 2;
+    auto nv12_buf = BufferPool::global().acquire(dst_size);
+
+#if defined(RGA_USE_IM2D_HPP) || defined(RGA_USE_IM2D_C)
+    rga_buffer_t dst_buf = wrapbuffer_virtualaddr(
+        nv12_buf->data(), dst_w, dst_h,
+        RK_FORMAT_YCbCr_420_SP, dst_w, dst_h);
+    impl_->ops.push_back(make_op(impl_->src, dst_buf));
+    return nv12_buf;
+#else
+    return nullptr;
+#endif
+}
+
+bool RgaFrameBatch::add_rgb(DmaBuffer& dst) {
+    if (!impl_->valid || dst.fd < 0 || dst.width <= 0 || dst.height <= 0) {
+        return false;
+    }
+
+#if defined(RGA_USE_IM2D_HPP) || defined(RGA_USE_IM2D_C)
+    auto handle = std::make_unique<RgaHandle>(dst.fd, dst.size);
+    if (!handle->valid()) {
+        LOG_ERROR("RGA importbuffer_fd failed (dst fd={})", dst.fd);
+        return false;
+    }
+    rga_buffer_t dst_buf = wrapbuffer_handle(
+        handle->get(), dst.width, dst.height, RK_FORMAT_RGB_888,
+        stride_or(dst.wstride, dst.width), stride_or(dst.hstride, dst.height));
+    impl_->handles.push_back(std::move(handle));
+    impl_->ops.push_back(make_op(impl_->src, dst_buf));
+    // 整帧写入覆盖了之前填充的边框
+    if (dst.id != 0) PaddingCache::instance().invalidate(dst.id);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool RgaFrameBatch::crop_fits(const CropRect& crop) const {
+    if (crop.empty()) return true;
+    // NV12 源的裁剪起点和宽高必须为偶数
+    if ((crop.x | crop.y | crop.width | crop.height) & 1) return false;
+    return crop.x >= 0 && crop.y >= 0 &&
+           crop.x + crop.width <= impl_->src_w && crop.y + crop.height <= impl_->src_h;
+}
+
+std::shared_ptr<std::vector<uint8_t>> RgaFrameBatch::add_rgb(const LetterboxTransform& transform,
+                                                             const CropRect& crop) {
+    if (!transform.has_padding() && crop.empty()) {
+        return add_rgb(transform.model_w, transform.model_h);
+    }
+    if (!impl_->valid || !transform.valid() || (transform.model_w & 1) || (transform.model_h & 1) ||
+        !crop_fits(crop)) {
+        return nullptr;
+    }
+
+    int dst_w = transform.model_w;
+    int dst_h = transform.model_h;
+    size_t dst_size = static_cast<size_t>(dst_w) * dst_h * 3;
+    auto rgb_buf = BufferPool::global().acquire(dst_size);
+
+#if defined(RGA_USE_IM2D_HPP) || defined(RGA_USE_IM2D_C)
+    // 池化缓冲区内容不确定, 每帧重新填充 (只写填充区域, 图像区域由 RGA 覆盖)
+    im_rect drect = {};
+    if (transform.has_padding()) {
+        fill_padding(rgb_buf->data(), dst_w, dst_h, dst_w, transform);
+        drect = im_rect{transform.x, transform.y, transform.w, transform.h};
+    }
+    rga_buffer_t dst_buf = wrapbuffer_virtualaddr(
+        rgb_buf->data(), dst_w, dst_h,
+        RK_FORMAT_RGB_888, dst_w, dst_h);
+    impl_->ops.push_back(make_op(impl_->src, dst_buf, drect,
+                                 im_rect{crop.x, crop.y, crop.width, crop.height}));
+    return rgb_buf;
 #else
-    LOG_ERROR("RGA im2d API not available. Need im2d.h or im2d.hpp");
     return nullptr;
 #endif
 }
 
+bool RgaFrameBatch::add_rgb(DmaBuffer& dst, const LetterboxTransform& transform,
+                            const CropRect& crop) {
+    if (!transform.has_padding() && crop.empty()) {
+        return add_rgb(dst);
+    }
+    // 填充区域需要 CPU 写入: 没有虚拟地址的 DMA-BUF 交给调用方走 CPU 内存路径
+    if (!impl_->valid || !transform.valid() || !crop_fits(crop) ||
+        (transform.has_padding() && !dst.virt_addr) ||
+        dst.width != transform.model_w || dst.height != transform.model_h) {
+        return false;
+    }
+
+#if defined(RGA_USE_IM2D_HPP) || defined(RGA_USE_IM2D_C)
+    auto handle = std::make_unique<RgaHandle>(dst.fd, dst.size);
+    if (!handle->valid()) {
+        LOG_ERROR("RGA importbuffer_fd failed (dst fd={})", dst.fd);
+        return false;
+    }
+    int stride = stride_or(dst.wstride, dst.width);
+    im_rect drect = {};
+    if (transform.has_padding()) {
+        // 边框由 CPU 写入, RGA 只写内容区域: 池化缓冲每种变换只填充一次, 写完刷 cache 供 NPU 读取
+        if (dst.id == 0 || !PaddingCache::instance().filled(dst.id, transform, stride)) {
+            dma_buf_cpu_write(dst.fd, true);
+            fill_padding(static_cast<uint8_t*>(dst.virt_addr), dst.width, dst.height, stride, transform);
+            dma_buf_cpu_write(dst.fd, false);
+            if (dst.id != 0) PaddingCache::instance().mark(dst.id, transform, stride);
+        }
+        drect = im_rect{transform.x, transform.y, transform.w, transform.h};
+    }
+    rga_buffer_t dst_buf = wrapbuffer_handle(
+        handle->get(), dst.width, dst.height, RK_FORMAT_RGB_888,
+        stride, stride_or(dst.hstride, dst.height));
+    impl_->handles.push_back(std::move(handle));
+    impl_->ops.push_back(make_op(impl_->src, dst_buf, drect,
+                                 im_rect{crop.x, crop.y, crop.width, crop.height}));
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool RgaFrameBatch::submit() {
+    if (!impl_->valid) return false;
+
+#if defined(RGA_USE_IM2D_HPP) || defined(RGA_USE_IM2D_C)
+    bool ok = submit_ops(impl_->ops);
+    if (ok) {
+        LOG_TRACE("RGA batch NV12({}x{}) -> {} output(s) success",
+                  impl_->src_w, impl_->src_h, impl_->ops.size());
+    }
+    impl_->ops.clear();
+    impl_->handles.clear();
+    return ok;
+#else
+    return false;
+#endif
+}
+
+// ============================================================
+// RgaProcessor (单输出便捷接口)
+// ============================================================
+
+std::shared_ptr<std::vector<uint8_t>> RgaProcessor::nv12_to_rgb_resize(
+    const uint8_t* nv12_data, int src_w, int src_h,
+    int dst_w, int dst_h)
+{
+    if (!nv12_data || src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0) {
+        LOG_ERROR("RGA: invalid parameters src={}x{} dst={}x{}", src_w, src_h, dst_w, dst_h);
+        return nullptr;
+    }
+
+    RgaFrameBatch batch(nv12_data, src_w, src_h);
+    auto rgb_buf = batch.add_rgb(dst_w, dst_h);
+    if (!rgb_buf || !batch.submit()) {
+        return nullptr;
+    }
+
+    LOG_TRACE("RGA NV12({}x{}) -> RGB({}x{}) success", src_w, src_h, dst_w, dst_h);
+    return rgb_buf;
+}
+
 std::shared_ptr<std::vector<uint8_t>> RgaProcessor::nv12_resize(
     const uint8_t* nv12_data, int src_w, int src_h,
     int dst_w, int dst_h)
@@ -114,13 +531,9 @@ std::shared_ptr<std::vector<uint8_t>> RgaProcessor::nv12_resize(
 
     // NV12 输出: Y + UV = w * h * 3/2
     size_t dst_size = static_cast<size_t>(dst_w) * dst_h * 3 / 2;
-    auto nv12_out = std::make_shared<std::vector<uint8_t>>(dst_size);
+    auto nv12_out = BufferPool::global().acquire(dst_size);
 
 #if defined(RGA_USE_IM2D_HPP) || defined(RGA_USE_IM2D_C)
-    // 使用 RGA 全局锁保护所有 RGA 操作，防止多线程并发导致的内存损坏
-    // 注意：wrapbuffer_virtualaddr 也必须在锁内调用，因为 RGA 库内部可能访问全局状态
-    std::lock_guard<std::mutex> rga_lock(g_rga_mutex);
-
     rga_buffer_t src_buf = wrapbuffer_virtualaddr(
         const_cast<uint8_t*>(nv12_data), src_w, src_h,
         RK_FORMAT_YCbCr_420_SP, src_w, src_h);
@@ -129,10 +542,7 @@ std::shared_ptr<std::vector<uint8_t>> RgaProcessor::nv12_resize(
         nv12_out->data(), dst_w, dst_h,
         RK_FORMAT_YCbCr_420_SP, dst_w, dst_h);
 
-    IM_STATUS status = imresize(src_buf, dst_buf);
-    if (status != IM_STATUS_SUCCESS) {
-        LOG_ERROR("RGA imresize (NV12->NV12) failed: {} (status={})",
-                  imStrError(status), static_cast<int>(status));
+    if (!submit_ops({make_op(src_buf, dst_buf)})) {
         return nullptr;
     }
 
@@ -145,6 +555,42 @@ std::shared_ptr<std::vector<uint8_t>> RgaProcessor::nv12_resize(
 #endif
 }
 
+std::shared_ptr<std::vector<uint8_t>> RgaProcessor::nv12_to_rgb_resize(
+    const DmaBuffer& src, int dst_w, int dst_h)
+{
+    RgaFrameBatch batch(src);
+    auto rgb_buf = batch.add_rgb(dst_w, dst_h);
+    if (!rgb_buf || !batch.submit()) {
+        return nullptr;
+    }
+
+    LOG_TRACE("RGA NV12 fd({}x{}) -> RGB({}x{}) success", src.width, src.height, dst_w, dst_h);
+    return rgb_buf;
+}
+
+bool RgaProcessor::nv12_to_rgb_resize(const DmaBuffer& src, DmaBuffer& dst) {
+    RgaFrameBatch batch(src);
+    if (!batch.add_rgb(dst) || !batch.submit()) {
+        return false;
+    }
+
+    LOG_TRACE("RGA NV12 fd({}x{}) -> RGB fd({}x{}) success",
+              src.width, src.height, dst.width, dst.height);
+    return true;
+}
+
+bool RgaProcessor::nv12_to_rgb_resize(const uint8_t* nv12_data, int src_w, int src_h,
+                                      DmaBuffer& dst)
+{
+    RgaFrameBatch batch(nv12_data, src_w, src_h);
+    if (!batch.add_rgb(dst) || !batch.submit()) {
+        return false;
+    }
+
+    LOG_TRACE("RGA NV12({}x{}) -> RGB fd({}x{}) success", src_w, src_h, dst.width, dst.height);
+    return true;
+}
+
 int RgaProcessor::calc_proportional_height(int src_w, int src_h, int target_w) {
     if (src_w <= 0 || src_h <= 0 || target_w <= 0) return 0;
     int h = (target_w * src_h) / src_w;
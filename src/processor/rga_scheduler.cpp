@@ -0,0 +1,124 @@
+/**
+ * @file rga_scheduler.cpp
+ * @brief RGA 多核心调度器实现
+ */
+
+#include "infer_server/processor/rga_scheduler.h"
+
+namespace infer_server {
+
+RgaScheduler& RgaScheduler::instance() {
+    static RgaScheduler* scheduler = new RgaScheduler();
+    return *scheduler;
+}
+
+RgaScheduler::RgaScheduler(int core_mask) {
+    build_slots(core_mask);
+}
+
+void RgaScheduler::build_slots(int core_mask) {
+    slots_.clear();
+    for (int bit = 0; bit < 8; bit++) {
+        int core = 1 << bit;
+        if (core_mask & core) {
+            auto slot = std::make_unique<Slot>();
+            slot->core = core;
+            slots_.push_back(std::move(slot));
+        }
+    }
+    if (slots_.empty()) {
+        auto slot = std::make_unique<Slot>();
+        slot->core = RgaCoreMask::AUTO;
+        slots_.push_back(std::move(slot));
+    }
+}
+
+bool RgaScheduler::configure(int core_mask) {
+    if (started_.load()) {
+        return false;
+    }
+    build_slots(core_mask);
+    return true;
+}
+
+RgaScheduler::Lease RgaScheduler::acquire() {
+    started_.store(true, std::memory_order_relaxed);
+    {
+        std::unique_lock<std::mutex> lock(gate_mutex_);
+        gate_cv_.wait(lock, [this]() { return npu_inits_ == 0 && npu_waiting_ == 0; });
+        rga_active_++;
+    }
+
+    size_t n = slots_.size();
+    size_t start = next_.fetch_add(1, std::memory_order_relaxed) % n;
+
+    // 1. 轮询起点开始, 优先取空闲核心
+    for (size_t i = 0; i < n; i++) {
+        Slot* slot = slots_[(start + i) % n].get();
+        if (slot->mutex.try_lock()) {
+            slot->jobs.fetch_add(1, std::memory_order_relaxed);
+            wait_hist_.record_us(0);
+            return Lease(this, slot);
+        }
+    }
+
+    // 2. 全部忙碌: 排队到等待者最少的核心
+    Slot* best = slots_[start].get();
+    for (size_t i = 1; i < n; i++) {
+        Slot* slot = slots_[(start + i) % n].get();
+        if (slot->waiting.load(std::memory_order_relaxed) <
+            best->waiting.load(std::memory_order_relaxed)) {
+            best = slot;
+        }
+    }
+
+    best->waiting.fetch_add(1, std::memory_order_relaxed);
+    int64_t t_wait = mono_now_ns();
+    best->mutex.lock();
+    int64_t wait_ns = mono_now_ns() - t_wait;
+    best->waiting.fetch_sub(1, std::memory_order_relaxed);
+    best->wait_ns.fetch_add(static_cast<uint64_t>(wait_ns), std::memory_order_relaxed);
+    wait_hist_.record_ns(wait_ns);
+    best->contended.fetch_add(1, std::memory_order_relaxed);
+    best->jobs.fetch_add(1, std::memory_order_relaxed);
+    return Lease(this, best);
+}
+
+void RgaScheduler::leave_rga() {
+    std::lock_guard<std::mutex> lock(gate_mutex_);
+    if (--rga_active_ == 0 && npu_waiting_ > 0) gate_cv_.notify_all();
+}
+
+RgaScheduler::NpuInit RgaScheduler::begin_npu_init() {
+    std::unique_lock<std::mutex> lock(gate_mutex_);
+    npu_waiting_++;
+    gate_cv_.wait(lock, [this]() { return rga_active_ == 0; });
+    npu_waiting_--;
+    npu_inits_++;
+    return NpuInit(this);
+}
+
+void RgaScheduler::end_npu_init() {
+    {
+        std::lock_guard<std::mutex> lock(gate_mutex_);
+        if (--npu_inits_ > 0 || npu_waiting_ > 0) return;
+    }
+    gate_cv_.notify_all();
+}
+
+std::vector<RgaScheduler::CoreStats> RgaScheduler::get_stats() const {
+    std::vector<CoreStats> stats;
+    stats.reserve(slots_.size());
+    for (const auto& slot : slots_) {
+        CoreStats cs;
+        cs.core = slot->core;
+        cs.jobs = slot->jobs.load(std::memory_order_relaxed);
+        cs.contended = slot->contended.load(std::memory_order_relaxed);
+        cs.waiting = slot->waiting.load(std::memory_order_relaxed);
+        cs.wait_us = slot->wait_ns.load(std::memory_order_relaxed) / 1000;
+        stats.push_back(cs);
+    }
+    return stats;
+}
+
+} // namespace infer_server
@@ -0,0 +1,193 @@
+/**
+ * @file admission_controller.cpp
+ * @brief 负载感知的帧准入控制实现
+ */
+
+#include "infer_server/stream/admission_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace infer_server {
+
+namespace {
+
+constexpr double kScaleMin = 0.05;      ///< 预算系数下限
+constexpr double kScaleMax = 2.0;       ///< 预算系数上限 (单帧开销含后处理, 流水线下实际 NPU 占用更低)
+constexpr double kDecrease = 0.8;       ///< 过载时乘性收紧
+constexpr double kIncrease = 0.1;       ///< 空闲时加性放宽
+constexpr double kMaxSourceFps = 240.0; ///< 超过该值视为解码器报告异常
+
+} // namespace
+
+// ============================================================
+// Stream
+// ============================================================
+
+AdmissionController::Stream::Stream(std::string cam_id, int frame_skip, double target_fps,
+                                    std::shared_ptr<StreamCounters> counters)
+    : cam_id_(std::move(cam_id))
+    , frame_skip_(std::max(1, frame_skip))
+    , counters_(std::move(counters))
+    , target_fps_(std::max(0.0, target_fps))
+{
+}
+
+bool AdmissionController::Stream::admit() {
+    double src = source_fps();
+    double ratio = std::min(1.0, allowed_fps() / src);
+
+    bool admitted = credit_ >= 1.0;
+    if (admitted) credit_ -= 1.0;
+    credit_ += ratio;
+
+    if (!admitted) rejected_.fetch_add(1, std::memory_order_relaxed);
+    return admitted;
+}
+
+void AdmissionController::Stream::set_source_fps(double fps) {
+    if (!(fps > 0.0) || fps > kMaxSourceFps) fps = 0.0;
+    source_fps_.store(fps, std::memory_order_relaxed);
+}
+
+void AdmissionController::Stream::set_target_fps(double fps) {
+    target_fps_.store(std::max(0.0, fps), std::memory_order_relaxed);
+    // 立即按新目标准入, 下一次 update() 再参与公平分配
+    allowed_fps_.store(demand_fps(), std::memory_order_relaxed);
+}
+
+double AdmissionController::Stream::source_fps() const {
+    double fps = source_fps_.load(std::memory_order_relaxed);
+    return fps > 0.0 ? fps : default_source_fps_;
+}
+
+double AdmissionController::Stream::demand_fps() const {
+    double src = source_fps();
+    double target = target_fps();
+    if (target > 0.0) return std::min(target, src);
+    return src / static_cast<double>(frame_skip_);
+}
+
+int AdmissionController::Stream::effective_skip() const {
+    double allowed = allowed_fps();
+    if (allowed <= 0.0) return 0;
+    return std::max(1, static_cast<int>(std::lround(source_fps() / allowed)));
+}
+
+// ============================================================
+// AdmissionController
+// ============================================================
+
+AdmissionController::AdmissionController(Options options, LoadProbe probe)
+    : options_(options), probe_(std::move(probe)) {}
+
+std::shared_ptr<AdmissionController::Stream> AdmissionController::add_stream(
+    const std::string& cam_id, int frame_skip, double target_fps,
+    std::shared_ptr<StreamCounters> counters)
+{
+    auto stream = std::make_shared<Stream>(cam_id, frame_skip, target_fps, std::move(counters));
+    stream->default_source_fps_ = options_.default_source_fps > 0.0 ? options_.default_source_fps : 25.0;
+    stream->allowed_fps_.store(stream->demand_fps(), std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.push_back(stream);
+    return stream;
+}
+
+void AdmissionController::remove_stream(const std::shared_ptr<Stream>& stream) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.erase(std::remove(streams_.begin(), streams_.end(), stream), streams_.end());
+}
+
+size_t AdmissionController::stream_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return streams_.size();
+}
+
+void AdmissionController::maybe_update(Clock::time_point now) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) return;
+        if (now - last_update_ < std::chrono::milliseconds(options_.update_interval_ms)) return;
+        last_update_ = now;
+    }
+    update(probe_ ? probe_() : LoadSample{});
+}
+
+void AdmissionController::update(const LoadSample& load) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // === 1. 全局预算系数 (AIMD) ===
+    uint64_t dropped_delta = load.dropped >= last_dropped_ ? load.dropped - last_dropped_ : 0;
+    last_dropped_ = load.dropped;
+
+    double scale = scale_.load(std::memory_order_relaxed);
+    if (load.queue_capacity > 0) {
+        double fill = static_cast<double>(load.queue_depth) / static_cast<double>(load.queue_capacity);
+        if (dropped_delta > 0 || fill >= options_.queue_high) {
+            scale *= kDecrease;
+        } else if (fill <= options_.queue_low) {
+            scale += kIncrease;
+        }
+    }
+    scale = std::clamp(scale, kScaleMin, kScaleMax);
+    scale_.store(scale, std::memory_order_relaxed);
+
+    if (streams_.empty()) return;
+
+    // === 2. 每路流的请求帧率与单帧开销 ===
+    struct Demand {
+        Stream* stream;
+        double fps;
+        double cost_ms;
+    };
+    std::vector<Demand> demands;
+    demands.reserve(streams_.size());
+
+    double known_cost = 0.0;
+    size_t known = 0;
+    for (const auto& s : streams_) {
+        double cost = s->counters_ ? s->counters_->frame_cost_ms.load(std::memory_order_relaxed) : 0.0;
+        if (cost > 0.0) {
+            known_cost += cost;
+            known++;
+        }
+        demands.push_back({s.get(), s->demand_fps(), cost});
+    }
+
+    // 还没有推理结果的流按已知流的平均开销估计
+    double mean_cost = known > 0 ? known_cost / static_cast<double>(known) : 0.0;
+    for (auto& d : demands) {
+        if (d.cost_ms <= 0.0) d.cost_ms = mean_cost;
+    }
+
+    auto publish = [this](const Demand& d, double fps) {
+        double floor = std::min(options_.min_fps, d.fps);
+        d.stream->allowed_fps_.store(std::clamp(fps, floor, d.fps), std::memory_order_relaxed);
+    };
+
+    // 没有 NPU 开销信息 (尚无结果 / 无推理引擎): 只按系数缩放
+    if (load.workers == 0 || mean_cost <= 0.0) {
+        double factor = std::min(1.0, scale);
+        for (const auto& d : demands) publish(d, d.fps * factor);
+        return;
+    }
+
+    // === 3. 按 NPU 时间 max-min 公平分配 ===
+    double remaining = static_cast<double>(load.workers) * 1000.0 * scale;  // ms / s
+    std::sort(demands.begin(), demands.end(), [](const Demand& a, const Demand& b) {
+        return a.fps * a.cost_ms < b.fps * b.cost_ms;
+    });
+
+    size_t n = demands.size();
+    for (size_t i = 0; i < n; i++) {
+        const auto& d = demands[i];
+        double need = d.fps * d.cost_ms;
+        double share = remaining / static_cast<double>(n - i);
+        double grant = std::min(need, share);
+        remaining -= grant;
+        publish(d, grant / d.cost_ms);
+    }
+}
+
+} // namespace infer_server
@@ -0,0 +1,171 @@
+/**
+ * @file decode_scheduler.cpp
+ * @brief 解码任务调度器与视频包到达预测实现
+ */
+
+#include "infer_server/stream/decode_scheduler.h"
+#include "infer_server/common/logger.h"
+#include "infer_server/common/thread_policy.h"
+
+#include <algorithm>
+
+namespace infer_server {
+
+DecodeScheduler::DecodeScheduler(int num_threads) {
+    int n = std::max(1, num_threads);
+    threads_.reserve(static_cast<size_t>(n));
+    for (int i = 0; i < n; i++) {
+        threads_.emplace_back(&DecodeScheduler::run, this, i);
+    }
+    LOG_INFO("DecodeScheduler started: {} thread(s)", n);
+}
+
+DecodeScheduler::~DecodeScheduler() {
+    stop();
+}
+
+uint64_t DecodeScheduler::add(std::string name, StepFn step, bool parked) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t id = next_id_++;
+    Task& task = tasks_[id];
+    task.name = std::move(name);
+    task.step = std::move(step);
+    if (parked) {
+        task.due = kParked;
+        return id;
+    }
+    task.due = Clock::now();
+    timers_.emplace(task.due, id);
+    cv_.notify_one();
+    return id;
+}
+
+void DecodeScheduler::wake(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tasks_.find(id);
+    if (it == tasks_.end()) return;
+    Task& task = it->second;
+    if (task.running) {
+        task.woken = true;
+        return;
+    }
+    auto now = Clock::now();
+    if (task.due <= now) return;
+    timers_.erase({task.due, id});
+    task.due = now;
+    timers_.emplace(now, id);
+    cv_.notify_one();
+}
+
+void DecodeScheduler::wait(uint64_t id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [&] { return stopping_ || tasks_.count(id) == 0; });
+}
+
+void DecodeScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ && threads_.empty()) return;
+        stopping_ = true;
+        if (!tasks_.empty()) {
+            LOG_WARN("DecodeScheduler stopping with {} unfinished task(s)", tasks_.size());
+        }
+    }
+    cv_.notify_all();
+    done_cv_.notify_all();
+    for (auto& t : threads_) {
+        if (t.joinable()) t.join();
+    }
+    threads_.clear();
+}
+
+DecodeScheduler::Stats DecodeScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s;
+    s.threads = static_cast<int>(threads_.size());
+    s.tasks = tasks_.size();
+    s.busy = busy_;
+    s.steps = steps_;
+    s.lag_ms = lag_ms_;
+    return s;
+}
+
+void DecodeScheduler::run(int index) {
+    ThreadPolicy::instance().apply(ThreadRole::Decode, "decode-" + std::to_string(index), index);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (timers_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+        auto [due, id] = *timers_.begin();
+        auto now = Clock::now();
+        if (due > now) {
+            cv_.wait_until(lock, due);
+            continue;
+        }
+        timers_.erase(timers_.begin());
+
+        Task& task = tasks_.at(id);
+        task.running = true;
+        task.woken = false;
+        busy_++;
+        double lag = std::chrono::duration<double, std::milli>(now - due).count();
+        lag_ms_ = steps_ == 0 ? lag : lag_ms_ * 0.95 + lag * 0.05;
+        steps_++;
+        // 还有到期任务时唤醒其他线程
+        if (!timers_.empty() && timers_.begin()->first <= now) cv_.notify_one();
+
+        // 单步在锁外执行; 任务运行期间不会被移除, 引用保持有效 (std::map 节点稳定)
+        lock.unlock();
+        std::optional<Clock::time_point> next;
+        try {
+            next = task.step();
+        } catch (const std::exception& e) {
+            LOG_ERROR("DecodeScheduler: task {} threw: {}", task.name, e.what());
+        }
+        lock.lock();
+
+        busy_--;
+        task.running = false;
+        if (!next) {
+            tasks_.erase(id);
+            done_cv_.notify_all();
+            continue;
+        }
+        task.due = task.woken ? Clock::now() : *next;
+        if (task.due == kParked) continue;     // 挂起: 不进入定时器, 等待 wake()
+        timers_.emplace(task.due, id);
+        cv_.notify_one();
+    }
+}
+
+// ============================================================
+// ArrivalPredictor
+// ============================================================
+
+ArrivalPredictor::Clock::time_point ArrivalPredictor::next_read(
+    Clock::time_point now, int64_t pts_ms, bool blocked, double fps)
+{
+    if (fps <= 0.0) return now;
+
+    int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        now.time_since_epoch()).count();
+    int64_t offset = now_us - pts_ms * 1000;
+    // 阻塞读取说明包刚到达: 以此为准; 否则只在观测到更早的到达时下调 (包不可能早于到达被读到)
+    if (!has_offset_ || blocked || offset < offset_us_) {
+        offset_us_ = offset;
+        has_offset_ = true;
+    }
+
+    auto interval_us = static_cast<int64_t>(1e6 / fps);
+    int64_t expected_us = pts_ms * 1000 + offset_us_;   // 本包的期望到达时刻
+    if (now_us - expected_us > interval_us / 2) {
+        return now;     // 积压: 继续读
+    }
+    auto next_us = expected_us + interval_us + guard_.count();
+    return Clock::time_point(std::chrono::microseconds(std::max(next_us, now_us)));
+}
+
+} // namespace infer_server
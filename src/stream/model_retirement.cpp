@@ -0,0 +1,83 @@
+/**
+ * @file model_retirement.cpp
+ * @brief 热切换后旧模型的延迟卸载实现
+ */
+
+#include "infer_server/stream/model_retirement.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace infer_server {
+
+void ModelRetirement::retire(const std::string& model_path,
+                             std::vector<std::weak_ptr<const ModelBinding>> bindings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = retired_[model_path];
+    entry.insert(entry.end(), std::make_move_iterator(bindings.begin()),
+                 std::make_move_iterator(bindings.end()));
+}
+
+std::vector<std::string> ModelRetirement::claim(const InUse& in_use) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> ready;
+    for (auto it = retired_.begin(); it != retired_.end();) {
+        // 仍有流引用: 模型重新投入使用, 按普通模型管理
+        if (in_use(it->first)) {
+            it = retired_.erase(it);
+            continue;
+        }
+        auto& bindings = it->second;
+        bool drained = std::all_of(bindings.begin(), bindings.end(),
+                                   [](const std::weak_ptr<const ModelBinding>& b) { return b.expired(); });
+        if (!drained || unloading_.count(it->first)) {
+            ++it;
+            continue;
+        }
+        unloading_.insert(it->first);
+        ready.push_back(it->first);
+        it = retired_.erase(it);
+    }
+    return ready;
+}
+
+void ModelRetirement::cancel(const std::string& model_path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired_.erase(model_path);
+}
+
+bool ModelRetirement::begin_unload(const std::string& model_path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired_.erase(model_path);
+    return unloading_.insert(model_path).second;
+}
+
+void ModelRetirement::finish(const std::string& model_path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unloading_.erase(model_path);
+    }
+    cv_.notify_all();
+}
+
+bool ModelRetirement::unloading_locked(const std::vector<std::string>& model_paths) const {
+    return std::any_of(model_paths.begin(), model_paths.end(),
+                       [this](const std::string& path) { return unloading_.count(path) > 0; });
+}
+
+bool ModelRetirement::unloading(const std::vector<std::string>& model_paths) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return unloading_locked(model_paths);
+}
+
+void ModelRetirement::wait_unloaded(const std::vector<std::string>& model_paths) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&]() { return !unloading_locked(model_paths); });
+}
+
+size_t ModelRetirement::retired_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return retired_.size();
+}
+
+} // namespace infer_server
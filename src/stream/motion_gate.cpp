@@ -0,0 +1,118 @@
+/**
+ * @file motion_gate.cpp
+ * @brief 场景变化门控实现
+ */
+
+#include "infer_server/stream/motion_gate.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define INFER_SERVER_MOTION_NEON 1
+#endif
+
+namespace infer_server {
+
+MotionGate::MotionGate(const Options& options)
+    : options_(options)
+{
+    options_.min_blocks = std::max(options_.min_blocks, 1);
+    options_.max_skip_ms = std::max(options_.max_skip_ms, 0);
+}
+
+void MotionGate::downsample(const uint8_t* y, int width, int height, int stride, uint8_t* thumb) {
+    if (!y || width < 2 || height < 2) {
+        std::memset(thumb, 0, kThumbWidth * kThumbHeight);
+        return;
+    }
+    // 每个缩略图像素取对应源区域中心的 2x2 均值 (只读 4 个像素, 不做全图盒式滤波)
+    int xs[kThumbWidth];
+    for (int tx = 0; tx < kThumbWidth; tx++) {
+        int sx = static_cast<int>((2LL * tx + 1) * width / (2 * kThumbWidth));
+        xs[tx] = std::min(sx, width - 2);
+    }
+    for (int ty = 0; ty < kThumbHeight; ty++) {
+        int sy = static_cast<int>((2LL * ty + 1) * height / (2 * kThumbHeight));
+        sy = std::min(sy, height - 2);
+        const uint8_t* row0 = y + static_cast<size_t>(sy) * stride;
+        const uint8_t* row1 = row0 + stride;
+        uint8_t* out = thumb + ty * kThumbWidth;
+        for (int tx = 0; tx < kThumbWidth; tx++) {
+            int sx = xs[tx];
+            out[tx] = static_cast<uint8_t>((row0[sx] + row0[sx + 1] + row1[sx] + row1[sx + 1] + 2) >> 2);
+        }
+    }
+}
+
+uint32_t MotionGate::block_sad(const uint8_t* a, const uint8_t* b, int stride) {
+#ifdef INFER_SERVER_MOTION_NEON
+    // 每行 16 字节: |a - b| 按 u16 成对累加, 最大 8 行 x 2 x 255, 不会溢出
+    uint16x8_t acc = vdupq_n_u16(0);
+    for (int r = 0; r < kBlockHeight; r++) {
+        uint8x16_t diff = vabdq_u8(vld1q_u8(a + r * stride), vld1q_u8(b + r * stride));
+        acc = vpadalq_u8(acc, diff);
+    }
+    uint32x4_t sum4 = vpaddlq_u16(acc);
+    uint64x2_t sum2 = vpaddlq_u32(sum4);
+    return static_cast<uint32_t>(vgetq_lane_u64(sum2, 0) + vgetq_lane_u64(sum2, 1));
+#else
+    uint32_t sum = 0;
+    for (int r = 0; r < kBlockHeight; r++) {
+        const uint8_t* ra = a + r * stride;
+        const uint8_t* rb = b + r * stride;
+        for (int c = 0; c < kBlockWidth; c++) {
+            sum += static_cast<uint32_t>(std::abs(ra[c] - rb[c]));
+        }
+    }
+    return sum;
+#endif
+}
+
+bool MotionGate::check(const uint8_t* thumb, int64_t timestamp_ms) {
+    constexpr size_t kThumbBytes = static_cast<size_t>(kThumbWidth) * kThumbHeight;
+
+    if (reference_.empty()) {
+        reference_.assign(thumb, thumb + kThumbBytes);
+        reference_ms_ = timestamp_ms;
+        last_score_ = 0.0;
+        last_changed_ = 0;
+        return true;
+    }
+
+    constexpr double kBlockPixels = kBlockWidth * kBlockHeight;
+    uint32_t max_sad = 0;
+    int changed = 0;
+    for (int br = 0; br < kBlockRows; br++) {
+        for (int bc = 0; bc < kBlockCols; bc++) {
+            size_t offset = static_cast<size_t>(br) * kBlockHeight * kThumbWidth + bc * kBlockWidth;
+            uint32_t sad = block_sad(thumb + offset, reference_.data() + offset, kThumbWidth);
+            max_sad = std::max(max_sad, sad);
+            if (sad > options_.threshold * kBlockPixels) changed++;
+        }
+    }
+    last_score_ = max_sad / kBlockPixels;
+    last_changed_ = changed;
+
+    // 时间戳回退 (流重连 / 系统时间调整) 时按超时处理, 避免永久跳过
+    bool expired = options_.max_skip_ms > 0 &&
+        (timestamp_ms - reference_ms_ >= options_.max_skip_ms || timestamp_ms < reference_ms_);
+    if (changed < options_.min_blocks && !expired) {
+        return false;
+    }
+
+    std::memcpy(reference_.data(), thumb, kThumbBytes);
+    reference_ms_ = timestamp_ms;
+    return true;
+}
+
+void MotionGate::reset() {
+    reference_.clear();
+    reference_ms_ = 0;
+    last_score_ = 0.0;
+    last_changed_ = 0;
+}
+
+} // namespace infer_server
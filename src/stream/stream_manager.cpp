@@ -5,6 +5,8 @@
 
 #include "infer_server/stream/stream_manager.h"
 #include "infer_server/common/logger.h"
+#include "infer_server/common/thread_policy.h"
+#include "infer_server/inference/object_tracker.h"
 
 #ifdef HAS_FFMPEG
 #include "infer_server/decoder/hw_decoder.h"
@@ -26,10 +28,41 @@
 
 #include <fstream>
 #include <algorithm>
+#include <iterator>
 #include <cmath>
 
 namespace infer_server {
 
+#ifdef HAS_RGA
+namespace {
+
+/**
+ * @brief 源帧裁剪区域 -> 模型输入的几何变换
+ *
+ * crop 为解码输出 (frame_w x frame_h) 中的像素矩形, 为空表示整帧;
+ * 区域原点和尺寸按比例换算回原始分辨率 (orig_w x orig_h), 检测框据此映射回整帧坐标。
+ */
+LetterboxTransform region_transform(const CropRect& crop, int frame_w, int frame_h,
+                                    int orig_w, int orig_h,
+                                    bool letterbox, int model_w, int model_h) {
+    int src_x = 0, src_y = 0, src_w = orig_w, src_h = orig_h;
+    if (!crop.empty()) {
+        src_x = static_cast<int>(static_cast<int64_t>(crop.x) * orig_w / frame_w);
+        src_y = static_cast<int>(static_cast<int64_t>(crop.y) * orig_h / frame_h);
+        src_w = static_cast<int>(static_cast<int64_t>(crop.width) * orig_w / frame_w);
+        src_h = static_cast<int>(static_cast<int64_t>(crop.height) * orig_h / frame_h);
+    }
+    auto t = letterbox
+        ? LetterboxTransform::letterbox(src_w, src_h, model_w, model_h)
+        : LetterboxTransform::stretch(src_w, src_h, model_w, model_h);
+    t.src_x = src_x;
+    t.src_y = src_y;
+    return t;
+}
+
+} // namespace
+#endif // HAS_RGA
+
 // ============================================================
 // 构造/析构
 // ============================================================
@@ -45,19 +78,111 @@ StreamManager::StreamManager(const ServerConfig& config,
 #endif
     , cache_(cache)
 {
+    if (config_.adaptive_skip) {
+        AdmissionController::Options opts;
+        opts.update_interval_ms = std::max(50, config_.adaptive_interval_ms);
+        opts.min_fps = std::max(0.0, config_.adaptive_min_fps);
+
+        AdmissionController::LoadProbe probe;
+#ifdef HAS_RKNN
+        probe = [this]() {
+            AdmissionController::LoadSample load;
+            if (engine_) {
+                load.queue_depth = engine_->queue_size();
+                load.queue_capacity = engine_->queue_capacity();
+                load.dropped = engine_->queue_dropped();
+                load.workers = engine_->worker_count();
+            }
+            return load;
+        };
+#endif
+        admission_ = std::make_unique<AdmissionController>(opts, std::move(probe));
+    }
+    if (config_.decode_threads > 0) {
+        decode_pool_ = std::make_unique<DecodeScheduler>(config_.decode_threads);
+        opener_ = std::thread(&StreamManager::opener_loop, this);
+    }
 }
 
 StreamManager::~StreamManager() {
     shutdown();
 }
 
+/**
+ * @brief 单路流的解码状态机
+ *
+ * Start -> Open -> Run (每步一个包) -> 出错回到 Open (退避后重连); 停止请求在任一步生效。
+ * 由独立解码线程或解码线程池推进, 同一时刻只有一个线程执行其单步。
+ * 线程池模式下 Open 交给打开线程 (opener_loop) 执行, 任务挂起到打开结束。
+ */
+struct StreamManager::DecodeSession {
+    enum class Phase { Start, Open, Run };
+
+    Phase phase = Phase::Start;
+    bool pooled = false;                ///< 由解码线程池推进 (按预测的包到达时刻调度读取)
+    std::atomic<bool> opening{false};   ///< 已交给打开线程, 尚未返回 (线程池模式)
+    std::optional<std::chrono::steady_clock::time_point> open_due;  ///< 打开线程返回的下一步时刻
+    std::thread preprocess_thread;
+    std::thread encode_thread;
+    std::thread cascade_thread;
+    int backoff_sec = 1;
+    uint64_t local_frame_count = 0;
+
+#ifdef HAS_FFMPEG
+    std::unique_ptr<HwDecoder> decoder;
+#endif
+    DecodeMode decode_mode = DecodeMode::All;
+    int skip = 1;                       ///< 固定跳帧间隔 (准入控制关闭时)
+    uint64_t discarded_base = 0;        ///< 本次打开前累计的解复用丢包数
+
+    // 当前输出帧: 准入决定在第一个包之前做出, 跨越多个单步
+    bool frame_pending = false;
+    bool need_process = false;
+    int64_t decode_ns = 0;              ///< 当前输出帧累计的单步耗时
+
+    ArrivalPredictor predictor;
+    int64_t last_packet_ms = -1;
+
+    /// 重连退避: 返回重试时刻, 退避时间翻倍 (最长 8s)
+    std::chrono::steady_clock::time_point retry_at() {
+        const int max_backoff_sec = 8;
+        auto due = std::chrono::steady_clock::now() + std::chrono::seconds(backoff_sec);
+        backoff_sec = std::min(backoff_sec * 2, max_backoff_sec);
+        return due;
+    }
+
+    /// 源帧率变化: 更新准入控制的源帧率, 或按 target_fps 换算固定跳帧间隔
+    void apply_source_fps(StreamContext* ctx, double fps) {
+        if (ctx->admission) {
+            ctx->admission->set_source_fps(fps);
+        } else if (ctx->config.target_fps > 0.0 && fps > 0.0) {
+            skip = std::max(1, static_cast<int>(std::lround(fps / ctx->config.target_fps)));
+        }
+    }
+};
+
+StreamManager::StreamContext::StreamContext(size_t queue_size)
+    : frame_queue(queue_size), encode_queue(queue_size)
+    , cascade_queue(std::make_shared<BoundedQueue<CascadeJob>>(queue_size)) {}
+
+StreamManager::StreamContext::~StreamContext() = default;
+
 // ============================================================
 // 流 CRUD
 // ============================================================
 
 bool StreamManager::add_stream(const StreamConfig& stream_config) {
     {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        // 引用的模型正在卸载 (热切换后的旧模型): 在锁外等待卸载结束, 之后按新模型重新加载
+        std::vector<std::string> model_paths;
+        for (const auto& mc : stream_config.models) model_paths.push_back(mc.model_path);
+        while (retirement_.unloading(model_paths)) {
+            lock.unlock();
+            retirement_.wait_unloaded(model_paths);
+            lock.lock();
+        }
 
         if (stream_config.cam_id.empty()) {
             LOG_ERROR("Cannot add stream: cam_id is empty");
@@ -69,28 +194,60 @@ bool StreamManager::add_stream(const StreamConfig& stream_config) {
             return false;
         }
 
-        LOG_INFO("Adding stream: [{}] {} (skip={}, {} model(s))",
+        LOG_INFO("Adding stream: [{}] {} (skip={}, priority={}, decode={}, {} model(s))",
                  stream_config.cam_id, stream_config.rtsp_url,
-                 stream_config.frame_skip, stream_config.models.size());
+                 stream_config.frame_skip, stream_config.priority, stream_config.decode_mode,
+                 stream_config.models.size());
 
-        auto ctx = std::make_unique<StreamContext>();
+        auto ctx = std::make_unique<StreamContext>(
+            static_cast<size_t>(std::max(1, config_.decode_queue_size)));
         ctx->config = stream_config;
 
 #ifdef HAS_TURBOJPEG
-        ctx->jpeg_encoder = std::make_unique<JpegEncoder>();
+        // 未知后端名已由 main 告警, 这里按 turbojpeg 处理
+        JpegBackend jpeg_backend = JpegBackend::TURBOJPEG;
+        parse_jpeg_backend(config_.cache_jpeg_backend, jpeg_backend);
+        ctx->jpeg_encoder = std::make_unique<JpegEncoder>(jpeg_backend);
 #endif
 
-        // 预加载标签文件
-        for (const auto& mc : stream_config.models) {
-            if (!mc.labels_file.empty() && ctx->labels_cache.find(mc.model_path) == ctx->labels_cache.end()) {
-                ctx->labels_cache[mc.model_path] = load_labels_file(mc.labels_file);
-            }
+        if (config_.clip_duration_sec > 0) {
+            ctx->packet_ring = std::make_shared<PacketRing>(
+                config_.clip_duration_sec,
+                static_cast<size_t>(std::max(config_.clip_max_memory_mb, 0)) * 1024 * 1024);
+        }
+
+        // 模型绑定 (含共享标签表)
+        ctx->trackers = build_trackers(stream_config);
+        ctx->bindings = build_bindings(stream_config, ctx->counters, ctx->trackers);
+
+        ctx->preprocess_groups = build_preprocess_groups(stream_config);
+        ctx->cascade_plan = build_cascade_plan(stream_config, ctx->bindings);
+
+        if (admission_) {
+            ctx->admission = admission_->add_stream(
+                stream_config.cam_id, stream_config.frame_skip, stream_config.target_fps, ctx->counters);
+        }
+        if (stream_config.motion_threshold > 0.0) {
+            MotionGate::Options opts;
+            opts.threshold = stream_config.motion_threshold;
+            opts.min_blocks = stream_config.motion_min_blocks;
+            opts.max_skip_ms = stream_config.motion_max_skip_ms;
+            ctx->motion_gate = std::make_unique<MotionGate>(opts);
+            ctx->counters->keep_last_result = stream_config.motion_skip_action == "republish";
+            LOG_INFO("[{}] Motion gate: threshold={}, min_blocks={}, max_skip={}ms, action={}",
+                     stream_config.cam_id, stream_config.motion_threshold, stream_config.motion_min_blocks,
+                     stream_config.motion_max_skip_ms, stream_config.motion_skip_action);
+        }
+        if (ctx->preprocess_groups.size() < stream_config.models.size()) {
+            LOG_INFO("[{}] {} model(s) share {} preprocess group(s)",
+                     stream_config.cam_id, stream_config.models.size(),
+                     ctx->preprocess_groups.size());
         }
 
 #ifdef HAS_RKNN
-        // 预加载模型
+        // 后台预加载模型: 流先开始解码, 模型就绪后才提交推理
         if (engine_) {
-            engine_->load_models(stream_config.models);
+            engine_->load_models_async(stream_config.models);
         }
 #endif
 
@@ -101,15 +258,15 @@ bool StreamManager::add_stream(const StreamConfig& stream_config) {
         }
 #endif
 
-        // 启动解码线程
-        auto* ctx_ptr = ctx.get();
+        // 启动解码
         ctx->stop_requested = false;
         ctx->running = true;
         ctx->state = static_cast<int>(StreamState::Starting);
         ctx->start_time = std::chrono::steady_clock::now();
-        ctx->decode_thread = std::thread(&StreamManager::decode_thread_func, this, ctx_ptr);
+        launch_decode(*ctx);
 
         streams_[stream_config.cam_id] = std::move(ctx);
+        invalidate_status();
     }
 
     // 持久化 (在锁外调用, 避免死锁)
@@ -133,11 +290,15 @@ bool StreamManager::remove_stream(const std::string& cam_id) {
 
         ctx_to_destroy = std::move(it->second);
         streams_.erase(it);
+        invalidate_status();
     }
 
-    // 在锁外等待线程结束并销毁
-    if (ctx_to_destroy && ctx_to_destroy->decode_thread.joinable()) {
-        ctx_to_destroy->decode_thread.join();
+    // 在锁外等待解码结束并销毁
+    if (ctx_to_destroy) {
+        join_decode(*ctx_to_destroy);
+    }
+    if (admission_ && ctx_to_destroy) {
+        admission_->remove_stream(ctx_to_destroy->admission);
     }
 
 #ifdef HAS_TURBOJPEG
@@ -146,6 +307,10 @@ bool StreamManager::remove_stream(const std::string& cam_id) {
     }
 #endif
 
+    // 删除的流可能是热切换旧模型的最后一个引用
+    ctx_to_destroy.reset();
+    unload_retired();
+
     // 持久化
     save_configs();
 
@@ -168,22 +333,40 @@ bool StreamManager::start_stream(const std::string& cam_id) {
 
     LOG_INFO("Starting stream: [{}]", cam_id);
 
-    // 等待旧线程结束
-    if (ctx.decode_thread.joinable()) {
-        ctx.decode_thread.join();
-    }
+    // 等待旧的解码结束
+    join_decode(ctx);
+    // 停止期间未来得及在帧边界应用的模型切换
+    apply_model_swap(ctx);
 
     // 重置统计
     ctx.decoded_frames = 0;
-    ctx.inferred_frames = 0;
+    ctx.demux_discarded = 0;
+    ctx.counters->inferred_frames = 0;
+    ctx.counters->infer_dropped = 0;
+    ctx.counters->infer_expired = 0;
+    ctx.counters->decode_rate.reset();
+    ctx.counters->infer_rate.reset();
+    ctx.counters->drop_rate.reset();
+    ctx.predicted_results = 0;
+    ctx.motion_skipped = 0;
+    ctx.motion_score = 0.0;
+    if (ctx.motion_gate) {
+        ctx.motion_gate->reset();
+        std::lock_guard<std::mutex> result_lock(ctx.counters->last_result_mutex);
+        ctx.counters->last_results.clear();
+    }
     ctx.reconnect_count = 0;
+    ctx.decode_ms = 0.0;
+    ctx.preprocess_ms = 0.0;
+    ctx.encode_ms = 0.0;
     ctx.set_error("");
 
     ctx.stop_requested = false;
     ctx.running = true;
     ctx.state = static_cast<int>(StreamState::Starting);
     ctx.start_time = std::chrono::steady_clock::now();
-    ctx.decode_thread = std::thread(&StreamManager::decode_thread_func, this, &ctx);
+    launch_decode(ctx);
+    invalidate_status();
 
     return true;
 }
@@ -201,10 +384,11 @@ bool StreamManager::stop_stream(const std::string& cam_id) {
         stop_stream_internal(*ctx_ptr);
     }
 
-    // 在锁外等待线程结束
-    if (ctx_ptr && ctx_ptr->decode_thread.joinable()) {
-        ctx_ptr->decode_thread.join();
+    // 在锁外等待解码结束
+    if (ctx_ptr) {
+        join_decode(*ctx_ptr);
     }
+    invalidate_status();
 
     return true;
 }
@@ -213,6 +397,95 @@ void StreamManager::stop_stream_internal(StreamContext& ctx) {
     if (!ctx.running.load()) return;
     LOG_INFO("Stopping stream: [{}]", ctx.config.cam_id);
     ctx.stop_requested = true;
+    // 线程池任务可能在等待退避 / 下一个包: 立即调度以便处理停止
+    if (decode_pool_ && ctx.decode_task != 0) {
+        decode_pool_->wake(ctx.decode_task);
+    }
+}
+
+void StreamManager::launch_decode(StreamContext& ctx) {
+    ctx.decode_session = std::make_unique<DecodeSession>();
+    ctx.decode_session->pooled = decode_pool_ != nullptr;
+    if (decode_pool_) {
+        // 先挂起注册, 保存任务 ID 后再开始: 打开线程按 decode_task 唤醒任务
+        auto* ctx_ptr = &ctx;
+        ctx.decode_task = decode_pool_->add(ctx.config.cam_id,
+                                            [this, ctx_ptr] { return decode_step(ctx_ptr); }, true);
+        decode_pool_->wake(ctx.decode_task);
+    } else {
+        ctx.decode_task = 0;
+        ctx.decode_thread = std::thread(&StreamManager::decode_thread_func, this, &ctx);
+    }
+}
+
+void StreamManager::join_decode(StreamContext& ctx) {
+    if (ctx.decode_thread.joinable()) {
+        ctx.decode_thread.join();
+    }
+    if (decode_pool_ && ctx.decode_task != 0) {
+        decode_pool_->wait(ctx.decode_task);
+        ctx.decode_task = 0;
+    }
+}
+
+void StreamManager::apply_model_swap(StreamContext& ctx) {
+    if (!ctx.pending_swap) return;
+    auto& swap = *ctx.pending_swap;
+    // 只改写模型路径: 解码线程不加锁读取的其他模型字段 (输入尺寸 / ROI) 不变
+    for (size_t i = 0; i < ctx.config.models.size() && i < swap.model_paths.size(); i++) {
+        ctx.config.models[i].model_path = swap.model_paths[i];
+    }
+    ctx.bindings = std::move(swap.bindings);
+    ctx.cascade_plan = std::move(swap.cascade_plan);
+    ctx.pending_swap.reset();
+    ctx.swap_pending.store(false, std::memory_order_release);
+    invalidate_status();
+    LOG_INFO("[{}] Model swap applied", ctx.config.cam_id);
+}
+
+bool StreamManager::model_in_use_locked(const std::string& model_path) const {
+    return std::any_of(streams_.begin(), streams_.end(), [&](const auto& entry) {
+        const auto& ctx = *entry.second;
+        if (ctx.pending_swap) {
+            const auto& paths = ctx.pending_swap->model_paths;
+            return std::find(paths.begin(), paths.end(), model_path) != paths.end();
+        }
+        const auto& models = ctx.config.models;
+        return std::any_of(models.begin(), models.end(),
+                           [&](const ModelConfig& mc) { return mc.model_path == model_path; });
+    });
+}
+
+std::vector<std::string> StreamManager::unload_retired(bool try_only, int timeout_ms) {
+    std::vector<std::string> claimed;
+    {
+        std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+        if (try_only) {
+            if (!lock.try_lock()) return {};
+        } else {
+            lock.lock();
+        }
+        claimed = retirement_.claim([this](const std::string& path) { return model_in_use_locked(path); });
+    }
+    return unload_claimed(claimed, timeout_ms);
+}
+
+std::vector<std::string> StreamManager::unload_claimed(const std::vector<std::string>& model_paths,
+                                                       int timeout_ms) {
+    // 不持有 mutex_: unload_model 等待 worker 释放 context, 可能耗时数秒
+    std::vector<std::string> unloaded;
+    for (const auto& path : model_paths) {
+#ifdef HAS_RKNN
+        if (engine_ && engine_->unload_model(path, timeout_ms)) {
+            LOG_INFO("Unloaded retired model {}", path);
+            unloaded.push_back(path);
+        }
+#else
+        (void)timeout_ms;
+#endif
+        retirement_.finish(path);
+    }
+    return unloaded;
 }
 
 // ============================================================
@@ -244,33 +517,75 @@ void StreamManager::stop_all() {
             contexts.push_back(ctx.get());
         }
     }
-    // 等待所有线程结束 (锁外, 避免死锁)
+    // 等待所有解码结束 (锁外, 避免死锁)
     for (auto* ctx : contexts) {
-        if (ctx->decode_thread.joinable()) {
-            ctx->decode_thread.join();
-        }
+        join_decode(*ctx);
     }
+    invalidate_status();
 }
 
 // ============================================================
 // 查询
 // ============================================================
 
-std::vector<StreamStatus> StreamManager::get_all_status() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::vector<StreamStatus> result;
-    result.reserve(streams_.size());
-    for (const auto& [id, ctx] : streams_) {
-        result.push_back(build_status(*ctx));
+const StreamStatus* StreamManager::StatusSnapshot::find(const std::string& cam_id) const {
+    for (const auto& s : streams) {
+        if (s.cam_id == cam_id) return &s;
     }
-    return result;
+    return nullptr;
+}
+
+std::shared_ptr<const StreamManager::StatusSnapshot> StreamManager::status_snapshot(int max_age_ms) const {
+    if (max_age_ms < 0) max_age_ms = std::max(0, config_.status_refresh_ms);
+    auto is_current = [this](const std::shared_ptr<const StatusSnapshot>& snap) {
+        return snap && snap->generation == status_generation_.load(std::memory_order_acquire);
+    };
+    auto is_fresh = [&](const std::shared_ptr<const StatusSnapshot>& snap) {
+        return is_current(snap) &&
+               std::chrono::steady_clock::now() - snap->built_at < std::chrono::milliseconds(max_age_ms);
+    };
+
+    auto snap = std::atomic_load(&status_snapshot_);
+    if (is_fresh(snap)) return snap;
+
+    // 只是过期 (流配置未变): 已有读取者在重建时直接返回旧快照, 不排队等待
+    std::unique_lock<std::mutex> refresh(status_mutex_, std::defer_lock);
+    if (is_current(snap) && max_age_ms > 0) {
+        if (!refresh.try_lock()) return snap;
+    } else {
+        refresh.lock();
+    }
+
+    // 等锁期间其他读取者可能已完成重建
+    snap = std::atomic_load(&status_snapshot_);
+    if (is_fresh(snap)) return snap;
+
+    auto next = std::make_shared<StatusSnapshot>();
+    // 先取版本再加锁: 构造期间发生的变更使本快照立即失效
+    next->generation = status_generation_.load(std::memory_order_acquire);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        next->streams.reserve(streams_.size());
+        for (const auto& [id, ctx] : streams_) {
+            next->streams.push_back(build_status(*ctx));
+        }
+    }
+    next->built_at = std::chrono::steady_clock::now();
+
+    snap = std::move(next);
+    std::atomic_store(&status_snapshot_, snap);
+    return snap;
+}
+
+std::vector<StreamStatus> StreamManager::get_all_status() const {
+    return status_snapshot()->streams;
 }
 
 std::optional<StreamStatus> StreamManager::get_status(const std::string& cam_id) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = streams_.find(cam_id);
-    if (it == streams_.end()) return std::nullopt;
-    return build_status(*it->second);
+    auto snap = status_snapshot();
+    const StreamStatus* status = snap->find(cam_id);
+    if (!status) return std::nullopt;
+    return *status;
 }
 
 std::vector<StreamConfig> StreamManager::get_all_configs() const {
@@ -283,6 +598,20 @@ std::vector<StreamConfig> StreamManager::get_all_configs() const {
     return result;
 }
 
+std::optional<Clip> StreamManager::get_clip(
+    const std::string& cam_id, int64_t start_ms, int64_t end_ms) const
+{
+    std::shared_ptr<PacketRing> ring;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = streams_.find(cam_id);
+        if (it == streams_.end()) return std::nullopt;
+        ring = it->second->packet_ring;
+    }
+    if (!ring) return std::nullopt;
+    return ring->get_clip(start_ms, end_ms);
+}
+
 bool StreamManager::has_stream(const std::string& cam_id) const {
     std::lock_guard<std::mutex> lock(mutex_);
     return streams_.count(cam_id) > 0;
@@ -293,28 +622,320 @@ size_t StreamManager::stream_count() const {
     return streams_.size();
 }
 
+bool StreamManager::set_target_fps(const std::string& cam_id, double target_fps) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = streams_.find(cam_id);
+        if (it == streams_.end()) {
+            LOG_WARN("Cannot set target fps for stream {}: not found", cam_id);
+            return false;
+        }
+        auto& ctx = *it->second;
+        ctx.config.target_fps = std::max(0.0, target_fps);
+        if (ctx.admission) {
+            ctx.admission->set_target_fps(ctx.config.target_fps);
+        }
+        invalidate_status();
+        LOG_INFO("[{}] Target fps set to {:.2f}{}", cam_id, ctx.config.target_fps,
+                 ctx.admission ? "" : " (applied on next stream start)");
+    }
+
+    save_configs();
+    return true;
+}
+
+std::optional<DecodeScheduler::Stats> StreamManager::decode_pool_stats() const {
+    if (!decode_pool_) return std::nullopt;
+    return decode_pool_->stats();
+}
+
+double StreamManager::admission_scale() const {
+    return admission_ ? admission_->scale() : 0.0;
+}
+
+std::vector<StreamManager::LatencyReport> StreamManager::latency_reports() const {
+    // 持锁只取句柄, 快照在锁外生成 (直方图为原子计数, 句柄保证流删除后仍有效)
+    struct Source {
+        std::string cam_id;
+        std::shared_ptr<StreamCounters> counters;
+        std::vector<std::shared_ptr<const ModelBinding>> bindings;
+    };
+    std::vector<Source> sources;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sources.reserve(streams_.size());
+        for (const auto& [id, ctx] : streams_) {
+            sources.push_back({id, ctx->counters, ctx->bindings});
+        }
+    }
+    std::sort(sources.begin(), sources.end(),
+              [](const Source& a, const Source& b) { return a.cam_id < b.cam_id; });
+
+    auto collect = [](const StageLatency& latency, LatencyReport& report) {
+        for (size_t i = 0; i < kNumLatencyStages; i++) {
+            auto stage = static_cast<LatencyStage>(i);
+            if (latency.at(stage).count() == 0) continue;
+            report.stages.emplace_back(stage, latency.at(stage).snapshot());
+        }
+    };
+
+    std::vector<LatencyReport> reports;
+    for (const auto& src : sources) {
+        LatencyReport stream_report;
+        stream_report.cam_id = src.cam_id;
+        collect(src.counters->latency, stream_report);
+        reports.push_back(std::move(stream_report));
+
+        for (const auto& binding : src.bindings) {
+            if (!binding->latency) continue;
+            LatencyReport model_report;
+            model_report.cam_id = src.cam_id;
+            model_report.task_name = binding->task_name;
+            model_report.model_path = binding->model_path;
+            collect(*binding->latency, model_report);
+            reports.push_back(std::move(model_report));
+        }
+    }
+    return reports;
+}
+
+// ============================================================
+// 模型热切换
+// ============================================================
+
+StreamManager::ModelSwapResult StreamManager::swap_model(const std::string& old_path,
+                                                         const std::string& new_path,
+                                                         const std::vector<std::string>& cam_ids,
+                                                         int timeout_ms) {
+    ModelSwapResult result;
+#ifndef HAS_RKNN
+    (void)old_path;
+    (void)new_path;
+    (void)cam_ids;
+    (void)timeout_ms;
+    result.error = "RKNN not available";
+    return result;
+#else
+    if (!engine_) {
+        result.error = "Inference engine not available";
+        return result;
+    }
+    if (old_path.empty() || new_path.empty() || old_path == new_path) {
+        result.error = "model_path and new_model_path must be non-empty and different";
+        return result;
+    }
+    std::lock_guard<std::mutex> swap_lock(swap_mutex_);
+    using Clock = std::chrono::steady_clock;
+    auto timeout = std::chrono::milliseconds(std::max(timeout_ms, 0));
+
+    // 目标流; 新模型除路径外沿用旧模型的配置 (后处理参数以各流自己的配置为准)
+    std::vector<std::string> targets;
+    std::optional<ModelConfig> new_model;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // 切换回之前卸下的模型: 等待进行中的卸载结束, 并取消尚未执行的卸载
+        while (retirement_.unloading({new_path})) {
+            lock.unlock();
+            retirement_.wait_unloaded({new_path});
+            lock.lock();
+        }
+        retirement_.cancel(new_path);
+        for (const auto& [id, ctx] : streams_) {
+            if (!cam_ids.empty() && std::find(cam_ids.begin(), cam_ids.end(), id) == cam_ids.end()) continue;
+            for (const auto& mc : ctx->config.models) {
+                if (mc.model_path != old_path) continue;
+                if (!new_model) {
+                    new_model = mc;
+                    new_model->model_path = new_path;
+                }
+                targets.push_back(id);
+                break;
+            }
+        }
+    }
+    if (targets.empty()) {
+        result.error = "No stream uses model " + old_path;
+        return result;
+    }
+
+    // 1. 加载新模型并预创建 worker context (流继续用旧模型推理)
+    LOG_INFO("Swapping model {} -> {} on {} stream(s)", old_path, new_path, targets.size());
+    auto t_load = Clock::now();
+    bool loaded = engine_->load_models({*new_model});
+    result.load_ms = std::chrono::duration<double, std::milli>(Clock::now() - t_load).count();
+    if (!loaded) {
+        result.error = "Failed to load model " + new_path;
+        return result;
+    }
+
+    // 预处理分组与解码输出尺寸按配置的输入尺寸构造: 新模型必须一致 (NHWC)
+    const ModelInfo* info = engine_->model_manager().get_model_info(new_path);
+    bool input_ok = info && !info->input_attrs.empty() && info->input_attrs[0].n_dims >= 4 &&
+                    static_cast<int>(info->input_attrs[0].dims[1]) == new_model->input_height &&
+                    static_cast<int>(info->input_attrs[0].dims[2]) == new_model->input_width;
+    if (!input_ok) {
+        result.error = "Model " + new_path + " input size does not match " +
+                       std::to_string(new_model->input_width) + "x" + std::to_string(new_model->input_height);
+        bool unload;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            unload = !model_in_use_locked(new_path) && retirement_.begin_unload(new_path);
+        }
+        if (unload) unload_claimed({new_path}, timeout_ms);
+        return result;
+    }
+
+    // 2. 构造新的绑定与级联计划, 交给预处理线程在帧边界替换
+    std::vector<std::weak_ptr<const ModelBinding>> old_bindings;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& id : targets) {
+            auto it = streams_.find(id);
+            if (it == streams_.end()) continue;
+            auto& ctx = *it->second;
+
+            StreamConfig swapped = ctx.config;
+            auto swap = std::make_unique<StreamContext::ModelSwap>();
+            for (size_t i = 0; i < swapped.models.size(); i++) {
+                if (swapped.models[i].model_path == old_path) {
+                    swapped.models[i].model_path = new_path;
+                    old_bindings.push_back(ctx.bindings[i]);
+                }
+                swap->model_paths.push_back(swapped.models[i].model_path);
+            }
+            swap->bindings = build_bindings(swapped, ctx.counters, ctx.trackers);
+            swap->cascade_plan = build_cascade_plan(swapped, swap->bindings);
+            ctx.pending_swap = std::move(swap);
+            ctx.swap_pending.store(true, std::memory_order_release);
+            if (!ctx.running.load()) apply_model_swap(ctx);
+        }
+    }
+    // 旧模型登记为待卸载: 本次调用超时后由预处理线程在旧绑定全部释放时卸载
+    retirement_.retire(old_path, old_bindings);
+
+    auto deadline = Clock::now() + timeout;
+    for (;;) {
+        result.swapped.clear();
+        result.pending.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& id : targets) {
+                auto it = streams_.find(id);
+                if (it == streams_.end()) continue;     // 期间被删除
+                auto& ctx = *it->second;
+                // 预处理线程已退出 (流刚停止): 直接应用
+                if (ctx.swap_pending.load(std::memory_order_acquire) && !ctx.running.load()) {
+                    apply_model_swap(ctx);
+                }
+                (ctx.swap_pending.load(std::memory_order_acquire) ? result.pending : result.swapped).push_back(id);
+            }
+        }
+        if (result.pending.empty() || Clock::now() >= deadline) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    save_configs();
+    result.ok = true;
+
+    if (!result.pending.empty()) {
+        LOG_WARN("Model swap {} -> {}: {} stream(s) not switched yet, {} unloads once they switch",
+                 old_path, new_path, result.pending.size(), old_path);
+        return result;
+    }
+
+    // 3. 旧 ModelBinding 不再被引用 = 旧模型没有排队 / 在途任务
+    auto t_drain = Clock::now();
+    deadline = t_drain + timeout;
+    auto drained = [&old_bindings]() {
+        return std::all_of(old_bindings.begin(), old_bindings.end(),
+                           [](const std::weak_ptr<const ModelBinding>& b) { return b.expired(); });
+    };
+    while (!drained() && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    result.drain_ms = std::chrono::duration<double, std::milli>(Clock::now() - t_drain).count();
+    if (!drained()) {
+        LOG_WARN("Model swap {} -> {}: old tasks still in flight after {} ms, {} unloads once drained",
+                 old_path, new_path, timeout_ms, old_path);
+        return result;
+    }
+
+    // 持锁选出、锁外卸载: 卸载期间引用旧模型的 add_stream 等待其结束
+    auto unloaded = unload_retired(false, timeout_ms);
+    result.old_unloaded = std::find(unloaded.begin(), unloaded.end(), old_path) != unloaded.end();
+    LOG_INFO("Model swap {} -> {} done (load {:.0f} ms, drain {:.0f} ms, old model {})",
+             old_path, new_path, result.load_ms, result.drain_ms,
+             result.old_unloaded ? "unloaded" : "kept");
+    return result;
+#endif // HAS_RKNN
+}
+
 StreamStatus StreamManager::build_status(const StreamContext& ctx) const {
     StreamStatus s;
     s.cam_id = ctx.config.cam_id;
     s.rtsp_url = ctx.config.rtsp_url;
     s.status = stream_state_to_string(static_cast<StreamState>(ctx.state.load()));
     s.frame_skip = ctx.config.frame_skip;
+    s.target_fps = ctx.config.target_fps;
+    s.priority = ctx.config.priority;
+    s.deadline_ms = ctx.config.deadline_ms;
+    s.decode_mode = ctx.config.decode_mode;
+    s.rois = ctx.config.rois;
+    s.motion_threshold = ctx.config.motion_threshold;
+    s.motion_min_blocks = ctx.config.motion_min_blocks;
+    s.motion_max_skip_ms = ctx.config.motion_max_skip_ms;
+    s.motion_skip_action = ctx.config.motion_skip_action;
     s.models = ctx.config.models;
     s.decoded_frames = ctx.decoded_frames.load();
-    s.inferred_frames = ctx.inferred_frames.load();
+    s.demux_discarded = ctx.demux_discarded.load();
+    s.inferred_frames = ctx.counters->inferred_frames.load();
     s.reconnect_count = ctx.reconnect_count.load();
     s.last_error = ctx.get_error();
 
     auto now = std::chrono::steady_clock::now();
     s.uptime_seconds = std::chrono::duration<double>(now - ctx.start_time).count();
 
-    if (s.uptime_seconds > 0.0) {
-        s.decode_fps = static_cast<double>(s.decoded_frames) / s.uptime_seconds;
-        s.infer_fps = static_cast<double>(s.inferred_frames) / s.uptime_seconds;
+    // 帧率取滑动窗口速率 (而非总数 / 运行时长), 重连或长时间运行后仍反映当前负载
+    auto round2 = [](double v) { return std::round(v * 100.0) / 100.0; };
+    auto decode_rate = ctx.counters->decode_rate.rates();
+    auto infer_rate = ctx.counters->infer_rate.rates();
+    auto drop_rate = ctx.counters->drop_rate.rates();
+    s.decode_fps = round2(decode_rate.last_10s);
+    s.decode_fps_1s = round2(decode_rate.last_1s);
+    s.decode_fps_60s = round2(decode_rate.last_60s);
+    s.infer_fps = round2(infer_rate.last_10s);
+    s.infer_fps_1s = round2(infer_rate.last_1s);
+    s.infer_fps_60s = round2(infer_rate.last_60s);
+    s.drop_fps = round2(drop_rate.last_10s);
+    s.drop_fps_1s = round2(drop_rate.last_1s);
+    s.drop_fps_60s = round2(drop_rate.last_60s);
+
+    // dropped_frames: 预处理跟不上解码而在流水线中丢弃的帧 + 推理队列挤出 / 超时的任务
+    s.infer_dropped = ctx.counters->infer_dropped.load(std::memory_order_relaxed);
+    s.infer_expired = ctx.counters->infer_expired.load(std::memory_order_relaxed);
+    s.dropped_frames = ctx.frame_queue.dropped_count() + s.infer_dropped + s.infer_expired;
+
+    s.decode_ms = std::round(ctx.decode_ms.load(std::memory_order_relaxed) * 100.0) / 100.0;
+    s.preprocess_ms = std::round(ctx.preprocess_ms.load(std::memory_order_relaxed) * 100.0) / 100.0;
+    s.encode_ms = std::round(ctx.encode_ms.load(std::memory_order_relaxed) * 100.0) / 100.0;
+    s.preprocess_queue = static_cast<uint32_t>(ctx.frame_queue.size());
+    s.encode_queue = static_cast<uint32_t>(ctx.encode_queue.size());
+    s.encode_dropped = ctx.encode_queue.dropped_count();
+
+    if (ctx.admission) {
+        s.admitted_fps = std::round(ctx.admission->allowed_fps() * 100.0) / 100.0;
+        s.effective_skip = ctx.admission->effective_skip();
+        s.admission_skipped = ctx.admission->rejected();
+    }
+    s.frame_cost_ms = std::round(ctx.counters->frame_cost_ms.load(std::memory_order_relaxed) * 100.0) / 100.0;
+    s.predicted_results = ctx.predicted_results.load(std::memory_order_relaxed);
+    s.motion_skipped = ctx.motion_skipped.load(std::memory_order_relaxed);
+    s.motion_score = std::round(ctx.motion_score.load(std::memory_order_relaxed) * 100.0) / 100.0;
+    s.models_ready = ctx.models_ready.load(std::memory_order_relaxed);
+
+    if (ctx.packet_ring) {
+        s.clip_bytes = ctx.packet_ring->memory_bytes();
+        s.clip_duration_ms = ctx.packet_ring->duration_ms();
     }
-
-    // dropped_frames: 由全局推理队列统计, 这里近似为 0
-    s.dropped_frames = 0;
 
     return s;
 }
@@ -348,11 +969,35 @@ void StreamManager::load_and_start(const std::vector<StreamConfig>& configs) {
 // ============================================================
 
 void StreamManager::on_infer_result(const FrameResult& result) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = streams_.find(result.cam_id);
-    if (it != streams_.end()) {
-        it->second->inferred_frames.fetch_add(1, std::memory_order_relaxed);
+#ifdef HAS_TURBOJPEG
+    // 检测框回填到缓存帧 (运动门控转发的结果同样属于本帧)
+    if (cache_ && config_.cache_overlay) {
+        cache_->attach_overlay(result);
     }
+#endif
+
+    // 运动门控转发的结果不是新的推理
+    if (!result.counters || result.repeated) return;
+    // 所有模型都由跟踪器外推的帧不计入推理帧数
+    if (result.inferred()) {
+        result.counters->inferred_frames.fetch_add(1, std::memory_order_relaxed);
+        result.counters->infer_rate.mark();
+    }
+
+    if (result.counters->keep_last_result.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(result.counters->last_result_mutex);
+        result.counters->last_results = result.results;
+    }
+
+    // 单帧 NPU + 后处理开销 (所有模型之和) 的滑动平均, 供准入控制估计 NPU 占用;
+    // 不用 inference_time_ms: 它含后处理排队, 批处理时每个任务都记整批耗时
+    // 同一路流的结果由同一个输出线程回调; output_threads = 0 时偶尔丢失一次更新, 不影响估计
+    double cost = 0.0;
+    for (const auto& r : result.results) cost += r.compute_ms;
+    if (cost <= 0.0) return;
+    auto& avg = result.counters->frame_cost_ms;
+    double prev = avg.load(std::memory_order_relaxed);
+    avg.store(prev > 0.0 ? prev * 0.9 + cost * 0.1 : cost, std::memory_order_relaxed);
 }
 
 // ============================================================
@@ -362,6 +1007,14 @@ void StreamManager::on_infer_result(const FrameResult& result) {
 void StreamManager::shutdown() {
     LOG_INFO("StreamManager shutting down...");
     stop_all();
+    // 流都已停止, 打开队列为空
+    {
+        std::lock_guard<std::mutex> lock(open_mutex_);
+        opener_stop_ = true;
+    }
+    open_cv_.notify_all();
+    if (opener_.joinable()) opener_.join();
+    if (decode_pool_) decode_pool_->stop();
     LOG_INFO("StreamManager shutdown complete");
 }
 
@@ -369,6 +1022,140 @@ void StreamManager::shutdown() {
 // 工具函数
 // ============================================================
 
+std::pair<int, int> StreamManager::decode_output_size(const ServerConfig& config,
+                                                     const StreamConfig& stream,
+                                                     bool cache_enabled, int src_w, int src_h)
+{
+    if (src_w <= 0 || src_h <= 0) return {0, 0};
+
+    double scale = 0.0;
+    auto parents = cascade_parents(stream);
+    for (size_t i = 0; i < stream.models.size(); i++) {
+        // 级联第二级模型的输入来自检测框裁剪, 尺寸不固定, 不参与计算
+        if (parents[i] >= 0) continue;
+        const auto& mc = stream.models[i];
+        auto regions = model_regions(stream, mc);
+        if (regions.empty()) regions.emplace_back();
+        for (const auto& r : regions) {
+            scale = std::max({scale,
+                              mc.input_width / (static_cast<double>(src_w) * r.width),
+                              mc.input_height / (static_cast<double>(src_h) * r.height)});
+        }
+    }
+    if (cache_enabled) {
+        // cache_resize_width = 0: 缓存宽度为原图宽度
+        if (config.cache_resize_width <= 0) return {0, 0};
+        scale = std::max(scale, static_cast<double>(config.cache_resize_width) / src_w);
+        if (config.cache_resize_height > 0) {
+            scale = std::max(scale, static_cast<double>(config.cache_resize_height) / src_h);
+        }
+    }
+
+    if (scale <= 0.0 || scale > 0.75) return {0, 0};
+    int w = static_cast<int>(std::ceil(src_w * scale));
+    int h = static_cast<int>(std::ceil(src_h * scale));
+    return {(w + 1) & ~1, (h + 1) & ~1};
+}
+
+std::vector<RoiConfig> StreamManager::model_regions(const StreamConfig& stream, const ModelConfig& mc) {
+    const auto& rois = mc.rois.empty() ? stream.rois : mc.rois;
+    if (rois.empty() && mc.tile_cols <= 1 && mc.tile_rows <= 1) return {};
+    return tile_regions(rois, mc.tile_cols, mc.tile_rows, mc.tile_overlap);
+}
+
+std::vector<StreamManager::PreprocessGroup> StreamManager::build_preprocess_groups(
+    const StreamConfig& stream)
+{
+    auto same_regions = [](const std::vector<RoiConfig>& a, const std::vector<RoiConfig>& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                          [](const RoiConfig& l, const RoiConfig& r) {
+                              return l.x == r.x && l.y == r.y &&
+                                     l.width == r.width && l.height == r.height;
+                          });
+    };
+
+    auto parents = cascade_parents(stream);
+    std::vector<PreprocessGroup> groups;
+    for (size_t i = 0; i < stream.models.size(); i++) {
+        if (parents[i] >= 0) continue;   // 级联第二级模型不在整帧上推理
+        const auto& mc = stream.models[i];
+        bool letterbox = mc.resize_mode != "stretch";
+        auto regions = model_regions(stream, mc);
+        auto it = std::find_if(groups.begin(), groups.end(), [&](const PreprocessGroup& g) {
+            return g.input_width == mc.input_width && g.input_height == mc.input_height &&
+                   g.letterbox == letterbox && same_regions(g.regions, regions);
+        });
+        if (it == groups.end()) {
+            PreprocessGroup group;
+            group.input_width = mc.input_width;
+            group.input_height = mc.input_height;
+            group.letterbox = letterbox;
+            group.regions = std::move(regions);
+            groups.push_back(std::move(group));
+            it = std::prev(groups.end());
+        }
+        it->model_indices.push_back(i);
+    }
+    return groups;
+}
+
+std::vector<int> StreamManager::cascade_parents(const StreamConfig& stream) {
+    const auto& models = stream.models;
+    auto find_model = [&models](const std::string& task_name) {
+        for (size_t i = 0; i < models.size(); i++) {
+            if (models[i].task_name == task_name) return static_cast<int>(i);
+        }
+        return -1;
+    };
+
+    // 只支持两级: 第一级模型自身必须是整帧推理
+    std::vector<int> parents(models.size(), -1);
+    for (size_t i = 0; i < models.size(); i++) {
+        if (models[i].cascade_from.empty()) continue;
+        int parent = find_model(models[i].cascade_from);
+        if (parent < 0 || parent == static_cast<int>(i) ||
+            !models[static_cast<size_t>(parent)].cascade_from.empty()) {
+            LOG_WARN("[{}] Model {}: cascade_from '{}' is not a full-frame model of this stream, "
+                     "running on full frames", stream.cam_id, models[i].task_name, models[i].cascade_from);
+            continue;
+        }
+        parents[i] = parent;
+    }
+    return parents;
+}
+
+std::shared_ptr<const StreamManager::CascadePlan> StreamManager::build_cascade_plan(
+    const StreamConfig& stream, const std::vector<std::shared_ptr<const ModelBinding>>& bindings)
+{
+    auto parents = cascade_parents(stream);
+    auto plan = std::make_shared<CascadePlan>();
+    for (size_t i = 0; i < stream.models.size() && i < bindings.size(); i++) {
+        if (parents[i] < 0) continue;
+        const auto& mc = stream.models[i];
+        CascadeStage stage;
+        stage.binding = bindings[i];
+        stage.slot = static_cast<int>(i);
+        stage.letterbox = mc.resize_mode != "stretch";
+        stage.classes = mc.cascade_classes;
+        stage.expand = std::clamp(mc.cascade_expand, 0.0f, 1.0f);
+        stage.max_crops = std::max(mc.cascade_max_crops, 1);
+        (*plan)[stream.models[static_cast<size_t>(parents[i])].task_name].push_back(std::move(stage));
+        LOG_INFO("[{}] Model {} cascades from {} ({} class filter(s))",
+                 stream.cam_id, mc.task_name, mc.cascade_from, mc.cascade_classes.size());
+    }
+    if (plan->empty()) return nullptr;
+    return plan;
+}
+
+void StreamManager::update_stage_ms(std::atomic<double>& avg,
+                                    std::chrono::steady_clock::time_point start) {
+    constexpr double kAlpha = 0.1;
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    double prev = avg.load(std::memory_order_relaxed);
+    avg.store(prev == 0.0 ? ms : prev + kAlpha * (ms - prev), std::memory_order_relaxed);
+}
+
 std::vector<std::string> StreamManager::load_labels_file(const std::string& path) {
     std::vector<std::string> labels;
     if (path.empty()) return labels;
@@ -393,150 +1180,630 @@ std::vector<std::string> StreamManager::load_labels_file(const std::string& path
     return labels;
 }
 
+std::shared_ptr<const LabelTable> StreamManager::intern_labels(const std::string& path) {
+    if (path.empty()) return nullptr;
+
+    auto& slot = label_tables_[path];
+    if (auto table = slot.lock()) return table;
+
+    auto table = std::make_shared<const LabelTable>(load_labels_file(path));
+    slot = table;
+    return table;
+}
+
+std::shared_ptr<const StreamTrackers> StreamManager::build_trackers(const StreamConfig& stream) {
+    auto trackers = std::make_shared<StreamTrackers>();
+    for (const auto& mc : stream.models) {
+        if (!mc.track) continue;
+        ObjectTracker::Options opts;
+        opts.high_threshold = mc.track_high_threshold;
+        opts.iou_threshold = mc.track_iou_threshold;
+        opts.max_age_ms = mc.track_max_age_ms;
+        trackers->add(mc.task_name, opts);
+    }
+    if (trackers->empty()) return nullptr;
+    return trackers;
+}
+
+std::vector<std::shared_ptr<const ModelBinding>> StreamManager::build_bindings(
+    const StreamConfig& config, const std::shared_ptr<StreamCounters>& counters,
+    const std::shared_ptr<const StreamTrackers>& trackers)
+{
+    // 清理已释放的标签表
+    for (auto it = label_tables_.begin(); it != label_tables_.end();) {
+        it = it->second.expired() ? label_tables_.erase(it) : std::next(it);
+    }
+
+    std::vector<std::shared_ptr<const ModelBinding>> bindings;
+    bindings.reserve(config.models.size());
+    for (const auto& mc : config.models) {
+        auto b = std::make_shared<ModelBinding>();
+        b->cam_id = config.cam_id;
+        b->rtsp_url = config.rtsp_url;
+        b->model_path = mc.model_path;
+        b->task_name = mc.task_name;
+        b->model_type = mc.model_type;
+        b->conf_threshold = mc.conf_threshold;
+        b->nms_threshold = mc.nms_threshold;
+        b->max_batch = mc.max_batch;
+        b->batch_wait_ms = mc.batch_wait_ms;
+        b->input_width = mc.input_width;
+        b->input_height = mc.input_height;
+        b->labels = intern_labels(mc.labels_file);
+        b->priority = task_priority_from_string(config.priority);
+        b->deadline_ms = config.deadline_ms > 0 ? config.deadline_ms : std::max(0, config_.infer_task_deadline_ms);
+        b->counters = counters;
+        b->trackers = trackers;
+        b->latency = std::make_shared<StageLatency>();
+        bindings.push_back(std::move(b));
+    }
+    return bindings;
+}
+
 // ============================================================
-// 解码线程主函数
+// 解码: 独立线程 / 线程池单步
 // ============================================================
 
 void StreamManager::decode_thread_func(StreamContext* ctx) {
+    ThreadPolicy::instance().apply(ThreadRole::Decode, "dec-" + ctx->config.cam_id);
+    LOG_INFO("[{}] Decode thread started", ctx->config.cam_id);
+
+    while (auto due = decode_step(ctx)) {
+        // 重连退避: 分段等待, 及时响应停止请求
+        while (!ctx->stop_requested.load(std::memory_order_relaxed)) {
+            auto now = std::chrono::steady_clock::now();
+            if (*due <= now) break;
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                *due - now, std::chrono::milliseconds(100)));
+        }
+    }
+}
+
+std::optional<std::chrono::steady_clock::time_point> StreamManager::decode_step(StreamContext* ctx) {
     const std::string& cam_id = ctx->config.cam_id;
-    LOG_INFO("[{}] Decode thread started", cam_id);
 
 #ifndef HAS_FFMPEG
     LOG_ERROR("[{}] FFmpeg not available, cannot decode RTSP", cam_id);
     ctx->set_error("FFmpeg not available");
     ctx->state = static_cast<int>(StreamState::Error);
     ctx->running = false;
-    return;
+    return std::nullopt;
 #else
+    using Clock = std::chrono::steady_clock;
+    auto& session = *ctx->decode_session;
+
+    if (session.phase == DecodeSession::Phase::Start) {
+        // 启动流水线下游阶段
+        ctx->frame_queue.reset();
+        ctx->encode_queue.reset();
+        ctx->cascade_queue->reset();
+        session.preprocess_thread = std::thread(&StreamManager::preprocess_thread_func, this, ctx);
+        session.encode_thread = std::thread(&StreamManager::encode_thread_func, this, ctx);
+        session.cascade_thread = std::thread(&StreamManager::cascade_thread_func, this, ctx);
+        session.phase = DecodeSession::Phase::Open;
+    }
 
-    uint64_t local_frame_count = 0;
-    int backoff_sec = 1;
-    const int max_backoff_sec = 8;
+    // 打开线程尚未返回 (停止请求使其尽快中止): 继续挂起, 由打开线程唤醒
+    if (session.opening.load(std::memory_order_acquire)) return DecodeScheduler::kParked;
+
+    if (ctx->stop_requested.load(std::memory_order_relaxed)) {
+        session.decoder.reset();
+
+        // 回收流水线: 先停预处理 (不再产生编码任务), 再停编码与级联
+        ctx->frame_queue.stop();
+        session.preprocess_thread.join();
+        ctx->encode_queue.stop();
+        session.encode_thread.join();
+        ctx->cascade_queue->stop();
+        session.cascade_thread.join();
+
+        ctx->state = static_cast<int>(StreamState::Stopped);
+        ctx->running = false;
+        LOG_INFO("[{}] Decode stopped (decoded {} frames)", cam_id, ctx->decoded_frames.load());
+        return std::nullopt;
+    }
+
+    // === 打开解码器 ===
+    if (session.open_due) {
+        auto due = *session.open_due;
+        session.open_due.reset();
+        return due;
+    }
+    if (session.phase == DecodeSession::Phase::Open) {
+        if (!session.pooled) return open_decoder(ctx);
+
+        // 线程池: 打开 / 重连可能阻塞 connect_timeout + read_timeout, 不占用池线程
+        session.opening.store(true, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(open_mutex_);
+            open_queue_.push_back(ctx);
+        }
+        open_cv_.notify_one();
+        return DecodeScheduler::kParked;
+    }
+
+    // === 解码: 每步一个包 ===
+    auto& decoder = *session.decoder;
+    if (!session.frame_pending) {
+        session.local_frame_count++;
+        if (ctx->admission) {
+            admission_->maybe_update(Clock::now());
+            session.need_process = ctx->admission->admit();
+        } else {
+            session.need_process = (session.skip <= 1) ||
+                (session.local_frame_count % static_cast<uint64_t>(session.skip)) == 0;
+        }
+        session.frame_pending = true;
+        session.decode_ns = 0;
+    }
+
+    // 跳帧时用轻量级路径：只推进解码器，不做 GPU→CPU 拷贝和 NV12 提取
+    std::optional<DecodedFrame> frame;
+    int64_t t_step = mono_now_ns();
+    auto status = decoder.poll(session.need_process, frame);
+    session.decode_ns += mono_now_ns() - t_step;
+
+    if (status == HwDecoder::PollStatus::Error) {
+        session.decoder.reset();
+        session.phase = DecodeSession::Phase::Open;
+        if (ctx->stop_requested.load()) return Clock::now();
+        ctx->set_error("Decode failed or stream ended");
+        ctx->state = static_cast<int>(StreamState::Reconnecting);
+        ctx->reconnect_count.fetch_add(1, std::memory_order_relaxed);
+        LOG_WARN("[{}] Decode failed, reconnecting in {}s...", cam_id, session.backoff_sec);
+        return session.retry_at();
+    }
+
+    if (status != HwDecoder::PollStatus::Pending) {
+        session.frame_pending = false;
+        ctx->decoded_frames.fetch_add(1, std::memory_order_relaxed);
+        ctx->counters->decode_rate.mark();
+        // nonref / keyframe 模式: 输出帧率 (如 GOP 间隔) 由包时间戳实测, 随帧刷新
+        if (session.decode_mode != DecodeMode::All) {
+            ctx->demux_discarded.store(session.discarded_base + decoder.discarded_packets(),
+                                       std::memory_order_relaxed);
+            session.apply_source_fps(ctx, decoder.get_output_fps());
+        }
+    }
+
+    if (status == HwDecoder::PollStatus::Frame) {
+        update_stage_ms(ctx->decode_ms, Clock::now() - std::chrono::nanoseconds(session.decode_ns));
+        frame->decoded_ns = mono_now_ns();
+        ctx->counters->latency.record(LatencyStage::Decode, session.decode_ns);
+        if (frame->copy_ns > 0) {
+            ctx->counters->latency.record(LatencyStage::Nv12Copy, frame->copy_ns);
+        }
+
+        // 交给预处理线程; 队列满时丢弃最旧帧, 解码不等待下游
+        std::optional<DecodedFrame> evicted;
+        ctx->frame_queue.push(std::move(*frame), evicted);
+        if (evicted) ctx->counters->drop_rate.mark();
+    }
+
+    // 独立线程: 直接读下一个包 (阻塞在网络 / 文件限速上)
+    auto now = Clock::now();
+    if (!session.pooled) return now;
+
+    // 线程池: 本地文件按限速时刻, 网络流按预测的下一个视频包到达时刻调度, 避免池线程阻塞在读取上
+    if (decoder.is_file()) {
+        int64_t next_ns = decoder.next_read_ns();
+        return next_ns > 0 ? Clock::time_point(std::chrono::nanoseconds(next_ns)) : now;
+    }
+    int64_t packet_ms = decoder.last_packet_ms();
+    if (packet_ms == session.last_packet_ms) return now;    // 非视频包: 继续读
+    session.last_packet_ms = packet_ms;
+    return session.predictor.next_read(now, packet_ms, decoder.last_read_blocked(), decoder.get_fps());
+#endif // HAS_FFMPEG
+}
 
+#ifdef HAS_FFMPEG
+std::chrono::steady_clock::time_point StreamManager::open_decoder(StreamContext* ctx) {
+    using Clock = std::chrono::steady_clock;
+    const std::string& cam_id = ctx->config.cam_id;
+    auto& session = *ctx->decode_session;
+
+    ctx->state = static_cast<int>(StreamState::Starting);
+    session.decoder = std::make_unique<HwDecoder>();
+    auto& decoder = *session.decoder;
+    HwDecoder::Config dec_cfg;
+    dec_cfg.rtsp_url = ctx->config.rtsp_url;
+    dec_cfg.tcp_transport = true;
+    dec_cfg.connect_timeout_sec = 5;
+    dec_cfg.read_timeout_sec = 5;
+    dec_cfg.zero_copy = config_.zero_copy;
+    dec_cfg.decode_mode = decode_mode_from_string(ctx->config.decode_mode);
+    dec_cfg.file_fps = ctx->config.file_fps;
+    decoder.set_packet_ring(ctx->packet_ring);
+    decoder.set_abort_flag(&ctx->stop_requested);
+
+    LOG_INFO("[{}] Opening RTSP stream: {}", cam_id, ctx->config.rtsp_url);
+    if (!decoder.open(dec_cfg)) {
+        session.decoder.reset();
+        if (ctx->stop_requested.load()) return Clock::now();
+        ctx->set_error("Failed to open RTSP stream");
+        ctx->state = static_cast<int>(StreamState::Reconnecting);
+        ctx->reconnect_count.fetch_add(1, std::memory_order_relaxed);
+        LOG_WARN("[{}] Failed to open, retrying in {}s...", cam_id, session.backoff_sec);
+        return session.retry_at();
+    }
+
+    // 打开成功, 重置退避
+    session.backoff_sec = 1;
+    ctx->state = static_cast<int>(StreamState::Running);
+    ctx->set_error("");
+    LOG_INFO("[{}] Stream opened: {}x{} @ {:.1f}fps codec={} hw={}",
+             cam_id, decoder.get_width(), decoder.get_height(),
+             decoder.get_fps(), decoder.get_codec_name(),
+             decoder.is_hardware() ? "yes" : "no");
+
+    // 解码输出缩放 (零拷贝路径 RGA 直接读 DMA-BUF, 不需要)
+    if (config_.decode_downscale && !config_.zero_copy) {
+        auto [out_w, out_h] = decode_output_size(config_, ctx->config, cache_ != nullptr,
+                                                 decoder.get_width(), decoder.get_height());
+        if (out_w > 0) {
+            decoder.set_output_size(out_w, out_h);
+            LOG_INFO("[{}] Decoder output scaled to {}x{}", cam_id, out_w, out_h);
+        }
+    }
+
+    // 准入控制开启时按分配到的帧率在解码前逐帧决定; 否则按固定间隔跳帧
+    // (设置了 target_fps 时由源帧率换算间隔)
+    session.decode_mode = dec_cfg.decode_mode;
+    session.skip = ctx->config.frame_skip;
+    session.apply_source_fps(ctx, decoder.get_output_fps());
+    session.discarded_base = ctx->demux_discarded.load(std::memory_order_relaxed);
+    session.frame_pending = false;
+    session.predictor.reset();
+    session.last_packet_ms = -1;
+    session.phase = DecodeSession::Phase::Run;
+    return Clock::now();
+}
+#endif // HAS_FFMPEG
+
+void StreamManager::opener_loop() {
+    ThreadPolicy::instance().apply(ThreadRole::Decode, "dec-open");
+
+    std::unique_lock<std::mutex> lock(open_mutex_);
+    while (true) {
+        open_cv_.wait(lock, [this]() { return !open_queue_.empty() || opener_stop_; });
+        if (open_queue_.empty()) break;
+
+        StreamContext* ctx = open_queue_.front();
+        open_queue_.pop_front();
+        lock.unlock();
+
+        auto& session = *ctx->decode_session;
+#ifdef HAS_FFMPEG
+        session.open_due = open_decoder(ctx);
+#endif
+        // 清除 opening 之后任务可能随即结束、ctx 被删除: 先取出任务 ID
+        uint64_t task = ctx->decode_task;
+        session.opening.store(false, std::memory_order_release);
+        decode_pool_->wake(task);
+
+        lock.lock();
+    }
+}
+
+// ============================================================
+// 流水线: 预处理线程 / 编码线程
+// ============================================================
+
+void StreamManager::preprocess_thread_func(StreamContext* ctx) {
+    ThreadPolicy::instance().apply(ThreadRole::Preprocess, "pre-" + ctx->config.cam_id);
+    LOG_DEBUG("[{}] Preprocess thread started", ctx->config.cam_id);
     while (!ctx->stop_requested.load(std::memory_order_relaxed)) {
-        // === 打开解码器 ===
-        ctx->state = static_cast<int>(StreamState::Starting);
-        HwDecoder decoder;
-        HwDecoder::Config dec_cfg;
-        dec_cfg.rtsp_url = ctx->config.rtsp_url;
-        dec_cfg.tcp_transport = true;
-        dec_cfg.connect_timeout_sec = 5;
-        dec_cfg.read_timeout_sec = 5;
-
-        LOG_INFO("[{}] Opening RTSP stream: {}", cam_id, ctx->config.rtsp_url);
-        if (!decoder.open(dec_cfg)) {
-            ctx->set_error("Failed to open RTSP stream");
-            ctx->state = static_cast<int>(StreamState::Reconnecting);
-            ctx->reconnect_count.fetch_add(1, std::memory_order_relaxed);
-            LOG_WARN("[{}] Failed to open, retrying in {}s...", cam_id, backoff_sec);
-
-            // 指数退避等待
-            for (int i = 0; i < backoff_sec * 10 && !ctx->stop_requested.load(); i++) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            }
-            backoff_sec = std::min(backoff_sec * 2, max_backoff_sec);
+        // 模型热切换: 在帧边界应用; mutex_ 被占用时留到下一轮
+        // (start_stream 持 mutex_ 等待本线程退出, 不能阻塞加锁)
+        if (ctx->swap_pending.load(std::memory_order_acquire)) {
+            std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+            if (lock.owns_lock()) apply_model_swap(*ctx);
+        }
+        // 热切换后的旧模型: 旧绑定全部释放后卸载 (同样不阻塞加锁)
+        if (retirement_.retired_count() > 0) unload_retired(true);
+        auto frame = ctx->frame_queue.pop(std::chrono::milliseconds(200));
+        if (!frame) {
+            if (ctx->frame_queue.is_stopped()) break;
             continue;
         }
+        auto t_start = std::chrono::steady_clock::now();
+        preprocess_frame(ctx, *frame);
+        update_stage_ms(ctx->preprocess_ms, t_start);
+    }
+    LOG_DEBUG("[{}] Preprocess thread stopped", ctx->config.cam_id);
+}
 
-        // 打开成功, 重置退避
-        backoff_sec = 1;
-        ctx->state = static_cast<int>(StreamState::Running);
-        ctx->set_error("");
-        LOG_INFO("[{}] Stream opened: {}x{} @ {:.1f}fps codec={} hw={}",
-                 cam_id, decoder.get_width(), decoder.get_height(),
-                 decoder.get_fps(), decoder.get_codec_name(),
-                 decoder.is_hardware() ? "yes" : "no");
+void StreamManager::encode_thread_func(StreamContext* ctx) {
+    ThreadPolicy::instance().apply(ThreadRole::Encode, "enc-" + ctx->config.cam_id);
+    LOG_DEBUG("[{}] Encode thread started", ctx->config.cam_id);
+    while (!ctx->stop_requested.load(std::memory_order_relaxed)) {
+        auto job = ctx->encode_queue.pop(std::chrono::milliseconds(200));
+        if (!job) {
+            if (ctx->encode_queue.is_stopped()) break;
+            continue;
+        }
+#ifdef HAS_TURBOJPEG
+        auto t_start = std::chrono::steady_clock::now();
+        auto jpeg = ctx->jpeg_encoder->encode_nv12(
+            job->nv12->data(), job->width, job->height,
+            config_.cache_jpeg_quality);
+
+        if (!jpeg.empty()) {
+            CachedFrame cf;
+            cf.cam_id = ctx->config.cam_id;
+            cf.frame_id = job->frame_id;
+            cf.timestamp_ms = job->timestamp_ms;
+            cf.width = job->width;
+            cf.height = job->height;
+            cf.jpeg_data = std::make_shared<std::vector<uint8_t>>(std::move(jpeg));
+            cache_->add_frame(std::move(cf));
+        }
+        update_stage_ms(ctx->encode_ms, t_start);
+#endif // HAS_TURBOJPEG
+    }
+    LOG_DEBUG("[{}] Encode thread stopped", ctx->config.cam_id);
+}
 
-        int orig_w = decoder.get_width();
-        int orig_h = decoder.get_height();
+void StreamManager::cascade_thread_func(StreamContext* ctx) {
+    ThreadPolicy::instance().apply(ThreadRole::Preprocess, "cas-" + ctx->config.cam_id);
+    LOG_DEBUG("[{}] Cascade thread started", ctx->config.cam_id);
+    auto& queue = *ctx->cascade_queue;
+    while (!ctx->stop_requested.load(std::memory_order_relaxed)) {
+        auto job = queue.pop(std::chrono::milliseconds(200));
+        if (!job) {
+            if (queue.is_stopped()) break;
+            continue;
+        }
+#ifdef HAS_RKNN
+        run_cascade(*job, engine_);
+#endif
+    }
+#ifdef HAS_RKNN
+    // 未处理的任务以空结果完成 (队列已停止, 之后的第一级结果不再投递)
+    while (auto job = queue.try_pop()) {
+        abandon_cascade(*job, engine_);
+    }
+#else
+    queue.clear();
+#endif
+    LOG_DEBUG("[{}] Cascade thread stopped", ctx->config.cam_id);
+}
+
+void StreamManager::preprocess_frame(StreamContext* ctx, const DecodedFrame& frame) {
+#ifndef HAS_RGA
+    (void)ctx;
+    (void)frame;
+#else
+    const std::string& cam_id = ctx->config.cam_id;
+    // 解码器缩放输出时, 检测框坐标与缓存尺寸仍以原始分辨率为准 (等比缩放, 几何关系不变)
+    int orig_w = frame.source_width > 0 ? frame.source_width : frame.width;
+    int orig_h = frame.source_height > 0 ? frame.source_height : frame.height;
 
-        // === 解码循环 ===
-        int skip = ctx->config.frame_skip;
+    // === RGA 预处理: 本帧所有输出 (模型输入 + 缓存缩略图) 合并为一个 job ===
+    auto batch = frame.dma_buf
+        ? std::make_unique<RgaFrameBatch>(*frame.dma_buf)
+        : std::make_unique<RgaFrameBatch>(frame.nv12_data->data(), frame.width, frame.height);
 
-        while (!ctx->stop_requested.load(std::memory_order_relaxed)) {
-            local_frame_count++;
-            bool need_process = (skip <= 1) ||
-                (local_frame_count % static_cast<uint64_t>(skip)) == 0;
-
-            // 跳帧时用轻量级路径：只推进解码器，不做 GPU→CPU 拷贝和 NV12 提取
-            if (!need_process) {
-                if (!decoder.skip_frame()) {
-                    ctx->set_error("Decode failed or stream ended");
-                    ctx->state = static_cast<int>(StreamState::Reconnecting);
-                    ctx->reconnect_count.fetch_add(1, std::memory_order_relaxed);
-                    LOG_WARN("[{}] Decode failed, reconnecting in {}s...", cam_id, backoff_sec);
-                    decoder.close();
-                    break;
+#ifdef HAS_RKNN
+    // 每个预处理分组 x 推理区域的输入 (零拷贝 tensor 或 CPU 内存 RGB, 二选一)
+    struct GroupInput {
+        std::shared_ptr<DmaBuffer> dma;
+        std::shared_ptr<std::vector<uint8_t>> rgb;
+        LetterboxTransform transform;       ///< 原图 (区域) -> 模型输入 (后处理据此反算坐标)
+    };
+    std::vector<std::vector<GroupInput>> group_inputs;
+    bool want_infer = engine_ && !ctx->config.models.empty();
+
+    // 模型仍在加载 (服务刚启动 / 刚添加流): 只解码和更新缓存, 不提交推理
+    if (want_infer && !ctx->models_ready.load(std::memory_order_relaxed)) {
+        if (engine_->models_ready(ctx->config.models)) {
+            ctx->models_ready.store(true, std::memory_order_relaxed);
+        } else {
+            want_infer = false;
+        }
+    }
+
+    // 场景静止: 不生成模型输入也不提交推理 (缓存缩略图照常更新)
+    bool motion_skip = want_infer && ctx->motion_gate && !motion_check(ctx, frame);
+    if (motion_skip) {
+        want_infer = false;
+    }
+
+    // infer_interval: 每个跟踪模型每 N 个处理帧推理一次, 其余帧由跟踪器外推
+    // (按模型下标错开, 多个模型不会在同一帧集中推理)
+    std::vector<bool> model_skipped(ctx->config.models.size(), false);
+    auto model_runs = [&model_skipped](size_t idx) { return !model_skipped[idx]; };
+
+    if (want_infer) {
+        uint64_t seq = ctx->processed_frames++;
+        if (ctx->trackers) {
+            for (const auto& group : ctx->preprocess_groups) {
+                for (size_t idx : group.model_indices) {
+                    const auto& mc = ctx->config.models[idx];
+                    int interval = std::max(mc.infer_interval, 1);
+                    model_skipped[idx] = mc.track && interval > 1 && (seq + idx) % interval != 0;
                 }
-                ctx->decoded_frames.fetch_add(1, std::memory_order_relaxed);
-                continue;
             }
+        }
 
-            auto frame = decoder.decode_frame();
-            if (!frame) {
-                ctx->set_error("Decode failed or stream ended");
-                ctx->state = static_cast<int>(StreamState::Reconnecting);
-                ctx->reconnect_count.fetch_add(1, std::memory_order_relaxed);
-                LOG_WARN("[{}] Decode failed, reconnecting in {}s...", cam_id, backoff_sec);
-                decoder.close();
-                break;
+        group_inputs.resize(ctx->preprocess_groups.size());
+        for (size_t g = 0; g < ctx->preprocess_groups.size(); g++) {
+            const auto& group = ctx->preprocess_groups[g];
+            // 本帧组内所有模型都不推理: 不生成模型输入
+            if (std::none_of(group.model_indices.begin(), group.model_indices.end(), model_runs)) {
+                continue;
             }
-            ctx->decoded_frames.fetch_add(1, std::memory_order_relaxed);
-
-            // === 推理提交 ===
-#if defined(HAS_RKNN) && defined(HAS_RGA)
-            if (engine_ && !ctx->config.models.empty()) {
-                int num_models = static_cast<int>(ctx->config.models.size());
-
-                // 构造基础 FrameResult 用于 Collector
-                FrameResult base_result;
-                base_result.cam_id = cam_id;
-                base_result.rtsp_url = ctx->config.rtsp_url;
-                base_result.frame_id = frame->frame_id;
-                base_result.timestamp_ms = frame->timestamp_ms;
-                base_result.pts = frame->pts;
-                base_result.original_width = orig_w;
-                base_result.original_height = orig_h;
-
-                // 多模型: 创建共享的 Collector
-                std::shared_ptr<FrameResultCollector> collector;
-                if (num_models > 1) {
-                    collector = std::make_shared<FrameResultCollector>(num_models, base_result);
-                }
+            group_inputs[g].resize(std::max<size_t>(group.regions.size(), 1));
 
-                for (const auto& mc : ctx->config.models) {
-                    // RGA: NV12 -> RGB (模型输入尺寸)
-                    auto rgb_data = RgaProcessor::nv12_to_rgb_resize(
-                        frame->nv12_data->data(), orig_w, orig_h,
-                        mc.input_width, mc.input_height);
+            for (size_t r = 0; r < group_inputs[g].size(); r++) {
+                auto& input = group_inputs[g][r];
 
-                    if (!rgb_data || rgb_data->empty()) {
-                        LOG_WARN("[{}] RGA resize failed for model {}", cam_id, mc.task_name);
-                        continue;
+                // ROI / 分块: 按解码输出尺寸裁剪, 区域原点和尺寸换算回原图坐标
+                CropRect crop;
+                if (!group.regions.empty()) {
+                    crop = group.regions[r].to_pixels(frame.width, frame.height);
+                }
+                input.transform = region_transform(crop, frame.width, frame.height, orig_w, orig_h,
+                                                   group.letterbox, group.input_width, group.input_height);
+
+                // 零拷贝: RGA 直接写入 NPU 输入 tensor (同组模型共享, 由组内第一个模型分配)
+                if (config_.zero_copy) {
+                    const auto& first = ctx->config.models[group.model_indices.front()];
+                    input.dma = engine_->model_manager().create_input_buffer(first.model_path);
+                    if (input.dma && !batch->add_rgb(*input.dma, input.transform, crop)) {
+                        LOG_DEBUG("[{}] Zero-copy RGA import failed for model {}, falling back to copy",
+                                  cam_id, first.task_name);
+                        input.dma.reset();
                     }
+                }
+
+                // RGA: NV12 -> RGB (模型输入尺寸, letterbox 时写入居中的子矩形)
+                if (!input.dma) {
+                    input.rgb = batch->add_rgb(input.transform, crop);
+                }
+            }
+        }
+    }
+#endif // HAS_RKNN
+
+#ifdef HAS_TURBOJPEG
+    // cache_mode = "raw": 缓存 NV12 缩略图, 由 ImageCache 在首次读取时编码
+    // cache_overlay 需要等推理结果回填后再编码, 同样按 raw 缓存
+    // cache_mode = "jpeg": 同样输出 NV12 缩略图, 由编码线程直接编码 NV12 (MPP 硬件编码或
+    // TurboJPEG YUV 编码), 无需 RGA 额外做一次 NV12 -> RGB 转换
+    bool lazy_cache = config_.cache_mode == "raw" || config_.cache_overlay;
+    std::shared_ptr<std::vector<uint8_t>> cache_nv12;
+    int cache_w = 0, cache_h = 0;
+    if (cache_ && (lazy_cache || (ctx->jpeg_encoder && ctx->jpeg_encoder->is_valid()))) {
+        cache_w = config_.cache_resize_width > 0 ? config_.cache_resize_width : orig_w;
+        cache_h = config_.cache_resize_height > 0
+            ? config_.cache_resize_height
+            : RgaProcessor::calc_proportional_height(orig_w, orig_h, cache_w);
+        // NV12 要求偶数宽高 (与 add_nv12 对齐规则一致)
+        cache_w = (cache_w + 1) & ~1;
+        cache_h = (cache_h + 1) & ~1;
+        cache_nv12 = batch->add_nv12(cache_w, cache_h);
+    }
+#endif // HAS_TURBOJPEG
+
+    bool rga_ok = true;
+    if (batch->size() > 0) {
+        int64_t t_rga = mono_now_ns();
+        rga_ok = batch->submit();
+        ctx->counters->latency.record(LatencyStage::Rga, mono_now_ns() - t_rga);
+    }
+    if (!rga_ok) {
+        LOG_WARN("[{}] RGA preprocess failed for frame {}", cam_id, frame.frame_id);
+    }
+
+    // === 推理提交 ===
+#ifdef HAS_RKNN
+    if (motion_skip) {
+        ctx->motion_skipped.fetch_add(1, std::memory_order_relaxed);
+        if (ctx->config.motion_skip_action == "republish") {
+            FrameResult repeated;
+            {
+                std::lock_guard<std::mutex> lock(ctx->counters->last_result_mutex);
+                repeated.results = ctx->counters->last_results;
+            }
+            // 首次推理结果尚未返回时没有可转发的结果
+            if (!repeated.results.empty()) {
+                repeated.cam_id = cam_id;
+                repeated.rtsp_url = ctx->config.rtsp_url;
+                repeated.frame_id = frame.frame_id;
+                repeated.timestamp_ms = frame.timestamp_ms;
+                repeated.pts = frame.pts;
+                repeated.original_width = orig_w;
+                repeated.original_height = orig_h;
+                repeated.repeated = true;
+                repeated.counters = ctx->counters;
+                repeated.decoded_ns = frame.decoded_ns;
+                engine_->publish(std::move(repeated));
+            }
+        }
+    }
 
+    if (rga_ok && want_infer) {
+        int num_models = static_cast<int>(ctx->config.models.size());
+        bool tiled = std::any_of(group_inputs.begin(), group_inputs.end(),
+                                 [](const std::vector<GroupInput>& inputs) { return inputs.size() > 1; });
+
+        // 多模型或分块: 创建共享的 Collector (基础 FrameResult 只在此时需要)
+        std::shared_ptr<FrameResultCollector> collector;
+        if (num_models > 1 || tiled) {
+            FrameResult base_result;
+            base_result.cam_id = cam_id;
+            base_result.rtsp_url = ctx->config.rtsp_url;
+            base_result.frame_id = frame.frame_id;
+            base_result.timestamp_ms = frame.timestamp_ms;
+            base_result.pts = frame.pts;
+            base_result.original_width = orig_w;
+            base_result.original_height = orig_h;
+            base_result.counters = ctx->counters;
+            base_result.trackers = ctx->trackers;
+            base_result.decoded_ns = frame.decoded_ns;
+            collector = std::make_shared<FrameResultCollector>(num_models, std::move(base_result));
+        }
+
+        // 级联: 保留解码帧, 第一级结果到达时投递到级联线程裁剪并提交第二级任务
+        if (collector && ctx->cascade_plan) {
+            auto retained = std::make_shared<CascadeFrame>();
+            retained->nv12_data = frame.nv12_data;
+            retained->dma_buf = frame.dma_buf;
+            retained->width = frame.width;
+            retained->height = frame.height;
+            retained->orig_w = orig_w;
+            retained->orig_h = orig_h;
+            retained->frame_id = frame.frame_id;
+            retained->pts = frame.pts;
+            retained->timestamp_ms = frame.timestamp_ms;
+            retained->parents_pending = static_cast<int>(ctx->cascade_plan->size());
+
+            std::weak_ptr<FrameResultCollector> weak = collector;
+            collector->set_stage_hook(
+                [plan = ctx->cascade_plan, retained, weak, queue = ctx->cascade_queue,
+                 engine = engine_](const ModelResult& mr) {
+                    auto self = weak.lock();
+                    if (!self) return std::vector<FrameResultCollector::SlotResult>{};
+                    return defer_cascade(plan, retained, mr, self, *queue, engine);
+                });
+        }
+
+        for (size_t g = 0; g < ctx->preprocess_groups.size(); g++) {
+            const auto& group = ctx->preprocess_groups[g];
+            const auto& inputs = group_inputs[g];
+
+            bool inputs_ok = std::all_of(inputs.begin(), inputs.end(), [](const GroupInput& input) {
+                return input.dma || (input.rgb && !input.rgb->empty());
+            });
+            if (!inputs_ok) {
+                LOG_WARN("[{}] RGA resize failed for {}x{} ({} model(s), {} region(s))",
+                         cam_id, group.input_width, group.input_height,
+                         group.model_indices.size(), inputs.size());
+                continue;
+            }
+
+            for (size_t model_idx : group.model_indices) {
+                if (!model_runs(model_idx)) continue;
+                if (collector && inputs.size() > 1) {
+                    collector->expect_tiles(static_cast<int>(model_idx), static_cast<int>(inputs.size()));
+                }
+                for (size_t r = 0; r < inputs.size(); r++) {
+                    const auto& input = inputs[r];
                     InferTask task;
-                    task.cam_id = cam_id;
-                    task.rtsp_url = ctx->config.rtsp_url;
-                    task.frame_id = frame->frame_id;
-                    task.pts = frame->pts;
-                    task.timestamp_ms = frame->timestamp_ms;
+                    task.frame_id = frame.frame_id;
+                    task.pts = frame.pts;
+                    task.timestamp_ms = frame.timestamp_ms;
                     task.original_width = orig_w;
                     task.original_height = orig_h;
-                    task.model_path = mc.model_path;
-                    task.task_name = mc.task_name;
-                    task.model_type = mc.model_type;
-                    task.conf_threshold = mc.conf_threshold;
-                    task.nms_threshold = mc.nms_threshold;
-                    task.input_data = rgb_data;
-                    task.input_width = mc.input_width;
-                    task.input_height = mc.input_height;
-
-                    // 标签
-                    auto lab_it = ctx->labels_cache.find(mc.model_path);
-                    if (lab_it != ctx->labels_cache.end()) {
-                        task.labels = lab_it->second;
-                    }
+                    task.binding = ctx->bindings[model_idx];
+                    task.input_data = input.rgb;
+                    task.input_dma = input.dma;
+                    task.transform = input.transform;
+                    task.tile_count = static_cast<int>(inputs.size());
+                    task.tile_index = static_cast<int>(r);
+                    task.result_slot = static_cast<int>(model_idx);
+                    task.decoded_ns = frame.decoded_ns;
 
                     // 聚合器
                     if (collector) {
@@ -546,55 +1813,288 @@ void StreamManager::decode_thread_func(StreamContext* ctx) {
                     engine_->submit(std::move(task));
                 }
             }
-#endif // HAS_RKNN && HAS_RGA
-
-            // === 图片缓存 ===
-#if defined(HAS_TURBOJPEG) && defined(HAS_RGA)
-            if (cache_ && ctx->jpeg_encoder && ctx->jpeg_encoder->is_valid()) {
-                int cache_w = config_.cache_resize_width > 0 ? config_.cache_resize_width : orig_w;
-                int cache_h = config_.cache_resize_height > 0
-                    ? config_.cache_resize_height
-                    : RgaProcessor::calc_proportional_height(orig_w, orig_h, cache_w);
-
-                auto cache_rgb = RgaProcessor::nv12_to_rgb_resize(
-                    frame->nv12_data->data(), orig_w, orig_h,
-                    cache_w, cache_h);
-
-                if (cache_rgb && !cache_rgb->empty()) {
-                    auto jpeg = ctx->jpeg_encoder->encode(
-                        cache_rgb->data(), cache_w, cache_h,
-                        config_.cache_jpeg_quality);
-
-                    if (!jpeg.empty()) {
-                        CachedFrame cf;
-                        cf.cam_id = cam_id;
-                        cf.frame_id = frame->frame_id;
-                        cf.timestamp_ms = frame->timestamp_ms;
-                        cf.width = cache_w;
-                        cf.height = cache_h;
-                        cf.jpeg_data = std::make_shared<std::vector<uint8_t>>(std::move(jpeg));
-                        cache_->add_frame(std::move(cf));
-                    }
+        }
+
+        // 本帧不推理的跟踪模型: 外推结果与推理结果一起输出
+        for (size_t idx = 0; idx < model_skipped.size(); idx++) {
+            if (!model_skipped[idx]) continue;
+            const auto& mc = ctx->config.models[idx];
+            ModelResult mr;
+            mr.task_name = mc.task_name;
+            mr.model_path = mc.model_path;
+            mr.predicted = true;
+            if (auto* tracker = ctx->trackers->find(mc.task_name)) {
+                mr.detections = tracker->predict(frame.timestamp_ms, orig_w, orig_h);
+            }
+            ctx->predicted_results.fetch_add(1, std::memory_order_relaxed);
+
+            if (collector) {
+                auto complete = collector->add_result(static_cast<int>(idx), std::move(mr));
+                if (complete) {
+                    engine_->publish(std::move(*complete));
                 }
+            } else {
+                FrameResult result;
+                result.cam_id = cam_id;
+                result.rtsp_url = ctx->config.rtsp_url;
+                result.frame_id = frame.frame_id;
+                result.timestamp_ms = frame.timestamp_ms;
+                result.pts = frame.pts;
+                result.original_width = orig_w;
+                result.original_height = orig_h;
+                result.counters = ctx->counters;
+                result.trackers = ctx->trackers;
+                result.decoded_ns = frame.decoded_ns;
+                result.results.push_back(std::move(mr));
+                engine_->publish(std::move(result));
             }
-#endif // HAS_TURBOJPEG && HAS_RGA
-        } // end decode loop
+        }
+    }
+#endif // HAS_RKNN
 
-        decoder.close();
+    // === 图片缓存: 投递给编码线程, 编码跟不上时丢弃最旧的缓存帧 ===
+#ifdef HAS_TURBOJPEG
+    if (rga_ok && lazy_cache && cache_nv12 && !cache_nv12->empty()) {
+        // 延迟编码: 直接写入缓存, 不经过编码线程
+        CachedFrame cf;
+        cf.cam_id = cam_id;
+        cf.frame_id = frame.frame_id;
+        cf.timestamp_ms = frame.timestamp_ms;
+        cf.width = cache_w;
+        cf.height = cache_h;
+        cf.raw_nv12 = std::move(cache_nv12);
+        cache_->add_frame(std::move(cf));
+    }
+    if (rga_ok && !lazy_cache && cache_nv12 && !cache_nv12->empty()) {
+        EncodeJob job;
+        job.frame_id = frame.frame_id;
+        job.timestamp_ms = frame.timestamp_ms;
+        job.width = cache_w;
+        job.height = cache_h;
+        job.nv12 = std::move(cache_nv12);
+        ctx->encode_queue.push(std::move(job));
+    }
+#endif // HAS_TURBOJPEG
+#endif // HAS_RGA
+}
 
-        // 等待退避时间后重连
-        if (!ctx->stop_requested.load()) {
-            for (int i = 0; i < backoff_sec * 10 && !ctx->stop_requested.load(); i++) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            }
-            backoff_sec = std::min(backoff_sec * 2, max_backoff_sec);
+bool StreamManager::motion_check(StreamContext* ctx, const DecodedFrame& frame) {
+    constexpr size_t kThumbBytes = static_cast<size_t>(MotionGate::kThumbWidth) * MotionGate::kThumbHeight;
+    uint8_t thumb[kThumbBytes];
+
+    if (frame.nv12_data && !frame.nv12_data->empty()) {
+        MotionGate::downsample(frame.nv12_data->data(), frame.width, frame.height, frame.width, thumb);
+    } else if (frame.dma_buf && frame.dma_buf->virt_addr) {
+        const auto& buf = *frame.dma_buf;
+        MotionGate::downsample(static_cast<const uint8_t*>(buf.virt_addr), buf.width, buf.height,
+                               buf.wstride > 0 ? buf.wstride : buf.width, thumb);
+    } else {
+#ifdef HAS_RGA
+        // DRM-PRIME 帧没有 CPU 映射: RGA 缩放出 NV12 缩略图, 取其 Y 平面
+        if (!frame.dma_buf) return true;
+        RgaFrameBatch batch(*frame.dma_buf);
+        auto small = batch.add_nv12(MotionGate::kThumbWidth, MotionGate::kThumbHeight);
+        if (!small || !batch.submit() || small->size() < kThumbBytes) return true;
+        std::copy_n(small->data(), kThumbBytes, thumb);
+#else
+        return true;
+#endif
+    }
+
+    bool changed = ctx->motion_gate->check(thumb, frame.timestamp_ms);
+    ctx->motion_score.store(ctx->motion_gate->last_score(), std::memory_order_relaxed);
+    return changed;
+}
+
+#ifdef HAS_RKNN
+bool StreamManager::cascade_candidate(const CascadeStage& stage, const Detection& det) {
+    if (det.bbox.x2 <= det.bbox.x1 || det.bbox.y2 <= det.bbox.y1) return false;
+    return stage.classes.empty() ||
+           std::any_of(stage.classes.begin(), stage.classes.end(), [&det](const std::string& c) {
+               return c == det.class_name || c == std::to_string(det.class_id);
+           });
+}
+
+namespace {
+
+/// 在级联线程计入第二级模型结果, 整帧因此完成时输出
+void complete_stages(FrameResultCollector& collector, std::vector<FrameResultCollector::SlotResult> results,
+                     InferenceEngine* engine) {
+    for (auto& sr : results) {
+        if (auto complete = collector.add_result(sr.slot, std::move(sr.result))) {
+            engine->publish(std::move(*complete));
         }
-    } // end reconnect loop
+    }
+}
 
-    ctx->state = static_cast<int>(StreamState::Stopped);
-    ctx->running = false;
-    LOG_INFO("[{}] Decode thread stopped (decoded {} frames)", cam_id, ctx->decoded_frames.load());
-#endif // HAS_FFMPEG
+} // namespace
+
+bool StreamManager::cascade_triggered(const CascadeStage& stage, const ModelResult& parent) {
+    return std::any_of(parent.detections.begin(), parent.detections.end(),
+                       [&stage](const Detection& det) { return cascade_candidate(stage, det); });
+}
+
+FrameResultCollector::SlotResult StreamManager::cascade_empty_result(const CascadeStage& stage) {
+    FrameResultCollector::SlotResult sr;
+    sr.slot = stage.slot;
+    sr.result.task_name = stage.binding->task_name;
+    sr.result.model_path = stage.binding->model_path;
+    return sr;
+}
+
+std::vector<FrameResultCollector::SlotResult> StreamManager::defer_cascade(
+    const std::shared_ptr<const CascadePlan>& plan, const std::shared_ptr<CascadeFrame>& frame,
+    const ModelResult& parent, const std::shared_ptr<FrameResultCollector>& collector,
+    BoundedQueue<CascadeJob>& queue, InferenceEngine* engine)
+{
+    auto it = plan->find(parent.task_name);
+    if (it == plan->end()) return {};
+
+    // 只做类别筛选 (不碰像素), 没有候选检测框的第二级模型立即以空结果计入
+    std::vector<FrameResultCollector::SlotResult> skipped;
+    for (const auto& stage : it->second) {
+        if (!cascade_triggered(stage, parent)) skipped.push_back(cascade_empty_result(stage));
+    }
+    if (skipped.size() == it->second.size()) {
+        frame->release_parent();
+        return skipped;
+    }
+
+    CascadeJob job;
+    job.plan = plan;
+    job.frame = frame;
+    job.parent = parent;
+    job.collector = collector;
+    std::optional<CascadeJob> evicted;
+    if (!queue.push(std::move(job), evicted)) {
+        // 流已停止: 不再裁剪
+        frame->release_parent();
+        skipped.clear();
+        for (const auto& stage : it->second) skipped.push_back(cascade_empty_result(stage));
+        return skipped;
+    }
+    if (evicted) {
+        LOG_WARN("[{}] Cascade queue full, dropping crops of frame {}",
+                 it->second.front().binding->cam_id, evicted->frame->frame_id);
+        abandon_cascade(*evicted, engine);
+    }
+    return skipped;
+}
+
+void StreamManager::abandon_cascade(CascadeJob& job, InferenceEngine* engine) {
+    auto it = job.plan->find(job.parent.task_name);
+    if (it == job.plan->end()) return;
+
+    std::vector<FrameResultCollector::SlotResult> results;
+    for (const auto& stage : it->second) {
+        if (cascade_triggered(stage, job.parent)) results.push_back(cascade_empty_result(stage));
+    }
+    job.frame->release_parent();
+    complete_stages(*job.collector, std::move(results), engine);
+}
+
+void StreamManager::run_cascade(CascadeJob& job, InferenceEngine* engine) {
+    auto it = job.plan->find(job.parent.task_name);
+    if (it == job.plan->end()) return;
+    CascadeFrame& frame = *job.frame;
+
+    std::vector<FrameResultCollector::SlotResult> skipped;
+#ifdef HAS_RGA
+    // 每个第二级模型的裁剪输入
+    struct StageInputs {
+        const CascadeStage* stage = nullptr;
+        std::vector<std::pair<std::shared_ptr<std::vector<uint8_t>>, LetterboxTransform>> crops;
+    };
+    std::vector<StageInputs> pending;
+
+    std::unique_ptr<RgaFrameBatch> batch;
+    if (frame.dma_buf) {
+        batch = std::make_unique<RgaFrameBatch>(*frame.dma_buf);
+    } else if (frame.nv12_data) {
+        batch = std::make_unique<RgaFrameBatch>(frame.nv12_data->data(), frame.width, frame.height);
+    }
+
+    for (const auto& stage : it->second) {
+        StageInputs inputs;
+        inputs.stage = &stage;
+        bool any = false;
+        // 第一级结果已按置信度降序, 取前 max_crops 个候选检测框
+        for (const auto& det : job.parent.detections) {
+            if (!cascade_candidate(stage, det)) continue;
+            any = true;
+            if (!batch || !batch->valid()) break;
+            if (static_cast<int>(inputs.crops.size()) >= stage.max_crops) break;
+
+            // 检测框四周扩展后换算为归一化区域, 再按解码输出尺寸取 RGA 对齐的像素矩形
+            float bw = det.bbox.x2 - det.bbox.x1;
+            float bh = det.bbox.y2 - det.bbox.y1;
+            float x1 = std::max(det.bbox.x1 - bw * stage.expand, 0.0f);
+            float y1 = std::max(det.bbox.y1 - bh * stage.expand, 0.0f);
+            float x2 = std::min(det.bbox.x2 + bw * stage.expand, static_cast<float>(frame.orig_w));
+            float y2 = std::min(det.bbox.y2 + bh * stage.expand, static_cast<float>(frame.orig_h));
+            RoiConfig region;
+            region.x = x1 / frame.orig_w;
+            region.y = y1 / frame.orig_h;
+            region.width = (x2 - x1) / frame.orig_w;
+            region.height = (y2 - y1) / frame.orig_h;
+            CropRect crop = region.to_pixels(frame.width, frame.height);
+
+            auto transform = region_transform(crop, frame.width, frame.height, frame.orig_w, frame.orig_h,
+                                              stage.letterbox, stage.binding->input_width,
+                                              stage.binding->input_height);
+            auto rgb = batch->add_rgb(transform, crop);
+            if (rgb) inputs.crops.emplace_back(std::move(rgb), transform);
+        }
+        // 没有候选检测框的槽位已由 defer_cascade() 计入
+        if (!any) continue;
+        if (inputs.crops.empty()) {
+            skipped.push_back(cascade_empty_result(stage));
+        } else {
+            pending.push_back(std::move(inputs));
+        }
+    }
+
+    bool rga_ok = pending.empty() || batch->submit();
+    if (!rga_ok) {
+        LOG_WARN("[{}] RGA cascade crop failed for frame {} (stage 1: {})",
+                 it->second.front().binding->cam_id, frame.frame_id, job.parent.task_name);
+    }
+    frame.release_parent();
+
+    for (auto& inputs : pending) {
+        const auto& stage = *inputs.stage;
+        if (!rga_ok) {
+            skipped.push_back(cascade_empty_result(stage));
+            continue;
+        }
+        int tile_count = static_cast<int>(inputs.crops.size());
+        if (tile_count > 1) job.collector->expect_tiles(stage.slot, tile_count);
+        for (int c = 0; c < tile_count; c++) {
+            auto& [rgb, transform] = inputs.crops[static_cast<size_t>(c)];
+            InferTask task;
+            task.frame_id = frame.frame_id;
+            task.pts = frame.pts;
+            task.timestamp_ms = frame.timestamp_ms;
+            task.original_width = frame.orig_w;
+            task.original_height = frame.orig_h;
+            task.binding = stage.binding;
+            task.input_data = std::move(rgb);
+            task.transform = transform;
+            task.tile_count = tile_count;
+            task.tile_index = c;
+            task.result_slot = stage.slot;
+            task.aggregator = job.collector;
+            engine->submit(std::move(task));
+        }
+    }
+#else
+    for (const auto& stage : it->second) {
+        if (cascade_triggered(stage, job.parent)) skipped.push_back(cascade_empty_result(stage));
+    }
+    frame.release_parent();
+#endif // HAS_RGA
+    complete_stages(*job.collector, std::move(skipped), engine);
 }
+#endif // HAS_RKNN
 
 } // namespace infer_server
@@ -0,0 +1,132 @@
+/**
+ * @file bench_bounded_queue.cpp
+ * @brief 有界队列 (BoundedQueue) 微基准: MUTEX 与 LOCK_FREE 两种实现
+ *
+ * 不需要硬件。元素模拟 InferTask: 携带一个共享帧句柄 (shared_ptr, 推入/弹出时原子引用计数)。
+ *   - roundtrip: 单线程 push + try_pop (无竞争开销)
+ *   - 1p1c / 4p4c / 8p3c: 生产者持续推入 (满时丢弃最旧元素, 与解码线程一致), 消费者阻塞弹出;
+ *     每次迭代推入 1000 个元素, 吞吐按推入次数计, 标签给出被丢弃的比例
+ *
+ * 运行:
+ *   ./bench_bounded_queue [过滤子串] [--min-time=0.5] [--json=bounded_queue.json]
+ */
+
+#include "bench_common.h"
+#include "infer_server/common/bounded_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace infer_server;
+
+namespace {
+
+constexpr size_t kCapacity = 64;
+constexpr int64_t kBatch = 1000;
+
+struct Payload {
+    std::shared_ptr<const int> frame;
+    uint64_t seq = 0;
+};
+
+const char* mode_name(QueueMode mode) {
+    return mode == QueueMode::LOCK_FREE ? "lock_free" : "mutex";
+}
+
+/**
+ * @brief producers 个线程共推入 n 个元素, consumers 个线程弹出直到队列耗尽
+ * @return 被丢弃 (满时淘汰) 的元素数
+ */
+size_t run_contended(QueueMode mode, int producers, int consumers, int64_t n) {
+    BoundedQueue<Payload> queue(kCapacity, mode);
+    auto frame = std::make_shared<const int>(0);
+    std::atomic<int> producers_left{producers};
+    std::atomic<bool> go{false};
+
+    std::vector<std::thread> threads;
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&] {
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            while (true) {
+                auto item = queue.pop(std::chrono::milliseconds(1));
+                if (item) {
+                    bench::do_not_optimize(item->seq);
+                } else if (producers_left.load(std::memory_order_acquire) == 0 && queue.empty()) {
+                    break;
+                }
+            }
+        });
+    }
+    for (int p = 0; p < producers; p++) {
+        int64_t count = n / producers + (p < n % producers ? 1 : 0);
+        threads.emplace_back([&, count] {
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (int64_t i = 0; i < count; i++) {
+                queue.push(Payload{frame, static_cast<uint64_t>(i)});
+            }
+            producers_left.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    go.store(true, std::memory_order_release);
+    for (auto& t : threads) t.join();
+    return queue.dropped_count();
+}
+
+void register_all() {
+    for (auto mode : {QueueMode::MUTEX, QueueMode::LOCK_FREE}) {
+        std::string mname = mode_name(mode);
+
+        bench::add("roundtrip/" + mname, [mode](bench::State& state) {
+            BoundedQueue<Payload> queue(kCapacity, mode);
+            auto frame = std::make_shared<const int>(0);
+            uint64_t seq = 0;
+            state.run([&] {
+                queue.push(Payload{frame, seq++});
+                auto item = queue.try_pop();
+                bench::do_not_optimize(item);
+            });
+            state.set_items_per_iter(1);
+        });
+
+        // 满队列推入: 每次推入都淘汰一个最旧元素 (推理跟不上解码时的稳态)
+        bench::add("push_full/" + mname, [mode](bench::State& state) {
+            BoundedQueue<Payload> queue(kCapacity, mode);
+            auto frame = std::make_shared<const int>(0);
+            for (size_t i = 0; i < kCapacity; i++) queue.push(Payload{frame, i});
+            uint64_t seq = 0;
+            state.run([&] { queue.push(Payload{frame, seq++}); });
+            state.set_items_per_iter(1);
+        });
+
+        for (auto [p, c] : {std::pair<int, int>{1, 1}, std::pair<int, int>{4, 4}, std::pair<int, int>{8, 3}}) {
+            std::string name = std::to_string(p) + "p" + std::to_string(c) + "c/" + mname;
+            int producers = p, consumers = c;
+            bench::add(name, [mode, producers, consumers](bench::State& state) {
+                size_t dropped = 0;
+                int64_t pushed = 0;
+                // 一次迭代 = kBatch 次推入, 摊薄线程启动开销
+                state.measure([&](int64_t n) {
+                    dropped += run_contended(mode, producers, consumers, n * kBatch);
+                    pushed += n * kBatch;
+                });
+                state.set_items_per_iter(kBatch);
+                char label[32];
+                std::snprintf(label, sizeof(label), "%.1f%% dropped",
+                              pushed > 0 ? 100.0 * static_cast<double>(dropped) / static_cast<double>(pushed) : 0.0);
+                state.set_label(label);
+            });
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    register_all();
+    return bench::run_all(argc, argv);
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+/**
+ * @file bench_common.h
+ * @brief 微基准测试框架 (header-only, 仿 Google Benchmark 的最小实现)
+ *
+ * 用法:
+ *   BENCH(yolov8_dense) {
+ *       auto fixture = make_fixture();             // 不计时
+ *       state.run([&] { bench::do_not_optimize(process(fixture)); });
+ *       state.set_items_per_iter(1);
+ *   }
+ *   BENCH_MAIN()
+ *
+ * state.run() 自动标定迭代次数 (单次测量不少于 --min-time 秒), 重复 --repetitions 次取中位数。
+ * 自己管理线程的基准 (如多生产者队列) 改用 state.measure(fn): fn(n) 自行执行 n 次操作, 整体计时。
+ *
+ * 命令行:
+ *   ./bench_xxx [过滤子串] [--min-time=0.5] [--repetitions=3] [--json=out.json]
+ * --json 输出与 Google Benchmark 相同的字段 (name / iterations / real_time / time_unit /
+ * items_per_second), 可直接用其 compare.py 对比两次提交的结果。
+ */
+
+#include "infer_server/common/logger.h"
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+/// 阻止编译器把结果当作无用计算删除
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Options {
+    std::string filter;
+    double min_time_sec = 0.5;
+    int repetitions = 3;
+    std::string json_path;
+};
+
+class State {
+public:
+    explicit State(const Options& opt) : opt_(opt) {}
+
+    /**
+     * @brief 计时执行 fn: 标定迭代次数后重复测量, 记录每次迭代的中位耗时
+     */
+    void run(const std::function<void()>& fn) {
+        measure_impl([&fn](int64_t n) {
+            for (int64_t i = 0; i < n; i++) fn();
+        });
+    }
+
+    /**
+     * @brief 计时执行 fn(n) (fn 自己执行 n 次操作, 如在多个线程间分配)
+     */
+    void measure(const std::function<void(int64_t)>& fn) { measure_impl(fn); }
+
+    /// 每次迭代处理的条目数 (输出 items_per_second)
+    void set_items_per_iter(double items) { items_per_iter_ = items; }
+
+    /// 附加说明 (如检测框数量)
+    void set_label(std::string label) { label_ = std::move(label); }
+
+    int64_t iterations() const { return iterations_; }
+    double ns_per_iter() const { return ns_per_iter_; }
+    double items_per_iter() const { return items_per_iter_; }
+    const std::string& label() const { return label_; }
+
+private:
+    static double elapsed_ns(const std::function<void(int64_t)>& fn, int64_t n) {
+        auto t0 = std::chrono::steady_clock::now();
+        fn(n);
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count();
+    }
+
+    void measure_impl(const std::function<void(int64_t)>& fn) {
+        const double target_ns = opt_.min_time_sec * 1e9;
+        int64_t n = 1;
+        double ns = elapsed_ns(fn, n);
+        while (ns < target_ns && n < (int64_t{1} << 40)) {
+            // 按已测耗时估计所需次数, 每轮最多放大 10 倍
+            double grow = ns > 0.0 ? std::min(10.0, target_ns * 1.2 / ns) : 10.0;
+            n = std::max(n + 1, static_cast<int64_t>(static_cast<double>(n) * grow));
+            ns = elapsed_ns(fn, n);
+        }
+
+        std::vector<double> per_iter{ns / static_cast<double>(n)};
+        for (int r = 1; r < opt_.repetitions; r++) {
+            per_iter.push_back(elapsed_ns(fn, n) / static_cast<double>(n));
+        }
+        std::sort(per_iter.begin(), per_iter.end());
+        iterations_ = n;
+        ns_per_iter_ = per_iter[per_iter.size() / 2];
+    }
+
+    const Options& opt_;
+    int64_t iterations_ = 0;
+    double ns_per_iter_ = 0.0;
+    double items_per_iter_ = 0.0;
+    std::string label_;
+};
+
+struct Case {
+    std::string name;
+    std::function<void(State&)> fn;
+};
+
+inline std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+struct Registrar {
+    Registrar(const char* name, std::function<void(State&)> fn) {
+        registry().push_back({name, std::move(fn)});
+    }
+};
+
+/// 注册带参数的基准 (名称形如 "yolov8/dense")
+inline void add(std::string name, std::function<void(State&)> fn) {
+    registry().push_back({std::move(name), std::move(fn)});
+}
+
+inline Options parse_options(int argc, char* argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--min-time=", 0) == 0) {
+            opt.min_time_sec = std::max(0.01, std::atof(arg.c_str() + 11));
+        } else if (arg.rfind("--repetitions=", 0) == 0) {
+            opt.repetitions = std::max(1, std::atoi(arg.c_str() + 14));
+        } else if (arg.rfind("--json=", 0) == 0) {
+            opt.json_path = arg.substr(7);
+        } else {
+            opt.filter = arg;
+        }
+    }
+    return opt;
+}
+
+/// 人类可读的耗时
+inline std::string format_ns(double ns) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(ns < 10.0 ? 2 : 1);
+    if (ns < 1e3) ss << ns << " ns";
+    else if (ns < 1e6) ss << ns / 1e3 << " us";
+    else ss << ns / 1e6 << " ms";
+    return ss.str();
+}
+
+inline int run_all(int argc, char* argv[]) {
+    Options opt = parse_options(argc, argv);
+    // 被测组件的 info 日志会打断结果表格
+    infer_server::logger::init("warn");
+    nlohmann::json results = nlohmann::json::array();
+
+    std::cout << std::left << std::setw(44) << "Benchmark" << std::right
+              << std::setw(14) << "Time" << std::setw(14) << "Iterations"
+              << std::setw(16) << "Items/s" << "  Label" << std::endl;
+    std::cout << std::string(100, '-') << std::endl;
+
+    for (const auto& c : registry()) {
+        if (!opt.filter.empty() && c.name.find(opt.filter) == std::string::npos) continue;
+        State state(opt);
+        c.fn(state);
+        if (state.iterations() == 0) continue;
+
+        double items_per_sec = state.items_per_iter() > 0.0 && state.ns_per_iter() > 0.0
+            ? state.items_per_iter() * 1e9 / state.ns_per_iter() : 0.0;
+        std::ostringstream items;
+        if (items_per_sec > 0.0) {
+            items << std::fixed << std::setprecision(1);
+            if (items_per_sec >= 1e6) items << items_per_sec / 1e6 << "M";
+            else if (items_per_sec >= 1e3) items << items_per_sec / 1e3 << "k";
+            else items << items_per_sec;
+        }
+        std::cout << std::left << std::setw(44) << c.name << std::right
+                  << std::setw(14) << format_ns(state.ns_per_iter())
+                  << std::setw(14) << state.iterations()
+                  << std::setw(16) << items.str()
+                  << "  " << state.label() << std::endl;
+
+        nlohmann::json r;
+        r["name"] = c.name;
+        r["iterations"] = state.iterations();
+        r["real_time"] = state.ns_per_iter();
+        r["time_unit"] = "ns";
+        if (items_per_sec > 0.0) r["items_per_second"] = items_per_sec;
+        if (!state.label().empty()) r["label"] = state.label();
+        results.push_back(std::move(r));
+    }
+
+    if (!opt.json_path.empty()) {
+        std::ofstream f(opt.json_path);
+        f << nlohmann::json{{"benchmarks", results}}.dump(2) << std::endl;
+    }
+    return 0;
+}
+
+} // namespace bench
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+
+/// 定义并注册一个基准, 函数体内可用 state
+#define BENCH(name)                                                             \
+    static void bench_##name(bench::State& state);                              \
+    static bench::Registrar BENCH_CONCAT(bench_registrar_, name)(#name, bench_##name); \
+    static void bench_##name(bench::State& state)
+
+#define BENCH_MAIN()                                                            \
+    int main(int argc, char* argv[]) { return bench::run_all(argc, argv); }
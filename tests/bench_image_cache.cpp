@@ -0,0 +1,142 @@
+/**
+ * @file bench_image_cache.cpp
+ * @brief 图片缓存 (ImageCache) 微基准
+ *
+ * 不需要硬件。场景为 64 路流 x 5 秒 x 25 fps (稳态 8000 帧), 每帧 JPEG 30 KB
+ * (所有帧共享同一块数据, 内存统计仍按每帧 30 KB 计, 不实际占用 240 MB)。
+ *   - add_frame/time_evict:   内存上限足够, 每次写入淘汰本流最旧的过期帧
+ *   - add_frame/memory_evict: 内存上限 64 MB (约 2200 帧), 每次写入触发 evict_global_memory
+ *   - get_nearest_frame:      随机流 + 窗口内随机时间戳查询, 可选一个并发写入线程 (25 fps x 64 路)
+ *
+ * 运行:
+ *   ./bench_image_cache [过滤子串] [--min-time=0.5] [--json=image_cache.json]
+ */
+
+#include "bench_common.h"
+#include "infer_server/cache/image_cache.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace infer_server;
+
+namespace {
+
+constexpr int kStreams = 64;
+constexpr int kDurationSec = 5;
+constexpr int kFps = 25;
+constexpr int64_t kFrameIntervalMs = 1000 / kFps;
+constexpr size_t kJpegBytes = 30 * 1024;
+
+/// 按 (流, 帧) 轮转生成缓存帧: 第 seq 帧属于 cam_(seq % 64), 时间戳每轮前进 40 ms
+class FrameSource {
+public:
+    FrameSource()
+        : jpeg_(std::make_shared<std::vector<uint8_t>>(kJpegBytes, 0xAB))
+    {
+        for (int i = 0; i < kStreams; i++) {
+            cam_ids_.push_back("cam_" + std::to_string(i));
+        }
+    }
+
+    CachedFrame next() {
+        CachedFrame f;
+        f.cam_id = cam_ids_[static_cast<size_t>(seq_ % kStreams)];
+        f.frame_id = seq_;
+        f.timestamp_ms = timestamp_of(seq_);
+        f.width = 640;
+        f.height = 360;
+        f.jpeg_data = jpeg_;
+        seq_++;
+        return f;
+    }
+
+    /// 填满一个缓存窗口 (每路 5 秒)
+    void fill(ImageCache& cache) {
+        for (int i = 0; i < kStreams * kDurationSec * kFps; i++) cache.add_frame(next());
+    }
+
+    const std::string& cam_id(int i) const { return cam_ids_[static_cast<size_t>(i)]; }
+
+    /// 最新一帧的时间戳
+    int64_t latest_ms() const { return seq_ > 0 ? timestamp_of(seq_ - 1) : 0; }
+
+private:
+    static int64_t timestamp_of(uint64_t seq) {
+        return 1700000000000 + static_cast<int64_t>(seq / kStreams) * kFrameIntervalMs;
+    }
+
+    std::shared_ptr<std::vector<uint8_t>> jpeg_;
+    std::vector<std::string> cam_ids_;
+    uint64_t seq_ = 0;
+};
+
+BENCH(add_frame_time_evict) {
+    ImageCache cache(kDurationSec, 1024);
+    FrameSource source;
+    source.fill(cache);
+    state.run([&] { cache.add_frame(source.next()); });
+    state.set_items_per_iter(1);
+    state.set_label(std::to_string(cache.total_frames()) + " frames");
+}
+
+BENCH(add_frame_memory_evict) {
+    ImageCache cache(kDurationSec, 64);
+    FrameSource source;
+    source.fill(cache);
+    state.run([&] { cache.add_frame(source.next()); });
+    state.set_items_per_iter(1);
+    state.set_label(std::to_string(cache.total_frames()) + " frames");
+}
+
+/// 随机查询; writer 为 true 时另有一个线程以实际帧率 (64 路 x 25 fps) 写入
+void bench_nearest(bench::State& state, bool writer) {
+    ImageCache cache(kDurationSec, 1024);
+    FrameSource source;
+    source.fill(cache);
+
+    std::atomic<int64_t> latest{source.latest_ms()};
+    std::atomic<bool> stop{false};
+    std::thread writer_thread;
+    if (writer) {
+        writer_thread = std::thread([&] {
+            auto next = std::chrono::steady_clock::now();
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < kStreams; i++) cache.add_frame(source.next());
+                latest.store(source.latest_ms(), std::memory_order_relaxed);
+                next += std::chrono::milliseconds(kFrameIntervalMs);
+                std::this_thread::sleep_until(next);
+            }
+        });
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> cam(0, kStreams - 1);
+    std::uniform_int_distribution<int64_t> offset(0, kDurationSec * 1000 - 1);
+    size_t hits = 0, total = 0;
+    state.run([&] {
+        int64_t ts = latest.load(std::memory_order_relaxed) - offset(rng);
+        auto f = cache.get_nearest_frame(source.cam_id(cam(rng)), ts);
+        hits += f ? 1 : 0;
+        total++;
+        bench::do_not_optimize(f);
+    });
+
+    stop.store(true);
+    if (writer_thread.joinable()) writer_thread.join();
+    state.set_items_per_iter(1);
+    state.set_label(std::to_string(total > 0 ? hits * 100 / total : 0) + "% hit");
+}
+
+BENCH(get_nearest_frame) { bench_nearest(state, false); }
+
+BENCH(get_nearest_frame_with_writer) { bench_nearest(state, true); }
+
+} // namespace
+
+BENCH_MAIN()
@@ -0,0 +1,453 @@
+/**
+ * @file bench_pipeline.cpp
+ * @brief 端到端压测: N 路虚拟摄像头 -> StreamManager -> InferenceEngine -> ZMQ
+ *
+ * 不需要真实摄像头: 每路流都以同一个本地 H.264 / H.265 文件为源 (StreamConfig::file_fps
+ * 限速回放, 文件结束后从头循环), 走与线上完全相同的解码 / RGA / 推理 / 输出路径。
+ * 预热结束后统计一个测量窗口, 输出:
+ * - 持续吞吐: 解码帧率, 推理帧率, NPU 任务速率
+ * - 丢弃: 流水线队列 + 推理队列丢弃的帧数 / 比例, 准入控制跳过的帧数
+ * - 分阶段延迟: 所有流合并后的 p50 / p99 / p999 (只含测量窗口内的样本)
+ * - 资源: 进程 CPU (核数), 整机 CPU 占用, RSS, DDR 负载 (devfreq dmc, 可用时)
+ * 可用 --json 写出机器可读的结果, 按提交记录性能回归。
+ *
+ * 源分辨率即文件分辨率, 不同分辨率请准备不同的文件, 如:
+ *   ffmpeg -i src.mp4 -vf scale=1920:1080 -c:v libx264 -g 50 -bf 0 -an bench_1080p.mp4
+ *
+ * 用法:
+ *   sudo ./bench_pipeline <video_file> <model.rknn> [options]
+ *     --streams N       虚拟流数量 (默认 4)
+ *     --fps F           每路回放帧率 (默认 0 = 文件帧率; < 0 不限速)
+ *     --frame-skip K    每 K 帧推理一次 (默认 1)
+ *     --model-type T    yolov5 / yolov8 / yolov11 (默认 yolov5)
+ *     --warmup S        预热秒数, 不计入统计 (默认 10)
+ *     --duration S      测量窗口秒数 (默认 60)
+ *     --config PATH     服务器配置文件 (默认使用内置默认值)
+ *     --json PATH       结果写入 JSON 文件
+ *
+ * 示例:
+ *   sudo ./bench_pipeline /data/bench_1080p.mp4 /weights/yolov8n.rknn \
+ *       --streams 16 --fps 25 --frame-skip 5 --model-type yolov8 --json bench.json
+ */
+
+#if defined(HAS_RKNN) && defined(HAS_FFMPEG) && defined(HAS_RGA)
+
+#include "infer_server/common/config.h"
+#include "infer_server/common/logger.h"
+#include "infer_server/common/buffer_pool.h"
+#include "infer_server/common/metrics.h"
+#include "infer_server/processor/rga_scheduler.h"
+#include "infer_server/stream/stream_manager.h"
+#include "infer_server/inference/inference_engine.h"
+
+#ifdef HAS_TURBOJPEG
+#include "infer_server/cache/image_cache.h"
+#endif
+
+#include <nlohmann/json.hpp>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace infer_server;
+using json = nlohmann::json;
+
+// ============================================================
+// 参数
+// ============================================================
+
+struct BenchOptions {
+    std::string video_path;
+    std::string model_path;
+    std::string model_type = "yolov5";
+    int streams = 4;
+    double fps = 0.0;
+    int frame_skip = 1;
+    int warmup_sec = 10;
+    int duration_sec = 60;
+    std::string config_path;
+    std::string json_path;
+};
+
+static void print_usage(const char* prog) {
+    std::cerr << "Usage: sudo " << prog << " <video_file> <model.rknn> [options]\n"
+              << "  --streams N       virtual streams (default 4)\n"
+              << "  --fps F           playback fps per stream (0 = file fps, < 0 = unpaced)\n"
+              << "  --frame-skip K    infer every K-th frame (default 1)\n"
+              << "  --model-type T    yolov5 / yolov8 / yolov11 (default yolov5)\n"
+              << "  --warmup S        warm-up seconds excluded from stats (default 10)\n"
+              << "  --duration S      measurement window seconds (default 60)\n"
+              << "  --config PATH     server config JSON\n"
+              << "  --json PATH       write results as JSON" << std::endl;
+}
+
+static bool parse_args(int argc, char* argv[], BenchOptions& opt) {
+    if (argc < 3) return false;
+    opt.video_path = argv[1];
+    opt.model_path = argv[2];
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--streams") opt.streams = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--fps") opt.fps = std::atof(value.c_str());
+        else if (arg == "--frame-skip") opt.frame_skip = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--model-type") opt.model_type = value;
+        else if (arg == "--warmup") opt.warmup_sec = std::max(0, std::atoi(value.c_str()));
+        else if (arg == "--duration") opt.duration_sec = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--config") opt.config_path = value;
+        else if (arg == "--json") opt.json_path = value;
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// ============================================================
+// 系统资源采样 (/proc, /sys)
+// ============================================================
+
+/// 进程累计 CPU 时间 (秒, 用户态 + 内核态)
+static double process_cpu_sec() {
+    std::ifstream f("/proc/self/stat");
+    std::string content((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    // comm 字段可能含空格, 从最后一个 ')' 之后开始数: state 为第 3 个字段, utime / stime 为第 14 / 15 个
+    size_t pos = content.rfind(')');
+    if (pos == std::string::npos) return 0.0;
+    std::istringstream ss(content.substr(pos + 2));
+    std::string field;
+    unsigned long long utime = 0, stime = 0;
+    for (int i = 3; i <= 15 && ss >> field; i++) {
+        if (i == 14) utime = std::stoull(field);
+        if (i == 15) stime = std::stoull(field);
+    }
+    return static_cast<double>(utime + stime) / static_cast<double>(sysconf(_SC_CLK_TCK));
+}
+
+/// 整机 CPU 时间 (jiffies): busy / total
+struct SystemCpu {
+    unsigned long long busy = 0;
+    unsigned long long total = 0;
+};
+
+static SystemCpu system_cpu() {
+    SystemCpu cpu;
+    std::ifstream f("/proc/stat");
+    std::string label;
+    f >> label;     // "cpu"
+    unsigned long long v = 0;
+    for (int i = 0; i < 8 && f >> v; i++) {
+        cpu.total += v;
+        if (i != 3 && i != 4) cpu.busy += v;    // idle, iowait
+    }
+    return cpu;
+}
+
+/// /proc/self/status 中的内存字段 (kB)
+static uint64_t proc_status_kb(const std::string& key) {
+    std::ifstream f("/proc/self/status");
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() && line[key.size()] == ':') {
+            return std::strtoull(line.c_str() + key.size() + 1, nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+/// DDR 控制器负载 (Rockchip devfreq dmc, "load@freq"); 不可用时返回 -1
+static int ddr_load_percent() {
+    std::ifstream f("/sys/class/devfreq/dmc/load");
+    int load = -1;
+    if (!(f >> load)) return -1;
+    return load;
+}
+
+// ============================================================
+// 统计汇总
+// ============================================================
+
+/// 所有流在某一时刻的累计计数
+struct Totals {
+    uint64_t decoded = 0;
+    uint64_t inferred = 0;
+    uint64_t dropped = 0;
+    uint64_t admission_skipped = 0;
+    uint64_t processed = 0;
+    uint64_t queue_dropped = 0;
+    uint64_t queue_expired = 0;
+    uint64_t output_dropped = 0;
+    double cpu_sec = 0.0;
+    SystemCpu system;
+    std::vector<uint64_t> npu_busy_us;
+    std::map<LatencyStage, LatencyHistogram::Snapshot> stages;  ///< 流级阶段, 所有流合并
+};
+
+static Totals collect(const StreamManager& mgr, const InferenceEngine& engine) {
+    Totals t;
+    // 强制重建快照: 测量窗口两端的计数不能滞后 status_refresh_ms
+    for (const auto& s : mgr.status_snapshot(0)->streams) {
+        t.decoded += s.decoded_frames;
+        t.inferred += s.inferred_frames;
+        t.dropped += s.dropped_frames;
+        t.admission_skipped += s.admission_skipped;
+    }
+    for (const auto& report : mgr.latency_reports()) {
+        if (!report.task_name.empty()) continue;
+        for (const auto& [stage, snap] : report.stages) t.stages[stage].merge(snap);
+    }
+    t.processed = engine.total_processed();
+    t.queue_dropped = engine.queue_dropped();
+    t.queue_expired = engine.queue_expired();
+    t.output_dropped = engine.output_stats().dropped;
+    for (const auto& ws : engine.worker_stats()) t.npu_busy_us.push_back(ws.npu_busy_us);
+    t.cpu_sec = process_cpu_sec();
+    t.system = system_cpu();
+    return t;
+}
+
+static double round2(double v) { return std::round(v * 100.0) / 100.0; }
+
+int main(int argc, char* argv[]) {
+    BenchOptions opt;
+    if (!parse_args(argc, argv, opt)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    ServerConfig config;
+    if (!opt.config_path.empty()) {
+        try {
+            config = ConfigManager::load_server_config(opt.config_path);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to load config " << opt.config_path << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    // 压测不落盘流配置, 也不占用线上的 ZMQ 端口
+    config.streams_save_path = "/tmp/bench_pipeline_streams.json";
+    config.zmq_endpoint = "ipc:///tmp/bench_pipeline.ipc";
+    config.log_level = "warn";
+
+    logger::init(config.log_level);
+    BufferPool::global().set_max_idle_bytes(
+        static_cast<size_t>(std::max(config.buffer_pool_max_mb, 0)) * 1024 * 1024);
+    RgaScheduler::instance().configure(config.rga_core_mask);
+
+    std::cout << "======================================" << std::endl;
+    std::cout << "  Pipeline Benchmark" << std::endl;
+    std::cout << "======================================" << std::endl;
+    std::cout << "  Video:      " << opt.video_path << std::endl;
+    std::cout << "  Model:      " << opt.model_path << " (" << opt.model_type << ")" << std::endl;
+    std::cout << "  Streams:    " << opt.streams << " @ "
+              << (opt.fps > 0.0 ? std::to_string(opt.fps) : opt.fps < 0.0 ? "unpaced" : "file")
+              << " fps, frame_skip " << opt.frame_skip << std::endl;
+    std::cout << "  Workers:    " << config.num_infer_workers << std::endl;
+    std::cout << "  Window:     " << opt.warmup_sec << " s warm-up + " << opt.duration_sec << " s" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+#ifdef HAS_TURBOJPEG
+    auto image_cache = std::make_unique<ImageCache>(
+        config.cache_duration_sec, config.cache_max_memory_mb, config.cache_jpeg_quality);
+    ImageCache* cache_ptr = image_cache.get();
+#else
+    ImageCache* cache_ptr = nullptr;
+#endif
+
+    InferenceEngine engine(config);
+    if (!engine.init()) {
+        std::cerr << "Failed to init InferenceEngine" << std::endl;
+        return 1;
+    }
+    StreamManager mgr(config, &engine, cache_ptr);
+    engine.set_result_callback([&mgr](const FrameResult& result) { mgr.on_infer_result(result); });
+
+    ModelConfig mc;
+    mc.model_path = opt.model_path;
+    mc.task_name = "bench";
+    mc.model_type = opt.model_type;
+
+    for (int i = 0; i < opt.streams; i++) {
+        char cam_id[32];
+        std::snprintf(cam_id, sizeof(cam_id), "bench_%02d", i);
+        StreamConfig sc;
+        sc.cam_id = cam_id;
+        sc.rtsp_url = opt.video_path;
+        sc.file_fps = opt.fps;
+        sc.frame_skip = opt.frame_skip;
+        sc.models = {mc};
+        if (!mgr.add_stream(sc)) {
+            std::cerr << "Failed to add stream " << cam_id << std::endl;
+            return 1;
+        }
+    }
+
+    // 预热: 模型加载 + 各流打开文件, 不计入统计
+    std::this_thread::sleep_for(std::chrono::seconds(opt.warmup_sec));
+    if (engine.model_load_stats().failed > 0) {
+        std::cerr << "Model failed to load: " << opt.model_path << std::endl;
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    Totals begin = collect(mgr, engine);
+    int ddr_samples = 0, ddr_sum = 0, ddr_max = -1;
+    uint64_t rss_peak_kb = 0;
+    for (int sec = 0; sec < opt.duration_sec; sec++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        int load = ddr_load_percent();
+        if (load >= 0) {
+            ddr_samples++;
+            ddr_sum += load;
+            ddr_max = std::max(ddr_max, load);
+        }
+        rss_peak_kb = std::max(rss_peak_kb, proc_status_kb("VmRSS"));
+    }
+    Totals end = collect(mgr, engine);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // ========================
+    // 结果
+    // ========================
+    uint64_t decoded = end.decoded - begin.decoded;
+    uint64_t inferred = end.inferred - begin.inferred;
+    uint64_t dropped = end.dropped - begin.dropped;
+    double drop_ratio = decoded > 0 ? static_cast<double>(dropped) / static_cast<double>(decoded) : 0.0;
+    double cpu_cores = (end.cpu_sec - begin.cpu_sec) / elapsed;
+    unsigned long long sys_total = end.system.total - begin.system.total;
+    double sys_cpu = sys_total > 0
+        ? static_cast<double>(end.system.busy - begin.system.busy) / static_cast<double>(sys_total) : 0.0;
+
+    json out;
+    out["streams"] = opt.streams;
+    out["fps_per_stream"] = opt.fps;
+    out["frame_skip"] = opt.frame_skip;
+    out["model"] = opt.model_path;
+    out["model_type"] = opt.model_type;
+    out["workers"] = config.num_infer_workers;
+    out["duration_sec"] = round2(elapsed);
+    out["decode_fps"] = round2(static_cast<double>(decoded) / elapsed);
+    out["infer_fps"] = round2(static_cast<double>(inferred) / elapsed);
+    out["npu_tasks_per_sec"] = round2(static_cast<double>(end.processed - begin.processed) / elapsed);
+    out["dropped_frames"] = dropped;
+    out["drop_ratio"] = std::round(drop_ratio * 10000.0) / 10000.0;
+    out["admission_skipped"] = end.admission_skipped - begin.admission_skipped;
+    out["infer_queue_dropped"] = end.queue_dropped - begin.queue_dropped;
+    out["infer_queue_expired"] = end.queue_expired - begin.queue_expired;
+    out["output_dropped"] = end.output_dropped - begin.output_dropped;
+
+    json npu = json::array();
+    for (size_t i = 0; i < end.npu_busy_us.size() && i < begin.npu_busy_us.size(); i++) {
+        double util = static_cast<double>(end.npu_busy_us[i] - begin.npu_busy_us[i]) / (elapsed * 1e6);
+        npu.push_back(std::round(util * 1000.0) / 1000.0);
+    }
+    out["npu_util"] = std::move(npu);
+
+    json latency = json::object();
+    for (auto& [stage, snap] : end.stages) {
+        auto it = begin.stages.find(stage);
+        if (it != begin.stages.end()) snap.subtract(it->second);
+        if (snap.count == 0) continue;
+        latency[latency_stage_name(stage)] = {
+            {"count", snap.count},
+            {"mean_ms", round2(snap.mean_us() / 1000.0)},
+            {"p50_ms", round2(static_cast<double>(snap.percentile_us(0.5)) / 1000.0)},
+            {"p99_ms", round2(static_cast<double>(snap.percentile_us(0.99)) / 1000.0)},
+            {"p999_ms", round2(static_cast<double>(snap.percentile_us(0.999)) / 1000.0)}
+        };
+    }
+    out["latency"] = latency;
+
+    out["cpu_cores"] = round2(cpu_cores);
+    out["system_cpu"] = std::round(sys_cpu * 1000.0) / 1000.0;
+    out["rss_mb"] = round2(static_cast<double>(rss_peak_kb) / 1024.0);
+    out["rss_peak_mb"] = round2(static_cast<double>(proc_status_kb("VmHWM")) / 1024.0);
+    if (ddr_samples > 0) {
+        out["ddr_load_avg"] = round2(static_cast<double>(ddr_sum) / ddr_samples);
+        out["ddr_load_max"] = ddr_max;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "  Results (" << elapsed << " s window)" << std::endl;
+    std::cout << "======================================" << std::endl;
+    std::cout << "  Decode FPS:        " << out["decode_fps"].get<double>() << " (total)" << std::endl;
+    std::cout << "  Infer FPS:         " << out["infer_fps"].get<double>() << " (total)" << std::endl;
+    std::cout << "  NPU tasks/s:       " << out["npu_tasks_per_sec"].get<double>() << std::endl;
+    std::cout << "  Dropped frames:    " << dropped << " (" << drop_ratio * 100.0 << "% of decoded)" << std::endl;
+    std::cout << "  Admission skipped: " << out["admission_skipped"].get<uint64_t>() << std::endl;
+    std::cout << "  Output dropped:    " << out["output_dropped"].get<uint64_t>() << std::endl;
+    for (size_t i = 0; i < out["npu_util"].size(); i++) {
+        std::cout << "  Worker " << i << " NPU util: " << out["npu_util"][i].get<double>() * 100.0 << "%" << std::endl;
+    }
+    std::cout << "  Process CPU:       " << cpu_cores << " cores" << std::endl;
+    std::cout << "  System CPU:        " << sys_cpu * 100.0 << "%" << std::endl;
+    std::cout << "  RSS:               " << out["rss_mb"].get<double>() << " MB (peak "
+              << out["rss_peak_mb"].get<double>() << " MB)" << std::endl;
+    if (ddr_samples > 0) {
+        std::cout << "  DDR load:          " << out["ddr_load_avg"].get<double>() << "% avg, "
+                  << ddr_max << "% max" << std::endl;
+    } else {
+        std::cout << "  DDR load:          n/a (/sys/class/devfreq/dmc/load not available)" << std::endl;
+    }
+    std::cout << "\n  Stage latency (ms)      p50      p99     p999     mean" << std::endl;
+    for (size_t i = 0; i < kNumLatencyStages; i++) {
+        const char* name = latency_stage_name(static_cast<LatencyStage>(i));
+        if (!latency.contains(name)) continue;
+        const auto& v = latency[name];
+        std::cout << "  " << std::left << std::setw(18) << name << std::right
+                  << std::setw(9) << v["p50_ms"].get<double>()
+                  << std::setw(9) << v["p99_ms"].get<double>()
+                  << std::setw(9) << v["p999_ms"].get<double>()
+                  << std::setw(9) << v["mean_ms"].get<double>() << std::endl;
+    }
+    std::cout << "======================================" << std::endl;
+
+    if (!opt.json_path.empty()) {
+        std::ofstream f(opt.json_path);
+        f << out.dump(2) << std::endl;
+        std::cout << "  Results written to " << opt.json_path << std::endl;
+    }
+
+    mgr.shutdown();
+    engine.shutdown();
+    logger::shutdown();
+    return inferred > 0 ? 0 : 1;
+}
+
+#else // Missing dependencies
+
+#include <iostream>
+int main() {
+    std::cout << "Pipeline benchmark requires all dependencies:" << std::endl;
+    std::cout << "  HAS_RKNN, HAS_FFMPEG, HAS_RGA" << std::endl;
+#ifndef HAS_RKNN
+    std::cout << "  Missing: HAS_RKNN (ENABLE_RKNN=ON)" << std::endl;
+#endif
+#ifndef HAS_FFMPEG
+    std::cout << "  Missing: HAS_FFMPEG (ENABLE_FFMPEG=ON)" << std::endl;
+#endif
+#ifndef HAS_RGA
+    std::cout << "  Missing: HAS_RGA (ENABLE_RGA=ON)" << std::endl;
+#endif
+    return 0;
+}
+
+#endif
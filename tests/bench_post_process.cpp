@@ -0,0 +1,308 @@
+/**
+ * @file bench_post_process.cpp
+ * @brief 后处理 (PostProcessor) 微基准
+ *
+ * 不需要硬件。输入为按真实模型输出分布合成的张量:
+ *   - yolov8: 3 个输出头 [1, grid, grid, 64 + 80] (grid = 80/40/20),
+ *     背景类别 logit ~ N(-9, 1.5), 每个目标在 3x3 邻域的 anchor 上给出高分与尖峰 DFL 分布
+ *     (与真实模型一样, 一个目标产生多个候选框, 由 NMS 合并)
+ *   - 目标密度: empty (0) / sparse (20) / crowd (200)
+ *   - yolov8_int8: 同一输出按 (zp=-10, scale=0.12) 量化, 走 process_int8
+ *   - yolov8_dequant: 同一量化输出先整体反量化再走浮点后处理 (yolov8_int8 的对照)
+ *   - yolov11: 单头 [1, 84, 8400], 约 2% 的 anchor 有高分类别
+ *   - NMS: 密集人群场景下的候选框 (100 / 1000 / 2000 个, 每个目标 8 个抖动框)
+ *
+ * 每个用例分别在 REFERENCE / PORTABLE 以及当前平台支持的 NEON 内核下测量。
+ *
+ * 运行:
+ *   ./bench_post_process [过滤子串] [--min-time=0.5] [--json=post_process.json]
+ */
+
+#include "bench_common.h"
+#include "infer_server/inference/post_kernels.h"
+#include "infer_server/inference/post_processor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace infer_server;
+
+namespace {
+
+constexpr int kNumClasses = 80;
+constexpr int kModelSize = 640;
+constexpr int kOrigW = 1920;
+constexpr int kOrigH = 1080;
+constexpr float kConfThresh = 0.25f;
+constexpr float kNmsThresh = 0.45f;
+
+struct Fixture {
+    std::vector<std::vector<float>> heads;
+    std::vector<std::vector<int8_t>> qheads;
+    std::vector<TensorAttr> attrs;
+    std::vector<TensorAttr> qattrs;
+
+    std::vector<float*> outputs() {
+        std::vector<float*> out;
+        for (auto& h : heads) out.push_back(h.data());
+        return out;
+    }
+    std::vector<const int8_t*> qoutputs() const {
+        std::vector<const int8_t*> out;
+        for (auto& h : qheads) out.push_back(h.data());
+        return out;
+    }
+};
+
+std::vector<std::string> make_labels() {
+    std::vector<std::string> labels;
+    for (int i = 0; i < kNumClasses; i++) labels.push_back("class_" + std::to_string(i));
+    return labels;
+}
+
+/// 把 DFL 分布设为以 bin 为中心的尖峰 (softmax 后约 90% 落在 bin 上)
+void set_dfl(float* dfl, float bin) {
+    for (int i = 0; i < 16; i++) {
+        float d = static_cast<float>(i) - bin;
+        dfl[i] = -d * d;
+    }
+}
+
+/// yolov8 三头输出, 植入 objects 个目标
+Fixture make_yolov8(int objects, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> background(-9.0f, 1.5f);
+    std::normal_distribution<float> dfl_noise(0.0f, 1.0f);
+    constexpr int kChannels = 64 + kNumClasses;
+
+    Fixture f;
+    for (int grid : {80, 40, 20}) {
+        std::vector<float> head(static_cast<size_t>(grid) * grid * kChannels);
+        for (size_t cell = 0; cell < head.size() / kChannels; cell++) {
+            float* entry = head.data() + cell * kChannels;
+            for (int c = 0; c < 64; c++) entry[c] = dfl_noise(rng);
+            for (int c = 0; c < kNumClasses; c++) entry[64 + c] = background(rng);
+        }
+        f.attrs.push_back({static_cast<int>(head.size()), {1, grid, grid, kChannels}, 0, 1.0f, false});
+        f.heads.push_back(std::move(head));
+    }
+
+    // 目标大小决定所在输出头 (小目标 stride 8, 大目标 stride 32)
+    std::uniform_int_distribution<int> head_dist(0, 2);
+    std::uniform_int_distribution<int> cls(0, kNumClasses - 1);
+    std::uniform_real_distribution<float> bin(2.0f, 6.0f);
+    std::uniform_real_distribution<float> logit(1.0f, 4.0f);
+    for (int o = 0; o < objects; o++) {
+        int h = head_dist(rng);
+        int grid = f.attrs[static_cast<size_t>(h)].dims[1];
+        std::uniform_int_distribution<int> pos(1, grid - 2);
+        int cx = pos(rng), cy = pos(rng);
+        int c = cls(rng);
+        float l = bin(rng), t = bin(rng), r = bin(rng), b = bin(rng);
+        float peak = logit(rng);
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                float* entry = f.heads[static_cast<size_t>(h)].data() +
+                    (static_cast<size_t>(cy + dy) * grid + static_cast<size_t>(cx + dx)) * kChannels;
+                set_dfl(entry + 0, l + static_cast<float>(dx));
+                set_dfl(entry + 16, t + static_cast<float>(dy));
+                set_dfl(entry + 32, r - static_cast<float>(dx));
+                set_dfl(entry + 48, b - static_cast<float>(dy));
+                // 中心 anchor 分数最高, 邻域递减
+                entry[64 + c] = peak - 1.5f * static_cast<float>(std::abs(dx) + std::abs(dy));
+            }
+        }
+    }
+    return f;
+}
+
+/// yolov11 单头输出 [1, 4 + 80, 8400], 约 2% 的 anchor 有一个高分类别
+Fixture make_yolov11(uint32_t seed) {
+    constexpr int kAnchors = 8400;
+    constexpr int kChannels = 4 + kNumClasses;
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> coord(0.0f, 640.0f);
+    std::uniform_real_distribution<float> size(4.0f, 200.0f);
+    std::uniform_real_distribution<float> prob(0.0f, 1.0f);
+    std::uniform_int_distribution<int> cls(0, kNumClasses - 1);
+
+    Fixture f;
+    std::vector<float> head(static_cast<size_t>(kChannels) * kAnchors);
+    for (int i = 0; i < kAnchors; i++) {
+        head[0 * kAnchors + i] = coord(rng);
+        head[1 * kAnchors + i] = coord(rng);
+        head[2 * kAnchors + i] = size(rng);
+        head[3 * kAnchors + i] = size(rng);
+    }
+    for (size_t i = 4 * kAnchors; i < head.size(); i++) head[i] = prob(rng) * 0.1f;
+    for (int i = 0; i < kAnchors; i++) {
+        if (prob(rng) < 0.02f) {
+            head[static_cast<size_t>(4 + cls(rng)) * kAnchors + i] = 0.5f + prob(rng) * 0.5f;
+        }
+    }
+    f.attrs.push_back({static_cast<int>(head.size()), {1, kChannels, kAnchors}, 0, 1.0f, false});
+    f.heads.push_back(std::move(head));
+    return f;
+}
+
+/// 按 (zp, scale) 量化所有输出头, 模拟 RKNN INT8 输出
+void quantize(Fixture& f, int32_t zp, float scale) {
+    f.qattrs = f.attrs;
+    for (size_t h = 0; h < f.heads.size(); h++) {
+        std::vector<int8_t> q(f.heads[h].size());
+        for (size_t i = 0; i < q.size(); i++) {
+            long v = std::lround(f.heads[h][i] / scale) + zp;
+            q[i] = static_cast<int8_t>(std::clamp(v, -128L, 127L));
+        }
+        f.qattrs[h].is_int8 = true;
+        f.qattrs[h].zp = zp;
+        f.qattrs[h].scale = scale;
+        f.qheads.push_back(std::move(q));
+    }
+}
+
+/// 密集人群 NMS 输入: 每个目标 8 个抖动候选框
+std::vector<Detection> make_crowd(int count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> center(0.0f, 1920.0f);
+    std::uniform_real_distribution<float> jitter(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> size(30.0f, 160.0f);
+    std::uniform_real_distribution<float> conf(0.1f, 1.0f);
+    std::uniform_int_distribution<int> cls(0, 3);
+
+    std::vector<Detection> dets;
+    while (static_cast<int>(dets.size()) < count) {
+        float cx = center(rng), cy = center(rng) * 0.5625f;
+        float w = size(rng), h = size(rng) * 2.0f;
+        int c = cls(rng);
+        for (int k = 0; k < 8 && static_cast<int>(dets.size()) < count; k++) {
+            Detection d;
+            d.class_id = c;
+            d.confidence = conf(rng);
+            d.bbox.x1 = cx + jitter(rng) - w / 2;
+            d.bbox.y1 = cy + jitter(rng) - h / 2;
+            d.bbox.x2 = d.bbox.x1 + w + jitter(rng);
+            d.bbox.y2 = d.bbox.y1 + h + jitter(rng);
+            dets.push_back(d);
+        }
+    }
+    return dets;
+}
+
+std::string detections_label(size_t n) {
+    return std::to_string(n) + " dets";
+}
+
+void register_all() {
+    std::vector<PostProcessKernel> kernels = {PostProcessKernel::REFERENCE, PostProcessKernel::PORTABLE};
+    if (PostProcessor::best_kernel() != PostProcessKernel::PORTABLE) kernels.push_back(PostProcessor::best_kernel());
+    const std::vector<std::pair<const char*, int>> densities = {
+        {"empty", 0}, {"sparse", 20}, {"crowd", 200}};
+
+    for (auto kernel : kernels) {
+        std::string kname = post_kernel_name(kernel);
+
+        for (const auto& [dname, objects] : densities) {
+            int n = objects;
+            bench::add("yolov8/" + std::string(dname) + "/" + kname, [kernel, n](bench::State& state) {
+                auto f = make_yolov8(n, 1000 + static_cast<uint32_t>(n));
+                auto outputs = f.outputs();
+                auto labels = make_labels();
+                PostProcessor::set_kernel(kernel);
+                size_t dets = 0;
+                state.run([&] {
+                    auto r = PostProcessor::process("yolov8", outputs, f.attrs, kModelSize, kModelSize,
+                                                    kOrigW, kOrigH, kConfThresh, kNmsThresh, labels);
+                    dets = r.size();
+                    bench::do_not_optimize(r);
+                });
+                state.set_items_per_iter(1);
+                state.set_label(detections_label(dets));
+            });
+
+            // 对照: want_float=1 的等价做法, 先反量化整个输出再走浮点后处理
+            bench::add("yolov8_dequant/" + std::string(dname) + "/" + kname, [kernel, n](bench::State& state) {
+                auto f = make_yolov8(n, 1000 + static_cast<uint32_t>(n));
+                quantize(f, -10, 0.12f);
+                auto outputs = f.outputs();
+                auto labels = make_labels();
+                PostProcessor::set_kernel(kernel);
+                size_t dets = 0;
+                state.run([&] {
+                    for (size_t h = 0; h < f.qheads.size(); h++) {
+                        PostProcessor::dequantize_int8(f.qheads[h].data(), outputs[h],
+                                                       static_cast<int>(f.qheads[h].size()),
+                                                       f.qattrs[h].zp, f.qattrs[h].scale);
+                    }
+                    auto r = PostProcessor::process("yolov8", outputs, f.attrs, kModelSize, kModelSize,
+                                                    kOrigW, kOrigH, kConfThresh, kNmsThresh, labels);
+                    dets = r.size();
+                    bench::do_not_optimize(r);
+                });
+                state.set_items_per_iter(1);
+                state.set_label(detections_label(dets));
+            });
+
+            bench::add("yolov8_int8/" + std::string(dname) + "/" + kname, [kernel, n](bench::State& state) {
+                auto f = make_yolov8(n, 1000 + static_cast<uint32_t>(n));
+                quantize(f, -10, 0.12f);
+                auto outputs = f.qoutputs();
+                auto labels = make_labels();
+                PostProcessor::set_kernel(kernel);
+                size_t dets = 0;
+                state.run([&] {
+                    auto r = PostProcessor::process_int8("yolov8", outputs, f.qattrs, kModelSize, kModelSize,
+                                                         kOrigW, kOrigH, kConfThresh, kNmsThresh, labels);
+                    dets = r.size();
+                    bench::do_not_optimize(r);
+                });
+                state.set_items_per_iter(1);
+                state.set_label(detections_label(dets));
+            });
+        }
+
+        bench::add("yolov11/8400/" + kname, [kernel](bench::State& state) {
+            auto f = make_yolov11(11);
+            auto outputs = f.outputs();
+            auto labels = make_labels();
+            PostProcessor::set_kernel(kernel);
+            size_t dets = 0;
+            state.run([&] {
+                auto r = PostProcessor::process("yolov11", outputs, f.attrs, kModelSize, kModelSize,
+                                                kOrigW, kOrigH, kConfThresh, kNmsThresh, labels);
+                dets = r.size();
+                bench::do_not_optimize(r);
+            });
+            state.set_items_per_iter(1);
+            state.set_label(detections_label(dets));
+        });
+
+        for (int count : {100, 1000, 2000}) {
+            bench::add("nms/" + std::to_string(count) + "/" + kname, [kernel, count](bench::State& state) {
+                const auto input = make_crowd(count, 7);
+                PostProcessor::set_kernel(kernel);
+                std::vector<Detection> dets;
+                // 拷贝输入计入耗时 (每次迭代需要未抑制的输入), 与 process() 内的 NMS 开销同量级
+                state.run([&] {
+                    dets = input;
+                    PostProcessor::nms(dets, kNmsThresh);
+                    bench::do_not_optimize(dets);
+                });
+                state.set_items_per_iter(static_cast<double>(count));
+                state.set_label(std::to_string(dets.size()) + " kept");
+            });
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    register_all();
+    int rc = bench::run_all(argc, argv);
+    PostProcessor::set_kernel(PostProcessor::default_kernel());
+    return rc;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file bench_result_codec.cpp
+ * @brief 结果序列化 (result_codec) 微基准: ZmqPublisher 每帧的编码开销
+ *
+ * 不需要硬件。FrameResult 含 2 个模型结果, 检测框总数 0 / 10 / 100。
+ *   - encode_json:    nlohmann::json DOM (默认输出格式)
+ *   - encode_msgpack: 直接写入复用的字节缓冲
+ *   - decode_msgpack: 订阅端解码
+ * 标签给出编码后的字节数。
+ *
+ * 运行:
+ *   ./bench_result_codec [过滤子串] [--min-time=0.5] [--json=result_codec.json]
+ */
+
+#include "bench_common.h"
+#include "infer_server/output/result_codec.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace infer_server;
+
+namespace {
+
+FrameResult make_result(int detections, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> coord(0.0f, 1800.0f);
+    std::uniform_real_distribution<float> size(20.0f, 120.0f);
+    std::uniform_real_distribution<float> conf(0.25f, 1.0f);
+    std::uniform_int_distribution<int> cls(0, 79);
+
+    FrameResult r;
+    r.cam_id = "cam_01";
+    r.rtsp_url = "rtsp://192.168.1.64:554/Streaming/Channels/101";
+    r.frame_id = 123456;
+    r.timestamp_ms = 1700000000123;
+    r.pts = 9876543;
+    r.original_width = 1920;
+    r.original_height = 1080;
+    for (int m = 0; m < 2; m++) {
+        ModelResult mr;
+        mr.task_name = m == 0 ? "phone_detection" : "smoking_detection";
+        mr.model_path = m == 0 ? "/opt/models/yolov8s_phone.rknn" : "/opt/models/yolov8s_smoke.rknn";
+        mr.inference_time_ms = 12.5 + m;
+        int count = detections / 2 + (m == 0 ? detections % 2 : 0);
+        for (int i = 0; i < count; i++) {
+            Detection d;
+            d.class_id = cls(rng);
+            d.class_name = "class_" + std::to_string(d.class_id);
+            d.confidence = conf(rng);
+            d.bbox.x1 = coord(rng);
+            d.bbox.y1 = coord(rng) * 0.5625f;
+            d.bbox.x2 = d.bbox.x1 + size(rng);
+            d.bbox.y2 = d.bbox.y1 + size(rng);
+            mr.detections.push_back(std::move(d));
+        }
+        r.results.push_back(std::move(mr));
+    }
+    return r;
+}
+
+void register_all() {
+    for (int dets : {0, 10, 100}) {
+        std::string suffix = "/" + std::to_string(dets);
+
+        bench::add("encode_json" + suffix, [dets](bench::State& state) {
+            auto r = make_result(dets, 3);
+            size_t bytes = 0;
+            state.run([&] {
+                auto s = result_codec::encode_json(r);
+                bytes = s.size();
+                bench::do_not_optimize(s);
+            });
+            state.set_items_per_iter(1);
+            state.set_label(std::to_string(bytes) + " B");
+        });
+
+        bench::add("encode_msgpack" + suffix, [dets](bench::State& state) {
+            auto r = make_result(dets, 3);
+            std::vector<uint8_t> buf;
+            state.run([&] {
+                result_codec::encode_msgpack(r, buf);
+                bench::do_not_optimize(buf);
+            });
+            state.set_items_per_iter(1);
+            state.set_label(std::to_string(buf.size()) + " B");
+        });
+
+        bench::add("decode_msgpack" + suffix, [dets](bench::State& state) {
+            auto r = make_result(dets, 3);
+            std::vector<uint8_t> buf;
+            result_codec::encode_msgpack(r, buf);
+            state.run([&] {
+                auto decoded = result_codec::decode_msgpack(buf.data(), buf.size());
+                bench::do_not_optimize(decoded);
+            });
+            state.set_items_per_iter(1);
+            state.set_label(std::to_string(buf.size()) + " B");
+        });
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    register_all();
+    return bench::run_all(argc, argv);
+}
@@ -0,0 +1,357 @@
+/**
+ * @file test_admission_controller.cpp
+ * @brief AdmissionController 自适应跳帧测试 (纯逻辑, 不需要硬件)
+ *
+ * 测试内容:
+ *   1. 默认请求帧率 = 源帧率 / frame_skip, 准入帧均匀分布
+ *   2. target_fps 覆盖 frame_skip, 不超过源帧率, 修改立即生效
+ *   3. 预算系数 AIMD: 队列高水位 / 丢弃收紧, 低水位放宽, 有上下限
+ *   4. 按 NPU 时间 max-min 公平分配: 轻负载流全部满足, 重负载流分剩余预算
+ *   5. 过载时保底 min_fps
+ *   6. 无开销信息时按系数缩放; 无结果的流按平均开销估计
+ *   7. maybe_update 按周期调用 LoadProbe
+ *   8. 注销的流不再参与分配
+ *
+ * 编译: cmake --build build --target test_admission_controller
+ * 运行: ./build/tests/test_admission_controller
+ */
+
+#include "infer_server/stream/admission_controller.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+// ============================================================
+// 简易测试框架 (同 test_bounded_queue)
+// ============================================================
+
+struct TestCase {
+    std::string name;
+    std::function<void()> func;
+};
+
+static std::vector<TestCase> g_tests;
+static int g_pass = 0;
+static int g_fail = 0;
+
+#define ASSERT_TRUE(cond)                                                      \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_TRUE failed: ") + #cond +                  \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_FALSE(cond) ASSERT_TRUE(!(cond))
+
+#define ASSERT_EQ(a, b)                                                        \
+    do {                                                                        \
+        auto _a = (a); auto _b = (b);                                          \
+        if (_a != _b) {                                                         \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_EQ failed: ") + #a + "=" +                 \
+                std::to_string(_a) + " != " + #b + "=" +                       \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_NEAR(a, b, eps)                                                 \
+    do {                                                                        \
+        double _a = (a); double _b = (b);                                      \
+        if (std::fabs(_a - _b) > (eps)) {                                       \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_NEAR failed: ") + #a + "=" +              \
+                std::to_string(_a) + " vs " + #b + "=" +                     \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define TEST(test_name)                                                        \
+    static void test_fn_##test_name();                                         \
+    static bool _reg_##test_name = [] {                                        \
+        g_tests.push_back({#test_name, test_fn_##test_name});                  \
+        return true;                                                            \
+    }();                                                                        \
+    static void test_fn_##test_name()
+
+// ============================================================
+// 测试用例
+// ============================================================
+
+using infer_server::AdmissionController;
+using infer_server::StreamCounters;
+using namespace std::chrono_literals;
+
+static AdmissionController::LoadSample make_load(size_t depth, size_t capacity,
+                                                 uint64_t dropped = 0, size_t workers = 1) {
+    AdmissionController::LoadSample load;
+    load.queue_depth = depth;
+    load.queue_capacity = capacity;
+    load.dropped = dropped;
+    load.workers = workers;
+    return load;
+}
+
+static std::shared_ptr<StreamCounters> make_counters(double cost_ms) {
+    auto c = std::make_shared<StreamCounters>();
+    c->frame_cost_ms = cost_ms;
+    return c;
+}
+
+static int count_admitted(AdmissionController::Stream& s, int frames) {
+    int n = 0;
+    for (int i = 0; i < frames; i++) {
+        if (s.admit()) n++;
+    }
+    return n;
+}
+
+// 1. 默认: 源帧率 / frame_skip
+TEST(default_demand_from_frame_skip) {
+    AdmissionController ac(AdmissionController::Options{});
+    auto s = ac.add_stream("cam1", 5, 0.0, make_counters(0.0));
+    s->set_source_fps(25.0);
+
+    ASSERT_NEAR(s->demand_fps(), 5.0, 1e-9);
+    ASSERT_NEAR(s->allowed_fps(), 5.0, 1e-9);   // add_stream 时按默认源帧率 25
+    ASSERT_EQ(s->effective_skip(), 5);
+
+    // 第一帧必定处理, 之后每 5 帧处理一帧
+    std::vector<int> admitted;
+    for (int i = 0; i < 20; i++) {
+        if (s->admit()) admitted.push_back(i);
+    }
+    ASSERT_EQ(admitted.size(), 4u);
+    ASSERT_EQ(admitted[0], 0);
+    ASSERT_EQ(admitted[1] - admitted[0], 5);
+    ASSERT_EQ(admitted[3] - admitted[2], 5);
+    ASSERT_EQ(s->rejected(), 16u);
+
+    // 解码器报告异常帧率时按默认值处理
+    s->set_source_fps(90000.0);
+    ASSERT_NEAR(s->demand_fps(), 5.0, 1e-9);
+}
+
+// 2. target_fps 覆盖 frame_skip
+TEST(target_fps_overrides_frame_skip) {
+    AdmissionController ac(AdmissionController::Options{});
+    auto s = ac.add_stream("cam1", 5, 10.0, make_counters(0.0));
+    s->set_source_fps(30.0);
+    ASSERT_NEAR(s->demand_fps(), 10.0, 1e-9);
+
+    // 不超过源帧率
+    s->set_target_fps(60.0);
+    ASSERT_NEAR(s->demand_fps(), 30.0, 1e-9);
+    ASSERT_NEAR(s->allowed_fps(), 30.0, 1e-9);
+    ASSERT_EQ(count_admitted(*s, 30), 30);
+
+    // 修改立即生效: 30fps 源, 目标 7.5 -> 每 4 帧一帧
+    s->set_target_fps(7.5);
+    ASSERT_NEAR(s->allowed_fps(), 7.5, 1e-9);
+    ASSERT_EQ(s->effective_skip(), 4);
+    ASSERT_EQ(count_admitted(*s, 120), 30);
+
+    // 0 = 恢复 frame_skip
+    s->set_target_fps(0.0);
+    ASSERT_NEAR(s->demand_fps(), 6.0, 1e-9);
+}
+
+// 3. 预算系数 AIMD
+TEST(scale_aimd) {
+    AdmissionController ac(AdmissionController::Options{});
+    ASSERT_NEAR(ac.scale(), 1.0, 1e-9);
+
+    ac.update(make_load(16, 16));          // 队列满: 乘性收紧
+    ASSERT_NEAR(ac.scale(), 0.8, 1e-9);
+
+    ac.update(make_load(8, 16));           // 中间区间: 保持
+    ASSERT_NEAR(ac.scale(), 0.8, 1e-9);
+
+    ac.update(make_load(0, 16, 3));        // 队列空但有新丢弃: 收紧
+    ASSERT_NEAR(ac.scale(), 0.64, 1e-9);
+
+    ac.update(make_load(0, 16, 3));        // 丢弃计数未增长, 队列空: 加性放宽
+    ASSERT_NEAR(ac.scale(), 0.74, 1e-9);
+
+    for (int i = 0; i < 100; i++) ac.update(make_load(0, 16, 3));
+    ASSERT_NEAR(ac.scale(), 2.0, 1e-9);    // 上限
+
+    for (int i = 0; i < 100; i++) ac.update(make_load(16, 16, 3));
+    ASSERT_NEAR(ac.scale(), 0.05, 1e-9);   // 下限
+
+    // 无队列信号时不调整
+    double before = ac.scale();
+    ac.update(make_load(0, 0));
+    ASSERT_NEAR(ac.scale(), before, 1e-9);
+}
+
+// 4. max-min 公平分配
+TEST(fair_share_by_npu_time) {
+    AdmissionController::Options opts;
+    opts.min_fps = 0.0;
+    AdmissionController ac(opts);
+
+    // 重负载流: 25fps x 100ms = 2500 ms/s; 轻负载流: 5fps x 10ms = 50 ms/s
+    auto heavy = ac.add_stream("heavy", 1, 0.0, make_counters(100.0));
+    auto light = ac.add_stream("light", 5, 0.0, make_counters(10.0));
+    heavy->set_source_fps(25.0);
+    light->set_source_fps(25.0);
+
+    // 1 个 worker, 队列中间区间 (scale 保持 1.0): 预算 1000 ms/s
+    ac.update(make_load(8, 16));
+    ASSERT_NEAR(light->allowed_fps(), 5.0, 1e-9);            // 全部满足
+    ASSERT_NEAR(heavy->allowed_fps(), (1000.0 - 50.0) / 100.0, 1e-9);
+
+    // 两路同样的重负载流平分预算
+    AdmissionController ac2(opts);
+    auto a = ac2.add_stream("a", 1, 0.0, make_counters(50.0));
+    auto b = ac2.add_stream("b", 1, 0.0, make_counters(50.0));
+    a->set_source_fps(25.0);
+    b->set_source_fps(25.0);
+    ac2.update(make_load(8, 16, 0, 2));    // 预算 2000 ms/s, 需求各 1250
+    ASSERT_NEAR(a->allowed_fps(), 20.0, 1e-9);
+    ASSERT_NEAR(b->allowed_fps(), 20.0, 1e-9);
+
+    // 需求未超预算: 全部满足
+    AdmissionController ac3(opts);
+    auto c = ac3.add_stream("c", 5, 0.0, make_counters(20.0));
+    c->set_source_fps(25.0);
+    ac3.update(make_load(8, 16));
+    ASSERT_NEAR(c->allowed_fps(), 5.0, 1e-9);
+}
+
+// 5. 保底 min_fps
+TEST(min_fps_floor) {
+    AdmissionController::Options opts;
+    opts.min_fps = 2.0;
+    AdmissionController ac(opts);
+    auto s = ac.add_stream("cam1", 1, 0.0, make_counters(1000.0));
+    auto slow = ac.add_stream("slow", 1, 1.0, make_counters(1000.0));
+    s->set_source_fps(25.0);
+
+    // 预算 1000 x 0.05 = 50 ms/s, 按开销只能分到 0.025 fps
+    for (int i = 0; i < 100; i++) ac.update(make_load(16, 16));
+    ASSERT_NEAR(s->allowed_fps(), 2.0, 1e-9);
+    // 请求帧率低于保底值时不超过请求帧率
+    ASSERT_NEAR(slow->allowed_fps(), 1.0, 1e-9);
+}
+
+// 6. 缺少开销信息
+TEST(missing_cost_information) {
+    AdmissionController::Options opts;
+    opts.min_fps = 0.0;
+    AdmissionController ac(opts);
+    auto counters_b = make_counters(0.0);
+    auto a = ac.add_stream("a", 1, 0.0, make_counters(0.0));
+    auto b = ac.add_stream("b", 1, 0.0, counters_b);
+
+    // 都没有推理结果: 只按系数缩放
+    ac.update(make_load(16, 16));           // scale 0.8
+    ASSERT_NEAR(a->allowed_fps(), 25.0 * 0.8, 1e-9);
+    ASSERT_NEAR(b->allowed_fps(), 25.0 * 0.8, 1e-9);
+
+    // 系数大于 1 时不超过请求帧率
+    for (int i = 0; i < 30; i++) ac.update(make_load(0, 16));
+    ASSERT_NEAR(a->allowed_fps(), 25.0, 1e-9);
+
+    // b 有了结果, a 按 b 的开销估计: 预算 1000 x 2.0 = 2000 ms/s, 各需 25 x 100 = 2500
+    counters_b->frame_cost_ms = 100.0;
+    ac.update(make_load(0, 16));
+    ASSERT_NEAR(a->allowed_fps(), 10.0, 1e-9);
+    ASSERT_NEAR(b->allowed_fps(), 10.0, 1e-9);
+
+    // 没有推理引擎 (workers = 0): 只按系数缩放
+    ac.update(make_load(16, 16, 0, 0));     // scale 1.6
+    ASSERT_NEAR(a->allowed_fps(), 25.0, 1e-9);
+}
+
+// 7. maybe_update 按周期调用 LoadProbe
+TEST(maybe_update_interval) {
+    AdmissionController::Options opts;
+    opts.update_interval_ms = 100;
+    int probes = 0;
+    AdmissionController ac(opts, [&probes]() {
+        probes++;
+        return make_load(16, 16);
+    });
+
+    auto t0 = AdmissionController::Clock::now();
+    ac.maybe_update(t0);
+    ASSERT_EQ(probes, 1);
+    ac.maybe_update(t0 + 50ms);
+    ASSERT_EQ(probes, 1);
+    ac.maybe_update(t0 + 100ms);
+    ASSERT_EQ(probes, 2);
+    ASSERT_NEAR(ac.scale(), 0.64, 1e-9);
+
+    // 没有 probe: 不调整系数
+    AdmissionController idle(opts);
+    idle.maybe_update(t0);
+    ASSERT_NEAR(idle.scale(), 1.0, 1e-9);
+}
+
+// 8. 注销的流不再参与分配
+TEST(remove_stream) {
+    AdmissionController::Options opts;
+    opts.min_fps = 0.0;
+    AdmissionController ac(opts);
+    auto a = ac.add_stream("a", 1, 0.0, make_counters(50.0));
+    auto b = ac.add_stream("b", 1, 0.0, make_counters(50.0));
+    ASSERT_EQ(ac.stream_count(), 2u);
+
+    ac.update(make_load(8, 16));            // 预算 1000, 各分 500 ms/s
+    ASSERT_NEAR(a->allowed_fps(), 10.0, 1e-9);
+
+    ac.remove_stream(b);
+    ASSERT_EQ(ac.stream_count(), 1u);
+    ac.update(make_load(8, 16));            // a 独占预算
+    ASSERT_NEAR(a->allowed_fps(), 20.0, 1e-9);
+
+    // 句柄仍可使用
+    ASSERT_TRUE(b->admit());
+}
+
+// ============================================================
+// 主函数
+// ============================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "  AdmissionController Unit Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    for (auto& tc : g_tests) {
+        std::cout << "[RUN ] " << tc.name << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            tc.func();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[PASS] " << tc.name << " (" << ms << "ms)" << std::endl;
+            g_pass++;
+        } catch (const std::exception& e) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[FAIL] " << tc.name << " (" << ms << "ms)" << std::endl;
+            std::cout << "       " << e.what() << std::endl;
+            g_fail++;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Results: " << g_pass << " passed, " << g_fail << " failed"
+              << " (total " << (g_pass + g_fail) << ")" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return g_fail > 0 ? 1 : 0;
+}
@@ -0,0 +1,313 @@
+/**
+ * @file test_affinity_scheduler.cpp
+ * @brief AffinityScheduler 模型亲和 / 工作窃取测试 (纯逻辑, 不需要 NPU)
+ *
+ * 测试内容:
+ *   1. 模型按负载均衡分配主 worker, 重复分配稳定; 卸载后释放分配
+ *   2. submit 路由到主 worker 队列
+ *   3. 热窃取: 仅窃取 can_steal 允许的模型
+ *   4. 冷窃取: 积压达到 steal_backlog 时无 context 也可窃取
+ *   5. 聚合统计 (size / dropped) 与 stop 唤醒
+ *   6. 多线程生产消费: 任务不丢不重
+ *   7. 空闲 worker 睡眠等待 submit 唤醒, 不轮询窃取
+ *
+ * 编译: cmake --build build --target test_affinity_scheduler
+ * 运行: ./build/tests/test_affinity_scheduler
+ */
+
+#include "infer_server/inference/affinity_scheduler.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <set>
+#include <mutex>
+
+// ============================================================
+// 简易测试框架 (同 test_bounded_queue)
+// ============================================================
+
+struct TestCase {
+    std::string name;
+    std::function<void()> func;
+};
+
+static std::vector<TestCase> g_tests;
+static int g_pass = 0;
+static int g_fail = 0;
+
+#define ASSERT_TRUE(cond)                                                      \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_TRUE failed: ") + #cond +                  \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_FALSE(cond) ASSERT_TRUE(!(cond))
+
+#define ASSERT_EQ(a, b)                                                        \
+    do {                                                                        \
+        auto _a = (a); auto _b = (b);                                          \
+        if (_a != _b) {                                                         \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_EQ failed: ") + #a + "=" +                 \
+                std::to_string(_a) + " != " + #b + "=" +                       \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define TEST(test_name)                                                        \
+    static void test_fn_##test_name();                                         \
+    static bool _reg_##test_name = [] {                                        \
+        g_tests.push_back({#test_name, test_fn_##test_name});                  \
+        return true;                                                            \
+    }();                                                                        \
+    static void test_fn_##test_name()
+
+// ============================================================
+// 测试用例
+// ============================================================
+
+using infer_server::AffinityScheduler;
+using infer_server::InferTask;
+using namespace std::chrono_literals;
+
+static InferTask make_task(const std::string& model, uint64_t frame_id = 0) {
+    auto binding = std::make_shared<infer_server::ModelBinding>();
+    binding->model_path = model;
+
+    InferTask t;
+    t.binding = std::move(binding);
+    t.frame_id = frame_id;
+    return t;
+}
+
+static const AffinityScheduler::CanStealFn kNoContext =
+    [](const std::string&) { return false; };
+
+// 1. 主 worker 分配
+TEST(assign_balances_models) {
+    AffinityScheduler sched(3, 8);
+    ASSERT_EQ(sched.home_worker("a.rknn"), -1);
+    ASSERT_EQ(sched.assign_model("a.rknn"), 0);
+    ASSERT_EQ(sched.assign_model("b.rknn"), 1);
+    ASSERT_EQ(sched.assign_model("c.rknn"), 2);
+    ASSERT_EQ(sched.assign_model("d.rknn"), 0);
+    // 重复分配返回同一 worker
+    ASSERT_EQ(sched.assign_model("b.rknn"), 1);
+    ASSERT_EQ(sched.home_worker("d.rknn"), 0);
+}
+
+// 1b. 卸载模型后释放分配, 新模型补到空出的 worker
+TEST(release_model_frees_home) {
+    AffinityScheduler sched(2, 8);
+    ASSERT_EQ(sched.assign_model("a.rknn"), 0);
+    ASSERT_EQ(sched.assign_model("b.rknn"), 1);
+    sched.release_model("a.rknn");
+    sched.release_model("unknown.rknn");
+    ASSERT_EQ(sched.home_worker("a.rknn"), -1);
+    ASSERT_EQ(sched.assign_model("a_v2.rknn"), 0);
+    ASSERT_EQ(sched.assign_model("c.rknn"), 0);
+}
+
+// 2. submit 路由到主 worker 队列
+TEST(submit_routes_to_home) {
+    AffinityScheduler sched(2, 8);
+    sched.assign_model("a.rknn");
+    sched.assign_model("b.rknn");
+
+    ASSERT_TRUE(sched.submit(make_task("a.rknn", 1)));
+    ASSERT_TRUE(sched.submit(make_task("b.rknn", 2)));
+    ASSERT_TRUE(sched.submit(make_task("b.rknn", 3)));
+    ASSERT_EQ(sched.queue(0).size(), 1u);
+    ASSERT_EQ(sched.queue(1).size(), 2u);
+    ASSERT_EQ(sched.size(), 3u);
+
+    auto t = sched.pop(0, 10ms, kNoContext);
+    ASSERT_TRUE(t.has_value());
+    ASSERT_EQ(t->frame_id, 1u);
+}
+
+// 3. 热窃取: 只取本 worker 有 context 的模型
+TEST(warm_steal_only_known_models) {
+    AffinityScheduler sched(2, 8);
+    sched.assign_model("a.rknn");   // worker 0
+    sched.assign_model("b.rknn");   // worker 1
+    sched.assign_model("c.rknn");   // worker 0
+
+    sched.submit(make_task("a.rknn", 1));
+    sched.submit(make_task("c.rknn", 2));
+
+    // worker 1 没有任何 context: 不窃取
+    ASSERT_FALSE(sched.pop(1, 20ms, kNoContext).has_value());
+    ASSERT_EQ(sched.steal_count(), 0u);
+
+    // worker 1 持有 c 的 context: 跳过 a, 窃取 c
+    auto t = sched.pop(1, 20ms, [](const std::string& m) { return m == "c.rknn"; });
+    ASSERT_TRUE(t.has_value());
+    ASSERT_TRUE(t->model_path() == "c.rknn");
+    ASSERT_EQ(sched.steal_count(), 1u);
+    ASSERT_EQ(sched.queue(0).size(), 1u);
+}
+
+// 4. 冷窃取: 积压达到阈值
+TEST(cold_steal_on_backlog) {
+    AffinityScheduler sched(2, 8, 3);
+    sched.assign_model("a.rknn");   // worker 0
+
+    sched.submit(make_task("a.rknn", 1));
+    sched.submit(make_task("a.rknn", 2));
+    ASSERT_FALSE(sched.pop(1, 10ms, kNoContext).has_value());
+
+    sched.submit(make_task("a.rknn", 3));
+    auto t = sched.pop(1, 10ms, kNoContext);
+    ASSERT_TRUE(t.has_value());
+    ASSERT_EQ(t->frame_id, 1u);     // 从队首窃取最旧任务
+    ASSERT_EQ(sched.steal_count(), 1u);
+}
+
+// 5. 聚合统计与 stop
+TEST(aggregate_stats_and_stop) {
+    AffinityScheduler sched(2, 2);
+    sched.assign_model("a.rknn");
+    sched.assign_model("b.rknn");
+
+    for (int i = 0; i < 3; i++) sched.submit(make_task("a.rknn", i));
+    for (int i = 0; i < 4; i++) sched.submit(make_task("b.rknn", i));
+    ASSERT_EQ(sched.size(), 4u);
+    ASSERT_EQ(sched.dropped_count(), 3u);
+
+    sched.clear();
+    ASSERT_EQ(sched.size(), 0u);
+
+    std::atomic<bool> got_task{true};
+    auto start = std::chrono::steady_clock::now();
+    std::thread waiter([&] {
+        got_task = sched.pop(0, 5000ms, kNoContext).has_value();
+    });
+    std::this_thread::sleep_for(50ms);
+    sched.stop();
+    waiter.join();
+    ASSERT_FALSE(got_task.load());
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start < 1000ms);
+    ASSERT_FALSE(sched.submit(make_task("a.rknn")));
+}
+
+// 6. 多线程生产消费
+TEST(concurrent_no_loss_no_dup) {
+    const int num_workers = 3;
+    const int per_model = 300;
+    const std::vector<std::string> models = {"a.rknn", "b.rknn", "c.rknn", "d.rknn"};
+
+    AffinityScheduler sched(num_workers, 4096);
+    for (const auto& m : models) sched.assign_model(m);
+
+    std::mutex seen_mutex;
+    std::set<uint64_t> seen;
+    std::atomic<int> consumed{0};
+    std::atomic<int> duplicates{0};
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < num_workers; w++) {
+        workers.emplace_back([&, w] {
+            // 每个 worker 都 "持有" 所有模型的 context, 允许任意窃取
+            auto can_steal = [](const std::string&) { return true; };
+            while (!done.load()) {
+                auto t = sched.pop(w, 20ms, can_steal);
+                if (!t) continue;
+                std::lock_guard<std::mutex> lock(seen_mutex);
+                if (!seen.insert(t->frame_id).second) duplicates++;
+                consumed++;
+            }
+        });
+    }
+
+    uint64_t id = 0;
+    for (int i = 0; i < per_model; i++) {
+        for (const auto& m : models) sched.submit(make_task(m, id++));
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (consumed.load() < static_cast<int>(id) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(5ms);
+    }
+    done = true;
+    for (auto& t : workers) t.join();
+
+    ASSERT_EQ(consumed.load(), static_cast<int>(id));
+    ASSERT_EQ(duplicates.load(), 0);
+    ASSERT_EQ(sched.dropped_count(), 0u);
+}
+
+// 7. 空闲 worker 等待 submit 唤醒
+TEST(idle_worker_sleeps_until_submit) {
+    AffinityScheduler sched(2, 8);
+    sched.assign_model("a.rknn");   // worker 0
+    sched.assign_model("c.rknn");   // worker 1
+    sched.assign_model("b.rknn");   // worker 0
+    sched.submit(make_task("a.rknn", 1));
+
+    // worker 1 只能窃取 b: 队列 0 中的 a 不可窃取, 睡眠期间不应反复检查
+    std::atomic<int> checks{0};
+    std::optional<InferTask> got;
+    auto start = std::chrono::steady_clock::now();
+    std::thread waiter([&] {
+        got = sched.pop(1, 5000ms, [&](const std::string& m) { checks++; return m == "b.rknn"; });
+    });
+    std::this_thread::sleep_for(100ms);
+    int idle_checks = checks.load();
+
+    sched.submit(make_task("b.rknn", 2));
+    waiter.join();
+    ASSERT_TRUE(idle_checks <= 2);
+    ASSERT_TRUE(got.has_value());
+    ASSERT_EQ(got->frame_id, 2u);
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start < 2000ms);
+    ASSERT_EQ(sched.steal_count(), 1u);
+}
+
+// ============================================================
+// 主函数
+// ============================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "  AffinityScheduler Unit Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    for (auto& tc : g_tests) {
+        std::cout << "[RUN ] " << tc.name << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            tc.func();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[PASS] " << tc.name << " (" << ms << "ms)" << std::endl;
+            g_pass++;
+        } catch (const std::exception& e) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[FAIL] " << tc.name << " (" << ms << "ms)" << std::endl;
+            std::cout << "       " << e.what() << std::endl;
+            g_fail++;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Results: " << g_pass << " passed, " << g_fail << " failed"
+              << " (total " << (g_pass + g_fail) << ")" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return g_fail > 0 ? 1 : 0;
+}
@@ -13,6 +13,17 @@
  *   8. reset 重置状态
  *   9. 多线程生产者/消费者 (正确性验证)
  *  10. 移动语义类型支持 (unique_ptr)
+ *  11. 容量为 1 的边界情况
+ *  12. 多生产者高压力测试
+ *  13. pop_if 按条件弹出 (跳过不匹配元素)
+ *  14. pop_if 超时 / 等待新元素
+ *  15. LOCK_FREE: FIFO / 丢弃最旧 / 丢弃计数
+ *  16. LOCK_FREE: 阻塞 pop 唤醒、超时与 stop
+ *  17. LOCK_FREE: pop_if 暂存区保持顺序
+ *  18. LOCK_FREE: 多生产者多消费者不丢不重
+ *  19. push(item, evicted) 交回被丢弃的最旧元素 (两种实现)
+ *  20. LOCK_FREE: pop_if 暂存的元素计入容量, 满时先丢弃暂存区中最旧的
+ *  21. 多个 pop_if 等待者: 新元素的唤醒转给能消费的等待者, 不匹配的元素不引起互相唤醒空转
  *
  * 编译: cmake --build build --target test_bounded_queue
  * 运行: ./build/tests/test_bounded_queue
@@ -82,6 +93,7 @@ static int g_fail = 0;
 // ============================================================
 
 using infer_server::BoundedQueue;
+using infer_server::QueueMode;
 
 // 1. 基本 push/pop - FIFO 顺序
 TEST(basic_push_pop) {
@@ -435,6 +447,309 @@ TEST(stress_test) {
     ASSERT_EQ(consumed + dropped, total);
 }
 
+// 13. pop_if 取出第一个匹配元素, 其余保持顺序
+TEST(pop_if_matching) {
+    BoundedQueue<int> q(10);
+    for (int i = 1; i <= 5; i++) q.push(i);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+    auto v = q.pop_if([](int x) { return x % 2 == 0; }, deadline);
+    ASSERT_TRUE(v.has_value());
+    ASSERT_EQ(*v, 2);
+    ASSERT_EQ(q.size(), 4u);
+
+    // 剩余元素顺序不变
+    ASSERT_EQ(*q.try_pop(), 1);
+    ASSERT_EQ(*q.try_pop(), 3);
+    ASSERT_EQ(*q.try_pop(), 4);
+    ASSERT_EQ(*q.try_pop(), 5);
+}
+
+// 14. pop_if 超时与等待新元素
+TEST(pop_if_timeout_and_wait) {
+    BoundedQueue<int> q(10);
+    q.push(1);
+
+    // 无匹配: 超时返回 nullopt, 不匹配的元素保留
+    auto start = std::chrono::steady_clock::now();
+    auto v = q.pop_if([](int x) { return x == 42; }, start + std::chrono::milliseconds(30));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_FALSE(v.has_value());
+    ASSERT_TRUE(elapsed >= std::chrono::milliseconds(25));
+    ASSERT_EQ(q.size(), 1u);
+
+    // 等待期间推入匹配元素
+    std::thread producer([&q] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        q.push(42);
+    });
+    v = q.pop_if([](int x) { return x == 42; },
+                 std::chrono::steady_clock::now() + std::chrono::milliseconds(500));
+    producer.join();
+    ASSERT_TRUE(v.has_value());
+    ASSERT_EQ(*v, 42);
+    ASSERT_EQ(q.size(), 1u);
+}
+
+// 15. LOCK_FREE: FIFO / 丢弃最旧 / 丢弃计数
+TEST(lockfree_fifo_and_drop_oldest) {
+    BoundedQueue<int> q(3, QueueMode::LOCK_FREE);
+    ASSERT_TRUE(q.mode() == QueueMode::LOCK_FREE);
+    ASSERT_TRUE(q.empty());
+
+    for (int i = 1; i <= 5; i++) ASSERT_TRUE(q.push(i));
+    ASSERT_EQ(q.size(), 3u);
+    ASSERT_TRUE(q.full());
+    ASSERT_EQ(q.dropped_count(), 2u);
+
+    ASSERT_EQ(*q.try_pop(), 3);
+    ASSERT_EQ(*q.try_pop(), 4);
+    ASSERT_EQ(*q.pop(std::chrono::milliseconds(10)), 5);
+    ASSERT_FALSE(q.try_pop().has_value());
+
+    // 环绕多圈
+    for (int i = 0; i < 100; i++) {
+        q.push(i);
+        ASSERT_EQ(*q.try_pop(), i);
+    }
+
+    // 移动语义类型
+    BoundedQueue<std::unique_ptr<int>> uq(2, QueueMode::LOCK_FREE);
+    uq.push(std::make_unique<int>(7));
+    uq.push(std::make_unique<int>(8));
+    uq.push(std::make_unique<int>(9));
+    ASSERT_EQ(**uq.try_pop(), 8);
+
+    q.push(1);
+    q.reset();
+    ASSERT_EQ(q.size(), 0u);
+    ASSERT_EQ(q.dropped_count(), 0u);
+}
+
+// 16. LOCK_FREE: 阻塞 pop 唤醒、超时与 stop
+TEST(lockfree_blocking_pop) {
+    BoundedQueue<int> q(4, QueueMode::LOCK_FREE);
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_FALSE(q.pop(std::chrono::milliseconds(30)).has_value());
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(25));
+
+    std::thread producer([&q] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        q.push(42);
+    });
+    auto v = q.pop(std::chrono::milliseconds(1000));
+    producer.join();
+    ASSERT_TRUE(v.has_value());
+    ASSERT_EQ(*v, 42);
+
+    std::atomic<bool> got{true};
+    std::thread consumer([&] { got = q.pop(std::chrono::milliseconds(5000)).has_value(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    start = std::chrono::steady_clock::now();
+    q.stop();
+    consumer.join();
+    ASSERT_FALSE(got.load());
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+    ASSERT_FALSE(q.push(1));
+}
+
+// 17. LOCK_FREE: pop_if 暂存区保持顺序
+TEST(lockfree_pop_if_stash) {
+    BoundedQueue<int> q(10, QueueMode::LOCK_FREE);
+    for (int i = 1; i <= 5; i++) q.push(i);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+    auto v = q.pop_if([](int x) { return x == 4; }, deadline);
+    ASSERT_TRUE(v.has_value());
+    ASSERT_EQ(*v, 4);
+    ASSERT_EQ(q.size(), 4u);
+
+    // 暂存区中的元素再次被 pop_if 找到
+    v = q.pop_if([](int x) { return x == 2; }, deadline);
+    ASSERT_EQ(*v, 2);
+
+    q.push(6);
+    ASSERT_EQ(*q.try_pop(), 1);
+    ASSERT_EQ(*q.pop(std::chrono::milliseconds(10)), 3);
+    ASSERT_EQ(*q.try_pop(), 5);
+    ASSERT_EQ(*q.try_pop(), 6);
+
+    // 等待期间推入匹配元素
+    q.push(1);
+    std::thread producer([&q] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        q.push(42);
+    });
+    v = q.pop_if([](int x) { return x == 42; },
+                 std::chrono::steady_clock::now() + std::chrono::milliseconds(500));
+    producer.join();
+    ASSERT_TRUE(v.has_value());
+    ASSERT_EQ(*v, 42);
+    ASSERT_EQ(*q.try_pop(), 1);
+}
+
+// 18. LOCK_FREE: 多生产者多消费者不丢不重
+TEST(lockfree_mpmc_no_loss) {
+    const int NUM_PRODUCERS = 4;
+    const int NUM_CONSUMERS = 4;
+    const int ITEMS_PER_PRODUCER = 20000;
+    const int TOTAL = NUM_PRODUCERS * ITEMS_PER_PRODUCER;
+
+    // 容量足够大, 不应丢弃
+    BoundedQueue<int> q(TOTAL, QueueMode::LOCK_FREE);
+    std::vector<std::atomic<int>> seen(TOTAL);
+    for (auto& s : seen) s = 0;
+    std::atomic<int> consumed{0};
+
+    std::vector<std::thread> threads;
+    for (int c = 0; c < NUM_CONSUMERS; c++) {
+        threads.emplace_back([&] {
+            while (consumed.load() < TOTAL) {
+                auto v = q.pop(std::chrono::milliseconds(10));
+                if (!v) continue;
+                seen[*v]++;
+                consumed++;
+            }
+        });
+    }
+    for (int p = 0; p < NUM_PRODUCERS; p++) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+                q.push(p * ITEMS_PER_PRODUCER + i);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    ASSERT_EQ(q.dropped_count(), 0u);
+    for (int i = 0; i < TOTAL; i++) {
+        ASSERT_EQ(seen[i].load(), 1);
+    }
+
+    // 小容量高压力: 消费 + 丢弃 = 推入
+    BoundedQueue<int> small(4, QueueMode::LOCK_FREE);
+    std::atomic<int> pops{0};
+    threads.clear();
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 5000; i++) {
+                if (i % 2 == 0) small.push(t * 5000 + i);
+                else if (small.try_pop()) pops++;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    while (small.try_pop()) pops++;
+    ASSERT_EQ(static_cast<size_t>(pops.load()) + small.dropped_count(), 8u * 2500u);
+}
+
+// 19. push(item, evicted): 交回被丢弃的元素
+TEST(push_returns_evicted) {
+    for (auto mode : {QueueMode::MUTEX, QueueMode::LOCK_FREE}) {
+        BoundedQueue<int> q(2, mode);
+        std::optional<int> evicted;
+
+        ASSERT_TRUE(q.push(1, evicted));
+        ASSERT_TRUE(q.push(2, evicted));
+        ASSERT_FALSE(evicted.has_value());
+
+        ASSERT_TRUE(q.push(3, evicted));
+        ASSERT_TRUE(evicted.has_value());
+        ASSERT_EQ(*evicted, 1);
+        ASSERT_EQ(q.dropped_count(), 1u);
+
+        evicted.reset();
+        q.stop();
+        ASSERT_FALSE(q.push(4, evicted));
+        ASSERT_FALSE(evicted.has_value());
+    }
+}
+
+// 20. LOCK_FREE: 暂存区计入容量, 满时丢弃最旧 (暂存区队首)
+TEST(lockfree_stash_counts_toward_capacity) {
+    BoundedQueue<int> q(4, QueueMode::LOCK_FREE);
+    for (int i = 1; i <= 4; i++) q.push(i);
+
+    // 1 2 3 被移入暂存区, 4 被取出
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+    auto v = q.pop_if([](int x) { return x == 4; }, deadline);
+    ASSERT_EQ(*v, 4);
+    ASSERT_EQ(q.size(), 3u);
+    ASSERT_FALSE(q.full());
+
+    q.push(5);
+    ASSERT_EQ(q.size(), 4u);
+    ASSERT_TRUE(q.full());
+    ASSERT_EQ(q.dropped_count(), 0u);
+
+    std::optional<int> evicted;
+    ASSERT_TRUE(q.push(6, evicted));    // 丢弃暂存区中的 1, 而不是环形缓冲中的 5
+    ASSERT_TRUE(evicted.has_value());
+    ASSERT_EQ(*evicted, 1);
+    q.push(7);                          // 丢弃 2
+    ASSERT_TRUE(q.size() <= q.capacity());
+    ASSERT_EQ(q.size(), 4u);
+    ASSERT_EQ(q.dropped_count(), 2u);
+
+    ASSERT_EQ(*q.try_pop(), 3);
+    ASSERT_EQ(*q.try_pop(), 5);
+    ASSERT_EQ(*q.try_pop(), 6);
+    ASSERT_EQ(*q.try_pop(), 7);
+    ASSERT_FALSE(q.try_pop().has_value());
+
+    // 全部元素都被暂存 (pop_if 不匹配超时) 后继续推入: 总量仍不超过容量
+    q.reset();
+    for (int i = 1; i <= 4; i++) q.push(i);
+    v = q.pop_if([](int) { return false; },
+                 std::chrono::steady_clock::now() + std::chrono::milliseconds(10));
+    ASSERT_FALSE(v.has_value());
+    for (int i = 5; i <= 10; i++) {
+        q.push(i);
+        ASSERT_TRUE(q.size() <= q.capacity());
+    }
+    ASSERT_EQ(q.dropped_count(), 6u);
+    for (int expect = 7; expect <= 10; expect++) ASSERT_EQ(*q.try_pop(), expect);
+    ASSERT_TRUE(q.empty());
+}
+
+// 21. 多个 pop_if 等待者 (批处理 worker 各自等待不同模型的任务)
+TEST(pop_if_waiters_no_ping_pong) {
+    for (auto mode : {QueueMode::MUTEX, QueueMode::LOCK_FREE}) {
+        BoundedQueue<int> q(16, mode);
+        std::atomic<int> pred_calls{0};
+        std::atomic<int> got_a{0}, got_b{0};
+        // deadline 足够长: 若唤醒丢失, 等待者要到超时才取走元素
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+        std::thread a([&] {
+            auto v = q.pop_if([&](int x) { pred_calls++; return x == 1; }, deadline);
+            if (v) got_a = *v;
+        });
+        std::thread b([&] {
+            auto v = q.pop_if([&](int x) { pred_calls++; return x == 2; }, deadline);
+            if (v) got_b = *v;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        // 两个等待者都不匹配的元素: 各自最多检查几次后继续睡眠
+        q.push(3);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        int idle_calls = pred_calls.load();
+
+        // 唤醒信号无论先到哪个等待者, 匹配的元素都被及时取走
+        q.push(2);
+        q.push(1);
+        a.join();
+        b.join();
+        ASSERT_TRUE(idle_calls < 20);
+        ASSERT_TRUE(std::chrono::steady_clock::now() < deadline - std::chrono::seconds(2));
+        ASSERT_EQ(got_a.load(), 1);
+        ASSERT_EQ(got_b.load(), 2);
+        ASSERT_EQ(*q.try_pop(), 3);
+    }
+}
+
 // ============================================================
 // 测试运行器
 // ============================================================
@@ -0,0 +1,238 @@
+/**
+ * @file test_buffer_pool.cpp
+ * @brief BufferPool 缓冲池测试
+ *
+ * 测试内容:
+ *   1. 分级容量 (64KB 向上取整)
+ *   2. 释放后复用 (hit/miss 统计)
+ *   3. 不同分级互不复用
+ *   4. 空闲内存上限 (超出直接释放)
+ *   5. trim / set_max_idle_bytes
+ *   6. 多线程 acquire/release 统计一致性
+ *
+ * 编译: cmake --build build --target test_buffer_pool
+ * 运行: ./build/tests/test_buffer_pool
+ */
+
+#include "infer_server/common/buffer_pool.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <memory>
+#include <functional>
+#include <chrono>
+
+// ============================================================
+// 简易测试框架 (同 test_bounded_queue)
+// ============================================================
+
+struct TestCase {
+    std::string name;
+    std::function<void()> func;
+};
+
+static std::vector<TestCase> g_tests;
+static int g_pass = 0;
+static int g_fail = 0;
+
+#define ASSERT_TRUE(cond)                                                      \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_TRUE failed: ") + #cond +                  \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_FALSE(cond) ASSERT_TRUE(!(cond))
+
+#define ASSERT_EQ(a, b)                                                        \
+    do {                                                                        \
+        auto _a = (a); auto _b = (b);                                          \
+        if (_a != _b) {                                                         \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_EQ failed: ") + #a + "=" +                 \
+                std::to_string(_a) + " != " + #b + "=" +                       \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define TEST(test_name)                                                        \
+    static void test_fn_##test_name();                                         \
+    static bool _reg_##test_name = [] {                                        \
+        g_tests.push_back({#test_name, test_fn_##test_name});                  \
+        return true;                                                            \
+    }();                                                                        \
+    static void test_fn_##test_name()
+
+// ============================================================
+// 测试用例
+// ============================================================
+
+using infer_server::BufferPool;
+
+static constexpr size_t KB = 1024;
+static constexpr size_t MB = 1024 * 1024;
+
+// 1. 分级容量
+TEST(size_class_rounding) {
+    ASSERT_EQ(BufferPool::size_class(0), 64 * KB);
+    ASSERT_EQ(BufferPool::size_class(1), 64 * KB);
+    ASSERT_EQ(BufferPool::size_class(64 * KB), 64 * KB);
+    ASSERT_EQ(BufferPool::size_class(64 * KB + 1), 128 * KB);
+    // 1920x1080 NV12
+    ASSERT_EQ(BufferPool::size_class(1920 * 1080 * 3 / 2), 3072 * KB);
+}
+
+// 2. 释放后复用同一块内存
+TEST(reuse_after_release) {
+    BufferPool pool(16 * MB);
+
+    const uint8_t* first_ptr = nullptr;
+    {
+        auto buf = pool.acquire(640 * 640 * 3);
+        ASSERT_EQ(buf->size(), static_cast<size_t>(640 * 640 * 3));
+        first_ptr = buf->data();
+
+        auto st = pool.get_stats();
+        ASSERT_EQ(st.misses, 1u);
+        ASSERT_EQ(st.hits, 0u);
+        ASSERT_EQ(st.bytes_in_use, BufferPool::size_class(640 * 640 * 3));
+    }
+
+    auto st = pool.get_stats();
+    ASSERT_EQ(st.bytes_in_use, 0u);
+    ASSERT_EQ(st.idle_buffers, 1u);
+    ASSERT_EQ(st.bytes_resident(), BufferPool::size_class(640 * 640 * 3));
+
+    auto buf = pool.acquire(640 * 640 * 3);
+    ASSERT_TRUE(buf->data() == first_ptr);
+    st = pool.get_stats();
+    ASSERT_EQ(st.hits, 1u);
+    ASSERT_EQ(st.misses, 1u);
+    ASSERT_EQ(st.idle_buffers, 0u);
+}
+
+// 3. 同一分级内不同尺寸可复用, 不同分级不复用
+TEST(size_class_isolation) {
+    BufferPool pool(16 * MB);
+
+    { auto a = pool.acquire(100 * KB); }
+    // 同一分级 (128KB)
+    {
+        auto b = pool.acquire(120 * KB);
+        ASSERT_EQ(b->size(), 120 * KB);
+        ASSERT_EQ(pool.get_stats().hits, 1u);
+    }
+    // 不同分级
+    {
+        auto c = pool.acquire(1 * MB);
+        ASSERT_EQ(pool.get_stats().hits, 1u);
+        ASSERT_EQ(pool.get_stats().misses, 2u);
+    }
+    ASSERT_EQ(pool.get_stats().idle_buffers, 2u);
+}
+
+// 4. 空闲上限: 超出部分直接释放
+TEST(idle_limit) {
+    BufferPool pool(1 * MB);
+
+    {
+        auto a = pool.acquire(512 * KB);
+        auto b = pool.acquire(512 * KB);
+        auto c = pool.acquire(512 * KB);
+        ASSERT_EQ(pool.get_stats().bytes_in_use, 1536 * KB);
+    }
+
+    auto st = pool.get_stats();
+    ASSERT_EQ(st.bytes_in_use, 0u);
+    ASSERT_EQ(st.bytes_idle, 1 * MB);
+    ASSERT_EQ(st.idle_buffers, 2u);
+}
+
+// 5. trim / set_max_idle_bytes
+TEST(trim_and_shrink) {
+    BufferPool pool(16 * MB);
+    {
+        auto a = pool.acquire(1 * MB);
+        auto b = pool.acquire(1 * MB);
+        auto c = pool.acquire(2 * MB);
+    }
+    ASSERT_EQ(pool.get_stats().bytes_idle, 4 * MB);
+
+    pool.set_max_idle_bytes(2 * MB);
+    ASSERT_TRUE(pool.get_stats().bytes_idle <= 2 * MB);
+
+    pool.trim();
+    ASSERT_EQ(pool.get_stats().bytes_idle, 0u);
+    ASSERT_EQ(pool.get_stats().idle_buffers, 0u);
+
+    // 上限为 0: 不复用
+    pool.set_max_idle_bytes(0);
+    { auto d = pool.acquire(1 * MB); }
+    ASSERT_EQ(pool.get_stats().idle_buffers, 0u);
+}
+
+// 6. 多线程: 统计守恒
+TEST(concurrent_acquire_release) {
+    BufferPool pool(64 * MB);
+    const int num_threads = 4;
+    const int iterations = 2000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&pool, t]() {
+            std::vector<BufferPool::Buffer> held;
+            for (int i = 0; i < iterations; i++) {
+                held.push_back(pool.acquire(static_cast<size_t>((t + 1) * 100 * KB)));
+                if (held.size() > 3) held.erase(held.begin());
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    auto st = pool.get_stats();
+    ASSERT_EQ(st.hits + st.misses, static_cast<uint64_t>(num_threads * iterations));
+    ASSERT_EQ(st.bytes_in_use, 0u);
+    ASSERT_TRUE(st.hits > st.misses);
+}
+
+// ============================================================
+// 主函数
+// ============================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "  BufferPool Unit Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    for (auto& tc : g_tests) {
+        std::cout << "[RUN ] " << tc.name << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            tc.func();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[PASS] " << tc.name << " (" << ms << "ms)" << std::endl;
+            g_pass++;
+        } catch (const std::exception& e) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[FAIL] " << tc.name << " (" << ms << "ms)" << std::endl;
+            std::cout << "       " << e.what() << std::endl;
+            g_fail++;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Results: " << g_pass << " passed, " << g_fail << " failed"
+              << " (total " << (g_pass + g_fail) << ")" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return g_fail > 0 ? 1 : 0;
+}
@@ -18,6 +18,7 @@
 
 #include "infer_server/common/config.h"
 #include "infer_server/common/types.h"
+#include "infer_server/cache/jpeg_encoder.h"
 
 #include <iostream>
 #include <string>
@@ -27,6 +28,7 @@
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <cmath>
 
 namespace fs = std::filesystem;
 
@@ -109,6 +111,11 @@ TEST(server_config_defaults) {
     ASSERT_EQ(config.decode_queue_size, 2);
     ASSERT_EQ(config.infer_queue_size, 18);
     ASSERT_EQ(config.log_level, std::string("info"));
+    ASSERT_FALSE(config.zero_copy);
+    ASSERT_TRUE(config.decode_downscale);
+    ASSERT_FALSE(config.infer_queue_lockfree);
+    ASSERT_EQ(config.infer_scheduler, std::string("shared"));
+    ASSERT_EQ(config.affinity_replicas, 1);
 }
 
 // 2. ServerConfig JSON 往返 (serialize → deserialize)
@@ -118,6 +125,8 @@ TEST(server_config_json_roundtrip) {
     original.zmq_endpoint = "ipc:///tmp/test.ipc";
     original.num_infer_workers = 2;
     original.log_level = "debug";
+    original.zero_copy = true;
+    original.infer_scheduler = "affinity";
 
     nlohmann::json j = original;
     std::cout << "    JSON: " << j.dump(2) << std::endl;
@@ -127,6 +136,8 @@ TEST(server_config_json_roundtrip) {
     ASSERT_EQ(restored.zmq_endpoint, std::string("ipc:///tmp/test.ipc"));
     ASSERT_EQ(restored.num_infer_workers, 2);
     ASSERT_EQ(restored.log_level, std::string("debug"));
+    ASSERT_TRUE(restored.zero_copy);
+    ASSERT_EQ(restored.infer_scheduler, std::string("affinity"));
     // 未修改的字段应保持默认值
     ASSERT_EQ(restored.decode_queue_size, 2);
 }
@@ -186,6 +197,8 @@ TEST(model_config_partial_json) {
     ASSERT_EQ(model.input_width, 640);                     // 默认值
     ASSERT_EQ(model.input_height, 640);                    // 默认值
     ASSERT_TRUE(model.conf_threshold > 0.24f && model.conf_threshold < 0.26f);
+    ASSERT_EQ(model.max_batch, 1);                         // 默认不批处理
+    ASSERT_EQ(model.batch_wait_ms, 2);
 }
 
 // 5. 配置文件保存与加载
@@ -321,6 +334,71 @@ TEST(api_response_json) {
     ASSERT_EQ(restored.data["added"].size(), 2u);
 }
 
+// 11. ROI / 分块配置与区域切分
+TEST(roi_tiling_regions) {
+    nlohmann::json j = {
+        {"cam_id", "cam_roi"},
+        {"rtsp_url", "rtsp://host/stream"},
+        {"rois", {{{"x", 0.5}, {"y", 0.25}, {"width", 0.5}, {"height", 0.5}}}},
+        {"models", {{{"model_path", "/weights/a.rknn"}, {"task_name", "a"},
+                     {"tile_cols", 2}, {"tile_rows", 2}, {"tile_overlap", 0.0}}}}
+    };
+    auto stream = j.get<StreamConfig>();
+    ASSERT_EQ(stream.rois.size(), 1u);
+    ASSERT_TRUE(stream.rois[0].valid());
+    ASSERT_TRUE(stream.models[0].rois.empty());
+    ASSERT_EQ(stream.models[0].tile_cols, 2);
+
+    // 无重叠 2x2: 每块为 ROI 的 1/4, 行优先
+    auto tiles = tile_regions(stream.rois, 2, 2, 0.0f);
+    ASSERT_EQ(tiles.size(), 4u);
+    ASSERT_TRUE(std::fabs(tiles[1].x - 0.75f) < 1e-5f);
+    ASSERT_TRUE(std::fabs(tiles[1].y - 0.25f) < 1e-5f);
+    ASSERT_TRUE(std::fabs(tiles[2].y - 0.5f) < 1e-5f);
+    ASSERT_TRUE(std::fabs(tiles[3].width - 0.25f) < 1e-5f);
+
+    // 有重叠: 首尾块仍贴合整帧边界, 相邻块重叠 20%
+    auto full = tile_regions({}, 3, 1, 0.2f);
+    ASSERT_EQ(full.size(), 3u);
+    ASSERT_TRUE(std::fabs(full[0].x) < 1e-5f);
+    ASSERT_TRUE(std::fabs(full[2].x + full[2].width - 1.0f) < 1e-5f);
+    ASSERT_TRUE(std::fabs((full[0].x + full[0].width - full[1].x) - 0.2f * full[0].width) < 1e-5f);
+
+    // 像素换算: 偶数对齐, 不越界
+    auto px = tiles[3].to_pixels(1920, 1080);
+    ASSERT_EQ(px.x, 1440);
+    ASSERT_EQ(px.y, 540);
+    ASSERT_EQ(px.width, 480);
+    ASSERT_EQ(px.height, 270 & ~1);
+    ASSERT_EQ((px.x | px.y | px.width | px.height) & 1, 0);
+
+    RoiConfig bad;
+    bad.x = 0.8f;
+    bad.width = 0.5f;
+    ASSERT_TRUE(!bad.valid());
+}
+
+// 12. cache_jpeg_backend 默认值与后端名称解析
+TEST(cache_jpeg_backend) {
+    ServerConfig config;
+    ASSERT_EQ(config.cache_jpeg_backend, std::string("turbojpeg"));
+
+    nlohmann::json j = {{"cache_jpeg_backend", "auto"}};
+    auto parsed = j.get<ServerConfig>();
+    ASSERT_EQ(parsed.cache_jpeg_backend, std::string("auto"));
+
+    for (auto backend : {JpegBackend::AUTO, JpegBackend::MPP, JpegBackend::TURBOJPEG}) {
+        JpegBackend out = JpegBackend::AUTO;
+        ASSERT_TRUE(parse_jpeg_backend(jpeg_backend_name(backend), out));
+        ASSERT_TRUE(out == backend);
+    }
+
+    // 未知名称: 返回 false, 不修改输出
+    JpegBackend out = JpegBackend::MPP;
+    ASSERT_FALSE(parse_jpeg_backend("vaapi", out));
+    ASSERT_TRUE(out == JpegBackend::MPP);
+}
+
 // ============================================================
 // 测试运行器
 // ============================================================
@@ -0,0 +1,313 @@
+/**
+ * @file test_decode_scheduler.cpp
+ * @brief 解码线程池 (DecodeScheduler) 与视频包到达预测 (ArrivalPredictor) 单元测试
+ *
+ * 不依赖 FFmpeg, 验证:
+ * - 单步按返回时刻重新调度, 返回 nullopt 后任务结束, wait() 返回
+ * - 定时器按到期时刻执行
+ * - wake() 打断长退避
+ * - 同一任务不会被两个线程同时执行
+ * - 多任务共享少量线程
+ * - 挂起的任务 (add(parked) / 单步返回 kParked) 只由 wake() 恢复, 池线程不被占用
+ * - 到达预测: 积压时立即再读, 追上后等到下一个包的期望到达时刻, 阻塞读取时重新对齐
+ */
+
+#include "infer_server/stream/decode_scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace infer_server;
+using Clock = std::chrono::steady_clock;
+using namespace std::chrono_literals;
+
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_CASE(name) \
+    do { std::cout << "\n[TEST] " << name << std::endl; } while(0)
+
+#define ASSERT_TRUE(expr) \
+    do { \
+        if (!(expr)) { \
+            std::cerr << "  FAIL: " << #expr << " at line " << __LINE__ << std::endl; \
+            g_tests_failed++; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) \
+    do { \
+        auto _a = (a); auto _b = (b); \
+        if (_a != _b) { \
+            std::cerr << "  FAIL: " << #a << " == " << #b \
+                      << " (" << _a << " != " << _b << ") at line " << __LINE__ << std::endl; \
+            g_tests_failed++; \
+            return; \
+        } \
+    } while(0)
+
+#define PASS() \
+    do { std::cout << "  PASS" << std::endl; g_tests_passed++; } while(0)
+
+/// 毫秒 -> 时刻 (ArrivalPredictor 测试用的固定时钟)
+static Clock::time_point at_ms(int64_t ms) {
+    return Clock::time_point(std::chrono::milliseconds(ms));
+}
+
+static int64_t to_ms(Clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count();
+}
+
+// ============================================================
+// 测试 1: 单步 / 结束 / wait
+// ============================================================
+void test_steps_and_finish() {
+    TEST_CASE("Task steps until it returns nullopt, wait() returns after it finishes");
+
+    DecodeScheduler pool(2);
+    ASSERT_EQ(pool.num_threads(), 2);
+
+    std::atomic<int> steps{0};
+    uint64_t id = pool.add("cam", [&]() -> std::optional<Clock::time_point> {
+        if (++steps >= 5) return std::nullopt;
+        return Clock::now();
+    });
+    ASSERT_TRUE(id > 0);
+    pool.wait(id);
+    ASSERT_EQ(steps.load(), 5);
+
+    auto stats = pool.stats();
+    ASSERT_EQ(stats.tasks, 0u);
+    ASSERT_EQ(stats.busy, 0);
+    ASSERT_TRUE(stats.steps >= 5u);
+
+    pool.wait(id);  // 已结束的任务立即返回
+    pool.wake(id);  // 未知任务忽略
+    PASS();
+}
+
+// ============================================================
+// 测试 2: 定时器按到期时刻执行
+// ============================================================
+void test_timer_order() {
+    TEST_CASE("Timers run in due order");
+
+    DecodeScheduler pool(1);
+    std::mutex mutex;
+    std::vector<std::string> order;
+
+    auto make = [&](const std::string& name, std::chrono::milliseconds delay) {
+        auto first = std::make_shared<bool>(true);
+        return [&, name, delay, first]() -> std::optional<Clock::time_point> {
+            if (*first) {
+                *first = false;
+                return Clock::now() + delay;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+            return std::nullopt;
+        };
+    };
+    auto slow = pool.add("slow", make("slow", 80ms));
+    auto fast = pool.add("fast", make("fast", 20ms));
+    pool.wait(slow);
+    pool.wait(fast);
+
+    ASSERT_EQ(order.size(), 2u);
+    ASSERT_EQ(order[0], std::string("fast"));
+    ASSERT_EQ(order[1], std::string("slow"));
+    PASS();
+}
+
+// ============================================================
+// 测试 3: wake() 打断退避
+// ============================================================
+void test_wake() {
+    TEST_CASE("wake() runs a task that is waiting on a long backoff");
+
+    DecodeScheduler pool(1);
+    std::atomic<bool> stop{false};
+    std::atomic<int> steps{0};
+    uint64_t id = pool.add("cam", [&]() -> std::optional<Clock::time_point> {
+        steps++;
+        if (stop.load()) return std::nullopt;
+        return Clock::now() + 10s;
+    });
+    while (steps.load() == 0) std::this_thread::sleep_for(1ms);
+
+    auto t0 = Clock::now();
+    stop = true;
+    pool.wake(id);
+    pool.wait(id);
+    auto elapsed = Clock::now() - t0;
+
+    ASSERT_EQ(steps.load(), 2);
+    ASSERT_TRUE(elapsed < 2s);
+    PASS();
+}
+
+// ============================================================
+// 测试 4: 同一任务不并发
+// ============================================================
+void test_no_concurrent_steps() {
+    TEST_CASE("A task never runs on two threads at once");
+
+    DecodeScheduler pool(4);
+    std::atomic<int> inside{0};
+    std::atomic<int> max_inside{0};
+    std::atomic<int> steps{0};
+    uint64_t id = pool.add("cam", [&]() -> std::optional<Clock::time_point> {
+        int n = ++inside;
+        int prev = max_inside.load();
+        while (n > prev && !max_inside.compare_exchange_weak(prev, n)) {}
+        std::this_thread::sleep_for(200us);
+        --inside;
+        if (++steps >= 50) return std::nullopt;
+        return Clock::now();
+    });
+    // 运行期间的 wake() 只让下一步立即执行, 不会并发
+    for (int i = 0; i < 20; i++) {
+        pool.wake(id);
+        std::this_thread::sleep_for(100us);
+    }
+    pool.wait(id);
+
+    ASSERT_EQ(steps.load(), 50);
+    ASSERT_EQ(max_inside.load(), 1);
+    PASS();
+}
+
+// ============================================================
+// 测试 5: 多任务共享线程
+// ============================================================
+void test_many_tasks() {
+    TEST_CASE("Many tasks share a small pool");
+
+    DecodeScheduler pool(2);
+    constexpr int kTasks = 20;
+    constexpr int kSteps = 10;
+    std::vector<std::atomic<int>> counts(kTasks);
+    std::vector<uint64_t> ids;
+    for (int i = 0; i < kTasks; i++) {
+        ids.push_back(pool.add("cam" + std::to_string(i), [&counts, i]() -> std::optional<Clock::time_point> {
+            if (++counts[static_cast<size_t>(i)] >= kSteps) return std::nullopt;
+            return Clock::now() + 1ms;
+        }));
+    }
+    ASSERT_TRUE(pool.stats().tasks <= static_cast<size_t>(kTasks));
+    for (auto id : ids) pool.wait(id);
+
+    for (int i = 0; i < kTasks; i++) {
+        ASSERT_EQ(counts[static_cast<size_t>(i)].load(), kSteps);
+    }
+    auto stats = pool.stats();
+    ASSERT_EQ(stats.tasks, 0u);
+    ASSERT_TRUE(stats.steps >= static_cast<uint64_t>(kTasks * kSteps));
+    ASSERT_TRUE(stats.lag_ms >= 0.0);
+
+    pool.stop();
+    ASSERT_EQ(pool.stats().threads, 0);
+    PASS();
+}
+
+// ============================================================
+// 测试 6: 挂起任务由 wake() 恢复
+// ============================================================
+void test_parked() {
+    TEST_CASE("Parked tasks only run after wake()");
+
+    DecodeScheduler pool(1);
+    std::atomic<int> steps{0};
+    std::atomic<bool> stop{false};
+    // 模拟池外线程打开流: 单步把请求交出去后挂起, 打开完成后唤醒
+    uint64_t id = pool.add("cam", [&]() -> std::optional<Clock::time_point> {
+        steps++;
+        if (stop.load()) return std::nullopt;
+        return DecodeScheduler::kParked;
+    }, true);
+
+    std::this_thread::sleep_for(30ms);
+    ASSERT_EQ(steps.load(), 0);         // 注册时挂起
+    ASSERT_EQ(pool.stats().tasks, 1u);
+
+    pool.wake(id);
+    while (steps.load() == 0) std::this_thread::sleep_for(1ms);
+    std::this_thread::sleep_for(30ms);
+    ASSERT_EQ(steps.load(), 1);         // 单步返回 kParked 后不再调度
+
+    // 挂起期间其他任务照常运行
+    std::atomic<int> other{0};
+    auto other_id = pool.add("other", [&]() -> std::optional<Clock::time_point> {
+        if (++other >= 3) return std::nullopt;
+        return Clock::now();
+    });
+    pool.wait(other_id);
+    ASSERT_EQ(other.load(), 3);
+
+    stop = true;
+    pool.wake(id);
+    pool.wait(id);
+    ASSERT_EQ(steps.load(), 2);
+    ASSERT_EQ(pool.stats().tasks, 0u);
+    PASS();
+}
+
+// ============================================================
+// 测试 7: 包到达预测
+// ============================================================
+void test_arrival_predictor() {
+    TEST_CASE("ArrivalPredictor schedules reads at the expected packet arrival");
+
+    ArrivalPredictor predictor(2ms);
+    const double fps = 25.0;  // 40ms 帧间隔
+
+    // 首包阻塞读到: 偏移 = 1000ms, 下一个包在 1040ms 到达, +2ms guard
+    ASSERT_EQ(to_ms(predictor.next_read(at_ms(1000), 0, true, fps)), 1042);
+
+    // 积压: pts=40 的包本应 1040ms 到达, 1100ms 才读到 -> 立即再读
+    ASSERT_EQ(to_ms(predictor.next_read(at_ms(1100), 40, false, fps)), 1100);
+
+    // 追上: pts=80 在期望时刻附近读到 -> 等下一个包
+    ASSERT_EQ(to_ms(predictor.next_read(at_ms(1081), 80, false, fps)), 1122);
+
+    // 观测到更早的到达 (偏移变小): 以更早的偏移为准
+    ASSERT_EQ(to_ms(predictor.next_read(at_ms(1115), 120, false, fps)), 1157);
+
+    // 网络停顿后阻塞读到: 重新对齐
+    ASSERT_EQ(to_ms(predictor.next_read(at_ms(1300), 160, true, fps)), 1342);
+
+    // 帧率未知: 立即再读
+    ASSERT_EQ(to_ms(predictor.next_read(at_ms(1400), 200, false, 0.0)), 1400);
+
+    // 重新打开后时间戳不连续: reset() 后以新包为准
+    predictor.reset();
+    ASSERT_EQ(to_ms(predictor.next_read(at_ms(5000), 0, false, fps)), 5042);
+    PASS();
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << "  Decode Scheduler Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    test_steps_and_finish();
+    test_timer_order();
+    test_wake();
+    test_no_concurrent_steps();
+    test_many_tasks();
+    test_parked();
+    test_arrival_predictor();
+
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "  Results: " << g_tests_passed << " passed, "
+              << g_tests_failed << " failed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return g_tests_failed > 0 ? 1 : 0;
+}
@@ -5,8 +5,11 @@
  * 不依赖任何硬件, 验证:
  * - 单模型场景: 1 个模型完成即返回
  * - 多模型场景: 所有模型完成后返回
- * - 并发安全: 多线程同时 add_result
- * - 结果完整性: 所有 ModelResult 都被收集
+ * - 并发安全: 多线程同时 add_result, 恰好一个线程取走结果
+ * - 结果完整性: 所有 ModelResult 都被收集, 按槽位 (配置) 顺序输出
+ * - 分块合并: 同一模型的分块结果跨块 NMS 后计为一个模型 (含并发分块)
+ * - 级联回调: 第一级结果触发第二级任务, 无目标时直接计入空结果
+ * - 推理帧判定: 运动门控转发与全部由跟踪器外推的帧不算推理帧
  */
 
 #include "infer_server/inference/frame_result_collector.h"
@@ -16,6 +19,9 @@
 #include <atomic>
 #include <chrono>
 #include <cassert>
+#include <memory>
+#include <optional>
+#include <string>
 
 using namespace infer_server;
 
@@ -73,7 +79,7 @@ void test_single_model() {
     mr.inference_time_ms = 12.5;
     mr.detections.push_back(Detection{0, "phone", 0.95f, {100, 200, 300, 400}});
 
-    auto result = collector.add_result(mr);
+    auto result = collector.add_result(0, mr);
     ASSERT_TRUE(result.has_value());
     ASSERT_TRUE(collector.is_complete());
     ASSERT_EQ(collector.completed_count(), 1);
@@ -103,26 +109,28 @@ void test_multi_model_sequential() {
     // 第 1 个模型
     ModelResult mr1;
     mr1.task_name = "phone";
-    auto r1 = collector.add_result(mr1);
+    auto r1 = collector.add_result(0, mr1);
     ASSERT_TRUE(!r1.has_value());
     ASSERT_EQ(collector.completed_count(), 1);
 
     // 第 2 个模型
     ModelResult mr2;
     mr2.task_name = "smoking";
-    auto r2 = collector.add_result(mr2);
+    auto r2 = collector.add_result(1, mr2);
     ASSERT_TRUE(!r2.has_value());
     ASSERT_EQ(collector.completed_count(), 2);
 
     // 第 3 个模型 -> 完成
     ModelResult mr3;
     mr3.task_name = "helmet";
-    auto r3 = collector.add_result(mr3);
+    auto r3 = collector.add_result(2, mr3);
     ASSERT_TRUE(r3.has_value());
     ASSERT_TRUE(collector.is_complete());
 
     // 验证所有结果都在
     ASSERT_EQ(r3->results.size(), 3u);
+    ASSERT_TRUE(r3->results[0].task_name == "phone");
+    ASSERT_TRUE(r3->results[2].task_name == "helmet");
 
     PASS();
 }
@@ -153,11 +161,14 @@ void test_concurrent_add_result() {
             // 稍微错开时间
             std::this_thread::sleep_for(std::chrono::microseconds(i * 100));
 
-            auto result = collector->add_result(mr);
+            auto result = collector->add_result(i, mr);
             if (result.has_value()) {
                 complete_count++;
-                // 只有一个线程应该得到完整结果
+                // 只有一个线程应该得到完整结果, 顺序与槽位一致 (与完成先后无关)
                 ASSERT_EQ(result->results.size(), static_cast<size_t>(NUM_MODELS));
+                for (int m = 0; m < NUM_MODELS; m++) {
+                    ASSERT_TRUE(result->results[m].task_name == "model_" + std::to_string(m));
+                }
             }
         });
     }
@@ -204,8 +215,9 @@ void test_result_integrity() {
     mr2.inference_time_ms = 6.7;
     mr2.detections.push_back(Detection{0, "cigarette", 0.91f, {150, 80, 250, 180}});
 
-    collector.add_result(mr1);
-    auto result = collector.add_result(mr2);
+    // 第二个模型先完成, 输出仍按槽位顺序
+    ASSERT_TRUE(!collector.add_result(1, mr2).has_value());
+    auto result = collector.add_result(0, mr1);
 
     ASSERT_TRUE(result.has_value());
 
@@ -220,6 +232,8 @@ void test_result_integrity() {
 
     // 验证模型结果
     ASSERT_EQ(result->results.size(), 2u);
+    ASSERT_TRUE(result->results[0].task_name == "detect_phone");
+    ASSERT_TRUE(result->results[1].task_name == "detect_smoking");
 
     // 检查总检测数
     size_t total_dets = 0;
@@ -232,10 +246,10 @@ void test_result_integrity() {
 }
 
 // ============================================================
-// 测试 5: shared_ptr 用法 (模拟 InferTask::aggregator)
+// 测试 5: InferTask::aggregator 用法
 // ============================================================
 void test_shared_ptr_usage() {
-    TEST_CASE("shared_ptr usage - simulating InferTask aggregator");
+    TEST_CASE("InferTask aggregator - typed shared_ptr with result slots");
 
     FrameResult base;
     base.cam_id = "cam05";
@@ -244,22 +258,232 @@ void test_shared_ptr_usage() {
     auto collector = std::make_shared<FrameResultCollector>(2, base);
 
     // 模拟 InferTask 中的 aggregator 存储
-    std::shared_ptr<void> aggregator1 = collector;
-    std::shared_ptr<void> aggregator2 = collector;
+    InferTask task1;
+    task1.aggregator = collector;
+    task1.result_slot = 0;
+    InferTask task2;
+    task2.aggregator = collector;
+    task2.result_slot = 1;
 
     // 模拟 InferWorker 中的使用
-    auto* c1 = static_cast<FrameResultCollector*>(aggregator1.get());
+    ModelResult mr2;
+    mr2.task_name = "task_b";
+    auto r2 = task2.aggregator->add_result(task2.result_slot, std::move(mr2));
+    ASSERT_TRUE(!r2.has_value());
+
     ModelResult mr1;
     mr1.task_name = "task_a";
-    auto r1 = c1->add_result(mr1);
-    ASSERT_TRUE(!r1.has_value());
+    mr1.detections.push_back(Detection{0, "a", 0.5f, {0, 0, 10, 10}});
+    auto r1 = task1.aggregator->add_result(task1.result_slot, std::move(mr1));
+    ASSERT_TRUE(r1.has_value());
+    ASSERT_EQ(r1->results.size(), 2u);
+    ASSERT_TRUE(r1->results[0].task_name == "task_a");
+    ASSERT_EQ(r1->results[0].detections.size(), 1u);
 
-    auto* c2 = static_cast<FrameResultCollector*>(aggregator2.get());
-    ModelResult mr2;
-    mr2.task_name = "task_b";
-    auto r2 = c2->add_result(mr2);
-    ASSERT_TRUE(r2.has_value());
-    ASSERT_EQ(r2->results.size(), 2u);
+    PASS();
+}
+
+// ============================================================
+// 测试 6: 分块结果合并 (跨块 NMS)
+// ============================================================
+void test_tile_merge() {
+    TEST_CASE("add_tile - cross-tile NMS merges duplicates at tile seams");
+
+    FrameResult base;
+    base.cam_id = "cam06";
+    base.frame_id = 600;
+
+    // 一个分块模型 (2 块) + 一个整帧模型
+    FrameResultCollector collector(2, base);
+
+    // 跨越分块边界的同一目标在两块中都被检出 (坐标已映射回原图)
+    ModelResult left;
+    left.task_name = "person";
+    left.model_path = "/weights/person.rknn";
+    left.inference_time_ms = 5.0;
+    left.compute_ms = 3.0;
+    left.detections.push_back(Detection{0, "person", 0.90f, {900, 100, 1010, 300}});
+    left.detections.push_back(Detection{0, "person", 0.80f, {100, 100, 200, 300}});
+
+    ModelResult right;
+    right.task_name = "person";
+    right.inference_time_ms = 6.0;
+    right.compute_ms = 4.0;
+    right.detections.push_back(Detection{0, "person", 0.85f, {905, 102, 1012, 298}});
+
+    // 右块先到达: 合并时仍按分块顺序取 task_name / model_path
+    collector.expect_tiles(0, 2);
+    ASSERT_TRUE(!collector.add_tile(0, 1, right, 0.45f).has_value());
+    ASSERT_EQ(collector.completed_count(), 0);
+    ASSERT_TRUE(!collector.add_tile(0, 0, left, 0.45f).has_value());
+    ASSERT_EQ(collector.completed_count(), 1);
+
+    ModelResult whole;
+    whole.task_name = "helmet";
+    auto result = collector.add_result(1, whole);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result->results.size(), 2u);
+
+    const auto& merged = result->results[0];
+    ASSERT_TRUE(merged.task_name == "person");
+    ASSERT_TRUE(merged.model_path == "/weights/person.rknn");
+    ASSERT_TRUE(merged.inference_time_ms > 10.9 && merged.inference_time_ms < 11.1);
+    ASSERT_TRUE(merged.compute_ms > 6.9 && merged.compute_ms < 7.1);
+    ASSERT_EQ(merged.detections.size(), 2u);
+    ASSERT_TRUE(merged.detections[0].confidence > 0.89f);   // 重复框中保留置信度最高的
+
+    PASS();
+}
+
+// ============================================================
+// 测试 7: 级联回调 (第一级结果触发第二级)
+// ============================================================
+void test_stage_hook() {
+    TEST_CASE("set_stage_hook - cascade stage 2 joins the same frame");
+
+    FrameResult base;
+    base.cam_id = "cam07";
+    base.frame_id = 700;
+
+    // person (第一级) -> helmet (第二级, 在人体裁剪上推理)
+    auto collector = std::make_shared<FrameResultCollector>(2, base);
+    int hook_calls = 0;
+    int crops_submitted = 0;
+    collector->set_stage_hook([&](const ModelResult& mr) {
+        hook_calls++;
+        if (mr.task_name != "person") return std::vector<FrameResultCollector::SlotResult>{};
+        crops_submitted = static_cast<int>(mr.detections.size());
+        collector->expect_tiles(1, crops_submitted);
+        return std::vector<FrameResultCollector::SlotResult>{};
+    });
+
+    ModelResult person;
+    person.task_name = "person";
+    person.detections.push_back(Detection{0, "person", 0.9f, {10, 10, 110, 310}});
+    person.detections.push_back(Detection{0, "person", 0.8f, {500, 10, 600, 310}});
+    ASSERT_TRUE(!collector->add_result(0, person).has_value());
+    ASSERT_EQ(crops_submitted, 2);
+
+    // 两个裁剪的第二级结果按分块合并
+    ModelResult helmet_a;
+    helmet_a.task_name = "helmet";
+    helmet_a.detections.push_back(Detection{0, "helmet", 0.7f, {30, 10, 80, 50}});
+    ModelResult helmet_b;
+    helmet_b.task_name = "helmet";
+    ASSERT_TRUE(!collector->add_tile(1, 0, helmet_a, 0.45f).has_value());
+    auto result = collector->add_tile(1, 1, helmet_b, 0.45f);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result->results.size(), 2u);
+    ASSERT_TRUE(result->results[1].task_name == "helmet");
+    ASSERT_EQ(result->results[1].detections.size(), 1u);
+    ASSERT_EQ(hook_calls, 2);
+
+    // 第一级没有目标: 回调直接返回第二级的空结果, 同一次 add_result 即完成
+    auto idle = std::make_shared<FrameResultCollector>(2, base);
+    idle->set_stage_hook([](const ModelResult& mr) {
+        std::vector<FrameResultCollector::SlotResult> skipped;
+        if (mr.task_name == "person" && mr.detections.empty()) {
+            FrameResultCollector::SlotResult empty;
+            empty.slot = 1;
+            empty.result.task_name = "helmet";
+            skipped.push_back(empty);
+        }
+        return skipped;
+    });
+    ModelResult nobody;
+    nobody.task_name = "person";
+    auto done = idle->add_result(0, nobody);
+    ASSERT_TRUE(done.has_value());
+    ASSERT_EQ(done->results.size(), 2u);
+    ASSERT_TRUE(done->results[0].task_name == "person");
+    ASSERT_TRUE(done->results[1].detections.empty());
+
+    PASS();
+}
+
+// ============================================================
+// 测试 8: 并发分块
+// ============================================================
+void test_concurrent_tiles() {
+    TEST_CASE("Concurrent add_tile - tiles and whole-frame models race to complete");
+
+    const int NUM_TILES = 6;
+
+    FrameResult base;
+    base.cam_id = "cam08";
+    base.frame_id = 800;
+
+    for (int round = 0; round < 50; round++) {
+        // 槽位 0: 整帧模型; 槽位 1: 分块模型
+        auto collector = std::make_shared<FrameResultCollector>(2, base);
+        collector->expect_tiles(1, NUM_TILES);
+
+        std::atomic<int> complete_count{0};
+        std::atomic<size_t> merged_dets{0};
+        std::atomic<bool> order_ok{true};
+        auto on_complete = [&](std::optional<FrameResult> result) {
+            if (!result) return;
+            complete_count++;
+            merged_dets = result->results[1].detections.size();
+            order_ok = result->results[0].task_name == "whole" && result->results[1].task_name == "tiled";
+        };
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < NUM_TILES; t++) {
+            threads.emplace_back([&, t]() {
+                ModelResult tile;
+                tile.task_name = "tiled";
+                // 各分块的检测框互不重叠, NMS 后全部保留
+                float x = 200.0f * t;
+                tile.detections.push_back(Detection{0, "person", 0.9f, {x, 0, x + 100, 100}});
+                on_complete(collector->add_tile(1, t, std::move(tile), 0.45f));
+            });
+        }
+        threads.emplace_back([&]() {
+            ModelResult whole;
+            whole.task_name = "whole";
+            on_complete(collector->add_result(0, std::move(whole)));
+        });
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        ASSERT_EQ(complete_count.load(), 1);
+        ASSERT_EQ(merged_dets.load(), static_cast<size_t>(NUM_TILES));
+        ASSERT_TRUE(order_ok.load());
+    }
+
+    PASS();
+}
+
+// ============================================================
+// 测试 9: 推理帧判定 (转发 / 全部外推的帧不计入推理统计与延迟直方图)
+// ============================================================
+void test_inferred_frames() {
+    TEST_CASE("FrameResult::inferred - repeated and fully predicted frames are excluded");
+
+    FrameResult base;
+    base.cam_id = "cam09";
+    auto collector = std::make_shared<FrameResultCollector>(2, base);
+
+    ModelResult predicted;
+    predicted.task_name = "tracked";
+    predicted.predicted = true;
+    ModelResult inferred;
+    inferred.task_name = "detector";
+
+    ASSERT_TRUE(!collector->add_result(0, predicted).has_value());
+    auto mixed = collector->add_result(1, inferred);
+    ASSERT_TRUE(mixed.has_value());
+    ASSERT_TRUE(mixed->inferred());
+
+    FrameResult all_predicted = *mixed;
+    all_predicted.results[1].predicted = true;
+    ASSERT_TRUE(!all_predicted.inferred());
+
+    FrameResult repeated = *mixed;
+    repeated.repeated = true;
+    ASSERT_TRUE(!repeated.inferred());
 
     PASS();
 }
@@ -277,6 +501,10 @@ int main() {
     test_concurrent_add_result();
     test_result_integrity();
     test_shared_ptr_usage();
+    test_tile_merge();
+    test_stage_hook();
+    test_concurrent_tiles();
+    test_inferred_frames();
 
     std::cout << "\n======================================" << std::endl;
     std::cout << "  Results: " << g_tests_passed << " passed, "
@@ -14,14 +14,24 @@
  *   7. 流的添加和删除
  *   8. 多流并发写入
  *   9. 内存统计准确性
+ *  10. 延迟编码 (raw NV12 帧首次读取时编码为 JPEG)
+ *  11. 乱序写入仍保持有序 (二分查找正确)
+ *  12. 全局内存淘汰按跨流最旧帧进行
+ *  13. 读写并发 (读取者不被写入阻塞, 快照一致)
+ *  14. 等待新帧 (wait_latest_frame: 立即返回 / 超时 / 被写入唤醒)
+ *  15. NV12 检测框绘制 (坐标换算 / 边框像素 / 越界裁剪)
+ *  16. 检测框回填与带框延迟编码 (attach_overlay)
+ *  17. 请求 MPP 后端但未编译 MPP 时回退 TurboJPEG, 仍输出完整 JPEG
  */
 
 #include "infer_server/cache/image_cache.h"
+#include "infer_server/cache/overlay.h"
 
 #include <iostream>
 #include <string>
 #include <vector>
 #include <thread>
+#include <atomic>
 #include <functional>
 #include <chrono>
 #include <cassert>
@@ -299,6 +309,365 @@ TEST(memory_accounting) {
     ASSERT_EQ(cache.total_memory_bytes(), 0u);
 }
 
+// 10. 延迟编码
+TEST(lazy_encode_raw_frame) {
+    ImageCache cache(60, 0, 80);
+
+    int w = 64, h = 32;
+    size_t raw_size = static_cast<size_t>(w) * h * 3 / 2;
+    for (int i = 0; i < 3; i++) {
+        CachedFrame f;
+        f.cam_id = "cam01";
+        f.frame_id = i + 1;
+        f.timestamp_ms = i * 1000;
+        f.width = w;
+        f.height = h;
+        f.raw_nv12 = std::make_shared<std::vector<uint8_t>>(raw_size, 0x80);
+        cache.add_frame(std::move(f));
+    }
+
+    // 写入时不编码, 按原图大小计入内存
+    ASSERT_EQ(cache.total_memory_bytes(), raw_size * 3);
+    ASSERT_EQ(cache.lazy_encode_count(), 0u);
+
+    // 首次读取: 编码并回写
+    auto first = cache.get_frame("cam01", 1000);
+    ASSERT_TRUE(first.has_value());
+    ASSERT_TRUE(first->jpeg_data && !first->jpeg_data->empty());
+    ASSERT_TRUE(!first->raw_nv12);
+    ASSERT_EQ(cache.lazy_encode_count(), 1u);
+    ASSERT_EQ(cache.total_memory_bytes(), raw_size * 2 + first->jpeg_size());
+    std::cout << "    Raw: " << raw_size << " bytes, JPEG: " << first->jpeg_size() << " bytes" << std::endl;
+
+    // 再次读取: 复用已编码结果
+    auto second = cache.get_nearest_frame("cam01", 1100);
+    ASSERT_TRUE(second.has_value());
+    ASSERT_TRUE(second->jpeg_data == first->jpeg_data);
+    ASSERT_EQ(cache.lazy_encode_count(), 1u);
+
+    auto latest = cache.get_latest_frame("cam01");
+    ASSERT_TRUE(latest.has_value() && latest->jpeg_data);
+    ASSERT_EQ(latest->frame_id, 3u);
+    ASSERT_EQ(cache.lazy_encode_count(), 2u);
+
+    cache.remove_stream("cam01");
+    ASSERT_EQ(cache.total_memory_bytes(), 0u);
+}
+
+// 11. 乱序写入
+TEST(out_of_order_insert) {
+    ImageCache cache(60, 0);
+
+    int64_t ts_list[] = {3000, 1000, 2000, 5000, 4000, 2000};
+    for (size_t i = 0; i < 6; i++) {
+        cache.add_frame(make_frame("cam01", i + 1, ts_list[i]));
+    }
+    ASSERT_EQ(cache.stream_frame_count("cam01"), 6u);
+
+    auto r = cache.get_frame("cam01", 4000);
+    ASSERT_TRUE(r.has_value());
+    ASSERT_EQ(r->frame_id, 5u);
+
+    // 相同时间戳: 返回先写入的帧
+    r = cache.get_frame("cam01", 2000);
+    ASSERT_TRUE(r.has_value());
+    ASSERT_EQ(r->frame_id, 3u);
+
+    r = cache.get_nearest_frame("cam01", 1400);
+    ASSERT_TRUE(r.has_value());
+    ASSERT_EQ(r->frame_id, 2u);
+
+    r = cache.get_nearest_frame("cam01", 99999);
+    ASSERT_TRUE(r.has_value());
+    ASSERT_EQ(r->timestamp_ms, 5000);
+
+    r = cache.get_latest_frame("cam01");
+    ASSERT_TRUE(r.has_value());
+    ASSERT_EQ(r->timestamp_ms, 5000);
+}
+
+// 12. 全局内存淘汰按跨流最旧帧进行
+TEST(global_eviction_oldest_across_streams) {
+    ImageCache cache(600, 1);  // 1MB 限制
+
+    // cam_a 的帧整体比 cam_b 旧
+    for (int i = 0; i < 4; i++) {
+        cache.add_frame(make_frame("cam_a", i + 1, 1000 + i * 100, 200 * 1024));
+    }
+    for (int i = 0; i < 4; i++) {
+        cache.add_frame(make_frame("cam_b", i + 1, 5000 + i * 100, 200 * 1024));
+    }
+
+    ASSERT_TRUE(cache.total_memory_bytes() <= 1024u * 1024);
+    // 8 x 200KB 需淘汰 3 帧, 全部来自 cam_a
+    ASSERT_EQ(cache.stream_frame_count("cam_a"), 1u);
+    ASSERT_EQ(cache.stream_frame_count("cam_b"), 4u);
+    ASSERT_FALSE(cache.get_frame("cam_a", 1200).has_value());
+    ASSERT_TRUE(cache.get_frame("cam_a", 1300).has_value());
+
+    // 删除后重建同名流, 残留索引不影响淘汰
+    cache.remove_stream("cam_a");
+    for (int i = 0; i < 3; i++) {
+        cache.add_frame(make_frame("cam_a", i + 1, 9000 + i * 100, 200 * 1024));
+    }
+    ASSERT_TRUE(cache.total_memory_bytes() <= 1024u * 1024);
+    ASSERT_EQ(cache.stream_frame_count("cam_a"), 3u);
+    ASSERT_EQ(cache.stream_frame_count("cam_b"), 2u);
+}
+
+// 13. 读写并发
+TEST(concurrent_read_write) {
+    ImageCache cache(2, 0);
+    std::atomic<bool> done{false};
+    std::atomic<int> bad{0};
+    std::atomic<uint64_t> reads{0};
+
+    std::thread writer([&] {
+        for (int i = 0; i < 2000; i++) {
+            cache.add_frame(make_frame("cam01", i + 1, static_cast<int64_t>(i) * 40, 256));
+        }
+        done = true;
+    });
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; r++) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                auto latest = cache.get_latest_frame("cam01");
+                if (latest) {
+                    // 帧 ID 与时间戳一一对应
+                    if (latest->timestamp_ms != static_cast<int64_t>(latest->frame_id - 1) * 40) bad++;
+                    // 写入者持续推进, 两次查询之间窗口可能已滑过; 只校验快照内容一致
+                    auto near = cache.get_nearest_frame("cam01", latest->timestamp_ms - 500);
+                    if (!near || near->timestamp_ms != static_cast<int64_t>(near->frame_id - 1) * 40) bad++;
+                }
+                reads++;
+            }
+        });
+    }
+
+    writer.join();
+    for (auto& t : readers) t.join();
+
+    std::cout << "    Reads during writes: " << reads.load() << std::endl;
+    ASSERT_EQ(bad.load(), 0);
+    // 2 秒窗口 @ 40ms = 51 帧
+    ASSERT_EQ(cache.stream_frame_count("cam01"), 51u);
+    ASSERT_EQ(cache.total_memory_bytes(), 51u * 256);
+}
+
+// 14. 等待新帧
+TEST(wait_latest_frame) {
+    ImageCache cache(5, 0);
+    using std::chrono::milliseconds;
+
+    // 流不存在
+    ASSERT_FALSE(cache.wait_latest_frame("cam01", -1, milliseconds(10)).has_value());
+
+    cache.add_frame(make_frame("cam01", 1, 1000));
+    cache.add_frame(make_frame("cam01", 2, 1040));
+
+    // 已有更新的帧: 立即返回最新帧
+    auto latest = cache.wait_latest_frame("cam01", 1000, milliseconds(0));
+    ASSERT_TRUE(latest.has_value());
+    ASSERT_EQ(latest->frame_id, 2u);
+
+    // 没有更新的帧: 超时
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_FALSE(cache.wait_latest_frame("cam01", 1040, milliseconds(50)).has_value());
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start >= milliseconds(45));
+
+    // 写入唤醒等待者 (远早于超时)
+    std::thread writer([&] {
+        std::this_thread::sleep_for(milliseconds(30));
+        cache.add_frame(make_frame("cam01", 3, 1080));
+    });
+    start = std::chrono::steady_clock::now();
+    auto woken = cache.wait_latest_frame("cam01", 1040, milliseconds(5000));
+    auto waited = std::chrono::steady_clock::now() - start;
+    writer.join();
+    ASSERT_TRUE(woken.has_value());
+    ASSERT_EQ(woken->frame_id, 3u);
+    ASSERT_TRUE(waited < milliseconds(2000));
+
+    // 持续写入时每次等待都拿到严格更新的帧
+    std::atomic<bool> done{false};
+    std::thread producer([&] {
+        for (int i = 0; i < 200; i++) {
+            cache.add_frame(make_frame("cam01", 100 + i, 2000 + i * 40, 64));
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        done = true;
+    });
+    int64_t last = 1080;
+    int got = 0;
+    bool ordered = true;
+    while (!done.load()) {
+        auto f = cache.wait_latest_frame("cam01", last, milliseconds(100));
+        if (!f) continue;
+        if (f->timestamp_ms <= last) ordered = false;
+        last = f->timestamp_ms;
+        got++;
+    }
+    producer.join();
+    std::cout << "    Frames delivered to waiter: " << got << " / 200" << std::endl;
+    ASSERT_TRUE(ordered);
+    ASSERT_TRUE(got > 0);
+}
+
+// 15. NV12 检测框绘制
+TEST(overlay_draw_nv12) {
+    namespace overlay = infer_server::overlay;
+    const int w = 64, h = 32;
+
+    // 原图 1280x640 -> 缓存 64x32 (缩放 1/20), 越界框被裁剪, 空框被丢弃
+    infer_server::FrameResult r;
+    r.original_width = 1280;
+    r.original_height = 640;
+    infer_server::ModelResult mr;
+    infer_server::Detection d;
+    d.class_id = 1;
+    d.bbox = {200.0f, 100.0f, 600.0f, 500.0f};
+    mr.detections.push_back(d);
+    d.bbox = {1000.0f, -100.0f, 2000.0f, 300.0f};
+    mr.detections.push_back(d);
+    d.bbox = {100.0f, 100.0f, 105.0f, 300.0f};
+    mr.detections.push_back(d);
+    r.results.push_back(mr);
+
+    auto boxes = overlay::scale_boxes(r, w, h);
+    ASSERT_EQ(boxes.size(), 2u);
+    ASSERT_EQ(boxes[0].x1, 10);
+    ASSERT_EQ(boxes[0].y1, 5);
+    ASSERT_EQ(boxes[0].x2, 30);
+    ASSERT_EQ(boxes[0].y2, 25);
+    ASSERT_EQ(boxes[1].x2, w - 1);
+    ASSERT_EQ(boxes[1].y1, 0);
+
+    std::vector<uint8_t> nv12(static_cast<size_t>(w) * h * 3 / 2, 0x80);
+    overlay::draw_boxes_nv12(nv12.data(), w, h, {boxes[0]}, 2);
+    auto Y = [&](int x, int y) { return nv12[static_cast<size_t>(y) * w + x]; };
+    auto U = [&](int x, int y) { return nv12[static_cast<size_t>(w) * h + static_cast<size_t>(y / 2) * w + (x / 2) * 2]; };
+
+    // 边框 (2 像素) 被改写, 框内与框外不变
+    uint8_t edge = Y(10, 5);
+    ASSERT_TRUE(edge != 0x80);
+    ASSERT_EQ(Y(20, 6), edge);
+    ASSERT_EQ(Y(11, 15), edge);
+    ASSERT_EQ(Y(30, 25), edge);
+    ASSERT_EQ(Y(29, 20), edge);
+    ASSERT_EQ(Y(20, 15), 0x80);
+    ASSERT_EQ(Y(12, 15), 0x80);
+    ASSERT_EQ(Y(9, 5), 0x80);
+    ASSERT_EQ(Y(31, 25), 0x80);
+    ASSERT_TRUE(U(10, 5) != 0x80);
+    ASSERT_EQ(U(20, 15), 0x80);
+
+    // 越界坐标不写出缓冲区 (缓冲区外的哨兵不变)
+    std::vector<uint8_t> guarded(nv12.size() + 16, 0x55);
+    infer_server::OverlayBox wild{-50, -50, 500, 500, 7};
+    overlay::draw_boxes_nv12(guarded.data(), w, h, {wild});
+    for (size_t i = nv12.size(); i < guarded.size(); i++) ASSERT_EQ(guarded[i], 0x55);
+}
+
+// 16. 检测框回填与带框延迟编码
+TEST(overlay_attach_and_encode) {
+    ImageCache cache(60, 0, 80);
+    const int w = 64, h = 32;
+    size_t raw_size = static_cast<size_t>(w) * h * 3 / 2;
+    for (int i = 0; i < 3; i++) {
+        CachedFrame f;
+        f.cam_id = "cam01";
+        f.frame_id = i + 1;
+        f.timestamp_ms = i * 1000;
+        f.width = w;
+        f.height = h;
+        f.raw_nv12 = std::make_shared<std::vector<uint8_t>>(raw_size, 0x80);
+        cache.add_frame(std::move(f));
+    }
+
+    auto make_result = [](uint64_t frame_id, int64_t ts) {
+        infer_server::FrameResult r;
+        r.cam_id = "cam01";
+        r.frame_id = frame_id;
+        r.timestamp_ms = ts;
+        r.original_width = 640;
+        r.original_height = 320;
+        infer_server::ModelResult mr;
+        infer_server::Detection d;
+        d.class_id = 0;
+        d.bbox = {100.0f, 50.0f, 400.0f, 250.0f};
+        mr.detections.push_back(d);
+        r.results.push_back(mr);
+        return r;
+    };
+
+    // 不匹配的帧 / 流
+    ASSERT_FALSE(cache.attach_overlay(make_result(9, 1000)));
+    auto other = make_result(2, 1000);
+    other.cam_id = "cam02";
+    ASSERT_FALSE(cache.attach_overlay(other));
+
+    // 没有检测框的结果不回填
+    auto empty = make_result(2, 1000);
+    empty.results[0].detections.clear();
+    ASSERT_FALSE(cache.attach_overlay(empty));
+
+    // 两个模型的结果分别到达: 检测框累加, 内存统计不变
+    ASSERT_TRUE(cache.attach_overlay(make_result(2, 1000)));
+    ASSERT_TRUE(cache.attach_overlay(make_result(2, 1000)));
+    ASSERT_EQ(cache.total_memory_bytes(), raw_size * 3);
+
+    auto annotated = cache.get_frame("cam01", 1000);
+    ASSERT_TRUE(annotated.has_value() && annotated->jpeg_data);
+    ASSERT_TRUE(annotated->overlay != nullptr);
+    ASSERT_EQ(annotated->overlay->size(), 2u);
+    ASSERT_EQ(cache.annotated_count(), 1u);
+
+    // 无框帧照常编码 (画框像素见 overlay_draw_nv12)
+    auto plain = cache.get_frame("cam01", 0);
+    ASSERT_TRUE(plain.has_value() && plain->jpeg_data);
+    ASSERT_TRUE(plain->overlay == nullptr);
+    ASSERT_EQ(cache.annotated_count(), 1u);
+
+    // 已编码的帧不能再回填; 再次读取复用带框 JPEG
+    ASSERT_FALSE(cache.attach_overlay(make_result(1, 0)));
+    ASSERT_FALSE(cache.attach_overlay(make_result(2, 1000)));
+    auto again = cache.get_nearest_frame("cam01", 1100);
+    ASSERT_TRUE(again.has_value());
+    ASSERT_TRUE(again->jpeg_data == annotated->jpeg_data);
+    ASSERT_TRUE(again->overlay != nullptr);
+    ASSERT_EQ(cache.lazy_encode_count(), 2u);
+}
+
+#ifdef HAS_TURBOJPEG
+// 17. JpegEncoder(MPP) 在没有 HAS_MPP 的构建中回退到 TurboJPEG
+TEST(mpp_backend_fallback) {
+    using infer_server::JpegBackend;
+    using infer_server::JpegEncoder;
+
+    const int w = 64, h = 48;
+    std::vector<uint8_t> nv12(w * h * 3 / 2, 0x80);
+
+    for (auto backend : {JpegBackend::MPP, JpegBackend::AUTO, JpegBackend::TURBOJPEG}) {
+        JpegEncoder encoder(backend);
+        ASSERT_TRUE(encoder.is_valid());
+#ifndef HAS_MPP
+        ASSERT_TRUE(encoder.backend() == JpegBackend::TURBOJPEG);
+        ASSERT_EQ(encoder.hw_encodes(), 0u);
+#endif
+        auto jpeg = encoder.encode_nv12(nv12.data(), w, h, 80);
+        ASSERT_TRUE(jpeg.size() >= 4);
+        ASSERT_TRUE(jpeg[0] == 0xFF && jpeg[1] == 0xD8);    // SOI
+        ASSERT_TRUE(jpeg[jpeg.size() - 2] == 0xFF && jpeg[jpeg.size() - 1] == 0xD9);  // EOI
+    }
+
+    // 默认后端只用软件编码
+    JpegEncoder def;
+    ASSERT_TRUE(def.backend() == JpegBackend::TURBOJPEG);
+}
+#endif
+
 // ============================================================
 // 测试运行器
 // ============================================================
@@ -36,6 +36,7 @@
 #include <chrono>
 #include <thread>
 #include <mutex>
+#include <cstdlib>
 
 using namespace infer_server;
 
@@ -107,6 +108,9 @@ int main(int argc, char* argv[]) {
     config.num_infer_workers = 3;
     config.infer_queue_size = 18;
     config.zmq_endpoint = "ipc:///tmp/infer_server_test_pipeline.ipc";
+    if (const char* depth = std::getenv("INFER_PIPELINE_DEPTH")) {
+        config.infer_pipeline_depth = std::atoi(depth);   // 1 = 串行, 用于对比 NPU 利用率
+    }
 
     InferenceEngine engine(config);
     if (!engine.init()) {
@@ -191,6 +195,18 @@ int main(int argc, char* argv[]) {
     int frames_submitted = 0;
     int frame_skip = 5;  // 每 5 帧推理 1 次
 
+    // 所有任务共享的模型绑定
+    auto binding = std::make_shared<ModelBinding>();
+    binding->cam_id = "test_cam";
+    binding->rtsp_url = rtsp_url;
+    binding->model_path = model_path;
+    binding->task_name = mc.task_name;
+    binding->model_type = mc.model_type;
+    binding->conf_threshold = mc.conf_threshold;
+    binding->nms_threshold = mc.nms_threshold;
+    binding->input_width = model_input_w;
+    binding->input_height = model_input_h;
+
     for (int i = 0; i < num_frames * frame_skip && frames_submitted < num_frames; i++) {
         auto frame = decoder.decode_frame();
         if (!frame) {
@@ -216,21 +232,13 @@ int main(int argc, char* argv[]) {
 
         // 构造 InferTask
         InferTask task;
-        task.cam_id = "test_cam";
-        task.rtsp_url = rtsp_url;
         task.frame_id = frame->frame_id;
         task.pts = frame->pts;
         task.timestamp_ms = frame->timestamp_ms;
         task.original_width = frame->width;
         task.original_height = frame->height;
-        task.model_path = model_path;
-        task.task_name = mc.task_name;
-        task.model_type = mc.model_type;
-        task.conf_threshold = mc.conf_threshold;
-        task.nms_threshold = mc.nms_threshold;
+        task.binding = binding;
         task.input_data = std::move(rgb_data);
-        task.input_width = model_input_w;
-        task.input_height = model_input_h;
         // 单模型, 不需要 aggregator
 
         engine.submit(std::move(task));
@@ -268,6 +276,12 @@ int main(int argc, char* argv[]) {
 #ifdef HAS_ZMQ
     std::cout << "  ZMQ published:     " << engine.zmq_published_count() << std::endl;
 #endif
+    std::cout << "  Pipeline depth:    " << config.infer_pipeline_depth << std::endl;
+    for (const auto& ws : engine.worker_stats()) {
+        std::cout << "  Worker " << ws.worker_id << " (core " << ws.core_mask << "): "
+                  << ws.processed << " tasks, NPU busy " << ws.npu_busy_us / 1000 << " ms, util "
+                  << ws.npu_utilization * 100.0 << "%" << std::endl;
+    }
     std::cout << "======================================" << std::endl;
 
     // ========================
@@ -0,0 +1,419 @@
+/**
+ * @file test_infer_task_queue.cpp
+ * @brief InferTaskQueue 推理任务队列测试 (纯逻辑, 不需要 NPU)
+ *
+ * 测试内容:
+ *   1. FIFO: 先进先出, 挤出的任务计入所属流
+ *   2. FAIR: 按 cam_id 轮转 (DRR), 每轮 quantum 个任务
+ *   3. FAIR: 优先级权重 (critical 4 : best_effort 1)
+ *   4. FAIR: 队列满时高帧率流只挤掉自己的旧任务
+ *   5. FAIR: 按优先级挤出, 低优先级新任务直接丢弃
+ *   6. deadline: 出队时丢弃排队超时的任务 (两种策略)
+ *   7. FAIR: pop_if 跨流按条件取任务 / 超时
+ *   8. stop 唤醒阻塞的 pop, reset 恢复
+ *   9. FAIR: 多生产者多消费者不丢不重
+ *
+ * 编译: cmake --build build --target test_infer_task_queue
+ * 运行: ./build/tests/test_infer_task_queue
+ */
+
+#include "infer_server/inference/infer_task_queue.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+// ============================================================
+// 简易测试框架 (同 test_bounded_queue)
+// ============================================================
+
+struct TestCase {
+    std::string name;
+    std::function<void()> func;
+};
+
+static std::vector<TestCase> g_tests;
+static int g_pass = 0;
+static int g_fail = 0;
+
+#define ASSERT_TRUE(cond)                                                      \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_TRUE failed: ") + #cond +                  \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_FALSE(cond) ASSERT_TRUE(!(cond))
+
+#define ASSERT_EQ(a, b)                                                        \
+    do {                                                                        \
+        auto _a = (a); auto _b = (b);                                          \
+        if (_a != _b) {                                                         \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_EQ failed: ") + #a + "=" +                 \
+                std::to_string(_a) + " != " + #b + "=" +                       \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define TEST(test_name)                                                        \
+    static void test_fn_##test_name();                                         \
+    static bool _reg_##test_name = [] {                                        \
+        g_tests.push_back({#test_name, test_fn_##test_name});                  \
+        return true;                                                            \
+    }();                                                                        \
+    static void test_fn_##test_name()
+
+// ============================================================
+// 测试用例
+// ============================================================
+
+using infer_server::InferTaskQueue;
+using infer_server::InferTask;
+using infer_server::ModelBinding;
+using infer_server::StreamCounters;
+using infer_server::TaskPriority;
+using namespace std::chrono_literals;
+
+using Policy = InferTaskQueue::Policy;
+
+/// 测试用的流: 同一路流的任务共享 binding
+struct TestStream {
+    std::shared_ptr<StreamCounters> counters = std::make_shared<StreamCounters>();
+    std::shared_ptr<ModelBinding> binding = std::make_shared<ModelBinding>();
+
+    explicit TestStream(const std::string& cam_id,
+                        TaskPriority priority = TaskPriority::Normal,
+                        int deadline_ms = 0,
+                        const std::string& model = "m.rknn") {
+        binding->cam_id = cam_id;
+        binding->model_path = model;
+        binding->priority = priority;
+        binding->deadline_ms = deadline_ms;
+        binding->counters = counters;
+    }
+
+    InferTask task(uint64_t frame_id) const {
+        InferTask t;
+        t.binding = binding;
+        t.frame_id = frame_id;
+        return t;
+    }
+};
+
+/// 弹出所有任务, 返回 (cam_id, frame_id) 序列
+static std::vector<std::pair<std::string, uint64_t>> drain(InferTaskQueue& q) {
+    std::vector<std::pair<std::string, uint64_t>> out;
+    while (auto t = q.try_pop()) {
+        out.emplace_back(t->binding->cam_id, t->frame_id);
+    }
+    return out;
+}
+
+// 1. FIFO 策略
+TEST(fifo_order_and_drop_attribution) {
+    InferTaskQueue q(3, infer_server::QueueMode::MUTEX, Policy::FIFO);
+    TestStream a("a"), b("b");
+
+    ASSERT_TRUE(q.push(a.task(1)));
+    ASSERT_TRUE(q.push(b.task(2)));
+    ASSERT_TRUE(q.push(a.task(3)));
+    ASSERT_TRUE(q.push(b.task(4)));     // 挤出 a#1
+
+    ASSERT_EQ(q.size(), 3u);
+    ASSERT_EQ(q.dropped_count(), 1u);
+    ASSERT_EQ(a.counters->infer_dropped.load(), 1u);
+    ASSERT_EQ(b.counters->infer_dropped.load(), 0u);
+
+    auto out = drain(q);
+    ASSERT_EQ(out.size(), 3u);
+    ASSERT_EQ(out[0].second, 2u);
+    ASSERT_EQ(out[1].second, 3u);
+    ASSERT_EQ(out[2].second, 4u);
+
+    // 无锁实现同样按流统计
+    InferTaskQueue lf(2, infer_server::QueueMode::LOCK_FREE, Policy::FIFO);
+    lf.push(a.task(5));
+    lf.push(b.task(6));
+    lf.push(b.task(7));
+    ASSERT_EQ(a.counters->infer_dropped.load(), 2u);
+    ASSERT_EQ(lf.try_pop()->frame_id, 6u);
+}
+
+// 2. FAIR: DRR 轮转
+TEST(fair_round_robin) {
+    InferTaskQueue q(32, infer_server::QueueMode::MUTEX, Policy::FAIR);
+    TestStream a("a"), b("b");
+
+    for (uint64_t i = 0; i < 6; i++) q.push(a.task(i));
+    q.push(b.task(100));
+    q.push(b.task(101));
+    ASSERT_EQ(q.flow_count(), 2u);
+
+    // normal quantum = 2: a a b b a a a a
+    auto out = drain(q);
+    ASSERT_EQ(out.size(), 8u);
+    std::string order;
+    for (auto& [cam, id] : out) order += cam;
+    ASSERT_TRUE(order == "aabbaaaa");
+
+    // 同一路流内保持 FIFO
+    ASSERT_EQ(out[0].second, 0u);
+    ASSERT_EQ(out[1].second, 1u);
+    ASSERT_EQ(out[4].second, 2u);
+    ASSERT_EQ(q.flow_count(), 0u);
+}
+
+// 3. FAIR: 优先级权重
+TEST(fair_priority_weights) {
+    InferTaskQueue q(64, infer_server::QueueMode::MUTEX, Policy::FAIR);
+    TestStream gate("gate", TaskPriority::Critical);
+    TestStream lobby("lobby", TaskPriority::BestEffort);
+
+    for (uint64_t i = 0; i < 20; i++) {
+        q.push(lobby.task(i));
+        q.push(gate.task(i));
+    }
+
+    // 前 10 个任务: critical 4 个 / best_effort 1 个 交替
+    std::map<std::string, int> counts;
+    for (int i = 0; i < 10; i++) {
+        auto t = q.try_pop();
+        ASSERT_TRUE(t.has_value());
+        counts[t->binding->cam_id]++;
+    }
+    ASSERT_EQ(counts["gate"], 8);
+    ASSERT_EQ(counts["lobby"], 2);
+}
+
+// 4. FAIR: 高帧率流只挤掉自己的任务
+TEST(fair_busy_stream_evicts_itself) {
+    InferTaskQueue q(6, infer_server::QueueMode::MUTEX, Policy::FAIR);
+    TestStream busy("busy"), quiet("quiet");
+
+    q.push(quiet.task(1));
+    q.push(quiet.task(2));
+    for (uint64_t i = 0; i < 20; i++) q.push(busy.task(i));
+
+    ASSERT_EQ(q.size(), 6u);
+    ASSERT_EQ(q.dropped_count(), 16u);
+    ASSERT_EQ(busy.counters->infer_dropped.load(), 16u);
+    ASSERT_EQ(quiet.counters->infer_dropped.load(), 0u);
+
+    // quiet 的两个任务都保留, busy 保留最新的 4 个
+    int quiet_left = 0;
+    uint64_t busy_min = UINT64_MAX;
+    for (auto& [cam, id] : drain(q)) {
+        if (cam == "quiet") quiet_left++;
+        else busy_min = std::min(busy_min, id);
+    }
+    ASSERT_EQ(quiet_left, 2);
+    ASSERT_EQ(busy_min, 16u);
+}
+
+// 5. FAIR: 按优先级挤出
+TEST(fair_priority_eviction) {
+    InferTaskQueue q(4, infer_server::QueueMode::MUTEX, Policy::FAIR);
+    TestStream gate("gate", TaskPriority::Critical);
+    TestStream lobby("lobby", TaskPriority::BestEffort);
+
+    q.push(lobby.task(1));
+    q.push(lobby.task(2));
+    q.push(gate.task(1));
+    q.push(gate.task(2));
+
+    // critical 新任务挤出 best_effort, 即使 gate 积压更多
+    q.push(gate.task(3));
+    q.push(gate.task(4));
+    ASSERT_EQ(lobby.counters->infer_dropped.load(), 2u);
+    ASSERT_EQ(gate.counters->infer_dropped.load(), 0u);
+
+    // 队列全是 critical: best_effort 新任务直接丢弃
+    q.push(lobby.task(3));
+    ASSERT_EQ(lobby.counters->infer_dropped.load(), 3u);
+    ASSERT_EQ(q.size(), 4u);
+    ASSERT_EQ(q.dropped_count(), 3u);
+
+    // critical 流继续推入: 挤掉自己最旧的任务
+    q.push(gate.task(5));
+    ASSERT_EQ(gate.counters->infer_dropped.load(), 1u);
+    auto first = q.try_pop();
+    ASSERT_EQ(first->frame_id, 2u);
+}
+
+// 6. deadline
+TEST(deadline_drops_stale_tasks) {
+    for (auto policy : {Policy::FIFO, Policy::FAIR}) {
+        InferTaskQueue q(16, infer_server::QueueMode::MUTEX, policy);
+        TestStream slow("slow", TaskPriority::Normal, 20);
+        TestStream live("live");
+
+        q.push(slow.task(1));
+        q.push(slow.task(2));
+        q.push(live.task(3));
+        std::this_thread::sleep_for(40ms);
+        q.push(slow.task(4));
+
+        std::vector<uint64_t> ids;
+        while (auto t = q.pop(10ms)) ids.push_back(t->frame_id);
+
+        ASSERT_EQ(ids.size(), 2u);
+        ASSERT_EQ(q.expired_count(), 2u);
+        ASSERT_EQ(slow.counters->infer_expired.load(), 2u);
+        ASSERT_EQ(live.counters->infer_expired.load(), 0u);
+    }
+}
+
+// 7. FAIR: pop_if
+TEST(fair_pop_if_across_flows) {
+    InferTaskQueue q(16, infer_server::QueueMode::MUTEX, Policy::FAIR);
+    TestStream a("a", TaskPriority::Normal, 0, "det.rknn");
+    TestStream b("b", TaskPriority::Normal, 0, "cls.rknn");
+    TestStream c("c", TaskPriority::Normal, 0, "det.rknn");
+
+    q.push(a.task(1));
+    q.push(b.task(2));
+    q.push(c.task(3));
+
+    auto is_cls = [](const InferTask& t) { return t.model_path() == "cls.rknn"; };
+    auto t = q.pop_if(is_cls, std::chrono::steady_clock::now());
+    ASSERT_TRUE(t.has_value());
+    ASSERT_EQ(t->frame_id, 2u);
+    ASSERT_EQ(q.flow_count(), 2u);
+
+    // 无匹配: 等到 deadline 返回
+    auto t0 = std::chrono::steady_clock::now();
+    ASSERT_FALSE(q.pop_if(is_cls, t0 + 30ms).has_value());
+    ASSERT_TRUE(std::chrono::steady_clock::now() - t0 >= 25ms);
+
+    // 等待期间推入的匹配任务被取出
+    std::thread producer([&] {
+        std::this_thread::sleep_for(20ms);
+        q.push(b.task(4));
+    });
+    auto late = q.pop_if(is_cls, std::chrono::steady_clock::now() + 500ms);
+    producer.join();
+    ASSERT_TRUE(late.has_value());
+    ASSERT_EQ(late->frame_id, 4u);
+    ASSERT_EQ(q.size(), 2u);
+}
+
+// 8. stop / reset
+TEST(stop_and_reset) {
+    InferTaskQueue q(4, infer_server::QueueMode::MUTEX, Policy::FAIR);
+    TestStream a("a");
+
+    std::atomic<bool> got{true};
+    std::thread waiter([&] { got = q.pop(2000ms).has_value(); });
+    std::this_thread::sleep_for(20ms);
+    auto t0 = std::chrono::steady_clock::now();
+    q.stop();
+    waiter.join();
+    ASSERT_FALSE(got.load());
+    ASSERT_TRUE(std::chrono::steady_clock::now() - t0 < 500ms);
+
+    ASSERT_TRUE(q.is_stopped());
+    ASSERT_FALSE(q.push(a.task(1)));
+
+    q.reset();
+    ASSERT_FALSE(q.is_stopped());
+    ASSERT_TRUE(q.push(a.task(2)));
+    ASSERT_EQ(q.size(), 1u);
+    q.clear();
+    ASSERT_TRUE(q.empty());
+    ASSERT_EQ(q.flow_count(), 0u);
+}
+
+// 9. FAIR: 多生产者多消费者
+TEST(fair_mpmc_no_loss) {
+    InferTaskQueue q(16, infer_server::QueueMode::MUTEX, Policy::FAIR);
+    const int kProducers = 4;
+    const int kPerProducer = 5000;
+
+    std::vector<std::unique_ptr<TestStream>> streams;
+    for (int i = 0; i < kProducers; i++) {
+        streams.push_back(std::make_unique<TestStream>("cam" + std::to_string(i)));
+    }
+
+    std::atomic<int> consumed{0};
+    std::atomic<bool> done{false};
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < 2; c++) {
+        consumers.emplace_back([&] {
+            while (true) {
+                auto t = q.pop(5ms);
+                if (t) {
+                    consumed++;
+                } else if (done.load()) {
+                    break;
+                }
+            }
+        });
+    }
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < kPerProducer; i++) {
+                q.push(streams[p]->task(static_cast<uint64_t>(i)));
+            }
+        });
+    }
+    for (auto& t : producers) t.join();
+    done = true;
+    for (auto& t : consumers) t.join();
+
+    size_t per_stream_drops = 0;
+    for (auto& s : streams) per_stream_drops += s->counters->infer_dropped.load();
+    ASSERT_EQ(per_stream_drops, q.dropped_count());
+    ASSERT_EQ(static_cast<size_t>(consumed.load()) + q.dropped_count() + q.size(),
+              static_cast<size_t>(kProducers * kPerProducer));
+}
+
+// ============================================================
+// 主函数
+// ============================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "  InferTaskQueue Unit Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    for (auto& tc : g_tests) {
+        std::cout << "[RUN ] " << tc.name << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            tc.func();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[PASS] " << tc.name << " (" << ms << "ms)" << std::endl;
+            g_pass++;
+        } catch (const std::exception& e) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[FAIL] " << tc.name << " (" << ms << "ms)" << std::endl;
+            std::cout << "       " << e.what() << std::endl;
+            g_fail++;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Results: " << g_pass << " passed, " << g_fail << " failed"
+              << " (total " << (g_pass + g_fail) << ")" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return g_fail > 0 ? 1 : 0;
+}
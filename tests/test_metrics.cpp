@@ -0,0 +1,318 @@
+/**
+ * @file test_metrics.cpp
+ * @brief 延迟直方图与 Prometheus 输出测试 (纯 CPU, 不需要硬件)
+ *
+ * 测试内容:
+ *   1. 桶划分: 小值精确, 大值相对误差 <= 12.5%, 超出上限按上限计
+ *   2. 分位数: 均匀分布的 p50 / p99 / p999 落在误差范围内, 不超过最大值
+ *   3. 多线程并发记录不丢计数
+ *   4. StageLatency 按阶段分别记录
+ *   5. Prometheus 文本: HELP / TYPE 只输出一次, summary 分位数与 _sum / _count, 标签转义
+ *   6. RateMeter: 恒定速率, 负载突变时短窗口先反应, 空闲衰减, reset, 并发 mark
+ *
+ * 编译: cmake --build build --target test_metrics
+ * 运行: ./build/tests/test_metrics
+ */
+
+#include "infer_server/common/metrics.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+// ============================================================
+// 简易测试框架 (同 test_bounded_queue)
+// ============================================================
+
+struct TestCase {
+    std::string name;
+    std::function<void()> func;
+};
+
+static std::vector<TestCase> g_tests;
+static int g_pass = 0;
+static int g_fail = 0;
+
+#define ASSERT_TRUE(cond)                                                      \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_TRUE failed: ") + #cond +                  \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_FALSE(cond) ASSERT_TRUE(!(cond))
+
+#define ASSERT_EQ(a, b)                                                        \
+    do {                                                                        \
+        auto _a = (a); auto _b = (b);                                          \
+        if (_a != _b) {                                                         \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_EQ failed: ") + #a + "=" +                 \
+                std::to_string(_a) + " != " + #b + "=" +                       \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_NEAR(a, b, eps)                                                 \
+    do {                                                                        \
+        double _a = (a); double _b = (b);                                      \
+        if (std::fabs(_a - _b) > (eps)) {                                       \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_NEAR failed: ") + #a + "=" +              \
+                std::to_string(_a) + " vs " + #b + "=" +                     \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define TEST(test_name)                                                        \
+    static void test_fn_##test_name();                                         \
+    static bool _reg_##test_name = [] {                                        \
+        g_tests.push_back({#test_name, test_fn_##test_name});                  \
+        return true;                                                            \
+    }();                                                                        \
+    static void test_fn_##test_name()
+
+// ============================================================
+// 测试用例
+// ============================================================
+
+using infer_server::LatencyHistogram;
+using infer_server::LatencyStage;
+using infer_server::PrometheusWriter;
+using infer_server::RateMeter;
+using infer_server::StageLatency;
+
+static size_t count_occurrences(const std::string& text, const std::string& needle) {
+    size_t n = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) n++;
+    return n;
+}
+
+// 1. 桶划分
+TEST(bucket_layout) {
+    for (uint64_t v = 0; v < 8; v++) {
+        ASSERT_EQ(LatencyHistogram::bucket_index(v), static_cast<size_t>(v));
+        ASSERT_EQ(LatencyHistogram::bucket_upper(v), v);
+    }
+    // 桶上界单调递增, 每个值落在 [上一桶上界 + 1, 本桶上界] 内
+    uint64_t values[] = {8, 9, 15, 16, 17, 100, 1000, 12345, 999999, 123456789};
+    for (uint64_t v : values) {
+        size_t idx = LatencyHistogram::bucket_index(v);
+        ASSERT_TRUE(v <= LatencyHistogram::bucket_upper(idx));
+        ASSERT_TRUE(v > LatencyHistogram::bucket_upper(idx - 1));
+        double rel = static_cast<double>(LatencyHistogram::bucket_upper(idx) - v) / static_cast<double>(v);
+        ASSERT_TRUE(rel <= 0.125);
+    }
+    ASSERT_EQ(LatencyHistogram::bucket_index(UINT64_MAX), LatencyHistogram::kBuckets - 1);
+}
+
+// 2. 分位数
+TEST(percentiles_uniform) {
+    LatencyHistogram h;
+    ASSERT_EQ(h.snapshot().percentile_us(0.5), 0ULL);
+
+    for (uint64_t v = 1; v <= 10000; v++) h.record_us(v);
+    auto snap = h.snapshot();
+    ASSERT_EQ(snap.count, 10000ULL);
+    ASSERT_EQ(snap.max_us, 10000ULL);
+    ASSERT_EQ(snap.sum_us, 10000ULL * 10001 / 2);
+    ASSERT_NEAR(snap.mean_us(), 5000.5, 1e-6);
+
+    ASSERT_NEAR(static_cast<double>(snap.percentile_us(0.5)), 5000.0, 5000.0 * 0.125);
+    ASSERT_NEAR(static_cast<double>(snap.percentile_us(0.99)), 9900.0, 9900.0 * 0.125);
+    ASSERT_TRUE(snap.percentile_us(0.999) <= 10000ULL);
+    ASSERT_EQ(snap.percentile_us(1.0), 10000ULL);
+
+    // 纳秒接口: 负值按 0 计
+    LatencyHistogram ns;
+    ns.record_ns(-5);
+    ns.record_ns(2500000);
+    auto s2 = ns.snapshot();
+    ASSERT_EQ(s2.count, 2ULL);
+    ASSERT_EQ(s2.max_us, 2500ULL);
+    ASSERT_EQ(s2.percentile_us(0.5), 0ULL);
+}
+
+// 快照合并 / 相减 (压测按测量窗口汇总多路流)
+TEST(snapshot_merge_subtract) {
+    LatencyHistogram a, b;
+    for (uint64_t v = 1; v <= 100; v++) a.record_us(v);
+    auto warm = a.snapshot();
+    for (int i = 0; i < 100; i++) a.record_us(5000);
+    for (int i = 0; i < 50; i++) b.record_us(7);
+
+    auto window = a.snapshot();
+    window.subtract(warm);
+    ASSERT_EQ(window.count, 100ULL);
+    ASSERT_EQ(window.sum_us, 500000ULL);
+    ASSERT_EQ(window.percentile_us(0.01), 5000ULL);
+
+    window.merge(b.snapshot());
+    ASSERT_EQ(window.count, 150ULL);
+    ASSERT_EQ(window.percentile_us(0.3), 7ULL);
+    ASSERT_EQ(window.max_us, 5000ULL);
+
+    LatencyHistogram::Snapshot empty;
+    empty.merge(b.snapshot());
+    ASSERT_EQ(empty.count, 50ULL);
+}
+
+// 3. 并发记录
+TEST(concurrent_record) {
+    LatencyHistogram h;
+    const int kThreads = 4;
+    const int kPerThread = 50000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&h, t]() {
+            for (int i = 0; i < kPerThread; i++) h.record_us(static_cast<uint64_t>(t * 1000 + i % 1000));
+        });
+    }
+    for (auto& th : threads) th.join();
+    auto snap = h.snapshot();
+    ASSERT_EQ(snap.count, static_cast<uint64_t>(kThreads * kPerThread));
+    ASSERT_EQ(h.count(), static_cast<uint64_t>(kThreads * kPerThread));
+    ASSERT_EQ(snap.max_us, 3999ULL);
+}
+
+// 4. 分阶段
+TEST(stage_latency) {
+    StageLatency lat;
+    lat.record(LatencyStage::Npu, 8000000);
+    lat.record(LatencyStage::Npu, 12000000);
+    lat.record(LatencyStage::QueueWait, 1000);
+    ASSERT_EQ(lat.at(LatencyStage::Npu).count(), 2ULL);
+    ASSERT_EQ(lat.at(LatencyStage::QueueWait).count(), 1ULL);
+    ASSERT_EQ(lat.at(LatencyStage::Decode).count(), 0ULL);
+    ASSERT_TRUE(std::string(infer_server::latency_stage_name(LatencyStage::EndToEnd)) == "end_to_end");
+}
+
+// 5. Prometheus 文本
+TEST(prometheus_text) {
+    LatencyHistogram h;
+    h.record_us(1000);
+    h.record_us(3000);
+
+    PrometheusWriter w;
+    w.summary("lat_seconds", "Latency", {{"cam_id", "cam\"1"}, {"stage", "npu"}}, h.snapshot());
+    w.summary("lat_seconds", "Latency", {{"cam_id", "cam2"}, {"stage", "npu"}}, h.snapshot());
+    w.sample("queue_depth", "gauge", "Depth", {}, 7);
+    const std::string& text = w.str();
+
+    ASSERT_EQ(count_occurrences(text, "# HELP lat_seconds Latency\n"), size_t{1});
+    ASSERT_EQ(count_occurrences(text, "# TYPE lat_seconds summary\n"), size_t{1});
+    ASSERT_EQ(count_occurrences(text, "# TYPE queue_depth gauge\n"), size_t{1});
+    ASSERT_TRUE(text.find("lat_seconds{cam_id=\"cam\\\"1\",stage=\"npu\",quantile=\"0.5\"} 0.001023\n") != std::string::npos);
+    ASSERT_TRUE(text.find("lat_seconds{cam_id=\"cam2\",stage=\"npu\",quantile=\"0.99\"} 0.003\n") != std::string::npos);
+    ASSERT_TRUE(text.find("lat_seconds_sum{cam_id=\"cam2\",stage=\"npu\"} 0.004\n") != std::string::npos);
+    ASSERT_TRUE(text.find("lat_seconds_count{cam_id=\"cam2\",stage=\"npu\"} 2\n") != std::string::npos);
+    ASSERT_TRUE(text.find("queue_depth 7\n") != std::string::npos);
+    ASSERT_TRUE(PrometheusWriter::escape("a\\b\nc") == "a\\\\b\\nc");
+}
+
+// 6. 滑动窗口速率
+static constexpr int64_t kSec = 1000000000;
+
+TEST(rate_meter_constant) {
+    RateMeter m(0);
+    // 刚启动: 没有完整秒
+    m.mark(5, kSec / 2);
+    auto r0 = m.rates(kSec + kSec / 2);
+    ASSERT_NEAR(r0.last_1s, 0.0, 1e-9);
+
+    // 每秒 25 次, 持续 100 秒 (跨越槽位回绕)
+    for (int64_t sec = 1; sec <= 100; sec++) {
+        for (int i = 0; i < 25; i++) m.mark(1, sec * kSec + i * (kSec / 25));
+    }
+    auto r = m.rates(101 * kSec);
+    ASSERT_NEAR(r.last_1s, 25.0, 1e-9);
+    ASSERT_NEAR(r.last_10s, 25.0, 1e-9);
+    ASSERT_NEAR(r.last_60s, 25.0, 1e-9);
+}
+
+TEST(rate_meter_step_and_idle) {
+    RateMeter m(0);
+    for (int64_t sec = 1; sec <= 60; sec++) m.mark(10, sec * kSec);
+    // 最近 3 秒升到 100/s: 1 秒窗口最先反应, 60 秒窗口变化最小
+    for (int64_t sec = 61; sec <= 63; sec++) m.mark(100, sec * kSec);
+    auto r = m.rates(64 * kSec);
+    ASSERT_TRUE(r.last_1s > 90.0);
+    ASSERT_TRUE(r.last_10s > 30.0 && r.last_10s < r.last_1s);
+    ASSERT_TRUE(r.last_60s > 10.0 && r.last_60s < r.last_10s);
+
+    // 空闲 120 秒后所有窗口归零 (旧秒号的槽位不再计入)
+    auto idle = m.rates(184 * kSec);
+    ASSERT_NEAR(idle.last_1s, 0.0, 1e-9);
+    ASSERT_NEAR(idle.last_60s, 0.0, 1e-9);
+
+    // reset 之前的计数不参与计算
+    m.reset(200 * kSec);
+    m.mark(7, 201 * kSec);
+    auto after = m.rates(202 * kSec);
+    ASSERT_NEAR(after.last_60s, 7.0, 1e-9);
+
+    RateMeter::Rates sum = after;
+    sum += after;
+    ASSERT_NEAR(sum.last_10s, 14.0, 1e-9);
+}
+
+TEST(rate_meter_concurrent) {
+    RateMeter m(4 * kSec);      // 只有第 5 秒一个完整秒
+    const int kThreads = 4;
+    const int kPerThread = 100000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&m]() {
+            for (int i = 0; i < kPerThread; i++) m.mark(1, 5 * kSec + i);
+        });
+    }
+    for (auto& th : threads) th.join();
+    ASSERT_NEAR(m.rates(6 * kSec).last_1s, static_cast<double>(kThreads * kPerThread), 1e-6);
+}
+
+// ============================================================
+// 主函数
+// ============================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Metrics Unit Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    for (auto& tc : g_tests) {
+        std::cout << "[RUN ] " << tc.name << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            tc.func();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[PASS] " << tc.name << " (" << ms << "ms)" << std::endl;
+            g_pass++;
+        } catch (const std::exception& e) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[FAIL] " << tc.name << " (" << ms << "ms)" << std::endl;
+            std::cout << "       " << e.what() << std::endl;
+            g_fail++;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Results: " << g_pass << " passed, " << g_fail << " failed"
+              << " (total " << (g_pass + g_fail) << ")" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return g_fail > 0 ? 1 : 0;
+}
@@ -0,0 +1,206 @@
+/**
+ * @file test_model_retirement.cpp
+ * @brief ModelRetirement 热切换旧模型延迟卸载测试 (纯逻辑, 不需要硬件)
+ *
+ * 测试内容:
+ *   1. 旧绑定仍被引用时不卸载, 全部释放后 claim 一次
+ *   2. 切换超时: 仍被流引用时保留登记, 流切换后再次 claim 时卸载
+ *   3. 重新投入使用 (cancel / in_use) 的模型不再登记
+ *   4. 卸载中: unloading / wait_unloaded 在 finish 后返回, begin_unload 不重复标记
+ *
+ * 编译: cmake --build build --target test_model_retirement
+ * 运行: ./build/tests/test_model_retirement
+ */
+
+#include "infer_server/stream/model_retirement.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <memory>
+
+// ============================================================
+// 简易测试框架 (同 test_bounded_queue)
+// ============================================================
+
+struct TestCase {
+    std::string name;
+    std::function<void()> func;
+};
+
+static std::vector<TestCase> g_tests;
+static int g_pass = 0;
+static int g_fail = 0;
+
+#define ASSERT_TRUE(cond)                                                      \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_TRUE failed: ") + #cond +                  \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_FALSE(cond) ASSERT_TRUE(!(cond))
+
+#define ASSERT_EQ(a, b)                                                        \
+    do {                                                                        \
+        auto _a = (a); auto _b = (b);                                          \
+        if (_a != _b) {                                                         \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_EQ failed: ") + #a + "=" +                 \
+                std::to_string(_a) + " != " + #b + "=" +                       \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define TEST(test_name)                                                        \
+    static void test_fn_##test_name();                                         \
+    static bool _reg_##test_name = [] {                                        \
+        g_tests.push_back({#test_name, test_fn_##test_name});                  \
+        return true;                                                            \
+    }();                                                                        \
+    static void test_fn_##test_name()
+
+// ============================================================
+// 测试用例
+// ============================================================
+
+using infer_server::ModelBinding;
+using infer_server::ModelRetirement;
+
+static std::shared_ptr<const ModelBinding> make_binding(const std::string& path) {
+    auto b = std::make_shared<ModelBinding>();
+    b->model_path = path;
+    return b;
+}
+
+static const ModelRetirement::InUse kUnused = [](const std::string&) { return false; };
+
+// 1. 旧绑定 (在途任务) 释放后才卸载
+TEST(waits_for_bindings) {
+    ModelRetirement r;
+    auto b1 = make_binding("old.rknn");
+    auto b2 = make_binding("old.rknn");
+    r.retire("old.rknn", {b1, b2});
+    ASSERT_EQ(r.retired_count(), 1u);
+
+    ASSERT_TRUE(r.claim(kUnused).empty());
+    b1.reset();
+    ASSERT_TRUE(r.claim(kUnused).empty());
+    b2.reset();
+
+    auto claimed = r.claim(kUnused);
+    ASSERT_EQ(claimed.size(), 1u);
+    ASSERT_TRUE(claimed[0] == "old.rknn");
+    ASSERT_EQ(r.retired_count(), 0u);
+    ASSERT_TRUE(r.unloading({"old.rknn"}));
+
+    // 已取出: 不会再次 claim
+    ASSERT_TRUE(r.claim(kUnused).empty());
+    r.finish("old.rknn");
+    ASSERT_FALSE(r.unloading({"old.rknn"}));
+}
+
+// 2. swap_model 超时 (流仍待切换): 之后旧绑定释放、流切换完成时由重试卸载
+TEST(retry_after_swap_timeout) {
+    ModelRetirement r;
+    auto binding = make_binding("old.rknn");
+    r.retire("old.rknn", {binding});
+
+    // 流尚未切换: 旧绑定仍被引用, 保留登记
+    ASSERT_TRUE(r.claim(kUnused).empty());
+    ASSERT_EQ(r.retired_count(), 1u);
+
+    // 预处理线程应用切换, 在途任务结束
+    binding.reset();
+    auto claimed = r.claim(kUnused);
+    ASSERT_EQ(claimed.size(), 1u);
+    r.finish(claimed[0]);
+    ASSERT_EQ(r.retired_count(), 0u);
+}
+
+// 3. 重新投入使用的模型不再登记
+TEST(back_in_use_not_unloaded) {
+    ModelRetirement r;
+    std::weak_ptr<const ModelBinding> expired;
+    r.retire("a.rknn", {expired});
+    r.retire("b.rknn", {expired});
+
+    // a 被新添加的流引用
+    auto claimed = r.claim([](const std::string& path) { return path == "a.rknn"; });
+    ASSERT_EQ(claimed.size(), 1u);
+    ASSERT_TRUE(claimed[0] == "b.rknn");
+    ASSERT_EQ(r.retired_count(), 0u);
+    r.finish("b.rknn");
+
+    // 切换回之前的模型: 取消登记
+    r.retire("c.rknn", {expired});
+    r.cancel("c.rknn");
+    ASSERT_TRUE(r.claim(kUnused).empty());
+}
+
+// 4. 卸载中: 等待者在 finish 后返回
+TEST(wait_unloaded) {
+    ModelRetirement r;
+    ASSERT_TRUE(r.begin_unload("m.rknn"));
+    ASSERT_FALSE(r.begin_unload("m.rknn"));
+    ASSERT_TRUE(r.unloading({"x.rknn", "m.rknn"}));
+    ASSERT_FALSE(r.unloading({"x.rknn"}));
+
+    std::atomic<bool> returned{false};
+    std::thread waiter([&]() {
+        r.wait_unloaded({"m.rknn"});
+        returned = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    bool returned_early = returned.load();
+    r.finish("m.rknn");
+    waiter.join();
+
+    ASSERT_FALSE(returned_early);
+    ASSERT_TRUE(returned.load());
+    ASSERT_TRUE(r.begin_unload("m.rknn"));
+}
+
+// ============================================================
+// 主函数
+// ============================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "  ModelRetirement Unit Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    for (auto& tc : g_tests) {
+        std::cout << "[RUN ] " << tc.name << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            tc.func();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[PASS] " << tc.name << " (" << ms << "ms)" << std::endl;
+            g_pass++;
+        } catch (const std::exception& e) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[FAIL] " << tc.name << " (" << ms << "ms)" << std::endl;
+            std::cout << "       " << e.what() << std::endl;
+            g_fail++;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Results: " << g_pass << " passed, " << g_fail << " failed"
+              << " (total " << (g_pass + g_fail) << ")" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return g_fail > 0 ? 1 : 0;
+}
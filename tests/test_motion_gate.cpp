@@ -0,0 +1,284 @@
+/**
+ * @file test_motion_gate.cpp
+ * @brief MotionGate 场景变化门控测试 (纯 CPU, 不需要硬件)
+ *
+ * 测试内容:
+ *   1. 缩略图采样: 2x2 均值, 支持行步长
+ *   2. 单块 SAD 与逐像素参考实现一致
+ *   3. 首帧推理, 静止帧跳过, 局部变化触发推理并更新参考帧
+ *   4. min_blocks: 变化块数不足时跳过
+ *   5. max_skip_ms: 静止超时强制推理; 时间戳回退时同样推理
+ *   6. reset 后下一帧必定推理
+ *
+ * 编译: cmake --build build --target test_motion_gate
+ * 运行: ./build/tests/test_motion_gate
+ */
+
+#include "infer_server/stream/motion_gate.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+
+// ============================================================
+// 简易测试框架 (同 test_bounded_queue)
+// ============================================================
+
+struct TestCase {
+    std::string name;
+    std::function<void()> func;
+};
+
+static std::vector<TestCase> g_tests;
+static int g_pass = 0;
+static int g_fail = 0;
+
+#define ASSERT_TRUE(cond)                                                      \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_TRUE failed: ") + #cond +                  \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_FALSE(cond) ASSERT_TRUE(!(cond))
+
+#define ASSERT_EQ(a, b)                                                        \
+    do {                                                                        \
+        auto _a = (a); auto _b = (b);                                          \
+        if (_a != _b) {                                                         \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_EQ failed: ") + #a + "=" +                 \
+                std::to_string(_a) + " != " + #b + "=" +                       \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_NEAR(a, b, eps)                                                 \
+    do {                                                                        \
+        double _a = (a); double _b = (b);                                      \
+        if (std::fabs(_a - _b) > (eps)) {                                       \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_NEAR failed: ") + #a + "=" +              \
+                std::to_string(_a) + " vs " + #b + "=" +                     \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define TEST(test_name)                                                        \
+    static void test_fn_##test_name();                                         \
+    static bool _reg_##test_name = [] {                                        \
+        g_tests.push_back({#test_name, test_fn_##test_name});                  \
+        return true;                                                            \
+    }();                                                                        \
+    static void test_fn_##test_name()
+
+// ============================================================
+// 测试用例
+// ============================================================
+
+using infer_server::MotionGate;
+
+static constexpr int kW = MotionGate::kThumbWidth;
+static constexpr int kH = MotionGate::kThumbHeight;
+
+/// 均匀亮度缩略图
+static std::vector<uint8_t> flat_thumb(uint8_t value) {
+    return std::vector<uint8_t>(static_cast<size_t>(kW) * kH, value);
+}
+
+/// 把第 (bc, br) 块整体加上 delta
+static void shift_block(std::vector<uint8_t>& thumb, int bc, int br, int delta) {
+    for (int y = 0; y < MotionGate::kBlockHeight; y++) {
+        for (int x = 0; x < MotionGate::kBlockWidth; x++) {
+            auto& p = thumb[(br * MotionGate::kBlockHeight + y) * kW + bc * MotionGate::kBlockWidth + x];
+            p = static_cast<uint8_t>(p + delta);
+        }
+    }
+}
+
+static MotionGate::Options make_options(double threshold, int min_blocks = 1, int max_skip_ms = 0) {
+    MotionGate::Options opts;
+    opts.threshold = threshold;
+    opts.min_blocks = min_blocks;
+    opts.max_skip_ms = max_skip_ms;
+    return opts;
+}
+
+// 1. 缩略图采样
+TEST(downsample_average_and_stride) {
+    // 640x360 Y 平面, 行步长 704; 每个 2x2 取样区域内为 10/20/30/40, 均值 25
+    const int w = 640, h = 360, stride = 704;
+    std::vector<uint8_t> y(static_cast<size_t>(stride) * h, 0);
+    for (int r = 0; r < h; r++) {
+        for (int c = 0; c < w; c++) {
+            y[r * stride + c] = static_cast<uint8_t>(10 + (c % 2) * 10 + (r % 2) * 20);
+        }
+        // 行尾填充区域不应被读取
+        for (int c = w; c < stride; c++) y[r * stride + c] = 255;
+    }
+    std::vector<uint8_t> thumb(static_cast<size_t>(kW) * kH);
+    MotionGate::downsample(y.data(), w, h, stride, thumb.data());
+    for (uint8_t v : thumb) {
+        ASSERT_EQ(static_cast<int>(v), 25);
+    }
+
+    // 亮度渐变: 缩略图保持单调
+    for (int r = 0; r < h; r++) {
+        for (int c = 0; c < w; c++) y[r * stride + c] = static_cast<uint8_t>(c * 255 / (w - 1));
+    }
+    MotionGate::downsample(y.data(), w, h, stride, thumb.data());
+    for (int x = 1; x < kW; x++) {
+        ASSERT_TRUE(thumb[x] >= thumb[x - 1]);
+    }
+    ASSERT_TRUE(thumb[0] < 10);
+    ASSERT_TRUE(thumb[kW - 1] > 245);
+}
+
+// 2. 单块 SAD
+TEST(block_sad_matches_reference) {
+    std::vector<uint8_t> a(static_cast<size_t>(kW) * kH), b(a.size());
+    std::srand(7);
+    for (size_t i = 0; i < a.size(); i++) {
+        a[i] = static_cast<uint8_t>(std::rand() & 0xFF);
+        b[i] = static_cast<uint8_t>(std::rand() & 0xFF);
+    }
+    for (int br = 0; br < MotionGate::kBlockRows; br++) {
+        for (int bc = 0; bc < MotionGate::kBlockCols; bc++) {
+            size_t offset = static_cast<size_t>(br) * MotionGate::kBlockHeight * kW + bc * MotionGate::kBlockWidth;
+            uint32_t expected = 0;
+            for (int y = 0; y < MotionGate::kBlockHeight; y++) {
+                for (int x = 0; x < MotionGate::kBlockWidth; x++) {
+                    size_t i = offset + y * kW + x;
+                    expected += static_cast<uint32_t>(std::abs(a[i] - b[i]));
+                }
+            }
+            ASSERT_EQ(MotionGate::block_sad(a.data() + offset, b.data() + offset, kW), expected);
+        }
+    }
+
+    // 最大差值不溢出
+    auto black = flat_thumb(0), white = flat_thumb(255);
+    ASSERT_EQ(MotionGate::block_sad(black.data(), white.data(), kW),
+              255u * MotionGate::kBlockWidth * MotionGate::kBlockHeight);
+}
+
+// 3. 静止跳过, 局部变化触发
+TEST(static_scene_skipped_local_change_detected) {
+    MotionGate gate(make_options(8.0));
+    auto base = flat_thumb(100);
+
+    ASSERT_TRUE(gate.check(base.data(), 0));        // 首帧
+    ASSERT_FALSE(gate.check(base.data(), 40));
+    ASSERT_NEAR(gate.last_score(), 0.0, 1e-9);
+
+    // 全局轻微噪声 (平均差 3 < 8) 不触发
+    auto noisy = flat_thumb(103);
+    ASSERT_FALSE(gate.check(noisy.data(), 80));
+    ASSERT_NEAR(gate.last_score(), 3.0, 1e-9);
+
+    // 单个块明显变化 (一个人进入画面一角) 触发, 且成为新的参考帧
+    auto moved = base;
+    shift_block(moved, 7, 8, 40);
+    ASSERT_TRUE(gate.check(moved.data(), 120));
+    ASSERT_EQ(gate.last_changed_blocks(), 1);
+    ASSERT_NEAR(gate.last_score(), 40.0, 1e-9);
+    ASSERT_FALSE(gate.check(moved.data(), 160));
+
+    // 恢复原状同样是变化
+    ASSERT_TRUE(gate.check(base.data(), 200));
+}
+
+// 4. min_blocks
+TEST(min_blocks_required) {
+    MotionGate gate(make_options(8.0, 3));
+    auto base = flat_thumb(50);
+    ASSERT_TRUE(gate.check(base.data(), 0));
+
+    auto two = base;
+    shift_block(two, 0, 0, 30);
+    shift_block(two, 1, 0, 30);
+    ASSERT_FALSE(gate.check(two.data(), 40));
+    ASSERT_EQ(gate.last_changed_blocks(), 2);
+
+    auto three = two;
+    shift_block(three, 2, 0, 30);
+    ASSERT_TRUE(gate.check(three.data(), 80));
+    ASSERT_EQ(gate.last_changed_blocks(), 3);
+}
+
+// 5. max_skip_ms
+TEST(max_skip_forces_inference) {
+    MotionGate gate(make_options(8.0, 1, 1000));
+    auto base = flat_thumb(100);
+    ASSERT_TRUE(gate.check(base.data(), 10000));
+    ASSERT_FALSE(gate.check(base.data(), 10500));
+    ASSERT_FALSE(gate.check(base.data(), 10999));
+    ASSERT_TRUE(gate.check(base.data(), 11000));    // 距上次推理 1000ms
+    ASSERT_FALSE(gate.check(base.data(), 11400));
+
+    // 时间戳回退 (重连后时钟变化) 不应导致永久跳过
+    ASSERT_TRUE(gate.check(base.data(), 500));
+    ASSERT_FALSE(gate.check(base.data(), 600));
+
+    // max_skip_ms = 0: 不限
+    MotionGate unlimited(make_options(8.0, 1, 0));
+    ASSERT_TRUE(unlimited.check(base.data(), 0));
+    ASSERT_FALSE(unlimited.check(base.data(), 3600 * 1000));
+}
+
+// 6. reset
+TEST(reset_clears_reference) {
+    MotionGate gate(make_options(8.0));
+    auto base = flat_thumb(100);
+    ASSERT_TRUE(gate.check(base.data(), 0));
+    ASSERT_FALSE(gate.check(base.data(), 40));
+    gate.reset();
+    ASSERT_TRUE(gate.check(base.data(), 80));
+    ASSERT_FALSE(gate.check(base.data(), 120));
+}
+
+// ============================================================
+// 主函数
+// ============================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "  MotionGate Unit Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    for (auto& tc : g_tests) {
+        std::cout << "[RUN ] " << tc.name << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            tc.func();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[PASS] " << tc.name << " (" << ms << "ms)" << std::endl;
+            g_pass++;
+        } catch (const std::exception& e) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[FAIL] " << tc.name << " (" << ms << "ms)" << std::endl;
+            std::cout << "       " << e.what() << std::endl;
+            g_fail++;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Results: " << g_pass << " passed, " << g_fail << " failed"
+              << " (total " << (g_pass + g_fail) << ")" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return g_fail > 0 ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * @file test_nal_parser.cpp
+ * @brief NAL 单元解析 / 非参考帧过滤测试 (纯字节解析, 不需要 FFmpeg)
+ *
+ * 测试内容:
+ *   1. Annex B 拆分 (3 / 4 字节起始码, 尾随 0)
+ *   2. 长度前缀 (AVCC) 拆分, 越界截断
+ *   3. H.264: nal_ref_idc = 0 的 slice 可丢弃, IDR / 参考 P 帧不可丢弃
+ *   4. H.264: 只有参数集 / SEI 的包不可丢弃
+ *   5. H.265: TRAIL_N 可丢弃, TRAIL_R / IDR 不可丢弃
+ *   6. H.265: 低时域层的 _N 帧在出现更高层后不再丢弃
+ *
+ * 编译: cmake --build build --target test_nal_parser
+ * 运行: ./build/tests/test_nal_parser
+ */
+
+#include "infer_server/decoder/nal_parser.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <stdexcept>
+#include <initializer_list>
+
+// ============================================================
+// 简易测试框架 (同 test_bounded_queue)
+// ============================================================
+
+struct TestCase {
+    std::string name;
+    std::function<void()> func;
+};
+
+static std::vector<TestCase> g_tests;
+static int g_pass = 0;
+static int g_fail = 0;
+
+#define ASSERT_TRUE(cond)                                                      \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_TRUE failed: ") + #cond +                  \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_FALSE(cond) ASSERT_TRUE(!(cond))
+
+#define ASSERT_EQ(a, b)                                                        \
+    do {                                                                        \
+        auto _a = (a); auto _b = (b);                                          \
+        if (_a != _b) {                                                         \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_EQ failed: ") + #a + "=" +                 \
+                std::to_string(_a) + " != " + #b + "=" +                       \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define TEST(test_name)                                                        \
+    static void test_fn_##test_name();                                         \
+    static bool _reg_##test_name = [] {                                        \
+        g_tests.push_back({#test_name, test_fn_##test_name});                  \
+        return true;                                                            \
+    }();                                                                        \
+    static void test_fn_##test_name()
+
+// ============================================================
+// 测试用例
+// ============================================================
+
+using infer_server::NalCodec;
+using infer_server::NalUnit;
+using infer_server::NonRefPacketFilter;
+using infer_server::split_nal_units;
+
+using Bytes = std::vector<uint8_t>;
+
+/// 拼接 Annex B 包: 每个 NAL 前加 4 字节起始码
+static Bytes annexb(std::initializer_list<Bytes> nals) {
+    Bytes out;
+    for (const auto& nal : nals) {
+        out.insert(out.end(), {0, 0, 0, 1});
+        out.insert(out.end(), nal.begin(), nal.end());
+    }
+    return out;
+}
+
+/// H.264 NAL: 头字节 = (nal_ref_idc << 5) | type, 后跟 2 字节载荷
+static Bytes h264_nal(int ref_idc, int type) {
+    return {static_cast<uint8_t>((ref_idc << 5) | type), 0x88, 0x84};
+}
+
+/// H.265 NAL: 2 字节头 (type, TemporalId), 后跟 2 字节载荷
+static Bytes h265_nal(int type, int tid = 0) {
+    return {static_cast<uint8_t>(type << 1), static_cast<uint8_t>(tid + 1), 0xAF, 0x80};
+}
+
+static bool droppable(NonRefPacketFilter& f, const Bytes& pkt) {
+    return f.droppable(pkt.data(), pkt.size());
+}
+
+// 1. Annex B
+TEST(split_annexb) {
+    Bytes pkt = {0, 0, 0, 1, 0x67, 0x42, 0x1F,      // SPS (4 字节起始码)
+                 0, 0, 1, 0x68, 0xCE,               // PPS (3 字节起始码)
+                 0, 0, 0, 1, 0x65, 0x88, 0x80,       // IDR
+                 0, 0};                              // trailing_zero_8bits
+    std::vector<NalUnit> nals;
+    ASSERT_EQ(split_nal_units(pkt.data(), pkt.size(), nals), 3u);
+    ASSERT_EQ(nals[0].size, 3u);
+    ASSERT_EQ(static_cast<int>(nals[0].data[0]), 0x67);
+    ASSERT_EQ(nals[1].size, 2u);
+    ASSERT_EQ(static_cast<int>(nals[1].data[0]), 0x68);
+    ASSERT_EQ(nals[2].size, 3u);
+    ASSERT_EQ(static_cast<int>(nals[2].data[2]), 0x80);
+
+    ASSERT_EQ(split_nal_units(nullptr, 0, nals), 0u);
+}
+
+// 2. 长度前缀
+TEST(split_length_prefixed) {
+    Bytes pkt = {0, 0, 0, 2, 0x06, 0x05,             // SEI
+                 0, 0, 0, 3, 0x41, 0x9A, 0x01,        // P slice
+                 0, 0, 0, 9, 0x01};                   // 长度越界
+    std::vector<NalUnit> nals;
+    ASSERT_EQ(split_nal_units(pkt.data(), pkt.size(), nals), 2u);
+    ASSERT_EQ(static_cast<int>(nals[1].data[0]), 0x41);
+    ASSERT_EQ(nals[1].size, 3u);
+}
+
+// 3. H.264 slice
+TEST(h264_nonref_slices) {
+    NonRefPacketFilter f(NalCodec::H264);
+    ASSERT_FALSE(droppable(f, annexb({h264_nal(3, 7), h264_nal(3, 8), h264_nal(3, 5)})));  // IDR
+    ASSERT_FALSE(droppable(f, annexb({h264_nal(2, 1)})));                               // 参考 P
+    ASSERT_TRUE(droppable(f, annexb({h264_nal(0, 1)})));                                // 非参考 B
+    ASSERT_TRUE(droppable(f, annexb({h264_nal(0, 6), h264_nal(0, 1)})));                // SEI + B
+    // 多 slice: 任一 slice 为参考即不可丢弃
+    ASSERT_FALSE(droppable(f, annexb({h264_nal(0, 1), h264_nal(2, 1)})));
+}
+
+// 4. 无 VCL NAL
+TEST(h264_parameter_sets_kept) {
+    NonRefPacketFilter f(NalCodec::H264);
+    ASSERT_FALSE(droppable(f, annexb({h264_nal(0, 6)})));
+    ASSERT_FALSE(droppable(f, annexb({h264_nal(3, 7), h264_nal(3, 8)})));
+    ASSERT_FALSE(droppable(f, Bytes{}));
+}
+
+// 5. H.265 类型
+TEST(h265_nonref_types) {
+    NonRefPacketFilter f(NalCodec::H265);
+    ASSERT_FALSE(droppable(f, annexb({h265_nal(32), h265_nal(33), h265_nal(34), h265_nal(19)})));  // VPS/SPS/PPS + IDR_W_RADL
+    ASSERT_FALSE(droppable(f, annexb({h265_nal(1)})));     // TRAIL_R
+    ASSERT_TRUE(droppable(f, annexb({h265_nal(0)})));      // TRAIL_N
+    ASSERT_TRUE(droppable(f, annexb({h265_nal(8)})));      // RASL_N
+    ASSERT_FALSE(droppable(f, annexb({h265_nal(9)})));     // RASL_R
+    ASSERT_FALSE(droppable(f, annexb({h265_nal(39)})));    // 只有 SEI
+}
+
+// 6. H.265 时域分层
+TEST(h265_temporal_layers) {
+    NonRefPacketFilter f(NalCodec::H265);
+    ASSERT_TRUE(droppable(f, annexb({h265_nal(0, 0)})));
+    ASSERT_TRUE(droppable(f, annexb({h265_nal(0, 1)})));   // 出现 TemporalId = 1
+    // TemporalId = 0 的 _N 帧可能被更高层参考, 不再丢弃
+    ASSERT_FALSE(droppable(f, annexb({h265_nal(0, 0)})));
+    ASSERT_TRUE(droppable(f, annexb({h265_nal(2, 1)})));   // TSA_N @ 最高层
+
+    f.reset();
+    ASSERT_TRUE(droppable(f, annexb({h265_nal(0, 0)})));
+}
+
+// ============================================================
+// 主函数
+// ============================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "  NAL Parser Unit Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+    for (auto& tc : g_tests) {
+        std::cout << "[RUN ] " << tc.name << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            tc.func();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[PASS] " << tc.name << " (" << ms << "ms)" << std::endl;
+            g_pass++;
+        } catch (const std::exception& e) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[FAIL] " << tc.name << " (" << ms << "ms)" << std::endl;
+            std::cout << "       " << e.what() << std::endl;
+            g_fail++;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Results: " << g_pass << " passed, " << g_fail << " failed"
+              << " (total " << (g_pass + g_fail) << ")" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return g_fail > 0 ? 1 : 0;
+}
@@ -0,0 +1,278 @@
+/**
+ * @file test_object_tracker.cpp
+ * @brief ObjectTracker 目标跟踪测试 (纯 CPU, 不需要硬件)
+ *
+ * 测试内容:
+ *   1. 匀速运动目标保持同一 track_id, 不同目标 ID 不同
+ *   2. 只在同类别之间关联
+ *   3. 低分检测只续接已有轨迹, 不新建轨迹
+ *   4. predict 按速度外推, 裁剪到帧内, 超过 max_age_ms 的轨迹删除
+ *   5. 乱序到达的旧帧只分配 ID, 不修改轨迹
+ *   6. StreamTrackers::apply 跳过外推结果与转发结果
+ *
+ * 编译: cmake --build build --target test_object_tracker
+ * 运行: ./build/tests/test_object_tracker
+ */
+
+#include "infer_server/inference/object_tracker.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <cmath>
+
+// ============================================================
+// 简易测试框架 (同 test_bounded_queue)
+// ============================================================
+
+struct TestCase {
+    std::string name;
+    std::function<void()> func;
+};
+
+static std::vector<TestCase> g_tests;
+static int g_pass = 0;
+static int g_fail = 0;
+
+#define ASSERT_TRUE(cond)                                                      \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_TRUE failed: ") + #cond +                  \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_FALSE(cond) ASSERT_TRUE(!(cond))
+
+#define ASSERT_EQ(a, b)                                                        \
+    do {                                                                        \
+        auto _a = (a); auto _b = (b);                                          \
+        if (_a != _b) {                                                         \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_EQ failed: ") + #a + "=" +                 \
+                std::to_string(_a) + " != " + #b + "=" +                       \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_NEAR(a, b, eps)                                                 \
+    do {                                                                        \
+        double _a = (a); double _b = (b);                                      \
+        if (std::fabs(_a - _b) > (eps)) {                                       \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_NEAR failed: ") + #a + "=" +              \
+                std::to_string(_a) + " vs " + #b + "=" +                     \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define TEST(test_name)                                                        \
+    static void test_fn_##test_name();                                         \
+    static bool _reg_##test_name = [] {                                        \
+        g_tests.push_back({#test_name, test_fn_##test_name});                  \
+        return true;                                                            \
+    }();                                                                        \
+    static void test_fn_##test_name()
+
+// ============================================================
+// 测试用例
+// ============================================================
+
+using infer_server::BBox;
+using infer_server::Detection;
+using infer_server::FrameResult;
+using infer_server::ModelResult;
+using infer_server::ObjectTracker;
+using infer_server::StreamTrackers;
+
+static Detection make_det(float x1, float y1, float x2, float y2, float conf = 0.9f, int class_id = 0) {
+    Detection d;
+    d.class_id = class_id;
+    d.class_name = "cls" + std::to_string(class_id);
+    d.confidence = conf;
+    d.bbox = BBox{x1, y1, x2, y2};
+    return d;
+}
+
+// 1. 匀速运动
+TEST(constant_motion_keeps_ids) {
+    ObjectTracker tracker(ObjectTracker::Options{});
+    int id_a = -1, id_b = -1;
+    // 目标 A 每 100ms 右移 10px, 目标 B 静止
+    for (int i = 0; i < 10; i++) {
+        float dx = 10.0f * i;
+        auto out = tracker.update({make_det(100 + dx, 100, 200 + dx, 300),
+                                   make_det(600, 100, 700, 300)}, i * 100);
+        ASSERT_EQ(out.size(), 2u);
+        if (i == 0) {
+            id_a = out[0].track_id;
+            id_b = out[1].track_id;
+            ASSERT_TRUE(id_a > 0 && id_b > 0 && id_a != id_b);
+        }
+        ASSERT_EQ(out[0].track_id, id_a);
+        ASSERT_EQ(out[1].track_id, id_b);
+    }
+    ASSERT_EQ(tracker.track_count(), 2u);
+}
+
+// 2. 类别不同不关联
+TEST(class_must_match) {
+    ObjectTracker tracker(ObjectTracker::Options{});
+    auto first = tracker.update({make_det(0, 0, 100, 100, 0.9f, 0)}, 0);
+    auto second = tracker.update({make_det(0, 0, 100, 100, 0.9f, 1)}, 100);
+    ASSERT_TRUE(second[0].track_id > 0);
+    ASSERT_TRUE(second[0].track_id != first[0].track_id);
+    ASSERT_EQ(tracker.track_count(), 2u);
+}
+
+// 3. 低分检测
+TEST(low_score_extends_but_never_creates) {
+    ObjectTracker::Options opts;
+    opts.high_threshold = 0.5f;
+    ObjectTracker tracker(opts);
+
+    auto out = tracker.update({make_det(0, 0, 100, 100, 0.3f)}, 0);
+    ASSERT_EQ(out[0].track_id, -1);                 // 没有轨迹可续接: 原样输出
+    ASSERT_EQ(tracker.track_count(), 0u);
+
+    int id = tracker.update({make_det(0, 0, 100, 100, 0.8f)}, 100)[0].track_id;
+    ASSERT_TRUE(id > 0);
+    // 遮挡导致置信度下降: 仍续接同一轨迹
+    out = tracker.update({make_det(5, 0, 105, 100, 0.3f)}, 200);
+    ASSERT_EQ(out[0].track_id, id);
+    ASSERT_EQ(tracker.track_count(), 1u);
+}
+
+// 4. 外推与过期
+TEST(predict_extrapolates_and_expires) {
+    ObjectTracker::Options opts;
+    opts.max_age_ms = 500;
+    ObjectTracker tracker(opts);
+
+    // 每 100ms 右移 20px
+    for (int i = 0; i < 5; i++) {
+        tracker.update({make_det(100 + 20.0f * i, 100, 200 + 20.0f * i, 200)}, i * 100);
+    }
+    // 最后一次: x1 = 180; 再过 200ms 应在 x1 ≈ 220
+    auto pred = tracker.predict(600);
+    ASSERT_EQ(pred.size(), 1u);
+    ASSERT_NEAR(pred[0].bbox.x1, 220.0, 2.0);
+    ASSERT_NEAR(pred[0].bbox.x2, 320.0, 2.0);
+    ASSERT_NEAR(pred[0].bbox.y1, 100.0, 1.0);
+    ASSERT_TRUE(pred[0].track_id > 0);
+    ASSERT_NEAR(pred[0].confidence, 0.9, 1e-6);
+    ASSERT_EQ(tracker.track_count(), 1u);          // predict 不修改状态
+
+    // 裁剪到帧内; 完全移出画面时不输出
+    pred = tracker.predict(600, 300, 300);
+    ASSERT_EQ(pred.size(), 1u);
+    ASSERT_NEAR(pred[0].bbox.x2, 300.0, 1e-6);
+    ASSERT_TRUE(tracker.predict(900, 200, 300).empty());
+
+    // 超过 max_age_ms: 不再外推, 下次更新时删除
+    ASSERT_TRUE(tracker.predict(1000).empty());
+    tracker.update({}, 1000);
+    ASSERT_EQ(tracker.track_count(), 0u);
+}
+
+// 5. 乱序旧帧
+TEST(stale_update_only_assigns_ids) {
+    ObjectTracker tracker(ObjectTracker::Options{});
+    int id = tracker.update({make_det(0, 0, 100, 100)}, 1000)[0].track_id;
+    tracker.update({make_det(10, 0, 110, 100)}, 1100);
+
+    // 时间戳更早的结果: 能关联的分配 ID, 新目标不建轨迹
+    auto out = tracker.update({make_det(5, 0, 105, 100), make_det(500, 500, 600, 600)}, 1050);
+    ASSERT_EQ(out[0].track_id, id);
+    ASSERT_EQ(out[1].track_id, -1);
+    ASSERT_EQ(tracker.track_count(), 1u);
+
+    // 轨迹状态仍以 1100ms 的观测为准
+    auto pred = tracker.predict(1100);
+    ASSERT_EQ(pred.size(), 1u);
+    ASSERT_NEAR(pred[0].bbox.x1, 10.0, 1e-3);
+}
+
+// 6. StreamTrackers
+TEST(stream_trackers_apply) {
+    StreamTrackers trackers;
+    trackers.add("person", ObjectTracker::Options{});
+    ASSERT_TRUE(trackers.find("person") != nullptr);
+    ASSERT_TRUE(trackers.find("helmet") == nullptr);
+
+    FrameResult frame;
+    frame.timestamp_ms = 0;
+    ModelResult person;
+    person.task_name = "person";
+    person.detections = {make_det(0, 0, 100, 100)};
+    ModelResult helmet;
+    helmet.task_name = "helmet";
+    helmet.detections = {make_det(0, 0, 50, 50)};
+    frame.results = {person, helmet};
+
+    trackers.apply(frame);
+    int id = frame.results[0].detections[0].track_id;
+    ASSERT_TRUE(id > 0);
+    ASSERT_EQ(frame.results[1].detections[0].track_id, -1);   // 未开启跟踪的模型不变
+
+    // 外推结果 / 转发结果不再更新轨迹
+    FrameResult predicted;
+    predicted.timestamp_ms = 100;
+    ModelResult pr;
+    pr.task_name = "person";
+    pr.predicted = true;
+    pr.detections = trackers.find("person")->predict(100);
+    predicted.results = {pr};
+    trackers.apply(predicted);
+    ASSERT_EQ(predicted.results[0].detections[0].track_id, id);
+
+    FrameResult repeated = frame;
+    repeated.repeated = true;
+    repeated.timestamp_ms = 200;
+    repeated.results[0].detections[0].track_id = -1;
+    trackers.apply(repeated);
+    ASSERT_EQ(repeated.results[0].detections[0].track_id, -1);
+    ASSERT_EQ(trackers.find("person")->track_count(), 1u);
+}
+
+// ============================================================
+// 主函数
+// ============================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "  ObjectTracker Unit Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    for (auto& tc : g_tests) {
+        std::cout << "[RUN ] " << tc.name << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            tc.func();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[PASS] " << tc.name << " (" << ms << "ms)" << std::endl;
+            g_pass++;
+        } catch (const std::exception& e) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[FAIL] " << tc.name << " (" << ms << "ms)" << std::endl;
+            std::cout << "       " << e.what() << std::endl;
+            g_fail++;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Results: " << g_pass << " passed, " << g_fail << " failed"
+              << " (total " << (g_pass + g_fail) << ")" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return g_fail > 0 ? 1 : 0;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file test_packet_ring.cpp
+ * @brief PacketRing 码流环形缓冲测试 (纯内存, 不需要 FFmpeg)
+ *
+ * 测试内容:
+ *   1. 首个关键帧之前的包被丢弃
+ *   2. 按时长淘汰 (整 GOP 淘汰, 首包始终为关键帧)
+ *   3. 按内存上限淘汰
+ *   4. 片段起点对齐到关键帧
+ *   5. 窗口越界 / 无交集
+ *   6. reset 清空并更新码流参数
+ *
+ * 编译: cmake --build build --target test_packet_ring
+ * 运行: ./build/tests/test_packet_ring
+ */
+
+#include "infer_server/cache/packet_ring.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <stdexcept>
+
+// ============================================================
+// 简易测试框架 (同 test_bounded_queue)
+// ============================================================
+
+struct TestCase {
+    std::string name;
+    std::function<void()> func;
+};
+
+static std::vector<TestCase> g_tests;
+static int g_pass = 0;
+static int g_fail = 0;
+
+#define ASSERT_TRUE(cond)                                                      \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_TRUE failed: ") + #cond +                  \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_FALSE(cond) ASSERT_TRUE(!(cond))
+
+#define ASSERT_EQ(a, b)                                                        \
+    do {                                                                        \
+        auto _a = (a); auto _b = (b);                                          \
+        if (_a != _b) {                                                         \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_EQ failed: ") + #a + "=" +                 \
+                std::to_string(_a) + " != " + #b + "=" +                       \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define TEST(test_name)                                                        \
+    static void test_fn_##test_name();                                         \
+    static bool _reg_##test_name = [] {                                        \
+        g_tests.push_back({#test_name, test_fn_##test_name});                  \
+        return true;                                                            \
+    }();                                                                        \
+    static void test_fn_##test_name()
+
+using infer_server::PacketRing;
+using infer_server::ClipPacket;
+using infer_server::ClipCodecInfo;
+
+/// 合成包: 25fps (40ms), time_base = 1/1000
+static ClipPacket make_packet(int64_t ts_ms, bool key, size_t size = 1000) {
+    ClipPacket p;
+    p.data = std::make_shared<std::vector<uint8_t>>(size, key ? 0x65 : 0x41);
+    p.pts = ts_ms;
+    p.dts = ts_ms;
+    p.duration = 40;
+    p.timestamp_ms = ts_ms;
+    p.keyframe = key;
+    return p;
+}
+
+/// 写入 num_frames 帧, 每 gop 帧一个关键帧
+static void fill(PacketRing& ring, int num_frames, int gop, int64_t start_ms = 0, size_t size = 1000) {
+    for (int i = 0; i < num_frames; i++) {
+        ring.push(make_packet(start_ms + i * 40, i % gop == 0, size));
+    }
+}
+
+// ============================================================
+// 测试用例
+// ============================================================
+
+// 1. 首个关键帧之前的包被丢弃
+TEST(drop_until_keyframe) {
+    PacketRing ring(10, 0);
+    ring.push(make_packet(0, false));
+    ring.push(make_packet(40, false));
+    ASSERT_EQ(ring.packet_count(), 0u);
+
+    ring.push(make_packet(80, true));
+    ring.push(make_packet(120, false));
+    ASSERT_EQ(ring.packet_count(), 2u);
+    ASSERT_EQ(ring.keyframe_count(), 1u);
+    ASSERT_EQ(ring.memory_bytes(), 2000u);
+}
+
+// 2. 按时长淘汰
+TEST(evict_by_duration) {
+    PacketRing ring(2, 0);  // 保留 2 秒
+    fill(ring, 250, 25);    // 10 秒, GOP = 1 秒
+
+    int64_t dur = ring.duration_ms();
+    std::cout << "    Retained: " << ring.packet_count() << " packets, "
+              << dur << " ms, " << ring.keyframe_count() << " GOPs" << std::endl;
+    ASSERT_TRUE(dur >= 2000);
+    ASSERT_TRUE(dur < 3000);  // 最多多保留一个 GOP
+
+    // 首包始终为关键帧
+    auto clip = ring.get_clip(0, INT64_MAX);
+    ASSERT_TRUE(clip.has_value());
+    ASSERT_TRUE(clip->packets.front().keyframe);
+    ASSERT_EQ(clip->packets.size(), ring.packet_count());
+}
+
+// 3. 按内存上限淘汰
+TEST(evict_by_memory) {
+    PacketRing ring(60, 30 * 1000);  // 30 包的内存
+    fill(ring, 200, 10);
+
+    ASSERT_TRUE(ring.memory_bytes() <= 30u * 1000);
+    ASSERT_TRUE(ring.keyframe_count() >= 1u);
+
+    auto clip = ring.get_clip(0, INT64_MAX);
+    ASSERT_TRUE(clip.has_value());
+    ASSERT_TRUE(clip->packets.front().keyframe);
+    ASSERT_EQ(clip->packets.back().timestamp_ms, 199 * 40);
+
+    // 单个 GOP 超过上限: 整体丢弃, 等待下一个关键帧
+    PacketRing tiny(60, 5 * 1000);
+    fill(tiny, 8, 100);
+    ASSERT_EQ(tiny.packet_count(), 0u);
+    tiny.push(make_packet(1000, false));
+    ASSERT_EQ(tiny.packet_count(), 0u);
+    tiny.push(make_packet(1040, true));
+    ASSERT_EQ(tiny.packet_count(), 1u);
+}
+
+// 4. 片段起点对齐到关键帧
+TEST(clip_aligns_to_keyframe) {
+    PacketRing ring(60, 0);
+    fill(ring, 100, 25);  // 关键帧: 0, 1000, 2000, 3000 ms
+
+    auto clip = ring.get_clip(1500, 2500);
+    ASSERT_TRUE(clip.has_value());
+    ASSERT_EQ(clip->start_ms, 1000);
+    ASSERT_EQ(clip->end_ms, 2480);
+    ASSERT_TRUE(clip->packets.front().keyframe);
+    ASSERT_EQ(clip->packets.size(), 38u);  // 1000 ~ 2480 ms
+
+    // 起点正好落在关键帧
+    clip = ring.get_clip(2000, 2000);
+    ASSERT_TRUE(clip.has_value());
+    ASSERT_EQ(clip->start_ms, 2000);
+    ASSERT_EQ(clip->packets.size(), 1u);
+
+    // 片段共享包数据, 不拷贝码流
+    ASSERT_TRUE(clip->packets.front().data.use_count() >= 2);
+}
+
+// 5. 窗口越界 / 无交集
+TEST(clip_window_bounds) {
+    PacketRing ring(60, 0);
+    ASSERT_FALSE(ring.get_clip(0, 1000).has_value());  // 空
+
+    fill(ring, 50, 25, 10000);  // 10000 ~ 11960 ms
+
+    ASSERT_FALSE(ring.get_clip(0, 5000).has_value());      // 早于缓冲区
+    ASSERT_FALSE(ring.get_clip(20000, 30000).has_value()); // 晚于缓冲区
+    ASSERT_FALSE(ring.get_clip(11000, 10000).has_value()); // 反向窗口
+
+    // 起点早于缓冲区: 从最旧关键帧开始
+    auto clip = ring.get_clip(5000, 10500);
+    ASSERT_TRUE(clip.has_value());
+    ASSERT_EQ(clip->start_ms, 10000);
+    ASSERT_EQ(clip->end_ms, 10480);
+
+    // 终点晚于缓冲区: 截止到最新包
+    clip = ring.get_clip(11500, 99999);
+    ASSERT_TRUE(clip.has_value());
+    ASSERT_EQ(clip->start_ms, 11000);
+    ASSERT_EQ(clip->end_ms, 11960);
+}
+
+// 6. reset 清空并更新码流参数
+TEST(reset_updates_codec) {
+    PacketRing ring(60, 0);
+    ClipCodecInfo info;
+    info.codec_id = 27;
+    info.width = 1920;
+    info.height = 1080;
+    info.extradata = {0x00, 0x00, 0x00, 0x01, 0x67};
+    ring.reset(info);
+    fill(ring, 30, 25);
+    ASSERT_EQ(ring.packet_count(), 30u);
+
+    auto clip = ring.get_clip(0, 1000);
+    ASSERT_TRUE(clip.has_value());
+    ASSERT_EQ(clip->codec.codec_id, 27);
+    ASSERT_EQ(clip->codec.width, 1920);
+    ASSERT_EQ(clip->codec.extradata.size(), 5u);
+
+    // 重连: 时间戳从 0 重新开始
+    info.width = 1280;
+    ring.reset(info);
+    ASSERT_EQ(ring.packet_count(), 0u);
+    ASSERT_EQ(ring.memory_bytes(), 0u);
+    fill(ring, 10, 25);
+    clip = ring.get_clip(0, 1000);
+    ASSERT_TRUE(clip.has_value());
+    ASSERT_EQ(clip->codec.width, 1280);
+    ASSERT_EQ(clip->packets.size(), 10u);
+
+    ring.clear();
+    ASSERT_EQ(ring.packet_count(), 0u);
+    ASSERT_EQ(ring.duration_ms(), 0);
+}
+
+// ============================================================
+// 测试运行器
+// ============================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "  PacketRing Unit Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+    for (auto& tc : g_tests) {
+        std::cout << "[RUN ] " << tc.name << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            tc.func();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[PASS] " << tc.name << " (" << ms << "ms)" << std::endl;
+            g_pass++;
+        } catch (const std::exception& e) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[FAIL] " << tc.name << " (" << ms << "ms)" << std::endl;
+            std::cout << "       " << e.what() << std::endl;
+            g_fail++;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Results: " << g_pass << " passed, " << g_fail << " failed"
+              << " (total " << (g_pass + g_fail) << ")" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return g_fail > 0 ? 1 : 0;
+}
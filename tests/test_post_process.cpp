@@ -6,9 +6,12 @@
  * - NMS 算法正确性
  * - YOLOv5 anchor-based 解码
  * - YOLOv8/v11 anchor-free DFL 解码
- * - 坐标缩放 (letterbox)
+ * - 坐标缩放 (letterbox) 与预处理几何变换 (LetterboxTransform) 反算
  * - INT8 反量化
  * - 统一分发接口
+ * - 快速内核 (PORTABLE / NEON) 与 REFERENCE 等价性 (耗时对比见 bench_post_process)
+ * - INT8 量化域后处理与「反量化 + 浮点参考实现」等价
+ * - 分桶 SoA NMS 与参考 NMS 等价 (拥挤场景耗时见 bench_post_process)
  */
 
 #include "infer_server/inference/post_processor.h"
@@ -19,6 +22,9 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <random>
+#include <chrono>
+#include <functional>
 
 using namespace infer_server;
 
@@ -451,6 +457,684 @@ void test_yolov5_filter_low_conf() {
     PASS();
 }
 
+// ============================================================
+// 快速内核测试辅助
+// ============================================================
+
+/// 当前平台可测试的快速内核
+static std::vector<PostProcessKernel> fast_kernels() {
+    std::vector<PostProcessKernel> kernels = {PostProcessKernel::PORTABLE};
+    if (PostProcessor::best_kernel() == PostProcessKernel::NEON) {
+        kernels.push_back(PostProcessKernel::NEON);
+    }
+    return kernels;
+}
+
+/// 按 (class, x1, y1) 排序, 消除置信度浮点误差造成的顺序差异
+static std::vector<Detection> sorted_dets(std::vector<Detection> dets) {
+    std::sort(dets.begin(), dets.end(), [](const Detection& a, const Detection& b) {
+        if (a.class_id != b.class_id) return a.class_id < b.class_id;
+        if (a.bbox.x1 != b.bbox.x1) return a.bbox.x1 < b.bbox.x1;
+        return a.bbox.y1 < b.bbox.y1;
+    });
+    return dets;
+}
+
+/// 比较两组检测结果; 不一致时打印首个差异
+static bool same_dets(const std::vector<Detection>& ref_in,
+                      const std::vector<Detection>& fast_in) {
+    if (ref_in.size() != fast_in.size()) {
+        std::cerr << "  count mismatch: " << ref_in.size() << " vs " << fast_in.size() << std::endl;
+        return false;
+    }
+    auto ref = sorted_dets(ref_in);
+    auto fast = sorted_dets(fast_in);
+    for (size_t i = 0; i < ref.size(); i++) {
+        const auto& a = ref[i];
+        const auto& b = fast[i];
+        bool ok = a.class_id == b.class_id &&
+                  a.class_name == b.class_name &&
+                  std::abs(a.confidence - b.confidence) <= 1e-5f &&
+                  std::abs(a.bbox.x1 - b.bbox.x1) <= 1e-2f &&
+                  std::abs(a.bbox.y1 - b.bbox.y1) <= 1e-2f &&
+                  std::abs(a.bbox.x2 - b.bbox.x2) <= 1e-2f &&
+                  std::abs(a.bbox.y2 - b.bbox.y2) <= 1e-2f;
+        if (!ok) {
+            std::cerr << "  det " << i << " mismatch: class " << a.class_id << "/" << b.class_id
+                      << " conf " << a.confidence << "/" << b.confidence
+                      << " x1 " << a.bbox.x1 << "/" << b.bbox.x1 << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/// 随机 logit, 量化到 0.25 步长以制造大量相同值 (验证 argmax 取首个最大值)
+static void fill_logits(std::vector<float>& v, std::mt19937& rng, float mean, float stddev) {
+    std::normal_distribution<float> dist(mean, stddev);
+    for (auto& x : v) x = std::round(dist(rng) * 4.0f) / 4.0f;
+}
+
+struct SyntheticModel {
+    std::vector<std::vector<float>> heads;
+    std::vector<TensorAttr> attrs;
+
+    std::vector<float*> outputs() {
+        std::vector<float*> out;
+        for (auto& h : heads) out.push_back(h.data());
+        return out;
+    }
+};
+
+static SyntheticModel make_yolov5(int num_classes, uint32_t seed) {
+    std::mt19937 rng(seed);
+    SyntheticModel m;
+    int channel = 3 * (5 + num_classes);
+    for (int grid : {80, 40, 20}) {
+        std::vector<float> head(static_cast<size_t>(grid) * grid * channel);
+        fill_logits(head, rng, -5.5f, 2.0f);
+        m.attrs.push_back({static_cast<int>(head.size()), {1, grid, grid, channel}, 0, 1.0f, false});
+        m.heads.push_back(std::move(head));
+    }
+    return m;
+}
+
+static SyntheticModel make_yolov8(int num_classes, uint32_t seed) {
+    std::mt19937 rng(seed);
+    SyntheticModel m;
+    int channel = 64 + num_classes;
+    for (int grid : {80, 40, 20}) {
+        std::vector<float> head(static_cast<size_t>(grid) * grid * channel);
+        fill_logits(head, rng, -9.0f, 2.0f);
+        m.attrs.push_back({static_cast<int>(head.size()), {1, grid, grid, channel}, 0, 1.0f, false});
+        m.heads.push_back(std::move(head));
+    }
+    return m;
+}
+
+static SyntheticModel make_yolov11(int num_classes, int num_anchors, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> coord(0.0f, 640.0f);
+    std::uniform_real_distribution<float> size(4.0f, 200.0f);
+    std::uniform_real_distribution<float> prob(0.0f, 1.0f);
+
+    SyntheticModel m;
+    int channels = 4 + num_classes;
+    std::vector<float> head(static_cast<size_t>(channels) * num_anchors);
+    for (int i = 0; i < num_anchors; i++) {
+        head[0 * num_anchors + i] = coord(rng);
+        head[1 * num_anchors + i] = coord(rng);
+        head[2 * num_anchors + i] = size(rng);
+        head[3 * num_anchors + i] = size(rng);
+    }
+    // 背景分数量化到 1/16 (大量相同值), 约 2% 的 anchor 有一个高分类别
+    std::uniform_int_distribution<int> cls(0, num_classes - 1);
+    for (int c = 0; c < num_classes; c++) {
+        for (int i = 0; i < num_anchors; i++) {
+            head[static_cast<size_t>(4 + c) * num_anchors + i] =
+                std::round(prob(rng) * 16.0f) / 16.0f * 0.4f;
+        }
+    }
+    for (int i = 0; i < num_anchors; i++) {
+        if (prob(rng) < 0.02f) {
+            head[static_cast<size_t>(4 + cls(rng)) * num_anchors + i] = 0.5f + prob(rng) * 0.5f;
+        }
+    }
+    m.attrs.push_back({static_cast<int>(head.size()), {1, channels, num_anchors}, 0, 1.0f, false});
+    m.heads.push_back(std::move(head));
+    return m;
+}
+
+static std::vector<std::string> make_labels(int n) {
+    std::vector<std::string> labels;
+    for (int i = 0; i < n; i++) labels.push_back("c" + std::to_string(i));
+    return labels;
+}
+
+// ============================================================
+// 测试 11: fast_exp / fast_sigmoid 精度
+// ============================================================
+void test_fast_exp_accuracy() {
+    TEST_CASE("Kernels - fast_exp / fast_sigmoid accuracy");
+
+    float max_rel = 0.0f;
+    for (float x = -80.0f; x <= 80.0f; x += 0.01f) {
+        float ref = std::exp(x);
+        float rel = std::abs(post_kernels::fast_exp(x) - ref) / ref;
+        max_rel = std::max(max_rel, rel);
+    }
+    std::cout << "  max relative error (exp): " << max_rel << std::endl;
+    ASSERT_TRUE(max_rel < 1e-6f);
+
+    float max_abs = 0.0f;
+    for (float x = -20.0f; x <= 20.0f; x += 0.001f) {
+        float ref = 1.0f / (1.0f + std::exp(-x));
+        max_abs = std::max(max_abs, std::abs(post_kernels::fast_sigmoid(x) - ref));
+    }
+    std::cout << "  max absolute error (sigmoid): " << max_abs << std::endl;
+    ASSERT_TRUE(max_abs < 1e-6f);
+
+    // 极值不溢出
+    ASSERT_TRUE(std::isfinite(post_kernels::fast_exp(1000.0f)));
+    ASSERT_TRUE(post_kernels::fast_exp(-1000.0f) >= 0.0f);
+    ASSERT_NEAR(post_kernels::fast_sigmoid(-1000.0f), 0.0f, 1e-6f);
+    ASSERT_NEAR(post_kernels::fast_sigmoid(1000.0f), 1.0f, 1e-6f);
+
+    // logit 阈值: 超出 (0, 1) 时不预过滤
+    ASSERT_NEAR(post_kernels::sigmoid_threshold_logit(0.5f), 0.0f, 1e-6f);
+    ASSERT_TRUE(post_kernels::sigmoid_threshold_logit(0.0f) < -1e30f);
+    ASSERT_TRUE(post_kernels::sigmoid_threshold_logit(1.0f) < -1e30f);
+
+    PASS();
+}
+
+// ============================================================
+// 测试 12: argmax / column_argmax / dfl16 内核
+// ============================================================
+void test_kernel_primitives() {
+    TEST_CASE("Kernels - argmax first occurrence, column argmax, DFL");
+
+    for (auto k : fast_kernels()) {
+        const auto& kt = post_kernels::table(k);
+        std::cout << "  kernel: " << post_kernel_name(k) << std::endl;
+
+        // 相同最大值取最小下标 (跨 lane 与尾部)
+        for (int n : {1, 3, 4, 7, 8, 9, 80, 83}) {
+            for (int pos = 0; pos < n; pos++) {
+                std::vector<float> v(n, 0.0f);
+                v[pos] = 2.0f;
+                for (int j = pos + 1; j < n; j++) {
+                    if ((j - pos) % 3 == 0) v[j] = 2.0f;
+                }
+                int idx = -1;
+                float best = kt.argmax(v.data(), n, &idx);
+                ASSERT_EQ(idx, pos);
+                ASSERT_NEAR(best, 2.0f, 0.0f);
+            }
+        }
+
+        // 全部为负数
+        std::vector<float> neg = {-5.0f, -3.0f, -4.0f, -3.0f, -9.0f, -7.0f, -8.0f, -6.0f, -3.0f};
+        int idx = -1;
+        ASSERT_NEAR(kt.argmax(neg.data(), static_cast<int>(neg.size()), &idx), -3.0f, 0.0f);
+        ASSERT_EQ(idx, 1);
+
+        // column_argmax 与逐列扫描一致 (count 非 4 的倍数)
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> q(0, 7);
+        int rows = 13, count = 37, stride = 41;
+        std::vector<float> data(static_cast<size_t>(rows) * stride);
+        for (auto& x : data) x = static_cast<float>(q(rng)) / 8.0f;
+        std::vector<float> best(count, -1.0f);
+        std::vector<int> index(count, -1);
+        kt.column_argmax(data.data(), rows, stride, count, best.data(), index.data());
+        for (int j = 0; j < count; j++) {
+            float b = -1.0f;
+            int bi = -1;
+            for (int c = 0; c < rows; c++) {
+                if (data[c * stride + j] > b) { b = data[c * stride + j]; bi = c; }
+            }
+            ASSERT_EQ(index[j], bi);
+            ASSERT_NEAR(best[j], b, 0.0f);
+        }
+
+        // DFL: 与标准 softmax 加权和一致
+        std::normal_distribution<float> dist(0.0f, 3.0f);
+        for (int t = 0; t < 100; t++) {
+            float bins[16];
+            float max_val = -1e30f;
+            for (auto& x : bins) { x = dist(rng); max_val = std::max(max_val, x); }
+            double sum = 0.0, weighted = 0.0;
+            for (int i = 0; i < 16; i++) {
+                double e = std::exp(static_cast<double>(bins[i] - max_val));
+                sum += e;
+                weighted += e * i;
+            }
+            ASSERT_NEAR(kt.dfl16(bins), static_cast<float>(weighted / sum), 1e-4f);
+        }
+    }
+
+    PASS();
+}
+
+// ============================================================
+// 测试 13: YOLOv5 / YOLOv8 快速路径与参考实现等价
+// ============================================================
+void test_fast_kernels_match_reference_grid() {
+    TEST_CASE("Kernels - YOLOv5 / YOLOv8 fast path matches reference");
+
+    auto labels = make_labels(80);
+    for (uint32_t seed : {1u, 2u, 3u}) {
+        auto v5 = make_yolov5(80, seed);
+        auto v8 = make_yolov8(80, seed);
+
+        PostProcessor::set_kernel(PostProcessKernel::REFERENCE);
+        auto ref5 = PostProcessor::yolov5(v5.outputs(), v5.attrs, 640, 640, 1920, 1080,
+                                          0.25f, 0.45f, labels);
+        auto ref8 = PostProcessor::yolov8(v8.outputs(), v8.attrs, 640, 640, 1920, 1080,
+                                          0.25f, 0.45f, labels);
+        ASSERT_TRUE(!ref5.empty());
+        ASSERT_TRUE(!ref8.empty());
+
+        for (auto k : fast_kernels()) {
+            PostProcessor::set_kernel(k);
+            auto fast5 = PostProcessor::yolov5(v5.outputs(), v5.attrs, 640, 640, 1920, 1080,
+                                               0.25f, 0.45f, labels);
+            auto fast8 = PostProcessor::yolov8(v8.outputs(), v8.attrs, 640, 640, 1920, 1080,
+                                               0.25f, 0.45f, labels);
+            std::cout << "  seed " << seed << " " << post_kernel_name(k)
+                      << ": v5 " << ref5.size() << "/" << fast5.size()
+                      << ", v8 " << ref8.size() << "/" << fast8.size() << std::endl;
+            ASSERT_TRUE(same_dets(ref5, fast5));
+            ASSERT_TRUE(same_dets(ref8, fast8));
+        }
+    }
+
+    PostProcessor::set_kernel(PostProcessor::best_kernel());
+    PASS();
+}
+
+// ============================================================
+// 测试 14: YOLOv11 快速路径与参考实现等价
+// ============================================================
+void test_fast_kernels_match_reference_yolov11() {
+    TEST_CASE("Kernels - YOLOv11 fast path matches reference");
+
+    auto labels = make_labels(80);
+    // 8400 = 标准 640 输入; 1001 覆盖非整块 / 非 4 倍数的尾部
+    for (int anchors : {8400, 1001}) {
+        auto m = make_yolov11(80, anchors, static_cast<uint32_t>(anchors));
+
+        PostProcessor::set_kernel(PostProcessKernel::REFERENCE);
+        auto ref = PostProcessor::yolov11(m.outputs(), m.attrs, 640, 640, 1280, 720,
+                                          0.5f, 0.45f, labels);
+        ASSERT_TRUE(!ref.empty());
+
+        for (auto k : fast_kernels()) {
+            PostProcessor::set_kernel(k);
+            auto fast = PostProcessor::yolov11(m.outputs(), m.attrs, 640, 640, 1280, 720,
+                                               0.5f, 0.45f, labels);
+            std::cout << "  anchors " << anchors << " " << post_kernel_name(k)
+                      << ": " << ref.size() << "/" << fast.size() << std::endl;
+            ASSERT_TRUE(same_dets(ref, fast));
+        }
+    }
+
+    PostProcessor::set_kernel(PostProcessor::best_kernel());
+    PASS();
+}
+
+// ============================================================
+// INT8 测试辅助
+// ============================================================
+
+struct QuantizedModel {
+    std::vector<std::vector<int8_t>> heads;
+    std::vector<std::vector<float>> dequantized;
+    std::vector<TensorAttr> attrs;
+
+    std::vector<const int8_t*> outputs() const {
+        std::vector<const int8_t*> out;
+        for (auto& h : heads) out.push_back(h.data());
+        return out;
+    }
+    std::vector<float*> float_outputs() {
+        std::vector<float*> out;
+        for (auto& h : dequantized) out.push_back(h.data());
+        return out;
+    }
+};
+
+/// 按各头的 (zp, scale) 量化浮点模型输出
+static QuantizedModel quantize_model(const SyntheticModel& m,
+                                     const std::vector<std::pair<int32_t, float>>& qparams) {
+    QuantizedModel q;
+    q.attrs = m.attrs;
+    for (size_t h = 0; h < m.heads.size(); h++) {
+        int32_t zp = qparams[h].first;
+        float scale = qparams[h].second;
+        std::vector<int8_t> head(m.heads[h].size());
+        for (size_t i = 0; i < head.size(); i++) {
+            long v = std::lround(m.heads[h][i] / scale) + zp;
+            head[i] = static_cast<int8_t>(std::max(-128L, std::min(127L, v)));
+        }
+        std::vector<float> deq(head.size());
+        PostProcessor::dequantize_int8(head.data(), deq.data(), static_cast<int>(head.size()),
+                                       zp, scale);
+        q.attrs[h].is_int8 = true;
+        q.attrs[h].zp = zp;
+        q.attrs[h].scale = scale;
+        q.heads.push_back(std::move(head));
+        q.dequantized.push_back(std::move(deq));
+    }
+    return q;
+}
+
+// ============================================================
+// 测试 15: 阈值量化
+// ============================================================
+void test_quantize_threshold() {
+    TEST_CASE("INT8 - quantized threshold never rejects passing values");
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> scale_dist(0.001f, 0.2f);
+    std::uniform_int_distribution<int> zp_dist(-128, 127);
+    std::uniform_real_distribution<float> value_dist(-30.0f, 30.0f);
+
+    for (int t = 0; t < 2000; t++) {
+        float scale = scale_dist(rng);
+        int32_t zp = zp_dist(rng);
+        float value = value_dist(rng);
+        int qt = post_kernels::quantize_threshold(value, zp, scale);
+        ASSERT_TRUE(qt >= -128 && qt <= 128);
+        for (int q = -128; q <= 127; q++) {
+            float x = post_kernels::dequantize(static_cast<int8_t>(q), zp, scale);
+            if (x >= value) ASSERT_TRUE(q >= qt);
+        }
+    }
+
+    // 不预过滤 / 全部拒绝
+    ASSERT_EQ(post_kernels::quantize_threshold(-1e30f, 0, 0.1f), -128);
+    ASSERT_EQ(post_kernels::quantize_threshold(1e30f, 0, 0.1f), 128);
+
+    PASS();
+}
+
+// ============================================================
+// 测试 16: INT8 内核
+// ============================================================
+void test_int8_kernel_primitives() {
+    TEST_CASE("INT8 - argmax / column argmax kernels");
+
+    std::mt19937 rng(9);
+    std::uniform_int_distribution<int> q(-128, 127);
+    std::uniform_int_distribution<int> coarse(-2, 2);
+
+    for (auto k : fast_kernels()) {
+        const auto& kt = post_kernels::table(k);
+
+        for (int n : {1, 7, 16, 31, 32, 33, 80, 255, 256, 300}) {
+            for (int trial = 0; trial < 20; trial++) {
+                std::vector<int8_t> v(n);
+                // 少量取值, 制造大量相同值
+                for (auto& x : v) x = static_cast<int8_t>(trial % 2 ? q(rng) : coarse(rng) * 40);
+                int expect_idx = 0;
+                for (int i = 1; i < n; i++) {
+                    if (v[i] > v[expect_idx]) expect_idx = i;
+                }
+                int idx = -1;
+                int8_t best = kt.argmax_i8(v.data(), n, &idx);
+                ASSERT_EQ(idx, expect_idx);
+                ASSERT_EQ(static_cast<int>(best), static_cast<int>(v[expect_idx]));
+            }
+        }
+
+        int rows = 80, count = 53, stride = 61;
+        std::vector<int8_t> data(static_cast<size_t>(rows) * stride);
+        for (auto& x : data) x = static_cast<int8_t>(coarse(rng) * 50);
+        std::vector<int8_t> best(count, -128);
+        std::vector<int> index(count, -1);
+        kt.column_argmax_i8(data.data(), rows, stride, count, best.data(), index.data());
+        for (int j = 0; j < count; j++) {
+            int b = -128, bi = -1;
+            for (int c = 0; c < rows; c++) {
+                if (data[c * stride + j] > b) { b = data[c * stride + j]; bi = c; }
+            }
+            ASSERT_EQ(index[j], bi);
+            ASSERT_EQ(static_cast<int>(best[j]), b);
+        }
+    }
+
+    PASS();
+}
+
+// ============================================================
+// 测试 17: INT8 后处理与反量化 + 参考实现等价
+// ============================================================
+void test_int8_matches_dequantized_reference() {
+    TEST_CASE("INT8 - process_int8 matches dequantize + reference");
+
+    auto labels = make_labels(80);
+    struct Case {
+        std::string type;
+        SyntheticModel model;
+        std::vector<std::pair<int32_t, float>> qparams;
+        float conf;
+    };
+    std::vector<Case> cases;
+    cases.push_back({"yolov5", make_yolov5(80, 21), {{-30, 0.08f}, {-20, 0.075f}, {-25, 0.07f}}, 0.25f});
+    cases.push_back({"yolov8", make_yolov8(80, 22), {{10, 0.09f}, {0, 0.1f}, {-5, 0.085f}}, 0.25f});
+    cases.push_back({"yolov11", make_yolov11(80, 8400, 23), {{-128, 1.0f / 255.0f}}, 0.5f});
+    // 小 scale + zp 贴近上界: 大部分背景分数饱和到 -128
+    cases.push_back({"yolov8", make_yolov8(80, 24), {{127, 0.01f}, {127, 0.01f}, {127, 0.01f}}, 0.25f});
+
+    for (auto& c : cases) {
+        auto q = quantize_model(c.model, c.qparams);
+        ASSERT_TRUE(PostProcessor::supports_int8(c.type, q.attrs));
+
+        PostProcessor::set_kernel(PostProcessKernel::REFERENCE);
+        auto ref = PostProcessor::process(c.type, q.float_outputs(), q.attrs, 640, 640, 1920, 1080,
+                                          c.conf, 0.45f, labels);
+        auto ref_int8 = PostProcessor::process_int8(c.type, q.outputs(), q.attrs, 640, 640,
+                                                    1920, 1080, c.conf, 0.45f, labels);
+        ASSERT_TRUE(same_dets(ref, ref_int8));
+
+        for (auto k : fast_kernels()) {
+            PostProcessor::set_kernel(k);
+            auto fast = PostProcessor::process_int8(c.type, q.outputs(), q.attrs, 640, 640,
+                                                    1920, 1080, c.conf, 0.45f, labels);
+            std::cout << "  " << c.type << " " << post_kernel_name(k) << ": "
+                      << ref.size() << "/" << fast.size() << std::endl;
+            ASSERT_TRUE(same_dets(ref, fast));
+        }
+    }
+
+    // 非 INT8 输出不走 INT8 路径
+    auto fp = make_yolov8(80, 25);
+    ASSERT_TRUE(!PostProcessor::supports_int8("yolov8", fp.attrs));
+    ASSERT_TRUE(!PostProcessor::supports_int8("unknown", quantize_model(fp, {{0, 0.1f}, {0, 0.1f}, {0, 0.1f}}).attrs));
+
+    PostProcessor::set_kernel(PostProcessor::best_kernel());
+    PASS();
+}
+
+// ============================================================
+// NMS 测试辅助: 拥挤场景 (大量相互重叠的同类框)
+// ============================================================
+static std::vector<Detection> make_crowd(int count, int num_classes, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> center(0.0f, 1920.0f);
+    std::uniform_real_distribution<float> jitter(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> size(30.0f, 160.0f);
+    std::uniform_real_distribution<float> conf(0.1f, 1.0f);
+    std::uniform_int_distribution<int> cls(0, num_classes - 1);
+
+    // 每个 "人" 周围有若干候选框, 模拟低阈值下的密集输出
+    std::vector<Detection> dets;
+    while (static_cast<int>(dets.size()) < count) {
+        float cx = center(rng), cy = center(rng) * 0.5625f;
+        float w = size(rng), h = size(rng) * 2.0f;
+        int c = cls(rng);
+        for (int k = 0; k < 8 && static_cast<int>(dets.size()) < count; k++) {
+            Detection d;
+            d.class_id = c;
+            d.class_name = "class_" + std::to_string(c);
+            d.confidence = conf(rng);
+            d.bbox.x1 = cx + jitter(rng) - w / 2;
+            d.bbox.y1 = cy + jitter(rng) - h / 2;
+            d.bbox.x2 = d.bbox.x1 + w + jitter(rng);
+            d.bbox.y2 = d.bbox.y1 + h + jitter(rng);
+            dets.push_back(d);
+        }
+    }
+    return dets;
+}
+
+// ============================================================
+// 测试 18: 分桶 NMS 与参考实现等价
+// ============================================================
+void test_nms_matches_reference() {
+    TEST_CASE("NMS - bucketed SoA NMS matches reference");
+
+    for (uint32_t seed : {41u, 42u, 43u}) {
+        for (int classes : {1, 3, 80}) {
+            for (float thresh : {0.0f, 0.3f, 0.45f, 0.7f}) {
+                auto input = make_crowd(600, classes, seed);
+
+                auto ref = input;
+                PostProcessor::set_kernel(PostProcessKernel::REFERENCE);
+                PostProcessor::nms(ref, thresh);
+
+                for (auto k : fast_kernels()) {
+                    auto fast = input;
+                    PostProcessor::set_kernel(k);
+                    PostProcessor::nms(fast, thresh);
+                    ASSERT_TRUE(same_dets(ref, fast));
+
+                    // 输出保持置信度降序
+                    for (size_t i = 1; i < fast.size(); i++) {
+                        ASSERT_TRUE(fast[i - 1].confidence >= fast[i].confidence);
+                    }
+                }
+            }
+        }
+    }
+
+    PostProcessor::set_kernel(PostProcessor::best_kernel());
+    PASS();
+}
+
+// ============================================================
+// 测试 19: 预处理几何变换 (letterbox / stretch)
+// ============================================================
+void test_letterbox_transform() {
+    TEST_CASE("LetterboxTransform - content rect and unmap");
+
+    // 1920x1080 -> 640x640: 图像区域 640x360, 上下各填充 140 行
+    auto t = LetterboxTransform::letterbox(1920, 1080, 640, 640);
+    ASSERT_TRUE(t.valid());
+    ASSERT_TRUE(t.has_padding());
+    ASSERT_EQ(t.x, 0);
+    ASSERT_EQ(t.y, 140);
+    ASSERT_EQ(t.w, 640);
+    ASSERT_EQ(t.h, 360);
+
+    // 与 scale_coords 的 letterbox 假设一致: (100,200,300,400) -> (300,180,900,780)
+    BBox box{100.0f, 200.0f, 300.0f, 400.0f};
+    t.unmap(box);
+    ASSERT_NEAR(box.x1, 300.0f, 0.01f);
+    ASSERT_NEAR(box.y1, 180.0f, 0.01f);
+    ASSERT_NEAR(box.x2, 900.0f, 0.01f);
+    ASSERT_NEAR(box.y2, 780.0f, 0.01f);
+
+    // 落在填充区域的坐标裁剪到原图范围
+    BBox pad{0.0f, 10.0f, 640.0f, 630.0f};
+    t.unmap(pad);
+    ASSERT_NEAR(pad.y1, 0.0f, 0.01f);
+    ASSERT_NEAR(pad.y2, 1080.0f, 0.01f);
+
+    // 竖屏 1080x1920 -> 640x640: 宽度 360 (偶数), 左右填充
+    auto p = LetterboxTransform::letterbox(1080, 1920, 640, 640);
+    ASSERT_EQ(p.w, 360);
+    ASSERT_EQ(p.h, 640);
+    ASSERT_EQ(p.x, 140);
+    ASSERT_EQ(p.y, 0);
+
+    // 宽高比不整除时矩形对齐为偶数, 逐轴反算仍然精确: 1000x563 -> 416x416
+    auto odd = LetterboxTransform::letterbox(1000, 563, 416, 416);
+    ASSERT_EQ(odd.w % 2, 0);
+    ASSERT_EQ(odd.h % 2, 0);
+    ASSERT_EQ(odd.x % 2, 0);
+    ASSERT_EQ(odd.y % 2, 0);
+    BBox edge{static_cast<float>(odd.x), static_cast<float>(odd.y),
+              static_cast<float>(odd.x + odd.w), static_cast<float>(odd.y + odd.h)};
+    odd.unmap(edge);
+    ASSERT_NEAR(edge.x1, 0.0f, 0.01f);
+    ASSERT_NEAR(edge.y1, 0.0f, 0.01f);
+    ASSERT_NEAR(edge.x2, 1000.0f, 0.01f);
+    ASSERT_NEAR(edge.y2, 563.0f, 0.01f);
+
+    // stretch: 无填充, 各轴独立缩放
+    auto s = LetterboxTransform::stretch(1920, 1080, 640, 640);
+    ASSERT_TRUE(!s.has_padding());
+    BBox sb{320.0f, 320.0f, 640.0f, 640.0f};
+    s.unmap(sb);
+    ASSERT_NEAR(sb.x1, 960.0f, 0.01f);
+    ASSERT_NEAR(sb.y1, 540.0f, 0.01f);
+    ASSERT_NEAR(sb.x2, 1920.0f, 0.01f);
+    ASSERT_NEAR(sb.y2, 1080.0f, 0.01f);
+
+    // ROI 裁剪: 区域 (960, 540) 起的 960x540 -> 640x640, 坐标平移回整帧
+    auto roi = LetterboxTransform::letterbox(960, 540, 640, 640);
+    roi.src_x = 960;
+    roi.src_y = 540;
+    BBox rb{0.0f, static_cast<float>(roi.y), 640.0f, static_cast<float>(roi.y + roi.h)};
+    roi.unmap(rb);
+    ASSERT_NEAR(rb.x1, 960.0f, 0.01f);
+    ASSERT_NEAR(rb.y1, 540.0f, 0.01f);
+    ASSERT_NEAR(rb.x2, 1920.0f, 0.01f);
+    ASSERT_NEAR(rb.y2, 1080.0f, 0.01f);
+
+    // 无效尺寸
+    ASSERT_TRUE(!LetterboxTransform::letterbox(0, 1080, 640, 640).valid());
+
+    PASS();
+}
+
+// ============================================================
+// 测试 20: 按变换后处理与 letterbox 假设的结果一致
+// ============================================================
+void test_process_with_transform() {
+    TEST_CASE("process(transform) - matches scale_coords for centered letterbox");
+
+    int model_w = 640, model_h = 640;
+    int num_classes = 2, reg_max = 16;
+    int channel = 4 * reg_max + num_classes;
+
+    std::vector<float> head0(80 * 80 * channel, -10.0f);
+    std::vector<float> head1(40 * 40 * channel, -10.0f);
+    std::vector<float> head2(20 * 20 * channel, -10.0f);
+    int offset = (40 * 80 + 40) * channel;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < reg_max; j++) {
+            head0[offset + i * reg_max + j] = (j == 5) ? 10.0f : 0.0f;
+        }
+    }
+    head0[offset + 4 * reg_max + 1] = logit(0.92f);
+
+    std::vector<float*> outputs = {head0.data(), head1.data(), head2.data()};
+    std::vector<TensorAttr> attrs = {
+        {static_cast<int>(head0.size()), {1, 80, 80, channel}, 0, 1.0f, false},
+        {static_cast<int>(head1.size()), {1, 40, 40, channel}, 0, 1.0f, false},
+        {static_cast<int>(head2.size()), {1, 20, 20, channel}, 0, 1.0f, false},
+    };
+    std::vector<std::string> labels = {"cat", "dog"};
+
+    auto legacy = PostProcessor::process("yolov8", outputs, attrs, model_w, model_h,
+                                         1920, 1080, 0.5f, 0.45f, labels);
+    auto t = LetterboxTransform::letterbox(1920, 1080, model_w, model_h);
+    auto exact = PostProcessor::process("yolov8", outputs, attrs, t, 0.5f, 0.45f, labels);
+
+    ASSERT_EQ(legacy.size(), 1u);
+    ASSERT_EQ(exact.size(), 1u);
+    ASSERT_TRUE(exact[0].class_name == "dog");
+    ASSERT_NEAR(exact[0].bbox.x1, legacy[0].bbox.x1, 0.01f);
+    ASSERT_NEAR(exact[0].bbox.y1, legacy[0].bbox.y1, 0.01f);
+    ASSERT_NEAR(exact[0].bbox.x2, legacy[0].bbox.x2, 0.01f);
+    ASSERT_NEAR(exact[0].bbox.y2, legacy[0].bbox.y2, 0.01f);
+
+    // stretch 预处理: 同一模型输出映射到不同的原图位置
+    // 模型坐标 (284, 284, 364, 364) -> x *3, y *1.6875
+    auto s = LetterboxTransform::stretch(1920, 1080, model_w, model_h);
+    auto stretched = PostProcessor::process("yolov8", outputs, attrs, s, 0.5f, 0.45f, labels);
+    ASSERT_EQ(stretched.size(), 1u);
+    ASSERT_NEAR(stretched[0].bbox.x1, 284.0f * 3.0f, 6.0f);
+    ASSERT_NEAR(stretched[0].bbox.y1, 284.0f * 1.6875f, 4.0f);
+    ASSERT_NEAR(stretched[0].bbox.y2, 364.0f * 1.6875f, 4.0f);
+
+    PASS();
+}
+
 // ============================================================
 // main
 // ============================================================
@@ -469,6 +1153,16 @@ int main() {
     test_yolov8_synthetic();
     test_scale_coords_letterbox();
     test_process_dispatch();
+    test_fast_exp_accuracy();
+    test_kernel_primitives();
+    test_fast_kernels_match_reference_grid();
+    test_fast_kernels_match_reference_yolov11();
+    test_quantize_threshold();
+    test_int8_kernel_primitives();
+    test_int8_matches_dequantized_reference();
+    test_nms_matches_reference();
+    test_letterbox_transform();
+    test_process_with_transform();
 
     std::cout << "\n======================================" << std::endl;
     std::cout << "  Results: " << g_tests_passed << " passed, "
@@ -13,6 +13,8 @@
 #include <iostream>
 #include <string>
 #include <thread>
+#include <atomic>
+#include <vector>
 #include <chrono>
 #include <cstdlib>
 
@@ -22,6 +24,7 @@
 #include "infer_server/common/logger.h"
 #include "infer_server/stream/stream_manager.h"
 #include "infer_server/api/rest_server.h"
+#include "infer_server/output/result_broadcaster.h"
 
 #ifdef HAS_TURBOJPEG
 #include "infer_server/cache/image_cache.h"
@@ -63,6 +66,7 @@ int main() {
     infer_server::ServerConfig config;
     config.http_port = TEST_PORT;
     config.streams_save_path = "/tmp/test_rest_api_streams.json";
+    config.http_push_clients = 1;
 
     // 创建组件
 #ifdef HAS_TURBOJPEG
@@ -92,6 +96,9 @@ int main() {
 #endif
         config);
 
+    infer_server::ResultBroadcaster broadcaster;
+    rest->set_result_broadcaster(&broadcaster);
+
     if (!rest->start()) {
         std::cerr << "Failed to start REST server for testing" << std::endl;
         return 1;
@@ -406,8 +413,130 @@ int main() {
         }
     }
 
-    // 清理 cam01
-    stream_mgr->remove_stream("cam01");
+    // ----------------------------------------------------------
+    // Test 21: 状态快照复用 + 并发轮询 (多个请求线程)
+    // ----------------------------------------------------------
+    {
+        std::cout << "\n[Test 21] Status snapshot reuse + concurrent polling" << std::endl;
+        auto a = stream_mgr->status_snapshot();
+        auto b = stream_mgr->status_snapshot();
+        ASSERT_TRUE(a == b);                            // 周期内复用同一快照
+        ASSERT_TRUE(stream_mgr->status_snapshot(0) != a);   // max_age_ms = 0 强制重建
+
+        std::atomic<int> ok_count{0};
+        std::vector<std::thread> pollers;
+        for (int t = 0; t < 8; t++) {
+            pollers.emplace_back([&ok_count] {
+                httplib::Client c("localhost", TEST_PORT);
+                for (int i = 0; i < 20; i++) {
+                    auto res = c.Get(i % 2 ? "/api/streams" : "/api/status");
+                    if (res && res->status == 200) ok_count++;
+                }
+            });
+        }
+        for (auto& t : pollers) t.join();
+        ASSERT_EQ_INT(ok_count.load(), 160);
+
+        // 删除流 (清理 cam01) 使快照立即失效
+        stream_mgr->remove_stream("cam01");
+        ASSERT_EQ_INT(static_cast<int>(stream_mgr->status_snapshot()->streams.size()), 0);
+        ASSERT_TRUE(!stream_mgr->get_status("cam01").has_value());
+    }
+
+    // ----------------------------------------------------------
+    // Test 22: 推送 (SSE 结果流 / MJPEG 预览) + 连接数上限
+    // ----------------------------------------------------------
+    {
+        std::cout << "\n[Test 22] Push endpoints (SSE / MJPEG) + client limit" << std::endl;
+        auto wait_push_clients = [&rest](int n) {
+            for (int i = 0; i < 50 && rest->push_clients() != n; i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            return rest->push_clients() == n;
+        };
+
+        // SSE: 收到一个 result 事件后主动断开
+        std::string sse_body;
+        std::thread sse_client([&sse_body] {
+            httplib::Client c("localhost", TEST_PORT);
+            c.set_read_timeout(5);
+            c.Get("/api/results/stream", [&sse_body](const char* data, size_t len) {
+                sse_body.append(data, len);
+                return sse_body.find("\n\n", sse_body.find("event: result")) == std::string::npos;
+            });
+        });
+        ASSERT_TRUE(wait_push_clients(1));
+        ASSERT_EQ_INT(static_cast<int>(broadcaster.subscriber_count()), 1);
+
+        // 超过 http_push_clients (= 1) 的推送连接被拒绝
+        auto busy = cli.Get("/api/results/stream");
+        ASSERT_TRUE(busy != nullptr);
+        if (busy) ASSERT_EQ_INT(busy->status, 503);
+
+        infer_server::FrameResult fr;
+        fr.cam_id = "cam_push";
+        fr.frame_id = 42;
+        broadcaster.publish(fr);
+        sse_client.join();
+        ASSERT_TRUE(sse_body.find("event: result\ndata: ") != std::string::npos);
+        auto data_pos = sse_body.find("data: ");
+        if (data_pos != std::string::npos) {
+            auto line = sse_body.substr(data_pos + 6, sse_body.find('\n', data_pos) - data_pos - 6);
+            auto j = json::parse(line);
+            ASSERT_EQ_INT(j["frame_id"].get<int>(), 42);
+        }
+        // 客户端断开后名额在下一次写入 / 等待超时后释放
+        broadcaster.publish(fr);
+        ASSERT_TRUE(wait_push_clients(0));
+
+        // 过滤不存在的流
+        auto missing = cli.Get("/api/results/stream?stream_id=nonexistent");
+        ASSERT_TRUE(missing != nullptr);
+        if (missing) ASSERT_EQ_INT(missing->status, 404);
+
+#ifdef HAS_TURBOJPEG
+        auto nostream = cli.Get("/api/cache/mjpeg?stream_id=cam_push");
+        ASSERT_TRUE(nostream != nullptr);
+        if (nostream) ASSERT_EQ_INT(nostream->status, 404);
+
+        auto make_frame = [](uint64_t id) {
+            infer_server::CachedFrame f;
+            f.cam_id = "cam_push";
+            f.frame_id = id;
+            f.timestamp_ms = 1000 + static_cast<int64_t>(id) * 40;
+            f.jpeg_data = std::make_shared<std::vector<uint8_t>>(std::vector<uint8_t>{0xFF, 0xD8, 0x00, 0xFF, 0xD9});
+            return f;
+        };
+        cache->add_frame(make_frame(1));
+
+        // MJPEG: 收到两个分段 (最新帧 + 之后写入的新帧) 后断开
+        std::string mjpeg_body;
+        std::string content_type;
+        std::thread mjpeg_client([&] {
+            httplib::Client c("localhost", TEST_PORT);
+            c.set_read_timeout(5);
+            c.Get("/api/cache/mjpeg?stream_id=cam_push",
+                  [&content_type](const httplib::Response& r) {
+                      content_type = r.get_header_value("Content-Type");
+                      return true;
+                  },
+                  [&mjpeg_body](const char* data, size_t len) {
+                      mjpeg_body.append(data, len);
+                      return mjpeg_body.find("X-Frame-Id: 2") == std::string::npos;
+                  });
+        });
+        ASSERT_TRUE(wait_push_clients(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        cache->add_frame(make_frame(2));
+        mjpeg_client.join();
+        ASSERT_TRUE(content_type.find("multipart/x-mixed-replace") != std::string::npos);
+        ASSERT_TRUE(mjpeg_body.find("--frame\r\nContent-Type: image/jpeg\r\nContent-Length: 5") != std::string::npos);
+        ASSERT_TRUE(mjpeg_body.find("X-Frame-Id: 1") != std::string::npos);
+        cache->remove_stream("cam_push");
+        ASSERT_TRUE(wait_push_clients(0));
+#endif
+    }
+
     std::this_thread::sleep_for(std::chrono::milliseconds(200));
 
     // 停止服务器
@@ -0,0 +1,249 @@
+/**
+ * @file test_result_broadcaster.cpp
+ * @brief 结果广播 (ResultBroadcaster, HTTP SSE 推送的数据源) 单元测试
+ *
+ * 纯 CPU, 不依赖 httplib 与硬件, 验证:
+ * - 没有订阅者时 publish 直接返回
+ * - 按摄像头过滤 / 订阅全部摄像头
+ * - 每帧只编码一次, 订阅者共享同一份 JSON 文本
+ * - 慢订阅者队列满时丢弃最旧结果, 不阻塞发布者
+ * - 订阅者析构即退订
+ * - 多订阅者与发布者并发
+ */
+
+#include "infer_server/output/result_broadcaster.h"
+#include "infer_server/output/result_codec.h"
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace infer_server;
+using std::chrono::milliseconds;
+
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_CASE(name) \
+    do { std::cout << "\n[TEST] " << name << std::endl; } while(0)
+
+#define ASSERT_TRUE(expr) \
+    do { \
+        if (!(expr)) { \
+            std::cerr << "  FAIL: " << #expr << " at line " << __LINE__ << std::endl; \
+            g_tests_failed++; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) \
+    do { \
+        auto _a = (a); auto _b = (b); \
+        if (_a != _b) { \
+            std::cerr << "  FAIL: " << #a << " == " << #b \
+                      << " (" << _a << " != " << _b << ") at line " << __LINE__ << std::endl; \
+            g_tests_failed++; \
+            return; \
+        } \
+    } while(0)
+
+#define PASS() \
+    do { std::cout << "  PASS" << std::endl; g_tests_passed++; } while(0)
+
+// ============================================================
+// 辅助函数
+// ============================================================
+
+static FrameResult make_result(const std::string& cam_id, uint64_t frame_id) {
+    FrameResult r;
+    r.cam_id = cam_id;
+    r.frame_id = frame_id;
+    r.timestamp_ms = 1700000000000 + static_cast<int64_t>(frame_id) * 40;
+    r.original_width = 1920;
+    r.original_height = 1080;
+
+    ModelResult mr;
+    mr.task_name = "phone";
+    Detection d;
+    d.class_id = 0;
+    d.class_name = "phone";
+    d.confidence = 0.9f;
+    d.bbox = {10.0f, 20.0f, 110.0f, 220.0f};
+    mr.detections.push_back(d);
+    r.results.push_back(mr);
+    return r;
+}
+
+// ============================================================
+// 测试 1: 无订阅者
+// ============================================================
+void test_no_subscribers() {
+    TEST_CASE("Publish without subscribers is a no-op");
+
+    ResultBroadcaster b;
+    ASSERT_EQ(b.subscriber_count(), 0u);
+    for (int i = 0; i < 100; i++) b.publish(make_result("cam01", i));
+    ASSERT_EQ(b.published_count(), 0u);
+
+    PASS();
+}
+
+// ============================================================
+// 测试 2: 按摄像头过滤
+// ============================================================
+void test_filter() {
+    TEST_CASE("Per-camera and all-camera subscriptions");
+
+    ResultBroadcaster b;
+    auto cam1 = b.subscribe("cam01");
+    auto all = b.subscribe("");
+    ASSERT_EQ(b.subscriber_count(), 2u);
+    ASSERT_TRUE(cam1->cam_id() == "cam01");
+
+    b.publish(make_result("cam01", 1));
+    b.publish(make_result("cam02", 2));
+
+    auto p = cam1->next(milliseconds(100));
+    ASSERT_TRUE(p.has_value());
+    auto j = nlohmann::json::parse(**p);
+    ASSERT_TRUE(j["cam_id"] == "cam01");
+    ASSERT_EQ(j["frame_id"].get<uint64_t>(), 1u);
+    ASSERT_TRUE(!cam1->next(milliseconds(10)).has_value());
+
+    auto a1 = all->next(milliseconds(100));
+    auto a2 = all->next(milliseconds(100));
+    ASSERT_TRUE(a1.has_value() && a2.has_value());
+    ASSERT_EQ(nlohmann::json::parse(**a2)["frame_id"].get<uint64_t>(), 2u);
+
+    // 两个订阅者收到的 cam01 结果是同一份文本 (只编码一次)
+    ASSERT_TRUE(p->get() == a1->get());
+    ASSERT_TRUE(**p == result_codec::encode_json(make_result("cam01", 1)));
+    ASSERT_EQ(b.published_count(), 2u);
+
+    PASS();
+}
+
+// ============================================================
+// 测试 3: 慢订阅者
+// ============================================================
+void test_slow_subscriber() {
+    TEST_CASE("Slow subscriber drops oldest results without blocking publisher");
+
+    ResultBroadcaster b;
+    auto slow = b.subscribe("cam01", 4);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; i++) b.publish(make_result("cam01", i));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_TRUE(elapsed < milliseconds(1000));
+
+    ASSERT_EQ(slow->dropped(), 96u);
+    // 保留最新的 4 条
+    for (uint64_t expect = 96; expect < 100; expect++) {
+        auto p = slow->next(milliseconds(100));
+        ASSERT_TRUE(p.has_value());
+        ASSERT_EQ(nlohmann::json::parse(**p)["frame_id"].get<uint64_t>(), expect);
+    }
+
+    PASS();
+}
+
+// ============================================================
+// 测试 4: 析构即退订
+// ============================================================
+void test_unsubscribe() {
+    TEST_CASE("Destroying a subscription unsubscribes");
+
+    ResultBroadcaster b;
+    auto keep = b.subscribe("cam01");
+    {
+        auto gone = b.subscribe("cam01");
+        ASSERT_EQ(b.subscriber_count(), 2u);
+    }
+    b.publish(make_result("cam01", 1));
+    ASSERT_EQ(b.subscriber_count(), 1u);
+    ASSERT_TRUE(keep->next(milliseconds(100)).has_value());
+
+    keep.reset();
+    b.publish(make_result("cam01", 2));
+    ASSERT_EQ(b.subscriber_count(), 0u);
+    // 之后的 publish 走无订阅者快速路径
+    b.publish(make_result("cam01", 3));
+    ASSERT_EQ(b.published_count(), 1u);
+
+    PASS();
+}
+
+// ============================================================
+// 测试 5: 并发
+// ============================================================
+void test_concurrent() {
+    TEST_CASE("Concurrent publisher and subscribers");
+
+    constexpr int kFrames = 2000;
+    constexpr int kSubscribers = 4;
+    ResultBroadcaster b;
+    std::atomic<bool> done{false};
+    std::atomic<int> received{0};
+    std::atomic<int> out_of_order{0};
+
+    std::vector<std::thread> subscribers;
+    std::vector<std::shared_ptr<ResultBroadcaster::Subscription>> subs;
+    for (int s = 0; s < kSubscribers; s++) subs.push_back(b.subscribe("", kFrames));
+    for (int s = 0; s < kSubscribers; s++) {
+        subscribers.emplace_back([&, s] {
+            int64_t last = -1;
+            while (true) {
+                auto p = subs[static_cast<size_t>(s)]->next(milliseconds(20));
+                if (!p) {
+                    if (done.load()) break;
+                    continue;
+                }
+                auto id = nlohmann::json::parse(**p)["frame_id"].get<int64_t>();
+                if (id <= last) out_of_order++;
+                last = id;
+                received++;
+            }
+        });
+    }
+
+    // 订阅者反复加入/退出, 与发布者竞争
+    std::thread churn([&] {
+        while (!done.load()) {
+            auto tmp = b.subscribe("cam01", 1);
+            std::this_thread::yield();
+        }
+    });
+
+    for (int i = 0; i < kFrames; i++) b.publish(make_result("cam01", i));
+    done = true;
+    churn.join();
+    for (auto& t : subscribers) t.join();
+
+    ASSERT_EQ(received.load(), kFrames * kSubscribers);
+    ASSERT_EQ(out_of_order.load(), 0);
+
+    PASS();
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << "  Result Broadcaster Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    test_no_subscribers();
+    test_filter();
+    test_slow_subscriber();
+    test_unsubscribe();
+    test_concurrent();
+
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "  Results: " << g_tests_passed << " passed, "
+              << g_tests_failed << " failed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return g_tests_failed > 0 ? 1 : 0;
+}
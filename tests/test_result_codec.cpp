@@ -0,0 +1,402 @@
+/**
+ * @file test_result_codec.cpp
+ * @brief 结果序列化 (JSON / MessagePack) 单元测试
+ *
+ * 纯 CPU, 不依赖 libzmq 与硬件, 验证:
+ * - MessagePack 往返: 编码后解码得到相同的 FrameResult
+ * - schema v1 布局: 用 nlohmann::json::from_msgpack 独立解析, 字段位置正确
+ * - 整数 / 字符串 / 数组长度的各种编码宽度
+ * - 非法输入 (截断、版本不符) 被拒绝, 尾部扩展字段被忽略
+ * - 格式识别与 JSON 兼容
+ * - 缓冲复用: 稳态编码不分配内存
+ * - ZMQ 主题构造与主题模式解析
+ */
+
+#include "infer_server/output/result_codec.h"
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace infer_server;
+
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_CASE(name) \
+    do { std::cout << "\n[TEST] " << name << std::endl; } while(0)
+
+#define ASSERT_TRUE(expr) \
+    do { \
+        if (!(expr)) { \
+            std::cerr << "  FAIL: " << #expr << " at line " << __LINE__ << std::endl; \
+            g_tests_failed++; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) \
+    do { \
+        auto _a = (a); auto _b = (b); \
+        if (_a != _b) { \
+            std::cerr << "  FAIL: " << #a << " == " << #b \
+                      << " (" << _a << " != " << _b << ") at line " << __LINE__ << std::endl; \
+            g_tests_failed++; \
+            return; \
+        } \
+    } while(0)
+
+#define PASS() \
+    do { std::cout << "  PASS" << std::endl; g_tests_passed++; } while(0)
+
+// ============================================================
+// 辅助函数
+// ============================================================
+
+static FrameResult make_result(int num_models, int dets_per_model) {
+    FrameResult r;
+    r.cam_id = "cam01";
+    r.rtsp_url = "rtsp://192.168.1.10:554/stream1";
+    r.frame_id = 123456;
+    r.timestamp_ms = 1700000000123;
+    r.pts = 90000;
+    r.original_width = 1920;
+    r.original_height = 1080;
+
+    for (int m = 0; m < num_models; m++) {
+        ModelResult mr;
+        mr.task_name = "task_" + std::to_string(m);
+        mr.model_path = "/opt/models/yolov8_" + std::to_string(m) + ".rknn";
+        mr.inference_time_ms = 12.25 + m;
+        for (int i = 0; i < dets_per_model; i++) {
+            Detection d;
+            d.class_id = i % 80;
+            d.class_name = "class_" + std::to_string(i % 80);
+            d.confidence = 0.5f + 0.001f * i;
+            d.bbox = {10.5f + i, 20.25f + i, 110.75f + i, 220.0f + i};
+            mr.detections.push_back(d);
+        }
+        r.results.push_back(mr);
+    }
+    return r;
+}
+
+/// 以 JSON DOM 比较 (覆盖所有字段)
+static bool same_result(const FrameResult& a, const FrameResult& b) {
+    return nlohmann::json(a) == nlohmann::json(b);
+}
+
+// ============================================================
+// 测试 1: MessagePack 往返
+// ============================================================
+void test_msgpack_roundtrip() {
+    TEST_CASE("MessagePack roundtrip");
+
+    for (int models : {0, 1, 3}) {
+        for (int dets : {0, 1, 20}) {
+            FrameResult r = make_result(models, dets);
+            std::vector<uint8_t> buf;
+            result_codec::encode_msgpack(r, buf);
+            ASSERT_TRUE(!buf.empty());
+
+            auto decoded = result_codec::decode_msgpack(buf.data(), buf.size());
+            ASSERT_TRUE(decoded.has_value());
+            ASSERT_TRUE(same_result(r, *decoded));
+        }
+    }
+
+    PASS();
+}
+
+// ============================================================
+// 测试 2: schema v1 布局 (第三方解码器视角)
+// ============================================================
+void test_msgpack_schema_layout() {
+    TEST_CASE("MessagePack schema v1 layout");
+
+    FrameResult r = make_result(1, 2);
+    std::vector<uint8_t> buf;
+    result_codec::encode_msgpack(r, buf);
+
+    auto j = nlohmann::json::from_msgpack(buf);
+    ASSERT_TRUE(j.is_array());
+    ASSERT_EQ(j.size(), 9u);
+    ASSERT_EQ(j[0].get<int>(), result_codec::kMsgpackSchemaVersion);
+    ASSERT_TRUE(j[1] == "cam01");
+    ASSERT_TRUE(j[2] == r.rtsp_url);
+    ASSERT_EQ(j[3].get<uint64_t>(), r.frame_id);
+    ASSERT_EQ(j[4].get<int64_t>(), r.timestamp_ms);
+    ASSERT_EQ(j[5].get<int64_t>(), r.pts);
+    ASSERT_EQ(j[6].get<int>(), 1920);
+    ASSERT_EQ(j[7].get<int>(), 1080);
+
+    const auto& model = j[8][0];
+    ASSERT_EQ(model.size(), 4u);
+    ASSERT_TRUE(model[0] == "task_0");
+    ASSERT_TRUE(model[1] == r.results[0].model_path);
+    ASSERT_TRUE(model[2].get<double>() == r.results[0].inference_time_ms);
+
+    const auto& det = model[3][1];
+    const auto& expect = r.results[0].detections[1];
+    ASSERT_EQ(det.size(), 7u);
+    ASSERT_EQ(det[0].get<int>(), expect.class_id);
+    ASSERT_TRUE(det[1] == expect.class_name);
+    ASSERT_TRUE(det[2].get<float>() == expect.confidence);
+    ASSERT_TRUE(det[3].get<float>() == expect.bbox.x1);
+    ASSERT_TRUE(det[6].get<float>() == expect.bbox.y2);
+
+    // 运动门控转发的结果: 尾部追加 [9] repeated = true
+    r.repeated = true;
+    result_codec::encode_msgpack(r, buf);
+    j = nlohmann::json::from_msgpack(buf);
+    ASSERT_EQ(j.size(), 10u);
+    ASSERT_TRUE(j[9] == true);
+    auto d = result_codec::decode_msgpack(buf.data(), buf.size());
+    ASSERT_TRUE(d.has_value());
+    ASSERT_TRUE(d->repeated);
+    ASSERT_TRUE(same_result(r, *d));
+
+    // 跟踪: Detection 尾部追加 [7] track_id, 外推结果的 ModelResult 尾部追加 [4] predicted
+    r.repeated = false;
+    r.results[0].detections[1].track_id = 300;
+    r.results[0].predicted = true;
+    result_codec::encode_msgpack(r, buf);
+    j = nlohmann::json::from_msgpack(buf);
+    ASSERT_EQ(j.size(), 9u);
+    ASSERT_EQ(j[8][0].size(), 5u);
+    ASSERT_TRUE(j[8][0][4] == true);
+    ASSERT_EQ(j[8][0][3][0].size(), 7u);
+    ASSERT_EQ(j[8][0][3][1].size(), 8u);
+    ASSERT_EQ(j[8][0][3][1][7].get<int>(), 300);
+    d = result_codec::decode_msgpack(buf.data(), buf.size());
+    ASSERT_TRUE(d.has_value());
+    ASSERT_TRUE(d->results[0].predicted);
+    ASSERT_EQ(d->results[0].detections[0].track_id, -1);
+    ASSERT_EQ(d->results[0].detections[1].track_id, 300);
+    ASSERT_TRUE(same_result(r, *d));
+
+    PASS();
+}
+
+// ============================================================
+// 测试 3: 各种编码宽度
+// ============================================================
+void test_msgpack_widths() {
+    TEST_CASE("MessagePack integer / string / array widths");
+
+    const uint64_t frame_ids[] = {0, 127, 128, 255, 256, 65535, 65536,
+                                  0xffffffffull, 0x100000000ull, UINT64_MAX};
+    const int64_t signed_values[] = {0, -1, -32, -33, -128, -129, -32768, -32769,
+                                     INT32_MIN, static_cast<int64_t>(INT32_MIN) - 1,
+                                     INT64_MIN, INT64_MAX};
+
+    FrameResult r = make_result(1, 1);
+    std::vector<uint8_t> buf;
+
+    for (uint64_t id : frame_ids) {
+        r.frame_id = id;
+        result_codec::encode_msgpack(r, buf);
+        auto d = result_codec::decode_msgpack(buf.data(), buf.size());
+        ASSERT_TRUE(d.has_value());
+        ASSERT_TRUE(d->frame_id == id);
+    }
+
+    for (int64_t v : signed_values) {
+        r.timestamp_ms = v;
+        r.pts = -v / 2;
+        r.results[0].detections[0].class_id = static_cast<int>(v % 100000);
+        result_codec::encode_msgpack(r, buf);
+        auto d = result_codec::decode_msgpack(buf.data(), buf.size());
+        ASSERT_TRUE(d.has_value());
+        ASSERT_TRUE(same_result(r, *d));
+        ASSERT_TRUE(nlohmann::json::from_msgpack(buf)[4].get<int64_t>() == v);
+    }
+
+    // 字符串: fixstr / str8 / str16 / str32
+    for (size_t len : {0u, 31u, 32u, 255u, 256u, 65535u, 65536u}) {
+        r.cam_id.assign(len, 'x');
+        result_codec::encode_msgpack(r, buf);
+        auto d = result_codec::decode_msgpack(buf.data(), buf.size());
+        ASSERT_TRUE(d.has_value());
+        ASSERT_EQ(d->cam_id.size(), len);
+        ASSERT_TRUE(nlohmann::json::from_msgpack(buf)[1].get<std::string>().size() == len);
+    }
+
+    // 数组: fixarray / array16 / array32
+    for (int n : {15, 16, 70000}) {
+        FrameResult big = make_result(1, n);
+        result_codec::encode_msgpack(big, buf);
+        auto d = result_codec::decode_msgpack(buf.data(), buf.size());
+        ASSERT_TRUE(d.has_value());
+        ASSERT_EQ(d->results[0].detections.size(), static_cast<size_t>(n));
+        ASSERT_TRUE(same_result(big, *d));
+    }
+
+    PASS();
+}
+
+// ============================================================
+// 测试 4: 非法输入与前向兼容
+// ============================================================
+void test_msgpack_rejects_and_extends() {
+    TEST_CASE("MessagePack: reject malformed, ignore trailing fields");
+
+    FrameResult r = make_result(2, 3);
+    std::vector<uint8_t> buf;
+    result_codec::encode_msgpack(r, buf);
+
+    // 任意截断都必须失败, 不能越界
+    for (size_t n = 0; n < buf.size(); n++) {
+        ASSERT_TRUE(!result_codec::decode_msgpack(buf.data(), n).has_value());
+    }
+    // 多余的尾部字节
+    auto padded = buf;
+    padded.push_back(0xc0);
+    ASSERT_TRUE(!result_codec::decode_msgpack(padded.data(), padded.size()).has_value());
+
+    // 版本不符
+    auto j = nlohmann::json::from_msgpack(buf);
+    j[0] = 2;
+    auto v2 = nlohmann::json::to_msgpack(j);
+    ASSERT_TRUE(!result_codec::decode_msgpack(v2.data(), v2.size()).has_value());
+
+    // 伪造超大数组长度: 不应尝试分配
+    std::vector<uint8_t> huge = {0x99, 0x01, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                 0xdd, 0xff, 0xff, 0xff, 0xff};
+    ASSERT_TRUE(!result_codec::decode_msgpack(huge.data(), huge.size()).has_value());
+
+    // 其他编码器写出的等价数据 (浮点宽度等可能不同) 仍可解码
+    j = nlohmann::json::from_msgpack(buf);
+    auto reencoded = nlohmann::json::to_msgpack(j);
+    auto re = result_codec::decode_msgpack(reencoded.data(), reencoded.size());
+    ASSERT_TRUE(re.has_value());
+    ASSERT_TRUE(same_result(r, *re));
+
+    // 新版本在各层数组末尾追加字段 (含嵌套 map), 旧解码器应忽略
+    j = nlohmann::json::from_msgpack(buf);
+    j.push_back(nlohmann::json{{"future", {1, 2.5, "x", nullptr, true}}});
+    j[8][0].push_back(-7);
+    j[8][1][3][2].push_back("extra");
+    j[8][1][3][2].push_back(nlohmann::json::binary({1, 2, 3}));
+    auto extended = nlohmann::json::to_msgpack(j);
+    auto d = result_codec::decode_msgpack(extended.data(), extended.size());
+    ASSERT_TRUE(d.has_value());
+    ASSERT_TRUE(same_result(r, *d));
+
+    PASS();
+}
+
+// ============================================================
+// 测试 5: 格式识别与 JSON 兼容
+// ============================================================
+void test_detect_and_json() {
+    TEST_CASE("Format detection and JSON compatibility");
+
+    FrameResult r = make_result(2, 2);
+
+    std::string json = result_codec::encode_json(r);
+    ASSERT_TRUE(nlohmann::json::parse(json) == nlohmann::json(r));
+
+    std::vector<uint8_t> buf;
+    result_codec::encode_msgpack(r, buf);
+
+    auto f1 = result_codec::detect_format(json.data(), json.size());
+    auto f2 = result_codec::detect_format(buf.data(), buf.size());
+    ASSERT_TRUE(f1 == OutputFormat::JSON);
+    ASSERT_TRUE(f2 == OutputFormat::MSGPACK);
+    ASSERT_TRUE(!result_codec::detect_format("", 0).has_value());
+    ASSERT_TRUE(!result_codec::detect_format("hello", 5).has_value());
+
+    auto d1 = result_codec::decode(json.data(), json.size());
+    auto d2 = result_codec::decode(buf.data(), buf.size());
+    ASSERT_TRUE(d1.has_value() && same_result(r, *d1));
+    ASSERT_TRUE(d2.has_value() && same_result(r, *d2));
+    ASSERT_TRUE(!result_codec::decode("{broken", 7).has_value());
+
+    OutputFormat f = OutputFormat::JSON;
+    ASSERT_TRUE(parse_output_format("msgpack", f) && f == OutputFormat::MSGPACK);
+    ASSERT_TRUE(parse_output_format("json", f) && f == OutputFormat::JSON);
+    ASSERT_TRUE(!parse_output_format("flatbuffers", f) && f == OutputFormat::JSON);
+    ASSERT_TRUE(std::string(output_format_name(OutputFormat::MSGPACK)) == "msgpack");
+
+    std::cout << "  2 models x 2 dets: json=" << json.size()
+              << " bytes, msgpack=" << buf.size() << " bytes" << std::endl;
+    ASSERT_TRUE(buf.size() * 2 < json.size());
+
+    PASS();
+}
+
+// ============================================================
+// 测试 6: 缓冲复用 (编码耗时见 bench_result_codec)
+// ============================================================
+void test_buffer_reuse() {
+    TEST_CASE("Buffer reuse");
+
+    FrameResult r = make_result(3, 10);
+    std::vector<uint8_t> buf;
+    result_codec::encode_msgpack(r, buf);
+    const uint8_t* data = buf.data();
+    size_t capacity = buf.capacity();
+
+    // 同一结果反复编码: 不重新分配, 输出一致
+    std::vector<uint8_t> first = buf;
+    for (int i = 0; i < 10; i++) {
+        result_codec::encode_msgpack(r, buf);
+    }
+    ASSERT_TRUE(buf.data() == data);
+    ASSERT_EQ(buf.capacity(), capacity);
+    ASSERT_TRUE(buf == first);
+
+    PASS();
+}
+
+// ============================================================
+// 测试 7: 主题
+// ============================================================
+void test_topics() {
+    TEST_CASE("Topic construction and topic mode parsing");
+
+    ASSERT_TRUE(result_codec::make_topic("cam01") == "cam01/");
+    ASSERT_TRUE(result_codec::make_topic("cam01", "phone") == "cam01/phone");
+
+    // 前缀订阅: "cam1/" 匹配 cam1 的所有主题, 不匹配 cam10
+    auto starts_with = [](const std::string& s, const std::string& prefix) {
+        return s.compare(0, prefix.size(), prefix) == 0;
+    };
+    std::string sub = result_codec::make_topic("cam1");
+    ASSERT_TRUE(starts_with(result_codec::make_topic("cam1", "phone"), sub));
+    ASSERT_TRUE(starts_with(result_codec::make_topic("cam1"), sub));
+    ASSERT_TRUE(!starts_with(result_codec::make_topic("cam10", "phone"), sub));
+    ASSERT_TRUE(!starts_with(result_codec::make_topic("cam10"), sub));
+
+    TopicMode mode = TopicMode::NONE;
+    ASSERT_TRUE(parse_topic_mode("camera", mode) && mode == TopicMode::CAMERA);
+    ASSERT_TRUE(parse_topic_mode("task", mode) && mode == TopicMode::TASK);
+    ASSERT_TRUE(parse_topic_mode("none", mode) && mode == TopicMode::NONE);
+    ASSERT_TRUE(!parse_topic_mode("model", mode) && mode == TopicMode::NONE);
+    ASSERT_TRUE(std::string(topic_mode_name(TopicMode::TASK)) == "task");
+
+    PASS();
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << "  Result Codec Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    test_msgpack_roundtrip();
+    test_msgpack_schema_layout();
+    test_msgpack_widths();
+    test_msgpack_rejects_and_extends();
+    test_detect_and_json();
+    test_buffer_reuse();
+    test_topics();
+
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "  Results: " << g_tests_passed << " passed, "
+              << g_tests_failed << " failed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return g_tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,345 @@
+/**
+ * @file test_result_dispatcher.cpp
+ * @brief ResultDispatcher 输出阶段测试 (纯逻辑, 不需要 NPU / ZMQ)
+ *
+ * 测试内容:
+ *   1. num_threads = 0: 在调用线程同步输出
+ *   2. 异步输出: 慢 sink 不阻塞 post() (NPU 线程)
+ *   3. 多输出线程 + 多生产者: 同一路流的结果保持顺序, 不丢不重
+ *   4. 队列满时丢弃最旧结果并计数
+ *   5. stop() 输出完剩余结果后返回
+ *   6. sink 抛异常不影响后续结果与其他 sink
+ *   7. 未启动 / 已停止时 post() 返回 false
+ *   8. 结果携带的流计数器句柄 (StreamCounters)
+ *
+ * 编译: cmake --build build --target test_result_dispatcher
+ * 运行: ./build/tests/test_result_dispatcher
+ */
+
+#include "infer_server/output/result_dispatcher.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+// ============================================================
+// 简易测试框架 (同 test_bounded_queue)
+// ============================================================
+
+struct TestCase {
+    std::string name;
+    std::function<void()> func;
+};
+
+static std::vector<TestCase> g_tests;
+static int g_pass = 0;
+static int g_fail = 0;
+
+#define ASSERT_TRUE(cond)                                                      \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_TRUE failed: ") + #cond +                  \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_FALSE(cond) ASSERT_TRUE(!(cond))
+
+#define ASSERT_EQ(a, b)                                                        \
+    do {                                                                        \
+        auto _a = (a); auto _b = (b);                                          \
+        if (_a != _b) {                                                         \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_EQ failed: ") + #a + "=" +                 \
+                std::to_string(_a) + " != " + #b + "=" +                       \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define TEST(test_name)                                                        \
+    static void test_fn_##test_name();                                         \
+    static bool _reg_##test_name = [] {                                        \
+        g_tests.push_back({#test_name, test_fn_##test_name});                  \
+        return true;                                                            \
+    }();                                                                        \
+    static void test_fn_##test_name()
+
+// ============================================================
+// 测试用例
+// ============================================================
+
+using infer_server::FrameResult;
+using infer_server::ResultDispatcher;
+using infer_server::StreamCounters;
+using namespace std::chrono_literals;
+
+static FrameResult make_result(const std::string& cam_id, uint64_t frame_id) {
+    FrameResult r;
+    r.cam_id = cam_id;
+    r.frame_id = frame_id;
+    return r;
+}
+
+/// 等待条件成立 (最多 timeout)
+static bool wait_for(const std::function<bool()>& pred, std::chrono::milliseconds timeout = 2000ms) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+// 1. 同步模式
+TEST(sync_mode_runs_on_caller) {
+    ResultDispatcher d(0, 8);
+    std::thread::id sink_thread;
+    int calls = 0;
+    d.add_sink([&](const FrameResult& r) {
+        sink_thread = std::this_thread::get_id();
+        calls++;
+        ASSERT_EQ(r.frame_id, 7u);
+    });
+    d.start();
+
+    ASSERT_TRUE(d.post(make_result("cam", 7)));
+    ASSERT_EQ(calls, 1);
+    ASSERT_TRUE(sink_thread == std::this_thread::get_id());
+
+    auto s = d.get_stats();
+    ASSERT_EQ(s.posted, 1u);
+    ASSERT_EQ(s.dispatched, 1u);
+    d.stop();
+}
+
+// 2. 异步: 慢 sink 不阻塞 post
+TEST(slow_sink_does_not_block_post) {
+    ResultDispatcher d(1, 64);
+    std::atomic<bool> release{false};
+    std::atomic<int> calls{0};
+    std::thread::id sink_thread;
+    d.add_sink([&](const FrameResult&) {
+        sink_thread = std::this_thread::get_id();
+        while (!release.load()) std::this_thread::sleep_for(1ms);
+        calls++;
+    });
+    d.start();
+
+    // sink 被阻塞期间全部 post 返回即说明不阻塞 (不比较耗时); 在独立线程投递, 失败时不会卡死测试
+    std::atomic<int> posted{0};
+    std::thread producer([&] {
+        for (int i = 0; i < 10; i++) {
+            if (d.post(make_result("cam", i))) posted++;
+        }
+    });
+    bool all_posted = wait_for([&] { return posted.load() == 10; });
+    int calls_while_blocked = calls.load();
+
+    release = true;
+    producer.join();
+    ASSERT_TRUE(all_posted);
+    ASSERT_EQ(calls_while_blocked, 0);
+    ASSERT_TRUE(wait_for([&] { return calls.load() == 10; }));
+    ASSERT_TRUE(sink_thread != std::this_thread::get_id());
+    d.stop();
+}
+
+// 3. 多线程: 每路流结果有序, 不丢不重
+TEST(per_stream_order_with_many_threads) {
+    const int kThreads = 4;
+    const int kCams = 12;
+    const int kFrames = 500;
+
+    ResultDispatcher d(kThreads, kCams * kFrames);  // 足够大, 不丢弃
+    std::mutex mu;
+    std::map<std::string, std::vector<uint64_t>> seen;
+    d.add_sink([&](const FrameResult& r) {
+        std::lock_guard<std::mutex> lock(mu);
+        seen[r.cam_id].push_back(r.frame_id);
+    });
+    d.start();
+
+    // 每个生产者负责若干路流 (同一路流的结果由同一线程按序产生)
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 3; p++) {
+        producers.emplace_back([&, p] {
+            for (int f = 0; f < kFrames; f++) {
+                for (int c = p; c < kCams; c += 3) {
+                    d.post(make_result("cam" + std::to_string(c), f));
+                }
+            }
+        });
+    }
+    for (auto& t : producers) t.join();
+    d.stop();
+
+    ASSERT_EQ(seen.size(), static_cast<size_t>(kCams));
+    for (const auto& [cam, ids] : seen) {
+        ASSERT_EQ(ids.size(), static_cast<size_t>(kFrames));
+        for (size_t i = 0; i < ids.size(); i++) {
+            ASSERT_EQ(ids[i], static_cast<uint64_t>(i));
+        }
+    }
+    auto s = d.get_stats();
+    ASSERT_EQ(s.dispatched, static_cast<uint64_t>(kCams * kFrames));
+    ASSERT_EQ(s.dropped, 0u);
+}
+
+// 4. 队列满时丢弃最旧
+TEST(full_queue_drops_oldest) {
+    ResultDispatcher d(1, 4);
+    std::atomic<bool> release{false};
+    std::mutex mu;
+    std::vector<uint64_t> seen;
+    d.add_sink([&](const FrameResult& r) {
+        while (!release.load()) std::this_thread::sleep_for(1ms);
+        std::lock_guard<std::mutex> lock(mu);
+        seen.push_back(r.frame_id);
+    });
+    d.start();
+
+    // 第一条被输出线程取走并阻塞在 sink 中
+    d.post(make_result("cam", 0));
+    ASSERT_TRUE(wait_for([&] { return d.get_stats().queued == 0; }));
+
+    for (int i = 1; i <= 10; i++) {
+        d.post(make_result("cam", i));
+    }
+    auto s = d.get_stats();
+    ASSERT_EQ(s.queued, 4u);
+    ASSERT_EQ(s.dropped, 6u);
+
+    release = true;
+    d.stop();
+
+    std::lock_guard<std::mutex> lock(mu);
+    ASSERT_EQ(seen.size(), 5u);
+    ASSERT_EQ(seen[0], 0u);
+    ASSERT_EQ(seen[1], 7u);   // 1..6 被丢弃
+    ASSERT_EQ(seen[4], 10u);
+}
+
+// 5. stop 输出完剩余结果
+TEST(stop_drains_queue) {
+    ResultDispatcher d(2, 1000);
+    std::atomic<int> calls{0};
+    d.add_sink([&](const FrameResult&) {
+        std::this_thread::sleep_for(100us);
+        calls++;
+    });
+    d.start();
+
+    for (int i = 0; i < 200; i++) {
+        d.post(make_result("cam" + std::to_string(i % 5), i));
+    }
+    d.stop();
+    ASSERT_EQ(calls.load(), 200);
+    ASSERT_EQ(d.get_stats().queued, 0u);
+    ASSERT_FALSE(d.is_running());
+}
+
+// 6. sink 异常隔离
+TEST(sink_exception_is_isolated) {
+    ResultDispatcher d(1, 16);
+    std::atomic<int> second_calls{0};
+    d.add_sink([](const FrameResult& r) {
+        if (r.frame_id % 2 == 0) throw std::runtime_error("boom");
+    });
+    d.add_sink([&](const FrameResult&) { second_calls++; });
+    d.start();
+
+    for (int i = 0; i < 6; i++) d.post(make_result("cam", i));
+    d.stop();
+
+    ASSERT_EQ(second_calls.load(), 6);
+    ASSERT_EQ(d.get_stats().dispatched, 6u);
+}
+
+// 7. 生命周期
+TEST(post_requires_running) {
+    ResultDispatcher d(1, 4);
+    std::atomic<int> calls{0};
+    d.add_sink([&](const FrameResult&) { calls++; });
+
+    ASSERT_FALSE(d.post(make_result("cam", 0)));
+    d.start();
+    d.start();  // 重复启动无效果
+    ASSERT_TRUE(d.post(make_result("cam", 1)));
+    d.stop();
+    d.stop();
+    ASSERT_FALSE(d.post(make_result("cam", 2)));
+    ASSERT_EQ(calls.load(), 1);
+
+    // 停止后可重新启动
+    d.start();
+    ASSERT_TRUE(d.post(make_result("cam", 3)));
+    d.stop();
+    ASSERT_EQ(calls.load(), 2);
+}
+
+// 8. 计数器句柄
+TEST(counters_handle_survives_owner) {
+    ResultDispatcher d(2, 64);
+    d.add_sink([](const FrameResult& r) {
+        if (r.counters) r.counters->inferred_frames.fetch_add(1, std::memory_order_relaxed);
+    });
+    d.start();
+
+    auto counters = std::make_shared<StreamCounters>();
+    std::weak_ptr<StreamCounters> weak = counters;
+    for (int i = 0; i < 20; i++) {
+        auto r = make_result("cam", i);
+        r.counters = counters;
+        d.post(std::move(r));
+    }
+    counters.reset();  // 流已删除, 在途结果仍持有计数器
+
+    auto r = make_result("cam", 99);  // 无句柄的结果被忽略
+    d.post(std::move(r));
+    d.stop();
+
+    ASSERT_TRUE(weak.expired());
+    ASSERT_EQ(d.get_stats().dispatched, 21u);
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "  ResultDispatcher Unit Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    for (auto& tc : g_tests) {
+        std::cout << "[RUN ] " << tc.name << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            tc.func();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[PASS] " << tc.name << " (" << ms << "ms)" << std::endl;
+            g_pass++;
+        } catch (const std::exception& e) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[FAIL] " << tc.name << " (" << ms << "ms)" << std::endl;
+            std::cout << "       " << e.what() << std::endl;
+            g_fail++;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Results: " << g_pass << " passed, " << g_fail << " failed"
+              << " (total " << (g_pass + g_fail) << ")" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return g_fail > 0 ? 1 : 0;
+}
@@ -0,0 +1,261 @@
+/**
+ * @file test_rga_scheduler.cpp
+ * @brief RgaScheduler 多核心调度测试 (纯逻辑, 不需要 RGA 硬件)
+ *
+ * 测试内容:
+ *   1. 核心掩码 -> 槽位
+ *   2. 空闲核心优先 (持有一个 lease 时下一个分到其他核心)
+ *   3. 同一核心互斥
+ *   4. 启动后 configure 被忽略
+ *   5. 多线程提交: 不同核心并行, 统计守恒
+ *   6. NPU 初始化期: 等待进行中的 job, 暂停新的 acquire, 多个初始化可并行
+ *
+ * 编译: cmake --build build --target test_rga_scheduler
+ * 运行: ./build/tests/test_rga_scheduler
+ */
+
+#include "infer_server/processor/rga_scheduler.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <set>
+#include <memory>
+
+// ============================================================
+// 简易测试框架 (同 test_bounded_queue)
+// ============================================================
+
+struct TestCase {
+    std::string name;
+    std::function<void()> func;
+};
+
+static std::vector<TestCase> g_tests;
+static int g_pass = 0;
+static int g_fail = 0;
+
+#define ASSERT_TRUE(cond)                                                      \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_TRUE failed: ") + #cond +                  \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define ASSERT_FALSE(cond) ASSERT_TRUE(!(cond))
+
+#define ASSERT_EQ(a, b)                                                        \
+    do {                                                                        \
+        auto _a = (a); auto _b = (b);                                          \
+        if (_a != _b) {                                                         \
+            throw std::runtime_error(                                           \
+                std::string("ASSERT_EQ failed: ") + #a + "=" +                 \
+                std::to_string(_a) + " != " + #b + "=" +                       \
+                std::to_string(_b) +                                            \
+                " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")");        \
+        }                                                                       \
+    } while (0)
+
+#define TEST(test_name)                                                        \
+    static void test_fn_##test_name();                                         \
+    static bool _reg_##test_name = [] {                                        \
+        g_tests.push_back({#test_name, test_fn_##test_name});                  \
+        return true;                                                            \
+    }();                                                                        \
+    static void test_fn_##test_name()
+
+// ============================================================
+// 测试用例
+// ============================================================
+
+using infer_server::RgaScheduler;
+using infer_server::RgaCoreMask;
+
+// 1. 核心掩码 -> 槽位
+TEST(core_mask_slots) {
+    RgaScheduler auto_sched(RgaCoreMask::AUTO);
+    ASSERT_EQ(auto_sched.core_count(), 1u);
+    ASSERT_EQ(auto_sched.acquire().core(), RgaCoreMask::AUTO);
+
+    RgaScheduler rk3588(RgaCoreMask::RK3588);
+    ASSERT_EQ(rk3588.core_count(), 3u);
+
+    RgaScheduler rk3576(RgaCoreMask::RK3576);
+    ASSERT_EQ(rk3576.core_count(), 2u);
+    auto stats = rk3576.get_stats();
+    ASSERT_EQ(stats[0].core, RgaCoreMask::RGA2_CORE0);
+    ASSERT_EQ(stats[1].core, RgaCoreMask::RGA2_CORE1);
+}
+
+// 2. 空闲核心优先
+TEST(prefers_idle_core) {
+    RgaScheduler sched(RgaCoreMask::RK3588);
+
+    auto a = sched.acquire();
+    auto b = sched.acquire();
+    auto c = sched.acquire();
+
+    std::set<int> cores = {a.core(), b.core(), c.core()};
+    ASSERT_EQ(cores.size(), 3u);
+
+    uint64_t contended = 0;
+    for (const auto& cs : sched.get_stats()) contended += cs.contended;
+    ASSERT_EQ(contended, 0u);
+}
+
+// 3. 单核心: lease 互斥
+TEST(single_core_exclusive) {
+    RgaScheduler sched(RgaCoreMask::RGA2_CORE0);
+    std::atomic<bool> second_acquired{false};
+
+    std::thread t;
+    {
+        auto lease = sched.acquire();
+        t = std::thread([&]() {
+            auto l2 = sched.acquire();
+            second_acquired = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ASSERT_FALSE(second_acquired.load());
+    }
+    t.join();
+    ASSERT_TRUE(second_acquired.load());
+
+    auto stats = sched.get_stats();
+    ASSERT_EQ(stats[0].jobs, 2u);
+    ASSERT_EQ(stats[0].contended, 1u);
+}
+
+// 4. 启动后 configure 被忽略
+TEST(configure_before_use_only) {
+    RgaScheduler sched;
+    ASSERT_TRUE(sched.configure(RgaCoreMask::RK3576));
+    ASSERT_EQ(sched.core_count(), 2u);
+
+    { auto lease = sched.acquire(); }
+    ASSERT_FALSE(sched.configure(RgaCoreMask::RK3588));
+    ASSERT_EQ(sched.core_count(), 2u);
+}
+
+// 5. 多线程: 每个核心同一时刻只有一个持有者
+TEST(concurrent_submit) {
+    RgaScheduler sched(RgaCoreMask::RK3588);
+    const int num_threads = 8;
+    const int iterations = 300;
+
+    std::atomic<int> active[8] = {};
+    std::atomic<bool> overlap{false};
+    std::atomic<int> max_parallel{0};
+    std::atomic<int> parallel{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < iterations; i++) {
+                auto lease = sched.acquire();
+                int idx = 0;
+                while ((1 << idx) != lease.core()) idx++;
+                if (active[idx].fetch_add(1) != 0) overlap = true;
+
+                int p = parallel.fetch_add(1) + 1;
+                int prev = max_parallel.load();
+                while (p > prev && !max_parallel.compare_exchange_weak(prev, p)) {}
+
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                parallel.fetch_sub(1);
+                active[idx].fetch_sub(1);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    ASSERT_FALSE(overlap.load());
+    ASSERT_TRUE(max_parallel.load() <= 3);
+    ASSERT_TRUE(max_parallel.load() >= 2);
+
+    uint64_t total = 0;
+    for (const auto& cs : sched.get_stats()) {
+        total += cs.jobs;
+        ASSERT_EQ(cs.waiting, 0);
+    }
+    ASSERT_EQ(total, static_cast<uint64_t>(num_threads * iterations));
+}
+
+// 6. NPU 初始化与 RGA job 互斥
+TEST(npu_init_excludes_rga) {
+    RgaScheduler sched(RgaCoreMask::RK3588);
+    std::atomic<bool> init_started{false};
+    std::atomic<bool> release_init{false};
+    std::atomic<bool> rga_acquired{false};
+
+    // 进行中的 job 结束前初始化不能开始
+    auto lease = std::make_unique<RgaScheduler::Lease>(sched.acquire());
+    std::thread init_thread([&]() {
+        auto init = sched.begin_npu_init();
+        init_started = true;
+        while (!release_init.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    bool started_during_job = init_started.load();
+    lease.reset();
+    while (!init_started.load()) std::this_thread::yield();
+
+    // 初始化期间新的 acquire 等待, 另一个初始化不受影响
+    std::thread rga_thread([&]() {
+        auto l = sched.acquire();
+        rga_acquired = true;
+    });
+    { auto second = sched.begin_npu_init(); }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    bool acquired_during_init = rga_acquired.load();
+    release_init = true;
+    init_thread.join();
+    rga_thread.join();
+
+    ASSERT_FALSE(started_during_job);
+    ASSERT_FALSE(acquired_during_init);
+    ASSERT_TRUE(rga_acquired.load());
+}
+
+// ============================================================
+// 主函数
+// ============================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "  RgaScheduler Unit Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    for (auto& tc : g_tests) {
+        std::cout << "[RUN ] " << tc.name << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            tc.func();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[PASS] " << tc.name << " (" << ms << "ms)" << std::endl;
+            g_pass++;
+        } catch (const std::exception& e) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            std::cout << "[FAIL] " << tc.name << " (" << ms << "ms)" << std::endl;
+            std::cout << "       " << e.what() << std::endl;
+            g_fail++;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Results: " << g_pass << " passed, " << g_fail << " failed"
+              << " (total " << (g_pass + g_fail) << ")" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return g_fail > 0 ? 1 : 0;
+}
@@ -0,0 +1,437 @@
+/**
+ * @file test_shard_planner.cpp
+ * @brief 多节点分片规划 (ShardPlanner) 单元测试
+ *
+ * 纯逻辑, 验证:
+ * - HRW 排序确定, 不健康节点不参与
+ * - 多节点分配均衡, 权重按比例生效
+ * - 增加节点只迁移约 1/N 的流且都迁往新节点; 节点故障只重新添加其上的流
+ * - 容量上限与未分配; 过载节点每轮迁出一路
+ * - 过载时有时无: 迁出的流不来回迁移, 节点持续不过载后逐路迁回
+ * - 疑似故障节点: 流原地保留, 不分配新流、不迁出
+ * - max_moves 推迟迁移, 多轮后收敛到目标分配
+ * - 重复副本 / 已删除的流被移除, Remove 排在 Add 之前
+ */
+
+#include "infer_server/cluster/shard_planner.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace infer_server;
+using Running = std::map<std::string, std::vector<std::string>>;
+
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_CASE(name) \
+    do { std::cout << "\n[TEST] " << name << std::endl; } while(0)
+
+#define ASSERT_TRUE(expr) \
+    do { \
+        if (!(expr)) { \
+            std::cerr << "  FAIL: " << #expr << " at line " << __LINE__ << std::endl; \
+            g_tests_failed++; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) \
+    do { \
+        auto _a = (a); auto _b = (b); \
+        if (_a != _b) { \
+            std::cerr << "  FAIL: " << #a << " == " << #b \
+                      << " (" << _a << " != " << _b << ") at line " << __LINE__ << std::endl; \
+            g_tests_failed++; \
+            return; \
+        } \
+    } while(0)
+
+#define PASS() \
+    do { std::cout << "  PASS" << std::endl; g_tests_passed++; } while(0)
+
+static std::vector<std::string> make_cams(int n) {
+    std::vector<std::string> cams;
+    for (int i = 0; i < n; i++) cams.push_back("cam" + std::to_string(i));
+    return cams;
+}
+
+static std::vector<NodeLoad> make_nodes(int n) {
+    std::vector<NodeLoad> nodes;
+    for (int i = 1; i <= n; i++) {
+        NodeLoad node;
+        node.node_id = "http://10.0.0." + std::to_string(i) + ":8080";
+        nodes.push_back(node);
+    }
+    return nodes;
+}
+
+/// 模拟节点执行规划后的运行情况
+static Running execute(Running running, const ShardPlan& plan) {
+    for (const auto& a : plan.actions) {
+        auto& where = running[a.cam_id];
+        if (a.kind == ShardAction::Kind::Remove) {
+            where.erase(std::remove(where.begin(), where.end(), a.node_id), where.end());
+        } else {
+            where.push_back(a.node_id);
+        }
+    }
+    for (auto it = running.begin(); it != running.end();) {
+        it = it->second.empty() ? running.erase(it) : std::next(it);
+    }
+    return running;
+}
+
+static std::map<std::string, int> count_per_node(const std::map<std::string, std::string>& assignment) {
+    std::map<std::string, int> counts;
+    for (const auto& [cam, node] : assignment) counts[node]++;
+    return counts;
+}
+
+// ============================================================
+// 测试 1: 排序确定
+// ============================================================
+void test_rank() {
+    TEST_CASE("rank() is deterministic and skips unhealthy nodes");
+
+    auto nodes = make_nodes(4);
+    auto r1 = ShardPlanner::rank("cam7", nodes);
+    auto r2 = ShardPlanner::rank("cam7", nodes);
+    ASSERT_EQ(r1.size(), 4u);
+    ASSERT_TRUE(r1 == r2);
+
+    // 节点顺序不影响结果
+    auto reversed = nodes;
+    std::reverse(reversed.begin(), reversed.end());
+    auto r3 = ShardPlanner::rank("cam7", reversed);
+    for (size_t i = 0; i < r1.size(); i++) {
+        ASSERT_EQ(nodes[r1[i]].node_id, reversed[r3[i]].node_id);
+    }
+
+    // 不健康节点被排除, 其余节点相对顺序不变
+    size_t first = r1[0];
+    nodes[first].healthy = false;
+    auto r4 = ShardPlanner::rank("cam7", nodes);
+    ASSERT_EQ(r4.size(), 3u);
+    ASSERT_EQ(r4[0], r1[1]);
+    ASSERT_EQ(r4[1], r1[2]);
+    PASS();
+}
+
+// ============================================================
+// 测试 2: 均衡分配与权重
+// ============================================================
+void test_balanced_spread() {
+    TEST_CASE("300 cameras spread evenly over 3 nodes, weights scale the share");
+
+    auto cams = make_cams(300);
+    auto nodes = make_nodes(3);
+    auto plan = ShardPlanner::plan(cams, nodes, {});
+    ASSERT_EQ(plan.actions.size(), 300u);
+    ASSERT_EQ(plan.assignment.size(), 300u);
+    ASSERT_EQ(plan.moves, 0);
+    ASSERT_TRUE(plan.unassigned.empty());
+    for (const auto& a : plan.actions) ASSERT_TRUE(a.kind == ShardAction::Kind::Add);
+    for (const auto& [node, n] : count_per_node(plan.assignment)) {
+        std::cout << "  " << node << ": " << n << std::endl;
+        ASSERT_TRUE(n >= 70 && n <= 130);
+    }
+
+    // 权重 3:1:1 -> 约 60% / 20% / 20%
+    nodes[0].weight = 3.0;
+    auto weighted = count_per_node(ShardPlanner::plan(cams, nodes, {}).assignment);
+    std::cout << "  weighted: " << weighted[nodes[0].node_id] << " / "
+              << weighted[nodes[1].node_id] << " / " << weighted[nodes[2].node_id] << std::endl;
+    ASSERT_TRUE(weighted[nodes[0].node_id] >= 150 && weighted[nodes[0].node_id] <= 210);
+    PASS();
+}
+
+// ============================================================
+// 测试 3: 增加节点 -> 最小迁移
+// ============================================================
+void test_add_node_minimal_movement() {
+    TEST_CASE("Adding a 4th node moves about 1/4 of the cameras, all to the new node");
+
+    auto cams = make_cams(300);
+    auto running = execute({}, ShardPlanner::plan(cams, make_nodes(3), {}));
+
+    auto nodes = make_nodes(4);
+    auto plan = ShardPlanner::plan(cams, nodes, running);
+    std::cout << "  moves: " << plan.moves << std::endl;
+    ASSERT_TRUE(plan.moves >= 45 && plan.moves <= 105);
+    ASSERT_EQ(plan.deferred, 0);
+    ASSERT_EQ(plan.actions.size(), static_cast<size_t>(plan.moves) * 2);
+    for (const auto& a : plan.actions) {
+        if (a.kind == ShardAction::Kind::Add) ASSERT_EQ(a.node_id, nodes[3].node_id);
+    }
+
+    // 执行后再规划: 已收敛, 没有操作
+    running = execute(running, plan);
+    auto again = ShardPlanner::plan(cams, nodes, running);
+    ASSERT_TRUE(again.actions.empty());
+    PASS();
+}
+
+// ============================================================
+// 测试 4: 节点故障 -> 只重新添加其上的流
+// ============================================================
+void test_node_failure() {
+    TEST_CASE("An unreachable node only displaces its own cameras");
+
+    auto cams = make_cams(300);
+    auto nodes = make_nodes(3);
+    auto before = ShardPlanner::plan(cams, nodes, {});
+    auto running = execute({}, before);
+
+    // 节点 2 不可达: 协调器拿不到它上面的流
+    nodes[1].healthy = false;
+    for (auto& [cam, where] : running) {
+        where.erase(std::remove(where.begin(), where.end(), nodes[1].node_id), where.end());
+    }
+    auto plan = ShardPlanner::plan(cams, nodes, running);
+
+    int lost = count_per_node(before.assignment)[nodes[1].node_id];
+    ASSERT_EQ(plan.moves, 0);
+    ASSERT_EQ(plan.actions.size(), static_cast<size_t>(lost));
+    for (const auto& a : plan.actions) {
+        ASSERT_TRUE(a.kind == ShardAction::Kind::Add);
+        ASSERT_EQ(before.assignment[a.cam_id], nodes[1].node_id);
+        ASSERT_TRUE(a.node_id != nodes[1].node_id);
+    }
+
+    // 节点恢复 (上面没有流): 它原来的流迁回, 分配与故障前一致
+    nodes[1].healthy = true;
+    running = execute(running, plan);
+    auto back = ShardPlanner::plan(cams, nodes, running);
+    ASSERT_EQ(back.moves, lost);
+    ASSERT_TRUE(back.assignment == before.assignment);
+    PASS();
+}
+
+// ============================================================
+// 测试 5: 容量上限
+// ============================================================
+void test_capacity() {
+    TEST_CASE("max_streams caps each node, overflow is reported as unassigned");
+
+    auto cams = make_cams(8);
+    auto nodes = make_nodes(2);
+    nodes[0].max_streams = 3;
+    nodes[1].max_streams = 3;
+    auto plan = ShardPlanner::plan(cams, nodes, {});
+    ASSERT_EQ(plan.assignment.size(), 6u);
+    ASSERT_EQ(plan.unassigned.size(), 2u);
+    for (const auto& [node, n] : count_per_node(plan.assignment)) ASSERT_EQ(n, 3);
+
+    // 已运行的流不会被未分配的流挤掉
+    auto running = execute({}, plan);
+    auto again = ShardPlanner::plan(cams, nodes, running);
+    ASSERT_TRUE(again.actions.empty());
+    ASSERT_TRUE(again.assignment == plan.assignment);
+    PASS();
+}
+
+// ============================================================
+// 测试 6: 过载节点每轮迁出一路
+// ============================================================
+void test_overload_sheds_one() {
+    TEST_CASE("An overloaded node sheds exactly one stream per round");
+
+    auto cams = make_cams(40);
+    auto nodes = make_nodes(2);
+    auto running = execute({}, ShardPlanner::plan(cams, nodes, {}));
+    int on_first = 0;
+    for (const auto& [cam, where] : running) on_first += where.front() == nodes[0].node_id ? 1 : 0;
+
+    nodes[0].overloaded = true;
+    auto plan = ShardPlanner::plan(cams, nodes, running);
+    ASSERT_EQ(plan.moves, 1);
+    ASSERT_EQ(plan.actions.size(), 2u);
+    ASSERT_TRUE(plan.actions[0].kind == ShardAction::Kind::Remove);
+    ASSERT_EQ(plan.actions[0].node_id, nodes[0].node_id);
+    ASSERT_EQ(plan.actions[1].node_id, nodes[1].node_id);
+
+    // 仍过载: 下一轮再迁出一路
+    running = execute(running, plan);
+    auto next = ShardPlanner::plan(cams, nodes, running);
+    ASSERT_EQ(next.moves, 1);
+    ASSERT_EQ(count_per_node(next.assignment)[nodes[0].node_id], on_first - 2);
+    PASS();
+}
+
+// ============================================================
+// 测试 7: max_moves 推迟迁移并逐轮收敛
+// ============================================================
+void test_max_moves() {
+    TEST_CASE("max_moves defers migrations, rounds converge to the unlimited target");
+
+    auto cams = make_cams(300);
+    auto running = execute({}, ShardPlanner::plan(cams, make_nodes(3), {}));
+    auto nodes = make_nodes(4);
+    auto target = ShardPlanner::plan(cams, nodes, running);
+
+    auto plan = ShardPlanner::plan(cams, nodes, running, 5);
+    ASSERT_EQ(plan.moves, 5);
+    ASSERT_EQ(plan.deferred, target.moves - 5);
+
+    // 不迁移的流不受影响; 新增的流不受 max_moves 限制
+    auto cams_more = make_cams(310);
+    auto with_new = ShardPlanner::plan(cams_more, nodes, running, 0);
+    ASSERT_EQ(with_new.moves, 0);
+    ASSERT_EQ(with_new.actions.size(), 10u);
+
+    int rounds = 0;
+    while (plan.moves > 0 && rounds < 100) {
+        running = execute(running, plan);
+        plan = ShardPlanner::plan(cams, nodes, running, 5);
+        rounds++;
+    }
+    ASSERT_EQ(plan.moves, 0);
+    ASSERT_EQ(plan.deferred, 0);
+    ASSERT_TRUE(plan.assignment == target.assignment);
+    PASS();
+}
+
+// ============================================================
+// 测试 8: 重复副本 / 已删除的流 / 操作顺序
+// ============================================================
+void test_duplicates_and_order() {
+    TEST_CASE("Duplicate and undesired copies are removed, removes come before adds");
+
+    auto nodes = make_nodes(3);
+    std::vector<std::string> cams = {"a", "b"};
+    size_t target_a = ShardPlanner::rank("a", nodes)[0];
+
+    Running running;
+    running["a"] = {nodes[0].node_id, nodes[1].node_id, nodes[2].node_id};   // 三个副本
+    running["gone"] = {nodes[0].node_id};                                       // 已从集群删除
+
+    auto plan = ShardPlanner::plan(cams, nodes, running);
+    ASSERT_EQ(plan.actions.size(), 4u);     // a 的两个多余副本 + gone + 添加 b
+    ASSERT_EQ(plan.moves, 0);
+    for (size_t i = 0; i < 3; i++) ASSERT_TRUE(plan.actions[i].kind == ShardAction::Kind::Remove);
+    ASSERT_TRUE(plan.actions[3].kind == ShardAction::Kind::Add);
+    ASSERT_EQ(plan.actions[3].cam_id, std::string("b"));
+    for (size_t i = 0; i < 3; i++) {
+        if (plan.actions[i].cam_id == "a") ASSERT_TRUE(plan.actions[i].node_id != nodes[target_a].node_id);
+    }
+    ASSERT_EQ(plan.assignment["a"], nodes[target_a].node_id);
+    ASSERT_EQ(plan.assignment.count("gone"), 0u);
+    PASS();
+}
+
+// ============================================================
+// 测试 9: 过载迁出的粘性
+// ============================================================
+void test_overload_sticky() {
+    TEST_CASE("Streams shed by a flapping node do not bounce back, they return after a calm period");
+
+    auto cams = make_cams(20);
+    auto nodes = make_nodes(2);
+    auto initial = ShardPlanner::plan(cams, nodes, {});
+    auto running = execute({}, initial);
+    int on_a = count_per_node(initial.assignment)[nodes[0].node_id];
+
+    ShedState shed;
+    shed.cooldown_rounds = 3;
+    std::map<std::string, int> moved;   // cam_id -> 迁移次数
+
+    // A 的过载标志每轮翻转: 过载轮迁出一路, 不过载轮不迁回
+    int overloaded_rounds = 0;
+    for (int round = 0; round < 10; round++) {
+        nodes[0].overloaded = round % 2 == 0;
+        overloaded_rounds += nodes[0].overloaded ? 1 : 0;
+        auto plan = ShardPlanner::plan(cams, nodes, running, -1, &shed);
+        ASSERT_EQ(plan.moves, nodes[0].overloaded ? 1 : 0);
+        for (const auto& a : plan.actions) {
+            if (a.kind != ShardAction::Kind::Add) continue;
+            ASSERT_EQ(a.node_id, nodes[1].node_id);
+            moved[a.cam_id]++;
+        }
+        running = execute(running, plan);
+    }
+    for (const auto& [cam, n] : moved) ASSERT_EQ(n, 1);
+    ASSERT_EQ(static_cast<int>(moved.size()), overloaded_rounds);
+
+    // 持续不过载: 每 cooldown_rounds 轮迁回一路, 最终回到初始分配并忘记上限
+    nodes[0].overloaded = false;
+    int rounds = 0;
+    int returned = 0;
+    while (!shed.nodes.empty() && rounds < 100) {
+        auto plan = ShardPlanner::plan(cams, nodes, running, -1, &shed);
+        ASSERT_TRUE(plan.moves <= 1);
+        for (const auto& a : plan.actions) {
+            if (a.kind == ShardAction::Kind::Add) ASSERT_EQ(a.node_id, nodes[0].node_id);
+        }
+        returned += plan.moves;
+        running = execute(running, plan);
+        rounds++;
+    }
+    ASSERT_EQ(returned, overloaded_rounds);
+    ASSERT_TRUE(rounds >= overloaded_rounds * shed.cooldown_rounds);
+    auto final_plan = ShardPlanner::plan(cams, nodes, running, -1, &shed);
+    ASSERT_TRUE(final_plan.actions.empty());
+    ASSERT_TRUE(final_plan.assignment == initial.assignment);
+    ASSERT_EQ(count_per_node(final_plan.assignment)[nodes[0].node_id], on_a);
+    PASS();
+}
+
+// ============================================================
+// 测试 10: 疑似故障节点冻结
+// ============================================================
+void test_suspect_node_frozen() {
+    TEST_CASE("A suspect node keeps its streams and gets no new ones");
+
+    auto cams = make_cams(30);
+    auto nodes = make_nodes(3);
+    auto before = ShardPlanner::plan(cams, nodes, {});
+    auto running = execute({}, before);
+    int on_suspect = count_per_node(before.assignment)[nodes[1].node_id];
+
+    // 节点 2 轮询超时: 协调器沿用上次观测, 标记为疑似故障; 同时它过载且新增了流
+    nodes[1].suspect = true;
+    nodes[1].overloaded = true;
+    auto more = make_cams(40);
+    auto plan = ShardPlanner::plan(more, nodes, running);
+    ASSERT_EQ(plan.moves, 0);
+    ASSERT_EQ(plan.actions.size(), 10u);
+    for (const auto& a : plan.actions) {
+        ASSERT_TRUE(a.kind == ShardAction::Kind::Add);
+        ASSERT_TRUE(a.node_id != nodes[1].node_id);
+    }
+    ASSERT_EQ(count_per_node(plan.assignment)[nodes[1].node_id], on_suspect);
+
+    // 恢复: 按正常规则再平衡
+    nodes[1].suspect = false;
+    nodes[1].overloaded = false;
+    running = execute(running, plan);
+    auto recovered = ShardPlanner::plan(more, nodes, running);
+    ASSERT_TRUE(recovered.assignment == ShardPlanner::plan(more, nodes, {}).assignment);
+    PASS();
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << "  Shard Planner Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    test_rank();
+    test_balanced_spread();
+    test_add_node_minimal_movement();
+    test_node_failure();
+    test_capacity();
+    test_overload_sheds_one();
+    test_max_moves();
+    test_duplicates_and_order();
+    test_overload_sticky();
+    test_suspect_node_frozen();
+
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "  Results: " << g_tests_passed << " passed, "
+              << g_tests_failed << " failed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return g_tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,254 @@
+/**
+ * @file test_thread_policy.cpp
+ * @brief 线程策略 (ThreadPolicy: 命名 / 大小核绑定 / 优先级) 单元测试
+ *
+ * 不依赖硬件, 验证:
+ * - CPU 列表解析与格式化
+ * - 从 sysfs (临时目录模拟) 识别大小核
+ * - ServerConfig -> 策略 (显式列表 / 无法区分大小核时关闭绑核)
+ * - 各角色的 CPU 分配 (推理线程按 worker_id 轮转单个大核)
+ * - apply() 在当前线程设置线程名 / 亲和性 / nice
+ */
+
+#include "infer_server/common/thread_policy.h"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace infer_server;
+namespace fs = std::filesystem;
+
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_CASE(name) \
+    do { std::cout << "\n[TEST] " << name << std::endl; } while(0)
+
+#define ASSERT_TRUE(expr) \
+    do { \
+        if (!(expr)) { \
+            std::cerr << "  FAIL: " << #expr << " at line " << __LINE__ << std::endl; \
+            g_tests_failed++; \
+            return; \
+        } \
+    } while(0)
+
+#define ASSERT_EQ(a, b) \
+    do { \
+        auto _a = (a); auto _b = (b); \
+        if (_a != _b) { \
+            std::cerr << "  FAIL: " << #a << " == " << #b \
+                      << " (" << _a << " != " << _b << ") at line " << __LINE__ << std::endl; \
+            g_tests_failed++; \
+            return; \
+        } \
+    } while(0)
+
+#define PASS() \
+    do { std::cout << "  PASS" << std::endl; g_tests_passed++; } while(0)
+
+// ============================================================
+// 辅助函数
+// ============================================================
+
+/// 模拟 sysfs: cpuN/cpu_capacity 或 cpuN/cpufreq/cpuinfo_max_freq
+static void write_cpu(const fs::path& root, int cpu, const std::string& file, long value) {
+    fs::path path = root / ("cpu" + std::to_string(cpu)) / file;
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << value << "\n";
+}
+
+/// 当前进程允许运行的 CPU
+static std::vector<int> allowed_cpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    sched_getaffinity(0, sizeof(set), &set);
+    std::vector<int> cpus;
+    for (int i = 0; i < CPU_SETSIZE; i++) {
+        if (CPU_ISSET(i, &set)) cpus.push_back(i);
+    }
+    return cpus;
+}
+
+// ============================================================
+// 测试 1: CPU 列表
+// ============================================================
+void test_cpu_list() {
+    TEST_CASE("Parse and format CPU lists");
+
+    auto cpus = ThreadPolicy::parse_cpu_list("4-7, 0,2");
+    ASSERT_EQ(cpus.size(), 6u);
+    ASSERT_EQ(cpus.front(), 0);
+    ASSERT_EQ(cpus.back(), 7);
+    ASSERT_EQ(ThreadPolicy::format_cpu_list(cpus), std::string("0,2,4-7"));
+    ASSERT_EQ(ThreadPolicy::format_cpu_list(ThreadPolicy::parse_cpu_list("3,1-2,2")), std::string("1-3"));
+
+    ASSERT_TRUE(ThreadPolicy::parse_cpu_list("").empty());
+    ASSERT_TRUE(ThreadPolicy::parse_cpu_list("7-4").empty());
+    ASSERT_TRUE(ThreadPolicy::parse_cpu_list("a-b").empty());
+    ASSERT_TRUE(ThreadPolicy::parse_cpu_list("1,,2").empty());
+    ASSERT_TRUE(ThreadPolicy::parse_cpu_list("0-99999").empty());
+
+    PASS();
+}
+
+// ============================================================
+// 测试 2: sysfs 大小核识别
+// ============================================================
+void test_detect_topology() {
+    TEST_CASE("Detect big.LITTLE clusters from sysfs");
+
+    fs::path root = fs::temp_directory_path() / ("thread_policy_" + std::to_string(getpid()));
+    fs::remove_all(root);
+
+    // RK3576: cpu0-3 = A53, cpu4-7 = A72 (cpu_capacity)
+    for (int i = 0; i < 4; i++) write_cpu(root / "cap", i, "cpu_capacity", 530);
+    for (int i = 4; i < 8; i++) write_cpu(root / "cap", i, "cpu_capacity", 1024);
+    fs::create_directories(root / "cap" / "cpufreq");  // 非 cpuN 目录被忽略
+    auto topo = ThreadPolicy::detect_topology((root / "cap").string());
+    ASSERT_EQ(ThreadPolicy::format_cpu_list(topo.big), std::string("4-7"));
+    ASSERT_EQ(ThreadPolicy::format_cpu_list(topo.little), std::string("0-3"));
+
+    // 没有 cpu_capacity 时按最高频率
+    write_cpu(root / "freq", 0, "cpufreq/cpuinfo_max_freq", 1800000);
+    write_cpu(root / "freq", 1, "cpufreq/cpuinfo_max_freq", 1800000);
+    write_cpu(root / "freq", 2, "cpufreq/cpuinfo_max_freq", 2304000);
+    topo = ThreadPolicy::detect_topology((root / "freq").string());
+    ASSERT_EQ(ThreadPolicy::format_cpu_list(topo.big), std::string("2"));
+    ASSERT_EQ(ThreadPolicy::format_cpu_list(topo.little), std::string("0-1"));
+
+    // 同构 CPU: 没有小核
+    for (int i = 0; i < 4; i++) write_cpu(root / "same", i, "cpu_capacity", 1024);
+    topo = ThreadPolicy::detect_topology((root / "same").string());
+    ASSERT_EQ(topo.big.size(), 4u);
+    ASSERT_TRUE(topo.little.empty());
+
+    // 目录不存在
+    topo = ThreadPolicy::detect_topology((root / "missing").string());
+    ASSERT_TRUE(topo.big.empty() && topo.little.empty());
+
+    fs::remove_all(root);
+    PASS();
+}
+
+// ============================================================
+// 测试 3: 配置 -> 策略 与 角色 CPU 分配
+// ============================================================
+void test_roles() {
+    TEST_CASE("Role to CPU assignment");
+
+    ServerConfig config;
+    auto off = ThreadPolicy::from_config(config);
+    ASSERT_TRUE(!off.affinity);
+
+    config.thread_affinity = true;
+    config.cpu_big_cores = "4-7";
+    config.cpu_little_cores = "0-3";
+    config.infer_rt_priority = 150;
+    config.decode_nice = 5;
+    auto options = ThreadPolicy::from_config(config);
+    ASSERT_TRUE(options.affinity);
+    ASSERT_EQ(options.infer_rt_priority, 99);
+    ASSERT_EQ(options.decode_nice, 5);
+
+    ThreadPolicy policy;
+    ASSERT_TRUE(policy.cpus_for(ThreadRole::Infer, 0).empty());  // 未配置时不绑核
+    policy.configure(options);
+
+    // 推理线程: 每个 worker 一个大核, 与 NPU 核心同序轮转
+    for (int worker = 0; worker < 6; worker++) {
+        auto cpus = policy.cpus_for(ThreadRole::Infer, worker);
+        ASSERT_EQ(cpus.size(), 1u);
+        ASSERT_EQ(cpus[0], 4 + worker % 4);
+    }
+    ASSERT_EQ(ThreadPolicy::format_cpu_list(policy.cpus_for(ThreadRole::PostProcess, 1)), std::string("4-7"));
+    ASSERT_EQ(ThreadPolicy::format_cpu_list(policy.cpus_for(ThreadRole::Decode)), std::string("0-3"));
+    ASSERT_EQ(ThreadPolicy::format_cpu_list(policy.cpus_for(ThreadRole::Preprocess)), std::string("0-3"));
+    ASSERT_EQ(ThreadPolicy::format_cpu_list(policy.cpus_for(ThreadRole::Encode)), std::string("0-3"));
+    ASSERT_EQ(ThreadPolicy::format_cpu_list(policy.cpus_for(ThreadRole::Http)), std::string("0-3"));
+    ASSERT_TRUE(policy.cpus_for(ThreadRole::Output).empty());
+
+    auto text = policy.describe();
+    ASSERT_TRUE(text.find("big=4-7") != std::string::npos);
+    ASSERT_TRUE(text.find("SCHED_FIFO 99") != std::string::npos);
+
+    // 只给出大核列表且 sysfs 无法区分时: 关闭绑核 (本机拓扑未知, 只检查一致性)
+    config.cpu_little_cores = "x";
+    auto partial = ThreadPolicy::from_config(config);
+    ASSERT_TRUE(partial.affinity == !partial.little_cores.empty());
+
+    PASS();
+}
+
+// ============================================================
+// 测试 4: apply() 作用于当前线程
+// ============================================================
+void test_apply() {
+    TEST_CASE("apply() sets name, affinity and nice on the calling thread");
+
+    auto allowed = allowed_cpus();
+    ASSERT_TRUE(!allowed.empty());
+
+    ThreadPolicy::Options options;
+    options.affinity = true;
+    options.big_cores = {allowed.back()};
+    options.little_cores = {allowed.front()};
+    options.decode_nice = 3;
+    ThreadPolicy policy;
+    policy.configure(options);
+
+    std::string name;
+    std::vector<int> cpus;
+    int nice = 0;
+    std::thread t([&] {
+        policy.apply(ThreadRole::Decode, "dec-very-long-camera-name");
+        char buf[32] = {};
+        pthread_getname_np(pthread_self(), buf, sizeof(buf));
+        name = buf;
+        cpus = allowed_cpus();
+        nice = getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+    });
+    t.join();
+
+    ASSERT_EQ(name, std::string("dec-very-long-c"));  // 截断到 15 字符
+    ASSERT_EQ(cpus.size(), 1u);
+    ASSERT_EQ(cpus[0], allowed.front());
+    ASSERT_EQ(nice, 3);
+
+    // 不绑核的角色不改变亲和性
+    std::vector<int> output_cpus;
+    std::thread t2([&] {
+        policy.apply(ThreadRole::Output, "output-0");
+        output_cpus = allowed_cpus();
+    });
+    t2.join();
+    ASSERT_EQ(output_cpus.size(), allowed.size());
+
+    PASS();
+}
+
+int main() {
+    std::cout << "======================================" << std::endl;
+    std::cout << "  Thread Policy Unit Tests" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    test_cpu_list();
+    test_detect_topology();
+    test_roles();
+    test_apply();
+
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "  Results: " << g_tests_passed << " passed, "
+              << g_tests_failed << " failed" << std::endl;
+    std::cout << "======================================" << std::endl;
+
+    return g_tests_failed > 0 ? 1 : 0;
+}
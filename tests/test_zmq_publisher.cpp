@@ -11,6 +11,8 @@
  * - JSON 格式验证
  * - 多消息发送
  * - 并发发送安全性
+ * - MessagePack 格式收发与缓冲回收
+ * - 主题 multipart 消息、订阅端前缀过滤、空结果跳过
  */
 
 #ifdef HAS_ZMQ
@@ -292,6 +294,192 @@ void test_ipc_endpoint() {
     PASS();
 }
 
+// ============================================================
+// 测试 6: MessagePack 格式
+// ============================================================
+void test_msgpack_format() {
+    TEST_CASE("MessagePack format (zero-copy, recycled buffers)");
+
+    std::string endpoint = "tcp://127.0.0.1:15559";
+
+    ZmqPublisher pub(endpoint, OutputFormat::MSGPACK);
+    ASSERT_TRUE(pub.format() == OutputFormat::MSGPACK);
+    ASSERT_TRUE(pub.init());
+
+    zmq::context_t sub_ctx(1);
+    zmq::socket_t sub_socket(sub_ctx, zmq::socket_type::sub);
+    sub_socket.set(zmq::sockopt::subscribe, "");
+    sub_socket.set(zmq::sockopt::rcvtimeo, 3000);
+    sub_socket.connect(endpoint);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    Detection det;
+    det.class_id = 2;
+    det.class_name = "car";
+    det.confidence = 0.875f;
+    det.bbox = {1.0f, 2.0f, 3.0f, 4.0f};
+
+    ModelResult mr;
+    mr.task_name = "vehicle";
+    mr.model_path = "/model/yolo.rknn";
+    mr.inference_time_ms = 8.5;
+    mr.detections.push_back(det);
+
+    // 多条消息: 发送缓冲经 free 回调回收后被后续消息复用
+    const int NUM_MSGS = 20;
+    for (int i = 0; i < NUM_MSGS; i++) {
+        FrameResult result;
+        result.cam_id = "cam_mp";
+        result.frame_id = i;
+        result.timestamp_ms = 1700000000000 + i;
+        result.results.push_back(mr);
+        pub.publish(result);
+    }
+
+    for (int i = 0; i < NUM_MSGS; i++) {
+        zmq::message_t msg;
+        auto r = sub_socket.recv(msg, zmq::recv_flags::none);
+        ASSERT_TRUE(r.has_value());
+
+        ASSERT_TRUE(result_codec::detect_format(msg.data(), msg.size()) == OutputFormat::MSGPACK);
+        auto decoded = result_codec::decode_msgpack(msg.data(), msg.size());
+        ASSERT_TRUE(decoded.has_value());
+        ASSERT_TRUE(decoded->cam_id == "cam_mp");
+        ASSERT_EQ(decoded->frame_id, static_cast<uint64_t>(i));
+        ASSERT_EQ(decoded->results.size(), 1u);
+        ASSERT_TRUE(decoded->results[0].detections[0].class_name == "car");
+        ASSERT_TRUE(decoded->results[0].detections[0].confidence == 0.875f);
+    }
+    ASSERT_EQ(pub.published_count(), static_cast<uint64_t>(NUM_MSGS));
+
+    sub_socket.close();
+    pub.shutdown();
+
+    PASS();
+}
+
+// ============================================================
+// 测试 7: 主题与过滤
+// ============================================================
+
+/// 接收一条 multipart 消息, 返回 (topic, payload)
+static bool recv_topic_message(zmq::socket_t& sub, std::string& topic, FrameResult& result) {
+    zmq::message_t msg;
+    if (!sub.recv(msg, zmq::recv_flags::none).has_value() || !msg.more()) return false;
+    topic = msg.to_string();
+    if (!sub.recv(msg, zmq::recv_flags::none).has_value() || msg.more()) return false;
+    auto decoded = result_codec::decode(msg.data(), msg.size());
+    if (!decoded) return false;
+    result = std::move(*decoded);
+    return true;
+}
+
+static FrameResult make_topic_result(const std::string& cam_id, uint64_t frame_id,
+                                     int phone_dets, int smoke_dets) {
+    FrameResult result;
+    result.cam_id = cam_id;
+    result.frame_id = frame_id;
+
+    ModelResult phone;
+    phone.task_name = "phone";
+    phone.detections.resize(phone_dets);
+    ModelResult smoke;
+    smoke.task_name = "smoke";
+    smoke.detections.resize(smoke_dets);
+
+    result.results = {phone, smoke};
+    return result;
+}
+
+void test_topics() {
+    TEST_CASE("Topics: multipart envelope, prefix filtering, skip empty");
+
+    // --- TASK 模式 + skip_empty: 每个有检测结果的模型一条消息 ---
+    {
+        std::string endpoint = "tcp://127.0.0.1:15560";
+        ZmqPublisher::Options options;
+        options.topic_mode = TopicMode::TASK;
+        options.skip_empty = true;
+
+        ZmqPublisher pub(endpoint, options);
+        ASSERT_TRUE(pub.init());
+
+        zmq::context_t sub_ctx(1);
+        zmq::socket_t sub(sub_ctx, zmq::socket_type::sub);
+        sub.set(zmq::sockopt::subscribe, "cam1/");
+        sub.set(zmq::sockopt::rcvtimeo, 1000);
+        sub.connect(endpoint);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        pub.publish(make_topic_result("cam10", 1, 3, 3));  // 被前缀过滤
+        pub.publish(make_topic_result("cam1", 2, 0, 0));   // 两个模型都为空, 全部跳过
+        pub.publish(make_topic_result("cam1", 3, 2, 0));   // 只发 phone
+        pub.publish(make_topic_result("cam1", 4, 1, 4));   // phone + smoke
+
+        std::string topic;
+        FrameResult r;
+        ASSERT_TRUE(recv_topic_message(sub, topic, r));
+        ASSERT_TRUE(topic == "cam1/phone");
+        ASSERT_EQ(r.frame_id, 3u);
+        ASSERT_EQ(r.results.size(), 1u);
+        ASSERT_EQ(r.results[0].detections.size(), 2u);
+
+        ASSERT_TRUE(recv_topic_message(sub, topic, r));
+        ASSERT_TRUE(topic == "cam1/phone");
+        ASSERT_EQ(r.frame_id, 4u);
+
+        ASSERT_TRUE(recv_topic_message(sub, topic, r));
+        ASSERT_TRUE(topic == "cam1/smoke");
+        ASSERT_EQ(r.frame_id, 4u);
+        ASSERT_EQ(r.results[0].detections.size(), 4u);
+
+        // cam10 的消息不应到达
+        zmq::message_t extra;
+        ASSERT_TRUE(!sub.recv(extra, zmq::recv_flags::none).has_value());
+
+        ASSERT_EQ(pub.published_count(), 5u);  // cam10: 2, cam1: 3
+        ASSERT_EQ(pub.skipped_count(), 3u);    // frame 2: 2, frame 3: smoke
+
+        sub.close();
+        pub.shutdown();
+    }
+
+    // --- CAMERA 模式: 整帧一条消息 ---
+    {
+        std::string endpoint = "tcp://127.0.0.1:15561";
+        ZmqPublisher::Options options;
+        options.format = OutputFormat::MSGPACK;
+        options.topic_mode = TopicMode::CAMERA;
+
+        ZmqPublisher pub(endpoint, options);
+        ASSERT_TRUE(pub.init());
+
+        zmq::context_t sub_ctx(1);
+        zmq::socket_t sub(sub_ctx, zmq::socket_type::sub);
+        sub.set(zmq::sockopt::subscribe, "cam2/");
+        sub.set(zmq::sockopt::rcvtimeo, 1000);
+        sub.connect(endpoint);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        pub.publish(make_topic_result("cam1", 1, 1, 1));
+        pub.publish(make_topic_result("cam2", 2, 0, 0));  // 未开启 skip_empty, 照常发布
+
+        std::string topic;
+        FrameResult r;
+        ASSERT_TRUE(recv_topic_message(sub, topic, r));
+        ASSERT_TRUE(topic == "cam2/");
+        ASSERT_EQ(r.frame_id, 2u);
+        ASSERT_EQ(r.results.size(), 2u);
+        ASSERT_EQ(pub.skipped_count(), 0u);
+
+        sub.close();
+        pub.shutdown();
+    }
+
+    PASS();
+}
+
 int main() {
     logger::init("warn");
 
@@ -304,6 +492,8 @@ int main() {
     test_multiple_messages();
     test_concurrent_publish();
     test_ipc_endpoint();
+    test_msgpack_format();
+    test_topics();
 
     std::cout << "\n======================================" << std::endl;
     std::cout << "  Results: " << g_tests_passed << " passed, "
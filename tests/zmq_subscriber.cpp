@@ -3,21 +3,24 @@
  * @brief 独立 ZMQ 订阅者工具
  *
  * 用于手动验证推理服务器的 ZeroMQ 输出。
- * 连接到推理服务器的 PUB endpoint, 接收并打印 FrameResult JSON。
+ * 连接到推理服务器的 PUB endpoint, 接收并打印 FrameResult。
+ * 自动识别消息格式 (zmq_format = "json" 或 "msgpack"), 统一以 JSON 打印。
  *
  * 用法:
- *   ./zmq_subscriber [endpoint]
+ *   ./zmq_subscriber [endpoint] [topic_prefix]
  *   ./zmq_subscriber                              # 默认 tcp://127.0.0.1:5555
  *   ./zmq_subscriber tcp://127.0.0.1:5555
  *   ./zmq_subscriber ipc:///tmp/infer_server.ipc   # 若 server 使用 IPC
+ *   ./zmq_subscriber tcp://127.0.0.1:5555 cam01/   # 只接收 cam01 (需 zmq_topic_mode != none)
  *
  * 输出格式:
- *   [序号] [摄像头ID] frame=帧号 ts=时间戳 results=模型数 detections=总检测数
- *   JSON (pretty-printed)
+ *   [序号] [摄像头ID] frame=帧号 ts=时间戳 results=模型数 detections=总检测数 格式/字节数
+ *   检测详情 (有检测结果时)
  */
 
 #ifdef HAS_ZMQ
 
+#include "infer_server/output/result_codec.h"
 #include <zmq.hpp>
 #include <nlohmann/json.hpp>
 #include <iostream>
@@ -26,6 +29,7 @@
 #include <atomic>
 #include <chrono>
 #include <iomanip>
+#include <algorithm>
 
 static std::atomic<bool> g_running{true};
 
@@ -35,9 +39,13 @@ static void signal_handler(int) {
 
 int main(int argc, char* argv[]) {
     std::string endpoint = "tcp://127.0.0.1:5555";
+    std::string topic_prefix;
     if (argc > 1) {
         endpoint = argv[1];
     }
+    if (argc > 2) {
+        topic_prefix = argv[2];
+    }
 
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
@@ -45,6 +53,7 @@ int main(int argc, char* argv[]) {
     std::cout << "======================================" << std::endl;
     std::cout << "  ZMQ Subscriber Tool" << std::endl;
     std::cout << "  Endpoint: " << endpoint << std::endl;
+    std::cout << "  Topic:    " << (topic_prefix.empty() ? "(all)" : topic_prefix) << std::endl;
     std::cout << "  Press Ctrl+C to stop" << std::endl;
     std::cout << "======================================" << std::endl;
 
@@ -52,8 +61,8 @@ int main(int argc, char* argv[]) {
         zmq::context_t ctx(1);
         zmq::socket_t sub(ctx, zmq::socket_type::sub);
 
-        // 订阅所有消息
-        sub.set(zmq::sockopt::subscribe, "");
+        // 订阅 (空前缀 = 所有消息; 无主题的单帧消息只能用空前缀订阅)
+        sub.set(zmq::sockopt::subscribe, topic_prefix);
         sub.set(zmq::sockopt::rcvtimeo, 1000);  // 1s 超时, 便于检查 stop 信号
 
         std::cout << "Connecting to " << endpoint << "..." << std::endl;
@@ -68,11 +77,28 @@ int main(int argc, char* argv[]) {
             auto result = sub.recv(msg, zmq::recv_flags::none);
             if (!result.has_value()) continue;  // 超时
 
+            // multipart [topic][payload]: 第一帧为主题
+            std::string topic;
+            if (msg.more()) {
+                topic = msg.to_string();
+                msg = zmq::message_t();
+                if (!sub.recv(msg, zmq::recv_flags::none).has_value()) continue;
+            }
+
             msg_count++;
-            std::string json_str(static_cast<char*>(msg.data()), msg.size());
+            auto format = infer_server::result_codec::detect_format(msg.data(), msg.size());
+            auto decoded = infer_server::result_codec::decode(msg.data(), msg.size());
+            if (!decoded) {
+                std::string raw(static_cast<char*>(msg.data()), std::min<size_t>(msg.size(), 200));
+                std::cerr << "[" << msg_count << "] decode error ("
+                          << (format ? infer_server::output_format_name(*format) : "unknown format")
+                          << ", " << msg.size() << " bytes)" << std::endl;
+                std::cerr << "  Raw: " << raw << "..." << std::endl;
+                continue;
+            }
 
             try {
-                auto j = nlohmann::json::parse(json_str);
+                nlohmann::json j = *decoded;
 
                 // 统计
                 std::string cam_id = j.value("cam_id", "?");
@@ -96,10 +122,12 @@ int main(int argc, char* argv[]) {
                 double fps = (elapsed_sec > 0) ? (msg_count / elapsed_sec) : 0.0;
                 std::cout << "\n[" << msg_count << "] "
                           << "[" << cam_id << "] "
+                          << (topic.empty() ? "" : "topic=" + topic + " ")
                           << "frame=" << frame_id << " "
                           << "ts=" << ts << " "
                           << "results=" << n_results << " "
                           << "detections=" << total_dets << " "
+                          << infer_server::output_format_name(*format) << "/" << msg.size() << "B "
                           << "(" << std::fixed << std::setprecision(1) << fps << " msg/s)"
                           << std::endl;
 
@@ -134,8 +162,7 @@ int main(int argc, char* argv[]) {
                 }
 
             } catch (const nlohmann::json::exception& e) {
-                std::cerr << "[" << msg_count << "] JSON parse error: " << e.what() << std::endl;
-                std::cerr << "  Raw: " << json_str.substr(0, 200) << "..." << std::endl;
+                std::cerr << "[" << msg_count << "] JSON error: " << e.what() << std::endl;
             }
         }
 